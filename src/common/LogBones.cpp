@@ -25,6 +25,11 @@ Contact us at legal@badjuju.com.
 
 LogCallback* g_pLogCallback = NULL;
 
+bool IsLogEnabled(MSG_TYPE type)
+{
+	return g_pLogCallback && g_pLogCallback->isEnabled(type);
+}
+
 void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
 {
 	if (!g_pLogCallback)
@@ -33,4 +38,12 @@ void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, st
 	g_pLogCallback->Message(type, msg.c_str(), col, mpArgs);
 }
 
+void LogTrace(const TraceEvent &event)
+{
+	if (!g_pLogCallback)
+		return;
+
+	g_pLogCallback->Trace(event);
+}
+
 #include "DesuraPrintFRedirect.h"
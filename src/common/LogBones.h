@@ -38,6 +38,11 @@ enum MSG_TYPE
 
 void LogMsg(MSG_TYPE type, std::string msg, Color *col = nullptr, std::map<std::string, std::string> *pmArgs = nullptr);
 
+//! Returns true if messages of this type go anywhere. Defined next to LogMsg and
+//! checked by the log macros so a disabled channel costs no formatting
+//!
+bool IsLogEnabled(MSG_TYPE type);
+
 
 template <typename T>
 std::string TraceClassInfo(T *pClass)
@@ -45,6 +50,62 @@ std::string TraceClassInfo(T *pClass)
 	return "";
 }
 
+typedef std::string (*TraceClassInfoFn)(const void* pClass);
+
+template <typename T>
+std::string TraceClassInfoThunk(const void* pClass)
+{
+	return TraceClassInfo((T*)pClass);
+}
+
+//! A trace as it leaves the call site. Only the message arguments have been formatted,
+//! the rest is raw so the tracer can copy it straight into its ring buffer.
+//! Everything it points at only lives until LogTrace returns.
+struct TraceEvent
+{
+	const char* szFunction;
+	const char* szModule;
+	const void* pClass;
+	TraceClassInfoFn pfnClassInfo;
+	uint64 nThreadId;
+	uint64 nTick;
+	const char* szMessage;
+	uint32 nMessageLen;
+};
+
+//! Steady clock tick stored with each trace, nanoseconds
+inline uint64 GetTraceTick()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//! Hands a trace to whatever records traces in this module. Defined next to LogMsg
+//!
+void LogTrace(const TraceEvent &event);
+
+//! Formats the fields of a trace into the args LogMsg takes
+//!
+inline void FormatTraceArgs(const TraceEvent &event, std::map<std::string, std::string> &mArgs)
+{
+	mArgs["function"] = event.szFunction ? event.szFunction : "";
+	mArgs["classinfo"] = event.pfnClassInfo ? event.pfnClassInfo(event.pClass) : "";
+	mArgs["thread"] = gcString("{0}", event.nThreadId);
+	mArgs["time"] = gcTime().to_js_string();
+
+	if (event.szModule)
+		mArgs["module"] = event.szModule;
+}
+
+//! Sends a trace through LogMsg. For modules with no tracer that takes raw traces
+//!
+inline void LogTraceAsMsg(const TraceEvent &event)
+{
+	std::map<std::string, std::string> mArgs;
+	FormatTraceArgs(event, mArgs);
+
+	LogMsg(MT_TRACE, std::string(event.szMessage, event.nMessageLen), nullptr, &mArgs);
+}
+
 template<typename CT>
 void PrintToStream(const DesuraId& t, std::basic_stringstream<CT> &oss)
 {
@@ -61,53 +122,93 @@ extern "C" IMAGE_DOS_HEADER __ImageBase;
 #endif
 #endif
 
-template <typename ... Args>
-void TraceS(const char* szFunction, const char* szClassInfo, const char* szFormat, Args ... args)
+inline uint64 GetTraceThreadId()
 {
-	static auto getCurrentThreadId = []()
-	{
 #ifdef WIN32
-		return ::GetCurrentThreadId();
+	return ::GetCurrentThreadId();
 #else
-		return (uint64)pthread_self();
+	return (uint64)pthread_self();
 #endif
-	};
+}
 
-	std::map<std::string, std::string> mArgs;
+#ifdef WIN32
+inline const char* GetTraceModuleName()
+{
+	static std::string s_strModule;
 
-	mArgs["function"] = gcString(szFunction);
-	mArgs["classinfo"] = gcString(szClassInfo);
-	mArgs["thread"] = gcString("{0}", getCurrentThreadId());
-	mArgs["time"] = gcTime().to_js_string();
+	if (s_strModule.empty())
+	{
+		char szModuleName[255] = { 0 };
+		GetModuleFileNameA(reinterpret_cast<HMODULE>(&__ImageBase), szModuleName, 255);
 
-#ifdef WIN32
-	char szModuleName[255] = { 0 };
-	GetModuleFileNameA(reinterpret_cast<HMODULE>(&__ImageBase), szModuleName, 255);
+		std::string t(szModuleName);
+		s_strModule = t.substr(t.find_last_of('\\') + 1);
+	}
+
+	return s_strModule.c_str();
+}
+#endif
 
-	auto t = std::string(szModuleName, 255);
-	mArgs["module"] = t.substr(t.find_last_of('\\') + 1);
+//! Nothing but the message arguments is formatted here. The class info is resolved
+//! later and only if the trace ends up as text.
+template <typename ... Args>
+void TraceS(const char* szFunction, const void* pClass, TraceClassInfoFn pfnClassInfo, const char* szFormat, Args ... args)
+{
+	if (!IsLogEnabled(MT_TRACE))
+		return;
+
+	TraceEvent event;
+	event.szFunction = szFunction;
+#ifdef WIN32
+	event.szModule = GetTraceModuleName();
+#else
+	event.szModule = nullptr;
 #endif
+	event.pClass = pClass;
+	event.pfnClassInfo = pfnClassInfo;
+	event.nThreadId = GetTraceThreadId();
+	event.nTick = GetTraceTick();
 
-	LogMsg(MT_TRACE, gcString(szFormat, args...), nullptr, &mArgs);
+	if (sizeof...(Args) == 0)
+	{
+		event.szMessage = szFormat;
+		event.nMessageLen = (uint32)strlen(szFormat);
+		LogTrace(event);
+	}
+	else
+	{
+		gcString strMessage(szFormat, args...);
+		event.szMessage = strMessage.c_str();
+		event.nMessageLen = (uint32)strMessage.size();
+		LogTrace(event);
+	}
 }
 
 template <typename T, typename ... Args>
 void TraceT(const char* szFunction, T *pClass, const char* szFormat, Args ... args)
 {
-	auto ci = TraceClassInfo(pClass);
-	TraceS(szFunction, ci.c_str(), szFormat, args...);
+	TraceS(szFunction, pClass, &TraceClassInfoThunk<T>, szFormat, args...);
 }
 
 template <typename T, typename ... Args>
 void WarningT(const char* szFunction, T *pClass, const char* szFormat, Args ... args)
 {
+	bool bWarn = IsLogEnabled(MT_WARN);
+	bool bTrace = IsLogEnabled(MT_TRACE);
+
+	if (!bWarn && !bTrace)
+		return;
+
 	gcString msg(szFormat, args...);
-	LogMsg(MT_WARN, msg);
 
-	msg = "Warning: " + msg;
+	if (bWarn)
+		LogMsg(MT_WARN, msg);
+
+	if (!bTrace)
+		return;
 
-	auto ci = TraceClassInfo(pClass);
-	TraceS(szFunction, ci.c_str(), msg.c_str());
+	msg = "Warning: " + msg;
+	TraceS(szFunction, pClass, &TraceClassInfoThunk<T>, msg.c_str());
 }
 
 namespace
@@ -117,18 +218,18 @@ namespace
 	};
 }
 
-#define Msg( ... ) LogMsg(MT_MSG, gcString(__VA_ARGS__))
-#define Debug( ... ) LogMsg(MT_DEBUG, gcString(__VA_ARGS__))
-#define Warning( ... ) WarningT(__FUNCTION__, this, __VA_ARGS__)
-#define WarningS( ... ) WarningT(__FUNCTION__, (FakeTracerClass*)nullptr, __VA_ARGS__)
-#define gcTrace( ... ) TraceT(__FUNCTION__, this, __VA_ARGS__)
-#define gcTraceS( ... ) TraceT(__FUNCTION__, (FakeTracerClass*)nullptr, __VA_ARGS__)
+#define Msg( ... ) do { gcFormatCheck(__VA_ARGS__); if (IsLogEnabled(MT_MSG)) LogMsg(MT_MSG, gcString(__VA_ARGS__)); } while (false)
+#define Debug( ... ) do { gcFormatCheck(__VA_ARGS__); if (IsLogEnabled(MT_DEBUG)) LogMsg(MT_DEBUG, gcString(__VA_ARGS__)); } while (false)
+#define Warning( ... ) do { gcFormatCheck(__VA_ARGS__); WarningT(__FUNCTION__, this, __VA_ARGS__); } while (false)
+#define WarningS( ... ) do { gcFormatCheck(__VA_ARGS__); WarningT(__FUNCTION__, (FakeTracerClass*)nullptr, __VA_ARGS__); } while (false)
+#define gcTrace( ... ) do { gcFormatCheck(__VA_ARGS__); TraceT(__FUNCTION__, this, __VA_ARGS__); } while (false)
+#define gcTraceS( ... ) do { gcFormatCheck(__VA_ARGS__); TraceT(__FUNCTION__, (FakeTracerClass*)nullptr, __VA_ARGS__); } while (false)
 
 
 #else
 
 template <typename ... Args>
-void TraceS(const char* szFunction, const char* szClassInfo, const char* szFormat, Args ... args)
+void TraceS(const char* szFunction, const void* pClass, TraceClassInfoFn pfnClassInfo, const char* szFormat, Args ... args)
 {
 }
 
@@ -137,10 +238,10 @@ void TraceT(const char* szFunction, T *pClass, const char* szFormat, Args ... ar
 {
 }
 
-#define Msg( ... ) LogMsg(MT_MSG, gcString(__VA_ARGS__))
-#define Debug( ... ) LogMsg(MT_DEBUG, gcString(__VA_ARGS__))
-#define Warning( ... ) LogMsg(MT_WARN, gcString(__VA_ARGS__))
-#define WarningS( ... ) LogMsg(MT_WARN, gcString(__VA_ARGS__))
+#define Msg( ... ) do { gcFormatCheck(__VA_ARGS__); if (IsLogEnabled(MT_MSG)) LogMsg(MT_MSG, gcString(__VA_ARGS__)); } while (false)
+#define Debug( ... ) do { gcFormatCheck(__VA_ARGS__); if (IsLogEnabled(MT_DEBUG)) LogMsg(MT_DEBUG, gcString(__VA_ARGS__)); } while (false)
+#define Warning( ... ) do { gcFormatCheck(__VA_ARGS__); if (IsLogEnabled(MT_WARN)) LogMsg(MT_WARN, gcString(__VA_ARGS__)); } while (false)
+#define WarningS( ... ) do { gcFormatCheck(__VA_ARGS__); if (IsLogEnabled(MT_WARN)) LogMsg(MT_WARN, gcString(__VA_ARGS__)); } while (false)
 #define gcTrace( ... ) {}
 #define gcTraceS( ... ) {}
 
@@ -157,6 +258,7 @@ class TracerI
 {
 public:
 	virtual void trace(const std::string &strTrace, std::map<std::string, std::string> *mpArgs) = 0;
+	virtual void traceRaw(const TraceEvent &event) = 0;
 
 protected:
 	virtual ~TracerI(){}
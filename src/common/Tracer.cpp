@@ -32,60 +32,183 @@ Contact us at legal@badjuju.com.
 TracerStorage g_Tracer(TRACER_SHARED_MEM_NAME);
 #endif
 
+#include <chrono>
+
 #ifdef WIN32
 #include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	//! Copies a null terminated string into the record payload. Strings that dont fit are
+	//! truncated when bTruncate is set otherwise nothing is written
+	bool AppendString(char* &szPos, const char* szEnd, const char* szStr, size_t nLen, bool bTruncate)
+	{
+		size_t nAvail = szEnd - szPos;
+
+		if (nAvail == 0)
+			return false;
 
+		if (nLen + 1 > nAvail)
+		{
+			if (!bTruncate)
+				return false;
+
+			nLen = nAvail - 1;
+		}
+
+		memcpy(szPos, szStr, nLen);
+		szPos[nLen] = '\0';
+		szPos += nLen + 1;
+
+		return true;
+	}
+
+	bool AppendString(char* &szPos, const char* szEnd, const std::string &str, bool bTruncate)
+	{
+		return AppendString(szPos, szEnd, str.c_str(), str.size(), bTruncate);
+	}
+
+	bool AppendString(char* &szPos, const char* szEnd, const char* szStr)
+	{
+		if (!szStr)
+			szStr = "";
+
+		return AppendString(szPos, szEnd, szStr, strlen(szStr), true);
+	}
+}
 
 TracerStorage::TracerStorage(const wchar_t* szSharedMemName)
 	: m_szSharedMemName(szSharedMemName)
 {
 #ifdef WITH_TRACING
-	uint32 nSize = getTotalSize() + 12;
-
-	m_hMappedFile = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE|SEC_COMMIT, 0, nSize, getSharedMemName());
+	uint32 nSize = getTotalSize() + sizeof(TracerHeader_s) - 1;
 
-	if (!m_hMappedFile)
+	if (!openSharedMem(nSize))
 		return;
 
-	m_pHeader = (TracerHeader_s*)MapViewOfFile(m_hMappedFile, FILE_MAP_ALL_ACCESS, 0, 0, nSize);
-
+#ifdef WIN32
 	m_pHeader->pid = GetCurrentProcessId();
+#else
+	m_pHeader->pid = getpid();
+#endif
 	m_pHeader->segCount = m_nNumSegments;
 	m_pHeader->segSize = m_nSegmentSize;
+	m_pHeader->baseTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	m_pHeader->baseTick = GetTraceTick();
+
+	m_pLock = reinterpret_cast<std::atomic<uint32>*>(&m_pHeader->lock);
+	m_pLock->store(0);
 
-	m_nCurLock = &m_pHeader->lock;
 	m_szMappedMemory = &m_pHeader->data;
 
-	for (uint32 x = 0; x < nSize; x += m_nSegmentSize)
-		(m_szMappedMemory + x)[0] = 0;
+	for (uint32 x = 0; x < getTotalSize(); x += m_nSegmentSize)
+		reinterpret_cast<TracerRecord_s*>(m_szMappedMemory + x)->seq = 0;
 #endif
 }
 
 TracerStorage::~TracerStorage()
 {
-	if (m_pHeader)
-		UnmapViewOfFile(m_pHeader);
+	closeSharedMem();
+}
 
-	CloseHandle(m_hMappedFile);
+TracerRecord_s* TracerStorage::beginRecord(uint32 &nSeq)
+{
+	if (!m_szMappedMemory || !m_pLock)
+		return nullptr;
+
+	nSeq = m_pLock->fetch_add(1, std::memory_order_relaxed) + 1;
+
+	//zero marks an empty segment
+	if (nSeq == 0)
+		nSeq = m_pLock->fetch_add(1, std::memory_order_relaxed) + 1;
+
+	auto pRecord = reinterpret_cast<TracerRecord_s*>(m_szMappedMemory + m_nSegmentSize * ((nSeq - 1) % m_nNumSegments));
+	auto pSeq = reinterpret_cast<std::atomic<uint32>*>(&pRecord->seq);
+
+	pSeq->store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	return pRecord;
+}
+
+void TracerStorage::endRecord(TracerRecord_s* pRecord, uint32 nSeq, const char* szPayloadEnd)
+{
+	pRecord->size = (uint16)(szPayloadEnd - &pRecord->payload);
+	reinterpret_cast<std::atomic<uint32>*>(&pRecord->seq)->store(nSeq, std::memory_order_release);
 }
 
 void TracerStorage::trace(const std::string &strTrace, std::map<std::string, std::string> *pmArgs)
 {
-	if (!m_szMappedMemory || !m_nCurLock)
+	uint32 nSeq = 0;
+	auto pRecord = beginRecord(nSeq);
+
+	if (!pRecord)
 		return;
 
-	std::string strFormated = formatTrace(strTrace, pmArgs);
-	uint16 pos = InterlockedIncrement(m_nCurLock) % m_nNumSegments;
+	char* szPos = &pRecord->payload;
+	const char* szEnd = reinterpret_cast<char*>(pRecord) + m_nSegmentSize;
 
-	if (pos == 0)
-		pos = m_nNumSegments;
+	AppendString(szPos, szEnd, strTrace, true);
+	AppendString(szPos, szEnd, "");
+	AppendString(szPos, szEnd, "");
+	AppendString(szPos, szEnd, "");
 
-	auto saveSpot = m_szMappedMemory + (m_nSegmentSize * (pos - 1));
-	size_t limit = strFormated.size();
-	if ( limit >= m_nSegmentSize )
-		limit = ( m_nSegmentSize - 1 );
+	if (pmArgs)
+	{
+		for (auto &p : *pmArgs)
+		{
+			if (p.second.empty())
+				continue;
 
-	Safe::strncpy(saveSpot, m_nSegmentSize, strFormated.c_str(), limit);
+			char* szPairStart = szPos;
+
+			if (!AppendString(szPos, szEnd, p.first, false) || !AppendString(szPos, szEnd, p.second, false))
+			{
+				szPos = szPairStart;
+				break;
+			}
+		}
+	}
+
+	pRecord->flags = 0;
+	pRecord->tick = GetTraceTick();
+	pRecord->thread = 0;
+
+	endRecord(pRecord, nSeq, szPos);
+}
+
+void TracerStorage::traceRaw(const TraceEvent &event)
+{
+	//only this process can turn the class pointer into something readable
+	std::string strClassInfo;
+
+	if (event.pClass && event.pfnClassInfo)
+		strClassInfo = event.pfnClassInfo(event.pClass);
+
+	uint32 nSeq = 0;
+	auto pRecord = beginRecord(nSeq);
+
+	if (!pRecord)
+		return;
+
+	char* szPos = &pRecord->payload;
+	const char* szEnd = reinterpret_cast<char*>(pRecord) + m_nSegmentSize;
+
+	AppendString(szPos, szEnd, event.szMessage, event.nMessageLen, true);
+	AppendString(szPos, szEnd, event.szFunction);
+	AppendString(szPos, szEnd, event.szModule);
+	AppendString(szPos, szEnd, strClassInfo, true);
+
+	pRecord->flags = TRACER_RECORD_RAW;
+	pRecord->tick = event.nTick;
+	pRecord->thread = event.nThreadId;
+
+	endRecord(pRecord, nSeq, szPos);
 }
 
 const wchar_t* TracerStorage::getSharedMemName()
@@ -102,51 +225,66 @@ uint32 TracerStorage::getTotalSize() const
 	return m_nNumSegments * m_nSegmentSize;
 }
 
-std::string TracerStorage::formatTrace(const std::string &szMessage, std::map<std::string, std::string> *pmArgs)
-{
-	gcString out("{ \"message\": \"{0}\"", cleanUpString(szMessage));
-	out.reserve(m_nSegmentSize);
+#ifdef WIN32
 
-	if (pmArgs)
-	{
-		for (auto p : *pmArgs)
-		{
-			if (p.second.empty())
-				continue;
+bool TracerStorage::openSharedMem(uint32 nSize)
+{
+	m_hMappedFile = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE|SEC_COMMIT, 0, nSize, getSharedMemName());
 
-			gcString temp(", \"{0}\": \"{1}\"", p.first, cleanUpString(p.second));
+	if (!m_hMappedFile)
+		return false;
 
-			if (out.size() + temp.size() + 2 > m_nSegmentSize)
-				break;
+	m_pHeader = (TracerHeader_s*)MapViewOfFile(m_hMappedFile, FILE_MAP_ALL_ACCESS, 0, 0, nSize);
+	return !!m_pHeader;
+}
 
-			out += temp;
-		}
-	}
+void TracerStorage::closeSharedMem()
+{
+	if (m_pHeader)
+		UnmapViewOfFile(m_pHeader);
 
-	out += " }";
-	return out;
+	CloseHandle(m_hMappedFile);
 }
 
-std::string TracerStorage::cleanUpString(const std::string &string)
+#else
+
+bool TracerStorage::openSharedMem(uint32 nSize)
 {
-	std::string out;
-	out.reserve(string.size() + 20);
+	m_strShmName = GetTracerShmName(gcString(getSharedMemName()));
+
+	int fd = shm_open(m_strShmName.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
 
-	for (auto c : string)
+	if (fd == -1)
+		return false;
+
+	if (ftruncate(fd, nSize) != 0)
 	{
-		if (c == '"' || c == '\\')
-			out += '\\';
-
-		if (c == '\n')
-			out += "\\n";
-		else if (c == '\t')
-			out += "\\t";
-		else
-			out += c;
+		close(fd);
+		return false;
 	}
 
-	return out;
+	void* pMem = mmap(nullptr, nSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (pMem == MAP_FAILED)
+		return false;
+
+	m_pHeader = (TracerHeader_s*)pMem;
+	m_nMappedSize = nSize;
+
+	return true;
 }
 
+void TracerStorage::closeSharedMem()
+{
+	if (!m_pHeader)
+		return;
+
+	munmap(m_pHeader, m_nMappedSize);
+	m_pHeader = nullptr;
+
+	//Left behind on a crash so the trace can still be collected
+	shm_unlink(m_strShmName.c_str());
+}
 
 #endif
@@ -25,25 +25,70 @@ Contact us at legal@badjuju.com.
 #include "Common.h"
 #include "util_thread/BaseThread.h"
 #include <atomic>
+#include <functional>
 #include <list>
+#include <vector>
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
 
 #pragma pack(push)
 #pragma pack(1)
 
+//! baseTime (system clock microseconds) and baseTick (GetTraceTick) are taken together
+//! when the buffer is created so the reader can turn record ticks into wall time
 typedef struct
 {
 	uint32 pid;
 	uint32 lock;
 	uint16 segCount;
 	uint16 segSize;
+	uint64 baseTime;
+	uint64 baseTick;
 	char data;
 } TracerHeader_s;
 
+enum
+{
+	//! Record came from traceRaw, thread, function, module and class info are set
+	TRACER_RECORD_RAW = 1,
+};
+
+//! Record stored at the start of each segment. Payload is the message, function, module and
+//! class info followed by key and value pairs, all null terminated. Class info is the only
+//! thing the writer formats as the reader cant call back into the traced process, the reader
+//! turns records into json.
+typedef struct
+{
+	uint32 seq;
+	uint16 flags;
+	uint64 tick;
+	uint64 thread;
+	uint16 size;
+	char payload;
+} TracerRecord_s;
+
 #pragma pack(pop)
 
+static_assert(sizeof(std::atomic<uint32>) == sizeof(uint32), "Tracer shared memory needs a plain 32 bit atomic");
 
-#ifdef WIN32
+#ifndef WIN32
+//! Shared memory object name for a tracer. Suffixed with the user id so instances run by
+//! different users dont fight over the same object
+inline std::string GetTracerShmName(const std::string &strName)
+{
+	return gcString("/{0}.{1}", strName, (uint32)getuid());
+}
+#endif
 
+//! Writes traces into a shared memory ring buffer so they survive a crash and can be read
+//! by the crash uploader or tracer_dump.
+//!
+//! Writers claim a segment with an atomic increment of the header lock and copy the raw
+//! strings in. The segment sequence number is cleared while the record is written and set
+//! last, so readers can skip records that are torn or in progress.
+//!
 class TracerStorage : public TracerI
 {
 public:
@@ -51,44 +96,101 @@ public:
 	~TracerStorage();
 
 	void trace(const std::string &strTrace, std::map<std::string, std::string> *mpArgs) override;
+	void traceRaw(const TraceEvent &event) override;
 
 	const wchar_t* getSharedMemName();
 
 protected:
 	uint32 getTotalSize() const;
 
-	std::string formatTrace(const std::string &strTrace, std::map<std::string, std::string> *mpArgs);
-	std::string cleanUpString(const std::string &string);
+	bool openSharedMem(uint32 nSize);
+	void closeSharedMem();
+
+	//! Claims the next segment and clears its sequence number. Returns null if there is no buffer
+	TracerRecord_s* beginRecord(uint32 &nSeq);
+
+	//! Publishes a record started with beginRecord
+	void endRecord(TracerRecord_s* pRecord, uint32 nSeq, const char* szPayloadEnd);
 
 private:
 	//this number of segments should cause perfect roll around
 	const uint16 m_nNumSegments = 4096;
 	const uint16 m_nSegmentSize = 512;
 
-	volatile uint32* m_nCurLock = nullptr;
-
-	HANDLE m_hMappedFile = INVALID_HANDLE_VALUE;
+	std::atomic<uint32>* m_pLock = nullptr;
 	char* m_szMappedMemory = nullptr;
 
 	TracerHeader_s* m_pHeader = nullptr;
 	const wchar_t* m_szSharedMemName = nullptr;
-};
 
+#ifdef WIN32
+	HANDLE m_hMappedFile = INVALID_HANDLE_VALUE;
 #else
+	std::string m_strShmName;
+	uint32 m_nMappedSize = 0;
+#endif
+};
 
-class TracerStorage : public TracerI
+//! A single trace copied out of shared memory
+class TracerRecord
 {
 public:
-	TracerStorage(const wchar_t* szSharedMemName)
-	{
-	}
+	uint32 m_nSeq = 0;
+
+	//! System clock microseconds
+	uint64 m_nTime = 0;
+
+	//! Set for records written by traceRaw
+	bool m_bRaw = false;
+	uint64 m_nThreadId = 0;
+
+	std::string m_strMessage;
+	std::string m_strClassInfo;
+	std::string m_strFunction;
+	std::string m_strModule;
+	std::vector<std::pair<std::string, std::string>> m_vArgs;
 
-	void trace(const std::string &strTrace, std::map<std::string, std::string> *mpArgs) override
-	{
-	}
+	//! Formats the record as the json object the crash uploader expects
+	//!
+	void formatJson(std::string &strOut) const;
 };
 
+//! Attaches read only to the shared memory of a TracerStorage, possibly in another process
+//!
+class TracerReader
+{
+public:
+	TracerReader(const std::string &strSharedMemName);
+	~TracerReader();
+
+	bool isValid() const;
+
+	//! Process id of the writer
+	//!
+	uint32 getPid() const;
+
+	//! Sequence number of the latest claimed segment
+	//!
+	uint32 getLastSeq() const;
+
+	//! Reads all complete records newer than nAfterSeq, oldest first
+	//!
+	//! @param nAfterSeq Sequence number of the last record already seen, 0 for everything
+	//! @param callback Called with each record
+	//! @return Sequence number of the newest record read or nAfterSeq if none
+	//!
+	uint32 read(uint32 nAfterSeq, const std::function<void(const TracerRecord&)> &callback) const;
+
+private:
+	TracerHeader_s* m_pHeader = nullptr;
+	uint32 m_nDataSize = 0;
+
+#ifdef WIN32
+	HANDLE m_hMappedFile = nullptr;
+#else
+	uint32 m_nMappedSize = 0;
 #endif
+};
 
 extern TracerStorage g_Tracer;
 
@@ -0,0 +1,280 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#ifdef DONTUSE_PCH
+#include "stdafx.h"
+#else
+#include "Common.h"
+#endif
+
+#include "Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	const char* ReadString(const char* &szPos, const char* szEnd)
+	{
+		const char* szStart = szPos;
+
+		while (szPos < szEnd && *szPos)
+			++szPos;
+
+		if (szPos == szEnd)
+			return nullptr;
+
+		++szPos;
+		return szStart;
+	}
+}
+
+void TracerRecord::formatJson(std::string &strOut) const
+{
+	strOut += "{ \"message\": \"";
+	UTIL::STRING::appendJsonEscaped(strOut, m_strMessage);
+	strOut += "\"";
+
+	auto appendField = [&strOut](const std::string &strKey, const std::string &strValue)
+	{
+		strOut += ", \"";
+		UTIL::STRING::appendJsonEscaped(strOut, strKey);
+		strOut += "\": \"";
+		UTIL::STRING::appendJsonEscaped(strOut, strValue);
+		strOut += "\"";
+	};
+
+	if (m_bRaw)
+	{
+		appendField("function", m_strFunction);
+
+		if (!m_strClassInfo.empty())
+			appendField("classinfo", m_strClassInfo);
+
+		appendField("thread", gcString("{0}", m_nThreadId));
+		appendField("time", gcTime(std::chrono::system_clock::time_point(std::chrono::microseconds(m_nTime))).to_js_string());
+
+		if (!m_strModule.empty())
+			appendField("module", m_strModule);
+	}
+
+	for (auto &p : m_vArgs)
+		appendField(p.first, p.second);
+
+	strOut += " }";
+}
+
+
+#ifdef WIN32
+
+TracerReader::TracerReader(const std::string &strSharedMemName)
+{
+	uint32 nSize = sizeof(TracerHeader_s);
+
+	//Open only, creating it here would hand back an empty mapping when the writer has gone
+	m_hMappedFile = OpenFileMappingA(FILE_MAP_READ, FALSE, strSharedMemName.c_str());
+
+	if (!m_hMappedFile)
+		return;
+
+	m_pHeader = (TracerHeader_s*)MapViewOfFile(m_hMappedFile, FILE_MAP_READ, 0, 0, nSize);
+
+	if (!m_pHeader)
+		return;
+
+	m_nDataSize = m_pHeader->segCount * m_pHeader->segSize;
+
+	UnmapViewOfFile(m_pHeader);
+	m_pHeader = (TracerHeader_s*)MapViewOfFile(m_hMappedFile, FILE_MAP_READ, 0, 0, nSize + m_nDataSize);
+}
+
+TracerReader::~TracerReader()
+{
+	if (m_pHeader)
+		UnmapViewOfFile(m_pHeader);
+
+	if (m_hMappedFile)
+		CloseHandle(m_hMappedFile);
+}
+
+#else
+
+TracerReader::TracerReader(const std::string &strSharedMemName)
+{
+	int fd = shm_open(GetTracerShmName(strSharedMemName).c_str(), O_RDONLY, 0);
+
+	if (fd == -1)
+		return;
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(TracerHeader_s))
+	{
+		close(fd);
+		return;
+	}
+
+	void* pMem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (pMem == MAP_FAILED)
+		return;
+
+	m_pHeader = (TracerHeader_s*)pMem;
+	m_nMappedSize = (uint32)st.st_size;
+	m_nDataSize = m_pHeader->segCount * m_pHeader->segSize;
+
+	if (m_nDataSize + sizeof(TracerHeader_s) - 1 > m_nMappedSize)
+		m_nDataSize = 0;
+}
+
+TracerReader::~TracerReader()
+{
+	if (m_pHeader)
+		munmap(m_pHeader, m_nMappedSize);
+}
+
+#endif
+
+bool TracerReader::isValid() const
+{
+	return m_pHeader && m_nDataSize > 0 && m_pHeader->segSize > sizeof(TracerRecord_s);
+}
+
+uint32 TracerReader::getPid() const
+{
+	return m_pHeader ? m_pHeader->pid : 0;
+}
+
+uint32 TracerReader::getLastSeq() const
+{
+	if (!m_pHeader)
+		return 0;
+
+	return reinterpret_cast<const std::atomic<uint32>*>(&m_pHeader->lock)->load(std::memory_order_acquire);
+}
+
+uint32 TracerReader::read(uint32 nAfterSeq, const std::function<void(const TracerRecord&)> &callback) const
+{
+	if (!isValid() || !callback)
+		return nAfterSeq;
+
+	const uint16 nSegSize = m_pHeader->segSize;
+	const uint16 nSegCount = m_pHeader->segCount;
+
+	//Order relative to the oldest segment that can still be in the ring so wrap around of the
+	//sequence number doesnt matter
+	const uint32 nOldest = getLastSeq() - nSegCount;
+	uint32 nAfterRel = nAfterSeq - nOldest;
+
+	//Reader fell behind the writer, everything in the ring is new
+	if (nAfterSeq == 0 || nAfterRel > nSegCount)
+		nAfterRel = 0;
+
+	std::vector<TracerRecord> vRecords;
+	std::vector<char> vPayload(nSegSize);
+
+	for (uint32 x = 0; x < m_nDataSize; x += nSegSize)
+	{
+		auto pRecord = reinterpret_cast<const TracerRecord_s*>(&m_pHeader->data + x);
+		auto pSeq = reinterpret_cast<const std::atomic<uint32>*>(&pRecord->seq);
+
+		uint32 nSeq = pSeq->load(std::memory_order_acquire);
+
+		if (nSeq == 0 || nSeq - nOldest <= nAfterRel)
+			continue;
+
+		uint16 nFlags = pRecord->flags;
+		uint64 nTick = pRecord->tick;
+		uint64 nThread = pRecord->thread;
+		uint16 nSize = std::min<uint16>(pRecord->size, nSegSize - (sizeof(TracerRecord_s) - 1));
+		memcpy(&vPayload[0], &pRecord->payload, nSize);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		//Rewritten while we were copying it
+		if (pSeq->load(std::memory_order_relaxed) != nSeq)
+			continue;
+
+		const char* szPos = &vPayload[0];
+		const char* szEnd = szPos + nSize;
+
+		const char* szMessage = ReadString(szPos, szEnd);
+
+		if (!szMessage)
+			continue;
+
+		TracerRecord record;
+		record.m_nSeq = nSeq;
+		record.m_nTime = m_pHeader->baseTime + (int64)(nTick - m_pHeader->baseTick) / 1000;
+		record.m_bRaw = (nFlags & TRACER_RECORD_RAW) != 0;
+		record.m_nThreadId = nThread;
+		record.m_strMessage = szMessage;
+
+		//Left off when a long message filled the segment
+		const char* szFunction = ReadString(szPos, szEnd);
+		const char* szModule = szFunction ? ReadString(szPos, szEnd) : nullptr;
+		const char* szClassInfo = szModule ? ReadString(szPos, szEnd) : nullptr;
+
+		if (szFunction)
+			record.m_strFunction = szFunction;
+
+		if (szModule)
+			record.m_strModule = szModule;
+
+		if (szClassInfo)
+			record.m_strClassInfo = szClassInfo;
+
+		while (szClassInfo && szPos < szEnd)
+		{
+			const char* szKey = ReadString(szPos, szEnd);
+			const char* szValue = ReadString(szPos, szEnd);
+
+			if (!szKey || !szValue)
+				break;
+
+			record.m_vArgs.push_back(std::make_pair(szKey, szValue));
+		}
+
+		vRecords.push_back(std::move(record));
+	}
+
+	std::sort(vRecords.begin(), vRecords.end(), [nOldest](const TracerRecord &a, const TracerRecord &b)
+	{
+		return a.m_nSeq - nOldest < b.m_nSeq - nOldest;
+	});
+
+	for (auto &r : vRecords)
+	{
+		callback(r);
+		nAfterSeq = r.m_nSeq;
+	}
+
+	return nAfterSeq;
+}
@@ -73,16 +73,24 @@ void SetTracer(TracerI *pTracer)
 	g_pTracer = pTracer;
 }
 
-void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
+bool IsLogEnabled(MSG_TYPE type)
 {
 	if (!g_pServicemain || !g_bLogEnabled)
-		return;
+		return false;
 
 #ifndef DEBUG
 	if (type == MT_DEBUG)
-		return;
+		return false;
 #endif
 
+	return true;
+}
+
+void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
+{
+	if (!IsLogEnabled(type))
+		return;
+
 	uint64 nCol = -1;
 
 	if (col)
@@ -102,6 +110,15 @@ void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, st
 		g_pTracer->trace(msg, mpArgs);
 }
 
+//Traces go to the client over ipc so they have to be text here
+void LogTrace(const TraceEvent &event)
+{
+	if (!IsLogEnabled(MT_TRACE))
+		return;
+
+	LogTraceAsMsg(event);
+}
+
 #endif
 
 
@@ -155,6 +172,8 @@ void IPCServiceMain::registerFunctions()
 
 	REG_FUNCTION_VOID(IPCServiceMain, killProcessesAtPath);
 	REG_FUNCTION(IPCServiceMain, findProcessId);
+	REG_FUNCTION_VOID(IPCServiceMain, setTimelineSettings);
+	REG_FUNCTION_VOID(IPCServiceMain, setMcfBackgroundMode);
 #else
 	REG_FUNCTION_VOID_T( IPCServiceMain, message, false );
 	REG_FUNCTION( IPCServiceMain, getSpecialPath );
@@ -267,6 +286,16 @@ void IPCServiceMain::setCrashSettings(const char* user, bool upload)
 	IPC::functionCallAsync(this, "setCrashSettings", user, upload);
 }
 
+void IPCServiceMain::setTimelineSettings(bool bEnabled)
+{
+	IPC::functionCallAsync(this, "setTimelineSettings", bEnabled);
+}
+
+void IPCServiceMain::setMcfBackgroundMode(bool bEnabled, uint32 uiRateLimit)
+{
+	IPC::functionCallAsync(this, "setMcfBackgroundMode", bEnabled, uiRateLimit);
+}
+
 void IPCServiceMain::setUninstallRegKey(uint64 id, uint64 installSize)
 {
 	IPC::functionCallAsync(this, "setUninstallRegKey", id, installSize);
@@ -346,6 +375,8 @@ void IPCServiceMain::startThread()
 }
 
 void SetCrashSettings(const wchar_t* user, bool upload);
+void SetTimelineSettings(bool bEnabled);
+void SetMcfBackgroundMode(bool bEnabled, uint32 uiRateLimit);
 
 #ifdef WIN32
 void UnInstallRegKey_SetAppDataPath(const char* path);
@@ -364,6 +395,16 @@ void IPCServiceMain::setCrashSettings(const char* user, bool upload)
 	SetCrashSettings(wUser.c_str(), upload);
 }
 
+void IPCServiceMain::setTimelineSettings(bool bEnabled)
+{
+	SetTimelineSettings(bEnabled);
+}
+
+void IPCServiceMain::setMcfBackgroundMode(bool bEnabled, uint32 uiRateLimit)
+{
+	SetMcfBackgroundMode(bEnabled, uiRateLimit);
+}
+
 void IPCServiceMain::dispVersion()
 {
 	Msg(gcString("Version: {0}.{1}.{2}.{3}\n", VERSION_MAJOR, VERSION_MINOR, VERSION_BUILDNO, VERSION_EXTEND));
@@ -84,6 +84,9 @@ public:
 	void killProcessesAtPath(const char* szPath) override;
 	uint32 findProcessId(const char* szProcessName) override;
 
+	void setTimelineSettings(bool bEnabled) override;
+	void setMcfBackgroundMode(bool bEnabled, uint32 uiRateLimit) override;
+
 	gc_IMPLEMENT_REFCOUNTING(IPCServiceMain);
 
 private:
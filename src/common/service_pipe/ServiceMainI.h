@@ -70,6 +70,12 @@ namespace IPC
 		virtual void killProcessesAtPath(const char* szPath) = 0;
 		virtual uint32 findProcessId(const char* szProcessName) = 0;
 
+		//! Turns span recording on or off in the service. The service writes its chrome trace to its own app data folder
+		virtual void setTimelineSettings(bool bEnabled) = 0;
+
+		//! Switches mcf background mode in the service, see MCFCore::IOSchedulerI
+		virtual void setMcfBackgroundMode(bool bEnabled, uint32 uiRateLimit) = 0;
+
 	protected:
 		virtual ~ServiceMainI(){}
 	};
@@ -110,6 +116,8 @@ namespace IPC
 
 		MOCK_METHOD1(killProcessesAtPath, void(const char*));
 		MOCK_METHOD1(findProcessId, uint32(const char*));
+		MOCK_METHOD1(setTimelineSettings, void(bool));
+		MOCK_METHOD2(setMcfBackgroundMode, void(bool, uint32));
 
 		gc_IMPLEMENT_REFCOUNTING(ServiceMainMock);
 	};
@@ -33,6 +33,7 @@ Contact us at legal@badjuju.com.
 
 #include "UICoreI.h" // UICoreI
 #include "MiniDumpGenerator.h"
+#include "Tracer.h"
 
 #include "DesuraMain.h"
 #include "UtilFile.h"
@@ -303,6 +304,7 @@ bool MainApp::loadUICore()
 	m_pUICore->setDesuraVersion(version);
 	m_pUICore->setRestartFunction(&MainApp::restartFromUICore);
 	m_pUICore->setCrashDumpSettings(&MainApp::setCrashSettings);
+	m_pUICore->setTracer(&g_Tracer);
 
 	return true;
 }
@@ -35,6 +35,16 @@ void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, st
 #include "DesuraPrintFRedirect.h"
 
 
+bool IsLogEnabled(MSG_TYPE type)
+{
+	return true;
+}
+
+void LogTrace(const TraceEvent &event)
+{
+	g_Tracer.traceRaw(event);
+}
+
 void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
 {
 	if (type == MT_TRACE)
@@ -0,0 +1,97 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#include "Common.h"
+#include "ServiceCoreI.h"
+#include "SharedObjectLoader.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+typedef void* (*FactoryBuilderFN)(const char*);
+
+bool IsLogEnabled(MSG_TYPE type)
+{
+	return true;
+}
+
+void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
+{
+	if (type != MT_TRACE)
+		fprintf(stderr, "%s", msg.c_str());
+}
+
+void LogTrace(const TraceEvent &event)
+{
+}
+
+//Service only lives as long as the client that started it, same as the windows one
+void OnPipeDisconnect()
+{
+	fprintf(stderr, "Client disconnected, stopping service.\n");
+	kill(getpid(), SIGTERM);
+}
+
+int main(int argc, char** argv)
+{
+	//Block these before servicecore starts any threads so only sigwait below sees them
+	sigset_t sigs;
+	sigemptyset(&sigs);
+	sigaddset(&sigs, SIGTERM);
+	sigaddset(&sigs, SIGINT);
+	sigaddset(&sigs, SIGHUP);
+	pthread_sigmask(SIG_BLOCK, &sigs, nullptr);
+
+	SharedObjectLoader hServiceCore;
+
+	if (!hServiceCore.load("libservicecore.so"))
+	{
+		fprintf(stderr, "Failed to load libservicecore.so.\n");
+		return 1;
+	}
+
+	FactoryBuilderFN factory = hServiceCore.getFunction<FactoryBuilderFN>("FactoryBuilderSC");
+
+	if (!factory)
+	{
+		fprintf(stderr, "Failed to load FactoryBuilderSC function.\n");
+		return 1;
+	}
+
+	ServiceCoreI* pServiceCore = (ServiceCoreI*)factory(SERVICE_CORE);
+
+	if (!pServiceCore)
+	{
+		fprintf(stderr, "Failed to create service core.\n");
+		return 1;
+	}
+
+	pServiceCore->setDisconnectCallback(&OnPipeDisconnect);
+	pServiceCore->startPipe();
+
+	int nSig = 0;
+	sigwait(&sigs, &nSig);
+
+	pServiceCore->stopPipe();
+	pServiceCore->destroy();
+
+	return 0;
+}
@@ -33,6 +33,11 @@ CGCServiceApp g_ServiceApp;
 
 class Color;
 
+bool IsLogEnabled(MSG_TYPE type)
+{
+	return true;
+}
+
 void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
 {
 	if (type == MT_TRACE)
@@ -41,6 +46,11 @@ void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, st
 		fprintf(stdout, "[LogMsg] %s\n", msg.c_str());
 }
 
+void LogTrace(const TraceEvent &event)
+{
+	g_Tracer.traceRaw(event);
+}
+
 
 #include "DesuraPrintFRedirect.h"
 
@@ -60,6 +60,7 @@ Contact us at legal@badjuju.com.
 
 #include <functional>
 #include <mutex>
+#include <atomic>
 
 class VoidEventArg
 {
@@ -94,30 +95,120 @@ protected:
 	virtual ~InvokeI(){}
 };
 
+//! Firing an event is lock free and allocation free. The delegate list is an immutable snapshot
+//! which is replaced (copy on write) under m_WriteLock when delegates are added or removed. A fire
+//! works on the snapshot it loaded at the start, so delegates added during a fire are called from
+//! the next fire on. Delegates removed during a fire are skipped if they havnt been called yet.
+//!
+//! Old snapshots and removed delegates are freed with two reader epochs. A fire counts itself
+//! against the epoch it started in. Retiring flips the epoch and what was retired before the flip
+//! is freed once the fires counted against the old epoch are done, so fires that keep starting on
+//! other threads cant hold memory back.
+//!
+//! Note: different threads can now fire the same event at the same time.
 template <typename TArg, typename TDel>
 class EventBase
 {
+	class DelegateEntry
+	{
+	public:
+		DelegateEntry(TDel* pDel)
+			: pDelegate(pDel)
+			, bRemoved(false)
+		{
+		}
+
+		TDel* const pDelegate;
+		std::atomic<bool> bRemoved;
+	};
+
+	class DelegateSnapshot
+	{
+	public:
+		DelegateSnapshot()
+			: vEntries()
+			, bCanceled(false)
+		{
+		}
+
+		std::vector<DelegateEntry*> vEntries;
+		std::atomic<bool> bCanceled;
+	};
+
+	class ReadGuard
+	{
+	public:
+		ReadGuard(EventBase<TArg, TDel> &event)
+			: m_Event(event)
+		{
+			while (true)
+			{
+				m_nEpoch = m_Event.m_nEpoch & 1;
+				++m_Event.m_nReaders[m_nEpoch];
+
+				//epoch flipped before we were counted, count against the new one
+				if ((m_Event.m_nEpoch & 1) == m_nEpoch)
+					break;
+
+				--m_Event.m_nReaders[m_nEpoch];
+			}
+		}
+
+		~ReadGuard()
+		{
+			--m_Event.m_nReaders[m_nEpoch];
+
+			if (m_Event.m_bHasInvalid || (m_Event.m_bHasRetired && m_Event.m_nReaders[(m_Event.m_nEpoch & 1) ^ 1] == 0))
+				m_Event.tryCleanup();
+		}
+
+	private:
+		ReadGuard(const ReadGuard&);
+		ReadGuard& operator=(const ReadGuard&);
+
+		EventBase<TArg, TDel> &m_Event;
+		uint32 m_nEpoch;
+	};
+
 public:
 	EventBase()
-	: m_bCancel(false)
-	, m_pCurDelegate(nullptr)
-	, m_vPendingDelegates()
-	, m_vDelegates()
-	, m_PendingLock()
-	, m_Lock()
-	{
+		: m_WriteLock()
+		, m_pSnapshot(nullptr)
+		, m_nEpoch(0)
+		, m_bHasRetired(false)
+		, m_bHasInvalid(false)
+		, m_vRetiredSnapshots()
+		, m_vRetiredEntries()
+		, m_vWaitingSnapshots()
+		, m_vWaitingEntries()
+	{
+		m_nReaders[0] = 0;
+		m_nReaders[1] = 0;
+
 		assertType();
 	}
 
 	EventBase(const EventBase<TArg, TDel>& e)
-	{
+		: m_WriteLock()
+		, m_pSnapshot(nullptr)
+		, m_nEpoch(0)
+		, m_bHasRetired(false)
+		, m_bHasInvalid(false)
+		, m_vRetiredSnapshots()
+		, m_vRetiredEntries()
+		, m_vWaitingSnapshots()
+		, m_vWaitingEntries()
+	{
+		m_nReaders[0] = 0;
+		m_nReaders[1] = 0;
+
 		assertType();
 
-		for (size_t x=0; x<e.m_vDelegates.size(); x++)
-			m_vDelegates.push_back(e.m_vDelegates[x]->clone());
+		std::vector<TDel*> vAdd;
+		e.cloneDelegates(vAdd);
 
-		m_bCancel = false;
-		m_pCurDelegate = nullptr;
+		std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
+		updateSnapshot(vAdd, [](TDel*){ return false; });
 	}
 
 	virtual ~EventBase()
@@ -125,6 +216,10 @@ public:
 		try
 		{
 			reset();
+
+			std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
+			gcAssert(m_nReaders[0] == 0 && m_nReaders[1] == 0);
+			reclaimRetired(true);
 		}
 		catch (...)
 		{
@@ -145,95 +240,83 @@ public:
 		//cant use this with void event
 		gcAssert(typeid(TArg) != typeid(VoidEventArg));
 
-		std::lock_guard<std::recursive_mutex> guard(m_Lock);
-		migratePending();
-
-		for (auto d : m_vDelegates)
-		{
-			if (!d)
-				continue;
-
-			m_pCurDelegate = d;
-			m_pCurDelegate->operator()(a);
-			m_pCurDelegate = nullptr;
-
-			if (m_bCancel)
-				break;
-		}
-
-		migratePending();
+		dispatch([&a](TDel* d){
+			d->operator()(a);
+		});
 	}
 
 	void operator()()
 	{
-		std::lock_guard<std::recursive_mutex> guard(m_Lock);
-		migratePending();
-
-		for (auto d : m_vDelegates)
-		{
-			if (!d)
-				continue;
-
-			m_pCurDelegate = d;
-			m_pCurDelegate->operator()();
-			m_pCurDelegate = nullptr;
-
-			if (m_bCancel)
-				break;
-		}
-
-		migratePending();
+		dispatch([](TDel* d){
+			d->operator()();
+		});
 	}
 
 	EventBase<TArg, TDel>& operator=(const EventBase<TArg, TDel>& e)
 	{
-		std::lock_guard<std::recursive_mutex> guard(m_Lock);
-
-		for (auto d : m_vDelegates)
-			d->destroy();
+		if (&e == this)
+			return *this;
 
-		m_vDelegates.clear();
+		std::vector<TDel*> vAdd;
+		e.cloneDelegates(vAdd);
 
-		for (auto d : e.m_vDelegates)
-			m_vDelegates.push_back(d->clone());
+		std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
+		updateSnapshot(vAdd, [](TDel*){ return true; });
 
 		return *this;
 	}
 
 	EventBase<TArg, TDel>& operator+=(const EventBase<TArg, TDel>& e)
 	{
-		std::lock_guard<std::recursive_mutex> guard(m_Lock);
+		if (&e == this)
+			return *this;
+
+		std::vector<TDel*> vOther;
+		e.cloneDelegates(vOther);
+
+		std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
 
-		for (auto d : e.m_vDelegates)
+		std::vector<TDel*> vAdd;
+
+		for (auto d : vOther)
 		{
 			if (findInfo(d) == UNKNOWN_ITEM)
-				m_vDelegates.push_back(d->clone());
+				vAdd.push_back(d);
+			else
+				d->destroy();
 		}
 
+		updateSnapshot(vAdd, [](TDel*){ return false; });
 		return *this;
 	}
 
 	EventBase<TArg, TDel>& operator-=(const EventBase<TArg, TDel>& e)
 	{
-		std::lock_guard<std::recursive_mutex> guard(m_Lock);
+		if (&e == this)
+		{
+			reset();
+			return *this;
+		}
 
-		std::vector<size_t> del;
+		std::vector<TDel*> vOther;
+		e.cloneDelegates(vOther);
 
-		for (size_t x=0; x<e.m_vDelegates.size(); x++)
 		{
-			TDel* d = e.m_vDelegates[x];
-			size_t index = findInfo(d);
+			std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
 
-			if (index == UNKNOWN_ITEM)
-				continue;
+			updateSnapshot(std::vector<TDel*>(), [&vOther](TDel* d) -> bool {
+				for (auto o : vOther)
+				{
+					if (d->equals(o))
+						return true;
+				}
 
-			del.push_back(index);
+				return false;
+			});
 		}
 
-		std::sort(del.begin(), del.end());
-
-		for (size_t x=del.size(); x>0; x--)
-			m_vDelegates.erase(m_vDelegates.begin()+del[x]);
+		for (auto d : vOther)
+			d->destroy();
 
 		return *this;
 	}
@@ -244,17 +327,20 @@ public:
 		if (!d)
 			return *this;
 
-		{
-			std::lock_guard<std::recursive_mutex> guard(m_PendingLock);
-			m_vPendingDelegates.push_back(std::pair<bool, TDel*>(true, d->clone()));
-		}
-
+		TDel* pClone = d->clone();
 		d->destroy();
 
-		std::unique_lock<std::recursive_mutex> uLock(m_Lock, std::defer_lock);
+		std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
+
+		if (findInfo(pClone) != UNKNOWN_ITEM)
+		{
+			gcAssert(false);
+			pClone->destroy();
+			return *this;
+		}
 
-		if (uLock.try_lock())
-			migratePending();
+		std::vector<TDel*> vAdd(1, pClone);
+		updateSnapshot(vAdd, [](TDel*){ return false; });
 
 		return *this;
 	}
@@ -265,17 +351,17 @@ public:
 			return *this;
 
 		{
-			std::lock_guard<std::recursive_mutex> guard(m_PendingLock);
-			m_vPendingDelegates.push_back(std::pair<bool, TDel*>(false, d->clone()));
+			std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
+
+			if (findInfo(d) != UNKNOWN_ITEM)
+			{
+				updateSnapshot(std::vector<TDel*>(), [d](TDel* o){
+					return o->equals(d);
+				});
+			}
 		}
 
 		d->destroy();
-
-		std::unique_lock<std::recursive_mutex> uLock(m_Lock, std::defer_lock);
-
-		if (uLock.try_lock())
-			migratePending();
-
 		return *this;
 	}
 
@@ -284,111 +370,235 @@ public:
 		if (!this)
 			return;
 
-		std::lock_guard<std::recursive_mutex> guard(m_Lock);
+		std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
 
-		m_bCancel = true;
-		InvokeI* i = dynamic_cast<InvokeI*>(m_pCurDelegate);
+		auto pSnapshot = m_pSnapshot.load();
 
-		if (i)
-			i->cancel();
-
-		for (auto d : m_vDelegates)
-		{
-			if (d)
-				d->destroy();
-		}
+		if (!pSnapshot)
+			return;
 
-		m_vDelegates.clear();
+		//stop any fire in progress and wake up delegates waiting on other threads
+		pSnapshot->bCanceled = true;
 
+		for (auto e : pSnapshot->vEntries)
 		{
-			std::lock_guard<std::recursive_mutex> guard(m_PendingLock);
-			for (auto p : m_vPendingDelegates)
-			{
-				if (p.second)
-					p.second->destroy();
-			}
+			InvokeI* i = dynamic_cast<InvokeI*>(e->pDelegate);
 
-			m_vPendingDelegates.clear();
+			if (i)
+				i->cancel();
 		}
 
-		m_bCancel = false;
+		updateSnapshot(std::vector<TDel*>(), [](TDel*){ return true; });
 	}
 
 	void flush()
 	{
-		std::lock_guard<std::recursive_mutex> guard(m_Lock);
-		migratePending();
+		std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
+		removeInvalidDelegates();
+		reclaimRetired();
 	}
 
 protected:
+	template <typename F>
+	void dispatch(const F &fnInvoke)
+	{
+		ReadGuard guard(*this);
+
+		auto pSnapshot = m_pSnapshot.load();
+
+		if (!pSnapshot)
+			return;
+
+		for (auto e : pSnapshot->vEntries)
+		{
+			if (e->bRemoved)
+				continue;
+
+			if (!e->pDelegate->isValid())
+			{
+				m_bHasInvalid = true;
+				continue;
+			}
+
+			fnInvoke(e->pDelegate);
+
+			if (pSnapshot->bCanceled)
+				break;
+		}
+	}
+
+	//! Must hold m_WriteLock
 	size_t findInfo(TDel* d)
 	{
-		for (size_t x=0; x<m_vDelegates.size(); x++)
+		auto pSnapshot = m_pSnapshot.load();
+
+		if (!pSnapshot)
+			return UNKNOWN_ITEM;
+
+		for (size_t x=0; x<pSnapshot->vEntries.size(); x++)
 		{
-			if (m_vDelegates[x]->equals(d))
+			if (pSnapshot->vEntries[x]->pDelegate->equals(d))
 				return x;
 		}
 
 		return UNKNOWN_ITEM;
 	}
 
-	void migratePending()
+	void cloneDelegates(std::vector<TDel*> &vOut) const
 	{
-		std::lock_guard<std::recursive_mutex> guard(m_PendingLock);
+		std::lock_guard<std::recursive_mutex> guard(m_WriteLock);
 
-		removeInvalidDelegates();
+		auto pSnapshot = m_pSnapshot.load();
+
+		if (!pSnapshot)
+			return;
+
+		for (auto e : pSnapshot->vEntries)
+			vOut.push_back(e->pDelegate->clone());
+	}
 
-		for (auto p : m_vPendingDelegates)
+	//! Builds and publishes a new snapshot. Must hold m_WriteLock
+	template <typename F>
+	void updateSnapshot(const std::vector<TDel*> &vAdd, const F &fnShouldRemove)
+	{
+		auto pOld = m_pSnapshot.load();
+
+		std::vector<DelegateEntry*> vKeep;
+		std::vector<DelegateEntry*> vRemoved;
+
+		if (pOld)
 		{
-			if (p.first)
+			for (auto e : pOld->vEntries)
 			{
-				if (findInfo(p.second) == UNKNOWN_ITEM)
-					m_vDelegates.push_back(p.second);
+				if (fnShouldRemove(e->pDelegate))
+					vRemoved.push_back(e);
 				else
-				{
-					gcAssert(false);
-					p.second->destroy();
-				}
+					vKeep.push_back(e);
 			}
-			else
+		}
+
+		if (vRemoved.empty() && vAdd.empty())
+			return;
+
+		DelegateSnapshot* pNew = nullptr;
+
+		if (!vKeep.empty() || !vAdd.empty())
+		{
+			pNew = new DelegateSnapshot();
+			pNew->vEntries.reserve(vKeep.size() + vAdd.size());
+			pNew->vEntries = vKeep;
+
+			for (auto d : vAdd)
+				pNew->vEntries.push_back(new DelegateEntry(d));
+		}
+
+		for (auto e : vRemoved)
+		{
+			e->bRemoved = true;
+			m_vRetiredEntries.push_back(e);
+		}
+
+		m_pSnapshot.store(pNew);
+
+		if (pOld)
+			m_vRetiredSnapshots.push_back(pOld);
+
+		m_bHasRetired = true;
+		reclaimRetired();
+	}
+
+	//! Must hold m_WriteLock
+	void removeInvalidDelegates()
+	{
+		m_bHasInvalid = false;
+
+		updateSnapshot(std::vector<TDel*>(), [](TDel* d){
+			return !d || !d->isValid();
+		});
+	}
+
+	//! Frees what was retired before the last epoch flip once the fires counted against that
+	//! epoch are done, then flips the epoch for anything retired since. Must hold m_WriteLock
+	void reclaimRetired(bool bForce = false)
+	{
+		if (!m_bHasRetired)
+			return;
+
+		while (true)
+		{
+			if (!m_vWaitingSnapshots.empty() || !m_vWaitingEntries.empty())
 			{
-				size_t index = findInfo(p.second);
-				p.second->destroy();
+				//fires that could still see these started before the flip and are counted
+				//against the old epoch
+				if (!bForce && m_nReaders[(m_nEpoch & 1) ^ 1] != 0)
+					break;
 
-				if (index != UNKNOWN_ITEM)
-				{
-					m_vDelegates[index]->destroy();
-					m_vDelegates.erase(m_vDelegates.begin() + index);
-				}
+				freeWaiting();
 			}
+
+			if (m_vRetiredSnapshots.empty() && m_vRetiredEntries.empty())
+				break;
+
+			//m_pSnapshot is always swapped before retiring so fires counted against the new
+			//epoch can only load the current snapshot
+			std::swap(m_vWaitingSnapshots, m_vRetiredSnapshots);
+			std::swap(m_vWaitingEntries, m_vRetiredEntries);
+			++m_nEpoch;
 		}
 
-		m_vPendingDelegates.clear();
+		m_bHasRetired = !m_vWaitingSnapshots.empty() || !m_vWaitingEntries.empty();
 	}
 
-	void removeInvalidDelegates()
+	//! Must hold m_WriteLock
+	void freeWaiting()
 	{
-		std::vector<TDel*> vTemp = m_vDelegates;
-		m_vDelegates.clear();
+		std::vector<DelegateSnapshot*> vSnapshots;
+		std::vector<DelegateEntry*> vEntries;
+
+		std::swap(vSnapshots, m_vWaitingSnapshots);
+		std::swap(vEntries, m_vWaitingEntries);
 
-		for (auto p : vTemp)
+		for (auto s : vSnapshots)
+			delete s;
+
+		for (auto e : vEntries)
 		{
-			if (!p || !p->isValid())
-				p->destroy();
-			else
-				m_vDelegates.push_back(p);
+			e->pDelegate->destroy();
+			delete e;
 		}
 	}
 
+	void tryCleanup()
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_WriteLock, std::try_to_lock);
+
+		if (!lock.owns_lock())
+			return;
+
+		if (m_bHasInvalid)
+			removeInvalidDelegates();
+
+		reclaimRetired();
+	}
+
 private:
-	std::recursive_mutex m_Lock;
-	std::recursive_mutex m_PendingLock;
+	mutable std::recursive_mutex m_WriteLock;
+
+	std::atomic<DelegateSnapshot*> m_pSnapshot;
+
+	std::atomic<uint32> m_nEpoch;
+	std::atomic<uint32> m_nReaders[2];
+
+	std::atomic<bool> m_bHasRetired;
+	std::atomic<bool> m_bHasInvalid;
 
-	std::vector<TDel*> m_vDelegates;
-	std::vector<std::pair<bool, TDel*> > m_vPendingDelegates;
+	//retired since the last epoch flip
+	std::vector<DelegateSnapshot*> m_vRetiredSnapshots;
+	std::vector<DelegateEntry*> m_vRetiredEntries;
 
-	bool m_bCancel = false;
-	TDel* m_pCurDelegate = nullptr;
+	//retired before the last epoch flip, waiting on fires counted against the old epoch
+	std::vector<DelegateSnapshot*> m_vWaitingSnapshots;
+	std::vector<DelegateEntry*> m_vWaitingEntries;
 };
 
 
@@ -25,6 +25,7 @@ Contact us at legal@badjuju.com.
 #pragma once
 #endif
 
+#include <atomic>
 #include <functional>
 #include "LogBones.h"
 
@@ -35,30 +36,75 @@ class LogCallback
 {
 public:
 	typedef std::function<void(MSG_TYPE, const char*, Color*, std::map<std::string, std::string>*)> MessageFn;
+	typedef std::function<void(const TraceEvent&)> TraceFn;
 
 	LogCallback()
 	: m_cbMsg()
+	, m_cbTrace()
+	, m_nChannels(0xFFFFFFFF)
 	{
 	}
 
+	//! Enables or disables a message type for every module sharing this callback.
+	//! Disabled types are dropped by the log macros before any formatting.
+	//!
+	void setEnabled(MSG_TYPE type, bool bEnabled)
+	{
+		if (bEnabled)
+			m_nChannels |= (1u << type);
+		else
+			m_nChannels &= ~(1u << type);
+	}
+
+	bool isEnabled(MSG_TYPE type) const
+	{
+		return (m_nChannels.load(std::memory_order_relaxed) & (1u << type)) != 0;
+	}
+
 	void Message(MSG_TYPE type, const char* msg, Color* col = nullptr, std::map<std::string, std::string>* mpArgs = nullptr)
 	{
 		if (m_cbMsg)
 			m_cbMsg(type, msg, col, mpArgs);
 	}
 
+	//! Passes a raw trace on. Without a trace callback it is formatted and sent as a message
+	//!
+	void Trace(const TraceEvent &event)
+	{
+		if (m_cbTrace)
+		{
+			m_cbTrace(event);
+		}
+		else if (m_cbMsg)
+		{
+			std::map<std::string, std::string> mArgs;
+			FormatTraceArgs(event, mArgs);
+
+			std::string strMessage(event.szMessage, event.nMessageLen);
+			m_cbMsg(MT_TRACE, strMessage.c_str(), nullptr, &mArgs);
+		}
+	}
+
 	void RegMsg(MessageFn &cb)
 	{
 		m_cbMsg = cb;
 	}
 
+	void RegTrace(TraceFn &cb)
+	{
+		m_cbTrace = cb;
+	}
+
 	void Reset()
 	{
 		m_cbMsg = MessageFn();
+		m_cbTrace = TraceFn();
 	}
 
 private:
 	MessageFn m_cbMsg;
+	TraceFn m_cbTrace;
+	std::atomic<uint32> m_nChannels;
 };
 
 #endif //DESURA_LOG_CALLBACK_H
@@ -313,6 +313,19 @@ namespace XML
 			return !!m_pConstElement;
 		}
 
+		//! Hash of the names, attributes and text of this element and everything under it. Used to
+		//! spot subtrees that havent changed without comparing them
+		//!
+		uint64 GetContentHash() const
+		{
+			uint64 hash = 14695981039346656037ull;
+
+			if (m_pConstElement)
+				HashNode(m_pConstElement, hash);
+
+			return hash;
+		}
+
 		gcXMLElement FirstChildElement(const char* name)
 		{
 			gcAssert(m_pConstElement);
@@ -371,6 +384,45 @@ namespace XML
 		}
 
 	private:
+		//FNV-1a, the trailing null keeps "ab" + "c" from hashing the same as "a" + "bc"
+		static void HashString(const char* szValue, uint64 &hash)
+		{
+			if (szValue)
+			{
+				for (; *szValue; ++szValue)
+				{
+					hash ^= (unsigned char)*szValue;
+					hash *= 1099511628211ull;
+				}
+			}
+
+			hash *= 1099511628211ull;
+		}
+
+		static void HashNode(const tinyxml2::XMLNode* pNode, uint64 &hash)
+		{
+			if (auto pElement = pNode->ToElement())
+			{
+				HashString(pElement->Name(), hash);
+
+				for (auto pAtt = pElement->FirstAttribute(); pAtt; pAtt = pAtt->Next())
+				{
+					HashString(pAtt->Name(), hash);
+					HashString(pAtt->Value(), hash);
+				}
+
+				for (auto pChild = pElement->FirstChild(); pChild; pChild = pChild->NextSibling())
+					HashNode(pChild, hash);
+
+				//close the element so a child and a following sibling dont hash the same
+				HashString(nullptr, hash);
+			}
+			else if (pNode->ToText())
+			{
+				HashString(pNode->Value(), hash);
+			}
+		}
+
 		tinyxml2::XMLDocument* m_XmlDoc;
 		tinyxml2::XMLElement* m_pElement;
 		const tinyxml2::XMLElement* m_pConstElement;
@@ -38,6 +38,7 @@ class WildCardDelegate : public DelegateI<WCSpecialInfo&>, public InvokeI
 public:
 	WildCardDelegate(TObj* t)
 		: m_pObj(t)
+		, m_bCanceled(false)
 	{
 		if (m_pObj)
 			m_pObj->registerDelegate(this);
@@ -63,14 +64,14 @@ public:
 
 		auto invoker = std::make_shared<Invoker>(callback);
 
+		if (!m_PendingInvokers.add(invoker))
+			return;
+
 		wxGuiDelegateEvent event(invoker, m_pObj->GetId());
 		m_pObj->GetEventHandler()->AddPendingEvent(event);
 
-		std::shared_ptr<Invoker> empty;
-
-		setInvoker(invoker);
 		invoker->wait();
-		setInvoker(empty);
+		m_PendingInvokers.remove(invoker);
 	}
 
 	DelegateI<WCSpecialInfo&>* clone() override
@@ -88,9 +89,7 @@ public:
 		std::lock_guard<std::mutex> guard(m_InvokerMutex);
 
 		m_bCanceled = true;
-
-		if (m_pInvoker)
-			m_pInvoker->cancel();
+		m_PendingInvokers.cancelAll();
 
 		if (m_pObj && bDeregister)
 			m_pObj->deregisterDelegate(this);
@@ -108,18 +107,11 @@ public:
 		return (uint64)m_pObj;
 	}
 
-protected:
-	void setInvoker(std::shared_ptr<Invoker> &i)
-	{
-		std::lock_guard<std::mutex> guard(m_InvokerMutex);
-		m_pInvoker = i;
-	}
-
 private:
 	TObj* m_pObj;
 	std::atomic<bool> m_bCanceled;
 	std::mutex m_InvokerMutex;
-	std::shared_ptr<Invoker> m_pInvoker;
+	PendingInvokers m_PendingInvokers;
 };
 
 template <class TObj>
@@ -438,6 +438,15 @@ namespace MCFCore
 		//! Pre allocates the mcf. Usefull for large mcf's
 		//!
 		virtual void preAllocateFile()=0;
+
+		//! Sets a previous build of the same folder to take data from when saving. Files with the same
+		//! path, size and time stamp copy their stored data, md5 and crc from it instead of being
+		//! hashed and compressed again. Call before parseFolder.
+		//!
+		//! @param prevMcf Parsed mcf of the previous build, must stay valid until saveMCF returns
+		//! @param checkHash Only reuse a file once its md5 matches as well
+		//!
+		virtual void setReuseMcf(MCFI* prevMcf, bool checkHash = false)=0;
 	};
 
 #ifdef LINK_WITH_GMOCK
@@ -504,6 +513,7 @@ namespace MCFCore
 		MOCK_METHOD2(setFile, void(const char* file, uint64 offset));
 		MOCK_METHOD2(createCourgetteDiffs, void(MCFI* oldMcf, const char* outPath));
 		MOCK_METHOD0(preAllocateFile, void());
+		MOCK_METHOD2(setReuseMcf, void(MCFI* prevMcf, bool checkHash));
 	};
 
 #endif
@@ -0,0 +1,55 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#ifndef DESURA_MCFIOSCHEDULERI_H
+#define DESURA_MCFIOSCHEDULERI_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#define MCF_IOSCHEDULER "MCF_IOSCHEDULER_001"
+
+namespace MCFCore
+{
+
+
+class IOSchedulerI
+{
+public:
+	//! Background mode drops the cpu and io priority of every mcf worker thread
+	//! and caps how fast they read and write to disk
+	//!
+	//! @param bEnabled Turn background mode on or off
+	//! @param uiRateLimit Disk rate cap in KB/s while on, 0 for no cap
+	//!
+	virtual void setBackgroundMode(bool bEnabled, uint32 uiRateLimit)=0;
+
+	virtual bool isBackgroundMode()=0;
+
+protected:
+	virtual ~IOSchedulerI(){}
+};
+
+
+
+}
+
+#endif //DESURA_MCFIOSCHEDULERI_H
@@ -25,6 +25,9 @@ Contact us at legal@badjuju.com.
 
 #include "MCFI.h"
 
+//! Returns a UTIL::WEB::SetBandwidthLimiterFn for sharing a bandwidth limiter with mcfcore
+#define MCF_BANDWIDTHLIMITER "MCF_BANDWIDTHLIMITER"
+
 namespace MCFCore
 {
 	CEXPORT void* FactoryBuilder(const char* name);
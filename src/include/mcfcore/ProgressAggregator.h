@@ -0,0 +1,255 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_PROGRESS_AGGREGATOR_H
+#define DESURA_PROGRESS_AGGREGATOR_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "Event.h"
+#include "mcfcore/ProgressInfo.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+namespace MCFCore
+{
+namespace Misc
+{
+
+//! Coalesces progress from one or more workers into a rate limited stream of ProgressInfo events.
+//!
+//! Workers update the counters with setDone/addDone (lock free) and call publish, of which
+//! at most one per interval actually triggers the event. Already built progress (i.e. forwarded
+//! from another event or over ipc) can be gated with shouldPublish.
+//!
+//! The first update, flag changes and reaching 100% are always published. Everything else is
+//! dropped if it is the same as the last published update or arrives sooner than the max rate allows.
+//! Call finish once the work is done so the final state is never lost to the rate limit.
+//!
+class ProgressAggregator
+{
+public:
+	enum
+	{
+		DEFAULT_RATE = 20,	//!< Default max updates per second
+	};
+
+	typedef std::function<int64()> ClockFn;
+
+	//! Constructor
+	//!
+	//! @param totalAmmount Total ammount of work for the operation
+	//! @param uiMaxRate Max number of updates to publish a second
+	//!
+	ProgressAggregator(uint64 totalAmmount = 0, uint32 uiMaxRate = DEFAULT_RATE)
+		: m_nInterval(uiMaxRate == 0 ? 0 : 1000 / uiMaxRate)
+		, m_uiTotal(totalAmmount)
+		, m_uiDone(0)
+		, m_uiFlag(ProgressInfo::FLAG_NONE)
+		, m_uiLastValue(NOTHING_PUBLISHED)
+		, m_uiLastDone(0)
+		, m_uiLastTotal(0)
+		, m_nNextPublish(0)
+	{
+	}
+
+	//! Resets the counters and the rate limit ready for a new operation
+	//!
+	//! @param totalAmmount Total ammount of work for the operation
+	//! @param flag Starting progress flag
+	//!
+	void reset(uint64 totalAmmount = 0, uint8 flag = ProgressInfo::FLAG_NONE)
+	{
+		m_uiTotal = totalAmmount;
+		m_uiDone = 0;
+		m_uiFlag = flag;
+		m_uiLastValue = NOTHING_PUBLISHED;
+		m_uiLastDone = 0;
+		m_uiLastTotal = 0;
+		m_nNextPublish = 0;
+	}
+
+	void setTotal(uint64 totalAmmount)
+	{
+		m_uiTotal = totalAmmount;
+	}
+
+	void setDone(uint64 doneAmmount)
+	{
+		m_uiDone = doneAmmount;
+	}
+
+	void addDone(uint64 ammount = 1)
+	{
+		m_uiDone += ammount;
+	}
+
+	void setFlag(uint8 flag)
+	{
+		m_uiFlag = flag;
+	}
+
+	//! Replaces the millisecond clock used for the rate limit. Must be set before publishing.
+	//!
+	//! @param fnClock Clock to use or empty for the steady clock
+	//!
+	void setClock(const ClockFn &fnClock)
+	{
+		m_fnClock = fnClock;
+	}
+
+	//! Builds a progress update from the current counters
+	//!
+	ProgressInfo getProgress() const
+	{
+		ProgressInfo info;
+
+		info.totalAmmount = m_uiTotal;
+		info.doneAmmount = m_uiDone;
+		info.flag = m_uiFlag;
+
+		if (info.totalAmmount != 0)
+		{
+			if (info.doneAmmount > info.totalAmmount)
+				info.doneAmmount = info.totalAmmount;
+
+			info.percent = (uint8)(info.doneAmmount * 100 / info.totalAmmount);
+		}
+
+		return info;
+	}
+
+	//! Triggers the event with the current counters if an update is due
+	//!
+	//! @param event Event to trigger
+	//! @param bForce Publish even if not due
+	//! @return True if the event was triggered
+	//!
+	bool publish(Event<ProgressInfo> &event, bool bForce = false)
+	{
+		ProgressInfo info = getProgress();
+
+		if (!shouldPublish(info, bForce))
+			return false;
+
+		event(info);
+		return true;
+	}
+
+	//! Marks all the work as done and publishes it regardless of the rate limit
+	//!
+	//! @param event Event to trigger
+	//!
+	void finish(Event<ProgressInfo> &event)
+	{
+		m_uiDone = m_uiTotal.load();
+		flush(event);
+	}
+
+	//! Publishes the current counters regardless of the rate limit
+	//!
+	//! @param event Event to trigger
+	//!
+	void flush(Event<ProgressInfo> &event)
+	{
+		publish(event, true);
+	}
+
+	//! Checks if an already built progress update should be passed on
+	//!
+	//! @param info Progress update
+	//! @param bForce Publish even if not due
+	//! @return True if it should be published
+	//!
+	bool shouldPublish(ProgressInfo &info, bool bForce = false)
+	{
+		uint64 uiValue = info.toInt64();
+		uint64 uiLast = m_uiLastValue;
+
+		Prog_u last;
+		last.value = uiLast;
+
+		bool bImportant = bForce
+			|| uiLast == NOTHING_PUBLISHED
+			|| last.prog.flag != info.flag
+			|| info.percent >= 100;
+
+		int64 nNow = getTimeMs();
+
+		if (!bImportant)
+		{
+			if (uiValue == uiLast && info.doneAmmount == m_uiLastDone && info.totalAmmount == m_uiLastTotal)
+				return false;
+
+			int64 nNext = m_nNextPublish;
+
+			if (nNow < nNext)
+				return false;
+
+			//only one thread gets to publish per interval
+			if (!m_nNextPublish.compare_exchange_strong(nNext, nNow + m_nInterval))
+				return false;
+		}
+		else
+		{
+			m_nNextPublish = nNow + m_nInterval;
+		}
+
+		m_uiLastDone = info.doneAmmount;
+		m_uiLastTotal = info.totalAmmount;
+		m_uiLastValue = uiValue;
+		return true;
+	}
+
+protected:
+	int64 getTimeMs() const
+	{
+		if (m_fnClock)
+			return m_fnClock();
+
+		using namespace std::chrono;
+		return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	static const uint64 NOTHING_PUBLISHED = (uint64)-1;
+
+	const int64 m_nInterval;
+
+	std::atomic<uint64> m_uiTotal;
+	std::atomic<uint64> m_uiDone;
+	std::atomic<uint8> m_uiFlag;
+
+	std::atomic<uint64> m_uiLastValue;
+	std::atomic<uint64> m_uiLastDone;
+	std::atomic<uint64> m_uiLastTotal;
+	std::atomic<int64> m_nNextPublish;
+
+	ClockFn m_fnClock;
+};
+
+}
+}
+
+#endif //DESURA_PROGRESS_AGGREGATOR_H
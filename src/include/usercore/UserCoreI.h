@@ -37,6 +37,9 @@ class WCSpecialInfo;
 #define USERCORE_VER				"USERCORE_VERSION"
 #define USERCORE_GETLOGIN			"USERCORE_GETLOGIN"
 #define USERCORE_GETITEMSTATUS		"USERCORE_GETITEMSTATUS"
+#define USERCORE_METRICS			"USERCORE_METRICS"
+#define USERCORE_TIMELINE			"USERCORE_TIMELINE"
+#define USERCORE_BANDWIDTHLIMITER	"USERCORE_BANDWIDTHLIMITER"
 
 typedef const char* (*UserCoreVersionFN)();
 typedef void *UserCoreGetLoginFN(char**, char**);
@@ -201,6 +204,10 @@ namespace UserCore
 		//!
 		virtual void setQATesting(bool bEnable = true)=0;
 
+		//! Applies the background mode cvars again, i.e. after they have changed
+		//!
+		virtual void refreshBackgroundMode()=0;
+
 		///////////////////////////////////////////////////////////////////////////////
 		// Getters
 		///////////////////////////////////////////////////////////////////////////////
@@ -507,6 +514,7 @@ namespace UserCore
 		MOCK_METHOD0(forceUpdatePoll, void());
 		MOCK_METHOD0(forceQATestingUpdate, void());
 		MOCK_METHOD1(setQATesting, void(bool bEnable));
+		MOCK_METHOD0(refreshBackgroundMode, void());
 		MOCK_METHOD0(getUserId, uint32());
 		MOCK_METHOD0(getAvatar, const char*());
 		MOCK_METHOD0(getProfileUrl, const char*());
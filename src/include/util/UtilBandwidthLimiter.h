@@ -0,0 +1,99 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#ifndef DESURA_UTIL_BANDWIDTHLIMITER_H
+#define DESURA_UTIL_BANDWIDTHLIMITER_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "util/UtilTokenBucket.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace UTIL
+{
+namespace WEB
+{
+	enum class TrafficDirection
+	{
+		Download,
+		Upload,
+	};
+
+	//! Interactive transfers (api calls, web pages, images) are charged to the budget but never
+	//! wait, so they take their share out of what is left for background transfers (mcf
+	//! downloads, uploads and tools) which do. The debt interactive transfers can run up is
+	//! capped at one second of the limit.
+	enum class TrafficClass
+	{
+		Interactive,
+		Background,
+	};
+
+	//! Process wide bandwidth budget with separate download and upload limits
+	class BandwidthLimiter
+	{
+	public:
+		//! @param nRate Bytes per second, 0 for no limit
+		//!
+		void setDownloadLimit(uint64 nRate);
+
+		//! @param nRate Bytes per second, 0 for no limit
+		//!
+		void setUploadLimit(uint64 nRate);
+
+		uint64 getDownloadLimit() const;
+		uint64 getUploadLimit() const;
+
+		//! Charges transferred bytes to a budget
+		//!
+		//! @param direction Budget to charge
+		//! @param trafficClass Class of the transfer
+		//! @param nBytes Bytes transferred
+		//! @return How long the transfer has to wait before going on
+		//!
+		std::chrono::microseconds take(TrafficDirection direction, TrafficClass trafficClass, uint64 nBytes);
+
+	private:
+		UTIL::MISC::TokenBucket m_DownloadBucket;
+		UTIL::MISC::TokenBucket m_UploadBucket;
+
+		std::atomic<uint64> m_nDownloadRate = {0};
+		std::atomic<uint64> m_nUploadRate = {0};
+	};
+
+	//! Limiter used by the http handles of this module (each shared library gets its own
+	//! unless SetBandwidthLimiter points it at another modules one)
+	//!
+	BandwidthLimiter& GetBandwidthLimiter();
+
+	//! Makes this module charge its transfers to another modules limiter so they share one
+	//! budget. Pass nullptr to go back to the modules own limiter.
+	//!
+	void SetBandwidthLimiter(BandwidthLimiter* pLimiter);
+
+	typedef void (*SetBandwidthLimiterFn)(BandwidthLimiter* pLimiter);
+}
+}
+
+#endif
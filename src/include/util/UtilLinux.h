@@ -108,6 +108,21 @@ namespace LIN
 
 	bool launchFolder(const char* path);
 
+	//! Finds processes whose binary is inside a folder
+	//!
+	//! @param szPath Folder to look for
+	//! @return Process ids
+	//!
+	std::vector<uint32> getProcessesRunningAtPath(const char* szPath);
+
+	//! Finds processes whose binary or working dir is inside a folder. Catches games started
+	//! through a launch script as they show up as the shell
+	//!
+	//! @param szPath Folder to look for
+	//! @return Process ids
+	//!
+	std::vector<uint32> getProcessesUsingPath(const char* szPath);
+
 	//! Returns the stdout of a system() call
 	//!
 	//! @param command command to execute
@@ -0,0 +1,214 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#ifndef DESURA_UTIL_METRICS_H
+#define DESURA_UTIL_METRICS_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace UTIL
+{
+namespace METRICS
+{
+	//! Number of stripes a counter is split into. Threads are spread over them by id so a hot
+	//! counter doesnt bounce one cache line between every core that touches it
+	const uint32 COUNTER_SHARDS = 16;
+
+	inline uint32 GetThreadShard()
+	{
+		return (uint32)(std::hash<std::thread::id>()(std::this_thread::get_id()) % COUNTER_SHARDS);
+	}
+
+	//! Monotonic counter (bytes, events, failures)
+	class Counter
+	{
+	public:
+		Counter();
+
+		void add(uint64 nAmount = 1)
+		{
+			m_Shards[GetThreadShard()].m_nValue.fetch_add(nAmount, std::memory_order_relaxed);
+		}
+
+		uint64 get() const;
+
+	private:
+		class Shard
+		{
+		public:
+			std::atomic<uint64> m_nValue;
+			char m_Pad[64 - sizeof(std::atomic<uint64>)];
+		};
+
+		Shard m_Shards[COUNTER_SHARDS];
+	};
+
+	//! Point in time value (queue depth, active workers)
+	class Gauge
+	{
+	public:
+		Gauge();
+
+		void set(int64 nValue)
+		{
+			m_nValue.store(nValue, std::memory_order_relaxed);
+		}
+
+		void add(int64 nAmount)
+		{
+			m_nValue.fetch_add(nAmount, std::memory_order_relaxed);
+		}
+
+		int64 get() const
+		{
+			return m_nValue.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<int64> m_nValue;
+	};
+
+	class HistogramSnapshot
+	{
+	public:
+		uint64 m_nCount = 0;
+		uint64 m_nSum = 0;
+		uint64 m_nMax = 0;
+
+		//! Non empty buckets as (lowest value in bucket, count) in ascending order
+		std::vector<std::pair<uint64, uint64>> m_vBuckets;
+
+		//! Value at the given percentile (0-100), rounded up to the top of its bucket (12.5%)
+		//!
+		uint64 getPercentile(double dPercentile) const;
+
+		double getMean() const
+		{
+			return m_nCount ? (double)m_nSum / m_nCount : 0.0;
+		}
+	};
+
+	//! Log linear histogram in the style of HdrHistogram. Each power of two is split into
+	//! eight buckets so recorded values are kept to within 12.5% over the full 64 bit range
+	//! with a fixed amount of memory and no locking.
+	class Histogram
+	{
+	public:
+		Histogram();
+
+		void record(uint64 nValue);
+		HistogramSnapshot snapshot() const;
+
+		static uint32 getBucket(uint64 nValue);
+		static uint64 getBucketValue(uint32 nBucket);
+
+		static const uint32 SUB_BUCKET_BITS = 3;
+		static const uint32 SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+		static const uint32 BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+	private:
+		std::atomic<uint64> m_Buckets[BUCKET_COUNT];
+		std::atomic<uint64> m_nMax;
+
+		Counter m_Count;
+		Counter m_Sum;
+	};
+
+	//! Records the time in microseconds between construction and destruction
+	class ScopedTimer
+	{
+	public:
+		ScopedTimer(Histogram &histogram)
+			: m_Histogram(histogram)
+			, m_Start(std::chrono::steady_clock::now())
+		{
+		}
+
+		~ScopedTimer()
+		{
+			m_Histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_Start).count());
+		}
+
+	private:
+		Histogram &m_Histogram;
+		const std::chrono::steady_clock::time_point m_Start;
+	};
+
+	class Snapshot
+	{
+	public:
+		std::map<std::string, uint64> m_mCounters;
+		std::map<std::string, int64> m_mGauges;
+		std::map<std::string, HistogramSnapshot> m_mHistograms;
+
+		//! Appends the snapshot as a json object
+		//!
+		//! @param strOut String to append to
+		//! @param pPrevious Earlier snapshot used to work out per second counter rates. Can be null
+		//! @param dSeconds Seconds between pPrevious and this snapshot
+		//!
+		void toJson(std::string &strOut, const Snapshot* pPrevious = nullptr, double dSeconds = 0.0) const;
+
+		//! Appends the snapshot as human readable lines
+		//!
+		//! @param strOut String to append to
+		//! @param szFilter Only include metrics starting with this. Can be null
+		//!
+		void toText(std::string &strOut, const char* szFilter = nullptr) const;
+	};
+
+	//! Owns the named metrics of a module. Lookups take a lock so callers should look a metric
+	//! up once and keep the reference, metrics are never removed.
+	class Registry
+	{
+	public:
+		Counter& counter(const std::string &strName);
+		Gauge& gauge(const std::string &strName);
+		Histogram& histogram(const std::string &strName);
+
+		void snapshot(Snapshot &snapshot) const;
+
+	private:
+		mutable std::mutex m_Lock;
+
+		std::map<std::string, std::unique_ptr<Counter>> m_mCounters;
+		std::map<std::string, std::unique_ptr<Gauge>> m_mGauges;
+		std::map<std::string, std::unique_ptr<Histogram>> m_mHistograms;
+	};
+
+	//! Gets the registry metrics are created in. Created on first use and never freed so globals
+	//! can hold metric references. Other modules read it through their factory exports.
+	//!
+	Registry& GetRegistry();
+}
+}
+
+#endif //DESURA_UTIL_METRICS_H
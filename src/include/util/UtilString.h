@@ -178,6 +178,13 @@ namespace STRING
 	//! @return Escaped string
 	//!
 	std::string escape(const std::string &in);
+
+	//! Appends the string escaped for use inside a json string literal
+	//!
+	//! @param strOut String to append to
+	//! @param in String to escape
+	//!
+	void appendJsonEscaped(std::string &strOut, const std::string &in);
 }
 }
 #endif
@@ -0,0 +1,173 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#ifndef DESURA_UTIL_TIMELINE_H
+#define DESURA_UTIL_TIMELINE_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace UTIL
+{
+namespace TIMELINE
+{
+	//! Number of span buffers. Threads are spread over them by id so recording a span
+	//! almost never waits on another thread
+	const uint32 BUFFER_SHARDS = 16;
+
+	//! Spans kept per buffer, the oldest are overwritten once full
+	const uint32 BUFFER_SIZE = 8192;
+
+	//! Names of exited threads kept for their remaining spans before the oldest are dropped
+	const uint32 MAX_EXITED_THREAD_NAMES = 64;
+
+	class Span
+	{
+	public:
+		const char* m_szCategory = nullptr;
+		std::string m_strName;
+		std::string m_strDetail;
+
+		uint64 m_nThreadId = 0;
+		int64 m_nStart = 0;
+		int64 m_nDuration = 0;
+	};
+
+	//! Records timed spans of work for viewing in chrome://tracing.
+	//!
+	//! Category must be a string literal as only the pointer is kept.
+	class Timeline
+	{
+	public:
+		Timeline();
+
+		void setEnabled(bool bEnabled)
+		{
+			m_bEnabled.store(bEnabled, std::memory_order_relaxed);
+		}
+
+		bool isEnabled() const
+		{
+			return m_bEnabled.load(std::memory_order_relaxed);
+		}
+
+		void record(const char* szCategory, std::string strName, std::string strDetail, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+		//! Names the calling thread in the trace output
+		void setThreadName(const char* szName);
+
+		//! Drops the calling threads name once its spans have been cleared
+		void threadExited();
+
+		//! Appends recorded spans as comma separated trace event objects
+		//!
+		//! @param strOut String to append to
+		//! @param bClear Remove the spans once they have been added
+		//!
+		void appendEvents(std::string &strOut, bool bClear = false);
+
+		void clear();
+
+		static uint64 getCurrentThreadId();
+
+	private:
+		class Buffer
+		{
+		public:
+			std::mutex m_Lock;
+			std::vector<Span> m_vSpans;
+			uint32 m_nNext = 0;
+		};
+
+		std::atomic<bool> m_bEnabled;
+		Buffer m_Buffers[BUFFER_SHARDS];
+
+		void removeExitedThreadNames();
+
+		std::mutex m_ThreadNameLock;
+		std::map<uint64, std::string> m_mThreadNames;
+		std::deque<uint64> m_vExitedThreads;
+	};
+
+	//! Gets the span recorder ScopedSpan writes to. The static util lib is linked into every
+	//! shared library so each has its own, FormatChromeTrace merges them into one trace.
+	//!
+	Timeline& GetTimeline();
+
+	//! Builds a chrome trace event json document from a set of module timelines
+	//!
+	std::string FormatChromeTrace(const std::vector<Timeline*> &vTimelines, bool bClear = false);
+
+	//! Records a span covering its own lifetime into this modules timeline. Costs a relaxed
+	//! load when the timeline is disabled.
+	class ScopedSpan
+	{
+	public:
+		ScopedSpan(const char* szCategory, const char* szName)
+			: m_szCategory(szCategory)
+			, m_bEnabled(GetTimeline().isEnabled())
+		{
+			if (!m_bEnabled)
+				return;
+
+			m_strName = szName;
+			m_Start = std::chrono::steady_clock::now();
+		}
+
+		ScopedSpan(const char* szCategory, const std::string &strName)
+			: ScopedSpan(szCategory, strName.c_str())
+		{
+		}
+
+		template <typename ... Args>
+		ScopedSpan(const char* szCategory, const char* szName, const char* szDetailFormat, Args ... args)
+			: ScopedSpan(szCategory, szName)
+		{
+			if (m_bEnabled)
+				m_strDetail = gcString(szDetailFormat, args...);
+		}
+
+		~ScopedSpan()
+		{
+			if (m_bEnabled)
+				GetTimeline().record(m_szCategory, std::move(m_strName), std::move(m_strDetail), m_Start, std::chrono::steady_clock::now());
+		}
+
+	private:
+		const char* m_szCategory;
+		const bool m_bEnabled;
+
+		std::string m_strName;
+		std::string m_strDetail;
+		std::chrono::steady_clock::time_point m_Start;
+	};
+}
+}
+
+#endif //DESURA_UTIL_TIMELINE_H
@@ -0,0 +1,82 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#ifndef DESURA_UTIL_TOKENBUCKET_H
+#define DESURA_UTIL_TOKENBUCKET_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include <chrono>
+#include <mutex>
+
+namespace UTIL
+{
+namespace MISC
+{
+	//! Rate limiter for bytes (or any other unit). Tokens refill at a fixed rate up to a burst
+	//! size. A caller taking more than is available goes into debt and is told how long to wait,
+	//! so one large block is not starved by a stream of small ones.
+	class TokenBucket
+	{
+	public:
+		//! @param nRate Tokens per second, 0 for no limit
+		//! @param nBurst Most tokens that can build up, 0 for one second worth
+		//!
+		TokenBucket(uint64 nRate = 0, uint64 nBurst = 0);
+
+		//! Changes the rate, tokens already built up are kept up to the new burst size
+		//!
+		void setRate(uint64 nRate, uint64 nBurst = 0);
+
+		uint64 getRate() const;
+
+		//! Takes tokens from the bucket
+		//!
+		//! @return How long the caller has to wait before using them
+		//!
+		std::chrono::microseconds take(uint64 nTokens);
+
+		//! Takes tokens and sleeps until they are paid for
+		//!
+		void consume(uint64 nTokens);
+
+		//! Takes tokens for a caller that never waits. The debt this leaves is capped at one burst
+		//! so the callers that do wait are not held up for longer than that by it
+		//!
+		void charge(uint64 nTokens);
+
+	protected:
+		void refill(std::chrono::steady_clock::time_point tNow);
+
+	private:
+		mutable std::mutex m_Lock;
+
+		uint64 m_nRate = 0;
+		uint64 m_nBurst = 0;
+		double m_dTokens = 0.0;
+
+		std::chrono::steady_clock::time_point m_tLastRefill;
+	};
+}
+}
+
+#endif
@@ -26,6 +26,7 @@ Contact us at legal@badjuju.com.
 #pragma once
 #endif
 
+#include "util/UtilBandwidthLimiter.h"
 
 typedef struct
 {
@@ -112,6 +113,10 @@ public:
 	//!
 	virtual void setUserPass(const char* user, const char* pass)=0;
 
+	//! Sets which bandwidth class transfers on this handle are charged as (default interactive)
+	//!
+	virtual void setTrafficClass(UTIL::WEB::TrafficClass trafficClass)=0;
+
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Getters
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -57,6 +57,7 @@ namespace UTIL
 #include <ctype.h>
 #include <iostream>
 #include <iomanip>
+#include <type_traits>
 
 
 template <typename T> class gcBaseString;
@@ -831,48 +832,6 @@ public:
 };
 
 
-template <class CT, typename A, typename B, typename C, typename D, typename E, typename F>
-std::basic_string<CT> Format(const CT* format,
-	const A &a, const B &b, const C &c,
-	const D &d, const E &e, const F &f);
-
-
-template <class CT>
-std::basic_string<CT> Format(const CT* t)
-{
-	return Format<CT, NullArg, NullArg, NullArg, NullArg, NullArg, NullArg>(t, NullArg(), NullArg(), NullArg(), NullArg(), NullArg(), NullArg());
-}
-
-template <class CT, typename A>
-std::basic_string<CT> Format(const CT* t, const A &a)
-{
-	return Format<CT, A, NullArg, NullArg, NullArg, NullArg, NullArg>(t, a, NullArg(), NullArg(), NullArg(), NullArg(), NullArg());
-}
-
-template <class CT, typename A, typename B>
-std::basic_string<CT> Format(const CT* t, const A &a, const B &b)
-{
-	return Format<CT, A, B, NullArg, NullArg, NullArg, NullArg>(t, a, b, NullArg(), NullArg(), NullArg(), NullArg());
-}
-
-template <class CT, typename A, typename B, typename C>
-std::basic_string<CT> Format(const CT* t, const A &a, const B &b, const C &c)
-{
-	return Format<CT, A, B, C, NullArg, NullArg, NullArg>(t, a, b, c, NullArg(), NullArg(), NullArg());
-}
-
-template <class CT, typename A, typename B, typename C, typename D>
-std::basic_string<CT> Format(const CT* t, const A &a, const B &b, const C &c, const D &d)
-{
-	return Format<CT, A, B, C, D, NullArg, NullArg>(t, a, b, c, d, NullArg(), NullArg());
-}
-
-template <class CT, typename A, typename B, typename C, typename D, typename E>
-std::basic_string<CT> Format(const CT* t, const A &a, const B &b, const C &c, const D &d, const E &e)
-{
-	return Format<CT, A, B, C, D, E, NullArg>(t, a, b, c, d, e, NullArg());
-}
-
 inline int atoi(const char* str)
 {
 	return Safe::atoi(str);
@@ -1095,8 +1054,11 @@ std::basic_string<CT> FormatString(const CT* format, std::vector<FormatArgI<CT>*
 
 
 
+//! Original stream based formatter. Superseded by Format below, kept as the
+//! reference implementation for the format unit tests and benchmarks.
+//!
 template <class CT, typename A, typename B, typename C, typename D, typename E, typename F>
-std::basic_string<CT> Format(const CT* format,
+std::basic_string<CT> FormatLegacy(const CT* format,
 	const A &a, const B &b, const C &c,
 	const D &d, const E &e, const F &f)
 {
@@ -1139,6 +1101,505 @@ std::basic_string<CT> Format(const CT* format,
 }
 
 
+//! Width used by FormatArg for a {N,L.P} place holder. Kept identical (including
+//! how the unset values wrap) so the fast paths below pad exactly like the stream does
+//!
+inline int GetFormatWidth(size_t len, size_t per)
+{
+	if (len == UINT_MAX)
+		return 0;
+
+	if (per != UINT_MAX)
+		len += per;
+
+	return (int)len;
+}
+
+template <typename CT>
+void AppendPadded(std::basic_string<CT> &out, const CT* str, size_t strLen, size_t len, size_t per)
+{
+	int nWidth = GetFormatWidth(len, per);
+
+	if (nWidth > 0 && (size_t)nWidth > strLen)
+		out.append(nWidth - strLen, (CT)' ');
+
+	out.append(str, strLen);
+}
+
+template <typename CT, typename T>
+void AppendInteger(std::basic_string<CT> &out, T t, size_t len, size_t per)
+{
+	typedef typename std::make_unsigned<T>::type UT;
+
+	CT szBuff[24];
+	CT* pEnd = szBuff + 24;
+	CT* pPos = pEnd;
+
+	bool bNegative = std::is_signed<T>::value && t < (T)0;
+	UT v = bNegative ? (UT)((UT)0 - (UT)t) : (UT)t;
+
+	do
+	{
+		*--pPos = (CT)('0' + (v % 10));
+		v /= 10;
+	}
+	while (v);
+
+	if (bNegative)
+		*--pPos = (CT)'-';
+
+	AppendPadded(out, pPos, pEnd - pPos, len, per);
+}
+
+//! Appends a single argument to the output. Anything that isnt a plain
+//! integer or same width string (or uses a type specifier) goes through FormatArg
+//!
+template <typename CT, typename T>
+void AppendFormatArg(std::basic_string<CT> &out, const T& t, FormatTypes type, size_t len, size_t per)
+{
+	out.append(FormatArg<CT, T>(t, type, len, per));
+}
+
+#define GC_FORMAT_APPEND_INTEGER(Type)																				\
+	template <typename CT>																							\
+	void AppendFormatArg(std::basic_string<CT> &out, const Type& t, FormatTypes type, size_t len, size_t per)		\
+	{																												\
+		if (type == NONE)																							\
+			AppendInteger<CT, Type>(out, t, len, per);																\
+		else																										\
+			out.append(FormatArg<CT, Type>(t, type, len, per));													\
+	}
+
+GC_FORMAT_APPEND_INTEGER(short)
+GC_FORMAT_APPEND_INTEGER(unsigned short)
+GC_FORMAT_APPEND_INTEGER(int)
+GC_FORMAT_APPEND_INTEGER(unsigned int)
+GC_FORMAT_APPEND_INTEGER(long)
+GC_FORMAT_APPEND_INTEGER(unsigned long)
+GC_FORMAT_APPEND_INTEGER(long long)
+GC_FORMAT_APPEND_INTEGER(unsigned long long)
+
+#undef GC_FORMAT_APPEND_INTEGER
+
+template <typename CT>
+void AppendFormatArg(std::basic_string<CT> &out, const bool& t, FormatTypes type, size_t len, size_t per)
+{
+	if (type != NONE)
+	{
+		out.append(FormatArg<CT, bool>(t, type, len, per));
+		return;
+	}
+
+	CT c = t ? (CT)'1' : (CT)'0';
+	AppendPadded(out, &c, 1, len, per);
+}
+
+template <typename CT>
+void AppendFormatString(std::basic_string<CT> &out, const CT* t, FormatTypes type, size_t len, size_t per)
+{
+	if (type != NONE)
+	{
+		out.append(FormatArg<CT, const CT*>(t, type, len, per));
+		return;
+	}
+
+	if (!t)
+	{
+		const CT szNull[] = { 'n', 'u', 'l', 'l', 'p', 't', 'r' };
+		AppendPadded(out, szNull, 7, len, per);
+	}
+	else
+	{
+		AppendPadded(out, t, std::char_traits<CT>::length(t), len, per);
+	}
+}
+
+template <typename CT>
+void AppendFormatArg(std::basic_string<CT> &out, const CT* const& t, FormatTypes type, size_t len, size_t per)
+{
+	AppendFormatString(out, t, type, len, per);
+}
+
+template <typename CT>
+void AppendFormatArg(std::basic_string<CT> &out, CT* const& t, FormatTypes type, size_t len, size_t per)
+{
+	AppendFormatString<CT>(out, t, type, len, per);
+}
+
+template <typename CT>
+void AppendFormatArg(std::basic_string<CT> &out, const std::basic_string<CT>& t, FormatTypes type, size_t len, size_t per)
+{
+	AppendFormatString<CT>(out, t.c_str(), type, len, per);
+}
+
+template <typename CT>
+void AppendFormatArg(std::basic_string<CT> &out, const gcBaseString<CT>& t, FormatTypes type, size_t len, size_t per)
+{
+	AppendFormatString<CT>(out, t.c_str(), type, len, per);
+}
+
+//! Type erased reference to a format argument. Lives on the stack for the
+//! duration of the format call so no per argument allocation is needed.
+//!
+template <typename CT>
+class FormatArgRef
+{
+public:
+	template <typename T>
+	FormatArgRef(const T& t)
+		: m_pArg(&t)
+		, m_pAppend(&appendArg<T>)
+	{
+	}
+
+	//! Arrays (i.e. string literals) are passed on as pointers
+	template <typename T, size_t N>
+	FormatArgRef(const T (&t)[N])
+		: m_pArg(t)
+		, m_pAppend(&appendArray<T>)
+	{
+	}
+
+	void append(std::basic_string<CT> &out, FormatTypes type, size_t len, size_t per) const
+	{
+		m_pAppend(out, m_pArg, type, len, per);
+	}
+
+private:
+	template <typename T>
+	static void appendArg(std::basic_string<CT> &out, const void* pArg, FormatTypes type, size_t len, size_t per)
+	{
+		AppendFormatArg<CT>(out, *static_cast<const T*>(pArg), type, len, per);
+	}
+
+	template <typename T>
+	static void appendArray(std::basic_string<CT> &out, const void* pArg, FormatTypes type, size_t len, size_t per)
+	{
+		const T* t = static_cast<const T*>(pArg);
+		AppendFormatArg<CT>(out, t, type, len, per);
+	}
+
+	const void* m_pArg;
+	void (*m_pAppend)(std::basic_string<CT>&, const void*, FormatTypes, size_t, size_t);
+};
+
+template <class CT>
+FormatTypes GetTypeFromString(const CT* pStart, const CT* pEnd)
+{
+	size_t nSize = pEnd - pStart;
+
+	if (nSize == 1)
+	{
+		switch (pStart[0])
+		{
+		case 'c':
+			return CHAR;
+
+		case 's':
+			return STRING;
+
+		case 'u':
+			return UINT;
+
+		case 'i':
+			return INT;
+
+		case 'f':
+			return FLOAT;
+
+		case 'd':
+			return DOUBLE;
+
+		case 'b':
+			return BOOL;
+
+		case 'x':
+			return HEX;
+		}
+	}
+	else if (nSize == 2)
+	{
+		if (pStart[0] == 'b' && pStart[1] == 's')
+			return BOOL_STRING;
+		else if (pStart[0] == 'x' && pStart[1] == 'b')
+			return HEX_BASE;
+	}
+	else if (nSize == 3 && pStart[1] == '6' && pStart[2] == '4')
+	{
+		if (pStart[0] == 'u')
+			return UINT64;
+		else if (pStart[0] == 'i')
+			return INT64;
+	}
+
+	return NONE;
+}
+
+//! Parses the digits between pStart and pEnd. Returns false if a non digit is found
+//!
+template <class CT>
+bool ParseFormatNumber(const CT* pStart, const CT* pEnd, size_t &nOut)
+{
+	if (pStart == pEnd)
+		return true;
+
+	int nVal = 0;
+
+	for (const CT* p = pStart; p != pEnd; ++p)
+	{
+		if (!isdigit(*p))
+			return false;
+
+		nVal = nVal * 10 + (*p - '0');
+	}
+
+	nOut = nVal;
+	return true;
+}
+
+template <class CT>
+void AppendUnformatted(std::basic_string<CT> &ret, const CT* pStart, const CT* pEnd)
+{
+	ret += (CT)'{';
+	ret.append(pStart, pEnd);
+	ret += (CT)'}';
+}
+
+//! Single pass format. Produces the same output as FormatString but appends
+//! straight into ret instead of rebuilding the format string char by char.
+//!
+template <class CT>
+void FormatStringInto(std::basic_string<CT> &ret, const CT* format, const FormatArgRef<CT>* argsList, size_t nArgCount)
+{
+	if (!format)
+		return;
+
+	const CT* t = format;
+	const CT* pEnd = format + std::char_traits<CT>::length(format);
+
+	ret.reserve(ret.size() + (pEnd - format) + nArgCount * 16);
+
+#ifdef DEBUG
+	for (const CT* p = t; p + 1 < pEnd; ++p)
+	{
+		if (*p == '%' && p[1] != ' ' && p[1] != '%')
+		{
+			PAUSE_DEBUGGER();
+			break;
+		}
+	}
+#endif
+
+	while (t < pEnd)
+	{
+		const CT* pLiteral = t;
+
+		while (t < pEnd && *t != '{')
+			++t;
+
+		ret.append(pLiteral, t);
+
+		if (t == pEnd)
+			break;
+
+		if (pEnd - t == 1)
+		{
+			ret += *t;
+			break;
+		}
+
+		++t;
+
+		//must have some other bracket set, output what we have so far
+		const CT* pStart = t;
+
+		while (t < pEnd && *t != '}')
+		{
+			if (*t == '{')
+			{
+				ret += (CT)'{';
+				ret.append(pStart, t);
+				pStart = t + 1;
+			}
+
+			++t;
+		}
+
+		if (t == pEnd)
+		{
+			ret += (CT)'{';
+			ret.append(pStart, t);
+			break;
+		}
+
+		const CT* pClose = t;
+		++t;
+
+		if (pStart == pClose)
+		{
+			ret += (CT)'{';
+			ret += (CT)'}';
+			continue;
+		}
+
+		if (!isdigit(*pStart))
+		{
+			AppendUnformatted(ret, pStart, pClose);
+			continue;
+		}
+
+		size_t arg = *pStart - '0';
+
+		if (arg >= nArgCount)
+		{
+			AppendUnformatted(ret, pStart, pClose);
+			PAUSE_DEBUGGER();
+			continue;
+		}
+
+		const CT* p = pStart + 1;
+
+		size_t len = (size_t)-1;
+		size_t per = (size_t)-1;
+		FormatTypes type = NONE;
+
+		bool bValid = true;
+
+		if (pClose - p > 1 && *p == ',')
+		{
+			const CT* pNum = ++p;
+
+			while (p < pClose && *p != '.' && *p != ':')
+				++p;
+
+			bValid = ParseFormatNumber(pNum, p, len);
+		}
+
+		if (bValid && pClose - p > 1 && *p == '.')
+		{
+			const CT* pNum = ++p;
+
+			while (p < pClose && *p != ':')
+				++p;
+
+			bValid = ParseFormatNumber(pNum, p, per);
+		}
+
+		if (bValid && pClose - p > 1 && *p == ':')
+		{
+			const CT* pType = ++p;
+
+			while (p < pClose && *p != ':')
+			{
+				if (!isalnum(*p))
+					bValid = false;
+
+				++p;
+			}
+
+			type = GetTypeFromString(pType, p);
+		}
+
+		if (!bValid)
+		{
+			AppendUnformatted(ret, pStart, pClose);
+			PAUSE_DEBUGGER();
+			continue;
+		}
+
+		argsList[arg].append(ret, type, len, per);
+	}
+}
+
+template <class CT>
+void FormatInto(std::basic_string<CT> &out, const CT* format)
+{
+	FormatStringInto<CT>(out, format, nullptr, 0);
+}
+
+template <class CT, typename A, typename... Args>
+void FormatInto(std::basic_string<CT> &out, const CT* format, const A &a, const Args&... args)
+{
+	const FormatArgRef<CT> argsList[] = { FormatArgRef<CT>(a), FormatArgRef<CT>(args)... };
+	FormatStringInto<CT>(out, format, argsList, sizeof...(Args) + 1);
+}
+
+template <class CT, typename... Args>
+std::basic_string<CT> Format(const CT* format, const Args&... args)
+{
+	std::basic_string<CT> ret;
+	FormatInto(ret, format, args...);
+	return ret;
+}
+
+//! Compile time version of the index check FormatStringInto does. A format string is
+//! only parsed when it has arguments, so a format without them is always valid. Follows
+//! the same rules as the runtime parser: a '{' inside a placeholder starts it again, an
+//! unclosed or empty placeholder is literal text and only the first digit is the index.
+//!
+namespace FormatCheck
+{
+	template <class CT>
+	constexpr bool IsDigit(CT c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	template <class CT>
+	constexpr const CT* BodyEnd(const CT* s)
+	{
+		return (*s == '\0' || *s == '{' || *s == '}') ? s : BodyEnd(s + 1);
+	}
+
+	template <class CT>
+	constexpr bool CheckFrom(const CT* s, size_t nArgs);
+
+	template <class CT>
+	constexpr bool CheckBody(const CT* s, const CT* e, size_t nArgs)
+	{
+		return *e == '\0' ? true
+			: *e == '{' ? CheckBody(e + 1, BodyEnd(e + 1), nArgs)
+			: (s == e || !IsDigit(*s) || (size_t)(*s - '0') < nArgs) && CheckFrom(e + 1, nArgs);
+	}
+
+	template <class CT>
+	constexpr bool CheckFrom(const CT* s, size_t nArgs)
+	{
+		return *s == '\0' ? true
+			: *s == '{' ? CheckBody(s + 1, BodyEnd(s + 1), nArgs)
+			: CheckFrom(s + 1, nArgs);
+	}
+
+	//! True if every placeholder in a literal format refers to one of nArgs arguments
+	template <class CT, size_t N>
+	constexpr bool IsValid(const CT (&szFormat)[N], size_t nArgs)
+	{
+		return nArgs == 0 || CheckFrom<CT>(szFormat, nArgs);
+	}
+
+	//! Formats that are not literals can only be checked at runtime
+	template <typename T>
+	constexpr bool IsValid(const T &, size_t)
+	{
+		return true;
+	}
+
+	template <typename T>
+	struct IsLiteral : std::false_type
+	{
+	};
+
+	template <class CT, size_t N>
+	struct IsLiteral<const CT (&)[N]> : std::true_type
+	{
+	};
+
+	//! Only used in decltype to count the arguments after the format
+	template <typename F, typename... Args>
+	std::integral_constant<size_t, sizeof...(Args)> CountArgs(const F &, const Args&...);
+}
+
+
 }
 
 //
@@ -1192,52 +1653,10 @@ public:
 		this->assign(out);
 	}
 
-	template <typename CT, typename A>
-	gcBaseString(const CT* tIn, const A &a)
-	{
-		std::basic_string<T> t;
-		Template::ConvertStdString(tIn, t);
-		this->assign(Template::Format<T, A, Template::NullArg, Template::NullArg, Template::NullArg, Template::NullArg, Template::NullArg>(t.c_str(), a, Template::NullArg(), Template::NullArg(), Template::NullArg(), Template::NullArg(), Template::NullArg()));
-	}
-
-	template <typename CT, typename A, typename B>
-	gcBaseString(const CT* tIn, const A &a, const B &b)
-	{
-		std::basic_string<T> t;
-		Template::ConvertStdString(tIn, t);
-		this->assign(Template::Format<T, A, B, Template::NullArg, Template::NullArg, Template::NullArg, Template::NullArg>(t.c_str(), a, b, Template::NullArg(), Template::NullArg(), Template::NullArg(), Template::NullArg()));
-	}
-
-	template <typename CT, typename A, typename B, typename C>
-	gcBaseString(const CT* tIn, const A &a, const B &b, const C &c)
+	template <typename CT, typename A, typename... Args>
+	gcBaseString(const CT* tIn, const A &a, const Args&... args)
 	{
-		std::basic_string<T> t;
-		Template::ConvertStdString(tIn, t);
-		this->assign(Template::Format<T, A, B, C, Template::NullArg, Template::NullArg, Template::NullArg>(t.c_str(), a, b, c, Template::NullArg(), Template::NullArg(), Template::NullArg()));
-	}
-
-	template <typename CT, typename A, typename B, typename C, typename D>
-	gcBaseString(const CT* tIn, const A &a, const B &b, const C &c, const D &d)
-	{
-		std::basic_string<T> t;
-		Template::ConvertStdString(tIn, t);
-		this->assign(Template::Format<T, A, B, C, D, Template::NullArg, Template::NullArg>(t.c_str(), a, b, c, d, Template::NullArg(), Template::NullArg()));
-	}
-
-	template <typename CT, typename A, typename B, typename C, typename D, typename E>
-	gcBaseString(const CT* tIn, const A &a, const B &b, const C &c, const D &d, const E &e)
-	{
-		std::basic_string<T> t;
-		Template::ConvertStdString(tIn, t);
-		this->assign(Template::Format<T, A, B, C, D, E, Template::NullArg>(t.c_str(), a, b, c, d, e, Template::NullArg()));
-	}
-
-	template <typename CT, typename A, typename B, typename C, typename D, typename E, typename F>
-	gcBaseString(const CT* tIn, const A &a, const B &b, const C &c, const D &d, const E &e, const F &f)
-	{
-		std::basic_string<T> t;
-		Template::ConvertStdString(tIn, t);
-		this->assign(Template::Format<T, A, B, C, D, E, F>(t.c_str(), a, b, c, d, e, f));
+		formatInto(tIn, a, args...);
 	}
 
 	template<std::size_t SIZE>
@@ -1319,12 +1738,42 @@ public:
 
 		return temp;
 	}
+
+private:
+	template <typename... Args>
+	void formatInto(const T* szFormat, const Args&... args)
+	{
+		Template::FormatInto<T>(*this, szFormat, args...);
+	}
+
+	template <typename CT, typename... Args>
+	void formatInto(const CT* szFormat, const Args&... args)
+	{
+		std::basic_string<T> t;
+		Template::ConvertStdString(szFormat, t);
+		Template::FormatInto<T>(*this, t.c_str(), args...);
+	}
 };
 
 
 typedef gcBaseString<char> gcString;
 typedef gcBaseString<wchar_t> gcWString;
 
+//! gcFormatCheck(format, args...) fails to compile if a literal format refers to an argument
+//! that isnt there. Non literal formats are left to the runtime check. MSVC 2013 has no
+//! constexpr so the check is skipped there.
+#if !defined(_MSC_VER) || _MSC_VER >= 1900
+	#define GC_FORMAT_EXPAND(x) x
+	#define GC_FORMAT_FIRST_(first, ...) first
+	#define GC_FORMAT_FIRST(...) GC_FORMAT_EXPAND(GC_FORMAT_FIRST_(__VA_ARGS__, ~))
+
+	#define gcFormatCheck(...) static_assert(!Template::FormatCheck::IsLiteral<decltype(GC_FORMAT_FIRST(__VA_ARGS__))>::value \
+		|| Template::FormatCheck::IsValid(GC_FORMAT_FIRST(__VA_ARGS__), decltype(Template::FormatCheck::CountArgs(__VA_ARGS__))::value), \
+		"Format string refers to an argument that was not passed")
+#else
+	#define gcFormatCheck(...)
+#endif
+
 template <int SIZE>
 class gcFixedString
 {
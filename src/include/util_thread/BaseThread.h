@@ -34,9 +34,10 @@ public:
 	WaitCondition();
 	~WaitCondition();
 
+	//! Blocks until notify is called. A notify that happens before the wait is not lost
 	void wait();
 
-	//! returns false if the call is returning because the time specified was reached, true otherwise
+	//! returns true if the call is returning because the time specified was reached, false otherwise
 	bool wait(int sec, int msec = 0);
 
 	void notify();
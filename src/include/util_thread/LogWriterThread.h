@@ -0,0 +1,101 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_LOGWRITERTHREAD_H
+#define DESURA_LOGWRITERTHREAD_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "BaseThread.h"
+#include "Color.h"
+
+#include <atomic>
+#include <functional>
+
+namespace Thread
+{
+
+	//! Moves log sinks off the logging thread. Producers push messages onto a lock free
+	//! queue and return straight away, the writer thread drains it in batches, hands each
+	//! message to the sink and appends it to a buffered log file.
+	//!
+	class LogWriterThread : public BaseThread
+	{
+	public:
+		typedef std::function<void(MSG_TYPE, const char*, Color*)> SinkFn;
+
+		//! Constuctor
+		//!
+		//! @param szLogFile File to append messages to. Can be null for no file output
+		//! @param sink Callback to handle each message on the writer thread
+		//!
+		LogWriterThread(const char* szLogFile, const SinkFn &sink);
+		~LogWriterThread();
+
+		//! Queues a message for the writer thread. Safe to call from any thread
+		//!
+		//! @param type Message type
+		//! @param szMessage Message
+		//! @param pColor Optional color
+		//!
+		void push(MSG_TYPE type, const char* szMessage, Color* pColor = nullptr);
+
+		//! Number of messages written since the thread started
+		//!
+		uint64 getWrittenCount() const;
+
+	protected:
+		class LogEntry;
+
+		void run() override;
+		void onStop() override;
+
+		//! Writes all queued messages
+		//!
+		//! @return True if any messages where written
+		//!
+		bool drain();
+
+		void write(LogEntry* pEntry);
+
+		//! Lock free multi producer, single consumer (intrusive Vyukov) queue
+		void enqueue(LogEntry* pEntry);
+		LogEntry* dequeue();
+
+	private:
+		const SinkFn m_Sink;
+		const gcString m_szLogFile;
+
+		FILE* m_pFile = nullptr;
+		std::vector<char> m_vFileBuffer;
+
+		std::atomic<LogEntry*> m_pHead;
+		LogEntry* m_pTail;
+		LogEntry* m_pStub;
+
+		std::atomic<bool> m_bWaiting;
+		std::atomic<uint64> m_nWritten;
+
+		WaitCondition m_WaitCond;
+	};
+}
+
+#endif //DESURA_LOGWRITERTHREAD_H
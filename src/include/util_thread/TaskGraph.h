@@ -0,0 +1,114 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_TASKGRAPH_H
+#define DESURA_TASKGRAPH_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+
+namespace Thread
+{
+
+	//! Runs a set of named steps on a thread pool, starting each one as soon as the steps it
+	//! depends on have finished. Steps can only depend on steps added before them so there are
+	//! no cycles.
+	//!
+	//! If a step throws the steps that depend on it are skipped, the rest carry on and run
+	//! rethrows the first exception once nothing is running. A step can cancel the graph to
+	//! skip everything else that has not started.
+	//!
+	class TaskGraph
+	{
+	public:
+		typedef uint32 TaskId;
+		typedef std::function<void()> TaskFn;
+
+		TaskGraph(const char* szName);
+		~TaskGraph();
+
+		//! Adds a step
+		//!
+		//! @param szName Name for the report and timeline
+		//! @param fnTask Work to do
+		//! @param vDepends Steps that must finish first
+		//! @return Id to depend on this step
+		//!
+		TaskId addTask(const char* szName, const TaskFn &fnTask, const std::vector<TaskId> &vDepends = std::vector<TaskId>());
+
+		//! Runs every step and waits for them to finish
+		//!
+		//! @param pPool Pool to force steps on to. Steps run in order on the calling thread if null
+		//!
+		void run(const gcRefPtr<ThreadPoolI> &pPool);
+
+		//! Skips every step that has not started yet. Steps that are running still finish and
+		//! run waits for them, they can check isCancelled to stop early
+		//!
+		void cancel();
+
+		//! Has the current run been cancelled
+		//!
+		bool isCancelled() const;
+
+		//! Start offset, duration and outcome of each step from the last run
+		//!
+		gcString getReport() const;
+
+		//! Time from the last run starting to its last step finishing
+		//!
+		std::chrono::milliseconds getDuration() const;
+
+	protected:
+		class Task;
+		class PoolTask;
+
+		void startTask(TaskId id, const gcRefPtr<ThreadPoolI> &pPool);
+		void runTask(TaskId id);
+		void onTaskComplete(TaskId id, std::exception_ptr pException);
+		void skipDependents(TaskId id);
+
+	private:
+		gcString m_szName;
+		std::vector<Task*> m_vTasks;
+
+		std::chrono::steady_clock::time_point m_Start;
+		std::chrono::steady_clock::time_point m_End;
+
+		std::vector<TaskId> m_vReady;
+		size_t m_nFinished = 0;
+		std::exception_ptr m_pException;
+		std::atomic<bool> m_bCancelled = {false};
+
+		mutable std::mutex m_Lock;
+		std::condition_variable m_FinishedCond;
+	};
+
+}
+
+#endif //DESURA_TASKGRAPH_H
@@ -26,6 +26,8 @@ Contact us at legal@badjuju.com.
 #endif
 
 #include "BaseThread.h"
+#include <chrono>
+#include <condition_variable>
 
 namespace Thread
 {
@@ -126,7 +128,7 @@ namespace Thread
 
 		std::vector<gcRefPtr<ThreadPoolThread>> m_vForcedList;
 		std::vector<gcRefPtr<ThreadPoolThread>> m_vThreadList;
-		std::deque<gcRefPtr<BaseTask>> m_vTaskList;
+		std::deque<std::pair<gcRefPtr<BaseTask>, std::chrono::steady_clock::time_point>> m_vTaskList;
 
 		std::mutex m_TaskMutex;
 		std::mutex m_ForcedMutex;
@@ -134,6 +136,9 @@ namespace Thread
 
 		WaitCondition m_WaitCondition;
 
+		std::mutex m_IdleMutex;
+		std::condition_variable m_IdleCond;
+
 		gc_IMPLEMENT_REFCOUNTING(ThreadPool)
 	};
 
@@ -34,6 +34,7 @@ Contact us at legal@badjuju.com.
 #define WEBCORE_VER				"WEBCORE_VERSION"
 #define WEBCORE_PASSREMINDER	"WEBCORE_PASSWORDREMINDER"
 #define WEBCORE_USERAGENT		"WEBCORE_USERAGENT"
+#define WEBCORE_BANDWIDTHLIMITER	"WEBCORE_BANDWIDTHLIMITER"
 
 typedef void (*PassReminderFN)(const char*);
 typedef gcString (*UserAgentFN)();
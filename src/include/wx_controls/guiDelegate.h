@@ -27,12 +27,11 @@ Contact us at legal@badjuju.com.
 
 #include <wx/wx.h>
 #include "Event.h"
-#include "util_thread/BaseThread.h"
+#include "guiInvoker.h"
 
 #include <type_traits>
 #include <memory>
 #include <atomic>
-#include <list>
 
 class gcPanel;
 class gcDialog;
@@ -51,86 +50,6 @@ enum MODE
 uint64 GetMainThreadId();
 
 
-class EventHelper
-{
-public:
-	void done()
-	{
-		if (m_bDone)
-			return;
-
-		m_bDone = true;
-		m_WaitCond.notify();
-	}
-
-	void wait()
-	{
-		while (!m_bDone)
-			m_WaitCond.wait(0, 500);
-	}
-
-	bool isDone() const
-	{
-		return m_bDone;
-	}
-
-private:
-	Thread::WaitCondition m_WaitCond;
-	std::atomic<bool> m_bDone;
-};
-
-class Invoker
-{
-public:
-	Invoker(std::function<void()> &fnCallback)
-		: m_fnCallback(fnCallback)
-	{
-	}
-
-	~Invoker()
-	{
-		cancel();
-	}
-
-	void invoke()
-	{
-		gcAssert(!m_bCallbackHit);
-
-		std::lock_guard<std::recursive_mutex> guard(m_Lock);
-		m_bCallbackHit = true;
-
-		if (m_fnCallback)
-			m_fnCallback();
-
-		m_pHelper.done();
-	}
-
-	void cancel()
-	{
-		if (m_bCallbackHit)
-			return;
-
-		std::lock_guard<std::recursive_mutex> guard(m_Lock);
-
-		if (!m_bCallbackHit)
-		{
-			m_fnCallback = std::function<void()>();
-			m_pHelper.done();
-		}
-	}
-
-	void wait()
-	{
-		m_pHelper.wait();
-	}
-
-private:
-	std::atomic<bool> m_bCallbackHit;
-	std::recursive_mutex m_Lock;
-	EventHelper m_pHelper;
-	std::function<void()> m_fnCallback;
-};
-
 class wxGuiDelegateEvent : public wxNotifyEvent
 {
 public:
@@ -288,11 +207,7 @@ public:
 		std::lock_guard<std::mutex> guard(m_InvokerMutex);
 
 		m_bCanceled = true;
-
-		if (m_pInvoker)
-			m_pInvoker->cancel();
-
-		cancelPendingInvokers();
+		m_PendingInvokers.cancelAll();
 
 		if (m_pObj && bDeregister)
 			m_pObj->deregisterDelegate(this);
@@ -327,7 +242,9 @@ public:
 			std::function<void()> pcb = std::bind(&GuiDelegate<TObj, Args...>::callback, this, args...);
 
 			auto invoker = std::make_shared<Invoker>(pcb);
-			addPendingInvoker(invoker);
+
+			if (!m_PendingInvokers.add(invoker))
+				return;
 
 			auto event = new wxGuiDelegateEvent(invoker, m_pObj->GetId());
 			m_pObj->GetEventHandler()->QueueEvent(event);
@@ -341,62 +258,24 @@ public:
 			std::function<void()> pcb = std::bind(&GuiDelegate<TObj, Args...>::callback, this, std::ref(args)...);
 
 			auto invoker = std::make_shared<Invoker>(pcb);
-			setInvoker(invoker);
+
+			//the same event can fire on several threads at once so each waiting call keeps its own invoker
+			if (!m_PendingInvokers.add(invoker))
+				return;
 
 			m_pObj->GetEventHandler()->QueueEvent(new wxGuiDelegateEvent(invoker, m_pObj->GetId()));
 			invoker->wait();
 
-			setInvoker(std::shared_ptr<Invoker>());
+			m_PendingInvokers.remove(invoker);
 		}
 	}
 
-protected:
-	void setInvoker(const std::shared_ptr<Invoker> &i)
-	{
-		std::lock_guard<std::mutex> guard(m_InvokerMutex);
-		gcAssert((!m_pInvoker && i) || (m_pInvoker && !i));
-		m_pInvoker = i;
-	}
-
-	void addPendingInvoker(const std::shared_ptr<Invoker> &i)
-	{
-		std::lock_guard<std::mutex> guard(m_InvokerMutex);
-		removePendingExpiredInvokers();
-		m_vPendingInvokers.push_back(i);
-	}
-
-	void cancelPendingInvokers()
-	{
-		removePendingExpiredInvokers();
-
-		for (auto i : m_vPendingInvokers)
-		{
-			auto invoker = i.lock();
-
-			if (!invoker)
-				continue;
-
-			invoker->cancel();
-		}
-
-		m_vPendingInvokers.clear();
-	}
-
-	void removePendingExpiredInvokers()
-	{
-		m_vPendingInvokers.remove_if([](std::weak_ptr<Invoker> &invoker){
-			return invoker.expired();
-		});
-	}
-
 private:
 	MODE m_Mode;
 	TObj *m_pObj = nullptr;
 	std::atomic<bool> m_bCanceled;
 	std::mutex m_InvokerMutex;
-	std::shared_ptr<Invoker> m_pInvoker;
-
-	std::list<std::weak_ptr<Invoker>> m_vPendingInvokers;
+	PendingInvokers m_PendingInvokers;
 
 #ifdef DEBUG
 	const char* m_szFile = nullptr;
@@ -0,0 +1,199 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_GUIINVOKER_H
+#define DESURA_GUIINVOKER_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "util_thread/BaseThread.h"
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <list>
+#include <functional>
+
+class EventHelper
+{
+public:
+	EventHelper()
+		: m_bDone(false)
+	{
+	}
+
+	void done()
+	{
+		if (m_bDone)
+			return;
+
+		m_bDone = true;
+		m_WaitCond.notify();
+	}
+
+	void wait()
+	{
+		while (!m_bDone)
+			m_WaitCond.wait(0, 500);
+	}
+
+	bool isDone() const
+	{
+		return m_bDone;
+	}
+
+private:
+	Thread::WaitCondition m_WaitCond;
+	std::atomic<bool> m_bDone;
+};
+
+class Invoker
+{
+public:
+	Invoker(std::function<void()> &fnCallback)
+		: m_bCallbackHit(false)
+		, m_fnCallback(fnCallback)
+	{
+	}
+
+	~Invoker()
+	{
+		cancel();
+	}
+
+	void invoke()
+	{
+		gcAssert(!m_bCallbackHit);
+
+		std::lock_guard<std::recursive_mutex> guard(m_Lock);
+		m_bCallbackHit = true;
+
+		if (m_fnCallback)
+			m_fnCallback();
+
+		m_pHelper.done();
+	}
+
+	void cancel()
+	{
+		if (m_bCallbackHit)
+			return;
+
+		std::lock_guard<std::recursive_mutex> guard(m_Lock);
+
+		if (!m_bCallbackHit)
+		{
+			m_fnCallback = std::function<void()>();
+			m_pHelper.done();
+		}
+	}
+
+	void wait()
+	{
+		m_pHelper.wait();
+	}
+
+private:
+	std::atomic<bool> m_bCallbackHit;
+	std::recursive_mutex m_Lock;
+	EventHelper m_pHelper;
+	std::function<void()> m_fnCallback;
+};
+
+//! Invokers a delegate has queued to the gui thread and not seen finish yet.
+//!
+//! Events fire on several threads at once so a delegate can have more than one
+//! invoker in flight. Once canceled any invoker added later is canceled straight
+//! away so the thread that fired it doesnt wait on a window that is gone.
+class PendingInvokers
+{
+public:
+	PendingInvokers()
+		: m_bCanceled(false)
+	{
+	}
+
+	//! Returns false if the owner was already canceled. The invoker is canceled in that case
+	bool add(const std::shared_ptr<Invoker> &i)
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+
+		if (m_bCanceled)
+		{
+			i->cancel();
+			return false;
+		}
+
+		removeExpired();
+		m_vInvokers.push_back(i);
+		return true;
+	}
+
+	void remove(const std::shared_ptr<Invoker> &i)
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+
+		m_vInvokers.remove_if([&i](std::weak_ptr<Invoker> &invoker){
+			return invoker.expired() || invoker.lock() == i;
+		});
+	}
+
+	void cancelAll()
+	{
+		std::list<std::weak_ptr<Invoker>> vInvokers;
+
+		{
+			std::lock_guard<std::mutex> guard(m_Lock);
+			m_bCanceled = true;
+			vInvokers.swap(m_vInvokers);
+		}
+
+		for (auto i : vInvokers)
+		{
+			auto invoker = i.lock();
+
+			if (invoker)
+				invoker->cancel();
+		}
+	}
+
+	size_t size()
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+		removeExpired();
+		return m_vInvokers.size();
+	}
+
+private:
+	void removeExpired()
+	{
+		m_vInvokers.remove_if([](std::weak_ptr<Invoker> &invoker){
+			return invoker.expired();
+		});
+	}
+
+	std::mutex m_Lock;
+	bool m_bCanceled;
+	std::list<std::weak_ptr<Invoker>> m_vInvokers;
+};
+
+#endif //DESURA_GUIINVOKER_H
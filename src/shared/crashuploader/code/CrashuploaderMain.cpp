@@ -106,11 +106,22 @@ private:
 Logger g_Logger;
 
 class Color;
+
+bool IsLogEnabled(MSG_TYPE type)
+{
+	return true;
+}
+
 void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
 {
 	g_Logger.write(msg.c_str());
 }
 
+void LogTrace(const TraceEvent &event)
+{
+	LogTraceAsMsg(event);
+}
+
 #include "DesuraPrintFRedirect.h"
 
 bool CompressFile(gcString &filePath);
@@ -24,82 +24,40 @@ Contact us at legal@badjuju.com.
 #include "Common.h"
 #include "Tracer.h"
 
-#ifdef WIN32
-
 void DumpTracerToFile(const std::string &szTracer, std::function<void(const char*, uint32)> &fh)
 {
 	if (!fh)
 		return;
 
-	uint32 nSize = sizeof(TracerHeader_s);
-
-	HANDLE hMappedFile = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READONLY | SEC_COMMIT, 0, nSize, szTracer.c_str());
+	TracerReader reader(szTracer);
 
-	if (!hMappedFile)
+	if (!reader.isValid())
 		return;
 
-	TracerHeader_s *pHeader = (TracerHeader_s*)MapViewOfFile(hMappedFile, FILE_MAP_READ, 0, 0, nSize);
-
-	if (!pHeader)
-	{
-		CloseHandle(hMappedFile);
-		return;
-	}
-
-	uint32 nDataSize = pHeader->segCount * pHeader->segSize;
-
-	UnmapViewOfFile(pHeader);
-	CloseHandle(hMappedFile);
-
-	hMappedFile = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READONLY | SEC_COMMIT, 0, nSize + nDataSize, szTracer.c_str());
-
-	if (!hMappedFile)
-		return;
-
-	pHeader = (TracerHeader_s*)MapViewOfFile(hMappedFile, FILE_MAP_READ, 0, 0, nSize + nDataSize);
-
-	if (!pHeader)
-	{
-		CloseHandle(hMappedFile);
-		return;
-	}
-
-
 	try
 	{
 		fh("[", 1);
 		auto bFirst = true;
 
-		for (uint32 x = 0; x < nDataSize; x += pHeader->segSize)
+		std::string strRecord;
+
+		reader.read(0, [&](const TracerRecord &record)
 		{
-			const char* szStr = &pHeader->data + x;
-			uint32 nLen = Safe::strlen(szStr, pHeader->segSize);
+			strRecord.clear();
+			record.formatJson(strRecord);
 
-			if (nLen > 0)
-			{
-				if (!bFirst)
-					fh(",\n\t", 3);
-				else
-					fh("\n\t", 2);
+			if (!bFirst)
+				fh(",\n\t", 3);
+			else
+				fh("\n\t", 2);
 
-				fh(szStr, nLen);
-				bFirst = false;
-			}
-		}
+			fh(strRecord.c_str(), strRecord.size());
+			bFirst = false;
+		});
 
 		fh("\n]", 2);
 	}
 	catch (...)
 	{
 	}
-
-	UnmapViewOfFile(pHeader);
-	CloseHandle(hMappedFile);
-}
-
-#else
-void DumpTracerToFile(const std::string &szTracer, std::function<void(const char*, uint32)> &fh)
-{
-
 }
-#endif
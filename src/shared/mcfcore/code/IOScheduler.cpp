@@ -0,0 +1,856 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#include "Common.h"
+#include "IOScheduler.h"
+
+#include <fstream>
+#include <sstream>
+
+#ifdef NIX
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h>
+
+//glibc has no wrappers for these
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_WHO_PROCESS 1
+#endif
+
+using namespace MCFCore::Misc;
+
+
+namespace
+{
+#ifdef NIX
+	std::string ReadFirstLine(const std::string &strFile)
+	{
+		std::ifstream file(strFile.c_str());
+		std::string strLine;
+
+		if (file)
+			std::getline(file, strLine);
+
+		return strLine;
+	}
+
+	std::string BaseName(const std::string &strPath)
+	{
+		auto pos = strPath.find_last_of('/');
+
+		if (pos == std::string::npos)
+			return strPath;
+
+		return strPath.substr(pos + 1);
+	}
+
+	std::string DirName(const std::string &strPath)
+	{
+		auto pos = strPath.find_last_of('/');
+
+		if (pos == std::string::npos || pos == 0)
+			return "/";
+
+		return strPath.substr(0, pos);
+	}
+
+	//! Finds the mount source (i.e. /dev/sda1) for a device number in /proc/self/mountinfo content
+	//! Line format: id parent major:minor root mountpoint options [optional...] - fstype source superopts
+	bool ParseMountInfoSource(const std::string &strMountInfo, uint32 uiMajor, uint32 uiMinor, std::string &strSource)
+	{
+		std::istringstream stream(strMountInfo);
+		std::string strLine;
+
+		gcString strDev("{0}:{1}", uiMajor, uiMinor);
+
+		while (std::getline(stream, strLine))
+		{
+			std::istringstream line(strLine);
+			std::string strId, strParent, strNum;
+
+			if (!(line >> strId >> strParent >> strNum) || strNum != strDev)
+				continue;
+
+			auto pos = strLine.find(" - ");
+
+			if (pos == std::string::npos)
+				continue;
+
+			std::istringstream tail(strLine.substr(pos + 3));
+			std::string strType;
+
+			if (tail >> strType >> strSource)
+				return true;
+		}
+
+		return false;
+	}
+
+	//! Resolves a sysfs block entry (/sys/dev/block/M:m or /sys/class/block/name) to its
+	//! whole disk so every partition of a disk shares one budget
+	bool ResolveSysBlock(const std::string &strSysPath, IODeviceInfo &info)
+	{
+		char szReal[PATH_MAX] = {0};
+
+		if (!realpath(strSysPath.c_str(), szReal))
+			return false;
+
+		std::string strPath(szReal);
+		struct stat s;
+
+		if (stat((strPath + "/partition").c_str(), &s) == 0)
+			strPath = DirName(strPath);
+
+		auto strDisk = BaseName(strPath);
+		auto strRot = ReadFirstLine("/sys/block/" + strDisk + "/queue/rotational");
+
+		if (strRot.empty())
+			strRot = ReadFirstLine(strPath + "/queue/rotational");
+
+		info.szId = strDisk;
+		info.bKnown = !strRot.empty();
+		info.bRotational = (strRot == "1");
+
+		return true;
+	}
+
+	class IODeviceResolver : public IODeviceResolverI
+	{
+	public:
+		IODeviceInfo resolve(const std::string &strPath) override
+		{
+			IODeviceInfo info;
+			std::string strExisting(strPath);
+
+			//install folders might not exist yet, use the closest parent that does
+			struct stat s;
+			while (stat(strExisting.c_str(), &s) != 0)
+			{
+				if (strExisting.empty() || strExisting == "/")
+					return info;
+
+				strExisting = DirName(strExisting);
+			}
+
+			uint32 uiMajor = major(s.st_dev);
+			uint32 uiMinor = minor(s.st_dev);
+
+			info.szId = gcString("dev:{0}:{1}", uiMajor, uiMinor);
+
+			if (ResolveSysBlock(gcString("/sys/dev/block/{0}:{1}", uiMajor, uiMinor), info))
+				return info;
+
+			//btrfs, overlay and friends use anonymous device numbers, go via the mount source instead
+			std::ifstream file("/proc/self/mountinfo");
+			std::stringstream content;
+			content << file.rdbuf();
+
+			std::string strSource;
+
+			if (!ParseMountInfoSource(content.str(), uiMajor, uiMinor, strSource) || strSource.find("/dev/") != 0)
+				return info;
+
+			char szReal[PATH_MAX] = {0};
+
+			if (realpath(strSource.c_str(), szReal))
+				strSource = szReal;
+
+			ResolveSysBlock("/sys/class/block/" + BaseName(strSource), info);
+			return info;
+		}
+	};
+#else
+	class IODeviceResolver : public IODeviceResolverI
+	{
+	public:
+		IODeviceInfo resolve(const std::string &strPath) override
+		{
+			IODeviceInfo info;
+
+			gcWString strWPath(strPath);
+			wchar_t szVolume[MAX_PATH] = {0};
+
+			if (GetVolumePathNameW(strWPath.c_str(), szVolume, MAX_PATH))
+				info.szId = gcString(szVolume);
+
+			return info;
+		}
+	};
+#endif
+
+	IOScheduler g_IOScheduler;
+}
+
+
+IOWorkerScope::IOWorkerScope()
+{
+	IOScheduler::getGlobal().registerWorker();
+}
+
+IOWorkerScope::~IOWorkerScope()
+{
+	IOScheduler::getGlobal().unregisterWorker();
+}
+
+
+IOTicket::IOTicket(IOScheduler* pScheduler)
+	: m_pScheduler(pScheduler)
+{
+}
+
+IOTicket::~IOTicket()
+{
+	m_pScheduler->release(*this);
+}
+
+void IOTicket::suspend()
+{
+	m_pScheduler->suspend(*this);
+}
+
+bool IOTicket::resume(const std::atomic<bool> &bStopped)
+{
+	return m_pScheduler->resume(*this, bStopped);
+}
+
+
+IOScheduler::IOScheduler(std::shared_ptr<IODeviceResolverI> pResolver)
+	: m_pResolver(pResolver)
+	, m_uiSsdMaxWorkers(std::max<uint16>(4, UTIL::MISC::getCoreCount()))
+{
+	if (!m_pResolver)
+		m_pResolver = std::make_shared<IODeviceResolver>();
+}
+
+IOScheduler& IOScheduler::getGlobal()
+{
+	return g_IOScheduler;
+}
+
+IODeviceInfo IOScheduler::getDevice(const std::string &strPath)
+{
+	return m_pResolver->resolve(strPath);
+}
+
+void IOScheduler::setLimits(bool bRotational, uint16 uiMaxTasks, uint16 uiMaxWorkers)
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	if (bRotational)
+	{
+		m_uiRotMaxTasks = std::max<uint16>(1, uiMaxTasks);
+		m_uiRotMaxWorkers = std::max<uint16>(1, uiMaxWorkers);
+	}
+	else
+	{
+		m_uiSsdMaxTasks = std::max<uint16>(1, uiMaxTasks);
+		m_uiSsdMaxWorkers = std::max<uint16>(1, uiMaxWorkers);
+	}
+
+	m_WaitCond.notify_all();
+}
+
+bool IOScheduler::canAdmit(const DeviceState &state) const
+{
+	uint16 uiMaxTasks = state.bRotational ? m_uiRotMaxTasks : m_uiSsdMaxTasks;
+	uint16 uiMaxWorkers = state.bRotational ? m_uiRotMaxWorkers : m_uiSsdMaxWorkers;
+
+	if (state.uiActive == 0)
+		return true;
+
+	return state.uiActive < uiMaxTasks && state.uiWorkers < uiMaxWorkers;
+}
+
+uint16 IOScheduler::getGrant(const DeviceState &state, uint16 uiRequested) const
+{
+	uint16 uiMaxWorkers = state.bRotational ? m_uiRotMaxWorkers : m_uiSsdMaxWorkers;
+	uint16 uiFree = state.uiWorkers < uiMaxWorkers ? uiMaxWorkers - state.uiWorkers : 1;
+
+	return std::max<uint16>(1, std::min(uiRequested, uiFree));
+}
+
+bool IOScheduler::waitForTurn(std::unique_lock<std::mutex> &lock, DeviceState &state, const std::function<bool()> &fnGiveUp)
+{
+	uint64 uiTicket = m_uiNextTicket++;
+	state.dQueue.push_back(uiTicket);
+
+	while (state.dQueue.front() != uiTicket || !canAdmit(state))
+	{
+		if (fnGiveUp())
+		{
+			state.dQueue.erase(std::find(state.dQueue.begin(), state.dQueue.end(), uiTicket));
+			m_WaitCond.notify_all();
+			return false;
+		}
+
+		m_WaitCond.wait_for(lock, std::chrono::milliseconds(100));
+	}
+
+	state.dQueue.pop_front();
+	return true;
+}
+
+std::unique_ptr<IOTicket> IOScheduler::acquire(const std::vector<std::string> &vPaths, uint16 uiRequested, const std::atomic<bool> &bStopped)
+{
+	std::map<std::string, IODeviceInfo> mDevices;
+
+	for (auto &p : vPaths)
+	{
+		if (p.empty())
+			continue;
+
+		auto info = m_pResolver->resolve(p);
+
+		if (!info.szId.empty())
+			mDevices[info.szId] = info;
+	}
+
+	std::unique_ptr<IOTicket> ticket(new IOTicket(this));
+	ticket->m_uiWorkers = std::max<uint16>(1, uiRequested);
+
+	//devices are taken in sorted (map) order so two tasks spanning the same devices cant deadlock
+	for (auto &d : mDevices)
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+
+		auto &state = m_mDevices[d.first];
+		state.bRotational = d.second.bRotational;
+
+		if (!waitForTurn(lock, state, [&bStopped](){ return !!bStopped; }))
+		{
+			lock.unlock();
+
+			//ticket destructor gives back the devices already taken
+			return nullptr;
+		}
+
+		uint16 uiGrant = getGrant(state, ticket->m_uiWorkers);
+
+		state.uiActive++;
+		state.uiWorkers += uiGrant;
+
+		IOTicket::Device device;
+		device.szId = d.first;
+		device.uiGrant = uiGrant;
+
+		ticket->m_vDevices.push_back(device);
+		ticket->m_uiWorkers = std::min(ticket->m_uiWorkers, uiGrant);
+
+		//next in line might fit as well
+		m_WaitCond.notify_all();
+	}
+
+	//the task runs with the smallest grant so give back what the other devices were charged over that
+	std::lock_guard<std::mutex> guard(m_Lock);
+	bool bReturned = false;
+
+	for (auto &d : ticket->m_vDevices)
+	{
+		if (d.uiGrant <= ticket->m_uiWorkers)
+			continue;
+
+		auto &state = m_mDevices[d.szId];
+		state.uiWorkers -= std::min<uint16>(state.uiWorkers, d.uiGrant - ticket->m_uiWorkers);
+
+		d.uiGrant = ticket->m_uiWorkers;
+		bReturned = true;
+	}
+
+	if (bReturned)
+		m_WaitCond.notify_all();
+
+	return ticket;
+}
+
+void IOScheduler::release(IOTicket &ticket)
+{
+	if (ticket.m_vDevices.empty())
+		return;
+
+	std::lock_guard<std::mutex> guard(m_Lock);
+	releaseHeld(ticket);
+}
+
+void IOScheduler::releaseHeld(IOTicket &ticket)
+{
+	for (auto &d : ticket.m_vDevices)
+	{
+		if (!d.bHeld)
+			continue;
+
+		d.bHeld = false;
+		auto it = m_mDevices.find(d.szId);
+
+		if (it == m_mDevices.end())
+			continue;
+
+		gcAssert(it->second.uiActive > 0);
+
+		it->second.uiActive--;
+		it->second.uiWorkers -= std::min(it->second.uiWorkers, d.uiGrant);
+	}
+
+	m_WaitCond.notify_all();
+}
+
+void IOScheduler::suspend(IOTicket &ticket)
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	if (ticket.m_bSuspended && !ticket.m_bResuming)
+		return;
+
+	//also cancels a resume still waiting in the queue
+	ticket.m_bSuspended = true;
+	ticket.m_bResuming = false;
+	releaseHeld(ticket);
+}
+
+bool IOScheduler::resume(IOTicket &ticket, const std::atomic<bool> &bStopped)
+{
+	std::unique_lock<std::mutex> lock(m_Lock);
+
+	if (!ticket.m_bSuspended)
+		return true;
+
+	gcAssert(!ticket.m_bResuming);
+	ticket.m_bResuming = true;
+
+	//devices are still in the sorted order acquire took them in
+	for (auto &d : ticket.m_vDevices)
+	{
+		if (d.bHeld)
+			continue;
+
+		auto &state = m_mDevices[d.szId];
+
+		if (!waitForTurn(lock, state, [&](){ return bStopped || !ticket.m_bResuming; }))
+		{
+			//a suspend while we waited already gave back what we retook
+			if (ticket.m_bResuming)
+			{
+				ticket.m_bResuming = false;
+				releaseHeld(ticket);
+			}
+
+			return false;
+		}
+
+		//the workers are already running so charge the full grant again
+		state.uiActive++;
+		state.uiWorkers += d.uiGrant;
+		d.bHeld = true;
+
+		m_WaitCond.notify_all();
+	}
+
+	ticket.m_bResuming = false;
+	ticket.m_bSuspended = false;
+	return true;
+}
+
+
+void IOScheduler::setBackgroundMode(bool bEnabled, uint32 uiRateLimit)
+{
+	m_BackgroundRate.setRate((uint64)uiRateLimit * 1024);
+
+	if (m_bBackground == bEnabled)
+		return;
+
+	Debug("MCF background mode {0} (cap {1} KB/s)\n", bEnabled ? "on" : "off", uiRateLimit);
+	m_bBackground = bEnabled;
+}
+
+bool IOScheduler::isBackgroundMode()
+{
+	return m_bBackground;
+}
+
+void IOScheduler::registerWorker()
+{
+	std::lock_guard<std::mutex> guard(m_WorkerLock);
+	m_mWorkers[std::this_thread::get_id()] = WorkerState();
+}
+
+void IOScheduler::unregisterWorker()
+{
+	std::lock_guard<std::mutex> guard(m_WorkerLock);
+
+	auto it = m_mWorkers.find(std::this_thread::get_id());
+
+	if (it == m_mWorkers.end())
+		return;
+
+	if (it->second.bBackground)
+		applyBackground(it->second, false);
+
+	m_mWorkers.erase(it);
+}
+
+void IOScheduler::throttle(uint32 uiBytes)
+{
+	bool bBackground = m_bBackground;
+
+	if (!bBackground && m_uiBackgroundWorkers == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(m_WorkerLock);
+
+		auto it = m_mWorkers.find(std::this_thread::get_id());
+
+		if (it != m_mWorkers.end() && it->second.bBackground != bBackground)
+			applyBackground(it->second, bBackground);
+	}
+
+	if (bBackground)
+		m_BackgroundRate.consume(uiBytes);
+}
+
+//priorities can only be changed from the thread itself on windows so workers call this on their own thread
+void IOScheduler::applyBackground(WorkerState &state, bool bBackground)
+{
+	if (state.bBackground == bBackground)
+		return;
+
+	state.bBackground = bBackground;
+
+	if (bBackground)
+		m_uiBackgroundWorkers++;
+	else
+		m_uiBackgroundWorkers--;
+
+#ifdef NIX
+	//io priority and nice are per thread on linux
+	pid_t tid = (pid_t)syscall(SYS_gettid);
+
+	if (bBackground)
+	{
+		state.nOldIoPrio = (int)syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, tid);
+		syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+
+		errno = 0;
+		int nNice = getpriority(PRIO_PROCESS, tid);
+		state.nOldNice = (errno == 0) ? nNice : 0;
+
+		setpriority(PRIO_PROCESS, tid, std::min(19, state.nOldNice + 10));
+	}
+	else
+	{
+		syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, std::max(0, state.nOldIoPrio));
+
+		//lowering nice again needs CAP_SYS_NICE or RLIMIT_NICE headroom. Without it the worker
+		//stays niced until its task ends, new workers start at normal priority either way
+		if (setpriority(PRIO_PROCESS, tid, state.nOldNice) != 0)
+			Debug("Failed to restore nice level of mcf worker {0}: {1}\n", tid, errno);
+	}
+#else
+	SetThreadPriority(GetCurrentThread(), bBackground ? THREAD_MODE_BACKGROUND_BEGIN : THREAD_MODE_BACKGROUND_END);
+#endif
+}
+
+
+
+#ifdef WITH_GTEST
+
+#include <thread>
+
+namespace UnitTest
+{
+	class TestIODeviceResolver : public IODeviceResolverI
+	{
+	public:
+		IODeviceInfo resolve(const std::string &strPath) override
+		{
+			IODeviceInfo info;
+			info.szId = strPath.substr(0, strPath.find('/'));
+			info.bRotational = (info.szId.find("hdd") == 0);
+			info.bKnown = true;
+			return info;
+		}
+	};
+
+	class IOSchedulerFixture : public ::testing::Test
+	{
+	public:
+		IOSchedulerFixture()
+			: scheduler(std::make_shared<TestIODeviceResolver>())
+		{
+			scheduler.setLimits(true, 1, 2);
+			scheduler.setLimits(false, 3, 6);
+		}
+
+		std::atomic<bool> bStopped = {false};
+		IOScheduler scheduler;
+	};
+
+	TEST_F(IOSchedulerFixture, RotationalCapsWorkers)
+	{
+		auto ticket = scheduler.acquire({"hdd1/a", "hdd1/b"}, 8, bStopped);
+
+		ASSERT_TRUE(!!ticket);
+		ASSERT_EQ(2, ticket->getWorkerCount());
+	}
+
+	TEST_F(IOSchedulerFixture, RotationalQueuesSecondTask)
+	{
+		auto first = scheduler.acquire({"hdd1/a"}, 2, bStopped);
+
+		std::atomic<bool> bGotSecond = {false};
+		std::thread second([&](){
+			auto ticket = scheduler.acquire({"hdd1/b"}, 2, bStopped);
+			bGotSecond = !!ticket;
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		ASSERT_FALSE(bGotSecond);
+
+		//other devices are not held up by the busy disk
+		auto other = scheduler.acquire({"hdd2/a"}, 2, bStopped);
+		ASSERT_TRUE(!!other);
+
+		first.reset();
+		second.join();
+
+		ASSERT_TRUE(bGotSecond);
+	}
+
+	TEST_F(IOSchedulerFixture, SolidStateSharesBudget)
+	{
+		auto first = scheduler.acquire({"ssd/a"}, 4, bStopped);
+		auto second = scheduler.acquire({"ssd/b"}, 4, bStopped);
+
+		ASSERT_EQ(4, first->getWorkerCount());
+		ASSERT_EQ(2, second->getWorkerCount());
+
+		std::atomic<bool> bGotThird = {false};
+		std::thread third([&](){
+			auto ticket = scheduler.acquire({"ssd/c"}, 4, bStopped);
+			bGotThird = !!ticket;
+
+			if (ticket)
+				EXPECT_EQ(4, ticket->getWorkerCount());
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		ASSERT_FALSE(bGotThird);
+
+		first.reset();
+		third.join();
+
+		ASSERT_TRUE(bGotThird);
+	}
+
+	TEST_F(IOSchedulerFixture, StopWhileQueued)
+	{
+		auto first = scheduler.acquire({"hdd1/a"}, 1, bStopped);
+
+		std::atomic<bool> bStopSecond = {false};
+		std::atomic<bool> bReturned = {false};
+
+		std::thread second([&](){
+			auto ticket = scheduler.acquire({"hdd1/b"}, 1, bStopSecond);
+			EXPECT_FALSE(!!ticket);
+			bReturned = true;
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(150));
+		bStopSecond = true;
+		second.join();
+
+		ASSERT_TRUE(bReturned);
+
+		//stopped waiter must not block the queue
+		first.reset();
+		auto third = scheduler.acquire({"hdd1/c"}, 1, bStopped);
+		ASSERT_TRUE(!!third);
+	}
+
+	TEST_F(IOSchedulerFixture, SuspendLetsQueuedTaskRun)
+	{
+		auto first = scheduler.acquire({"hdd1/a"}, 1, bStopped);
+		first->suspend();
+
+		//paused task no longer holds the disk
+		auto second = scheduler.acquire({"hdd1/b"}, 1, bStopped);
+		ASSERT_TRUE(!!second);
+
+		std::atomic<bool> bResumed = {false};
+
+		std::thread resumer([&](){
+			bResumed = first->resume(bStopped);
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(150));
+		ASSERT_FALSE(bResumed);
+		ASSERT_TRUE(first->isSuspended());
+
+		second.reset();
+		resumer.join();
+
+		ASSERT_TRUE(bResumed);
+		ASSERT_FALSE(first->isSuspended());
+	}
+
+	TEST_F(IOSchedulerFixture, SuspendWhileResuming)
+	{
+		auto first = scheduler.acquire({"hdd1/a"}, 1, bStopped);
+		first->suspend();
+
+		auto second = scheduler.acquire({"hdd1/b"}, 1, bStopped);
+
+		std::atomic<bool> bReturned = {false};
+		std::atomic<bool> bResumed = {true};
+
+		std::thread resumer([&](){
+			bResumed = first->resume(bStopped);
+			bReturned = true;
+		});
+
+		//paused again before it got the disk back
+		std::this_thread::sleep_for(std::chrono::milliseconds(150));
+		first->suspend();
+		resumer.join();
+
+		ASSERT_TRUE(bReturned);
+		ASSERT_FALSE(bResumed);
+		ASSERT_TRUE(first->isSuspended());
+
+		//the abandoned resume must not hold the disk or block the queue
+		second.reset();
+		auto third = scheduler.acquire({"hdd1/c"}, 1, bStopped);
+		ASSERT_TRUE(!!third);
+	}
+
+	TEST_F(IOSchedulerFixture, MultiDeviceTicket)
+	{
+		{
+			auto ticket = scheduler.acquire({"ssd/a", "hdd1/b"}, 8, bStopped);
+
+			ASSERT_TRUE(!!ticket);
+			ASSERT_EQ(2, ticket->getWorkerCount());
+		}
+
+		//both devices were released
+		auto hdd = scheduler.acquire({"hdd1/c"}, 1, bStopped);
+		auto ssd = scheduler.acquire({"ssd/c"}, 6, bStopped);
+
+		ASSERT_EQ(6, ssd->getWorkerCount());
+	}
+
+	TEST_F(IOSchedulerFixture, MultiDeviceTicketOnlyChargesUsedWorkers)
+	{
+		//fast sorts first and grants 6 before the disk cuts the ticket down to 2
+		auto ticket = scheduler.acquire({"fast/a", "hdd1/b"}, 8, bStopped);
+		ASSERT_EQ(2, ticket->getWorkerCount());
+
+		auto other = scheduler.acquire({"fast/c"}, 6, bStopped);
+		ASSERT_EQ(4, other->getWorkerCount());
+	}
+
+	TEST(IOScheduler, BackgroundModeCapsRate)
+	{
+		auto &scheduler = IOScheduler::getGlobal();
+		scheduler.setBackgroundMode(true, 4 * 1024);
+
+		std::thread worker([&scheduler](){
+			IOWorkerScope scope;
+
+			auto start = std::chrono::steady_clock::now();
+
+			//12MB at 4MB/s with one second of burst
+			for (uint32 x = 0; x < 48; ++x)
+				scheduler.throttle(256 * 1024);
+
+			auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+			EXPECT_GE(ms, 1800);
+			EXPECT_LT(ms, 3000);
+		});
+
+		worker.join();
+		scheduler.setBackgroundMode(false, 0);
+	}
+
+#ifdef NIX
+	TEST(IOScheduler, BackgroundModeLowersPriority)
+	{
+		auto &scheduler = IOScheduler::getGlobal();
+
+		std::thread worker([&scheduler](){
+			IOWorkerScope scope;
+			pid_t tid = (pid_t)syscall(SYS_gettid);
+
+			int nNice = getpriority(PRIO_PROCESS, tid);
+
+			scheduler.setBackgroundMode(true, 0);
+			scheduler.throttle(1);
+
+			EXPECT_EQ(IOPRIO_CLASS_IDLE, (int)syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, tid) >> IOPRIO_CLASS_SHIFT);
+			EXPECT_EQ(std::min(19, nNice + 10), getpriority(PRIO_PROCESS, tid));
+
+			scheduler.setBackgroundMode(false, 0);
+			scheduler.throttle(1);
+
+			EXPECT_NE(IOPRIO_CLASS_IDLE, (int)syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, tid) >> IOPRIO_CLASS_SHIFT);
+		});
+
+		worker.join();
+	}
+
+	TEST(IOScheduler, ParseMountInfo)
+	{
+		const char* szMountInfo =
+			"23 28 0:22 / /proc rw,relatime - proc proc rw\n"
+			"28 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+			"41 28 0:45 / /home rw,relatime shared:27 - btrfs /dev/nvme0n1p2 rw,ssd\n";
+
+		std::string strSource;
+
+		ASSERT_TRUE(ParseMountInfoSource(szMountInfo, 0, 45, strSource));
+		ASSERT_EQ("/dev/nvme0n1p2", strSource);
+
+		ASSERT_TRUE(ParseMountInfoSource(szMountInfo, 8, 1, strSource));
+		ASSERT_EQ("/dev/sda1", strSource);
+
+		ASSERT_FALSE(ParseMountInfoSource(szMountInfo, 8, 2, strSource));
+	}
+
+	TEST(IOScheduler, ResolveRoot)
+	{
+		IODeviceResolver resolver;
+
+		auto root = resolver.resolve("/");
+		auto missing = resolver.resolve("/this/path/does/not/exist");
+
+		ASSERT_FALSE(root.szId.empty());
+		ASSERT_EQ(root.szId, missing.szId);
+	}
+#endif
+}
+
+#endif
@@ -0,0 +1,220 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+
+#ifndef DESURA_IOSCHEDULER_H
+#define DESURA_IOSCHEDULER_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include <deque>
+#include <functional>
+#include <condition_variable>
+
+#include "mcfcore/MCFIOSchedulerI.h"
+#include "util/UtilTokenBucket.h"
+
+namespace MCFCore
+{
+	namespace Misc
+	{
+		class IOScheduler;
+
+		//! Block device a path is stored on
+		class IODeviceInfo
+		{
+		public:
+			std::string szId;
+			bool bRotational = false;
+			bool bKnown = false;
+		};
+
+		//! Maps a path to the block device it lives on
+		class IODeviceResolverI
+		{
+		public:
+			virtual IODeviceInfo resolve(const std::string &strPath)=0;
+
+		protected:
+			virtual ~IODeviceResolverI(){}
+		};
+
+		//! Holds a heavy task slot on one or more devices until it is destroyed
+		class IOTicket
+		{
+		public:
+			~IOTicket();
+
+			//! Number of workers the task may run with
+			//!
+			uint16 getWorkerCount() const
+			{
+				return m_uiWorkers;
+			}
+
+			//! Gives the device slots back while the task is paused so queued tasks can run
+			//!
+			void suspend();
+
+			//! Queues for the device slots again after suspend with the same worker count
+			//!
+			//! @param bStopped Gives up waiting when this gets set
+			//! @return False if stopped or suspended again while queued
+			//!
+			bool resume(const std::atomic<bool> &bStopped);
+
+			//! True from suspend until resume has taken back every device
+			//!
+			bool isSuspended() const
+			{
+				return m_bSuspended;
+			}
+
+		protected:
+			friend class IOScheduler;
+			IOTicket(IOScheduler* pScheduler);
+
+			class Device
+			{
+			public:
+				std::string szId;
+				uint16 uiGrant = 0;
+				bool bHeld = true;
+			};
+
+		private:
+			IOScheduler* m_pScheduler;
+			uint16 m_uiWorkers = 0;
+			std::atomic<bool> m_bSuspended = {false};
+			bool m_bResuming = false;
+			std::vector<Device> m_vDevices;
+		};
+
+		//! Registers the calling thread as an mcf worker for its lifetime so background
+		//! mode can lower its priority. Workers create one at the top of run()
+		class IOWorkerScope
+		{
+		public:
+			IOWorkerScope();
+			~IOWorkerScope();
+		};
+
+		//! Process wide scheduler for disk heavy mcf tasks (install, create, verify).
+		//! Tasks are queued in order per block device so spinning disks only serve one
+		//! task at a time while solid state devices share a worker budget between tasks.
+		//! Tasks in other processes (i.e. the service) are not seen by this scheduler.
+		class IOScheduler : public MCFCore::IOSchedulerI
+		{
+		public:
+			IOScheduler(std::shared_ptr<IODeviceResolverI> pResolver = std::shared_ptr<IODeviceResolverI>());
+
+			//! Scheduler shared by every mcf in this process
+			//!
+			static IOScheduler& getGlobal();
+
+			//! Waits until every device the paths are stored on can take another heavy task
+			//!
+			//! @param vPaths Paths the task reads from or writes to
+			//! @param uiRequested Number of workers the task would like
+			//! @param bStopped Gives up waiting when this gets set
+			//! @return Ticket with the granted worker count or nullptr if stopped while queued
+			//!
+			std::unique_ptr<IOTicket> acquire(const std::vector<std::string> &vPaths, uint16 uiRequested, const std::atomic<bool> &bStopped);
+
+			//! Sets how many heavy tasks and workers in total a type of device runs at once
+			//!
+			void setLimits(bool bRotational, uint16 uiMaxTasks, uint16 uiMaxWorkers);
+
+			//! Resolves the device for a path
+			//!
+			IODeviceInfo getDevice(const std::string &strPath);
+
+			void setBackgroundMode(bool bEnabled, uint32 uiRateLimit) override;
+			bool isBackgroundMode() override;
+
+			//! Called by workers after each block of disk io. Moves the calling thread in or out
+			//! of background priority and sleeps while background mode is over its rate cap
+			//!
+			//! @param uiBytes Bytes just read or written
+			//!
+			void throttle(uint32 uiBytes);
+
+		protected:
+			friend class IOTicket;
+			friend class IOWorkerScope;
+
+			void release(IOTicket &ticket);
+			void suspend(IOTicket &ticket);
+			bool resume(IOTicket &ticket, const std::atomic<bool> &bStopped);
+
+			void releaseHeld(IOTicket &ticket);
+
+			void registerWorker();
+			void unregisterWorker();
+
+			class WorkerState
+			{
+			public:
+				bool bBackground = false;
+				int nOldNice = 0;
+				int nOldIoPrio = 0;
+			};
+
+			void applyBackground(WorkerState &state, bool bBackground);
+
+			class DeviceState
+			{
+			public:
+				bool bRotational = false;
+				uint16 uiActive = 0;
+				uint16 uiWorkers = 0;
+				std::deque<uint64> dQueue;
+			};
+
+			bool canAdmit(const DeviceState &state) const;
+			bool waitForTurn(std::unique_lock<std::mutex> &lock, DeviceState &state, const std::function<bool()> &fnGiveUp);
+			uint16 getGrant(const DeviceState &state, uint16 uiRequested) const;
+
+		private:
+			std::shared_ptr<IODeviceResolverI> m_pResolver;
+
+			std::mutex m_Lock;
+			std::condition_variable m_WaitCond;
+			std::map<std::string, DeviceState> m_mDevices;
+			uint64 m_uiNextTicket = 0;
+
+			uint16 m_uiRotMaxTasks = 1;
+			uint16 m_uiRotMaxWorkers = 2;
+			uint16 m_uiSsdMaxTasks = 4;
+			uint16 m_uiSsdMaxWorkers = 8;
+
+			std::mutex m_WorkerLock;
+			std::map<std::thread::id, WorkerState> m_mWorkers;
+
+			std::atomic<bool> m_bBackground = {false};
+			std::atomic<uint32> m_uiBackgroundWorkers = {0};
+			UTIL::MISC::TokenBucket m_BackgroundRate;
+		};
+	}
+}
+
+#endif //DESURA_IOSCHEDULER_H
@@ -28,6 +28,9 @@ Contact us at legal@badjuju.com.
 #include "mcfcore/MCFMain.h"
 
 #include "MCFDPReporter.h"
+#include "IOScheduler.h"
+#include "util/UtilMetrics.h"
+#include "util/UtilTimeline.h"
 
 gcString g_szMCFVersion("{0}.{1}.{2}.{3}", VERSION_MAJOR, VERSION_MINOR, VERSION_BUILDNO, VERSION_EXTEND);
 
@@ -46,6 +49,14 @@ namespace MCFCore
 		{
 			return static_cast<void*>(new MCFCore::MCFHeader());
 		}
+		if (strcmp(name, MCF_IOSCHEDULER) == 0)
+		{
+			return static_cast<void*>(static_cast<MCFCore::IOSchedulerI*>(&MCFCore::Misc::IOScheduler::getGlobal()));
+		}
+		if (strcmp(name, MCF_BANDWIDTHLIMITER) == 0)
+		{
+			return (void*)&UTIL::WEB::SetBandwidthLimiter;
+		}
 		if (strcmp(name, MCF_DPREPORTER) == 0)
 		{
 			if (!g_pDPReporter)
@@ -92,6 +103,16 @@ CEXPORT const char* GetMCFCoreVersion()
 	return g_szMCFVersion.c_str();
 }
 
+CEXPORT UTIL::METRICS::Registry* GetMCFCoreMetrics()
+{
+	return &UTIL::METRICS::GetRegistry();
+}
+
+CEXPORT UTIL::TIMELINE::Timeline* GetMCFCoreTimeline()
+{
+	return &UTIL::TIMELINE::GetTimeline();
+}
+
 }
 
 
@@ -28,9 +28,12 @@ Contact us at legal@badjuju.com.
 #include "BZip2.h"
 #include <branding/mcfcore_version.h>
 #include "mcfcore/ProgressInfo.h"
+#include "mcfcore/ProgressAggregator.h"
 
 #include "XMLSaveAndCompress.h"
+#include "IOScheduler.h"
 #include "thread/MCFServerCon.h"
+#include "util/UtilTimeline.h"
 
 using namespace MCFCore;
 
@@ -323,16 +326,24 @@ void MCF::printAll()
 bool MCF::verifyMCF()
 {
 	gcTrace("");
+	UTIL::TIMELINE::ScopedSpan span("mcf", "verifyMCF");
 
 	if (m_sHeader)
 		m_sHeader->addFlags(MCFCore::MCFHeaderI::FLAG_NONVERIFYED);
 
+	auto ioTicket = MCFCore::Misc::IOScheduler::getGlobal().acquire({ m_szFile }, 1, m_bStopped);
+
+	if (!ioTicket)
+		return false;
+
 	bool complete = true;
 
 	UTIL::FS::FileHandle hFile;
 	getReadHandle(hFile);
 
 	size_t size = m_pFileList.size();
+	MCFCore::Misc::ProgressAggregator progress(size);
+
 	for (size_t x=0; x<size; x++)
 	{
 		if (m_bStopped)
@@ -341,9 +352,8 @@ bool MCF::verifyMCF()
 			break;
 		}
 
-		MCFCore::Misc::ProgressInfo temp;
-		temp.percent = (uint8)(x*100/size);
-		onProgressEvent(temp);
+		progress.setDone(x);
+		progress.publish(onProgressEvent);
 
 		if (!m_pFileList[x] || !m_pFileList[x]->isSaved())
 			continue;
@@ -360,6 +370,11 @@ bool MCF::verifyMCF()
 			complete = false;
 	}
 
+	if (m_bStopped)
+		progress.flush(onProgressEvent);
+	else
+		progress.finish(onProgressEvent);
+
 	if (complete)
 	{
 		if (m_sHeader)
@@ -374,13 +389,21 @@ bool MCF::verifyMCF()
 bool MCF::verifyInstall(const char* path, bool flagMissing, bool useDiffs)
 {
 	gcTrace("Path: {0}", path);
+	UTIL::TIMELINE::ScopedSpan span("mcf", "verifyInstall", "{0}", path);
 
 	if (!path)
 		throw gcException(ERR_BADPATH);
 
+	auto ioTicket = MCFCore::Misc::IOScheduler::getGlobal().acquire({ path }, 1, m_bStopped);
+
+	if (!ioTicket)
+		return false;
+
 	bool complete = true;
 
 	size_t size = m_pFileList.size();
+	MCFCore::Misc::ProgressAggregator progress(size);
+
 	for (size_t x=0; x<size; x++)
 	{
 		if (m_bStopped)
@@ -389,9 +412,8 @@ bool MCF::verifyInstall(const char* path, bool flagMissing, bool useDiffs)
 			break;
 		}
 
-		MCFCore::Misc::ProgressInfo temp;
-		temp.percent = (uint8)(x*100/size);
-		onProgressEvent(temp);
+		progress.setDone(x);
+		progress.publish(onProgressEvent);
 
 		if (!m_pFileList[x])
 			continue;
@@ -431,6 +453,11 @@ bool MCF::verifyInstall(const char* path, bool flagMissing, bool useDiffs)
 		}
 	}
 
+	if (m_bStopped)
+		progress.flush(onProgressEvent);
+	else
+		progress.finish(onProgressEvent);
+
 	return complete;
 }
 
@@ -443,13 +470,12 @@ void MCF::removeFiles(const char* szPath, bool removeNonSave)
 		throw gcException(ERR_BADPATH);
 
 	size_t size = m_pFileList.size();
+	MCFCore::Misc::ProgressAggregator progress(size);
 
 	for (size_t x=0; x<size; x++)
 	{
-		MCFCore::Misc::ProgressInfo temp;
-		temp.percent = (uint8)(x*100/size);
-
-		onProgressEvent(temp);
+		progress.setDone(x);
+		progress.publish(onProgressEvent);
 
 		if (!m_pFileList[x])
 			continue;
@@ -462,6 +488,8 @@ void MCF::removeFiles(const char* szPath, bool removeNonSave)
 		m_pFileList[x]->setDir(nullptr);
 	}
 
+	progress.finish(onProgressEvent);
+
 	UTIL::FS::Path path(szPath, "", false);
 	UTIL::FS::delEmptyFolders(path);
 
@@ -634,6 +662,7 @@ void MCF::makeCRC()
 int32 MCF::verifyAll(const char* tempPath)
 {
 	gcTrace("Path: {0}", tempPath);
+	UTIL::TIMELINE::ScopedSpan span("mcf", "verifyAll");
 
 	if (!tempPath)
 	{
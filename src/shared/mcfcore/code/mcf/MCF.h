@@ -119,6 +119,27 @@ namespace MCFCore
 		//!
 		void sortFileList();
 
+		//! Finds the file in the reuse mcf that has the same path, size and time stamp
+		//!
+		//! @param file File in this mcf
+		//! @return Matching file with saved data or null
+		//!
+		std::shared_ptr<MCFCore::MCFFile> findReuseFile(const std::shared_ptr<MCFCore::MCFFile> &file);
+
+		//! Gets the mcf set with setReuseMcf
+		//!
+		MCF* getReuseMcf()
+		{
+			return m_pReuseMcf;
+		}
+
+		//! Should reused files have their md5 checked first
+		//!
+		bool shouldReuseCheckHash()
+		{
+			return m_bReuseCheckHash;
+		}
+
 		//! Prints all the file information to the console
 		//!
 		void printAll();
@@ -226,6 +247,7 @@ namespace MCFCore
 		uint64 getFileOffset();
 
 		void createCourgetteDiffs(MCFI* oldMcf, const char* outPath) override;
+		void setReuseMcf(MCFI* prevMcf, bool checkHash = false) override;
 
 	protected:
 		//! A struct that holds the position of a MCFFile in two different Mcfs.
@@ -333,6 +355,10 @@ namespace MCFCore
 
 		std::mutex m_mThreadMutex;
 		MCFCore::Misc::MCFServerCon *m_pMCFServerCon = nullptr;
+
+		MCF* m_pReuseMcf = nullptr;
+		bool m_bReuseCheckHash = false;
+		std::map<uint64, uint32> m_mReuseIndex;
 	};
 
 
@@ -497,6 +497,21 @@ void MCFFile::copyBorkedSettings(std::shared_ptr<MCFFile> tMCFFile)
 		m_vCRCList.push_back(tMCFFile->getCRC(x));
 }
 
+void MCFFile::copyStoredSettings(std::shared_ptr<MCFFile> tMCFFile)
+{
+	setCsum(tMCFFile->getCsum());
+	setCCsum(tMCFFile->getCCsum());
+
+	if (tMCFFile->isCompressed())
+		addFlag(FLAG_COMPRESSED);
+	else
+		delFlag(FLAG_COMPRESSED);
+
+	m_iCSize = tMCFFile->getCSize();
+	m_iBlockSize = tMCFFile->getBlockSize();
+	m_vCRCList = tMCFFile->m_vCRCList;
+}
+
 void MCFFile::copySettings(std::shared_ptr<MCFFile> tMCFFile)
 {
 	gcString tn(this->getName());
@@ -195,6 +195,13 @@ public:
 	void copySettings(std::shared_ptr<MCFFile> tMCFFile);
 	void copyBorkedSettings(std::shared_ptr<MCFFile> tMCFFile);
 
+	//! Copys the details of the stored data (md5s, crcs, compressed size and flag) from the
+	//! same file in another mcf. Used when its stored data is copied as is
+	//!
+	//! @param tMCFFile File to copy from
+	//!
+	void copyStoredSettings(std::shared_ptr<MCFFile> tMCFFile);
+
 	//! Checks to see if this file is completed inside a MCF. Sets a flag if true
 	//!
 	//! @param file Handle to the MCF file
@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 #include "thread/SFTController.h"
 #include "thread/HGTController.h"
 #include "BZip2.h"
+#include "util/UtilTimeline.h"
 
 
 #include <array>
@@ -77,6 +78,7 @@ namespace MCFCore
 void MCF::dlHeaderFromHttp(const char* url)
 {
 	gcTrace("Url: {0}", url);
+	UTIL::TIMELINE::ScopedSpan span("mcf", "dlHeaderFromHttp");
 
 	if (m_bStopped)
 		return;
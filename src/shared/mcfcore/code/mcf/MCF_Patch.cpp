@@ -24,6 +24,7 @@ Contact us at legal@badjuju.com.
 #include "MCF.h"
 #include "Courgette.h"
 #include "util/MD5Progressive.h"
+#include "mcfcore/ProgressAggregator.h"
 
 #define BLOCKSIZE (512*1024)
 
@@ -212,6 +213,8 @@ void MCF::copyMissingFiles(MCFI *sourceMcf)
 
 	size_t totalCount = vSame.size()*2;
 	size_t curCount = 0;
+
+	MCFCore::Misc::ProgressAggregator progress(totalCount);
     std::atomic<bool> placeholder = {false};
 
 	for (size_t x=0; x<vSame.size(); x++)
@@ -234,11 +237,8 @@ void MCF::copyMissingFiles(MCFI *sourceMcf)
 
 		curCount++;
 
-		MCFCore::Misc::ProgressInfo temp;
-		temp.doneAmmount = curCount;
-		temp.totalAmmount = totalCount;
-		temp.percent = (uint8)(curCount*100/totalCount);
-		onProgressEvent(temp);
+		progress.setDone(curCount);
+		progress.publish(onProgressEvent);
 	}
 	hFileDest.close();
 
@@ -271,11 +271,8 @@ void MCF::copyMissingFiles(MCFI *sourceMcf)
 		}
 
 		curCount++;
-		MCFCore::Misc::ProgressInfo temp;
-		temp.doneAmmount = curCount;
-		temp.totalAmmount = totalCount;
-		temp.percent = (uint8)(curCount*100/totalCount);
-		onProgressEvent(temp);
+		progress.setDone(curCount);
+		progress.publish(onProgressEvent);
 	}
 
 	//reset the file offsets so it doesnt fuck the mcf up
@@ -29,13 +29,16 @@ Contact us at legal@badjuju.com.
 #include "thread/SMTController.h"
 #include "thread/WGTController.h"
 #include "mcfcore/DownloadProvider.h"
+#include "mcfcore/ProgressAggregator.h"
 
 #include "XMLSaveAndCompress.h"
+#include "IOScheduler.h"
 
 #include <time.h>
 #include "thread/MCFServerCon.h"
 
 #include "util/gcTime.h"
+#include "util/UtilTimeline.h"
 
 #define MAX_FRAGMENT_SIZE (20*1024*1024)
 
@@ -126,6 +129,7 @@ using namespace MCFCore;
 void MCF::dlHeaderFromWeb()
 {
 	gcTrace("");
+	UTIL::TIMELINE::ScopedSpan span("mcf", "dlHeaderFromWeb");
 
 	if (m_bStopped)
 		return;
@@ -305,9 +309,7 @@ void MCF::parseFolder(const char *path, bool hashFile, bool reportProgress)
 	if (!hashFile)
 		return;
 
-	MCFCore::Misc::ProgressInfo p;
-	p.totalAmmount = m_pFileList.size();
-
+	MCFCore::Misc::ProgressAggregator progress(m_pFileList.size());
 	size_t x = 0;
 
 	for (auto file : m_pFileList)
@@ -316,17 +318,61 @@ void MCF::parseFolder(const char *path, bool hashFile, bool reportProgress)
 		if (m_bStopped)
 			return;
 
-		file->hashFile();
+		auto reuseFile = m_bReuseCheckHash ? nullptr : findReuseFile(file);
+
+		if (reuseFile)
+			file->setCsum(reuseFile->getCsum());
+		else
+			file->hashFile();
 
 		if (reportProgress)
 		{
-			p.doneAmmount = x+1;
-			p.percent = (uint8)(p.doneAmmount*100/p.totalAmmount);
-			onProgressEvent(p);
+			progress.setDone(x+1);
+			progress.publish(onProgressEvent);
 		}
 	}
 }
 
+void MCF::setReuseMcf(MCFI* prevMcf, bool checkHash)
+{
+	m_pReuseMcf = dynamic_cast<MCF*>(prevMcf);
+	m_bReuseCheckHash = checkHash;
+	m_mReuseIndex.clear();
+
+	if (!m_pReuseMcf)
+		return;
+
+	auto &vFileList = m_pReuseMcf->getFileList();
+
+	for (size_t x=0; x<vFileList.size(); x++)
+		m_mReuseIndex[vFileList[x]->getHash()] = (uint32)x;
+}
+
+std::shared_ptr<MCFCore::MCFFile> MCF::findReuseFile(const std::shared_ptr<MCFCore::MCFFile> &file)
+{
+	if (!m_pReuseMcf || !file || file->getTimeStamp() == 0)
+		return nullptr;
+
+	auto it = m_mReuseIndex.find(file->getHash());
+
+	if (it == m_mReuseIndex.end())
+		return nullptr;
+
+	auto reuseFile = m_pReuseMcf->getFile(it->second);
+
+	if (!reuseFile || !reuseFile->isSaved() || reuseFile->isZeroSize())
+		return nullptr;
+
+	if (reuseFile->getSize() != file->getSize() || reuseFile->getTimeStamp() != file->getTimeStamp())
+		return nullptr;
+
+	//without these the copied data cant be verified
+	if (gcString(reuseFile->getCsum()).empty() || reuseFile->getCRCCount() == 0)
+		return nullptr;
+
+	return reuseFile;
+}
+
 void MCF::parseFolder(const char *filePath, const char *oPath)
 {
 	if (m_bStopped)
@@ -437,7 +483,14 @@ void MCF::saveFiles(const char* path)
 
     UTIL::FS::recMakeFolder(strFullPath);
 
-    MCFCore::Thread::SFTController *temp = new MCFCore::Thread::SFTController(m_uiWCount, this, strFullPath.c_str());
+	//wait behind other installs on the same disks and use the worker count they leave us
+	auto ioTicket = MCFCore::Misc::IOScheduler::getGlobal().acquire({ strFullPath, m_szFile }, m_uiWCount, m_bStopped);
+
+	if (!ioTicket)
+		return;
+
+    MCFCore::Thread::SFTController *temp = new MCFCore::Thread::SFTController(ioTicket->getWorkerCount(), this, strFullPath.c_str());
+	temp->setIOTicket(ioTicket.get());
 	temp->onProgressEvent +=delegate(&onProgressEvent);
 	temp->onErrorEvent += delegate(&onErrorEvent);
 
@@ -456,7 +509,22 @@ void MCF::saveMCF_CandSFiles()
 	if (!m_sHeader)
 		throw gcException(ERR_SAVE_NOHEADER);
 
-	MCFCore::Thread::SMTController* temp = new MCFCore::Thread::SMTController(m_uiWCount, this);
+	std::vector<std::string> vIOPaths = { m_szFile };
+
+	if (m_pFileList[0]->getDir())
+		vIOPaths.push_back(m_pFileList[0]->getDir());
+
+	//reused files are copied out of the previous mcf
+	if (m_pReuseMcf && m_pReuseMcf->getFile())
+		vIOPaths.push_back(m_pReuseMcf->getFile());
+
+	auto ioTicket = MCFCore::Misc::IOScheduler::getGlobal().acquire(vIOPaths, m_uiWCount, m_bStopped);
+
+	if (!ioTicket)
+		return;
+
+	MCFCore::Thread::SMTController* temp = new MCFCore::Thread::SMTController(ioTicket->getWorkerCount(), this);
+	temp->setIOTicket(ioTicket.get());
 	temp->onProgressEvent +=delegate(&onProgressEvent);
 	temp->onErrorEvent += delegate(&onErrorEvent);
 
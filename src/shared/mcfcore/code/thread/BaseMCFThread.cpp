@@ -25,6 +25,7 @@ Contact us at legal@badjuju.com.
 
 #include "mcf/MCF.h"
 #include "mcf/MCFFile.h"
+#include "IOScheduler.h"
 
 namespace MCFCore
 {
@@ -53,8 +54,16 @@ BaseMCFThread::~BaseMCFThread()
 	safe_delete(m_pUPThread);
 }
 
+void BaseMCFThread::setIOTicket(MCFCore::Misc::IOTicket* pTicket)
+{
+	m_pIOTicket = pTicket;
+}
+
 void BaseMCFThread::onPause()
 {
+	if (m_pIOTicket)
+		m_pIOTicket->suspend();
+
 	if (m_pUPThread)
 		m_pUPThread->pause();
 }
@@ -67,8 +76,23 @@ void BaseMCFThread::onUnpause()
 
 void BaseMCFThread::onStop()
 {
+	m_bIOStopped = true;
+
 	if (m_pUPThread)
 		m_pUPThread->stop();
 }
 
+bool BaseMCFThread::resumeIO()
+{
+	if (!m_pIOTicket || !m_pIOTicket->isSuspended())
+		return true;
+
+	return m_pIOTicket->resume(m_bIOStopped);
+}
+
+bool BaseMCFThread::isIOSuspended()
+{
+	return m_pIOTicket && m_pIOTicket->isSuspended();
+}
+
 }}
@@ -38,6 +38,11 @@ namespace MCFCore
 	class MCF;
 	class MCFHeaderI;
 
+	namespace Misc
+	{
+		class IOTicket;
+	}
+
 	//! namespace for all MCFCore thread processes
 	namespace Thread
 	{
@@ -83,11 +88,29 @@ namespace MCFCore
 			//!
 			Event<MCFCore::Misc::ProgressInfo> onProgressEvent;
 
+			//! Sets the io ticket the task runs under. It is given back while paused
+			//! and must outlive the thread
+			//!
+			//! @param pTicket Ticket from IOScheduler::acquire
+			//!
+			void setIOTicket(MCFCore::Misc::IOTicket* pTicket);
+
 		protected:
 			virtual void onPause();
 			virtual void onUnpause();
 			virtual void onStop();
 
+			//! Queues for the io ticket again after a pause. Controllers call this once
+			//! doPause returns and only let the workers continue when it succeeds
+			//!
+			//! @return False if stopped or paused again while queued
+			//!
+			bool resumeIO();
+
+			//! Workers should stay paused while this is true
+			//!
+			bool isIOSuspended();
+
 			bool m_bCompress;
 			const char *m_szFile;
 			uint16 m_uiNumber;
@@ -100,6 +123,10 @@ namespace MCFCore
 			std::vector<size_t> m_vFileList;
 
 			uint64 m_uiFileOffset;
+
+		private:
+			MCFCore::Misc::IOTicket* m_pIOTicket = nullptr;
+			std::atomic<bool> m_bIOStopped = {false};
 		};
 	}
 }
@@ -28,6 +28,8 @@ Contact us at legal@badjuju.com.
 
 #include "Courgette.h"
 #include "util/MD5Progressive.h"
+#include "util/UtilTimeline.h"
+#include "IOScheduler.h"
 
 namespace MCFCore
 {
@@ -54,6 +56,8 @@ HGTController::~HGTController()
 
 void HGTController::run()
 {
+	UTIL::TIMELINE::ScopedSpan span("mcf", "HGTController");
+	MCFCore::Misc::IOWorkerScope ioScope;
 	bool usingDiffs = false;
 
 	fillDownloadList(usingDiffs);
@@ -140,6 +144,7 @@ void HGTController::decompressDiff(uint64 size, UTIL::FS::FileHandle &fhSrc, UTI
 
 bool HGTController::expandDiff(CourgetteInstance* ci, std::shared_ptr<MCFCore::MCFFile> file)
 {
+	UTIL::TIMELINE::ScopedSpan span("mcf", "expandDiff", "{0}", file->getName());
 	m_hFile.close();
 
 	UTIL::FS::Path path(m_szInstallDir, file->getName(), false);
@@ -216,6 +221,7 @@ void HGTController::doDownload()
 
 	//wc->getProgressEvent() += delegate(this, &HGTController::onProgress);
 	wc->getWriteEvent() += delegate(this, &HGTController::onWriteMemory);
+	wc->setTrafficClass(UTIL::WEB::TrafficClass::Background);
 
 	for (size_t x=0; x<m_vSuperBlockList.size(); x++)
 	{
@@ -391,6 +397,8 @@ void HGTController::onWriteMemory(WriteMem_s& ws)
 
 	m_uiDownloaded += ws.size;
 	onProgress();
+
+	MCFCore::Misc::IOScheduler::getGlobal().throttle(ws.size);
 }
 
 bool HGTController::saveData(const char* data, uint32 size)
@@ -24,6 +24,7 @@ Contact us at legal@badjuju.com.
 #include "Common.h"
 #include "MCFServerCon.h"
 #include "MCFDPReporter.h"
+#include "util/UtilTimeline.h"
 
 #include <array>
 
@@ -31,12 +32,16 @@ Contact us at legal@badjuju.com.
 
 using namespace MCFCore::Misc;
 
+static UTIL::METRICS::Counter &g_DownloadBytes = UTIL::METRICS::GetRegistry().counter("mcf.download.bytes");
+static UTIL::METRICS::Histogram &g_DownloadRangeTime = UTIL::METRICS::GetRegistry().histogram("mcf.download.range_us");
+
 
 MCFServerCon::MCFServerCon()
 {
 	m_FtpHandle->getProgressEvent() += delegate(this, &MCFServerCon::onProgress);
 	m_FtpHandle->getWriteEvent() += delegate(this, &MCFServerCon::onWrite);
 	m_FtpHandle->dontThrowOnPartFile();
+	m_FtpHandle->setTrafficClass(UTIL::WEB::TrafficClass::Background);
 }
 
 MCFServerCon::~MCFServerCon()
@@ -58,6 +63,11 @@ void MCFServerCon::onWrite(WriteMem_s &mem)
 {
 	m_uiDone += mem.size;
 
+	g_DownloadBytes.add(mem.size);
+
+	if (m_pProviderBytes)
+		m_pProviderBytes->add(mem.size);
+
 	if (!m_bConnected)
 		mem.stop = true;
 
@@ -103,6 +113,7 @@ void MCFServerCon::connect(const MCFCore::Misc::DownloadProvider &provider, cons
 	}
 
 	m_FtpHandle->setUrl(u.c_str());
+	m_pProviderBytes = &UTIL::METRICS::GetRegistry().counter(gcString("mcf.download.bytes.{0}", provider.getName()));
 
 	if (provider.getType() != DownloadProviderType::Cdn)
 		m_FtpHandle->setUserPass(fileAuth.authkey.data(), fileAuth.authhash.data());
@@ -125,6 +136,9 @@ void MCFServerCon::downloadRange(uint64 offset, uint32 size, OutBufferI* buff)
 	m_pOutBuffer = buff;
 	m_uiDone=0;
 
+	UTIL::METRICS::ScopedTimer timer(g_DownloadRangeTime);
+	UTIL::TIMELINE::ScopedSpan span("mcf", "downloadRange", "{0} bytes at {1}", size, offset);
+
 	try
 	{
 		doDownloadRange(offset, size);
@@ -26,6 +26,7 @@ Contact us at legal@badjuju.com.
 #endif
 
 #include "util_thread/BaseThread.h"
+#include "util/UtilMetrics.h"
 #include "mcfcore/MCFI.h"
 
 namespace MCFCore
@@ -118,6 +119,7 @@ private:
 	uint64 m_uiDone = 0;
 
 	OutBufferI* m_pOutBuffer = nullptr;
+	UTIL::METRICS::Counter* m_pProviderBytes = nullptr;
 
 	bool m_bHttpDownload = false;
 	bool m_bConnected = false;
@@ -24,6 +24,8 @@ Contact us at legal@badjuju.com.
 #include "SFTController.h"
 #include "SFTWorker.h"
 #include "mcf/MCFFile.h"
+#include "mcfcore/ProgressAggregator.h"
+#include "util/UtilTimeline.h"
 
 namespace MCFCore
 {
@@ -70,6 +72,7 @@ SFTController::~SFTController()
 
 void SFTController::run()
 {
+	UTIL::TIMELINE::ScopedSpan span("mcf", "SFTController");
 	gcAssert(m_uiNumber);
 	gcAssert(m_szFile);
 
@@ -94,8 +97,12 @@ void SFTController::run()
 	m_pUPThread->start();
 
 
-	for (uint32 x=0; x<m_uiNumber; x++)
-		m_vWorkerList.push_back(new SFTWorkerInfo(this, x));
+	{
+		std::lock_guard<std::mutex> guard(m_WorkerListMutex);
+
+		for (uint32 x=0; x<m_uiNumber; x++)
+			m_vWorkerList.push_back(new SFTWorkerInfo(this, x));
+	}
 
 	for (size_t x=0; x<m_vWorkerList.size(); x++)
 		m_vWorkerList[x]->workThread->start();
@@ -107,8 +114,18 @@ void SFTController::run()
 		if (isStopped())
 			break;
 
+		//the io ticket was given back while paused, get it again before the workers continue
+		if (isIOSuspended())
+		{
+			if (!resumeIO())
+				continue;
+
+			pokeWorkers();
+		}
+
+		//workers notify us when they consume a block, get a new task or finish
 		if (!fillBuffers(fh))
-			m_WaitCond.wait(0, 500);
+			m_WaitCond.wait();
 
 		if (workersDone())
 			break;
@@ -117,9 +134,33 @@ void SFTController::run()
 	for (size_t x=0; x<m_vWorkerList.size(); x++)
 		m_vWorkerList[x]->workThread->stop();
 
+	std::lock_guard<std::mutex> guard(m_WorkerListMutex);
 	safe_delete(m_vWorkerList);
 }
 
+void SFTController::onUnpause()
+{
+	//controller has to retake the io ticket
+	m_WaitCond.notify();
+	BaseMCFThread::onUnpause();
+	pokeWorkers();
+}
+
+void SFTController::onStop()
+{
+	m_WaitCond.notify();
+	BaseMCFThread::onStop();
+	pokeWorkers();
+}
+
+void SFTController::pokeWorkers()
+{
+	std::lock_guard<std::mutex> guard(m_WorkerListMutex);
+
+	for (auto worker : m_vWorkerList)
+		worker->workThread->pokeThread();
+}
+
 bool SFTController::workersDone()
 {
 	for (auto worker : m_vWorkerList)
@@ -136,13 +177,13 @@ void SFTController::fillFileList()
 	uint64 totSize = 0;
 	size_t count = m_rvFileList.size();
 
-	MCFCore::Misc::ProgressInfo p;
-	p.flag = 1;
+	MCFCore::Misc::ProgressAggregator progress(count);
+	progress.setFlag(MCFCore::Misc::ProgressInfo::FLAG_INITFINISHED);
 
 	for (size_t x=0; x<count; x++)
 	{
-		p.percent = x*100/count;
-		onProgressEvent(p);
+		progress.setDone(x);
+		progress.publish(onProgressEvent);
 
 		if (!m_rvFileList[x]->isSaved())
 			continue;
@@ -205,6 +246,8 @@ void SFTController::fillFileList()
 		m_vFileList.push_back((uint32)x);
 	}
 
+	MCFCore::Misc::ProgressInfo p;
+	p.flag = MCFCore::Misc::ProgressInfo::FLAG_INITFINISHED;
 	p.percent = 100;
 	onProgressEvent(p);
 
@@ -265,6 +308,8 @@ bool SFTController::fillBuffers(UTIL::FS::FileHandle& fileHandle)
 		m_vWorkerList[x]->offset += buffSize;
 
 		m_vWorkerList[x]->mutex.unlock();
+
+		m_vWorkerList[x]->workThread->pokeThread();
 	}
 
 	return processed;
@@ -275,7 +320,7 @@ MCFThreadStatus SFTController::getStatus(uint32 id)
 	SFTWorkerInfo* worker = findWorker(id);
 	gcAssert(worker);
 
-	if (isPaused())
+	if (isPaused() || isIOSuspended())
 		return MCFThreadStatus::SF_STATUS_PAUSE;
 
 	if (isStopped())
@@ -319,29 +364,29 @@ std::shared_ptr<MCFCore::MCFFile> SFTController::newTask(uint32 id)
 		return nullptr;
 
 	worker->status = MCFThreadStatus::SF_STATUS_WAITTASK;
-	size_t index = -1;
+	std::shared_ptr<MCFCore::MCFFile> temp;
 
 	{
+		//skip empty slots here rather than recursing, as a recursive call would see
+		//SF_STATUS_WAITTASK and bail leaving the worker stuck
 		std::lock_guard<std::mutex> guard(m_pFileMutex);
-		if (!m_vFileList.empty())
+		while (!temp && !m_vFileList.empty())
 		{
-			index = m_vFileList.back();
+			temp = m_rvFileList[m_vFileList.back()];
 			m_vFileList.pop_back();
 		}
 	}
 
-	if (index == -1)
+	if (!temp)
 	{
 		m_pUPThread->stopThread(id);
 		worker->status = MCFThreadStatus::SF_STATUS_STOP;
+
+		//wake thread up so it can see if all the workers are done
+		m_WaitCond.notify();
 		return nullptr;
 	}
 
-	auto temp = m_rvFileList[index];
-
-	if (!temp)
-		return newTask(id);
-
 	worker->curFile = temp;
 	worker->offset = 0;
 	worker->status = MCFThreadStatus::SF_STATUS_CONTINUE;
@@ -385,6 +430,9 @@ void SFTController::endTask(uint32 id, MCFThreadStatus status, gcException e)
 	worker->mutex.lock();
 	worker->vBuffer.clear();
 	worker->mutex.unlock();
+
+	worker->workThread->pokeThread();
+	m_WaitCond.notify();
 }
 
 
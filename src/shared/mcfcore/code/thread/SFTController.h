@@ -118,6 +118,12 @@ namespace MCFCore
 
 		protected:
 			void run();
+			void onUnpause();
+			void onStop();
+
+			//! Wakes up any workers waiting on data or a state change
+			//!
+			void pokeWorkers();
 
 			//! Finds a Worker given a worker id
 			//!
@@ -146,6 +152,7 @@ namespace MCFCore
 		private:
 			gcString m_szPath;
 			std::vector<SFTWorkerInfo*> m_vWorkerList;
+			std::mutex m_WorkerListMutex;
 
 			::Thread::WaitCondition m_WaitCond;
 		};
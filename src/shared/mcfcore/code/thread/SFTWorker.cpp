@@ -25,6 +25,8 @@ Contact us at legal@badjuju.com.
 #include "thread/SFTWorker.h"
 #include "thread/SFTController.h"
 #include "mcf/MCFFile.h"
+#include "util/UtilMetrics.h"
+#include "IOScheduler.h"
 
 #include <time.h>
 #include <time.h>
@@ -35,6 +37,11 @@ Contact us at legal@badjuju.com.
 #include <unistd.h>
 #endif
 
+static UTIL::METRICS::Counter &g_DecompressIn = UTIL::METRICS::GetRegistry().counter("mcf.sft.decompress_in_bytes");
+static UTIL::METRICS::Counter &g_DecompressOut = UTIL::METRICS::GetRegistry().counter("mcf.sft.decompress_out_bytes");
+static UTIL::METRICS::Counter &g_DecompressTime = UTIL::METRICS::GetRegistry().counter("mcf.sft.decompress_us");
+static UTIL::METRICS::Histogram &g_FileWriteTime = UTIL::METRICS::GetRegistry().histogram("mcf.sft.write_us");
+
 namespace MCFCore
 {
 namespace Thread
@@ -55,9 +62,20 @@ SFTWorker::~SFTWorker()
 	safe_delete(m_pBzs);
 }
 
+void SFTWorker::pokeThread()
+{
+	m_WaitCond.notify();
+}
+
+void SFTWorker::onStop()
+{
+	m_WaitCond.notify();
+}
+
 void SFTWorker::run()
 {
 	gcAssert(m_pCT);
+	MCFCore::Misc::IOWorkerScope ioScope;
 
 	while (true)
 	{
@@ -66,7 +84,7 @@ void SFTWorker::run()
 
 		while (status == MCFThreadStatus::SF_STATUS_PAUSE)
 		{
-			gcSleep(500);
+			m_WaitCond.wait();
 			status = m_pCT->getStatus(m_uiId);
 		}
 
@@ -76,8 +94,9 @@ void SFTWorker::run()
 		}
 		else if (status == MCFThreadStatus::SF_STATUS_NULL)
 		{
-			if (!newTask())
-				gcSleep(500);
+			//no task yet, sleep till the controller or endTask pokes us instead of spinning
+			if (!newTask() && m_pCT->getStatus(m_uiId) != MCFThreadStatus::SF_STATUS_STOP && !isStopped())
+				m_WaitCond.wait();
 
 			continue;
 		}
@@ -173,7 +192,7 @@ int32 SFTWorker::doWork()
 
 	bool endFile = (status == MCFThreadStatus::SF_STATUS_ENDFILE);
 
-	//if temp is null we are waiting on data to be read. Lets nap for a bit
+	//if temp is null we are waiting on data to be read. Sleep till the controller hands us a block
 	if (!temp)
 	{
 		if (endFile)
@@ -185,7 +204,7 @@ int32 SFTWorker::doWork()
 		}
 		else
 		{
-			//gcSleep(100);
+			m_WaitCond.wait();
 			return BZ_OK;
 		}
 	}
@@ -204,6 +223,8 @@ int SFTWorker::doDecompression(const char* buff, uint32 buffSize, bool endFile)
 		return reportError(BZ_STREAM_END, e);
 	}
 
+	auto start = std::chrono::steady_clock::now();
+
 	m_pBzs->write(buff, buffSize, endFile);
 
 	try
@@ -215,6 +236,10 @@ int SFTWorker::doDecompression(const char* buff, uint32 buffSize, bool endFile)
 		return reportError(BZ_STREAM_END, e);
 	}
 
+	//in and out bytes over time gives the decompression throughput
+	g_DecompressIn.add(buffSize);
+	g_DecompressTime.add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
 	size_t outBuffSize = m_pBzs->getReadSize();
 
 	if (outBuffSize == 0)
@@ -224,6 +249,8 @@ int SFTWorker::doDecompression(const char* buff, uint32 buffSize, bool endFile)
 	AutoDelete<char> outBuff(szBuff);
 
 	m_pBzs->read(outBuff, outBuffSize);
+	g_DecompressOut.add(outBuffSize);
+
 	int32 res = doWrite(outBuff, outBuffSize);
 
 	if (res == BZ_OK)
@@ -236,6 +263,7 @@ int32 SFTWorker::doWrite(const char* buff, uint32 buffSize)
 {
 	try
 	{
+		UTIL::METRICS::ScopedTimer timer(g_FileWriteTime);
 		m_hFh.write(buff, buffSize);
 	}
 	catch (gcException &e)
@@ -246,6 +274,7 @@ int32 SFTWorker::doWrite(const char* buff, uint32 buffSize)
 	m_pCT->reportProgress(m_uiId, buffSize);
 	m_pCT->pokeThread();
 
+	MCFCore::Misc::IOScheduler::getGlobal().throttle(buffSize);
 	return BZ_OK;
 }
 
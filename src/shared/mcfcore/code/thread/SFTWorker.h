@@ -50,8 +50,13 @@ public:
 	SFTWorker(SFTController* controller, uint32 id);
 	~SFTWorker();
 
+	//! Wakes the worker up when new data is ready or the controller changes state
+	//!
+	void pokeThread();
+
 protected:
 	void run();
+	void onStop();
 
 	//! Gets a new task to perform
 	//!
@@ -81,6 +86,8 @@ private:
 
 	UTIL::MISC::BZ2Worker *m_pBzs;
 	UTIL::FS::FileHandle m_hFh;
+
+	::Thread::WaitCondition m_WaitCond;
 };
 
 }
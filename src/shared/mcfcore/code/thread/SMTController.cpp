@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 #include "mcf/MCF.h"
 #include "mcf/MCFFile.h"
 #include "mcf/MCFHeader.h"
+#include "util/UtilTimeline.h"
 
 using namespace MCFCore::Thread;
 
@@ -68,6 +69,9 @@ namespace MCFCore
 SMTController::SMTController(uint16 num, MCFCore::MCF* caller)
 	: MCFCore::Thread::BaseMCFThread(std::min<uint32>(num, 4), caller, "SaveMCF Thread")
 	, m_vWorkerList(createWorkers())
+	, m_pMcf(caller)
+	, m_pReuseMcf(caller->getReuseMcf())
+	, m_bReuseCheckHash(caller->shouldReuseCheckHash())
 {
 }
 
@@ -84,15 +88,34 @@ void SMTController::onPause()
 	BaseMCFThread::onPause();
 }
 
+void SMTController::onUnpause()
+{
+	BaseMCFThread::onUnpause();
+	pokeWorkers();
+}
+
 void SMTController::onStop()
 {
 	//get thread running again.
 	m_WaitCond.notify();
 	BaseMCFThread::onStop();
+	pokeWorkers();
+}
+
+void SMTController::pokeWorkers()
+{
+	std::lock_guard<std::mutex> guard(m_WorkerListMutex);
+
+	for (auto worker : m_vWorkerList)
+	{
+		if (worker->workThread)
+			worker->workThread->pokeThread();
+	}
 }
 
 void SMTController::run()
 {
+	UTIL::TIMELINE::ScopedSpan span("mcf", "SMTController");
 	gcAssert(m_uiNumber);
 	gcAssert(m_szFile);
 
@@ -112,8 +135,17 @@ void SMTController::run()
 		if (isStopped())
 			break;
 
-		//wait here as we have nothing else to do
-		m_WaitCond.wait(2);
+		//the io ticket was given back while paused, get it again before the workers continue
+		if (isIOSuspended())
+		{
+			if (!resumeIO())
+				continue;
+
+			pokeWorkers();
+		}
+
+		//wait here as we have nothing else to do. Workers notify us when they finish or fail
+		m_WaitCond.wait();
 
 		if (m_iRunningWorkers == 0)
 			break;
@@ -126,6 +158,9 @@ void SMTController::run()
 
 	if (!isStopped())
 		postProcessing();
+
+	if (m_pReuseMcf)
+		Msg(gcString("Reused {0} of {1} files ({2} bytes) from {3}\n", (uint32)m_uiReusedCount, m_mReuseFiles.size(), (uint64)m_uiReusedSize, m_pReuseMcf->getFile()));
 }
 
 std::vector<SMTWorkerInfo*> SMTController::createWorkers()
@@ -167,7 +202,11 @@ bool SMTController::initWorkers()
 			}
 		}
 
-		m_vWorkerList[x]->init(this, fh, file);
+		{
+			std::lock_guard<std::mutex> guard(m_WorkerListMutex);
+			m_vWorkerList[x]->init(this, fh, file);
+		}
+
 		m_iRunningWorkers++;
 	}
 
@@ -290,6 +329,12 @@ void SMTController::fillFileList()
 		else
 			m_rvFileList[x]->delFlag(MCFCore::MCFFileI::FLAG_COMPRESSED);
 
+		//only reuse data that is stored the same way this save would store it
+		auto reuseFile = m_pMcf->findReuseFile(m_rvFileList[x]);
+
+		if (reuseFile && reuseFile->isCompressed() == m_rvFileList[x]->isCompressed())
+			m_mReuseFiles[x] = reuseFile;
+
 		vList.emplace_back(m_rvFileList[x]->getSize(), (uint32)x);
 	}
 
@@ -308,7 +353,7 @@ MCFThreadStatus SMTController::getStatus(uint32 id)
 	SMTWorkerInfo* worker = findWorker(id);
 	gcAssert(worker);
 
-	if (isPaused())
+	if (isPaused() || isIOSuspended())
 		return MCFThreadStatus::SF_STATUS_PAUSE;
 
 	if (isStopped())
@@ -372,6 +417,37 @@ void SMTController::endTask(uint32 id)
 	worker->ammountDone += worker->curFile->getSize();
 }
 
+std::shared_ptr<MCFCore::MCFFile> SMTController::getReuseFile(uint32 id)
+{
+	SMTWorkerInfo* worker = findWorker(id);
+	gcAssert(worker);
+
+	if (m_mReuseFiles.empty() || worker->vFileList.empty())
+		return nullptr;
+
+	auto it = m_mReuseFiles.find(worker->vFileList.back());
+
+	if (it == m_mReuseFiles.end())
+		return nullptr;
+
+	return it->second;
+}
+
+void SMTController::openReuseMcf(UTIL::FS::FileHandle& handle)
+{
+	gcAssert(m_pReuseMcf);
+	handle.open(m_pReuseMcf->getFile(), UTIL::FS::FILE_READ, m_pReuseMcf->getFileOffset());
+}
+
+void SMTController::reportReused(uint32 id)
+{
+	SMTWorkerInfo* worker = findWorker(id);
+	gcAssert(worker && worker->curFile);
+
+	m_uiReusedCount++;
+	m_uiReusedSize += worker->curFile->getSize();
+}
+
 SMTWorkerInfo* SMTController::findWorker(uint32 id)
 {
 	for (auto worker : m_vWorkerList)
@@ -85,11 +85,42 @@ namespace MCFCore
 			//!
 			void reportProgress(uint32 id, uint64 ammount);
 
+			//! Gets the file from the reuse mcf to copy instead of compressing the workers current task
+			//!
+			//! @param id Worker id
+			//! @return File in the reuse mcf or null to compress as normal
+			//!
+			std::shared_ptr<MCFCore::MCFFile> getReuseFile(uint32 id);
+
+			//! Opens a read handle to the reuse mcf
+			//!
+			//! @param handle Handle to open
+			//!
+			void openReuseMcf(UTIL::FS::FileHandle& handle);
+
+			//! Report a worker has copied its current task from the reuse mcf
+			//!
+			//! @param id Worker id
+			//!
+			void reportReused(uint32 id);
+
+			//! Should reused files have their md5 checked before copying
+			//!
+			bool shouldReuseCheckHash() const
+			{
+				return m_bReuseCheckHash;
+			}
+
 		protected:
 			void run();
 			void onPause();
+			void onUnpause();
 			void onStop();
 
+			//! Wakes up any workers waiting on a state change
+			//!
+			void pokeWorkers();
+
 			//! Finds a Worker given a worker id
 			//!
 			//! @param id worker id
@@ -122,10 +153,19 @@ namespace MCFCore
 
 		private:
 			const std::vector<SMTWorkerInfo*> m_vWorkerList;
+			std::mutex m_WorkerListMutex;
 
             std::atomic<uint32> m_iRunningWorkers = {0};
 			bool m_bCreateDiff = false;
 
+			MCFCore::MCF* m_pMcf;
+			MCFCore::MCF* m_pReuseMcf;
+			const bool m_bReuseCheckHash;
+
+			std::map<size_t, std::shared_ptr<MCFCore::MCFFile>> m_mReuseFiles;
+			std::atomic<uint32> m_uiReusedCount = {0};
+			std::atomic<uint64> m_uiReusedSize = {0};
+
 			::Thread::WaitCondition m_WaitCond;
 		};
 	}
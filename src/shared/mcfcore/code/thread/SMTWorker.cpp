@@ -31,6 +31,7 @@ Contact us at legal@badjuju.com.
 #include "util/MD5Progressive.h"
 #include "ProgressiveCRC.h"
 #include "Courgette.h"
+#include "IOScheduler.h"
 
 namespace MCFCore
 {
@@ -67,10 +68,21 @@ SMTWorker::~SMTWorker()
 	safe_delete(m_BZ2Worker);
 }
 
+void SMTWorker::pokeThread()
+{
+	m_WaitCond.notify();
+}
+
+void SMTWorker::onStop()
+{
+	m_WaitCond.notify();
+}
+
 
 void SMTWorker::run()
 {
 	gcAssert(m_pCT);
+	MCFCore::Misc::IOWorkerScope ioScope;
 
 	while (!isStopped())
 	{
@@ -78,7 +90,7 @@ void SMTWorker::run()
 
 		while (status ==  MCFThreadStatus::SF_STATUS_PAUSE)
 		{
-			gcSleep(500);
+			m_WaitCond.wait();
 			status = m_pCT->getStatus(m_uiId);
 		}
 
@@ -123,6 +135,12 @@ void SMTWorker::doWork()
 	gcAssert(m_pCurFile);
 	gcAssert(m_phFhSink);
 
+	if (m_pReuseFile)
+	{
+		doCopy();
+		return;
+	}
+
 	uint32 buffSize = BLOCKSIZE;
 	bool endFile = false;
 
@@ -149,6 +167,7 @@ void SMTWorker::doWork()
 	{
 		UTIL::MISC::Buffer buff(buffSize);
 		m_hFhSource.read(buff, buffSize);
+		MCFCore::Misc::IOScheduler::getGlobal().throttle(buffSize);
 
 		m_uiTotRead += buffSize;
 		m_uiTotFileRead += buffSize;
@@ -183,6 +202,36 @@ void SMTWorker::doCompression(const char* buff, uint32 buffSize, bool endFile)
 	}
 }
 
+void SMTWorker::doCopy()
+{
+	uint64 copySize = m_pReuseFile->getCurSize();
+	uint32 buffSize = (uint32)std::min<uint64>(BLOCKSIZE, copySize - m_uiTotRead);
+
+	if (buffSize > 0)
+	{
+		UTIL::MISC::Buffer buff(buffSize);
+		m_hFhReuse.read(buff, buffSize);
+		m_phFhSink->write(buff, buffSize);
+		MCFCore::Misc::IOScheduler::getGlobal().throttle(buffSize);
+
+		m_uiTotRead += buffSize;
+		m_uiCurOffset += buffSize;
+
+		//progress is counted in uncompressed bytes
+		m_uiTotFileRead = (uint64)((double)m_pCurFile->getSize() * m_uiTotRead / copySize);
+		m_pCT->reportProgress(m_uiId, m_uiTotFileRead);
+	}
+
+	if (m_uiTotRead < copySize)
+		return;
+
+	m_pCurFile->copyStoredSettings(m_pReuseFile);
+	m_pCT->reportReused(m_uiId);
+
+	finishTask();
+	m_pCT->endTask(m_uiId);
+}
+
 void SMTWorker::writeFile(const char* buff, uint32 buffSize, bool endFile)
 {
 	if (buff && buffSize > 0)
@@ -222,6 +271,8 @@ void SMTWorker::finishTask()
 	safe_delete(m_pCRC);
 	safe_delete(m_BZ2Worker);
 	safe_delete(m_pMD5Comp);
+
+	m_pReuseFile.reset();
 }
 
 bool SMTWorker::newTask()
@@ -252,6 +303,33 @@ bool SMTWorker::newTask()
 	}
 
 	m_pCurFile->setOffSet(m_uiCurOffset);
+	m_uiTotFileRead = 0;
+
+	m_pReuseFile = m_pCT->getReuseFile(m_uiId);
+
+	if (m_pReuseFile && m_pCT->shouldReuseCheckHash())
+	{
+		//parseFolder with hashing on already has the md5, only read the file when it wasnt hashed
+		std::string hash = gcString(m_pCurFile->getCsum());
+
+		if (hash.empty())
+		{
+			hash = UTIL::MISC::hashFile(m_hFhSource.getHandle(), m_pCurFile->getSize());
+			m_hFhSource.seek(0);
+		}
+
+		if (hash != m_pReuseFile->getCsum())
+			m_pReuseFile.reset();
+	}
+
+	if (m_pReuseFile)
+	{
+		if (!m_hFhReuse.isValidFile())
+			m_pCT->openReuseMcf(m_hFhReuse);
+
+		m_hFhReuse.seek(m_pReuseFile->getOffSet());
+		return true;
+	}
 
 	m_pMD5Norm = new MD5Progressive();
 	m_pCRC = new MCFCore::Misc::ProgressiveCRC(m_pCurFile->getBlockSize());
@@ -262,7 +340,6 @@ bool SMTWorker::newTask()
 		m_BZ2Worker = new UTIL::MISC::BZ2Worker(UTIL::MISC::BZ2_COMPRESS);
 	}
 
-	m_uiTotFileRead = 0;
 	return true;
 }
 
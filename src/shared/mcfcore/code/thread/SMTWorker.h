@@ -60,8 +60,13 @@ public:
 	SMTWorker(SMTController* controller, uint32 id, UTIL::FS::FileHandle* fileHandle);
 	~SMTWorker();
 
+	//! Wakes the worker up when the controller changes state (unpause or stop)
+	//!
+	void pokeThread();
+
 protected:
 	void run();
+	void onStop();
 
 	//! Compresses and saves the files to the mcf
 	//!
@@ -80,6 +85,10 @@ protected:
 	void writeFile(const char* buff, uint32 buffSize, bool endFile);
 	void doCompression(const char* buff, uint32 buffSize, bool endFile);
 
+	//! Copies the next block of the current file's stored data from the reuse mcf
+	//!
+	void doCopy();
+
 private:
 	MD5Progressive* m_pMD5Norm;
 	MD5Progressive* m_pMD5Comp;
@@ -98,10 +107,14 @@ private:
 	SMTController *m_pCT;
 
 	std::shared_ptr<MCFCore::MCFFile> m_pCurFile;
+	std::shared_ptr<MCFCore::MCFFile> m_pReuseFile;
 	UTIL::MISC::BZ2Worker *m_BZ2Worker;
 
 	UTIL::FS::FileHandle m_hFhSource;
+	UTIL::FS::FileHandle m_hFhReuse;
 	UTIL::FS::FileHandle* m_phFhSink;
+
+	::Thread::WaitCondition m_WaitCond;
 };
 
 }
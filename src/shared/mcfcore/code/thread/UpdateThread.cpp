@@ -31,9 +31,12 @@ namespace Thread
 
 UpdateProgThread::UpdateProgThread(uint16 count, uint64 totSize)
 	: BaseThread( "Update Progress Thread" )
-	, m_pCount(count)
+	, m_vProgInfo(count)
 	, m_uiTotalSize(totSize)
+	, m_uiDoneSize(0)
 {
+	for (auto &p : m_vProgInfo)
+		p = 0;
 }
 
 UpdateProgThread::~UpdateProgThread()
@@ -56,10 +59,7 @@ void UpdateProgThread::reportProg(uint32 id, uint64 ammount)
 	if (id >= m_vProgInfo.size())
 		return;
 
-	std::lock_guard<std::mutex> guard(m_pProgMutex);
-
-	m_vProgInfo[id] = ammount;
-	m_tLastUpdateTime = gcTime();
+	m_vProgInfo[id].store(ammount, std::memory_order_relaxed);
 }
 
 void UpdateProgThread::stopThread(uint32 id)
@@ -71,13 +71,10 @@ void UpdateProgThread::run()
 	m_tStartTime = gcTime();
 	m_tLastUpdateTime = gcTime();
 
-	for (uint8 x=0; x<m_pCount; x++)
-		m_vProgInfo.push_back(0);
-
 	while (!isStopped())
 	{
 		doPause();
-		gcSleep(500);
+		m_WaitCond.wait(0, 500);
 		calcResults();
 	}
 }
@@ -96,22 +93,26 @@ void UpdateProgThread::calcResults()
 	if (elasped.seconds() == 0)
 		return;
 
-	{
-		std::lock_guard<std::mutex> guard(m_pProgMutex);
-
-		for (size_t x=0; x<m_vProgInfo.size(); x++)
-			done += m_vProgInfo[x];
-	}
-
+	for (auto &p : m_vProgInfo)
+		done += p.load(std::memory_order_relaxed);
 
 	if (done == 0)
 		return;
 
+	if (done != m_uiLastDone)
+	{
+		m_uiLastDone = done;
+		m_tLastUpdateTime = curTime;
+	}
+
 	MCFCore::Misc::ProgressInfo temp = MCFCore::Misc::ProgressInfo();
 
-	temp.doneAmmount = done+m_uiDoneSize;
-	temp.totalAmmount = m_uiTotalSize;
-	temp.percent = (uint8)(((done+m_uiDoneSize)*100)/m_uiTotalSize);
+	uint64 totalSize = m_uiTotalSize;
+	uint64 doneSize = m_uiDoneSize;
+
+	temp.doneAmmount = done+doneSize;
+	temp.totalAmmount = totalSize;
+	temp.percent = (uint8)(((done+doneSize)*100)/totalSize);
 
 	auto diff = curTime - m_tLastUpdateTime;
 
@@ -125,7 +126,7 @@ void UpdateProgThread::calcResults()
 		total -= m_tTotPauseTime;
 
 		double avgRate	= done / (double)total.seconds();
-		uint64 pred		= (uint64)((m_uiTotalSize - done - m_uiDoneSize) / avgRate);
+		uint64 pred		= (uint64)((totalSize - done - doneSize) / avgRate);
 
 		auto predTime = gcDuration(std::chrono::seconds((long)pred));
 
@@ -139,7 +140,8 @@ void UpdateProgThread::calcResults()
 		temp.min	= (uint8)-1;
 	}
 
-	onProgUpdateEvent(temp);
+	if (m_ProgressLimiter.shouldPublish(temp))
+		onProgUpdateEvent(temp);
 }
 
 void UpdateProgThread::onPause()
@@ -154,6 +156,7 @@ void UpdateProgThread::onUnpause()
 
 void UpdateProgThread::onStop()
 {
+	m_WaitCond.notify();
 }
 
 
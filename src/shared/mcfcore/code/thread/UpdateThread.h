@@ -28,6 +28,7 @@ Contact us at legal@badjuju.com.
 #include "util_thread/BaseThread.h"
 #include "Event.h"
 #include "mcfcore/ProgressInfo.h"
+#include "mcfcore/ProgressAggregator.h"
 
 #include "util/gcTime.h"
 
@@ -40,6 +41,9 @@ namespace Thread
 //! This class handles the reporting of progress from multithreads of work.
 //! It predicts the time left and also the rate of progress
 //!
+//! Workers only store their progress in an atomic counter, the totals are
+//! calculated and published by this thread at a bounded rate.
+//!
 class UpdateProgThread : public ::Thread::BaseThread
 {
 public:
@@ -89,18 +93,19 @@ protected:
 	void onUnpause();
 
 private:
-	std::mutex m_pProgMutex;
+	::Thread::WaitCondition m_WaitCond;
+	MCFCore::Misc::ProgressAggregator m_ProgressLimiter;
 
 	gcTime m_tLastUpdateTime;
 	gcTime m_tStartTime;
 	gcTime m_tPauseStartTime;
 	gcDuration m_tTotPauseTime;
 
-	uint16 m_pCount = 0;
-	std::vector<uint64> m_vProgInfo;
+	uint64 m_uiLastDone = 0;
+	std::vector<std::atomic<uint64>> m_vProgInfo;
 
-	uint64 m_uiTotalSize = 0;
-	uint64 m_uiDoneSize = 0;
+	std::atomic<uint64> m_uiTotalSize;
+	std::atomic<uint64> m_uiDoneSize;
 };
 
 }}
@@ -28,9 +28,17 @@ Contact us at legal@badjuju.com.
 #include "mcf/MCF.h"
 
 #include "ProviderManager.h"
+#include "IOScheduler.h"
+#include "util/UtilMetrics.h"
+#include "util/UtilTimeline.h"
 
 #define MAX_BLOCK_SIZE (50*1024*1024)
 
+static UTIL::METRICS::Counter &g_CrcFailures = UTIL::METRICS::GetRegistry().counter("mcf.download.crc_failures");
+static UTIL::METRICS::Counter &g_SizeFailures = UTIL::METRICS::GetRegistry().counter("mcf.download.size_failures");
+static UTIL::METRICS::Counter &g_BytesSaved = UTIL::METRICS::GetRegistry().counter("mcf.download.bytes_saved");
+static UTIL::METRICS::Histogram &g_BlockWriteTime = UTIL::METRICS::GetRegistry().histogram("mcf.download.block_write_us");
+
 #ifndef min
 template <typename A>
 A min(A a, A b)
@@ -199,6 +207,11 @@ namespace MCFCore
 				m_pWorkThread->start();
 			}
 
+			void poke()
+			{
+				m_pWorkThread->pokeThread();
+			}
+
 			void reportError(gcException &e, gcString &strProv)
 			{
 				m_pWorkThread->reportError(e, strProv);
@@ -279,8 +292,10 @@ WGTController::~WGTController()
 {
 	stop();
 
-	if (m_bDoingStop)
-		gcSleep(500);
+	{
+		//make sure onStop has finished if it was called from another thread
+		std::lock_guard<std::mutex> guard(m_StopMutex);
+	}
 
 	m_pWorkerList.reset();
 
@@ -297,6 +312,7 @@ void WGTController::pokeThread()
 
 void WGTController::run()
 {
+	UTIL::TIMELINE::ScopedSpan span("mcf", "WGTController");
 	UTIL::FS::FileHandle fh;
 
 	if (!fillBlockList())
@@ -339,8 +355,9 @@ void WGTController::run()
 			break;
 		}
 
+		//workers notify us when a block is ready, they finish or they run out of providers
 		if (!isStopped())
-			m_WaitCondition.wait(5);
+			m_WaitCondition.wait();
 	}
 
 	m_pUPThread->stop();
@@ -416,8 +433,12 @@ void WGTController::saveBuffers(UTIL::FS::FileHandle& fileHandle, bool allBlocks
 
 			try
 			{
+				UTIL::METRICS::ScopedTimer timer(g_BlockWriteTime);
+				UTIL::TIMELINE::ScopedSpan span("mcf", "saveBuffers", "{0} bytes at {1}", block->size, block->fileOffset);
+
 				fileHandle.seek(block->fileOffset);
 				fileHandle.write(block->buff, block->size);
+				g_BytesSaved.add(block->size);
 
 #ifdef DEBUG
 				m_uiSaved += block->size;
@@ -428,6 +449,9 @@ void WGTController::saveBuffers(UTIL::FS::FileHandle& fileHandle, bool allBlocks
 				onErrorEvent(e);
 				break;
 			}
+
+			//only disk writes count against the background io limit, filling the block buffers is just memory
+			MCFCore::Misc::IOScheduler::getGlobal().throttle(block->size);
 		}
 		while (allBlocks); //if all blocks is true it will keep looping until buff size is zero else it will run once
 	}
@@ -452,6 +476,11 @@ bool WGTController::checkBlock(const std::shared_ptr<Misc::WGTBlock> &block, uin
 	if (!sizeFail && !crcFail)
 		return true;
 
+	if (sizeFail)
+		g_SizeFailures.add();
+	else
+		g_CrcFailures.add();
+
 	gcTrace("Id: {0}", workerId);
 
 	reportNegProgress(workerId, block->dlsize);
@@ -526,6 +555,7 @@ static bool SortByOffset(const std::shared_ptr<MCFCore::MCFFile>& a, const std::
 
 bool WGTController::fillBlockList()
 {
+	UTIL::TIMELINE::ScopedSpan span("mcf", "fillBlockList");
 	MCFCore::Misc::ProgressInfo pi;
 	MCFCore::MCF webMcf(m_ProvManager.getDownloadProviders());
 
@@ -959,9 +989,17 @@ std::shared_ptr<WGTWorkerInfo> WGTController::findWorker(uint32 id)
 	return nullptr;
 }
 
+void WGTController::onUnpause()
+{
+	BaseMCFThread::onUnpause();
+
+	for (auto w : m_vWorkerList)
+		w->poke();
+}
+
 void WGTController::onStop()
 {
-	m_bDoingStop = true;
+	std::lock_guard<std::mutex> stopGuard(m_StopMutex);
 
 	{
 		std::lock_guard<std::mutex> guard(m_McfLock);
@@ -976,6 +1014,4 @@ void WGTController::onStop()
 
 	//get thread running again.
 	m_WaitCondition.notify();
-
-	m_bDoingStop = false;
 }
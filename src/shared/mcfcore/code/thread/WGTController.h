@@ -102,6 +102,7 @@ namespace MCFCore
 
 			//inhereted from BaseThread
 			void run() override;
+			void onUnpause() override;
 			void onStop() override;
 
 			//! Checks a block for errors
@@ -130,7 +131,7 @@ namespace MCFCore
             std::atomic<uint32> m_iRunningWorkers = {0};
 
 			bool m_bCheckMcf = false;
-			volatile bool m_bDoingStop = false;
+			std::mutex m_StopMutex;
 
 			std::unique_ptr<WGTWorkerList> m_pWorkerList;
 			const std::vector<std::shared_ptr<WGTWorkerInfo>>& m_vWorkerList;
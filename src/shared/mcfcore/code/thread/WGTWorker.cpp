@@ -24,6 +24,7 @@ Contact us at legal@badjuju.com.
 #include "WGTWorker.h"
 #include "WGTController.h"
 #include "ProviderManager.h"
+#include "IOScheduler.h"
 
 
 using namespace MCFCore::Thread;
@@ -57,8 +58,14 @@ void WGTWorker::reportError(gcException &e, gcString provider)
 	m_ErrorMutex.unlock();
 }
 
+void WGTWorker::pokeThread()
+{
+	m_WaitCond.notify();
+}
+
 void WGTWorker::run()
 {
+	MCFCore::Misc::IOWorkerScope ioScope;
 	m_DownloadProvider = m_ProvMng.getUrl(m_uiId);
 
 	if (!m_DownloadProvider || !m_DownloadProvider->isValidAndNotExpired())
@@ -79,8 +86,6 @@ void WGTWorker::run()
 	{
 		MCFThreadStatus status = m_pCT->getStatus(m_uiId);
 
-		uint32 pauseCount = 0;
-
 		bool isPaused= (status == MCFThreadStatus::SF_STATUS_PAUSE);
 
 		if (isPaused)
@@ -88,11 +93,16 @@ void WGTWorker::run()
 
 		while (status == MCFThreadStatus::SF_STATUS_PAUSE)
 		{
-			if (pauseCount > 30000 && m_pMcfCon->isConnected())
-				m_pMcfCon->disconnect();
-
-			gcSleep(500);
-			pauseCount += 500;
+			//keep the connection around for a short pause, drop it if we are paused for a while
+			if (m_pMcfCon->isConnected())
+			{
+				if (m_WaitCond.wait(30))
+					m_pMcfCon->disconnect();
+			}
+			else
+			{
+				m_WaitCond.wait();
+			}
 
 			status = m_pCT->getStatus(m_uiId);
 		}
@@ -331,6 +341,7 @@ void WGTWorker::onStop()
 
 	m_DeleteMutex.unlock();
 
+	m_WaitCond.notify();
 	join();
 }
 
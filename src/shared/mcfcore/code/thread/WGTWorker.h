@@ -74,6 +74,10 @@ namespace MCFCore
 			//!
 			void reportError(gcException &e, gcString provider);
 
+			//! Wakes the worker up when the controller changes state (unpause or stop)
+			//!
+			void pokeThread();
+
 		protected:
 			void run();
 			void onStop();
@@ -118,6 +122,8 @@ namespace MCFCore
 			std::mutex m_ErrorMutex;
 			bool m_bError = false;
 			gcException m_Error;
+
+			::Thread::WaitCondition m_WaitCond;
 		};
 
 	}
@@ -22,6 +22,7 @@ Contact us at legal@badjuju.com.
 
 #include "Common.h"
 #include "ComplexLaunchProcess.h"
+#include "ServiceTimeline.h"
 #include "McfInit.h"
 
 #include "mcfcore/MCFMain.h"
@@ -37,7 +38,6 @@ enum
 ComplexLaunchProcess::ComplexLaunchProcess()
 : Thread::BaseThread("Complex Launch Process Thread")
 , m_iMode(MODE_UNKNOWN)
-, m_uiLastProg(0)
 , m_bHashMissMatch(false)
 , m_iFirstStage(true)
 , m_pException(nullptr)
@@ -75,6 +75,8 @@ void ComplexLaunchProcess::setInstall(const char* mcfPath, const char* installPa
 
 void ComplexLaunchProcess::run()
 {
+	ProcessTimeline timeline("ComplexLaunchProcess");
+
 	switch (m_iMode)
 	{
 		case MODE_REMOVE:
@@ -214,13 +216,11 @@ void ComplexLaunchProcess::onProgress(MCFCore::Misc::ProgressInfo& p)
 			p.percent = 50+p.percent/2;
 	}
 
-	uint64 val = p.toInt64();
-
-	if (val == m_uiLastProg)
+	if (!m_ProgressLimiter.shouldPublish(p))
 		return;
 
+	uint64 val = p.toInt64();
 	onProgressEvent(val);
-	m_uiLastProg = val;
 }
 
 void ComplexLaunchProcess::onError(gcException& e)
@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 
 #include "util_thread/BaseThread.h"
 #include "mcfcore/ProgressInfo.h"
+#include "mcfcore/ProgressAggregator.h"
 
 namespace MCFCore{ class MCFI; }
 
@@ -63,7 +64,7 @@ private:
 	bool m_bHashMissMatch;
 	bool m_iFirstStage;
 	uint8 m_iMode;
-	uint64 m_uiLastProg;
+	MCFCore::Misc::ProgressAggregator m_ProgressLimiter;
 
 	std::shared_ptr<gcException> m_pException;
 };
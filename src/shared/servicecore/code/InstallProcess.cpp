@@ -22,6 +22,7 @@ Contact us at legal@badjuju.com.
 
 #include "Common.h"
 #include "InstallProcess.h"
+#include "ServiceTimeline.h"
 #include "McfInit.h"
 #include "InstallScriptRunTime.h"
 
@@ -33,7 +34,6 @@ InstallProcess::InstallProcess(const char* mcfpath, const char* inspath, const c
 , m_pMcfHandle(nullptr)
 , m_bHashMissMatch(false)
 , m_bMakeWriteable(makeWriteable)
-, m_uiLastProg(0)
 , m_szInstallScript(installScript)
 , m_bHasHadError(false)
 , onCompleteEvent()
@@ -58,6 +58,7 @@ InstallProcess::~InstallProcess()
 void InstallProcess::run()
 {
 	gcTrace("");
+	ProcessTimeline timeline("InstallProcess");
 
 	if (m_szIPath == "" || m_szMCFPath == "")
 	{
@@ -164,11 +165,9 @@ void InstallProcess::onError(gcException& e)
 
 void InstallProcess::onProgress(MCFCore::Misc::ProgressInfo& p)
 {
-	uint64 val = p.toInt64();
-
-	if (val == m_uiLastProg)
+	if (!m_ProgressLimiter.shouldPublish(p))
 		return;
 
+	uint64 val = p.toInt64();
 	onProgressEvent(val);
-	m_uiLastProg = val;
 }
@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 
 #include "util_thread/BaseThread.h"
 #include "mcfcore/ProgressInfo.h"
+#include "mcfcore/ProgressAggregator.h"
 
 namespace MCFCore{ class MCFI; }
 
@@ -57,7 +58,7 @@ private:
 	bool m_bHasHadError;
 
 	uint32 m_uiWorkerCount;
-	uint64 m_uiLastProg;
+	MCFCore::Misc::ProgressAggregator m_ProgressLimiter;
 
 	gcString m_szIPath;
 	gcString m_szMCFPath;
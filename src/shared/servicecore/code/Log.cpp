@@ -23,10 +23,12 @@ Contact us at legal@badjuju.com.
 #include "Common.h"
 #include "Log.h"
 #include "LogCallback.h"
+#include "util_thread/LogWriterThread.h"
 
 class Color;
 
 LogCallback* g_pLogCallBack = nullptr;
+Thread::LogWriterThread* g_pLogWriter = nullptr;
 
 std::mutex g_RegDllLock;
 std::vector<RegDLLCB_MCF> g_pRegDlls;
@@ -47,14 +49,31 @@ void InitLogging(RegDLLCB_MCF cb)
 	}
 
 
+	//Forwarding over ipc happens on the writer thread so mcf workers dont block on it
+	Thread::LogWriterThread::SinkFn sinkFn = [](MSG_TYPE type, const char* msg, Color* col)
+	{
+		LogMsg(type, msg, col);
+	};
+
 	LogCallback::MessageFn messageFn = [](MSG_TYPE type, const char* msg, Color* col, std::map<std::string, std::string> *mpArgs)
 	{
-		LogMsg(type, msg, col, mpArgs);
+		if (type == MT_TRACE || !g_pLogWriter)
+			LogMsg(type, msg, col, mpArgs);
+		else
+			g_pLogWriter->push(type, msg, col);
 	};
 
+	g_pLogWriter = new Thread::LogWriterThread(nullptr, sinkFn);
+	g_pLogWriter->start();
+
 	g_pLogCallBack = new LogCallback();
 	g_pLogCallBack->RegMsg(messageFn);
 
+#ifndef DEBUG
+	//Dropped by LogMsg anyway, dont let the dlls format them
+	g_pLogCallBack->setEnabled(MT_DEBUG, false);
+#endif
+
 	if (cb)
 	{
 		g_pRegDlls.push_back(cb);
@@ -75,6 +94,7 @@ void DestroyLogging()
 			cb(nullptr);
 	}
 
+	safe_delete(g_pLogWriter);
 	safe_delete(g_pLogCallBack);
 }
 
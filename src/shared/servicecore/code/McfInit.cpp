@@ -24,9 +24,11 @@ Contact us at legal@badjuju.com.
 #include "McfInit.h"
 #include "SharedObjectLoader.h"
 #include "Log.h"
+#include "mcfcore/MCFIOSchedulerI.h"
 
 typedef void* (*BFACT)(const char*);
 typedef void (*DFACT)(void*, const char*);
+typedef UTIL::TIMELINE::Timeline* (*TIMELINEFN)();
 
 
 
@@ -97,6 +99,19 @@ void mcfDelFactory(void* p)
 }
 
 
+UTIL::TIMELINE::Timeline* mcfTimeline()
+{
+	if (!buildFactory)
+		return nullptr;
+
+	auto getTimeline = g_pMCFCore.getFunction<TIMELINEFN>("GetMCFCoreTimeline");
+
+	if (!getTimeline)
+		return nullptr;
+
+	return getTimeline();
+}
+
 void shutDownFactory()
 {
 	buildFactory = nullptr;
@@ -125,3 +140,11 @@ namespace MCFCore
 		delFactory(p, name);
 	}
 }
+
+void SetMcfBackgroundMode(bool bEnabled, uint32 uiRateLimit)
+{
+	auto pScheduler = static_cast<MCFCore::IOSchedulerI*>(MCFCore::FactoryBuilder(MCF_IOSCHEDULER));
+
+	if (pScheduler)
+		pScheduler->setBackgroundMode(bEnabled, uiRateLimit);
+}
@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 
 #include "mcfcore/MCFI.h"
 #include "mcfcore/MCFHeaderI.h"
+#include "util/UtilTimeline.h"
 
 
 
@@ -35,5 +36,11 @@ void mcfDelFactory(void* p);
 
 void shutDownFactory();
 
+//! Timeline of the loaded mcfcore, null if it hasnt been loaded yet
+UTIL::TIMELINE::Timeline* mcfTimeline();
+
+//! Turns background mode on or off for installs running in the service
+void SetMcfBackgroundMode(bool bEnabled, uint32 uiRateLimit);
+
 
 #endif
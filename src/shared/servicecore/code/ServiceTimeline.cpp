@@ -0,0 +1,60 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#include "Common.h"
+#include "ServiceTimeline.h"
+#include "McfInit.h"
+
+void SetTimelineSettings(bool bEnabled)
+{
+	UTIL::TIMELINE::GetTimeline().setEnabled(bEnabled);
+
+	auto pMcfTimeline = mcfTimeline();
+
+	if (pMcfTimeline)
+		pMcfTimeline->setEnabled(bEnabled);
+}
+
+void DumpTimeline()
+{
+	if (!UTIL::TIMELINE::GetTimeline().isEnabled())
+		return;
+
+	//Never take a path from the client, we run with more rights than it does
+	gcString strPath(UTIL::OS::getAppDataPath(L"desura_service_timeline.json"));
+
+	std::vector<UTIL::TIMELINE::Timeline*> vTimelines;
+	vTimelines.push_back(&UTIL::TIMELINE::GetTimeline());
+	vTimelines.push_back(mcfTimeline());
+
+	auto strTrace = UTIL::TIMELINE::FormatChromeTrace(vTimelines);
+
+	try
+	{
+		UTIL::FS::FileHandle fh(strPath.c_str(), UTIL::FS::FILE_WRITE);
+		fh.write(strTrace.c_str(), strTrace.size());
+	}
+	catch (gcException &e)
+	{
+		Warning("Failed to write service timeline: {0}\n", e);
+	}
+}
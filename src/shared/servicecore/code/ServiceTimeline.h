@@ -0,0 +1,54 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_SERVICE_TIMELINE_H
+#define DESURA_SERVICE_TIMELINE_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "util/UtilTimeline.h"
+
+void SetTimelineSettings(bool bEnabled);
+
+//! Writes the service and mcfcore spans to desura_service_timeline.json in the service app data folder
+void DumpTimeline();
+
+//! Times a service process and writes out the timeline once it has finished
+class ProcessTimeline
+{
+public:
+	ProcessTimeline(const char* szName)
+		: m_pSpan(new UTIL::TIMELINE::ScopedSpan("service", szName))
+	{
+	}
+
+	~ProcessTimeline()
+	{
+		m_pSpan.reset();
+		DumpTimeline();
+	}
+
+private:
+	std::unique_ptr<UTIL::TIMELINE::ScopedSpan> m_pSpan;
+};
+
+#endif //DESURA_SERVICE_TIMELINE_H
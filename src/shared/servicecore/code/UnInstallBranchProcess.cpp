@@ -22,6 +22,7 @@ Contact us at legal@badjuju.com.
 
 #include "Common.h"
 #include "UnInstallBranchProcess.h"
+#include "ServiceTimeline.h"
 #include "McfInit.h"
 #include "InstallScriptRunTime.h"
 #include "mcfcore/MCFMain.h"
@@ -43,6 +44,7 @@ UninstallBranchProcess::~UninstallBranchProcess()
 void UninstallBranchProcess::run()
 {
 	gcTrace("");
+	ProcessTimeline timeline("UninstallBranchProcess");
 
 	if (m_szOldMcfPath == "" || m_szNewMcfPath == "")
 	{
@@ -125,11 +127,9 @@ void UninstallBranchProcess::onError(gcException& e)
 
 void UninstallBranchProcess::onProgress(MCFCore::Misc::ProgressInfo& p)
 {
-	uint64 val = p.toInt64();
-
-	if (val == m_uiLastProg)
+	if (!m_ProgressLimiter.shouldPublish(p))
 		return;
 
+	uint64 val = p.toInt64();
 	onProgressEvent(val);
-	m_uiLastProg = val;
 }
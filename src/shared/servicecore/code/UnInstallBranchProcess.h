@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 
 #include "util_thread/BaseThread.h"
 #include "mcfcore/ProgressInfo.h"
+#include "mcfcore/ProgressAggregator.h"
 
 namespace MCFCore{ class MCFI; }
 
@@ -51,7 +52,7 @@ protected:
 	void onProgress(MCFCore::Misc::ProgressInfo& p);
 
 private:
-	uint64 m_uiLastProg = 0;
+	MCFCore::Misc::ProgressAggregator m_ProgressLimiter;
 
 	gcString m_szOldMcfPath;
 	gcString m_szNewMcfPath;
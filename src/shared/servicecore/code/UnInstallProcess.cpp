@@ -22,6 +22,7 @@ Contact us at legal@badjuju.com.
 
 #include "Common.h"
 #include "UnInstallProcess.h"
+#include "ServiceTimeline.h"
 #include "McfInit.h"
 #include "InstallScriptRunTime.h"
 #include "mcfcore/MCFMain.h"
@@ -42,6 +43,7 @@ UninstallProcess::~UninstallProcess()
 void UninstallProcess::run()
 {
 	gcTrace("");
+	ProcessTimeline timeline("UninstallProcess");
 
 	if (m_szIPath == "" || m_szMCFPath == "")
 	{
@@ -85,11 +87,9 @@ void UninstallProcess::onStop()
 
 void UninstallProcess::onProgress(MCFCore::Misc::ProgressInfo& p)
 {
-	uint64 val = p.toInt64();
-
-	if (val == m_uiLastProg)
+	if (!m_ProgressLimiter.shouldPublish(p))
 		return;
 
+	uint64 val = p.toInt64();
 	onProgressEvent(val);
-	m_uiLastProg = val;
 }
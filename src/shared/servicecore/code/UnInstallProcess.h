@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 
 #include "util_thread/BaseThread.h"
 #include "mcfcore/ProgressInfo.h"
+#include "mcfcore/ProgressAggregator.h"
 
 namespace MCFCore{ class MCFI; }
 
@@ -50,7 +51,7 @@ private:
 	gcString m_szMCFPath;
 	gcString m_szInstallScript;
 
-	uint64 m_uiLastProg = 0;
+	MCFCore::Misc::ProgressAggregator m_ProgressLimiter;
 
 	std::mutex m_McfLock;
 	MCFCore::MCFI* m_pMcfHandle = nullptr;
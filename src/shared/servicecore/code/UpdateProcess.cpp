@@ -22,6 +22,7 @@ Contact us at legal@badjuju.com.
 
 #include "Common.h"
 #include "UpdateProcess.h"
+#include "ServiceTimeline.h"
 
 #include "McfInit.h"
 #include "umcf/UMcf.h"
@@ -53,6 +54,8 @@ GCUpdateProcess::~GCUpdateProcess()
 
 void GCUpdateProcess::run()
 {
+	ProcessTimeline timeline("UpdateProcess");
+
 	try
 	{
 		install();
@@ -194,6 +194,11 @@ void Console::ignoreThisThread()
 	s_IgnoredThread = std::this_thread::get_id();
 }
 
+bool Console::isThreadIgnored()
+{
+	return s_IgnoredThread == std::this_thread::get_id();
+}
+
 void Console::setupAutoComplete()
 {
 	std::vector<gcRefPtr<ConCommand>> vCCList;
@@ -554,3 +559,11 @@ void Console::trace(const char* szMessage, std::map<std::string, std::string> *p
 
 	g_pTracer->trace(szMessage, pmArgs);
 }
+
+void Console::trace(const TraceEvent &event)
+{
+	if (!g_pTracer || isThreadIgnored())
+		return;
+
+	g_pTracer->traceRaw(event);
+}
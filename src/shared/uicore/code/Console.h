@@ -63,9 +63,11 @@ public:
 
 	//Used to ignore unit test thread
 	static void ignoreThisThread();
+	static bool isThreadIgnored();
 
 	static void setTracer(TracerI *pTracer);
 	static void trace(const char* szMessage, std::map<std::string, std::string> *pmArgs);
+	static void trace(const TraceEvent &event);
 
 protected:
 	void setupAutoComplete();
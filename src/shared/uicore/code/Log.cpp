@@ -29,20 +29,33 @@ Contact us at legal@badjuju.com.
 #include "Console.h"
 
 #include "LogBones.cpp"
+#include "util_thread/LogWriterThread.h"
 
 
 static Console* g_pConsole;
+static Thread::LogWriterThread* g_pLogWriter;
 
 extern bool admin_cb(CVar* var, const char* val);
 
 CVar admin_developer("admin_developer", "0", CFLAG_ADMIN|CFLAG_NOSAVE, (CVarCallBackFn)&admin_cb);
 
 
+bool gc_debug_cb(CVar* var, const char* val)
+{
+	//force the value to be set so getBool sees the new value
+	var->setValue(val);
+
+	if (g_pLogCallback)
+		g_pLogCallback->setEnabled(MT_DEBUG, var->getBool());
+
+	return true;
+}
+
 #ifdef DEBUG
-	CVar gc_debug("gc_debug", "1", CFLAG_USER);
+	CVar gc_debug("gc_debug", "1", CFLAG_USER, (CVarCallBackFn)&gc_debug_cb);
 	CVar gc_showerror("gc_showerror", "1", CFLAG_USER);
 #else
-	CVar gc_debug("gc_debug", "0", CFLAG_USER);
+	CVar gc_debug("gc_debug", "0", CFLAG_USER, (CVarCallBackFn)&gc_debug_cb);
 	CVar gc_showerror("gc_showerror", "0", CFLAG_USER);
 #endif
 
@@ -88,14 +101,9 @@ void LoggingapplyTheme()
 
 void InitLogging()
 {
-	LogCallback::MessageFn messageFn = [&](MSG_TYPE type, const char* szMessage, Color *pColor, std::map<std::string, std::string> *pmArgs)
+	//Runs on the log writer thread
+	Thread::LogWriterThread::SinkFn sinkFn = [](MSG_TYPE type, const char* szMessage, Color *pColor)
 	{
-		if (type == MT_TRACE)
-		{
-			Console::trace(szMessage, pmArgs);
-			return;
-		}
-
 		if (!g_pConsole)
 			return;
 
@@ -117,6 +125,25 @@ void InitLogging()
 		}
 	};
 
+	LogCallback::MessageFn messageFn = [](MSG_TYPE type, const char* szMessage, Color *pColor, std::map<std::string, std::string> *pmArgs)
+	{
+		if (type == MT_TRACE)
+		{
+			Console::trace(szMessage, pmArgs);
+			return;
+		}
+
+		if (!g_pLogWriter || Console::isThreadIgnored())
+			return;
+
+		g_pLogWriter->push(type, szMessage, pColor);
+	};
+
+	LogCallback::TraceFn traceFn = [](const TraceEvent &event)
+	{
+		Console::trace(event);
+	};
+
 
 	if (g_pConsole)
 		safe_delete(g_pConsole);
@@ -125,10 +152,16 @@ void InitLogging()
 
 	Msg("UICore Logging Started\n");
 
+	safe_delete(g_pLogWriter);
 	safe_delete(g_pLogCallback);
 
+	g_pLogWriter = new Thread::LogWriterThread(gcString(UTIL::OS::getAppDataPath(L"desura_log.txt")).c_str(), sinkFn);
+	g_pLogWriter->start();
+
 	g_pLogCallback = new LogCallback();
 	g_pLogCallback->RegMsg(messageFn);
+	g_pLogCallback->RegTrace(traceFn);
+	g_pLogCallback->setEnabled(MT_DEBUG, gc_debug.getBool());
 
 	RegDLLCB_MCF(g_pLogCallback);
 	RegDLLCB_WEBCORE(g_pLogCallback);
@@ -142,13 +175,16 @@ void RegLogWithWindow()
 
 void DestroyLogging()
 {
-	g_pConsole->Destroy();
-	g_pConsole = nullptr;
-
 	RegDLLCB_MCF(nullptr);
 	RegDLLCB_WEBCORE(nullptr);
 	RegDLLCB_USERCORE(nullptr);
 
+	//flushes anything still queued to the console before it goes away
+	safe_delete(g_pLogWriter);
+
+	g_pConsole->Destroy();
+	g_pConsole = nullptr;
+
 	safe_delete(g_pLogCallback);
 }
 
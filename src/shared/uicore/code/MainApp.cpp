@@ -29,6 +29,7 @@ Contact us at legal@badjuju.com.
 #include "wx/window.h"
 #include "Managers.h"
 #include "Log.h"
+#include "Metrics.h"
 #include <branding/uicore_version.h>
 #include "mcfcore/MCFMain.h"
 
@@ -351,6 +352,7 @@ MainApp::~MainApp()
 	g_pUserHandle = nullptr;
 	safe_delete(m_wxTBIcon);
 
+	DestroyMetrics();
 	DestroyManagers();
 	DestroyLogging();
 
@@ -404,6 +406,7 @@ void MainApp::Init(int argc, wxCmdLineArgsArray &argv)
 
 	InitManagers();
 	InitLocalManagers();
+	InitMetrics();
 
 	std::string val = UTIL::OS::getConfigValue(REGRUN);
 	gc_autostart.setValue( val.size() > 0 );
@@ -233,6 +233,9 @@ bool autoStartChange(CVar* var, const char* val);
 bool forceShortcutChange(CVar* var, const char* val);
 bool OnLinuxBinChange(CVar* var, const char* val);
 bool OnLinuxArgsChange(CVar* var, const char* val);
+bool OnBandwidthDownloadChange(CVar* var, const char* val);
+bool OnBandwidthUploadChange(CVar* var, const char* val);
+bool OnBackgroundModeChange(CVar* var, const char* val);
 
 CVar gc_corecount("gc_corecount", "0", 0, (CVarCallBackFn)&corecountChange);
 CVar gc_cleanmcf("gc_cleanmcf", "0", 0);
@@ -250,8 +253,16 @@ CVar gc_disable_forceupdate_shortcut("gc_disable_forceupdate_shortcut", "0", CVA
 CVar gc_linux_launch_globalbin("gc_linux_launch_globalbin", "", CVAR_LINUX_ONLY, (CVarCallBackFn)&OnLinuxBinChange);
 CVar gc_linux_launch_globalargs("gc_linux_launch_globalargs", "", CVAR_LINUX_ONLY, (CVarCallBackFn)&OnLinuxArgsChange);
 CVar gc_safe_uploads("gc_safe_uploads", "0", CFLAG_USER);
+CVar gc_upload_connections("gc_upload_connections", "3", CFLAG_USER);
 
 CVar gc_mcfcreate_nopatch("gc_mcfcreate_nopatch", "0", CFLAG_USER);
+CVar gc_mcfcreate_reuse("gc_mcfcreate_reuse", "1", CFLAG_USER);
+CVar gc_mcfcreate_reuse_hash("gc_mcfcreate_reuse_hash", "0", CFLAG_USER);
+CVar gc_updatepoll_delta("gc_updatepoll_delta", "1", CFLAG_USER);
+CVar gc_background_mode("gc_background_mode", "1", CFLAG_USER, (CVarCallBackFn)&OnBackgroundModeChange);
+CVar gc_background_io_limit("gc_background_io_limit", "8192", CFLAG_USER, (CVarCallBackFn)&OnBackgroundModeChange);
+CVar gc_bandwidth_download("gc_bandwidth_download", "0", CFLAG_USER, (CVarCallBackFn)&OnBandwidthDownloadChange);
+CVar gc_bandwidth_upload("gc_bandwidth_upload", "0", CFLAG_USER, (CVarCallBackFn)&OnBandwidthUploadChange);
 
 #ifdef DESURA_OFFICIAL_BUILD
 
@@ -306,6 +317,45 @@ bool OnLinuxArgsChange(CVar* var, const char* val)
 	return true;
 }
 
+//usercore shares its limiter with webcore and mcfcore so this covers all transfers
+static UTIL::WEB::BandwidthLimiter* GetUserCoreBandwidthLimiter()
+{
+	return (UTIL::WEB::BandwidthLimiter*)UserCore::FactoryBuilderUC(USERCORE_BANDWIDTHLIMITER);
+}
+
+bool OnBandwidthDownloadChange(CVar* var, const char* val)
+{
+	auto pLimiter = GetUserCoreBandwidthLimiter();
+
+	if (pLimiter)
+		pLimiter->setDownloadLimit((uint64)Safe::atoi(val) * 1024);
+
+	return true;
+}
+
+bool OnBandwidthUploadChange(CVar* var, const char* val)
+{
+	auto pLimiter = GetUserCoreBandwidthLimiter();
+
+	if (pLimiter)
+		pLimiter->setUploadLimit((uint64)Safe::atoi(val) * 1024);
+
+	return true;
+}
+
+bool OnBackgroundModeChange(CVar* var, const char* val)
+{
+	//force the value to be set
+	var->setValue(val);
+
+	auto userCore = GetUserCore();
+
+	if (userCore)
+		userCore->refreshBackgroundMode();
+
+	return true;
+}
+
 bool forceShortcutChange(CVar* var, const char* val)
 {
 	gcString v(val);
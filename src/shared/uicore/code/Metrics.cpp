@@ -0,0 +1,179 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "Metrics.h"
+
+#include "util/UtilMetrics.h"
+#include "usercore/UserCoreI.h"
+
+extern "C" UTIL::METRICS::Registry* GetMCFCoreMetrics();
+
+CVar gc_metrics_interval("gc_metrics_interval", "0", CFLAG_USER);
+
+
+typedef std::map<std::string, UTIL::METRICS::Snapshot> ModuleSnapshots;
+
+//each dll has its own registry so we collect them all here
+static void SnapshotModules(ModuleSnapshots &mSnapshots)
+{
+	UTIL::METRICS::GetRegistry().snapshot(mSnapshots["uicore"]);
+
+	auto pMcfCore = GetMCFCoreMetrics();
+
+	if (pMcfCore)
+		pMcfCore->snapshot(mSnapshots["mcfcore"]);
+
+	auto pUserCore = (UTIL::METRICS::Registry*)UserCore::FactoryBuilderUC(USERCORE_METRICS);
+
+	if (pUserCore)
+		pUserCore->snapshot(mSnapshots["usercore"]);
+}
+
+
+class MetricsWriterThread : public Thread::BaseThread
+{
+public:
+	MetricsWriterThread()
+		: Thread::BaseThread("Metrics Writer")
+		, m_szPath(UTIL::OS::getAppDataPath(L"desura_metrics.json"))
+	{
+	}
+
+	~MetricsWriterThread()
+	{
+		stop();
+	}
+
+protected:
+	void run() override
+	{
+		ModuleSnapshots mLast;
+		auto lastTime = std::chrono::steady_clock::now();
+
+		while (!isStopped())
+		{
+			int nInterval = gc_metrics_interval.getInt();
+
+			//disabled, check again later incase it gets turned on
+			if (nInterval <= 0)
+			{
+				m_WaitCond.wait(5);
+				continue;
+			}
+
+			m_WaitCond.wait(nInterval);
+
+			if (isStopped())
+				break;
+
+			ModuleSnapshots mCurrent;
+			SnapshotModules(mCurrent);
+
+			auto now = std::chrono::steady_clock::now();
+			double dSeconds = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTime).count() / 1000.0;
+
+			writeFile(mCurrent, mLast, dSeconds);
+
+			mLast.swap(mCurrent);
+			lastTime = now;
+		}
+	}
+
+	void onStop() override
+	{
+		m_WaitCond.notify();
+	}
+
+	void writeFile(const ModuleSnapshots &mCurrent, const ModuleSnapshots &mLast, double dSeconds)
+	{
+		std::string strJson = gcString("{ \"interval\": {0}, \"modules\": { ", dSeconds);
+		bool bFirst = true;
+
+		for (auto &m : mCurrent)
+		{
+			if (!bFirst)
+				strJson += ", ";
+
+			bFirst = false;
+
+			auto it = mLast.find(m.first);
+			const UTIL::METRICS::Snapshot* pLast = (it != mLast.end()) ? &it->second : nullptr;
+
+			strJson += gcString("\"{0}\": ", m.first);
+			m.second.toJson(strJson, pLast, dSeconds);
+		}
+
+		strJson += " } }\n";
+
+		try
+		{
+			UTIL::FS::FileHandle fh(m_szPath.c_str(), UTIL::FS::FILE_WRITE);
+			fh.write(strJson.c_str(), strJson.size());
+		}
+		catch (gcException &e)
+		{
+			Warning("Failed to write metrics file: {0}\n", e);
+		}
+	}
+
+private:
+	const gcString m_szPath;
+	Thread::WaitCondition m_WaitCond;
+};
+
+static MetricsWriterThread* g_pMetricsWriter = nullptr;
+
+void InitMetrics()
+{
+	safe_delete(g_pMetricsWriter);
+
+	g_pMetricsWriter = new MetricsWriterThread();
+	g_pMetricsWriter->start();
+}
+
+void DestroyMetrics()
+{
+	safe_delete(g_pMetricsWriter);
+}
+
+CONCOMMAND(cc_metrics, "metrics")
+{
+	const char* szFilter = nullptr;
+
+	if (vArgList.size() > 1)
+		szFilter = vArgList[1].c_str();
+
+	ModuleSnapshots mSnapshots;
+	SnapshotModules(mSnapshots);
+
+	for (auto &m : mSnapshots)
+	{
+		std::string strOut;
+		m.second.toText(strOut, szFilter);
+
+		if (strOut.empty())
+			continue;
+
+		Msg(gcString("-- {0} --\n", m.first));
+		Msg("{0}", strOut);
+	}
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+
+#include "util/UtilTimeline.h"
+#include "usercore/UserCoreI.h"
+
+extern "C" UTIL::TIMELINE::Timeline* GetMCFCoreTimeline();
+
+static void GetModuleTimelines(std::vector<UTIL::TIMELINE::Timeline*> &vTimelines)
+{
+	vTimelines.push_back(&UTIL::TIMELINE::GetTimeline());
+	vTimelines.push_back(GetMCFCoreTimeline());
+	vTimelines.push_back((UTIL::TIMELINE::Timeline*)UserCore::FactoryBuilderUC(USERCORE_TIMELINE));
+}
+
+bool OnTimelineChange(CVar* var, const char* val)
+{
+	gcString strVal(val);
+	bool bEnabled = (strVal == "1" || strVal == "true");
+
+	std::vector<UTIL::TIMELINE::Timeline*> vTimelines;
+	GetModuleTimelines(vTimelines);
+
+	for (auto pTimeline : vTimelines)
+	{
+		if (pTimeline)
+			pTimeline->setEnabled(bEnabled);
+	}
+
+	return true;
+}
+
+//Service picks this up at the start of its next task
+CVar gc_timeline("gc_timeline", "0", CFLAG_USER, (CVarCallBackFn)&OnTimelineChange);
+
+CONCOMMAND(cc_timeline_dump, "timeline_dump")
+{
+	gcString strPath;
+
+	if (vArgList.size() > 1)
+		strPath = vArgList[1];
+	else
+		strPath = gcString(UTIL::OS::getAppDataPath(L"desura_timeline.json"));
+
+	std::vector<UTIL::TIMELINE::Timeline*> vTimelines;
+	GetModuleTimelines(vTimelines);
+
+	auto strTrace = UTIL::TIMELINE::FormatChromeTrace(vTimelines);
+
+	try
+	{
+		UTIL::FS::FileHandle fh(strPath.c_str(), UTIL::FS::FILE_WRITE);
+		fh.write(strTrace.c_str(), strTrace.size());
+
+		Msg("Timeline written to {0}. Open it with chrome://tracing\n", strPath);
+	}
+	catch (gcException &e)
+	{
+		Warning("Failed to write timeline: {0}\n", e);
+	}
+}
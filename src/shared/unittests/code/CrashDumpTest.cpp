@@ -23,6 +23,24 @@ Contact us at legal@badjuju.com.
 #include "CrashuploaderShared.cpp"
 
 #include "Tracer.cpp"
+#include "TracerReader.cpp"
+
+#include <chrono>
+
+namespace UnitTest
+{
+	class TracedClass
+	{
+	public:
+		uint32 m_nStage = 0;
+	};
+}
+
+template <>
+std::string TraceClassInfo(UnitTest::TracedClass *pClass)
+{
+	return gcString("stage: {0}", pClass->m_nStage);
+}
 
 namespace UnitTest
 {
@@ -107,5 +125,163 @@ namespace UnitTest
 		}
 	}
 
+	TEST(TracerReader, readsNewestRecordsInOrderAfterWrap)
+	{
+		TracerStorage tracer(L"TracerReader_TEST");
+		TracerReader reader(gcString(tracer.getSharedMemName()));
+
+		ASSERT_TRUE(reader.isValid());
+
+		//Wrap the ring a bit more than once
+		const uint32 nTotal = 4096 + 100;
+
+		for (uint32 x = 1; x <= nTotal; ++x)
+			tracer.trace(gcString("{0}", x), nullptr);
+
+		std::vector<uint32> vSeen;
+
+		uint32 nLast = reader.read(0, [&vSeen](const TracerRecord &record)
+		{
+			vSeen.push_back(Safe::atoi(record.m_strMessage.c_str()));
+		});
+
+		ASSERT_EQ(nTotal, nLast);
+		ASSERT_EQ(4096u, vSeen.size());
+		ASSERT_EQ(nTotal - 4096 + 1, vSeen.front());
+		ASSERT_EQ(nTotal, vSeen.back());
+
+		for (size_t x = 1; x < vSeen.size(); ++x)
+			ASSERT_EQ(vSeen[x - 1] + 1, vSeen[x]);
+
+		//Following only returns new records
+		tracer.trace("next", nullptr);
+		vSeen.clear();
+
+		std::vector<std::string> vMessages;
+		nLast = reader.read(nLast, [&vMessages](const TracerRecord &record)
+		{
+			vMessages.push_back(record.m_strMessage);
+		});
+
+		ASSERT_EQ(nTotal + 1, nLast);
+		ASSERT_EQ(1u, vMessages.size());
+		ASSERT_EQ("next", vMessages[0]);
+	}
+
+	TEST(TracerReader, dropsArgsThatDontFit)
+	{
+		TracerStorage tracer(L"TracerReader_TEST");
+		TracerReader reader(gcString(tracer.getSharedMemName()));
+
+		std::map<std::string, std::string> mArgs;
+		mArgs["a"] = "small";
+		mArgs["b"] = std::string(600, 'b');
+		mArgs["c"] = "";
+
+		tracer.trace(std::string(1000, 'm'), nullptr);
+		tracer.trace("message", &mArgs);
+
+		std::vector<TracerRecord> vRecords;
+		reader.read(0, [&vRecords](const TracerRecord &record)
+		{
+			vRecords.push_back(record);
+		});
+
+		ASSERT_EQ(2u, vRecords.size());
+		ASSERT_GT(vRecords[0].m_strMessage.size(), 400u);
+		ASSERT_LT(vRecords[0].m_strMessage.size(), 512u);
+
+		ASSERT_EQ("message", vRecords[1].m_strMessage);
+		ASSERT_EQ(1u, vRecords[1].m_vArgs.size());
+		ASSERT_EQ("a", vRecords[1].m_vArgs[0].first);
+		ASSERT_EQ("small", vRecords[1].m_vArgs[0].second);
+	}
+
+	TEST(TracerReader, formatsRawRecords)
+	{
+		TracerStorage tracer(L"TracerReader_TEST");
+		TracerReader reader(gcString(tracer.getSharedMemName()));
+
+		TracedClass traced;
+		traced.m_nStage = 3;
+
+		TraceEvent event;
+		event.szFunction = "ItemHandle::onComplete";
+		event.szModule = nullptr;
+		event.pClass = &traced;
+		event.pfnClassInfo = &TraceClassInfoThunk<TracedClass>;
+		event.nThreadId = 42;
+		event.nTick = GetTraceTick();
+		event.szMessage = "done \"ok\"";
+		event.nMessageLen = (uint32)strlen(event.szMessage);
+
+		tracer.traceRaw(event);
+
+		std::map<std::string, std::string> mArgs;
+		mArgs["key \"q\""] = "v";
+		tracer.trace("text", &mArgs);
+
+		std::vector<TracerRecord> vRecords;
+		reader.read(0, [&vRecords](const TracerRecord &record)
+		{
+			vRecords.push_back(record);
+		});
+
+		ASSERT_EQ(2u, vRecords.size());
+
+		auto &raw = vRecords[0];
+		ASSERT_TRUE(raw.m_bRaw);
+		ASSERT_EQ("ItemHandle::onComplete", raw.m_strFunction);
+		ASSERT_EQ(42u, raw.m_nThreadId);
+		ASSERT_EQ("stage: 3", raw.m_strClassInfo);
+
+		//Tick is turned back into wall time by the reader
+		uint64 nNow = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		ASSERT_LT(nNow - raw.m_nTime, 10000000u);
+
+		std::string strJson;
+		raw.formatJson(strJson);
+
+		std::string strExpectedStart = "{ \"message\": \"done \\\"ok\\\"\", \"function\": \"ItemHandle::onComplete\", \"classinfo\": \"stage: 3\", \"thread\": \"42\", \"time\": \"";
+		ASSERT_EQ(strExpectedStart, strJson.substr(0, strExpectedStart.size()));
+
+		ASSERT_FALSE(vRecords[1].m_bRaw);
+
+		strJson.clear();
+		vRecords[1].formatJson(strJson);
+		ASSERT_EQ("{ \"message\": \"text\", \"key \\\"q\\\"\": \"v\" }", strJson);
+	}
+
+	TEST(TracerStorage, Benchmark)
+	{
+		TracerStorage tracer(L"TracerStorage_Benchmark_TEST");
+
+		const uint32 nIterations = 1000000;
+		std::string strMessage("Item install completed for 2533274790395905");
+
+		TraceEvent event;
+		event.szFunction = "ItemHandle::onComplete";
+		event.szModule = nullptr;
+		event.pClass = &tracer;
+		event.pfnClassInfo = nullptr;
+		event.nThreadId = 140234511234;
+		event.szMessage = strMessage.c_str();
+		event.nMessageLen = (uint32)strMessage.size();
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint32 x = 0; x < nIterations; ++x)
+		{
+			event.nTick = GetTraceTick();
+			tracer.traceRaw(event);
+		}
+
+		auto end = std::chrono::steady_clock::now();
+		auto nNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / nIterations;
+
+		RecordProperty("TraceNsPerCall", (int)nNs);
+		EXPECT_LT(nNs, 200);
+	}
+
 #endif
 }
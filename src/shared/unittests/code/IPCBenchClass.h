@@ -0,0 +1,239 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#ifndef DESURA_IPCBENCHCLASS_H
+#define DESURA_IPCBENCHCLASS_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "IPCClass.h"
+#include "IPCManager.h"
+#include "IPCPipeServer.h"
+#include "IPCPipeClient.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+
+//! Ipc class used by the benchmarks in the unit tests and ipc_bench. Both ends use this class.
+//! Events are linked and registered under the same name but to different Event objects so they
+//! only travel one way per side.
+//!
+//! Header only so the tools dont need a test library, users must REG_IPC_CLASS(IPCBenchClass) once.
+//!
+class IPCBenchClass : public IPC::IPCClass
+{
+public:
+	IPCBenchClass(IPC::IPCManager* mang, uint32 id, DesuraId itemId)
+		: IPC::IPCClass(mang, id, itemId)
+		, m_nEventCount(0)
+	{
+		registerFunctions();
+	}
+
+	//! Remote side
+	uint32 ping(uint32 val)
+	{
+		return val;
+	}
+
+	void notify(uint32 val)
+	{
+	}
+
+	void pause()
+	{
+	}
+
+	bool start(const char* mcfPath, const char* installPath, uint32 workers, bool delFiles)
+	{
+		return mcfPath && installPath && strlen(installPath) == workers && delFiles;
+	}
+
+	uint32 blobSize(IPC::PBlob blob)
+	{
+		return blob.getSize();
+	}
+
+	uint32 namedBlobSize(const char* name, IPC::PBlob blob)
+	{
+		return name ? strlen(name) + blob.getSize() : 0;
+	}
+
+	void fireEvents(uint32 count)
+	{
+		for (uint32 x = 0; x < count; ++x)
+		{
+			uint32 val = x;
+			onTickSend(val);
+		}
+	}
+
+	//! Local side
+	uint32 sendPing(uint32 val)
+	{
+		return IPC::functionCall<uint32>(this, "ping", val);
+	}
+
+	std::future<uint32> sendPingFuture(uint32 val)
+	{
+		return IPC::functionCallFuture<uint32>(this, "ping", val);
+	}
+
+	void sendNotify(uint32 val)
+	{
+		IPC::functionCallAsync(this, "notify", val);
+	}
+
+	void sendPause()
+	{
+		IPC::functionCallV(this, "pause");
+	}
+
+	bool sendStart(const char* mcfPath, const char* installPath, uint32 workers, bool delFiles)
+	{
+		return IPC::functionCall<bool>(this, "start", mcfPath, installPath, workers, delFiles);
+	}
+
+	uint32 sendBlob(const IPC::PBlob &blob)
+	{
+		return IPC::functionCall<uint32>(this, "blobSize", blob);
+	}
+
+	uint32 sendNamedBlob(const char* name, const IPC::PBlob &blob)
+	{
+		return IPC::functionCall<uint32>(this, "namedBlobSize", name, blob);
+	}
+
+	void sendFireEvents(uint32 count)
+	{
+		IPC::functionCallAsync(this, "fireEvents", count);
+	}
+
+	//! Waits until count events from the other side have arrived since the last reset
+	//!
+	//! @return false on timeout
+	//!
+	bool waitForEvents(uint32 count, uint32 nTimeoutMs)
+	{
+		std::unique_lock<std::mutex> lock(m_EventLock);
+
+		return m_EventCond.wait_for(lock, std::chrono::milliseconds(nTimeoutMs), [this, count](){
+			return m_nEventCount >= count;
+		});
+	}
+
+	void resetEvents()
+	{
+		m_nEventCount = 0;
+	}
+
+	Event<uint32> onTickSend;
+	Event<uint32> onTickRecv;
+
+protected:
+	void registerFunctions()
+	{
+		REG_FUNCTION(IPCBenchClass, ping);
+		REG_FUNCTION_VOID(IPCBenchClass, notify);
+		REG_FUNCTION_VOID(IPCBenchClass, pause);
+		REG_FUNCTION(IPCBenchClass, start);
+		REG_FUNCTION(IPCBenchClass, blobSize);
+		REG_FUNCTION(IPCBenchClass, namedBlobSize);
+		REG_FUNCTION_VOID(IPCBenchClass, fireEvents);
+
+		LINK_EVENT(onTickSend, uint32);
+		registerEvent(IPC::IPCEventHandle(&onTickRecv), "onTickSend");
+
+		onTickRecv += delegate(this, &IPCBenchClass::onTick);
+	}
+
+	void onTick(uint32 &val)
+	{
+		++m_nEventCount;
+
+		std::lock_guard<std::mutex> guard(m_EventLock);
+		m_EventCond.notify_all();
+	}
+
+private:
+	std::atomic<uint32> m_nEventCount;
+
+	std::mutex m_EventLock;
+	std::condition_variable m_EventCond;
+};
+
+
+//! A server and a client in this process connected to each other for benchmarking
+//!
+class IPCBenchPipes
+{
+public:
+	IPCBenchPipes(const char* szName)
+		: m_szName(szName)
+		, m_Server(m_szName.c_str(), 1)
+		, m_Client(m_szName.c_str())
+	{
+		m_Server.start();
+
+		//Server sets up its end on its own thread, give it up to a second
+		for (int x = 0; x < 50; x++)
+		{
+			try
+			{
+				m_Client.setUpPipes();
+				break;
+			}
+			catch (gcException &)
+			{
+				gcSleep(20);
+			}
+		}
+
+		m_Client.start();
+	}
+
+	//! Sets the shared memory threshold on both ends, 0 keeps everything on the pipe
+	//!
+	void setSharedPayloadThreshold(uint32 nThreshold)
+	{
+		m_Client.setSharedPayloadThreshold(nThreshold);
+		m_Server.getManager(0)->setSharedPayloadThreshold(nThreshold);
+	}
+
+	std::shared_ptr<IPCBenchClass> newClass()
+	{
+		auto bench = IPC::CreateIPCClass<IPCBenchClass>(&m_Client, "IPCBenchClass");
+
+		if (!bench)
+			throw gcException(ERR_IPC, "Failed to create benchmark ipc class");
+
+		return bench;
+	}
+
+private:
+	gcString m_szName;
+	IPC::PipeServer m_Server;
+	IPC::PipeClient m_Client;
+};
+
+#endif //DESURA_IPCBENCHCLASS_H
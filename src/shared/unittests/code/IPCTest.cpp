@@ -22,6 +22,8 @@ Contact us at legal@badjuju.com.
 #include "IPCClass.h"
 #include "IPCParameterI.h"
 
+#include <thread>
+
 using namespace IPC;
 using namespace testing;
 
@@ -228,6 +230,7 @@ public:
 
 		REG_FUNCTION(IPCClassFixture, uint32FunctionCB);
 		REG_FUNCTION_VOID(IPCClassFixture, voidFunctionCB);
+		REG_FUNCTION(IPCClassFixture, mixedFunctionCB);
 
 		uint32EventCB += delegate(this, &IPCClassFixture::onUint32EventCB);
 		voidEventCB += delegate(this, &IPCClassFixture::onVoidEventCB);
@@ -244,6 +247,7 @@ public:
 
 	MOCK_METHOD0(uint32FunctionCB, uint32());
 	MOCK_METHOD0(voidFunctionCB, void());
+	MOCK_METHOD6(mixedFunctionCB, uint64(const char*, const char*, uint8, bool, double, uint64));
 
 	uint32 callUint32Function()
 	{
@@ -255,9 +259,25 @@ public:
 		IPC::functionCallV(this, "voidFunctionCB");
 	}
 
+	uint64 callMixedFunction(const char* a, const char* b, uint8 c, bool d, double e, uint64 f)
+	{
+		return IPC::functionCall<uint64>(this, "mixedFunctionCB", a, b, c, d, e, f);
+	}
+
+	std::future<uint32> callUint32FunctionFuture()
+	{
+		return IPC::functionCallFuture<uint32>(this, "uint32FunctionCB");
+	}
+
+	std::future<void> callVoidFunctionFuture()
+	{
+		return IPC::functionCallFuture<void>(this, "voidFunctionCB");
+	}
+
 	void sendMessage(const char* buff, uint32 size, uint32 id, uint8 type) override
 	{
-		messageRecived(type, buff, size);
+		if (!m_bDropMessages)
+			messageRecived(type, buff, size);
 	}
 
 	void sendLoopbackMessage(const char* buff, uint32 size, uint32 id, uint8 type) override
@@ -278,6 +298,8 @@ public:
 	{
 		return std::shared_ptr<IPCClass>();
 	}
+
+	bool m_bDropMessages = false;
 };
 
 TEST_F(IPCClassFixture, FullUint32Func)
@@ -292,6 +314,60 @@ TEST_F(IPCClassFixture, FullVoidFunc)
 	callVoidFunction();
 }
 
+TEST_F(IPCClassFixture, FullMixedFunc)
+{
+	EXPECT_CALL(*this, mixedFunctionCB(StrEq("a string"), IsNull(), 7, true, 0.5, 1ull << 40)).Times(1).WillOnce(Return(456));
+	EXPECT_EQ(456, callMixedFunction("a string", nullptr, 7, true, 0.5, 1ull << 40));
+}
+
+TEST_F(IPCClassFixture, FutureUint32Func)
+{
+	EXPECT_CALL(*this, uint32FunctionCB()).Times(1).WillOnce(Return(123));
+	EXPECT_EQ(123, callUint32FunctionFuture().get());
+}
+
+TEST_F(IPCClassFixture, FutureVoidFuncException)
+{
+	EXPECT_CALL(*this, voidFunctionCB()).Times(1).WillOnce(Throw(gcException(ERR_INVALID, "bad call")));
+
+	auto future = callVoidFunctionFuture();
+	EXPECT_THROW(future.get(), gcException);
+}
+
+TEST_F(IPCClassFixture, FutureCancelledOnDisconnect)
+{
+	EXPECT_CALL(*this, uint32FunctionCB()).Times(0);
+
+	m_bDropMessages = true;
+	auto future = callUint32FunctionFuture();
+
+	EXPECT_EQ(std::future_status::timeout, future.wait_for(std::chrono::milliseconds(0)));
+
+	gcException e(ERR_PIPE, "Pipe Disconnected. IPC Failed.");
+	cancelLocks(e);
+
+	EXPECT_THROW(future.get(), gcException);
+}
+
+TEST_F(IPCClassFixture, FutureFailsAfterTimeout)
+{
+	EXPECT_CALL(*this, uint32FunctionCB()).Times(0);
+
+	setCallbackTimeout(10);
+
+	m_bDropMessages = true;
+	auto future = callUint32FunctionFuture();
+
+	expireLocks();
+	EXPECT_EQ(std::future_status::timeout, future.wait_for(std::chrono::milliseconds(0)));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	expireLocks();
+
+	EXPECT_EQ(std::future_status::ready, future.wait_for(std::chrono::milliseconds(0)));
+	EXPECT_THROW(future.get(), gcException);
+}
+
 TEST_F(IPCClassFixture, FullUint32Event)
 {
 	EXPECT_CALL(*this, onUint32EventCB(Eq(123))).Times(1);
@@ -562,3 +638,460 @@ TEST_F(IPCClassFixturePart, partBuffer_3)
 
 	call(2, "hello", 123, a, 45);
 }
+
+
+#ifdef NIX
+#include "IPCBenchClass.h"
+#include "IPCSharedPayload.h"
+#include <atomic>
+#include <chrono>
+
+REG_IPC_CLASS(IPCBenchClass);
+
+//! Real server and client talking over the unix socket transport
+class IPCBenchFixture : public ::testing::Test
+{
+public:
+	IPCBenchFixture()
+		: m_Pipes(gcString("unittest-bench-{0}", getpid()).c_str())
+	{
+	}
+
+	double runBench(uint32 threshold, const std::vector<char> &vData, uint32 nCalls)
+	{
+		m_Pipes.setSharedPayloadThreshold(threshold);
+
+		auto bench = m_Pipes.newClass();
+		PBlob blob(&vData[0], vData.size());
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint32 x=0; x<nCalls; x++)
+			EXPECT_EQ(vData.size(), bench->sendBlob(blob));
+
+		std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+		return (vData.size() * (double)nCalls / (1024.0 * 1024.0)) / secs.count();
+	}
+
+	IPCBenchPipes m_Pipes;
+};
+
+TEST_F(IPCBenchFixture, LargeBlobThroughput)
+{
+	//Part messages only count to 255 so stay under 1mb for the pipe path
+	std::vector<char> vData(512 * 1024, 'd');
+
+	double pipeMbs = runBench(0, vData, 20);
+	double sharedMbs = runBench(IPC_SHAREDPAYLOAD_THRESHOLD, vData, 20);
+
+	RecordProperty("pipe_mb_per_sec", gcString("{0}", (uint32)pipeMbs));
+	RecordProperty("shared_mb_per_sec", gcString("{0}", (uint32)sharedMbs));
+}
+
+//Shared payloads are dispatched in place and string args get terminated where they lie
+TEST_F(IPCBenchFixture, SharedPayloadWithString)
+{
+	m_Pipes.setSharedPayloadThreshold(IPC_SHAREDPAYLOAD_THRESHOLD);
+
+	auto bench = m_Pipes.newClass();
+
+	std::vector<char> vData(IPC_SHAREDPAYLOAD_THRESHOLD * 2, 'd');
+	PBlob blob(&vData[0], vData.size());
+
+	const char* szName = "some/file.mcf";
+
+	for (uint32 x=0; x<5; x++)
+		EXPECT_EQ(strlen(szName) + vData.size(), bench->sendNamedBlob(szName, blob));
+}
+
+TEST_F(IPCBenchFixture, SmallMessageBurst)
+{
+	auto bench = m_Pipes.newClass();
+
+	const uint32 nRounds = 200;
+	const uint32 nBurst = 20;
+
+	std::vector<double> vLatency;
+	auto start = std::chrono::steady_clock::now();
+
+	//bursts of async calls like progress events, each followed by a call that has to wait behind them
+	for (uint32 x=0; x<nRounds; x++)
+	{
+		for (uint32 y=0; y<nBurst; y++)
+			bench->sendNotify(y);
+
+		auto callStart = std::chrono::steady_clock::now();
+		EXPECT_EQ(x, bench->sendPing(x));
+
+		std::chrono::duration<double, std::micro> us = std::chrono::steady_clock::now() - callStart;
+		vLatency.push_back(us.count());
+	}
+
+	std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+	std::sort(begin(vLatency), end(vLatency));
+
+	double msgsPerSec = (nRounds * (nBurst + 1)) / secs.count();
+	double p99 = vLatency[vLatency.size() * 99 / 100];
+
+	RecordProperty("msgs_per_sec", gcString("{0}", (uint32)msgsPerSec));
+	RecordProperty("p99_us", gcString("{0}", (uint32)p99));
+}
+
+TEST_F(IPCBenchFixture, SmallCallRate)
+{
+	auto bench = m_Pipes.newClass();
+
+	const uint32 nCalls = 5000;
+
+	//no argument calls like IPCInstallMcf::pause
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32 x=0; x<nCalls; x++)
+		bench->sendPause();
+
+	std::chrono::duration<double> pauseSecs = std::chrono::steady_clock::now() - start;
+
+	//a few strings and scalars like IPCInstallMcf::start
+	const char* szMcfPath = "/home/user/.desura/cache/mcfstore/1234/5678.mcf";
+	const char* szInstallPath = "/home/user/desura/games/something";
+
+	start = std::chrono::steady_clock::now();
+
+	for (uint32 x=0; x<nCalls; x++)
+		EXPECT_TRUE(bench->sendStart(szMcfPath, szInstallPath, strlen(szInstallPath), true));
+
+	std::chrono::duration<double> startSecs = std::chrono::steady_clock::now() - start;
+
+	double pausePerSec = nCalls / pauseSecs.count();
+	double startPerSec = nCalls / startSecs.count();
+
+	RecordProperty("pause_calls_per_sec", gcString("{0}", (uint32)pausePerSec));
+	RecordProperty("start_calls_per_sec", gcString("{0}", (uint32)startPerSec));
+}
+
+TEST_F(IPCBenchFixture, PipelinedCalls)
+{
+	auto bench = m_Pipes.newClass();
+
+	const uint32 nCalls = 5000;
+	const uint32 nInFlight = 32;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32 x=0; x<nCalls; x++)
+		EXPECT_EQ(x, bench->sendPing(x));
+
+	std::chrono::duration<double> blockingSecs = std::chrono::steady_clock::now() - start;
+
+	std::deque<std::pair<uint32, std::future<uint32>>> dqPending;
+	start = std::chrono::steady_clock::now();
+
+	for (uint32 x=0; x<nCalls; x++)
+	{
+		if (dqPending.size() == nInFlight)
+		{
+			EXPECT_EQ(dqPending.front().first, dqPending.front().second.get());
+			dqPending.pop_front();
+		}
+
+		dqPending.push_back(std::make_pair(x, bench->sendPingFuture(x)));
+	}
+
+	for (auto &p : dqPending)
+		EXPECT_EQ(p.first, p.second.get());
+
+	std::chrono::duration<double> pipelinedSecs = std::chrono::steady_clock::now() - start;
+
+	double blockingPerSec = nCalls / blockingSecs.count();
+	double pipelinedPerSec = nCalls / pipelinedSecs.count();
+
+	RecordProperty("blocking_calls_per_sec", gcString("{0}", (uint32)blockingPerSec));
+	RecordProperty("pipelined_calls_per_sec", gcString("{0}", (uint32)pipelinedPerSec));
+}
+
+//! Several clients on one server each get their own pipe instance, calls and events must not cross over
+TEST(IPCMultiClient, ClientsAreRoutedSeparately)
+{
+	gcString name("unittest-multi-{0}", getpid());
+
+	const uint32 nClients = 3;
+
+	IPC::PipeServer server(name.c_str(), nClients);
+	server.start();
+
+	std::vector<std::unique_ptr<IPC::PipeClient>> vClients;
+	std::vector<std::shared_ptr<IPCBenchClass>> vBench;
+
+	for (uint32 x=0; x<nClients; x++)
+	{
+		std::unique_ptr<IPC::PipeClient> client(new IPC::PipeClient(name.c_str()));
+
+		//Server sets up its end on its own thread, give it up to a second
+		for (int y=0; y<50; y++)
+		{
+			try
+			{
+				client->setUpPipes();
+				break;
+			}
+			catch (gcException &)
+			{
+				gcSleep(20);
+			}
+		}
+
+		client->start();
+
+		auto bench = IPC::CreateIPCClass<IPCBenchClass>(client.get(), "IPCBenchClass");
+		ASSERT_TRUE(!!bench);
+
+		vClients.push_back(std::move(client));
+		vBench.push_back(bench);
+	}
+
+	//each client pings its own range at the same time, a reply routed to the wrong client would not match
+	std::vector<std::thread> vThreads;
+	std::atomic<uint32> nMismatched(0);
+
+	for (uint32 x=0; x<nClients; x++)
+	{
+		auto bench = vBench[x];
+
+		vThreads.push_back(std::thread([bench, x, &nMismatched]()
+		{
+			for (uint32 y=0; y<2000; y++)
+			{
+				uint32 val = x * 1000000 + y;
+
+				if (bench->sendPing(val) != val)
+					++nMismatched;
+			}
+		}));
+	}
+
+	for (auto &t : vThreads)
+		t.join();
+
+	EXPECT_EQ(0u, nMismatched);
+
+	//events fired by one server side class only reach the client that owns it
+	for (uint32 x=0; x<nClients; x++)
+		vBench[x]->sendFireEvents(x + 2);
+
+	for (uint32 x=0; x<nClients; x++)
+	{
+		EXPECT_TRUE(vBench[x]->waitForEvents(x + 2, 5000));
+		EXPECT_FALSE(vBench[x]->waitForEvents(x + 3, 100));
+	}
+
+	//losing one client leaves the others working
+	vBench[0].reset();
+	vClients[0].reset();
+
+	for (uint32 x=1; x<nClients; x++)
+		EXPECT_EQ(x, vBench[x]->sendPing(x));
+}
+
+//! Calls straight back into itself so only argument serialization and dispatch get timed
+class IPCDirectBenchClass : public IPCClass, protected IPCManagerI
+{
+public:
+	IPCDirectBenchClass()
+		: IPCClass(this, 0, DesuraId())
+	{
+		REG_FUNCTION_VOID(IPCDirectBenchClass, pause);
+		REG_FUNCTION(IPCDirectBenchClass, start);
+	}
+
+	void pause()
+	{
+	}
+
+	bool start(const char* mcfPath, const char* installPath, uint32 workers, bool delFiles)
+	{
+		return mcfPath && installPath && strlen(installPath) == workers && delFiles;
+	}
+
+	void sendPause()
+	{
+		IPC::functionCallV(this, "pause");
+	}
+
+	bool sendStart(const char* mcfPath, const char* installPath, uint32 workers, bool delFiles)
+	{
+		return IPC::functionCall<bool>(this, "start", mcfPath, installPath, workers, delFiles);
+	}
+
+protected:
+	void sendMessage(const char* buff, uint32 size, uint32 id, uint8 type) override
+	{
+		messageRecived(type, buff, size);
+	}
+
+	void sendLoopbackMessage(const char* buff, uint32 size, uint32 id, uint8 type) override
+	{
+		messageRecived(type, buff, size);
+	}
+
+	void destroyClass(IPCClass* obj) override
+	{
+	}
+
+	bool isDisconnected() override
+	{
+		return false;
+	}
+
+	std::shared_ptr<IPCClass> createClass(const char* name) override
+	{
+		return std::shared_ptr<IPCClass>();
+	}
+};
+
+TEST(IPCDirectBench, SmallCallRate)
+{
+	IPCDirectBenchClass bench;
+
+	const uint32 nCalls = 200000;
+	const char* szMcfPath = "/home/user/.desura/cache/mcfstore/1234/5678.mcf";
+	const char* szInstallPath = "/home/user/desura/games/something";
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32 x=0; x<nCalls; x++)
+		bench.sendPause();
+
+	std::chrono::duration<double> pauseSecs = std::chrono::steady_clock::now() - start;
+	start = std::chrono::steady_clock::now();
+
+	for (uint32 x=0; x<nCalls; x++)
+		ASSERT_TRUE(bench.sendStart(szMcfPath, szInstallPath, strlen(szInstallPath), true));
+
+	std::chrono::duration<double> startSecs = std::chrono::steady_clock::now() - start;
+
+	double pausePerSec = nCalls / pauseSecs.count();
+	double startPerSec = nCalls / startSecs.count();
+
+	RecordProperty("pause_calls_per_sec", gcString("{0}", (uint32)pausePerSec));
+	RecordProperty("start_calls_per_sec", gcString("{0}", (uint32)startPerSec));
+}
+#endif
+
+#ifdef NIX
+#include "IPCPipeSocket_Nix.h"
+#include <sys/socket.h>
+
+class SocketTestHandler : public SocketHandlerI
+{
+public:
+	int32 onSocketAccept(int hSocket, uid_t uid, pid_t pid) override
+	{
+		EXPECT_EQ(getuid(), uid);
+		m_hAccepted = hSocket;
+		return 7;
+	}
+
+	void onSocketRead(uint32 tag, const char* buffer, uint32 size) override
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+		m_vPackets.push_back(std::make_pair(tag, std::string(buffer, size)));
+		m_WaitCond.notify();
+	}
+
+	void onSocketClosed(uint32 tag) override
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+		m_bClosed = true;
+		m_WaitCond.notify();
+	}
+
+	template <typename F>
+	bool waitFor(F check)
+	{
+		for (int x=0; x<50; x++)
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_Lock);
+
+				if (check())
+					return true;
+			}
+
+			m_WaitCond.wait(0, 100);
+		}
+
+		return false;
+	}
+
+	int m_hAccepted = -1;
+	bool m_bClosed = false;
+
+	std::mutex m_Lock;
+	std::vector<std::pair<uint32, std::string>> m_vPackets;
+	Thread::WaitCondition m_WaitCond;
+};
+
+TEST(IPCSocket, PacketsKeepBoundaries)
+{
+	gcString name("unittest-{0}", getpid());
+
+	int hListen = ListenSocket(name.c_str());
+
+	SocketTestHandler handler;
+	SocketReader reader("unittest", &handler, hListen);
+	reader.start();
+
+	int hClient = ConnectSocket(name.c_str());
+
+	ASSERT_TRUE(SendPacket(hClient, "first", 5));
+	ASSERT_TRUE(SendPacket(hClient, "second", 6));
+
+	ASSERT_TRUE(handler.waitFor([&handler](){ return handler.m_vPackets.size() == 2; }));
+
+	EXPECT_EQ(7, handler.m_vPackets[0].first);
+	EXPECT_EQ("first", handler.m_vPackets[0].second);
+	EXPECT_EQ("second", handler.m_vPackets[1].second);
+
+	close(hClient);
+	EXPECT_TRUE(handler.waitFor([&handler](){ return handler.m_bClosed; }));
+
+	reader.stop();
+
+	close(handler.m_hAccepted);
+	close(hListen);
+}
+
+TEST(IPCSocket, SendFailsWhenReaderStalls)
+{
+	int hSockets[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, hSockets));
+
+	std::vector<char> vPacket(BUFSIZE, 'd');
+	bool bSent = true;
+
+	//nothing reads the other end so the buffer fills and the send has to give up
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32 x=0; x<100000 && bSent; x++)
+		bSent = SendPacket(hSockets[0], &vPacket[0], vPacket.size());
+
+	std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+
+	EXPECT_FALSE(bSent);
+	EXPECT_LT(secs.count(), 30.0);
+
+	close(hSockets[0]);
+	close(hSockets[1]);
+}
+
+TEST(IPCSocket, ListenTwiceFails)
+{
+	gcString name("unittest-dup-{0}", getpid());
+
+	int hListen = ListenSocket(name.c_str());
+	EXPECT_THROW(ListenSocket(name.c_str()), gcException);
+	close(hListen);
+
+	EXPECT_THROW(ConnectSocket(name.c_str()), gcException);
+}
+#endif
@@ -20,6 +20,10 @@ Contact us at legal@badjuju.com.
 */
 #include "Common.h"
 #include "mcfcore/MCFMain.h"
+#include "mcfcore/ProgressAggregator.h"
+
+#include <chrono>
+#include <thread>
 
 class MCFTestFixture : public ::testing::Test
 {
@@ -136,3 +140,214 @@ TEST_F(MCFTestFixture, MCF_MergePatch)
 
 	compareFolders(UTIL::FS::Path("unit_test\\mcftest\\ver2"), UTIL::FS::Path("unit_test\\mcftest\\merged"));
 }
+
+TEST_F(MCFTestFixture, MCF_SmallSaveLatency)
+{
+	//Small saves used to pay the controller poll timeouts (2s save, 500ms extract) on top
+	//of the real work. Timings are recorded for comparison, the test only checks the round trip.
+	for (int x = 0; x < 10; ++x)
+		createFile(gcString("unit_test\\mcftest\\small\\{0}.txt", x).c_str(), gcString("file {0} contents", x).c_str());
+
+	auto start = std::chrono::steady_clock::now();
+
+	{
+		McfHandle mcf;
+		mcf->setFile("unit_test\\mcftest\\small.mcf");
+		mcf->parseFolder("unit_test\\mcftest\\small");
+		mcf->hashFiles();
+		mcf->saveMCF();
+	}
+
+	auto saved = std::chrono::steady_clock::now();
+	ASSERT_TRUE(UTIL::FS::isValidFile("unit_test\\mcftest\\small.mcf"));
+
+	{
+		McfHandle mcf;
+		mcf->setFile("unit_test\\mcftest\\small.mcf");
+		mcf->parseMCF();
+		mcf->saveFiles("unit_test\\mcftest\\small_out");
+	}
+
+	auto extracted = std::chrono::steady_clock::now();
+
+	compareFolders(UTIL::FS::Path("unit_test\\mcftest\\small"), UTIL::FS::Path("unit_test\\mcftest\\small_out"));
+
+	auto saveMs = std::chrono::duration_cast<std::chrono::milliseconds>(saved - start).count();
+	auto extractMs = std::chrono::duration_cast<std::chrono::milliseconds>(extracted - saved).count();
+
+	RecordProperty("SaveMs", (int)saveMs);
+	RecordProperty("ExtractMs", (int)extractMs);
+}
+
+TEST_F(MCFTestFixture, MCF_IncrementalReuse)
+{
+	for (int x = 0; x < 10; ++x)
+		createFile(gcString("unit_test\\mcftest\\inc\\{0}\\file.txt", x).c_str(), gcString("file {0} contents {0} {0} {0} {0} {0} {0} {0} {0}", x).c_str());
+
+	{
+		McfHandle mcf;
+		mcf->setFile("unit_test\\mcftest\\inc_b1.mcf");
+		mcf->parseFolder("unit_test\\mcftest\\inc");
+		mcf->saveMCF();
+	}
+
+	//a size change always rebuilds the file, even inside the same time stamp second
+	createFile("unit_test\\mcftest\\inc\\3\\file.txt", "changed");
+	createFile("unit_test\\mcftest\\inc\\new\\file.txt", "new file");
+
+	//same size and time stamp but different contents is only caught by the hash check
+	auto sneakyPath = "unit_test\\mcftest\\inc\\5\\file.txt";
+	auto sneakyTime = UTIL::FS::lastWriteTime(sneakyPath);
+	createFile(sneakyPath, "FILE 5 CONTENTS 5 5 5 5 5 5 5 5");
+	UTIL::FS::setLastWriteTime(sneakyPath, sneakyTime);
+
+	McfHandle prev;
+	prev->setFile("unit_test\\mcftest\\inc_b1.mcf");
+	prev->parseMCF();
+
+	auto build = [&prev](const char* szMcf, const char* szOut, bool bCheckHash)
+	{
+		{
+			McfHandle mcf;
+			mcf->setFile(szMcf);
+			mcf->setReuseMcf(prev.handle(), bCheckHash);
+			mcf->parseFolder("unit_test\\mcftest\\inc", true);
+			mcf->saveMCF();
+		}
+
+		McfHandle mcf;
+		mcf->setFile(szMcf);
+		mcf->parseMCF();
+		ASSERT_TRUE(mcf->verifyMCF());
+		mcf->saveFiles(szOut);
+	};
+
+	build("unit_test\\mcftest\\inc_b2_hash.mcf", "unit_test\\mcftest\\inc_out_hash", true);
+	compareFolders(UTIL::FS::Path("unit_test\\mcftest\\inc"), UTIL::FS::Path("unit_test\\mcftest\\inc_out_hash"));
+
+	//without the hash check the unchanged looking file comes from the previous build
+	build("unit_test\\mcftest\\inc_b2.mcf", "unit_test\\mcftest\\inc_out", false);
+
+	auto hash = [](const char* szFile){
+		return UTIL::MISC::hashFile(UTIL::FS::PathWithFile(szFile).getFullPath());
+	};
+
+	ASSERT_EQ(hash("unit_test\\mcftest\\inc\\3\\file.txt"), hash("unit_test\\mcftest\\inc_out\\3\\file.txt"));
+	ASSERT_EQ(hash("unit_test\\mcftest\\inc\\new\\file.txt"), hash("unit_test\\mcftest\\inc_out\\new\\file.txt"));
+	ASSERT_EQ(hash("unit_test\\mcftest\\inc_out_hash\\5\\file.txt"), hash(sneakyPath));
+	ASSERT_NE(hash("unit_test\\mcftest\\inc_out\\5\\file.txt"), hash(sneakyPath));
+}
+
+
+class ProgressCounter
+{
+public:
+	void onProgress(MCFCore::Misc::ProgressInfo& info)
+	{
+		m_nCount++;
+		m_uiLastPercent = info.percent;
+	}
+
+	std::atomic<uint32> m_nCount{0};
+	std::atomic<uint32> m_uiLastPercent{0};
+};
+
+TEST(ProgressAggregator, CoalescesWorkerUpdates)
+{
+	const uint64 nTotal = 100000;
+
+	ProgressCounter counter;
+	Event<MCFCore::Misc::ProgressInfo> event;
+	event += delegate(&counter, &ProgressCounter::onProgress);
+
+	//clock stands still so only the first update gets through the rate limit
+	MCFCore::Misc::ProgressAggregator progress(nTotal);
+	progress.setClock([](){ return (int64)1000; });
+
+	std::vector<std::thread> vWorkers;
+
+	for (int x = 0; x < 4; ++x)
+	{
+		vWorkers.push_back(std::thread([&progress, &event, nTotal](){
+			for (uint64 y = 0; y < nTotal / 4 - 1; ++y)
+			{
+				progress.addDone();
+				progress.publish(event);
+			}
+		}));
+	}
+
+	for (auto &t : vWorkers)
+		t.join();
+
+	EXPECT_EQ(1u, counter.m_nCount);
+
+	progress.finish(event);
+
+	EXPECT_EQ(2u, counter.m_nCount);
+	EXPECT_EQ(100u, counter.m_uiLastPercent);
+	EXPECT_EQ(nTotal, progress.getProgress().doneAmmount);
+}
+
+TEST(ProgressAggregator, PublishesOncePerInterval)
+{
+	int64 nNow = 0;
+
+	ProgressCounter counter;
+	Event<MCFCore::Misc::ProgressInfo> event;
+	event += delegate(&counter, &ProgressCounter::onProgress);
+
+	MCFCore::Misc::ProgressAggregator progress(1000);
+	progress.setClock([&nNow](){ return nNow; });
+
+	for (uint64 x = 0; x < 999; ++x)
+	{
+		nNow = (int64)x;
+
+		progress.setDone(x);
+		progress.publish(event);
+	}
+
+	//one every 50ms (20Hz) over 999ms
+	EXPECT_EQ(20u, counter.m_nCount);
+	EXPECT_EQ(95u, counter.m_uiLastPercent);
+
+	progress.flush(event);
+	EXPECT_EQ(21u, counter.m_nCount);
+	EXPECT_EQ(99u, counter.m_uiLastPercent);
+
+	progress.finish(event);
+	EXPECT_EQ(22u, counter.m_nCount);
+	EXPECT_EQ(100u, counter.m_uiLastPercent);
+}
+
+TEST(ProgressAggregator, ImportantUpdatesAlwaysPublished)
+{
+	int64 nNow = 0;
+
+	MCFCore::Misc::ProgressAggregator progress;
+	progress.setClock([&nNow](){ return nNow; });
+
+	MCFCore::Misc::ProgressInfo info;
+	info.percent = 10;
+
+	ASSERT_TRUE(progress.shouldPublish(info));
+
+	//duplicates and updates inside the interval get dropped
+	ASSERT_FALSE(progress.shouldPublish(info));
+
+	nNow = 49;
+	info.percent = 20;
+	ASSERT_FALSE(progress.shouldPublish(info));
+
+	//flag changes and completion dont
+	info.flag = MCFCore::Misc::ProgressInfo::FLAG_FINALIZING;
+	ASSERT_TRUE(progress.shouldPublish(info));
+
+	info.percent = 100;
+	ASSERT_TRUE(progress.shouldPublish(info));
+
+	nNow = 99;
+	info.percent = 50;
+	ASSERT_TRUE(progress.shouldPublish(info));
+}
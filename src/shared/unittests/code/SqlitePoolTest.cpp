@@ -0,0 +1,330 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#include "Common.h"
+#include "sqlite3x.hpp"
+
+#include <chrono>
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace UnitTest
+{
+	class SqlitePoolFixture : public ::testing::Test
+	{
+	public:
+		void SetUp() override
+		{
+			m_Path = fs::temp_directory_path() / fs::unique_path("sqlitepool-%%%%-%%%%.sqlite");
+			m_szDb = m_Path.string();
+
+			sqlite3x::sqlite3_connection db(m_szDb.c_str());
+			db.executenonquery("CREATE TABLE favorite(internalid INTEGER, userid INTEGER, PRIMARY KEY (internalid, userid));");
+
+			sqlite3x::sqlite3_transaction trans(db);
+			sqlite3x::sqlite3_command cmd(db, "INSERT INTO favorite VALUES (?,?);");
+
+			for (int x=0; x<50; x++)
+			{
+				cmd.bind(1, (long long)x);
+				cmd.bind(2, x%2);
+				cmd.executenonquery();
+			}
+
+			trans.commit();
+		}
+
+		void TearDown() override
+		{
+			sqlite3x::closepooledconnections(m_szDb.c_str());
+
+			boost::system::error_code ec;
+			fs::remove(m_Path, ec);
+			fs::remove(m_szDb + "-wal", ec);
+			fs::remove(m_szDb + "-shm", ec);
+		}
+
+		fs::path m_Path;
+		std::string m_szDb;
+	};
+
+	TEST_F(SqlitePoolFixture, ReusesIdleConnection)
+	{
+		sqlite3x::sqlite3_pool_stats before = sqlite3x::getpoolstats();
+
+		{
+			sqlite3x::sqlite3_pooled_connection db(m_szDb);
+			ASSERT_EQ(50, db.executeint("SELECT count(*) FROM favorite;"));
+		}
+
+		{
+			sqlite3x::sqlite3_pooled_connection db(m_szDb);
+			ASSERT_EQ(50, db.executeint("SELECT count(*) FROM favorite;"));
+		}
+
+		sqlite3x::sqlite3_pool_stats after = sqlite3x::getpoolstats();
+		ASSERT_EQ(before.opened + 1, after.opened);
+		ASSERT_EQ(before.reused + 1, after.reused);
+	}
+
+	TEST_F(SqlitePoolFixture, ConcurrentBorrowsGetSeparateConnections)
+	{
+		sqlite3x::sqlite3_pooled_connection a(m_szDb);
+		sqlite3x::sqlite3_pooled_connection b(m_szDb);
+
+		ASSERT_NE(&a.connection(), &b.connection());
+	}
+
+	TEST_F(SqlitePoolFixture, CachesPreparedStatements)
+	{
+		const char* szSql = "SELECT internalid FROM favorite WHERE userid=?;";
+		sqlite3x::sqlite3_pool_stats before = sqlite3x::getpoolstats();
+		sqlite3x::sqlite3_command* pFirst = nullptr;
+
+		for (int x=0; x<3; x++)
+		{
+			sqlite3x::sqlite3_pooled_connection db(m_szDb);
+			sqlite3x::sqlite3_command &cmd = db.command(szSql);
+			cmd.bind(1, 1);
+
+			if (!pFirst)
+				pFirst = &cmd;
+
+			ASSERT_EQ(pFirst, &cmd);
+
+			int count = 0;
+			sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+			while (reader.read())
+				++count;
+
+			ASSERT_EQ(25, count);
+		}
+
+		sqlite3x::sqlite3_pool_stats after = sqlite3x::getpoolstats();
+		ASSERT_EQ(before.prepared + 1, after.prepared);
+		ASSERT_EQ(before.cached + 2, after.cached);
+	}
+
+	TEST_F(SqlitePoolFixture, ClearsBindingsOnReuse)
+	{
+		const char* szSql = "SELECT count(*) FROM favorite WHERE userid=?;";
+
+		{
+			sqlite3x::sqlite3_pooled_connection db(m_szDb);
+			sqlite3x::sqlite3_command &cmd = db.command(szSql);
+			cmd.bind(1, 0);
+			ASSERT_EQ(25, cmd.executeint());
+		}
+
+		sqlite3x::sqlite3_pooled_connection db(m_szDb);
+		ASSERT_EQ(0, db.command(szSql).executeint());
+	}
+
+	TEST_F(SqlitePoolFixture, UsesWriteAheadLog)
+	{
+		sqlite3x::sqlite3_pooled_connection db(m_szDb);
+		ASSERT_STREQ("wal", db.executestring("PRAGMA journal_mode;").c_str());
+	}
+
+	TEST_F(SqlitePoolFixture, RollsBackOpenTransactionOnRelease)
+	{
+		{
+			sqlite3x::sqlite3_pooled_connection db(m_szDb);
+			db.executenonquery("BEGIN;");
+			db.executenonquery("DELETE FROM favorite;");
+		}
+
+		sqlite3x::sqlite3_pooled_connection db(m_szDb);
+		ASSERT_EQ(50, db.executeint("SELECT count(*) FROM favorite;"));
+	}
+
+	TEST_F(SqlitePoolFixture, CommandInUseThrows)
+	{
+		const char* szSql = "SELECT internalid FROM favorite;";
+
+		sqlite3x::sqlite3_pooled_connection db(m_szDb);
+		sqlite3x::sqlite3_reader reader = db.command(szSql).executereader();
+		ASSERT_TRUE(reader.read());
+
+		ASSERT_THROW(db.command(szSql), sqlite3x::database_error);
+	}
+
+	TEST_F(SqlitePoolFixture, FavListRate)
+	{
+		const char* szSql = "SELECT internalid FROM favorite WHERE userid=?;";
+		const int nIterations = 2000;
+
+		auto loadFavList = [](sqlite3x::sqlite3_command &cmd) -> size_t
+		{
+			cmd.bind(1, 1);
+
+			std::vector<long long> vList;
+			sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+			while (reader.read())
+				vList.push_back(reader.getint64(0));
+
+			return vList.size();
+		};
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (int x=0; x<nIterations; x++)
+		{
+			sqlite3x::sqlite3_connection db(m_szDb.c_str());
+			sqlite3x::sqlite3_command cmd(db, szSql);
+			ASSERT_EQ(25u, loadFavList(cmd));
+		}
+
+		auto mid = std::chrono::steady_clock::now();
+
+		for (int x=0; x<nIterations; x++)
+		{
+			sqlite3x::sqlite3_pooled_connection db(m_szDb);
+			ASSERT_EQ(25u, loadFavList(db.command(szSql)));
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		double openPerSec = nIterations / std::chrono::duration<double>(mid - start).count();
+		double pooledPerSec = nIterations / std::chrono::duration<double>(end - mid).count();
+
+		RecordProperty("open_per_call_per_sec", gcString("{0}", (uint32)openPerSec));
+		RecordProperty("pooled_per_sec", gcString("{0}", (uint32)pooledPerSec));
+	}
+
+	TEST_F(SqlitePoolFixture, LoginDbPathRate)
+	{
+		//trimmed copies of the item db tables login reads
+		{
+			sqlite3x::sqlite3_connection db(m_szDb.c_str());
+			db.executenonquery("CREATE TABLE newItems(internalid INTEGER, userid INTEGER, time DATE);");
+			db.executenonquery("CREATE TABLE iteminfo(internalid INTEGER PRIMARY KEY, parentid INTEGER, name TEXT, statusflags INTEGER);");
+			db.executenonquery("CREATE TABLE branchinfo(branchid INTEGER, internalid INTEGER, name TEXT, biid INTEGER);");
+			db.executenonquery("CREATE TABLE installinfo(itemid INTEGER, biid INTEGER, installpath TEXT);");
+			db.executenonquery("CREATE TABLE installinfoex(itemid INTEGER, biid INTEGER, installcheck TEXT);");
+			db.executenonquery("CREATE TABLE exe(itemid INTEGER, biid INTEGER, name TEXT, exe TEXT);");
+			db.executenonquery("CREATE TABLE tools(branchid INTEGER, toolid INTEGER);");
+			db.executenonquery("CREATE TABLE cdkey(branchid INTEGER, userid INTEGER, key TEXT);");
+
+			sqlite3x::sqlite3_transaction trans(db);
+
+			for (int x=0; x<200; x++)
+			{
+				db.executenonquery(gcString("INSERT INTO newItems VALUES ({0}, 1, datetime('now'));", x));
+				db.executenonquery(gcString("INSERT INTO iteminfo VALUES ({0}, 0, 'item {0}', 4);", x));
+				db.executenonquery(gcString("INSERT INTO branchinfo VALUES ({0}, {0}, 'branch', 100);", x));
+				db.executenonquery(gcString("INSERT INTO installinfo VALUES ({0}, 100, 'games/{0}');", x));
+				db.executenonquery(gcString("INSERT INTO installinfoex VALUES ({0}, 100, 'games/{0}/game.exe');", x));
+				db.executenonquery(gcString("INSERT INTO exe VALUES ({0}, 100, 'Play', 'games/{0}/game.exe');", x));
+				db.executenonquery(gcString("INSERT INTO tools VALUES ({0}, 1);", x));
+				db.executenonquery(gcString("INSERT INTO cdkey VALUES ({0}, 1, 'key');", x));
+			}
+
+			trans.commit();
+		}
+
+		//The statements the login graph runs against the item db, one entry per connection a step
+		//borrows: ItemManager::preloadItems, then loadDbItems, then loadFavList
+		const std::vector<std::vector<const char*>> vLoginSteps =
+		{
+			{
+				"select count(*) from sqlite_master where name='iteminfo';",
+				"SELECT * FROM iteminfo ORDER BY internalid;",
+				"SELECT * FROM installinfo ORDER BY itemid, biid;",
+				"SELECT * FROM installinfoex ORDER BY itemid, biid, installcheck;",
+				"SELECT * FROM exe ORDER BY itemid, biid, name;",
+				"SELECT * FROM branchinfo ORDER BY internalid, branchid;",
+				"SELECT * FROM tools ORDER BY branchid, toolid;",
+			},
+			{
+				"SELECT count(*) FROM newItems WHERE userid=?;",
+			},
+			{
+				"select count(*) from sqlite_master where name='iteminfo';",
+				"SELECT branchid, key FROM cdkey WHERE userid=?;",
+			},
+			{
+				"SELECT internalid FROM favorite WHERE userid=?;",
+			},
+		};
+
+		const int nIterations = 200;
+
+		auto readRows = [](sqlite3x::sqlite3_command &cmd, const char* szSql) -> size_t
+		{
+			if (strchr(szSql, '?'))
+				cmd.bind(1, 1);
+
+			size_t nRows = 0;
+			sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+			while (reader.read())
+				++nRows;
+
+			return nRows;
+		};
+
+		size_t nOpenRows = 0;
+		size_t nPooledRows = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (int x=0; x<nIterations; x++)
+		{
+			for (auto &vStep : vLoginSteps)
+			{
+				sqlite3x::sqlite3_connection db(m_szDb.c_str());
+
+				for (auto szSql : vStep)
+				{
+					sqlite3x::sqlite3_command cmd(db, szSql);
+					nOpenRows += readRows(cmd, szSql);
+				}
+			}
+		}
+
+		auto mid = std::chrono::steady_clock::now();
+
+		for (int x=0; x<nIterations; x++)
+		{
+			for (auto &vStep : vLoginSteps)
+			{
+				sqlite3x::sqlite3_pooled_connection db(m_szDb);
+
+				for (auto szSql : vStep)
+					nPooledRows += readRows(db.command(szSql), szSql);
+			}
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		ASSERT_EQ(nOpenRows, nPooledRows);
+
+		double openPerSec = nIterations / std::chrono::duration<double>(mid - start).count();
+		double pooledPerSec = nIterations / std::chrono::duration<double>(end - mid).count();
+
+		RecordProperty("login_open_per_step_per_sec", gcString("{0}", (uint32)openPerSec));
+		RecordProperty("login_pooled_per_sec", gcString("{0}", (uint32)pooledPerSec));
+	}
+}
@@ -0,0 +1,207 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+
+#include "Common.h"
+#include "LogCallback.h"
+#include "util_thread/LogWriterThread.h"
+
+#include <chrono>
+#include <thread>
+
+extern LogCallback* g_pLogCallback;
+
+namespace UnitTest
+{
+	class LogCounter
+	{
+	public:
+		LogCounter()
+		{
+			LogCallback::MessageFn fn = [this](MSG_TYPE type, const char* szMessage, Color*, std::map<std::string, std::string>*)
+			{
+				m_nCount[type]++;
+				m_strLast = szMessage;
+			};
+
+			m_Callback.RegMsg(fn);
+			g_pLogCallback = &m_Callback;
+		}
+
+		~LogCounter()
+		{
+			g_pLogCallback = nullptr;
+		}
+
+		LogCallback m_Callback;
+		uint32 m_nCount[MT_TRACE + 1] = {0};
+		std::string m_strLast;
+	};
+
+	TEST(LogBones, DisabledChannelSkipsFormatting)
+	{
+		LogCounter counter;
+		counter.m_Callback.setEnabled(MT_DEBUG, false);
+
+		Msg("Msg {0}\n", 1);
+		Debug("Debug {0}\n", 2);
+		WarningS("Warning {0}\n", 3);
+
+		ASSERT_EQ(1u, counter.m_nCount[MT_MSG]);
+		ASSERT_EQ(0u, counter.m_nCount[MT_DEBUG]);
+		ASSERT_EQ(1u, counter.m_nCount[MT_WARN]);
+
+		counter.m_Callback.setEnabled(MT_DEBUG, true);
+		Debug("Debug {0}\n", 4);
+
+		ASSERT_EQ(1u, counter.m_nCount[MT_DEBUG]);
+		ASSERT_STREQ("Debug 4\n", counter.m_strLast.c_str());
+	}
+
+	TEST(LogBones, DisabledCallBenchmark)
+	{
+		LogCounter counter;
+		counter.m_Callback.setEnabled(MT_DEBUG, false);
+
+		const size_t nIterations = 10000000;
+		const char* szPath = "/home/user/.desura/games/some_game/data/file.pak";
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (size_t x = 0; x < nIterations; ++x)
+			Debug("Verifying file {0} of {1}: {2}\n", x, nIterations, szPath);
+
+		auto end = std::chrono::steady_clock::now();
+
+		ASSERT_EQ(0u, counter.m_nCount[MT_DEBUG]);
+
+		double dNsPerCall = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (double)nIterations;
+		RecordProperty("DisabledPsPerCall", (int)(dNsPerCall * 1000));
+
+		//a formatted call is in the hundreds of ns, a disabled one should be a branch
+		EXPECT_LT(dNsPerCall, 50.0);
+	}
+
+#ifdef WITH_TRACING
+	TEST(LogBones, TracePassesRawFields)
+	{
+		LogCounter counter;
+
+		std::vector<TraceEvent> vEvents;
+		std::vector<std::string> vMessages;
+
+		LogCallback::TraceFn fn = [&](const TraceEvent &event)
+		{
+			vEvents.push_back(event);
+			vMessages.push_back(std::string(event.szMessage, event.nMessageLen));
+		};
+
+		counter.m_Callback.RegTrace(fn);
+
+		int nClass = 0;
+		TraceT("Func", &nClass, "Plain {0}");
+		TraceT("Func", &nClass, "Id {0}", 7);
+
+		ASSERT_EQ(2u, vEvents.size());
+		ASSERT_STREQ("Func", vEvents[0].szFunction);
+		ASSERT_EQ(&nClass, vEvents[0].pClass);
+		ASSERT_NE(0u, vEvents[0].nThreadId);
+		ASSERT_LE(vEvents[0].nTick, vEvents[1].nTick);
+
+		//no arguments so the format string goes through as is
+		ASSERT_EQ("Plain {0}", vMessages[0]);
+		ASSERT_EQ("Id 7", vMessages[1]);
+
+		//without a trace callback it turns into a formatted message
+		LogCallback::TraceFn empty;
+		counter.m_Callback.RegTrace(empty);
+
+		TraceT("Func", &nClass, "Text");
+
+		ASSERT_EQ(1u, counter.m_nCount[MT_TRACE]);
+		ASSERT_EQ("Text", counter.m_strLast);
+	}
+#endif
+
+	TEST(LogBones, WriterThreadKeepsProducerOrder)
+	{
+		const uint32 nProducers = 4;
+		const uint32 nMessages = 5000;
+
+		std::vector<uint32> vLastSeen(nProducers, 0);
+		std::atomic<uint32> nOutOfOrder(0);
+		std::atomic<uint32> nReceived(0);
+
+		Thread::LogWriterThread::SinkFn sink = [&](MSG_TYPE, const char* szMessage, Color*)
+		{
+			uint32 nProducer = 0;
+			uint32 nMessage = 0;
+			sscanf(szMessage, "%u %u", &nProducer, &nMessage);
+
+			if (nMessage != vLastSeen[nProducer] + 1)
+				nOutOfOrder++;
+
+			vLastSeen[nProducer] = nMessage;
+			nReceived++;
+		};
+
+		const char* szLogFile = "log_writer_test.txt";
+		remove(szLogFile);
+
+		{
+			Thread::LogWriterThread writer(szLogFile, sink);
+			writer.start();
+
+			std::vector<std::thread> vThreads;
+
+			for (uint32 x = 0; x < nProducers; ++x)
+			{
+				vThreads.push_back(std::thread([&writer, x, nMessages]()
+				{
+					for (uint32 y = 1; y <= nMessages; ++y)
+						writer.push(MT_MSG, gcString("{0} {1}\n", x, y).c_str());
+				}));
+			}
+
+			for (auto &t : vThreads)
+				t.join();
+		}
+
+		ASSERT_EQ(nProducers * nMessages, nReceived.load());
+		ASSERT_EQ(0u, nOutOfOrder.load());
+
+		FILE* fh = fopen(szLogFile, "rb");
+		ASSERT_TRUE(fh != nullptr);
+
+		uint32 nLines = 0;
+		int c = 0;
+
+		while ((c = fgetc(fh)) != EOF)
+		{
+			if (c == '\n')
+				nLines++;
+		}
+
+		fclose(fh);
+		remove(szLogFile);
+
+		ASSERT_EQ(nProducers * nMessages, nLines);
+	}
+}
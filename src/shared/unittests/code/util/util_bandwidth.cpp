@@ -0,0 +1,305 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+#include "Common.h"
+#include "util/UtilBandwidthLimiter.h"
+
+#include <thread>
+
+#ifdef NIX
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+using namespace UTIL::WEB;
+
+namespace UnitTest
+{
+	TEST(BandwidthLimiter, NoLimitNeverWaits)
+	{
+		BandwidthLimiter limiter;
+
+		for (uint32 x = 0; x < 100; ++x)
+		{
+			ASSERT_EQ(0, limiter.take(TrafficDirection::Download, TrafficClass::Background, 1024 * 1024).count());
+			ASSERT_EQ(0, limiter.take(TrafficDirection::Upload, TrafficClass::Background, 1024 * 1024).count());
+		}
+	}
+
+	TEST(BandwidthLimiter, BackgroundWaitsOverBudget)
+	{
+		BandwidthLimiter limiter;
+		limiter.setDownloadLimit(1000);
+
+		ASSERT_EQ(1000, limiter.getDownloadLimit());
+		ASSERT_EQ(0, limiter.take(TrafficDirection::Download, TrafficClass::Background, 1000).count());
+
+		auto wait = limiter.take(TrafficDirection::Download, TrafficClass::Background, 500);
+		ASSERT_GT(wait.count(), 400000);
+		ASSERT_LE(wait.count(), 500000);
+	}
+
+	TEST(BandwidthLimiter, InteractiveIsChargedButNeverWaits)
+	{
+		BandwidthLimiter limiter;
+		limiter.setDownloadLimit(1000);
+
+		ASSERT_EQ(0, limiter.take(TrafficDirection::Download, TrafficClass::Interactive, 1000).count());
+		ASSERT_EQ(0, limiter.take(TrafficDirection::Download, TrafficClass::Interactive, 1000).count());
+
+		//background pays for what interactive used
+		auto wait = limiter.take(TrafficDirection::Download, TrafficClass::Background, 500);
+		ASSERT_GT(wait.count(), 1400000);
+	}
+
+	TEST(BandwidthLimiter, InteractiveDebtIsCapped)
+	{
+		BandwidthLimiter limiter;
+		limiter.setDownloadLimit(1000);
+
+		for (uint32 x = 0; x < 20; ++x)
+			ASSERT_EQ(0, limiter.take(TrafficDirection::Download, TrafficClass::Interactive, 1000).count());
+
+		//twenty seconds worth of interactive traffic only costs background one burst
+		auto wait = limiter.take(TrafficDirection::Download, TrafficClass::Background, 500);
+		ASSERT_GT(wait.count(), 1400000);
+		ASSERT_LE(wait.count(), 1500000);
+	}
+
+	TEST(BandwidthLimiter, DownloadAndUploadAreSeparate)
+	{
+		BandwidthLimiter limiter;
+		limiter.setUploadLimit(1000);
+
+		ASSERT_EQ(0, limiter.getDownloadLimit());
+		ASSERT_EQ(1000, limiter.getUploadLimit());
+
+		ASSERT_EQ(0, limiter.take(TrafficDirection::Download, TrafficClass::Background, 5000).count());
+		ASSERT_GT(limiter.take(TrafficDirection::Upload, TrafficClass::Background, 5000).count(), 0);
+
+		limiter.setUploadLimit(0);
+		ASSERT_EQ(0, limiter.take(TrafficDirection::Upload, TrafficClass::Background, 5000).count());
+	}
+
+	TEST(BandwidthLimiter, ModulesCanShareALimiter)
+	{
+		BandwidthLimiter &own = GetBandwidthLimiter();
+		BandwidthLimiter shared;
+
+		SetBandwidthLimiter(&shared);
+		ASSERT_EQ(&shared, &GetBandwidthLimiter());
+
+		SetBandwidthLimiter(nullptr);
+		ASSERT_EQ(&own, &GetBandwidthLimiter());
+	}
+
+#ifdef NIX
+	//Stand in for the content servers. Answers one request with a body of the given size
+	//after reading the whole request (including any post data).
+	class LocalHttpServer
+	{
+	public:
+		LocalHttpServer(uint32 nBodySize)
+			: m_nBodySize(nBodySize)
+		{
+			m_hListen = socket(AF_INET, SOCK_STREAM, 0);
+
+			sockaddr_in addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = 0;
+
+			socklen_t nLen = sizeof(addr);
+
+			bind(m_hListen, (sockaddr*)&addr, sizeof(addr));
+			listen(m_hListen, 1);
+			getsockname(m_hListen, (sockaddr*)&addr, &nLen);
+
+			m_nPort = ntohs(addr.sin_port);
+			m_Thread = std::thread(&LocalHttpServer::serve, this);
+		}
+
+		~LocalHttpServer()
+		{
+			m_Thread.join();
+			close(m_hListen);
+		}
+
+		gcString getUrl()
+		{
+			return gcString("http://127.0.0.1:{0}/file", m_nPort);
+		}
+
+		uint64 getBytesRead()
+		{
+			return m_nBytesRead;
+		}
+
+	protected:
+		void serve()
+		{
+			int hClient = accept(m_hListen, nullptr, nullptr);
+
+			if (hClient < 0)
+				return;
+
+			std::string strRequest;
+			char buff[16 * 1024];
+
+			size_t nHeaderEnd = std::string::npos;
+			uint64 nContentLength = 0;
+
+			while (true)
+			{
+				if (nHeaderEnd != std::string::npos && strRequest.size() >= nHeaderEnd + 4 + nContentLength)
+					break;
+
+				auto nRead = recv(hClient, buff, sizeof(buff), 0);
+
+				if (nRead <= 0)
+					break;
+
+				strRequest.append(buff, nRead);
+
+				if (nHeaderEnd == std::string::npos)
+				{
+					nHeaderEnd = strRequest.find("\r\n\r\n");
+
+					auto nPos = strRequest.find("Content-Length: ");
+
+					if (nPos != std::string::npos && nPos < nHeaderEnd)
+						nContentLength = Safe::atoi(strRequest.c_str() + nPos + 16);
+				}
+			}
+
+			m_nBytesRead = strRequest.size();
+
+			gcString strHeader("HTTP/1.1 200 OK\r\nContent-Length: {0}\r\nConnection: close\r\n\r\n", m_nBodySize);
+			send(hClient, strHeader.c_str(), strHeader.size(), 0);
+
+			std::vector<char> vBody(m_nBodySize, 'd');
+			size_t nSent = 0;
+
+			while (nSent < vBody.size())
+			{
+				auto nRes = send(hClient, &vBody[nSent], vBody.size() - nSent, 0);
+
+				if (nRes <= 0)
+					break;
+
+				nSent += nRes;
+			}
+
+			close(hClient);
+		}
+
+	private:
+		int m_hListen = -1;
+		uint32 m_nPort = 0;
+		uint32 m_nBodySize = 0;
+		std::atomic<uint64> m_nBytesRead = {0};
+		std::thread m_Thread;
+	};
+
+	class BandwidthLimiterHttpFixture : public ::testing::Test
+	{
+	public:
+		void TearDown() override
+		{
+			GetBandwidthLimiter().setDownloadLimit(0);
+			GetBandwidthLimiter().setUploadLimit(0);
+		}
+
+		int64 timeGet(uint32 nSize, TrafficClass trafficClass)
+		{
+			LocalHttpServer server(nSize);
+
+			HttpHandle hh(server.getUrl().c_str());
+			hh->setTrafficClass(trafficClass);
+
+			auto start = std::chrono::steady_clock::now();
+			hh->getWeb();
+			auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+			EXPECT_EQ(nSize, hh->getDataSize());
+			return ms;
+		}
+	};
+
+	TEST_F(BandwidthLimiterHttpFixture, BackgroundDownloadIsLimited)
+	{
+		GetBandwidthLimiter().setDownloadLimit(512 * 1024);
+
+		//first second is free then 768kb at 512kb a second
+		auto ms = timeGet(1280 * 1024, TrafficClass::Background);
+
+		ASSERT_GE(ms, 1300);
+		ASSERT_LT(ms, 3000);
+	}
+
+	TEST_F(BandwidthLimiterHttpFixture, ConcurrentDownloadsShareTheLimit)
+	{
+		GetBandwidthLimiter().setDownloadLimit(512 * 1024);
+
+		auto start = std::chrono::steady_clock::now();
+
+		std::thread other([this](){
+			timeGet(640 * 1024, TrafficClass::Background);
+		});
+
+		timeGet(640 * 1024, TrafficClass::Background);
+		other.join();
+
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+		ASSERT_GE(ms, 1300);
+		ASSERT_LT(ms, 3000);
+	}
+
+	TEST_F(BandwidthLimiterHttpFixture, InteractiveDownloadIsNotHeldBack)
+	{
+		GetBandwidthLimiter().setDownloadLimit(512 * 1024);
+
+		auto ms = timeGet(1280 * 1024, TrafficClass::Interactive);
+		ASSERT_LT(ms, 1000);
+	}
+
+	TEST_F(BandwidthLimiterHttpFixture, BackgroundUploadIsLimited)
+	{
+		GetBandwidthLimiter().setUploadLimit(512 * 1024);
+
+		LocalHttpServer server(16);
+		std::string strPost(1280 * 1024, 'u');
+
+		HttpHandle hh(server.getUrl().c_str());
+		hh->setTrafficClass(TrafficClass::Background);
+		hh->addRawPost(strPost.c_str(), strPost.size());
+
+		auto start = std::chrono::steady_clock::now();
+		hh->postWeb();
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+		ASSERT_GT(server.getBytesRead(), strPost.size());
+		ASSERT_GE(ms, 1300);
+		ASSERT_LT(ms, 3000);
+	}
+#endif
+}
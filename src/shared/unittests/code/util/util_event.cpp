@@ -19,6 +19,12 @@ Contact us at legal@badjuju.com.
 
 */
 #include "Common.h"
+#include "wx_controls/guiInvoker.h"
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <deque>
 
 namespace UnitTest
 {
@@ -189,4 +195,419 @@ namespace UnitTest
 		event1(val);
 		EXPECT_FALSE(a.hitCallback);
 	}
+
+	class DispatchCallback
+	{
+	public:
+		void callback(int& i)
+		{
+			++count;
+
+			if (fnOnCall)
+				fnOnCall();
+		}
+
+		std::atomic<int> count = {0};
+		std::function<void()> fnOnCall;
+	};
+
+	TEST(Event, AddDuringDispatch)
+	{
+		Event<int> event;
+		DispatchCallback a;
+		DispatchCallback b;
+
+		a.fnOnCall = [&](){
+			event += delegate(&b, &DispatchCallback::callback);
+		};
+
+		event += delegate(&a, &DispatchCallback::callback);
+
+		int val = 0;
+		event(val);
+
+		//added during fire so only gets called from the next fire on
+		EXPECT_EQ(1, a.count);
+		EXPECT_EQ(0, b.count);
+
+		a.fnOnCall = std::function<void()>();
+		event(val);
+
+		EXPECT_EQ(2, a.count);
+		EXPECT_EQ(1, b.count);
+	}
+
+	TEST(Event, RemoveDuringDispatch)
+	{
+		Event<int> event;
+		DispatchCallback a;
+		DispatchCallback b;
+
+		a.fnOnCall = [&](){
+			event -= delegate(&b, &DispatchCallback::callback);
+		};
+
+		event += delegate(&a, &DispatchCallback::callback);
+		event += delegate(&b, &DispatchCallback::callback);
+
+		int val = 0;
+		event(val);
+
+		EXPECT_EQ(1, a.count);
+		EXPECT_EQ(0, b.count);
+	}
+
+	TEST(Event, ResetDuringDispatch)
+	{
+		Event<int> event;
+		DispatchCallback a;
+		DispatchCallback b;
+
+		a.fnOnCall = [&](){
+			event.reset();
+		};
+
+		event += delegate(&a, &DispatchCallback::callback);
+		event += delegate(&b, &DispatchCallback::callback);
+
+		int val = 0;
+		event(val);
+		event(val);
+
+		EXPECT_EQ(1, a.count);
+		EXPECT_EQ(0, b.count);
+	}
+
+	//Stands in for the wx event queue. The main thread pumps the invokers that the
+	//firing threads queue, the same way wxGuiDelegateEvent runs them.
+	class FakeGuiQueue
+	{
+	public:
+		void queue(const std::shared_ptr<Invoker> &i)
+		{
+			std::lock_guard<std::mutex> guard(m_Lock);
+			m_vQueue.push_back(i);
+		}
+
+		bool pump()
+		{
+			std::deque<std::shared_ptr<Invoker>> vQueue;
+
+			{
+				std::lock_guard<std::mutex> guard(m_Lock);
+				vQueue.swap(m_vQueue);
+			}
+
+			for (auto i : vQueue)
+				i->invoke();
+
+			return !vQueue.empty();
+		}
+
+		void drop()
+		{
+			std::lock_guard<std::mutex> guard(m_Lock);
+			m_vQueue.clear();
+		}
+
+	private:
+		std::mutex m_Lock;
+		std::deque<std::shared_ptr<Invoker>> m_vQueue;
+	};
+
+	//Same invoker handling as GuiDelegate in MODE_PENDING_WAIT without needing a window.
+	//Events keep a clone so the invokers live outside the delegate where the test can see them
+	class PendingWaitDelegate : public DelegateI<int&>
+	{
+	public:
+		PendingWaitDelegate(FakeGuiQueue &queue, PendingInvokers &invokers, std::atomic<int> &count)
+			: m_Queue(queue)
+			, m_Invokers(invokers)
+			, m_nCount(count)
+		{
+		}
+
+		void operator()(int& a) override
+		{
+			std::function<void()> pcb = [this, &a](){
+				++a;
+				++m_nCount;
+			};
+
+			auto invoker = std::make_shared<Invoker>(pcb);
+
+			if (!m_Invokers.add(invoker))
+				return;
+
+			m_Queue.queue(invoker);
+			invoker->wait();
+
+			m_Invokers.remove(invoker);
+		}
+
+		bool equals(DelegateI<int&>* d) override
+		{
+			return d->getCompareHash() == getCompareHash();
+		}
+
+		DelegateI<int&>* clone() override
+		{
+			return new PendingWaitDelegate(m_Queue, m_Invokers, m_nCount);
+		}
+
+		uint64 getCompareHash() const override
+		{
+			return (uint64)&m_Queue;
+		}
+
+		void destroy() override
+		{
+			delete this;
+		}
+
+	private:
+		FakeGuiQueue &m_Queue;
+		PendingInvokers &m_Invokers;
+		std::atomic<int> &m_nCount;
+	};
+
+	//Fires arent serialized per event anymore so several threads can be waiting on the
+	//gui thread through the one delegate. Each waiting fire has to get its own callback.
+	TEST(Event, ConcurrentPendingWaitFire)
+	{
+		const int nProducers = 4;
+		const int nFires = 500;
+
+		FakeGuiQueue queue;
+		PendingInvokers invokers;
+		std::atomic<int> nCount(0);
+
+		Event<int> event;
+		event += new PendingWaitDelegate(queue, invokers, nCount);
+
+		std::atomic<int> nFinished(0);
+		std::vector<std::thread> vProducers;
+
+		for (int x = 0; x < nProducers; ++x)
+		{
+			vProducers.push_back(std::thread([&](){
+				for (int y = 0; y < nFires; ++y)
+				{
+					int val = 0;
+					event(val);
+					EXPECT_EQ(1, val);
+				}
+
+				++nFinished;
+			}));
+		}
+
+		while (nFinished != nProducers)
+		{
+			if (!queue.pump())
+				std::this_thread::yield();
+		}
+
+		for (auto &t : vProducers)
+			t.join();
+
+		EXPECT_EQ(nProducers * nFires, nCount);
+		EXPECT_EQ(0u, invokers.size());
+	}
+
+	//Canceling has to release every thread waiting on the delegate, not just the last one
+	TEST(Event, ConcurrentPendingWaitCancel)
+	{
+		const int nProducers = 4;
+
+		FakeGuiQueue queue;
+		PendingInvokers invokers;
+		std::atomic<int> nCount(0);
+
+		Event<int> event;
+		event += new PendingWaitDelegate(queue, invokers, nCount);
+
+		std::vector<std::thread> vProducers;
+
+		for (int x = 0; x < nProducers; ++x)
+		{
+			vProducers.push_back(std::thread([&](){
+				int val = 0;
+				event(val);
+			}));
+		}
+
+		auto end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+		while (invokers.size() != nProducers && std::chrono::steady_clock::now() < end)
+			std::this_thread::yield();
+
+		EXPECT_EQ((size_t)nProducers, invokers.size());
+
+		//gui never runs them, cancel has to wake them all
+		queue.drop();
+		invokers.cancelAll();
+
+		for (auto &t : vProducers)
+			t.join();
+
+		EXPECT_EQ(0, nCount);
+
+		//fires after the cancel dont wait at all
+		int val = 0;
+		event(val);
+		EXPECT_EQ(0, val);
+	}
+
+	class CountedDelegate : public DelegateI<int&>
+	{
+	public:
+		CountedDelegate(uint64 nHash)
+			: m_nHash(nHash)
+		{
+			++s_nLive;
+		}
+
+		void operator()(int&) override
+		{
+		}
+
+		bool equals(DelegateI<int&>* d) override
+		{
+			return d->getCompareHash() == m_nHash;
+		}
+
+		DelegateI<int&>* clone() override
+		{
+			return new CountedDelegate(m_nHash);
+		}
+
+		uint64 getCompareHash() const override
+		{
+			return m_nHash;
+		}
+
+		void destroy() override
+		{
+			delete this;
+		}
+
+		static std::atomic<int> s_nLive;
+
+	protected:
+		~CountedDelegate()
+		{
+			--s_nLive;
+		}
+
+	private:
+		const uint64 m_nHash;
+	};
+
+	std::atomic<int> CountedDelegate::s_nLive(0);
+
+	//Producers keep firing so there is never a moment with no fire in progress. Removed
+	//delegates still have to be freed as the fires that could see them finish.
+	TEST(Event, RetiredFreedUnderSustainedFire)
+	{
+		const int nProducers = 4;
+
+		{
+			Event<int> event;
+			DispatchCallback a;
+
+			event += delegate(&a, &DispatchCallback::callback);
+
+			std::atomic<bool> bDone(false);
+			std::vector<std::thread> vProducers;
+
+			for (int x = 0; x < nProducers; ++x)
+			{
+				vProducers.push_back(std::thread([&](){
+					int y = 0;
+
+					while (!bDone)
+						event(y);
+				}));
+			}
+
+			while (a.count < 1000)
+				std::this_thread::yield();
+
+			for (int x = 0; x < 20000; ++x)
+			{
+				event += new CountedDelegate(1);
+				event -= new CountedDelegate(1);
+			}
+
+			//the producers are still firing, the fires that saw the removed delegates finish
+			//and the next one to end frees them
+			auto end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+			while (CountedDelegate::s_nLive != 0 && std::chrono::steady_clock::now() < end)
+				std::this_thread::yield();
+
+			EXPECT_EQ(0, CountedDelegate::s_nLive);
+
+			bDone = true;
+
+			for (auto &t : vProducers)
+				t.join();
+		}
+
+		EXPECT_EQ(0, CountedDelegate::s_nLive);
+	}
+
+	//8 producers fire the same event while another thread adds and removes a delegate.
+	//Fires dont take a lock so the producers should scale instead of queuing on the event.
+	TEST(Event, ContentionBenchmark)
+	{
+		const int nProducers = 8;
+		const int nFires = 200000;
+
+		Event<int> event;
+		DispatchCallback a;
+		DispatchCallback b;
+
+		event += delegate(&a, &DispatchCallback::callback);
+
+		std::atomic<bool> bStart(false);
+		std::atomic<bool> bDone(false);
+		std::vector<std::thread> vProducers;
+
+		for (int x = 0; x < nProducers; ++x)
+		{
+			vProducers.push_back(std::thread([&](){
+				while (!bStart)
+					std::this_thread::yield();
+
+				for (int y = 0; y < nFires; ++y)
+					event(y);
+			}));
+		}
+
+		std::thread churn([&](){
+			while (!bDone)
+			{
+				event += delegate(&b, &DispatchCallback::callback);
+				event -= delegate(&b, &DispatchCallback::callback);
+			}
+		});
+
+		auto start = std::chrono::steady_clock::now();
+		bStart = true;
+
+		for (auto &t : vProducers)
+			t.join();
+
+		auto end = std::chrono::steady_clock::now();
+
+		bDone = true;
+		churn.join();
+
+		auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		RecordProperty("NsPerFire", (int)(nanos / ((int64)nProducers * nFires)));
+
+		EXPECT_EQ(nProducers * nFires, a.count);
+	}
 }
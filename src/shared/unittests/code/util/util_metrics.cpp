@@ -0,0 +1,127 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+#include "Common.h"
+#include "util/UtilMetrics.h"
+
+#include <thread>
+#include <vector>
+
+using namespace UTIL::METRICS;
+
+namespace UnitTest
+{
+	TEST(Metrics, CounterSumsAllThreads)
+	{
+		Counter counter;
+
+		std::vector<std::thread> vThreads;
+
+		for (uint32 x = 0; x < 8; ++x)
+		{
+			vThreads.push_back(std::thread([&counter]()
+			{
+				for (uint32 y = 0; y < 100000; ++y)
+					counter.add();
+			}));
+		}
+
+		for (auto &t : vThreads)
+			t.join();
+
+		ASSERT_EQ(800000u, counter.get());
+	}
+
+	TEST(Metrics, HistogramBucketsRoundTrip)
+	{
+		const uint32 nSubBuckets = Histogram::SUB_BUCKETS;
+		const uint32 nBucketCount = Histogram::BUCKET_COUNT;
+
+		for (uint64 x = 0; x < 100000; x += 7)
+		{
+			uint32 nBucket = Histogram::getBucket(x);
+			uint64 nLow = Histogram::getBucketValue(nBucket);
+
+			ASSERT_LE(nLow, x);
+			ASSERT_EQ(nBucket, Histogram::getBucket(nLow));
+			ASSERT_LE(x - nLow, x / nSubBuckets);
+		}
+
+		ASSERT_LT(Histogram::getBucket((uint64)-1), nBucketCount);
+	}
+
+	TEST(Metrics, HistogramPercentiles)
+	{
+		Histogram histogram;
+
+		for (uint64 x = 1; x <= 1000; ++x)
+			histogram.record(x);
+
+		auto snap = histogram.snapshot();
+
+		ASSERT_EQ(1000u, snap.m_nCount);
+		ASSERT_EQ(500500u, snap.m_nSum);
+		ASSERT_EQ(1000u, snap.m_nMax);
+
+		//Within the 12.5% bucket width
+		ASSERT_NEAR(500.0, (double)snap.getPercentile(50), 500 / 8.0);
+		ASSERT_NEAR(990.0, (double)snap.getPercentile(99), 990 / 8.0);
+		ASSERT_EQ(1000u, snap.getPercentile(100));
+	}
+
+	TEST(Metrics, RegistrySnapshotJson)
+	{
+		Registry registry;
+
+		registry.counter("bytes").add(100);
+		registry.gauge("depth").set(3);
+		registry.histogram("latency_us").record(10);
+
+		ASSERT_EQ(&registry.counter("bytes"), &registry.counter("bytes"));
+
+		Snapshot first;
+		registry.snapshot(first);
+
+		registry.counter("bytes").add(200);
+
+		Snapshot second;
+		registry.snapshot(second);
+
+		std::string strJson;
+		second.toJson(strJson, &first, 2.0);
+
+		ASSERT_EQ("{ \"counters\": { \"bytes\": { \"value\": 300, \"per_sec\": 100 } }, \"gauges\": { \"depth\": 3 }, "
+			"\"histograms\": { \"latency_us\": { \"count\": 1, \"sum\": 10, \"mean\": 10, \"p50\": 10, \"p90\": 10, \"p99\": 10, \"max\": 10 } } }", strJson);
+	}
+
+	TEST(Metrics, RegistrySnapshotJsonEscapesNames)
+	{
+		Registry registry;
+		registry.gauge("say \"hi\"\\now").set(1);
+
+		Snapshot snap;
+		registry.snapshot(snap);
+
+		std::string strJson;
+		snap.toJson(strJson);
+
+		ASSERT_NE(std::string::npos, strJson.find("\"say \\\"hi\\\"\\\\now\": 1"));
+	}
+}
@@ -0,0 +1,150 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+#include "Common.h"
+#include "util/UtilTimeline.h"
+
+#include <thread>
+
+using namespace UTIL::TIMELINE;
+
+namespace UnitTest
+{
+	static size_t CountOf(const std::string &strHaystack, const std::string &strNeedle)
+	{
+		size_t nCount = 0;
+		size_t nPos = strHaystack.find(strNeedle);
+
+		while (nPos != std::string::npos)
+		{
+			++nCount;
+			nPos = strHaystack.find(strNeedle, nPos + strNeedle.size());
+		}
+
+		return nCount;
+	}
+
+	TEST(Timeline, DisabledRecordsNothing)
+	{
+		auto &timeline = GetTimeline();
+		timeline.clear();
+		timeline.setEnabled(false);
+
+		{
+			ScopedSpan span("test", "disabled");
+		}
+
+		std::string strEvents;
+		timeline.appendEvents(strEvents);
+
+		ASSERT_EQ(std::string::npos, strEvents.find("\"disabled\""));
+	}
+
+	TEST(Timeline, SpanWritesChromeEvent)
+	{
+		auto &timeline = GetTimeline();
+		timeline.clear();
+		timeline.setEnabled(true);
+		timeline.setThreadName("unit \"test\"");
+
+		{
+			ScopedSpan span("mcf", "download", "item {0}", 42);
+		}
+
+		timeline.setEnabled(false);
+
+		std::vector<Timeline*> vTimelines;
+		vTimelines.push_back(&timeline);
+
+		auto strTrace = FormatChromeTrace(vTimelines, true);
+
+		ASSERT_EQ(0u, strTrace.find("{ \"displayTimeUnit\": \"ms\", \"traceEvents\": ["));
+		ASSERT_NE(std::string::npos, strTrace.find("\"ph\": \"X\""));
+		ASSERT_NE(std::string::npos, strTrace.find("\"cat\": \"mcf\", \"name\": \"download\", \"args\": { \"detail\": \"item 42\" }"));
+		ASSERT_NE(std::string::npos, strTrace.find("\"name\": \"unit \\\"test\\\"\""));
+
+		std::string strEvents;
+		timeline.appendEvents(strEvents);
+		ASSERT_EQ(std::string::npos, strEvents.find("\"download\""));
+	}
+
+	TEST(Timeline, FullBufferKeepsNewest)
+	{
+		auto &timeline = GetTimeline();
+		timeline.clear();
+
+		const uint32 nBufferSize = BUFFER_SIZE;
+		auto now = std::chrono::steady_clock::now();
+
+		for (uint32 x = 0; x < nBufferSize; ++x)
+			timeline.record("test", "old", std::string(), now, now);
+
+		for (uint32 x = 0; x < 10; ++x)
+			timeline.record("test", "new", std::string(), now, now);
+
+		std::string strEvents;
+		timeline.appendEvents(strEvents, true);
+
+		ASSERT_EQ(nBufferSize - 10, CountOf(strEvents, "\"name\": \"old\""));
+		ASSERT_EQ(10u, CountOf(strEvents, "\"name\": \"new\""));
+	}
+
+	TEST(Timeline, ExitedThreadNamesAreTrimmed)
+	{
+		Timeline timeline;
+		timeline.setEnabled(true);
+
+		std::thread([&timeline](){
+			timeline.setThreadName("short lived");
+			timeline.record("test", "work", std::string(), std::chrono::steady_clock::now(), std::chrono::steady_clock::now());
+			timeline.threadExited();
+		}).join();
+
+		//still named while its spans are around
+		std::string strEvents;
+		timeline.appendEvents(strEvents);
+		ASSERT_EQ(1u, CountOf(strEvents, "\"short lived\""));
+
+		strEvents.clear();
+		timeline.appendEvents(strEvents, true);
+		ASSERT_EQ(1u, CountOf(strEvents, "\"short lived\""));
+
+		strEvents.clear();
+		timeline.appendEvents(strEvents);
+		ASSERT_EQ(0u, CountOf(strEvents, "\"short lived\""));
+	}
+
+	TEST(Timeline, ExitedThreadNamesAreBounded)
+	{
+		Timeline timeline;
+
+		for (uint32 x = 0; x < MAX_EXITED_THREAD_NAMES + 10; ++x)
+		{
+			std::thread([&timeline](){
+				timeline.setThreadName("churn");
+				timeline.threadExited();
+			}).join();
+		}
+
+		std::string strEvents;
+		timeline.appendEvents(strEvents);
+		ASSERT_GE(MAX_EXITED_THREAD_NAMES, CountOf(strEvents, "\"churn\""));
+	}
+}
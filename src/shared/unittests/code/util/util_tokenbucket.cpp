@@ -0,0 +1,114 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+#include "Common.h"
+#include "util/UtilTokenBucket.h"
+
+#include <thread>
+
+using namespace UTIL::MISC;
+
+namespace UnitTest
+{
+	TEST(TokenBucket, UnlimitedNeverWaits)
+	{
+		TokenBucket bucket;
+
+		for (uint32 x = 0; x < 100; ++x)
+			ASSERT_EQ(0, bucket.take(1024 * 1024).count());
+	}
+
+	TEST(TokenBucket, BurstIsFree)
+	{
+		TokenBucket bucket(1000, 500);
+
+		ASSERT_EQ(0, bucket.take(300).count());
+		ASSERT_EQ(0, bucket.take(200).count());
+	}
+
+	TEST(TokenBucket, DebtIsPaidAtRate)
+	{
+		TokenBucket bucket(1000, 1000);
+
+		ASSERT_EQ(0, bucket.take(1000).count());
+
+		//500 tokens short at 1000 per second is about half a second
+		auto wait = bucket.take(500);
+		ASSERT_GT(wait.count(), 400000);
+		ASSERT_LE(wait.count(), 500000);
+	}
+
+	TEST(TokenBucket, ChargeDebtIsCappedAtBurst)
+	{
+		TokenBucket bucket(1000, 1000);
+
+		for (uint32 x = 0; x < 10; ++x)
+			bucket.charge(1000);
+
+		//one burst of debt plus the 500 taken here
+		auto wait = bucket.take(500);
+		ASSERT_GT(wait.count(), 1400000);
+		ASSERT_LE(wait.count(), 1500000);
+
+		//debt from take is not forgiven by a later charge
+		bucket.charge(1000);
+		ASSERT_GT(bucket.take(1).count(), 1400000);
+	}
+
+	TEST(TokenBucket, RefillsOverTime)
+	{
+		TokenBucket bucket(10000, 10000);
+
+		ASSERT_EQ(0, bucket.take(10000).count());
+		ASSERT_GT(bucket.take(1000).count(), 0);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+		//debt of 1000 is paid off after 100ms, the rest builds up again
+		ASSERT_EQ(0, bucket.take(1000).count());
+	}
+
+	TEST(TokenBucket, ConsumeHoldsRate)
+	{
+		TokenBucket bucket(100000, 10000);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint32 x = 0; x < 20; ++x)
+			bucket.consume(5000);
+
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+		//100000 tokens with 10000 free up front at 100000 a second
+		ASSERT_GE(ms, 850);
+		ASSERT_LT(ms, 1500);
+	}
+
+	TEST(TokenBucket, SetRateToZeroRemovesLimit)
+	{
+		TokenBucket bucket(1000, 1000);
+
+		bucket.take(5000);
+		bucket.setRate(0);
+
+		ASSERT_EQ(0, bucket.getRate());
+		ASSERT_EQ(0, bucket.take(5000).count());
+	}
+}
@@ -0,0 +1,50 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+#include "Common.h"
+#include "XMLMacros.h"
+
+namespace UnitTest
+{
+	static uint64 HashOf(const char* szXml, const char* szRoot = "item")
+	{
+		XML::gcXMLDocument doc(szXml, strlen(szXml));
+		return doc.GetRoot(szRoot).GetContentHash();
+	}
+
+	TEST(XMLContentHash, IgnoresFormatting)
+	{
+		ASSERT_EQ(HashOf("<item id=\"1\"><branch id=\"2\">abc</branch></item>"),
+				  HashOf("<item id=\"1\">\n\t<branch id=\"2\">abc</branch>\n</item>"));
+	}
+
+	TEST(XMLContentHash, ChangesWithContent)
+	{
+		auto base = HashOf("<item id=\"1\"><branch id=\"2\">abc</branch></item>");
+
+		ASSERT_NE(base, HashOf("<item id=\"1\"><branch id=\"3\">abc</branch></item>"));
+		ASSERT_NE(base, HashOf("<item id=\"1\"><branch id=\"2\">abd</branch></item>"));
+		ASSERT_NE(base, HashOf("<item id=\"1\"><branch id=\"2\">abc</branch><branch/></item>"));
+	}
+	TEST(XMLContentHash, NestingMatters)
+	{
+		ASSERT_NE(HashOf("<item><a/><b/></item>"), HashOf("<item><a><b/></a></item>"));
+		ASSERT_NE(HashOf("<item><a>bc</a></item>"), HashOf("<item><ab>c</ab></item>"));
+	}
+}
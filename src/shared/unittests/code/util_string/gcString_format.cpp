@@ -0,0 +1,137 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+
+#include <chrono>
+
+using namespace Template;
+
+namespace UnitTest
+{
+	template <typename A, typename B, typename C>
+	void CheckSameAsLegacy(const char* szFormat, const A &a, const B &b, const C &c)
+	{
+		std::string strLegacy = FormatLegacy(szFormat, a, b, c, NullArg(), NullArg(), NullArg());
+		std::string strNew = Format(szFormat, a, b, c);
+
+		ASSERT_STREQ(strLegacy.c_str(), strNew.c_str()) << "Format: " << szFormat;
+	}
+
+	TEST(gcStringFormat, MatchesLegacyPlaceHolders)
+	{
+		CheckSameAsLegacy("{0} {1} {2}", 1, "two", std::string("three"));
+		CheckSameAsLegacy("{2}{1}{0}", -1, 2u, 3ull);
+		CheckSameAsLegacy("{0,5}|{1,8}|{2,3}", 42, "ab", gcString("abcdef"));
+		CheckSameAsLegacy("{0,5.2}|{1.3}|{2,6.1}", 1.5, 2.25f, 10);
+		CheckSameAsLegacy("{0:x}|{1:xb}|{2:bs}", 255, 4096, true);
+		CheckSameAsLegacy("{0:u64}|{1:i64}|{2:d}", 7, -7, 3);
+		CheckSameAsLegacy("{0:c}|{1:u}|{2:i}", 65, (char)66, 3.0f);
+		CheckSameAsLegacy("{0}|{1}|{2}", true, (uint8)65, 'x');
+		CheckSameAsLegacy("{0}|{1}|{2}", (const char*)nullptr, (void*)nullptr, -9223372036854775807LL);
+		CheckSameAsLegacy("{0}|{1}|{2}", (short)-5, (unsigned short)5, 18446744073709551615ull);
+	}
+
+	TEST(gcStringFormat, MatchesLegacyMalformed)
+	{
+		CheckSameAsLegacy("{{0}} {} {a} {5} {10}", 1, 2, 3);
+		CheckSameAsLegacy("trailing {", 1, 2, 3);
+		CheckSameAsLegacy("unclosed {0 and {1", 1, 2, 3);
+		CheckSameAsLegacy("nested {a{b{0}", 1, 2, 3);
+		CheckSameAsLegacy("{0,} {1.} {2:}", 1, 2, 3);
+		CheckSameAsLegacy("{0:zz} {1,.4} }{", 1, 2.5, 3);
+		CheckSameAsLegacy("", 1, 2, 3);
+		CheckSameAsLegacy("no place holders", 1, 2, 3);
+	}
+
+#if !defined(_MSC_VER) || _MSC_VER >= 1900
+	TEST(gcStringFormat, CompileTimeCheck)
+	{
+		static_assert(FormatCheck::IsValid("{0} {1} {2}", 3), "");
+		static_assert(FormatCheck::IsValid("{2}{1}{0}", 3), "");
+		static_assert(FormatCheck::IsValid("{0,5.2}|{1:x}|{2:bs}", 3), "");
+		static_assert(FormatCheck::IsValid(L"{0} {1}", 2), "");
+
+		//no arguments means the format isnt parsed
+		static_assert(FormatCheck::IsValid("{5}", 0), "");
+
+		//same rules as the runtime parser for things that arent place holders
+		static_assert(FormatCheck::IsValid("{} {a} trailing {", 1), "");
+		static_assert(FormatCheck::IsValid("unclosed {5", 1), "");
+		static_assert(FormatCheck::IsValid("nested {5{0}", 1), "");
+		static_assert(FormatCheck::IsValid("{10}", 2), "");
+
+		static_assert(!FormatCheck::IsValid("{1}", 1), "");
+		static_assert(!FormatCheck::IsValid("{0} {1} {3}", 3), "");
+		static_assert(!FormatCheck::IsValid("nested {0{5}", 1), "");
+		static_assert(!FormatCheck::IsValid(L"{2}", 1), "");
+
+		//non literal formats are left to the runtime check
+		const char* szFormat = "{5}";
+		static_assert(FormatCheck::IsValid(szFormat, 1), "");
+
+		int a = 1;
+		gcFormatCheck("{0} {1}", a, szFormat);
+
+		static_assert(decltype(FormatCheck::CountArgs("{0}", a, szFormat, gcString()))::value == 3, "");
+	}
+#endif
+
+	TEST(gcStringFormat, WideStrings)
+	{
+		gcWString strWide(L"{0} {1} {2}", L"wide", 12, std::wstring(L"str"));
+		ASSERT_TRUE(strWide == L"wide 12 str");
+
+		gcString strNarrow("{0}-{1}", L"wide", gcWString(L"str"));
+		ASSERT_STREQ("wide-str", strNarrow.c_str());
+
+		gcWString strConverted("{0}", 5);
+		ASSERT_TRUE(strConverted == L"5");
+	}
+
+	TEST(gcStringFormat, Benchmark)
+	{
+		const size_t nIterations = 100000;
+		const char* szPath = "/home/user/.desura/games/some_game/data/file.pak";
+
+		size_t nLegacyTotal = 0;
+		size_t nNewTotal = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (size_t x = 0; x < nIterations; ++x)
+			nLegacyTotal += FormatLegacy("SMT Worker {0} of {1}: {2} [{3,8}]", x, nIterations, szPath, x * 7, NullArg(), NullArg()).size();
+
+		auto legacy = std::chrono::steady_clock::now();
+
+		for (size_t x = 0; x < nIterations; ++x)
+			nNewTotal += gcString("SMT Worker {0} of {1}: {2} [{3,8}]", x, nIterations, szPath, x * 7).size();
+
+		auto end = std::chrono::steady_clock::now();
+
+		ASSERT_EQ(nLegacyTotal, nNewTotal);
+
+		auto legacyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(legacy - start).count() / nIterations;
+		auto newNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - legacy).count() / nIterations;
+
+		RecordProperty("LegacyNsPerFormat", (int)legacyNs);
+		RecordProperty("NsPerFormat", (int)newNs);
+	}
+}
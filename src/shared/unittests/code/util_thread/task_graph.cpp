@@ -0,0 +1,196 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+#include "Common.h"
+#include "util_thread/TaskGraph.h"
+
+#include <atomic>
+
+using namespace Thread;
+
+namespace UnitTest
+{
+	TEST(TaskGraph, RunsAfterDependencies)
+	{
+		auto pool = gcRefPtr<ThreadPool>::create(2);
+
+		std::mutex lock;
+		std::vector<std::string> vOrder;
+
+		auto record = [&lock, &vOrder](const char* szName)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			vOrder.push_back(szName);
+		};
+
+		TaskGraph graph("test");
+		auto a = graph.addTask("a", [&](){ gcSleep(20); record("a"); });
+		auto b = graph.addTask("b", [&](){ record("b"); });
+		graph.addTask("c", [&](){ record("c"); }, { a, b });
+
+		graph.run(pool);
+
+		ASSERT_EQ(3u, vOrder.size());
+		ASSERT_EQ("c", vOrder[2]);
+	}
+
+	TEST(TaskGraph, IndependentTasksOverlap)
+	{
+		auto pool = gcRefPtr<ThreadPool>::create(2);
+
+		TaskGraph graph("test");
+		auto a = graph.addTask("a", [](){ gcSleep(100); });
+		auto b = graph.addTask("b", [](){ gcSleep(100); });
+		graph.addTask("c", [](){}, { a, b });
+
+		graph.run(pool);
+
+		ASSERT_LT(graph.getDuration().count(), 180);
+		ASSERT_NE(std::string::npos, graph.getReport().find("c: start"));
+	}
+
+	TEST(TaskGraph, FailureSkipsDependents)
+	{
+		auto pool = gcRefPtr<ThreadPool>::create(2);
+
+		std::atomic<bool> bRanDependent = {false};
+		std::atomic<bool> bRanOther = {false};
+
+		TaskGraph graph("test");
+		auto a = graph.addTask("a", [](){ throw gcException(ERR_BADXML); });
+		auto b = graph.addTask("b", [&](){ gcSleep(20); bRanOther = true; });
+		graph.addTask("c", [&](){ bRanDependent = true; }, { a, b });
+
+		try
+		{
+			graph.run(pool);
+			FAIL();
+		}
+		catch (gcException &e)
+		{
+			ASSERT_EQ(ERR_BADXML, e.getErrId());
+		}
+
+		ASSERT_TRUE(bRanOther);
+		ASSERT_FALSE(bRanDependent);
+		ASSERT_NE(std::string::npos, graph.getReport().find("c: skipped"));
+	}
+
+	TEST(TaskGraph, CancelSkipsTasksNotStarted)
+	{
+		auto pool = gcRefPtr<ThreadPool>::create(2);
+
+		std::atomic<bool> bStoppedEarly = {false};
+		std::atomic<bool> bRanDependent = {false};
+
+		TaskGraph graph("test");
+
+		graph.addTask("a", [&](){
+			gcSleep(20);
+			graph.cancel();
+			throw gcException(ERR_BADXML);
+		});
+
+		auto b = graph.addTask("b", [&](){
+			for (size_t x=0; x<500 && !graph.isCancelled(); x++)
+				gcSleep(10);
+
+			bStoppedEarly = graph.isCancelled();
+		});
+
+		graph.addTask("c", [&](){ bRanDependent = true; }, { b });
+
+		try
+		{
+			graph.run(pool);
+			FAIL();
+		}
+		catch (gcException &e)
+		{
+			ASSERT_EQ(ERR_BADXML, e.getErrId());
+		}
+
+		ASSERT_TRUE(bStoppedEarly);
+		ASSERT_FALSE(bRanDependent);
+		ASSERT_LT(graph.getDuration().count(), 2000);
+		ASSERT_NE(std::string::npos, graph.getReport().find("c: skipped"));
+	}
+
+	TEST(TaskGraph, CancelInlineSkipsLaterTasks)
+	{
+		std::vector<int> vOrder;
+
+		TaskGraph graph("test");
+		graph.addTask("a", [&](){ vOrder.push_back(1); graph.cancel(); });
+		graph.addTask("b", [&](){ vOrder.push_back(2); });
+
+		graph.run(gcRefPtr<ThreadPoolI>());
+
+		ASSERT_EQ(1u, vOrder.size());
+		ASSERT_TRUE(graph.isCancelled());
+		ASSERT_NE(std::string::npos, graph.getReport().find("b: skipped"));
+	}
+
+	TEST(TaskGraph, RunsInlineWithoutPool)
+	{
+		std::vector<int> vOrder;
+
+		TaskGraph graph("test");
+		auto a = graph.addTask("a", [&](){ vOrder.push_back(1); });
+		graph.addTask("b", [&](){ vOrder.push_back(2); }, { a });
+
+		graph.run(gcRefPtr<ThreadPoolI>());
+
+		ASSERT_EQ(2u, vOrder.size());
+		ASSERT_EQ(2, vOrder[1]);
+	}
+
+	//Same shape as the login graph in User_Login.cpp, with sleeps standing in for each step
+	static void AddLoginSteps(TaskGraph &graph)
+	{
+		auto loadTools = graph.addTask("Load tools", [](){ gcSleep(20); });
+		auto readItems = graph.addTask("Read item db", [](){ gcSleep(80); });
+		auto login = graph.addTask("Web login", [](){ gcSleep(150); });
+		auto connectService = graph.addTask("Connect service", [](){ gcSleep(40); }, { login });
+		graph.addTask("Queue avatar", [](){}, { login });
+		auto loadItems = graph.addTask("Load items", [](){ gcSleep(30); }, { readItems, login, connectService });
+		auto parseLogin = graph.addTask("Parse login", [](){ gcSleep(40); }, { loadTools, loadItems, connectService });
+		graph.addTask("Start update thread", [](){ gcSleep(5); }, { parseLogin });
+	}
+
+	TEST(TaskGraph, LoginShapeLatency)
+	{
+		auto pool = gcRefPtr<ThreadPool>::create(4);
+
+		TaskGraph sequential("login sequential");
+		AddLoginSteps(sequential);
+		sequential.run(gcRefPtr<ThreadPoolI>());
+
+		TaskGraph graph("login graph");
+		AddLoginSteps(graph);
+		graph.run(pool);
+
+		//web login, connect service, load items, parse and update thread are the critical path
+		ASSERT_LT(graph.getDuration().count(), sequential.getDuration().count());
+
+		RecordProperty("sequential_ms", gcString("{0}", (uint32)sequential.getDuration().count()));
+		RecordProperty("graph_ms", gcString("{0}", (uint32)graph.getDuration().count()));
+	}
+}
@@ -0,0 +1,309 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+
+#include "Common.h"
+#include "BackgroundModeMonitor.h"
+
+#ifdef NIX
+#include "util/UtilLinux.h"
+#endif
+
+using namespace UserCore::Misc;
+
+
+BackgroundModeMonitor::BackgroundModeMonitor(ApplyFn applyFn, ProcessListFn processListFn)
+	: ::Thread::BaseThread("BackgroundMode Thread")
+	, m_fnApply(applyFn)
+	, m_fnProcessList(processListFn)
+	, m_PollTime(std::chrono::seconds(2))
+	, m_GraceTime(std::chrono::seconds(15))
+{
+}
+
+BackgroundModeMonitor::~BackgroundModeMonitor()
+{
+	stop();
+
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+		m_mLaunches.clear();
+	}
+
+	updateBackgroundMode();
+}
+
+void BackgroundModeMonitor::setTiming(std::chrono::milliseconds pollTime, std::chrono::milliseconds graceTime)
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	m_PollTime = pollTime;
+	m_GraceTime = graceTime;
+}
+
+void BackgroundModeMonitor::onItemLaunched(DesuraId id, const char* szPath)
+{
+	if (!szPath || !szPath[0])
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+
+		Launch launch;
+		launch.strPath = szPath;
+		launch.tLaunched = std::chrono::steady_clock::now();
+
+		m_mLaunches[id.toInt64()] = launch;
+	}
+
+	updateBackgroundMode();
+
+	start();
+	m_WaitCond.notify();
+}
+
+std::vector<uint32> BackgroundModeMonitor::getLaunchProcesses(const char* szPath)
+{
+#ifdef WIN32
+	return UTIL::WIN::getProcessesRunningAtPath(szPath);
+#else
+	return UTIL::LIN::getProcessesUsingPath(szPath);
+#endif
+}
+
+bool BackgroundModeMonitor::isBackgroundMode()
+{
+	return m_bBackground;
+}
+
+void BackgroundModeMonitor::run()
+{
+	while (!isStopped())
+	{
+		std::chrono::milliseconds pollTime;
+
+		{
+			std::lock_guard<std::mutex> guard(m_Lock);
+			pollTime = m_PollTime;
+		}
+
+		m_WaitCond.wait(0, (int)pollTime.count());
+
+		if (isStopped())
+			break;
+
+		poll();
+	}
+}
+
+void BackgroundModeMonitor::onStop()
+{
+	m_WaitCond.notify();
+}
+
+void BackgroundModeMonitor::poll(std::chrono::steady_clock::time_point tNow)
+{
+	std::map<uint64, Launch> mLaunches;
+	std::chrono::milliseconds graceTime;
+
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+		mLaunches = m_mLaunches;
+		graceTime = m_GraceTime;
+	}
+
+	std::vector<uint64> vExited;
+
+	for (auto &l : mLaunches)
+	{
+		if (tNow - l.second.tLaunched < graceTime)
+			continue;
+
+		if (m_fnProcessList(l.second.strPath.c_str()).empty())
+			vExited.push_back(l.first);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+
+		for (auto id : vExited)
+		{
+			//relaunched while we were checking
+			auto it = m_mLaunches.find(id);
+
+			if (it != m_mLaunches.end() && it->second.tLaunched == mLaunches[id].tLaunched)
+				m_mLaunches.erase(it);
+		}
+	}
+
+	updateBackgroundMode();
+}
+
+void BackgroundModeMonitor::updateBackgroundMode()
+{
+	std::lock_guard<std::mutex> applyGuard(m_ApplyLock);
+
+	bool bEnabled = false;
+
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+		bEnabled = !m_mLaunches.empty();
+	}
+
+	if (m_bBackground == bEnabled)
+		return;
+
+	m_bBackground = bEnabled;
+
+	Msg(gcString("Background mode {0} for installs and downloads\n", bEnabled ? "on" : "off"));
+
+	if (m_fnApply)
+		m_fnApply(bEnabled);
+}
+
+
+
+#ifdef LINK_WITH_GTEST
+
+namespace UnitTest
+{
+	class BackgroundModeMonitorFixture : public ::testing::Test
+	{
+	public:
+		BackgroundModeMonitorFixture()
+		{
+			pMonitor = gcRefPtr<BackgroundModeMonitor>::create(
+				[this](bool bEnabled){
+					std::lock_guard<std::mutex> guard(m_Lock);
+					vApplied.push_back(bEnabled);
+				},
+				[this](const char* szPath) -> std::vector<uint32> {
+					std::lock_guard<std::mutex> guard(m_Lock);
+
+					if (setRunningPaths.find(szPath) != setRunningPaths.end())
+						return std::vector<uint32>(1, 1234);
+
+					return std::vector<uint32>();
+				});
+
+			//the tests poll by hand, keep the thread out of the way
+			pMonitor->setTiming(std::chrono::hours(1), std::chrono::seconds(10));
+		}
+
+		~BackgroundModeMonitorFixture()
+		{
+			pMonitor->stop();
+		}
+
+		void setRunning(const char* szPath, bool bRunning)
+		{
+			std::lock_guard<std::mutex> guard(m_Lock);
+
+			if (bRunning)
+				setRunningPaths.insert(szPath);
+			else
+				setRunningPaths.erase(szPath);
+		}
+
+		std::vector<bool> getApplied()
+		{
+			std::lock_guard<std::mutex> guard(m_Lock);
+			return vApplied;
+		}
+
+		void pollAfterGrace()
+		{
+			pMonitor->poll(std::chrono::steady_clock::now() + std::chrono::seconds(11));
+		}
+
+		std::mutex m_Lock;
+		std::set<std::string> setRunningPaths;
+		std::vector<bool> vApplied;
+
+		gcRefPtr<BackgroundModeMonitor> pMonitor;
+	};
+
+	TEST_F(BackgroundModeMonitorFixture, OnWhileGameRuns)
+	{
+		setRunning("/games/a", true);
+		pMonitor->onItemLaunched(DesuraId(1, DesuraId::TYPE_GAME), "/games/a");
+
+		ASSERT_TRUE(pMonitor->isBackgroundMode());
+
+		pollAfterGrace();
+		ASSERT_TRUE(pMonitor->isBackgroundMode());
+
+		setRunning("/games/a", false);
+		pollAfterGrace();
+
+		ASSERT_FALSE(pMonitor->isBackgroundMode());
+		ASSERT_EQ(std::vector<bool>({ true, false }), getApplied());
+	}
+
+	TEST_F(BackgroundModeMonitorFixture, GraceWithoutProcess)
+	{
+		pMonitor->onItemLaunched(DesuraId(1, DesuraId::TYPE_GAME), "/games/a");
+
+		//no process yet but still inside the grace period
+		pMonitor->poll();
+		ASSERT_TRUE(pMonitor->isBackgroundMode());
+
+		pollAfterGrace();
+		ASSERT_FALSE(pMonitor->isBackgroundMode());
+	}
+
+	TEST_F(BackgroundModeMonitorFixture, OffOnlyWhenAllExit)
+	{
+		setRunning("/games/a", true);
+		setRunning("/games/b", true);
+
+		pMonitor->onItemLaunched(DesuraId(1, DesuraId::TYPE_GAME), "/games/a");
+		pMonitor->onItemLaunched(DesuraId(2, DesuraId::TYPE_GAME), "/games/b");
+
+		pollAfterGrace();
+		setRunning("/games/a", false);
+		pollAfterGrace();
+
+		ASSERT_TRUE(pMonitor->isBackgroundMode());
+
+		setRunning("/games/b", false);
+		pollAfterGrace();
+
+		ASSERT_FALSE(pMonitor->isBackgroundMode());
+		ASSERT_EQ(std::vector<bool>({ true, false }), getApplied());
+	}
+
+	TEST_F(BackgroundModeMonitorFixture, RelaunchRestartsGrace)
+	{
+		pMonitor->onItemLaunched(DesuraId(1, DesuraId::TYPE_GAME), "/games/a");
+		pollAfterGrace();
+
+		ASSERT_FALSE(pMonitor->isBackgroundMode());
+
+		pMonitor->onItemLaunched(DesuraId(1, DesuraId::TYPE_GAME), "/games/a");
+		pMonitor->poll();
+
+		ASSERT_TRUE(pMonitor->isBackgroundMode());
+		ASSERT_EQ(std::vector<bool>({ true, false, true }), getApplied());
+	}
+}
+
+#endif
@@ -0,0 +1,119 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+
+
+#ifndef DESURA_BACKGROUNDMODEMONITOR_H
+#define DESURA_BACKGROUNDMODEMONITOR_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "util_thread/BaseThread.h"
+
+#include <chrono>
+#include <functional>
+
+namespace UserCore
+{
+	namespace Misc
+	{
+		//! Watches games launched through desura and keeps mcf background mode on while any
+		//! of them are running so installs, verifies and downloads dont make them stutter.
+		//!
+		//! A launch counts as running from the moment it is started. After a grace period
+		//! (launchers and xdg-open take a while to exec the real game) it stays running for as
+		//! long as a process is found with its binary or working dir in the items install folder.
+		//!
+		class BackgroundModeMonitor : public ::Thread::BaseThread, public gcRefBase
+		{
+		public:
+			//! Turns background mode on or off
+			typedef std::function<void(bool bEnabled)> ApplyFn;
+
+			//! Lists process ids running from a folder
+			typedef std::function<std::vector<uint32>(const char* szPath)> ProcessListFn;
+
+			BackgroundModeMonitor(ApplyFn applyFn, ProcessListFn processListFn = &BackgroundModeMonitor::getLaunchProcesses);
+			~BackgroundModeMonitor();
+
+			//! Starts watching an item that was just launched, starts the thread if needed
+			//!
+			//! @param id Item id
+			//! @param szPath Install folder of the item
+			//!
+			void onItemLaunched(DesuraId id, const char* szPath);
+
+			bool isBackgroundMode();
+
+			//! Changes how often processes are checked and how long a launch counts as
+			//! running without a process showing up
+			//!
+			void setTiming(std::chrono::milliseconds pollTime, std::chrono::milliseconds graceTime);
+
+			//! Checks the watched launches for processes and drops the ones that have exited. The
+			//! monitor thread calls this every poll interval
+			//!
+			//! @param tNow Time to measure the grace period against
+			//!
+			void poll(std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now());
+
+			//! Default process list. Matches the working dir as well as the binary on linux so
+			//! games started through a launch script are found
+			//!
+			static std::vector<uint32> getLaunchProcesses(const char* szPath);
+
+			gc_IMPLEMENT_REFCOUNTING(BackgroundModeMonitor);
+
+		protected:
+			void run() override;
+			void onStop() override;
+
+			//! Background mode is on while there are launches being watched
+			void updateBackgroundMode();
+
+			class Launch
+			{
+			public:
+				gcString strPath;
+				std::chrono::steady_clock::time_point tLaunched;
+			};
+
+		private:
+			ApplyFn m_fnApply;
+			ProcessListFn m_fnProcessList;
+
+			std::mutex m_Lock;
+			std::map<uint64, Launch> m_mLaunches;
+
+			std::mutex m_ApplyLock;
+
+			::Thread::WaitCondition m_WaitCond;
+
+			std::chrono::milliseconds m_PollTime;
+			std::chrono::milliseconds m_GraceTime;
+
+			std::atomic<bool> m_bBackground = {false};
+		};
+	}
+}
+
+#endif
@@ -23,6 +23,7 @@ Contact us at legal@badjuju.com.
 #include "Common.h"
 #include "BaseItemServiceTask.h"
 #include "User.h"
+#include "util/UtilTimeline.h"
 
 using namespace UserCore::ItemTask;
 
@@ -64,6 +65,12 @@ void BaseItemServiceTask::doRun()
 
 	try
 	{
+		auto pServiceMain = getServiceMain();
+
+		//keep the service timeline in step with ours so installs show up in both
+		if (pServiceMain)
+			pServiceMain->setTimelineSettings(UTIL::TIMELINE::GetTimeline().isEnabled());
+
 		bool shouldWait = initService();
 
 		if (shouldWait && !m_bFinished && !isStopped())
@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 #include "XMLMacros.h"
 
 #include "BranchInstallInfo.h"
+#include "ItemDbReader.h"
 
 #ifdef WIN32
   #include <Wincrypt.h>
@@ -131,101 +132,42 @@ bool BranchInfo::isSteamGame()
 
 void BranchInfo::acceptEula()
 {
-	m_uiFlags |= BF_ACCEPTED_EULA;
-}
-
-void BranchInfo::deleteFromDb(sqlite3x::sqlite3_connection* db)
-{
-	try
-	{
-		sqlite3x::sqlite3_command cmd(*db, "DELETE FROM branchinfo WHERE branchid=? AND internalid=?;");
-		cmd.bind(1, (int)m_uiBranchId);
-		cmd.bind(2, (long long int)m_ItemId.toInt64());
-		cmd.executenonquery();
-	}
-	catch (...)
-	{
-	}
-
-	try
-	{
-		sqlite3x::sqlite3_command cmd(*db, "DELETE FROM tools WHERE branchid=?;");
-		cmd.bind(1, (int)m_uiBranchId);
-		cmd.executenonquery();
-	}
-	catch (...)
-	{
-	}
-}
+	std::lock_guard<std::mutex> guard(m_BranchLock);
 
-void BranchInfo::saveDb(sqlite3x::sqlite3_connection* db)
-{
-	saveDbFull(db);
+	m_uiFlags |= BF_ACCEPTED_EULA;
+	markDirty();
 }
 
-void BranchInfo::saveDbFull(sqlite3x::sqlite3_connection* db)
+void BranchInfo::saveDb(BranchDbRow &row)
 {
-	{
-		sqlite3x::sqlite3_command cmd(*db, "REPLACE INTO branchinfo VALUES (?,?,?,?,?, ?,?,?,?,?, ?,?);");
-
-		cmd.bind(1, (int) m_uiBranchId);
-		cmd.bind(2, (long long int)m_ItemId.toInt64());
-		cmd.bind(3, m_szName);				//name
-		cmd.bind(4, (int) m_uiFlags);		//flags
-		cmd.bind(5, m_szEulaUrl);
-
-		cmd.bind(6, m_szEulaDate);
-		cmd.bind(7, m_szPreOrderDate);
-		cmd.bind(8, "");
-		cmd.bind(9, UTIL::OS::getRelativePath(m_szInstallScript));
-		cmd.bind(10, (int) m_uiInstallScriptCRC);
-
-		cmd.bind(11, (int) m_uiGlobalId);
-		cmd.bind(12, (int) m_InstallInfo->getBiId());
-
-		cmd.executenonquery();
-	}
-
-	{
-		sqlite3x::sqlite3_command cmd(*db, "DELETE from cdkey WHERE branchid=? and userid=?;");
-		cmd.bind(1, (int)m_uiBranchId);
-		cmd.bind(2, (int)m_uiUserId);
-		cmd.executenonquery();
-	}
-
-	{
-		sqlite3x::sqlite3_command cmd(*db, "INSERT INTO cdkey VALUES (?,?,?);");
-
-		std::lock_guard<std::mutex> guard(m_BranchLock);
-
-		for (auto key : m_vCDKeyList)
-		{
-			cmd.bind(1, (int)m_uiBranchId);
-			cmd.bind(2, (int)m_uiUserId);
-			cmd.bind(3, encodeCDKey(key));
+	std::lock_guard<std::mutex> guard(m_BranchLock);
+	clearDirty();
 
-			cmd.executenonquery();
-		}
-	}
+	row.branchId = m_uiBranchId;
+	row.biid = m_InstallInfo->getBiId();
+	row.userId = m_uiUserId;
 
+	row.name = m_szName;
+	row.flags = m_uiFlags;
+	row.eulaUrl = m_szEulaUrl;
+	row.eulaDate = m_szEulaDate;
+	row.preOrderDate = m_szPreOrderDate;
+	row.installScript = UTIL::OS::getRelativePath(m_szInstallScript);
+	row.installScriptCRC = m_uiInstallScriptCRC;
+	row.globalId = m_uiGlobalId;
 
+	row.tools = m_vToolList;
 
-	{
-		sqlite3x::sqlite3_command cmd(*db, "DELETE from tools WHERE branchid=?;");
-		cmd.bind(1, (int)m_uiBranchId);
-		cmd.executenonquery();
-	}
+	for (auto key : m_vCDKeyList)
+		row.cdKeys.push_back(encodeCDKey(key));
+}
 
-	{
-		sqlite3x::sqlite3_command cmd(*db, "INSERT INTO tools VALUES (?,?);");
+void BranchInfo::saveDbFull(ItemDbStatements &db)
+{
+	BranchDbRow row;
+	saveDb(row);
 
-		for (auto tool : m_vToolList)
-		{
-			cmd.bind(1, (int)m_uiBranchId);
-			cmd.bind(2, (long long int)tool.toInt64());
-			cmd.executenonquery();
-		}
-	}
+	ItemDbWriter(db).writeBranch(m_ItemId, row);
 }
 
 void BranchInfo::loadDb(sqlite3x::sqlite3_connection* db)
@@ -233,177 +175,177 @@ void BranchInfo::loadDb(sqlite3x::sqlite3_connection* db)
 	if (!db)
 		return;
 
-	sqlite3x::sqlite3_command cmd(*db, "SELECT * FROM branchinfo WHERE branchid=? AND internalid=?;");
-	cmd.bind(1, (int)m_uiBranchId);
-	cmd.bind(2, (long long int)m_ItemId.toInt64());
-
-	sqlite3x::sqlite3_reader reader = cmd.executereader();
+	BranchDbRow row;
+	row.branchId = m_uiBranchId;
 
-	reader.read();
+	ItemDbReader(*db, m_uiUserId).readBranch(m_ItemId, m_uiBranchId, row);
+	loadDb(row);
+}
 
-	m_szName		= gcString(reader.getstring(2));		//name
-	m_uiFlags		= reader.getint(3);						//flags
-	m_szEulaUrl		= reader.getstring(4);
-	m_szEulaDate	= reader.getstring(5);
-	m_szPreOrderDate = reader.getstring(6);
-	//7 is normally cd key but is moved to new table
-	m_szInstallScript = UTIL::OS::getAbsPath(reader.getstring(8));
-	m_uiInstallScriptCRC = reader.getint(9);
-	m_uiGlobalId = MCFBranch::BranchFromInt(reader.getint(10), true);
+void BranchInfo::loadDb(const BranchDbRow &row)
+{
+	std::lock_guard<std::mutex> guard(m_BranchLock);
 
+	m_szName		= row.name;
+	m_uiFlags		= row.flags;
+	m_szEulaUrl		= row.eulaUrl;
+	m_szEulaDate	= row.eulaDate;
+	m_szPreOrderDate = row.preOrderDate;
+	m_szInstallScript = UTIL::OS::getAbsPath(row.installScript);
+	m_uiInstallScriptCRC = row.installScriptCRC;
+	m_uiGlobalId = MCFBranch::BranchFromInt(row.globalId, true);
+
+	//what is on account gets refreshed from the web, until then the row is stale
+	m_bDirty = HasAnyFlags(m_uiFlags, BF_ONACCOUNT);
 	m_uiFlags &= ~BF_ONACCOUNT;
 
-	{
-		sqlite3x::sqlite3_command cmd(*db, "SELECT * FROM tools WHERE branchid=?;");
-		cmd.bind(1, (int)m_uiBranchId);
-		sqlite3x::sqlite3_reader reader = cmd.executereader();
-
-		while (reader.read())
-			m_vToolList.push_back(DesuraId(reader.getint64(1)));
-	}
+	for (auto tool : row.tools)
+		m_vToolList.push_back(tool);
 
+	for (auto &encoded : row.cdKeys)
 	{
-		sqlite3x::sqlite3_command cmd(*db, "SELECT key FROM cdkey WHERE branchid=? and userid=?;");
-		cmd.bind(1, (int)m_uiBranchId);
-		cmd.bind(2, (int)m_uiUserId);
-		sqlite3x::sqlite3_reader reader = cmd.executereader();
-
-		std::lock_guard<std::mutex> guard(m_BranchLock);
-
-		while (reader.read())
-		{
-			auto key = decodeCDKey(reader.getstring(0));
-
-			if (!key.empty())
-				m_vCDKeyList.push_back(key);
-		}
+		auto key = decodeCDKey(encoded);
 
+		if (!key.empty())
+			m_vCDKeyList.push_back(key);
 	}
 }
 
 
 void BranchInfo::loadXmlData(const XML::gcXMLElement &xmlNode)
 {
-	xmlNode.GetChild("name", m_szName);
-	xmlNode.GetChild("price", m_szCost);
-	xmlNode.GetChild("eula", m_szEulaUrl);
+	markDirty();
 
-	auto eNode = xmlNode.FirstChildElement("eula");
+	bool bPreOrderChanged = false;
 
-	if (eNode.IsValid())
 	{
-		const std::string date = eNode.GetAtt("date");
+		//events are fired after the lock is dropped
+		std::lock_guard<std::mutex> guard(m_BranchLock);
+
+		xmlNode.GetChild("name", m_szName);
+		xmlNode.GetChild("price", m_szCost);
+		xmlNode.GetChild("eula", m_szEulaUrl);
+
+		auto eNode = xmlNode.FirstChildElement("eula");
 
-		if (!date.empty() && m_szEulaDate != date)
+		if (eNode.IsValid())
 		{
-			m_uiFlags &= ~BF_ACCEPTED_EULA;
-			m_szEulaDate = date;
-		}
-	}
+			const std::string date = eNode.GetAtt("date");
 
-	gcString preload;
-	xmlNode.GetChild("preload", preload);
+			if (!date.empty() && m_szEulaDate != date)
+			{
+				m_uiFlags &= ~BF_ACCEPTED_EULA;
+				m_szEulaDate = date;
+			}
+		}
 
-	if (m_szPreOrderDate.size() > 0 && (preload.size() == 0 || preload == "0"))
-	{
-		m_szPreOrderDate = "";
-		m_uiFlags &= ~BF_PREORDER;
+		gcString preload;
+		xmlNode.GetChild("preload", preload);
 
-		onBranchInfoChangedEvent();
-	}
-	else if (preload != "0")
-	{
-		m_szPreOrderDate = preload;
-		m_uiFlags |= BF_PREORDER;
+		if (m_szPreOrderDate.size() > 0 && (preload.size() == 0 || preload == "0"))
+		{
+			m_szPreOrderDate = "";
+			m_uiFlags &= ~BF_PREORDER;
 
-		onBranchInfoChangedEvent();
-	}
+			bPreOrderChanged = true;
+		}
+		else if (preload != "0")
+		{
+			m_szPreOrderDate = preload;
+			m_uiFlags |= BF_PREORDER;
 
+			bPreOrderChanged = true;
+		}
 
-	bool nameon = false;
-	bool free = false;
-	bool onaccount = false;
-	bool regionlock = false;
-	bool memberlock = false;
-	bool demo = false;
-	bool test = false;
-	bool cdkey = false;
-	gcString cdkeyType;
 
-	xmlNode.GetChild("nameon", nameon);
-	xmlNode.GetChild("free", free);
-	xmlNode.GetChild("onaccount", onaccount);
-	xmlNode.GetChild("regionlock", regionlock);
-	xmlNode.GetChild("inviteonly", memberlock);
-	xmlNode.GetChild("demo", demo);
-	xmlNode.GetChild("test", test);
-	xmlNode.GetChild("cdkey", cdkey);
-	xmlNode.FirstChildElement("cdkey").GetAtt("type", cdkeyType);
+		bool nameon = false;
+		bool free = false;
+		bool onaccount = false;
+		bool regionlock = false;
+		bool memberlock = false;
+		bool demo = false;
+		bool test = false;
+		bool cdkey = false;
+		gcString cdkeyType;
 
-	uint32 global = -1;
-	xmlNode.GetChild("global", global);
+		xmlNode.GetChild("nameon", nameon);
+		xmlNode.GetChild("free", free);
+		xmlNode.GetChild("onaccount", onaccount);
+		xmlNode.GetChild("regionlock", regionlock);
+		xmlNode.GetChild("inviteonly", memberlock);
+		xmlNode.GetChild("demo", demo);
+		xmlNode.GetChild("test", test);
+		xmlNode.GetChild("cdkey", cdkey);
+		xmlNode.FirstChildElement("cdkey").GetAtt("type", cdkeyType);
 
-	if (global != -1)
-		m_uiGlobalId = MCFBranch::BranchFromInt(global, true);
+		uint32 global = -1;
+		xmlNode.GetChild("global", global);
 
-	if (nameon)
-		m_uiFlags |= BF_DISPLAY_NAME;
+		if (global != -1)
+			m_uiGlobalId = MCFBranch::BranchFromInt(global, true);
 
-	if (free)
-		m_uiFlags |= BF_FREE;
+		if (nameon)
+			m_uiFlags |= BF_DISPLAY_NAME;
 
-	if (onaccount)
-		m_uiFlags |= BF_ONACCOUNT;
+		if (free)
+			m_uiFlags |= BF_FREE;
 
-	if (regionlock)
-		m_uiFlags |= BF_REGIONLOCK;
+		if (onaccount)
+			m_uiFlags |= BF_ONACCOUNT;
 
-	if (memberlock)
-		m_uiFlags |= BF_MEMBERLOCK;
+		if (regionlock)
+			m_uiFlags |= BF_REGIONLOCK;
 
-	if (demo)
-		m_uiFlags |= BF_DEMO;
+		if (memberlock)
+			m_uiFlags |= BF_MEMBERLOCK;
 
-	if (test)
-		m_uiFlags |= BF_TEST;
+		if (demo)
+			m_uiFlags |= BF_DEMO;
 
-	if (cdkey)
-		m_uiFlags |= BF_CDKEY;
+		if (test)
+			m_uiFlags |= BF_TEST;
 
-	if (cdkeyType == "steam")
-		m_uiFlags |= BF_STEAMGAME;
+		if (cdkey)
+			m_uiFlags |= BF_CDKEY;
 
-	//no mcf no release
-	auto mcfNode = xmlNode.FirstChildElement("mcf");
-	if (!mcfNode.IsValid())
-	{
-		m_uiFlags |= BF_NORELEASES;
-	}
-	else
-	{
-		m_uiFlags &= ~BF_NORELEASES;
+		if (cdkeyType == "steam")
+			m_uiFlags |= BF_STEAMGAME;
 
-		uint32 build = -1;
-		mcfNode.GetChild("build", build);
+		//no mcf no release
+		auto mcfNode = xmlNode.FirstChildElement("mcf");
+		if (!mcfNode.IsValid())
+		{
+			m_uiFlags |= BF_NORELEASES;
+		}
+		else
+		{
+			m_uiFlags &= ~BF_NORELEASES;
 
-		m_uiLatestBuild = MCFBuild::BuildFromInt(build);
-	}
+			uint32 build = -1;
+			mcfNode.GetChild("build", build);
 
-	auto toolsNode = xmlNode.FirstChildElement("tools");
+			m_uiLatestBuild = MCFBuild::BuildFromInt(build);
+		}
 
-	if (toolsNode.IsValid())
-	{
-		m_vToolList.clear();
+		auto toolsNode = xmlNode.FirstChildElement("tools");
 
-		toolsNode.for_each_child("tool", [this](const XML::gcXMLElement &xmlTool)
+		if (toolsNode.IsValid())
 		{
-			const std::string id = xmlTool.GetText();
+			m_vToolList.clear();
 
-			if (!id.empty())
-				m_vToolList.push_back(DesuraId(id.c_str(), "tools"));
-		});
+			toolsNode.for_each_child("tool", [this](const XML::gcXMLElement &xmlTool)
+			{
+				const std::string id = xmlTool.GetText();
+
+				if (!id.empty())
+					m_vToolList.push_back(DesuraId(id.c_str(), "tools"));
+			});
+		}
 	}
 
+	if (bPreOrderChanged)
+		onBranchInfoChangedEvent();
+
 	auto scriptNode = xmlNode.FirstChildElement("installscript");
 
 	if (scriptNode.IsValid())
@@ -412,6 +354,8 @@ void BranchInfo::loadXmlData(const XML::gcXMLElement &xmlNode)
 
 void BranchInfo::processInstallScript(const XML::gcXMLElement &xmlElement)
 {
+	std::lock_guard<std::mutex> guard(m_BranchLock);
+
 	uint32 crc = 0;
 	xmlElement.GetAtt("crc", crc);
 
@@ -448,6 +392,7 @@ void BranchInfo::processInstallScript(const XML::gcXMLElement &xmlElement)
 
 void BranchInfo::getToolList(std::vector<DesuraId> &toolList)
 {
+	std::lock_guard<std::mutex> guard(m_BranchLock);
 	toolList = m_vToolList;
 }
 
@@ -488,6 +433,7 @@ void BranchInfo::setCDKey(gcString key)
 	if (std::find(begin(m_vCDKeyList), end(m_vCDKeyList), key) == end(m_vCDKeyList))
 	{
 		m_vCDKeyList.push_back(key);
+		markDirty();
 		onBranchCDKeyChangedEvent();
 	}
 }
@@ -505,6 +451,8 @@ DesuraId BranchInfo::getItemId()
 
 void BranchInfo::addJSTool(DesuraId toolId)
 {
+	std::lock_guard<std::mutex> guard(m_BranchLock);
+
 	for (size_t x=0; x<m_vToolList.size(); x++)
 	{
 		if (m_vToolList[x] == toolId)
@@ -512,10 +460,13 @@ void BranchInfo::addJSTool(DesuraId toolId)
 	}
 
 	m_vToolList.push_back(toolId);
+	markDirty();
 }
 
 void BranchInfo::setLinkInfo(const char* name)
 {
+	std::lock_guard<std::mutex> guard(m_BranchLock);
+
 	m_szName = name;
 	m_uiFlags = BF_FREE;
 
@@ -524,6 +475,8 @@ void BranchInfo::setLinkInfo(const char* name)
 #else
 	m_uiFlags |= BF_LINUX_32|BF_LINUX_64;
 #endif
+
+	markDirty();
 }
 
 gcRefPtr<BranchInstallInfo> BranchInfo::getInstallInfo()
@@ -586,7 +539,8 @@ namespace UnitTest
 		createItemInfoDbTables(db);
 
 
-		a->saveDbFull(&db);
+		ItemDbStatements statements(db);
+		a->saveDbFull(statements);
 		b->loadDb(&db);
 		c->loadDb(&db);
 
@@ -26,6 +26,7 @@ Contact us at legal@badjuju.com.
 #endif
 
 #include "usercore/BranchInfoI.h"
+#include <atomic>
 
 namespace XML
 {
@@ -44,6 +45,8 @@ namespace UserCore
 	{
 
 		class BranchInstallInfo;
+		class BranchDbRow;
+		class ItemDbStatements;
 
 		class BranchInfo : public BranchInfoI
 		{
@@ -84,23 +87,17 @@ namespace UserCore
 			//!
 			void acceptEula();
 
-			//! Removes this branch from the db
+			//! Copies what gets saved into row and clears the dirty flag
 			//!
-			//! @param db Sqlite db connection
+			//! @param row Branch row to fill in
 			//!
-			void deleteFromDb(sqlite3x::sqlite3_connection* db);
-
-			//! Save regular changed vars to db
-			//!
-			//! @param db Sqlite db connection
-			//!
-			void saveDb(sqlite3x::sqlite3_connection* db);
+			void saveDb(BranchDbRow &row);
 
 			//! Save all vars to db
 			//!
-			//! @param db Sqlite db connection
+			//! @param db Statements for the current save batch
 			//!
-			void saveDbFull(sqlite3x::sqlite3_connection* db);
+			void saveDbFull(ItemDbStatements &db);
 
 			//! Load vars from db
 			//!
@@ -108,6 +105,26 @@ namespace UserCore
 			//!
 			void loadDb(sqlite3x::sqlite3_connection* db);
 
+			//! Load vars from rows already read from the db
+			//!
+			//! @param row Branch row
+			//!
+			void loadDb(const BranchDbRow &row);
+
+			//! Flags this branch to be written on the next save
+			//!
+			void markDirty();
+
+			//! Has this branch changed since it was last saved or loaded
+			//!
+			bool isDirty() const;
+
+			//! Clears the dirty flag
+			//!
+			//! @return True if it was dirty
+			//!
+			bool clearDirty();
+
 			//! Load data for this branch from xml
 			//!
 			//! @param xmlNode Xml to get data from
@@ -164,8 +181,24 @@ namespace UserCore
 			gcRefPtr<BranchInstallInfo> m_InstallInfo;
 
 			mutable std::mutex m_BranchLock;
+			std::atomic<bool> m_bDirty = {true};
 		};
 
+		inline void BranchInfo::markDirty()
+		{
+			m_bDirty = true;
+		}
+
+		inline bool BranchInfo::isDirty() const
+		{
+			return m_bDirty;
+		}
+
+		inline bool BranchInfo::clearDirty()
+		{
+			return m_bDirty.exchange(false);
+		}
+
 
 
 		inline uint32 BranchInfo::getFlags()
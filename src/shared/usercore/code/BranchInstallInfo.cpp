@@ -23,6 +23,7 @@ Contact us at legal@badjuju.com.
 
 #include "Common.h"
 #include "BranchInstallInfo.h"
+#include "ItemDbReader.h"
 #include "sqlite3x.hpp"
 #include "sql/ItemInfoSql.h"
 
@@ -63,86 +64,39 @@ BranchInstallInfo::~BranchInstallInfo()
 {
 }
 
-void BranchInstallInfo::deleteFromDb(sqlite3x::sqlite3_connection* db)
+void ExeInfo::saveDb(ExeDbRow &row)
 {
-	try
-	{
-		{
-			sqlite3x::sqlite3_command cmd(*db, "DELETE FROM installinfo WHERE itemid=? AND biid=?;");
-			cmd.bind(1, (long long int)m_ItemId.toInt64());
-			cmd.bind(2, (int)m_BiId);
-			cmd.executenonquery();
-		}
-
-		{
-			sqlite3x::sqlite3_command cmd(*db, "DELETE FROM installinfoex WHERE itemid=? AND biid=?;");
-			cmd.bind(1, (long long int)m_ItemId.toInt64());
-			cmd.bind(2, (int)m_BiId);
-			cmd.executenonquery();
-		}
+	std::lock_guard<std::mutex> guard(m_ExeLock);
 
-		{
-			sqlite3x::sqlite3_command cmd(*db, "DELETE FROM exe WHERE itemid=? AND biid=?;");
-			cmd.bind(1, (long long int)m_ItemId.toInt64());
-			cmd.bind(2, (int)m_BiId);
-			cmd.executenonquery();
-		}
-	}
-	catch (...)
-	{
-	}
+	row.name = m_szName;
+	row.exe = UTIL::OS::getRelativePath(m_szExe);
+	row.exeArgs = m_szExeArgs;
+	row.userArgs = m_szUserArgs;
+	row.rank = m_uiRank;
 }
 
-void BranchInstallInfo::saveDb(sqlite3x::sqlite3_connection* db)
+void BranchInstallInfo::saveDb(InstallInfoDbRow &row)
 {
-	sqlite3x::sqlite3_command cmd(*db, "REPLACE INTO installinfo VALUES (?,?,?,?, ?,?,?,?);");
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+	clearDirty();
 
-	cmd.bind(1, (long long int)m_ItemId.toInt64());
-	cmd.bind(2, (int)m_BiId);
-	cmd.bind(3, UTIL::OS::getRelativePath(m_szPath));
-	cmd.bind(4, UTIL::OS::getRelativePath(m_szInsCheck));
-	cmd.bind(5, UTIL::OS::getRelativePath(m_szInsPrim));
-	cmd.bind(6, (long long int)m_iInstalledMod.toInt64());
-	cmd.bind(7, (int)m_INBuild);
-	cmd.bind(8, (int)m_LastBuild);
-
-	cmd.executenonquery();
+	row.biid = m_BiId;
+	row.path = UTIL::OS::getRelativePath(m_szPath);
+	row.installCheck = UTIL::OS::getRelativePath(m_szInsCheck);
+	row.installPrimary = UTIL::OS::getRelativePath(m_szInsPrim);
+	row.installedMod = m_iInstalledMod.toInt64();
+	row.installedBuild = (int)m_INBuild;
+	row.lastBuild = (int)m_LastBuild;
 
 	for (auto ei : m_vExeList)
 	{
-		sqlite3x::sqlite3_command cmd(*db, "REPLACE INTO exe VALUES (?,?,?,?,?,?,?);");
-
-		cmd.bind(1, (long long int)m_ItemId.toInt64());
-		cmd.bind(2, (int)m_BiId);
-		cmd.bind(3, ei->m_szName);
-		cmd.bind(4, UTIL::OS::getRelativePath(ei->m_szExe));
-		cmd.bind(5, ei->m_szExeArgs);
-		cmd.bind(6, ei->m_szUserArgs);
-		cmd.bind(7, (int)ei->m_uiRank);
-
-		cmd.executenonquery();
+		row.exes.emplace_back();
+		ei->saveDb(row.exes.back());
 	}
 
+	//writer clears the install checks when there are none
 	if (isInstalled())
-	{
-		for (gcString &check : m_vInstallChecks)
-		{
-			sqlite3x::sqlite3_command cmd(*db, "REPLACE INTO installinfoex VALUES (?,?,?);");
-
-			cmd.bind(1, (long long int)m_ItemId.toInt64());
-			cmd.bind(2, (int)m_BiId);
-			cmd.bind(3, check);
-
-			cmd.executenonquery();
-		}
-	}
-	else
-	{
-		sqlite3x::sqlite3_command cmd(*db, "DELETE FROM installinfoex WHERE itemid=? AND biid=?;");
-		cmd.bind(1, (long long int)m_ItemId.toInt64());
-		cmd.bind(2, (int)m_BiId);
-		cmd.executenonquery();
-	}
+		row.installChecks = m_vInstallChecks;
 }
 
 void BranchInstallInfo::loadDb(sqlite3x::sqlite3_connection* db)
@@ -150,35 +104,29 @@ void BranchInstallInfo::loadDb(sqlite3x::sqlite3_connection* db)
 	if (!db)
 		return;
 
-	{
-		sqlite3x::sqlite3_command cmd(*db, "SELECT * FROM installinfo WHERE itemid=? AND biid=?;");
-		cmd.bind(1, (long long int)m_ItemId.toInt64());
-		cmd.bind(2, (int)m_BiId);
+	InstallInfoDbRow row;
+	row.biid = m_BiId;
+
+	ItemDbReader(*db, 0).readInstallInfo(m_ItemId, m_BiId, row);
+	loadDb(row);
+}
 
-		sqlite3x::sqlite3_reader reader = cmd.executereader();
-		reader.read();
+void BranchInstallInfo::loadDb(const InstallInfoDbRow &row)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
 
-		m_szPath		= UTIL::OS::getAbsPath(reader.getstring(2)); //install path
-		m_szInsCheck	= UTIL::OS::getAbsPath(reader.getstring(3)); //install check
-		m_szInsPrim		= UTIL::OS::getAbsPath(reader.getstring(4)); //install primary
+	m_szPath		= UTIL::OS::getAbsPath(row.path); //install path
+	m_szInsCheck	= UTIL::OS::getAbsPath(row.installCheck); //install check
+	m_szInsPrim		= UTIL::OS::getAbsPath(row.installPrimary); //install primary
 
-		m_iInstalledMod = DesuraId(reader.getint64(5));
-		m_INBuild		= MCFBuild::BuildFromInt(reader.getint(6));
-		m_LastBuild		= MCFBuild::BuildFromInt(reader.getint(7));
-	}
+	m_iInstalledMod = DesuraId(row.installedMod);
+	m_INBuild		= MCFBuild::BuildFromInt(row.installedBuild);
+	m_LastBuild		= MCFBuild::BuildFromInt(row.lastBuild);
 
 	if (isInstalled())
 	{
-		sqlite3x::sqlite3_command cmd(*db, "SELECT installcheck FROM installinfoex WHERE itemid=? AND biid=?;");
-		cmd.bind(1, (long long int)m_ItemId.toInt64());
-		cmd.bind(2, (int)m_BiId);
-
-		sqlite3x::sqlite3_reader reader = cmd.executereader();
-
-		while (reader.read())
-		{
-			m_vInstallChecks.push_back(reader.getstring(0));
-		}
+		for (auto check : row.installChecks)
+			m_vInstallChecks.push_back(check);
 
 		if (!isValidFile(m_szInsCheck))
 		{
@@ -193,44 +141,62 @@ void BranchInstallInfo::loadDb(sqlite3x::sqlite3_connection* db)
 		}
 	}
 
+	for (auto &exeRow : row.exes)
 	{
-		sqlite3x::sqlite3_command cmd(*db, "SELECT * FROM exe WHERE itemid=? AND biid=?;");
-		cmd.bind(1, (long long int)m_ItemId.toInt64());
-		cmd.bind(2, (int)m_BiId);
+		gcRefPtr<ExeInfo> ei;
 
-		sqlite3x::sqlite3_reader reader = cmd.executereader();
+		for (auto exe : m_vExeList)
+		{
+			if (exe->m_szName == exeRow.name)
+			{
+				ei = exe;
+				break;
+			}
+		}
 
-		while (reader.read())
+		if (!ei)
 		{
-			gcString name = reader.getstring(2);
-			gcString exe = UTIL::OS::getAbsPath(reader.getstring(3));
-			gcString exeargs = reader.getstring(4);
-			gcString userargs = reader.getstring(5);
-			uint32 rank = reader.getint(6);
+			ei = gcRefPtr<ExeInfo>::create(exeRow.name.c_str());
+			m_vExeList.push_back(ei);
+		}
 
-			gcRefPtr<ExeInfo> ei;
+		ei->m_szExe = UTIL::OS::getAbsPath(exeRow.exe);
+		ei->m_szExeArgs = exeRow.exeArgs;
+		ei->m_szUserArgs = exeRow.userArgs;
+		ei->m_uiRank = exeRow.rank;
+	}
 
-			for (auto exe : m_vExeList)
-			{
-				if (exe->m_szName == name)
-				{
-					ei = exe;
-					break;
-				}
-			}
+	clearDirty();
+}
 
-			if (!ei)
-			{
-				ei = gcRefPtr<ExeInfo>::create(name.c_str());
-				m_vExeList.push_back(ei);
-			}
+bool BranchInstallInfo::isDirty()
+{
+	if (m_bDirty)
+		return true;
 
-			ei->m_szExe = exe;
-			ei->m_szExeArgs = exeargs;
-			ei->m_szUserArgs = userargs;
-			ei->m_uiRank = rank;
-		}
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
+	for (auto ei : m_vExeList)
+	{
+		if (ei->m_bDirty)
+			return true;
 	}
+
+	return false;
+}
+
+bool BranchInstallInfo::clearDirty()
+{
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+	bool bDirty = m_bDirty.exchange(false);
+
+	for (auto ei : m_vExeList)
+	{
+		if (ei->m_bDirty.exchange(false))
+			bDirty = true;
+	}
+
+	return bDirty;
 }
 
 
@@ -299,6 +265,8 @@ bool BranchInstallInfo::updateInstallCheck(gcString &strCheckRes, const gcString
 
 void BranchInstallInfo::UpdateInstallCheckList(const std::vector<InsCheck> &vInsChecks, gcRefPtr<WildcardManager> &pWildCard)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	VERIFY_OR_RETURN(!!pWildCard, );
 
 	for (const InsCheck &check : vInsChecks)
@@ -321,16 +289,21 @@ void BranchInstallInfo::UpdateInstallCheckList(const std::vector<InsCheck> &vIns
 			continue;
 
 		m_vInstallChecks.push_back(check.check);
+		markDirty();
 	}
 }
 
 ProcessResult BranchInstallInfo::processSettings(const XML::gcXMLElement &setNode, gcRefPtr<WildcardManager> &pWildCard, bool reset, bool hasBroughtItem, const char* cipPath)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	ProcessResult pr;
 	pr.found = false;
 	pr.useCip = false;
 	pr.notFirst = false;
 
+	markDirty();
+
 	auto icsNode = setNode.FirstChildElement("installlocations");
 
 	if (!isInstalled())
@@ -541,6 +514,8 @@ bool BranchInstallInfo::isInstalled()
 
 void BranchInstallInfo::setPath(const char *path)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	if (m_szPath == path)
 		return;
 
@@ -551,10 +526,14 @@ void BranchInstallInfo::setPath(const char *path)
 		m_szPath = gcString();
 	else
 		m_szPath = UTIL::FS::PathWithFile(path).getFullPath();
+
+	markDirty();
 }
 
 void BranchInstallInfo::setInsPrimary(const char* path)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	if (m_szInsPrim == path)
 		return;
 
@@ -565,11 +544,15 @@ void BranchInstallInfo::setInsPrimary(const char* path)
 		m_szInsPrim = gcString();
 	else
 		m_szInsPrim = UTIL::FS::PathWithFile(path).getFullPath();
+
+	markDirty();
 }
 
 //only can change this if it is not installed
 void BranchInstallInfo::setInsCheck(const char* path)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	if (m_szInsCheck == path)
 		return;
 
@@ -591,6 +574,8 @@ void BranchInstallInfo::setInsCheck(const char* path)
 		m_szInsCheck = gcString();
 	else
 		m_szInsCheck = UTIL::FS::PathWithFile(path).getFullPath();
+
+	markDirty();
 }
 
 void BranchInstallInfo::launchExeHack()
@@ -623,7 +608,10 @@ void BranchInstallInfo::launchExeHack()
 
 void BranchInstallInfo::processExes(const XML::gcXMLElement &setNode, gcRefPtr<WildcardManager> &pWildCard, bool useCip)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	uint32 rank = 0;
+	markDirty();
 
 	setNode.FirstChildElement("executes").for_each_child("execute", [&](const XML::gcXMLElement &xmlChild)
 	{
@@ -703,17 +691,23 @@ void BranchInstallInfo::processExes(const XML::gcXMLElement &setNode, gcRefPtr<W
 
 void BranchInstallInfo::updated()
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	if (m_NextBuild > m_INBuild)
 	{
 		m_LastBuild = m_INBuild;
 		m_INBuild = m_NextBuild;
+		markDirty();
 	}
 }
 
 bool BranchInstallInfo::setInstalledMcf(MCFBuild build)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	m_LastBuild = m_INBuild;
 	m_INBuild = build;
+	markDirty();
 
 	if (m_NextBuild == m_INBuild)
 	{
@@ -726,14 +720,20 @@ bool BranchInstallInfo::setInstalledMcf(MCFBuild build)
 
 void BranchInstallInfo::overideInstalledBuild(MCFBuild build)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	m_LastBuild = m_INBuild;
 	m_INBuild = build;
+	markDirty();
 }
 
 void BranchInstallInfo::resetInstalledMcf()
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	m_LastBuild = MCFBuild();
 	m_INBuild = MCFBuild();
+	markDirty();
 }
 
 bool BranchInstallInfo::processUpdateXml(const XML::gcXMLElement &branch)
@@ -760,8 +760,13 @@ bool BranchInstallInfo::processUpdateXml(const XML::gcXMLElement &branch)
 
 void BranchInstallInfo::setLinkInfo(const char* exe, const char* args)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	if (m_vExeList.size() == 0)
+	{
 		m_vExeList.push_back(gcRefPtr<ExeInfo>::create("Link"));
+		markDirty();
+	}
 
 	gcRefPtr<ExeInfo>& info = m_vExeList[0];
 
@@ -776,6 +781,8 @@ bool BranchInstallInfo::isValidFile(const gcString &strFile)
 
 void BranchInstallInfo::setLinkInfo(const char* szPath, const char* szExe, const char* szArgs)
 {
+	std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
+
 	if ((m_pItem->getStatus() & ItemInfo::STATUS_LINK) != ItemInfo::STATUS_LINK)
 	{
 		gcAssert(false);
@@ -27,6 +27,8 @@ Contact us at legal@badjuju.com.
 #endif
 
 #include "usercore/ItemInfoI.h"
+#include <atomic>
+#include <mutex>
 
 namespace XML
 {
@@ -54,6 +56,8 @@ namespace UserCore
 
 		class BranchItemInfoI;
 		class ItemInfo;
+		class ExeDbRow;
+		class InstallInfoDbRow;
 
 		class ExeInfo : public Misc::ExeInfoI
 		{
@@ -86,22 +90,36 @@ namespace UserCore
 
 			void setExe(const char* exe)
 			{
+				std::lock_guard<std::mutex> guard(m_ExeLock);
+
 				if (!exe)
 					m_szExe = "";
 				else
 					m_szExe = UTIL::FS::PathWithFile(exe).getFullPath();
+
+				m_bDirty = true;
 			}
 
 			void setUserArgs(const char* args)
 			{
+				std::lock_guard<std::mutex> guard(m_ExeLock);
+
 				m_szUserArgs = gcString(args);
+				m_bDirty = true;
 			}
 
+			//! Copies what gets saved into row
+			//!
+			void saveDb(ExeDbRow &row);
+
 			gcString m_szExe;		//exe command
 			gcString m_szExeArgs;	//command line args
 			gcString m_szUserArgs;	//user command line args
 			gcString m_szName;
 			uint32 m_uiRank;
+			std::atomic<bool> m_bDirty = {true};	//changed since last save
+
+			std::mutex m_ExeLock;
 
 			gc_IMPLEMENT_REFCOUNTING(ExeInfo);
 		};
@@ -122,23 +140,37 @@ namespace UserCore
 			~BranchInstallInfo();
 
 
-			//! Removes this from the db
+			//! Copies what gets saved into row and clears the dirty flags
 			//!
-			//! @param db Sqlite db connection
+			//! @param row Install info row to fill in
 			//!
-			void deleteFromDb(sqlite3x::sqlite3_connection* db);
+			void saveDb(InstallInfoDbRow &row);
 
-			//! Save regular changed vars to db
+			//! Load vars from db
 			//!
 			//! @param db Sqlite db connection
 			//!
-			void saveDb(sqlite3x::sqlite3_connection* db);
+			void loadDb(sqlite3x::sqlite3_connection* db);
 
-			//! Load vars from db
+			//! Load vars from rows already read from the db
 			//!
-			//! @param db Sqlite db connection
+			//! @param row Install info row
 			//!
-			void loadDb(sqlite3x::sqlite3_connection* db);
+			void loadDb(const InstallInfoDbRow &row);
+
+			//! Flags this to be written on the next save
+			//!
+			void markDirty();
+
+			//! Has this or any of its exes changed since it was last saved or loaded
+			//!
+			bool isDirty();
+
+			//! Clears the dirty flag on this and its exes
+			//!
+			//! @return True if anything was dirty
+			//!
+			bool clearDirty();
 
 			//! Load data for this from xml
 			//!
@@ -230,10 +262,20 @@ namespace UserCore
 			gcRefPtr<BranchItemInfoI> m_pItem;
 			UTIL::FS::UtilFSI* m_pFileSystem;
 
+			std::atomic<bool> m_bDirty = {true};
+
+			//guards what saveDb copies against the setters
+			std::recursive_mutex m_InstallLock;
+
 			gc_IMPLEMENT_REFCOUNTING(BranchInstallInfo)
 		};
 
 
+		inline void BranchInstallInfo::markDirty()
+		{
+			m_bDirty = true;
+		}
+
 		inline const char* BranchInstallInfo::getInstallCheck()
 		{
 			return m_szInsCheck.c_str();
@@ -261,7 +303,9 @@ namespace UserCore
 
 		inline void BranchInstallInfo::setInstalledModId(DesuraId id)
 		{
+			std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
 			m_iInstalledMod = id;
+			markDirty();
 		}
 
 		inline const char* BranchInstallInfo::getInstalledVersion()
@@ -296,7 +340,9 @@ namespace UserCore
 
 		inline void BranchInstallInfo::overideMcfBuild(MCFBuild build)
 		{
+			std::lock_guard<std::recursive_mutex> guard(m_InstallLock);
 			m_INBuild = build;
+			markDirty();
 		}
 
 		inline uint32 BranchInstallInfo::getBiId()
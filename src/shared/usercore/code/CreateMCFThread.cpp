@@ -77,6 +77,7 @@ void CreateMCFThread::doRun()
 	if (val && Safe::atoi(val) != 0)
 		m_hMCFile->setWorkerCount(Safe::atoi(val));
 
+	loadReuseMcf();
 
 	m_hMCFile->parseFolder(m_szPath.c_str(), true);
 
@@ -120,6 +121,58 @@ void CreateMCFThread::doRun()
 	onCompleteStrEvent(m_szFilePath);
 }
 
+void CreateMCFThread::loadReuseMcf()
+{
+	const gcString strReuse = getUserCore()->getCVarValue("gc_mcfcreate_reuse");
+
+	if (strReuse != "1" && strReuse != "true")
+		return;
+
+	auto mm = getUserCore()->getInternal()->getMCFManager();
+	UTIL::FS::Path folder(gcString("{0}{1}{2}", mm->getMcfSavePath(), DIRS_STR, getItemId().getFolderPathExtension()), "", false);
+
+	if (!UTIL::FS::isValidFolder(folder))
+		return;
+
+	std::vector<std::string> vExts = { "mcf" };
+	std::vector<UTIL::FS::Path> vFiles;
+	UTIL::FS::getAllFiles(folder, vFiles, &vExts);
+
+	UTIL::FS::Path lastMcf;
+	gcTime lastTime;
+
+	for (auto &file : vFiles)
+	{
+		if (file.getFile().getFile().find("NewMcf_") != 0)
+			continue;
+
+		gcTime time = UTIL::FS::lastWriteTime(file);
+
+		if (lastMcf.getFile().getFile().empty() || lastTime < time)
+		{
+			lastMcf = file;
+			lastTime = time;
+		}
+	}
+
+	if (lastMcf.getFile().getFile().empty())
+		return;
+
+	try
+	{
+		m_hReuseMcf->setFile(lastMcf.getFullPath().c_str());
+		m_hReuseMcf->parseMCF();
+	}
+	catch (gcException &except)
+	{
+		Warning("CreateMCF: Failed to load previous mcf {0} to reuse: {1}\n", lastMcf.getFullPath(), except);
+		return;
+	}
+
+	const gcString strReuseHash = getUserCore()->getCVarValue("gc_mcfcreate_reuse_hash");
+	m_hMCFile->setReuseMcf(m_hReuseMcf.handle(), strReuseHash == "1" || strReuseHash == "true");
+}
+
 void CreateMCFThread::compareBranches(std::vector<gcRefPtr<UserCore::Item::BranchInfo>> &vBranchList)
 {
 	uint64 lastSize = 0;
@@ -62,6 +62,10 @@ namespace UserCore
 
 			void waitForItemInfo();
 
+			//! Loads the last mcf created for this item so unchanged files can be copied from it
+			//!
+			void loadReuseMcf();
+
 			void retrieveBranchList(std::vector<gcRefPtr<UserCore::Item::BranchInfo>> &outList);
 
 			void processGames(std::vector<gcRefPtr<UserCore::Item::BranchInfo>> &outList, const XML::gcXMLElement &platform);
@@ -73,6 +77,8 @@ namespace UserCore
 			gcString m_szPath;
 			gcString m_szFilePath;
 
+			McfHandle m_hReuseMcf;
+
 			bool m_bComplete;
 			uint32 m_iInternId;
 		};
@@ -92,6 +92,7 @@ void DownloadToolTask::downloadTool()
 	hh->getWriteEvent() += delegate(this, &DownloadToolTask::onWrite);
 
 	hh->setUserAgent(getUserCore()->getWebCore()->getUserAgent());
+	hh->setTrafficClass(UTIL::WEB::TrafficClass::Background);
 	hh->getWeb();
 
 	m_pHttpHandle = nullptr;
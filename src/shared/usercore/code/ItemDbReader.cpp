@@ -0,0 +1,643 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "ItemDbReader.h"
+
+#include "sqlite3x.hpp"
+
+using namespace UserCore::Item;
+
+
+namespace
+{
+	void readItemRow(sqlite3x::sqlite3_reader &reader, ItemDbRow &row)
+	{
+		row.id				= DesuraId(reader.getint64(0));
+		row.parentId		= DesuraId(reader.getint64(1));
+		row.percent			= reader.getint(2);
+		row.status			= reader.getint(3);
+		row.rating			= reader.getstring(4);
+
+		row.developer		= reader.getstring(5);
+		row.name			= reader.getstring(6);
+		row.shortName		= reader.getstring(7);
+		row.profile			= reader.getstring(8);
+		row.devProfile		= reader.getstring(9);
+
+		row.icon			= reader.getstring(10);
+		row.iconUrl			= reader.getstring(11);
+		row.logo			= reader.getstring(12);
+		row.logoUrl			= reader.getstring(13);
+
+		row.publisher		= reader.getstring(14);
+		row.publisherProfile = reader.getstring(15);
+
+		row.installedBranch	= reader.getint(16);
+		row.lastBranch		= reader.getint(17);
+	}
+
+	void readInstallInfoRow(sqlite3x::sqlite3_reader &reader, InstallInfoDbRow &row)
+	{
+		row.biid			= reader.getint(1);
+		row.path			= reader.getstring(2);
+		row.installCheck	= reader.getstring(3);
+		row.installPrimary	= reader.getstring(4);
+		row.installedMod	= reader.getint64(5);
+		row.installedBuild	= reader.getint(6);
+		row.lastBuild		= reader.getint(7);
+	}
+
+	void readExeRow(sqlite3x::sqlite3_reader &reader, ExeDbRow &row)
+	{
+		row.name			= reader.getstring(2);
+		row.exe				= reader.getstring(3);
+		row.exeArgs			= reader.getstring(4);
+		row.userArgs		= reader.getstring(5);
+		row.rank			= reader.getint(6);
+	}
+
+	void readBranchRow(sqlite3x::sqlite3_reader &reader, BranchDbRow &row)
+	{
+		row.branchId		= reader.getint(0);
+		row.name			= reader.getstring(2);
+		row.flags			= reader.getint(3);
+		row.eulaUrl			= reader.getstring(4);
+		row.eulaDate		= reader.getstring(5);
+		row.preOrderDate	= reader.getstring(6);
+		//7 is normally cd key but is moved to new table
+		row.installScript	= reader.getstring(8);
+		row.installScriptCRC = reader.getint(9);
+		row.globalId		= reader.getint(10);
+		row.biid			= reader.getint(11);
+	}
+
+	typedef std::pair<uint64, uint32> InstallInfoKey;
+}
+
+
+ItemDbReader::ItemDbReader(sqlite3x::sqlite3_connection &db, uint32 nUserId)
+	: m_Db(db)
+	, m_nUserId(nUserId)
+{
+}
+
+void ItemDbReader::readAll(std::vector<ItemDbRow> &vItems)
+{
+	read(vItems, DesuraId());
+}
+
+bool ItemDbReader::readItem(DesuraId id, ItemDbRow &item)
+{
+	std::vector<ItemDbRow> vItems;
+	read(vItems, id);
+
+	if (vItems.empty())
+		return false;
+
+	item = std::move(vItems.front());
+	return true;
+}
+
+//Both paths run the same queries, reading one item just narrows each of them down to that item.
+//The old per item queries had no ORDER BY, so rows came back in whatever order sqlite walked them:
+//the primary key index for the tables keyed by item and branch, and branchid (the rowid) for the
+//branchinfo scan. The ORDER BYs below spell that order out. Branch order is the one that matters,
+//it decides the branch list order and so the installed branch index.
+void ItemDbReader::read(std::vector<ItemDbRow> &vItems, DesuraId id)
+{
+	const bool bAll = !id.isOk();
+
+	auto command = [this, bAll, id](const char* szAll, const char* szOne) -> std::unique_ptr<sqlite3x::sqlite3_command>
+	{
+		std::unique_ptr<sqlite3x::sqlite3_command> cmd(new sqlite3x::sqlite3_command(m_Db, bAll ? szAll : szOne));
+
+		if (!bAll)
+			cmd->bind(1, (long long int)id.toInt64());
+
+		return cmd;
+	};
+
+	std::map<uint64, size_t> mItemIndex;
+
+	{
+		auto cmd = command("SELECT * FROM iteminfo ORDER BY internalid;",
+							"SELECT * FROM iteminfo WHERE internalid=?;");
+
+		sqlite3x::sqlite3_reader reader = cmd->executereader();
+
+		while (reader.read())
+		{
+			vItems.push_back(ItemDbRow());
+			readItemRow(reader, vItems.back());
+			mItemIndex[vItems.back().id.toInt64()] = vItems.size() - 1;
+		}
+	}
+
+	if (vItems.empty())
+		return;
+
+	{
+		auto cmd = command("SELECT * FROM installinfo ORDER BY itemid, biid;",
+							"SELECT * FROM installinfo WHERE itemid=? ORDER BY biid;");
+
+		sqlite3x::sqlite3_reader reader = cmd->executereader();
+
+		while (reader.read())
+		{
+			auto it = mItemIndex.find(reader.getint64(0));
+
+			if (it == mItemIndex.end())
+				continue;
+
+			auto &vInstallInfo = vItems[it->second].installInfo;
+			vInstallInfo.push_back(InstallInfoDbRow());
+			readInstallInfoRow(reader, vInstallInfo.back());
+		}
+	}
+
+	std::map<InstallInfoKey, InstallInfoDbRow*> mInstallInfo;
+
+	for (auto &item : vItems)
+	{
+		for (auto &ii : item.installInfo)
+			mInstallInfo[InstallInfoKey(item.id.toInt64(), ii.biid)] = &ii;
+	}
+
+	if (!mInstallInfo.empty())
+	{
+		{
+			auto cmd = command("SELECT * FROM installinfoex ORDER BY itemid, biid, installcheck;",
+								"SELECT * FROM installinfoex WHERE itemid=? ORDER BY biid, installcheck;");
+
+			sqlite3x::sqlite3_reader reader = cmd->executereader();
+
+			while (reader.read())
+			{
+				auto it = mInstallInfo.find(InstallInfoKey(reader.getint64(0), reader.getint(1)));
+
+				if (it != mInstallInfo.end())
+					it->second->installChecks.push_back(reader.getstring(2));
+			}
+		}
+
+		{
+			auto cmd = command("SELECT * FROM exe ORDER BY itemid, biid, name;",
+								"SELECT * FROM exe WHERE itemid=? ORDER BY biid, name;");
+
+			sqlite3x::sqlite3_reader reader = cmd->executereader();
+
+			while (reader.read())
+			{
+				auto it = mInstallInfo.find(InstallInfoKey(reader.getint64(0), reader.getint(1)));
+
+				if (it == mInstallInfo.end())
+					continue;
+
+				it->second->exes.push_back(ExeDbRow());
+				readExeRow(reader, it->second->exes.back());
+			}
+		}
+	}
+
+	{
+		auto cmd = command("SELECT * FROM branchinfo ORDER BY internalid, branchid;",
+							"SELECT * FROM branchinfo WHERE internalid=? ORDER BY branchid;");
+
+		sqlite3x::sqlite3_reader reader = cmd->executereader();
+
+		while (reader.read())
+		{
+			auto it = mItemIndex.find(reader.getint64(1));
+
+			if (it == mItemIndex.end())
+				continue;
+
+			auto &vBranches = vItems[it->second].branches;
+			vBranches.push_back(BranchDbRow());
+			readBranchRow(reader, vBranches.back());
+		}
+	}
+
+	std::map<uint32, BranchDbRow*> mBranches;
+
+	for (auto &item : vItems)
+	{
+		for (auto &branch : item.branches)
+			mBranches[branch.branchId] = &branch;
+	}
+
+	if (mBranches.empty())
+		return;
+
+	{
+		auto cmd = command("SELECT * FROM tools ORDER BY branchid, toolid;",
+							"SELECT * FROM tools WHERE branchid IN (SELECT branchid FROM branchinfo WHERE internalid=?) ORDER BY branchid, toolid;");
+
+		sqlite3x::sqlite3_reader reader = cmd->executereader();
+
+		while (reader.read())
+		{
+			auto it = mBranches.find(reader.getint(0));
+
+			if (it != mBranches.end())
+				it->second->tools.push_back(DesuraId(reader.getint64(1)));
+		}
+	}
+
+	if (m_nUserId == 0)
+		return;
+
+	{
+		auto cmd = command("SELECT branchid, key FROM cdkey WHERE userid=?;",
+							"SELECT branchid, key FROM cdkey WHERE branchid IN (SELECT branchid FROM branchinfo WHERE internalid=?) AND userid=?;");
+
+		cmd->bind(bAll ? 1 : 2, (int)m_nUserId);
+
+		sqlite3x::sqlite3_reader reader = cmd->executereader();
+
+		while (reader.read())
+		{
+			auto it = mBranches.find(reader.getint(0));
+
+			if (it != mBranches.end())
+				it->second->cdKeys.push_back(reader.getstring(1));
+		}
+	}
+}
+
+void ItemDbReader::readCdKeys(std::vector<ItemDbRow> &vItems)
+{
+	std::map<uint32, BranchDbRow*> mBranches;
+
+	for (auto &item : vItems)
+	{
+		for (auto &branch : item.branches)
+		{
+			branch.cdKeys.clear();
+			mBranches[branch.branchId] = &branch;
+		}
+	}
+
+	if (mBranches.empty())
+		return;
+
+	sqlite3x::sqlite3_command cmd(m_Db, "SELECT branchid, key FROM cdkey WHERE userid=?;");
+	cmd.bind(1, (int)m_nUserId);
+
+	sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+	while (reader.read())
+	{
+		auto it = mBranches.find(reader.getint(0));
+
+		if (it != mBranches.end())
+			it->second->cdKeys.push_back(reader.getstring(1));
+	}
+}
+
+bool ItemDbReader::readBranch(DesuraId itemId, uint32 branchId, BranchDbRow &branch)
+{
+	{
+		sqlite3x::sqlite3_command cmd(m_Db, "SELECT * FROM branchinfo WHERE branchid=? AND internalid=?;");
+		cmd.bind(1, (int)branchId);
+		cmd.bind(2, (long long int)itemId.toInt64());
+
+		sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+		if (!reader.read())
+			return false;
+
+		readBranchRow(reader, branch);
+	}
+
+	{
+		sqlite3x::sqlite3_command cmd(m_Db, "SELECT * FROM tools WHERE branchid=?;");
+		cmd.bind(1, (int)branchId);
+
+		sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+		while (reader.read())
+			branch.tools.push_back(DesuraId(reader.getint64(1)));
+	}
+
+	{
+		sqlite3x::sqlite3_command cmd(m_Db, "SELECT key FROM cdkey WHERE branchid=? and userid=?;");
+		cmd.bind(1, (int)branchId);
+		cmd.bind(2, (int)m_nUserId);
+
+		sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+		while (reader.read())
+			branch.cdKeys.push_back(reader.getstring(0));
+	}
+
+	return true;
+}
+
+bool ItemDbReader::readInstallInfo(DesuraId itemId, uint32 biid, InstallInfoDbRow &installInfo)
+{
+	{
+		sqlite3x::sqlite3_command cmd(m_Db, "SELECT * FROM installinfo WHERE itemid=? AND biid=?;");
+		cmd.bind(1, (long long int)itemId.toInt64());
+		cmd.bind(2, (int)biid);
+
+		sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+		if (!reader.read())
+			return false;
+
+		readInstallInfoRow(reader, installInfo);
+	}
+
+	{
+		sqlite3x::sqlite3_command cmd(m_Db, "SELECT installcheck FROM installinfoex WHERE itemid=? AND biid=?;");
+		cmd.bind(1, (long long int)itemId.toInt64());
+		cmd.bind(2, (int)biid);
+
+		sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+		while (reader.read())
+			installInfo.installChecks.push_back(reader.getstring(0));
+	}
+
+	{
+		sqlite3x::sqlite3_command cmd(m_Db, "SELECT * FROM exe WHERE itemid=? AND biid=?;");
+		cmd.bind(1, (long long int)itemId.toInt64());
+		cmd.bind(2, (int)biid);
+
+		sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+		while (reader.read())
+		{
+			installInfo.exes.push_back(ExeDbRow());
+			readExeRow(reader, installInfo.exes.back());
+		}
+	}
+
+	return true;
+}
+
+
+ItemDbStatements::ItemDbStatements(sqlite3x::sqlite3_connection &db)
+	: m_Db(db)
+	, m_pPooled(nullptr)
+{
+}
+
+ItemDbStatements::ItemDbStatements(sqlite3x::sqlite3_pooled_connection &db)
+	: m_Db(db.connection())
+	, m_pPooled(&db)
+{
+}
+
+ItemDbStatements::~ItemDbStatements()
+{
+}
+
+sqlite3x::sqlite3_connection& ItemDbStatements::connection()
+{
+	return m_Db;
+}
+
+sqlite3x::sqlite3_command& ItemDbStatements::command(const char* szSql)
+{
+	if (m_pPooled)
+		return m_pPooled->command(szSql);
+
+	auto it = m_mCommands.find(szSql);
+
+	if (it != m_mCommands.end())
+	{
+		it->second->reset();
+		return *it->second;
+	}
+
+	auto &cmd = m_mCommands[szSql];
+	cmd.reset(new sqlite3x::sqlite3_command(m_Db, szSql));
+	return *cmd;
+}
+
+
+ItemDbWriter::ItemDbWriter(ItemDbStatements &db)
+	: m_Db(db)
+{
+}
+
+void ItemDbWriter::write(const ItemDbSnapshot &snapshot)
+{
+	if (snapshot.remove)
+	{
+		removeItem(snapshot.item);
+		return;
+	}
+
+	if (snapshot.itemRow)
+		writeItem(snapshot.item);
+
+	for (auto &branch : snapshot.item.branches)
+		writeBranch(snapshot.item.id, branch);
+
+	for (auto &installInfo : snapshot.item.installInfo)
+		writeInstallInfo(snapshot.item.id, installInfo);
+}
+
+void ItemDbWriter::writeItem(const ItemDbRow &item)
+{
+	sqlite3x::sqlite3_command &cmd = m_Db.command("REPLACE INTO iteminfo VALUES (?,?,?,?,?, ?,?,?,?,?, ?,?,?,?,?, ?,?,?);");
+
+	cmd.bind(1, (long long int)item.id.toInt64());
+	cmd.bind(2, (long long int)item.parentId.toInt64());
+	cmd.bind(3, (int)item.percent);
+	cmd.bind(4, (int)item.status);
+	cmd.bind(5, item.rating);
+
+	cmd.bind(6, item.developer);
+	cmd.bind(7, item.name);
+	cmd.bind(8, item.shortName);
+	cmd.bind(9, item.profile);
+	cmd.bind(10, item.devProfile);
+
+	cmd.bind(11, item.icon);
+	cmd.bind(12, item.iconUrl);
+	cmd.bind(13, item.logo);
+	cmd.bind(14, item.logoUrl);
+	cmd.bind(15, item.publisher);
+
+	cmd.bind(16, item.publisherProfile);
+	cmd.bind(17, item.installedBranch);
+	cmd.bind(18, item.lastBranch);
+
+	cmd.executenonquery();
+}
+
+void ItemDbWriter::writeBranch(DesuraId itemId, const BranchDbRow &branch)
+{
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("REPLACE INTO branchinfo VALUES (?,?,?,?,?, ?,?,?,?,?, ?,?);");
+
+		cmd.bind(1, (int)branch.branchId);
+		cmd.bind(2, (long long int)itemId.toInt64());
+		cmd.bind(3, branch.name);
+		cmd.bind(4, (int)branch.flags);
+		cmd.bind(5, branch.eulaUrl);
+
+		cmd.bind(6, branch.eulaDate);
+		cmd.bind(7, branch.preOrderDate);
+		cmd.bind(8, "");
+		cmd.bind(9, branch.installScript);
+		cmd.bind(10, (int)branch.installScriptCRC);
+
+		cmd.bind(11, branch.globalId);
+		cmd.bind(12, (int)branch.biid);
+
+		cmd.executenonquery();
+	}
+
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("DELETE from cdkey WHERE branchid=? and userid=?;");
+		cmd.bind(1, (int)branch.branchId);
+		cmd.bind(2, (int)branch.userId);
+		cmd.executenonquery();
+	}
+
+	for (auto &key : branch.cdKeys)
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("INSERT INTO cdkey VALUES (?,?,?);");
+		cmd.bind(1, (int)branch.branchId);
+		cmd.bind(2, (int)branch.userId);
+		cmd.bind(3, key);
+		cmd.executenonquery();
+	}
+
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("DELETE from tools WHERE branchid=?;");
+		cmd.bind(1, (int)branch.branchId);
+		cmd.executenonquery();
+	}
+
+	for (auto tool : branch.tools)
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("INSERT INTO tools VALUES (?,?);");
+		cmd.bind(1, (int)branch.branchId);
+		cmd.bind(2, (long long int)tool.toInt64());
+		cmd.executenonquery();
+	}
+}
+
+void ItemDbWriter::writeInstallInfo(DesuraId itemId, const InstallInfoDbRow &installInfo)
+{
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("REPLACE INTO installinfo VALUES (?,?,?,?, ?,?,?,?);");
+
+		cmd.bind(1, (long long int)itemId.toInt64());
+		cmd.bind(2, (int)installInfo.biid);
+		cmd.bind(3, installInfo.path);
+		cmd.bind(4, installInfo.installCheck);
+		cmd.bind(5, installInfo.installPrimary);
+		cmd.bind(6, (long long int)installInfo.installedMod);
+		cmd.bind(7, installInfo.installedBuild);
+		cmd.bind(8, installInfo.lastBuild);
+
+		cmd.executenonquery();
+	}
+
+	for (auto &exe : installInfo.exes)
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("REPLACE INTO exe VALUES (?,?,?,?,?,?,?);");
+
+		cmd.bind(1, (long long int)itemId.toInt64());
+		cmd.bind(2, (int)installInfo.biid);
+		cmd.bind(3, exe.name);
+		cmd.bind(4, exe.exe);
+		cmd.bind(5, exe.exeArgs);
+		cmd.bind(6, exe.userArgs);
+		cmd.bind(7, (int)exe.rank);
+
+		cmd.executenonquery();
+	}
+
+	//install checks are only listed while installed, so this also clears them on uninstall
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("DELETE FROM installinfoex WHERE itemid=? AND biid=?;");
+		cmd.bind(1, (long long int)itemId.toInt64());
+		cmd.bind(2, (int)installInfo.biid);
+		cmd.executenonquery();
+	}
+
+	for (auto &check : installInfo.installChecks)
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("INSERT INTO installinfoex VALUES (?,?,?);");
+
+		cmd.bind(1, (long long int)itemId.toInt64());
+		cmd.bind(2, (int)installInfo.biid);
+		cmd.bind(3, check);
+
+		cmd.executenonquery();
+	}
+}
+
+void ItemDbWriter::removeItem(const ItemDbRow &item)
+{
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("DELETE FROM iteminfo WHERE internalid=?;");
+		cmd.bind(1, (long long int)item.id.toInt64());
+		cmd.executenonquery();
+	}
+
+	for (auto &branch : item.branches)
+	{
+		{
+			sqlite3x::sqlite3_command &cmd = m_Db.command("DELETE FROM branchinfo WHERE branchid=? AND internalid=?;");
+			cmd.bind(1, (int)branch.branchId);
+			cmd.bind(2, (long long int)item.id.toInt64());
+			cmd.executenonquery();
+		}
+
+		{
+			sqlite3x::sqlite3_command &cmd = m_Db.command("DELETE FROM tools WHERE branchid=?;");
+			cmd.bind(1, (int)branch.branchId);
+			cmd.executenonquery();
+		}
+	}
+
+	for (auto &installInfo : item.installInfo)
+	{
+		{
+			sqlite3x::sqlite3_command &cmd = m_Db.command("DELETE FROM installinfo WHERE itemid=? AND biid=?;");
+			cmd.bind(1, (long long int)item.id.toInt64());
+			cmd.bind(2, (int)installInfo.biid);
+			cmd.executenonquery();
+		}
+
+		{
+			sqlite3x::sqlite3_command &cmd = m_Db.command("DELETE FROM installinfoex WHERE itemid=? AND biid=?;");
+			cmd.bind(1, (long long int)item.id.toInt64());
+			cmd.bind(2, (int)installInfo.biid);
+			cmd.executenonquery();
+		}
+	}
+
+	{
+		sqlite3x::sqlite3_command &cmd = m_Db.command("DELETE FROM exe WHERE itemid=?;");
+		cmd.bind(1, (long long int)item.id.toInt64());
+		cmd.executenonquery();
+	}
+}
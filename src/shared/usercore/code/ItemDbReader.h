@@ -0,0 +1,248 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_ITEMDBREADER_H
+#define DESURA_ITEMDBREADER_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include <map>
+#include <memory>
+
+namespace sqlite3x
+{
+	class sqlite3_connection;
+	class sqlite3_pooled_connection;
+	class sqlite3_command;
+}
+
+namespace UserCore
+{
+	namespace Item
+	{
+		//! Row from the exe table
+		class ExeDbRow
+		{
+		public:
+			gcString name;
+			gcString exe;
+			gcString exeArgs;
+			gcString userArgs;
+			uint32 rank = 0;
+		};
+
+		//! Row from the installinfo table along with its installinfoex and exe rows
+		class InstallInfoDbRow
+		{
+		public:
+			uint32 biid = 0;
+
+			gcString path;
+			gcString installCheck;
+			gcString installPrimary;
+
+			uint64 installedMod = 0;
+			int installedBuild = 0;
+			int lastBuild = 0;
+
+			std::vector<gcString> installChecks;
+			std::vector<ExeDbRow> exes;
+		};
+
+		//! Row from the branchinfo table along with its tools and (still encoded) cd keys
+		class BranchDbRow
+		{
+		public:
+			uint32 branchId = 0;
+			uint32 biid = 0;
+			uint32 userId = 0;	//user the cd keys belong to
+
+			gcString name;
+			uint32 flags = 0;
+			gcString eulaUrl;
+			gcString eulaDate;
+			gcString preOrderDate;
+			gcString installScript;
+			uint32 installScriptCRC = 0;
+			int globalId = 0;
+
+			std::vector<DesuraId> tools;
+			std::vector<gcString> cdKeys;
+		};
+
+		//! Row from the iteminfo table along with everything that hangs off it
+		class ItemDbRow
+		{
+		public:
+			DesuraId id;
+			DesuraId parentId;
+
+			uint32 percent = 0;
+			uint32 status = 0;
+
+			gcString rating;
+			gcString developer;
+			gcString name;
+			gcString shortName;
+			gcString profile;
+			gcString devProfile;
+			gcString icon;
+			gcString iconUrl;
+			gcString logo;
+			gcString logoUrl;
+			gcString publisher;
+			gcString publisherProfile;
+
+			int installedBranch = 0;
+			int lastBranch = 0;
+
+			std::vector<InstallInfoDbRow> installInfo;
+			std::vector<BranchDbRow> branches;
+		};
+
+		//! What one save of an item writes. It is copied out under the item lock so the saver
+		//! thread can write it without reading the live item
+		class ItemDbSnapshot
+		{
+		public:
+			//! Item is no longer kept so its rows get deleted instead
+			bool remove = false;
+
+			//! Write the iteminfo row, otherwise only the branches and install infos in item are written
+			bool itemRow = false;
+
+			ItemDbRow item;
+		};
+
+		//! Reads the item info tables with one query per table and groups the rows by item and branch
+		//! in memory, so items can be built without a query per item, branch or install info
+		//!
+		class ItemDbReader
+		{
+		public:
+			//! Constructor
+			//!
+			//! @param db Item info db
+			//! @param nUserId User to read cd keys for, cd keys are skipped if 0
+			//!
+			ItemDbReader(sqlite3x::sqlite3_connection &db, uint32 nUserId);
+
+			//! Reads every item in the db, ordered by id
+			//!
+			//! @param vItems Out list of items
+			//!
+			void readAll(std::vector<ItemDbRow> &vItems);
+
+			//! Fills in cd keys for items that were read before the user was known
+			//!
+			//! @param vItems Items read with a user id of 0
+			//!
+			void readCdKeys(std::vector<ItemDbRow> &vItems);
+
+			//! Reads a single item
+			//!
+			//! @param id Item to read
+			//! @param item Out item
+			//! @return False if the item is not in the db
+			//!
+			bool readItem(DesuraId id, ItemDbRow &item);
+
+			//! Reads a single branch
+			//!
+			//! @return False if the branch is not in the db
+			//!
+			bool readBranch(DesuraId itemId, uint32 branchId, BranchDbRow &branch);
+
+			//! Reads a single install info
+			//!
+			//! @return False if the install info is not in the db
+			//!
+			bool readInstallInfo(DesuraId itemId, uint32 biid, InstallInfoDbRow &installInfo);
+
+		protected:
+			void read(std::vector<ItemDbRow> &vItems, DesuraId id);
+
+		private:
+			sqlite3x::sqlite3_connection &m_Db;
+			const uint32 m_nUserId;
+		};
+
+		//! Statements used while saving a batch of items. Each sql string is prepared once
+		//! and reset between rows instead of being prepared again for every row.
+		//!
+		class ItemDbStatements
+		{
+		public:
+			//! Caches statements for the life of this object
+			ItemDbStatements(sqlite3x::sqlite3_connection &db);
+
+			//! Uses the statement cache of the pooled connection so statements outlive the batch
+			ItemDbStatements(sqlite3x::sqlite3_pooled_connection &db);
+
+			~ItemDbStatements();
+
+			sqlite3x::sqlite3_connection& connection();
+
+			//! Returns the prepared statement for szSql, reset and with no bindings
+			//!
+			sqlite3x::sqlite3_command& command(const char* szSql);
+
+		private:
+			sqlite3x::sqlite3_connection &m_Db;
+			sqlite3x::sqlite3_pooled_connection *m_pPooled;
+
+			std::map<std::string, std::unique_ptr<sqlite3x::sqlite3_command>> m_mCommands;
+		};
+
+		//! Writes item snapshots back to the item info tables, the counterpart to ItemDbReader
+		//!
+		class ItemDbWriter
+		{
+		public:
+			ItemDbWriter(ItemDbStatements &db);
+
+			//! Writes or deletes everything in the snapshot
+			//!
+			void write(const ItemDbSnapshot &snapshot);
+
+			//! Writes just the iteminfo row
+			//!
+			void writeItem(const ItemDbRow &item);
+
+			//! Writes a branch along with its tools and cd keys
+			//!
+			void writeBranch(DesuraId itemId, const BranchDbRow &branch);
+
+			//! Writes an install info along with its exes and install checks
+			//!
+			void writeInstallInfo(DesuraId itemId, const InstallInfoDbRow &installInfo);
+
+			//! Deletes the item and the branches and install infos listed in it
+			//!
+			void removeItem(const ItemDbRow &item);
+
+		private:
+			ItemDbStatements &m_Db;
+		};
+	}
+}
+
+#endif //DESURA_ITEMDBREADER_H
@@ -174,6 +174,7 @@ void ItemHandleEvents::reset()
 	m_LastProg = MCFCore::Misc::ProgressInfo();
 	m_LastProg.percent = -1;
 	m_LastProg.flag = -1;
+	m_ProgressLimiter.reset();
 
 	m_EventHistory.clear();
 }
@@ -197,6 +198,7 @@ void ItemHandleEvents::registerTask(gcRefPtr<UserCore::ItemTask::BaseItemTask> &
 	task->onErrorEvent			+= delegate(this, &ItemHandleEvents::onError);
 	task->onNeedWCEvent			+= delegate(this, &ItemHandleEvents::onNeedWildCard);
 
+	m_ProgressLimiter.reset();
 	task->onMcfProgressEvent	+= delegate(this, &ItemHandleEvents::onMcfProgress);
 	task->onNewProviderEvent	+= delegate(this, &ItemHandleEvents::onDownloadProvider);
 
@@ -247,6 +249,9 @@ void ItemHandleEvents::onNeedWildCard(WCSpecialInfo& info)
 
 void ItemHandleEvents::onMcfProgress(MCFCore::Misc::ProgressInfo& info)
 {
+	if (!m_ProgressLimiter.shouldPublish(info))
+		return;
+
 	std::lock_guard<std::recursive_mutex> guard(m_HelperLock);
 	if (info.percent != m_LastProg.percent || info.flag != m_LastProg.flag)
 	{
@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 
 #include "ItemHandle.h"
 #include "usercore/ItemHelpersI.h"
+#include "mcfcore/ProgressAggregator.h"
 
 namespace UserCore
 {
@@ -63,6 +64,7 @@ namespace UserCore
 
 		private:
 			MCFCore::Misc::ProgressInfo m_LastProg;
+			MCFCore::Misc::ProgressAggregator m_ProgressLimiter;
 
 			std::vector<gcRefPtr<EventItemI>> m_EventHistory;
 
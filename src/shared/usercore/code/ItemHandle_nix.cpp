@@ -189,6 +189,11 @@ void ItemHandle::doLaunch(bool useXdgOpen, const char* globalExe, const char* gl
 		ERROR_OUTPUT(gcString("Failed to create {0} process. [{1}: {2}].\n", getItemInfo()->getName(), errno, ei->getExe()).c_str());
 		throw gcException(ERR_LAUNCH, errno, gcString("Failed to create {0} process. [{1}: {2}].\n", getItemInfo()->getName(), errno, ei->getExe()));
 	}
+
+	auto pUserEx = getUserCore()->getInternal();
+
+	if (pUserEx)
+		pUserEx->onItemLaunched(getItemInfo()->getId(), getItemInfo()->getPath());
 }
 
 void ItemHandle::installLaunchScripts()
@@ -76,6 +76,9 @@ void ItemHandle::doLaunch(gcRefPtr<Helper::ItemLaunchHelperI> helper)
 
 	if (!res)
 		throw gcException(ERR_LAUNCH, GetLastError(), gcString("Failed to create {0} process. [{1}: {2}].\n", getItemInfo()->getName(), GetLastError(), ei->getExe()));
+
+	if (pUserEx)
+		pUserEx->onItemLaunched(getItemInfo()->getId(), getItemInfo()->getPath());
 }
 
 bool ItemHandle::createDesktopShortcut()
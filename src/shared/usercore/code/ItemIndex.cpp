@@ -0,0 +1,396 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "ItemIndex.h"
+#include "ItemInfo.h"
+
+using namespace UserCore::Item;
+
+
+namespace
+{
+	template <typename K, typename M>
+	void eraseFrom(std::map<K, M> &map, const K &key, uint64 id)
+	{
+		auto it = map.find(key);
+
+		if (it == map.end())
+			return;
+
+		it->second.erase(id);
+
+		if (it->second.empty())
+			map.erase(it);
+	}
+
+	template <typename K, typename M, typename F>
+	void visit(const std::map<K, M> &map, const K &key, const F &fn)
+	{
+		auto it = map.find(key);
+
+		if (it == map.end())
+			return;
+
+		for (auto &p : it->second)
+			fn(p.second);
+	}
+}
+
+
+uint32 ItemIndex::getIndexedStatus()
+{
+	return ItemInfoI::STATUS_DEVELOPER;
+}
+
+void ItemIndex::add(const gcRefPtr<ItemInfo> &item)
+{
+	if (!item)
+		return;
+
+	Keys keys;
+	keys.type = item->getId().getType();
+	keys.parentId = item->getParentId().toInt64();
+	keys.status = item->getStatus() & getIndexedStatus();
+
+	uint64 id = item->getId().toInt64();
+
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	auto it = m_mKeys.find(id);
+
+	if (it != m_mKeys.end())
+	{
+		if (it->second == keys)
+			return;
+
+		removeKeys(id, it->second);
+	}
+
+	m_mKeys[id] = keys;
+	m_mByType[keys.type][id] = item;
+	m_mByParent[keys.parentId][id] = item;
+
+	for (uint32 flag = 1; flag != 0 && flag <= keys.status; flag <<= 1)
+	{
+		if (HasAnyFlags(keys.status, flag))
+			m_mByStatus[flag][id] = item;
+	}
+}
+
+void ItemIndex::clear()
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	m_mKeys.clear();
+	m_mByType.clear();
+	m_mByParent.clear();
+	m_mByStatus.clear();
+}
+
+void ItemIndex::removeKeys(uint64 id, const Keys &keys)
+{
+	eraseFrom(m_mByType, keys.type, id);
+	eraseFrom(m_mByParent, keys.parentId, id);
+
+	for (uint32 flag = 1; flag != 0 && flag <= keys.status; flag <<= 1)
+	{
+		if (HasAnyFlags(keys.status, flag))
+			eraseFrom(m_mByStatus, flag, id);
+	}
+}
+
+void ItemIndex::forEachOfType(uint8 type, const VisitorFn &fn) const
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+	visit(m_mByType, type, fn);
+}
+
+void ItemIndex::forEachWithParent(DesuraId parentId, const VisitorFn &fn) const
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+	visit(m_mByParent, parentId.toInt64(), fn);
+}
+
+void ItemIndex::forEachWithStatus(uint32 flag, const VisitorFn &fn) const
+{
+	gcAssert(HasAllFlags(getIndexedStatus(), flag));
+
+	std::lock_guard<std::mutex> guard(m_Lock);
+	visit(m_mByStatus, flag, fn);
+}
+
+
+
+#ifdef LINK_WITH_GTEST
+
+#include <chrono>
+
+namespace UnitTest
+{
+	using namespace ::testing;
+
+	class ItemIndexFixture : public ::testing::Test
+	{
+	public:
+		ItemIndexFixture()
+			: user(gcRefPtr<UserCore::UserMock>::create())
+			, m_ItemManager(gcRefPtr<UserCore::ItemManagerMock>::create())
+		{
+			ON_CALL(*user, getUserId()).WillByDefault(Return(1));
+			ON_CALL(*user, getItemsAddedEvent()).WillByDefault(ReturnRef(m_ItemAddedEvent));
+			ON_CALL(*user, getItemManager()).WillByDefault(Return(gcRefPtr<UserCore::ItemManagerI>(m_ItemManager)));
+
+			ON_CALL(*m_ItemManager, getOnNewItemEvent()).WillByDefault(ReturnRef(m_NewItemEvent));
+		}
+
+		~ItemIndexFixture()
+		{
+			for (auto &p : m_mItems)
+				p.second->getIndexChangeEvent() -= delegate(this, &ItemIndexFixture::onIndexChange);
+		}
+
+		gcRefPtr<ItemInfo> addItem(DesuraId id, DesuraId parentId = DesuraId())
+		{
+			auto item = gcRefPtr<ItemInfo>::create(user, id, parentId, &fs);
+			item->getIndexChangeEvent() += delegate(this, &ItemIndexFixture::onIndexChange);
+
+			m_mItems[id.toInt64()] = item;
+			m_Index.add(item);
+
+			return item;
+		}
+
+		std::vector<gcRefPtr<ItemInfo>> collect(std::function<void(const ItemIndex::VisitorFn&)> forEach)
+		{
+			std::vector<gcRefPtr<ItemInfo>> vList;
+
+			forEach([&vList](const gcRefPtr<ItemInfo> &item){
+				vList.push_back(item);
+			});
+
+			return vList;
+		}
+
+		std::vector<gcRefPtr<ItemInfo>> getByType(uint8 type)
+		{
+			return collect([this, type](const ItemIndex::VisitorFn &fn){ m_Index.forEachOfType(type, fn); });
+		}
+
+		std::vector<gcRefPtr<ItemInfo>> getByParent(DesuraId parentId)
+		{
+			return collect([this, parentId](const ItemIndex::VisitorFn &fn){ m_Index.forEachWithParent(parentId, fn); });
+		}
+
+		std::vector<gcRefPtr<ItemInfo>> getByStatus(uint32 flag)
+		{
+			return collect([this, flag](const ItemIndex::VisitorFn &fn){ m_Index.forEachWithStatus(flag, fn); });
+		}
+
+		void onIndexChange(DesuraId &id)
+		{
+			m_Index.add(m_mItems[id.toInt64()]);
+		}
+
+		Event<DesuraId> m_NewItemEvent;
+		Event<uint32> m_ItemAddedEvent;
+
+		gcRefPtr<UserCore::UserMock> user;
+		UTIL::FS::UtilFSMock fs;
+		gcRefPtr<UserCore::ItemManagerMock> m_ItemManager;
+
+		std::map<uint64, gcRefPtr<ItemInfo>> m_mItems;
+		ItemIndex m_Index;
+	};
+
+	TEST_F(ItemIndexFixture, InsertAndLookup)
+	{
+		DesuraId gameA(1, DesuraId::TYPE_GAME);
+		DesuraId gameB(2, DesuraId::TYPE_GAME);
+		DesuraId gameC(3, DesuraId::TYPE_GAME);
+		DesuraId modId(4, DesuraId::TYPE_MOD);
+		DesuraId linkId(5, DesuraId::TYPE_LINK);
+
+		addItem(gameC);
+		addItem(gameA);
+		addItem(modId, gameB);
+		addItem(gameB);
+		addItem(linkId);
+
+		auto vGames = getByType(DesuraId::TYPE_GAME);
+		ASSERT_EQ(3u, vGames.size());
+		ASSERT_EQ(gameA, vGames[0]->getId());
+		ASSERT_EQ(gameB, vGames[1]->getId());
+		ASSERT_EQ(gameC, vGames[2]->getId());
+
+		auto vLinks = getByType(DesuraId::TYPE_LINK);
+		ASSERT_EQ(1u, vLinks.size());
+		ASSERT_EQ(linkId, vLinks[0]->getId());
+
+		auto vMods = getByParent(gameB);
+		ASSERT_EQ(1u, vMods.size());
+		ASSERT_EQ(modId, vMods[0]->getId());
+
+		ASSERT_EQ(0u, getByParent(gameA).size());
+		ASSERT_EQ(0u, getByType(DesuraId::TYPE_TOOL).size());
+		ASSERT_EQ(0u, getByStatus(ItemInfoI::STATUS_DEVELOPER).size());
+	}
+
+	TEST_F(ItemIndexFixture, AddingAgainDoesNotDuplicate)
+	{
+		DesuraId gameId(1, DesuraId::TYPE_GAME);
+		DesuraId modId(2, DesuraId::TYPE_MOD);
+
+		addItem(gameId);
+		auto mod = addItem(modId, gameId);
+
+		m_Index.add(mod);
+		m_Index.add(mod);
+
+		ASSERT_EQ(1u, getByType(DesuraId::TYPE_MOD).size());
+		ASSERT_EQ(1u, getByParent(gameId).size());
+	}
+
+	TEST_F(ItemIndexFixture, UpdateMovesItemToNewKeys)
+	{
+		DesuraId gameA(1, DesuraId::TYPE_GAME);
+		DesuraId gameB(2, DesuraId::TYPE_GAME);
+		DesuraId modId(3, DesuraId::TYPE_MOD);
+
+		addItem(gameA);
+		addItem(gameB);
+
+		//not hooked up to the index change event so the index only moves it when it is added again
+		auto mod = gcRefPtr<ItemInfo>::create(user, modId, gameA, &fs);
+		m_Index.add(mod);
+
+		mod->setParentId(gameB);
+		mod->addSFlag(ItemInfoI::STATUS_DEVELOPER);
+
+		ASSERT_EQ(1u, getByParent(gameA).size());
+		ASSERT_EQ(0u, getByStatus(ItemInfoI::STATUS_DEVELOPER).size());
+
+		m_Index.add(mod);
+
+		ASSERT_EQ(0u, getByParent(gameA).size());
+		ASSERT_EQ(1u, getByParent(gameB).size());
+		ASSERT_EQ(1u, getByStatus(ItemInfoI::STATUS_DEVELOPER).size());
+		ASSERT_EQ(1u, getByType(DesuraId::TYPE_MOD).size());
+	}
+
+	TEST_F(ItemIndexFixture, ClearEmptiesEveryIndex)
+	{
+		DesuraId gameId(1, DesuraId::TYPE_GAME);
+
+		addItem(gameId)->addSFlag(ItemInfoI::STATUS_DEVELOPER);
+		addItem(DesuraId(2, DesuraId::TYPE_MOD), gameId);
+
+		m_Index.clear();
+
+		ASSERT_EQ(0u, getByType(DesuraId::TYPE_GAME).size());
+		ASSERT_EQ(0u, getByParent(gameId).size());
+		ASSERT_EQ(0u, getByStatus(ItemInfoI::STATUS_DEVELOPER).size());
+	}
+
+	TEST_F(ItemIndexFixture, FollowsStatusAndParentChanges)
+	{
+		DesuraId gameA(1, DesuraId::TYPE_GAME);
+		DesuraId gameB(2, DesuraId::TYPE_GAME);
+		DesuraId modId(3, DesuraId::TYPE_MOD);
+
+		addItem(gameA);
+		addItem(gameB);
+		auto mod = addItem(modId, gameA);
+
+		auto vGames = getByType(DesuraId::TYPE_GAME);
+		ASSERT_EQ(2u, vGames.size());
+		ASSERT_EQ(gameA, vGames[0]->getId());
+
+		ASSERT_EQ(1u, getByParent(gameA).size());
+		ASSERT_EQ(0u, getByStatus(ItemInfoI::STATUS_DEVELOPER).size());
+
+		mod->addSFlag(ItemInfoI::STATUS_DEVELOPER);
+		mod->setParentId(gameB);
+
+		auto vDev = getByStatus(ItemInfoI::STATUS_DEVELOPER);
+		ASSERT_EQ(1u, vDev.size());
+		ASSERT_EQ(modId, vDev[0]->getId());
+
+		ASSERT_EQ(0u, getByParent(gameA).size());
+		ASSERT_EQ(1u, getByParent(gameB).size());
+
+		mod->delSFlag(ItemInfoI::STATUS_DEVELOPER);
+
+		ASSERT_EQ(0u, getByStatus(ItemInfoI::STATUS_DEVELOPER).size());
+		ASSERT_EQ(2u, getByType(DesuraId::TYPE_GAME).size());
+	}
+
+	TEST_F(ItemIndexFixture, ListLatency)
+	{
+		const uint32 nGames = 5000;
+		const uint32 nLists = 100;
+
+		for (uint32 x=0; x<nGames; x++)
+		{
+			DesuraId gameId(x+1, DesuraId::TYPE_GAME);
+			addItem(gameId);
+			addItem(DesuraId(x+1, DesuraId::TYPE_MOD), gameId);
+		}
+
+		size_t nScanned = 0;
+		size_t nIndexed = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint32 x=0; x<nLists; x++)
+		{
+			DesuraId gameId(x+1, DesuraId::TYPE_GAME);
+
+			for (auto &p : m_mItems)
+			{
+				if (p.second->getId().getType() == DesuraId::TYPE_MOD && p.second->getParentId() == gameId)
+					nScanned++;
+			}
+		}
+
+		auto mid = std::chrono::steady_clock::now();
+
+		for (uint32 x=0; x<nLists; x++)
+		{
+			m_Index.forEachWithParent(DesuraId(x+1, DesuraId::TYPE_GAME), [&nIndexed](const gcRefPtr<ItemInfo> &item){
+				if (item->getId().getType() == DesuraId::TYPE_MOD)
+					nIndexed++;
+			});
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		ASSERT_EQ(nLists, nScanned);
+		ASSERT_EQ(nScanned, nIndexed);
+
+		double scanMs = std::chrono::duration<double, std::milli>(mid - start).count();
+		double indexMs = std::chrono::duration<double, std::milli>(end - mid).count();
+
+		RecordProperty("scan_mod_list_ms", gcString("{0}", scanMs));
+		RecordProperty("index_mod_list_ms", gcString("{0}", indexMs));
+	}
+}
+
+#endif
@@ -0,0 +1,97 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_ITEMINDEX_H
+#define DESURA_ITEMINDEX_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include <functional>
+#include <map>
+#include <mutex>
+
+namespace UserCore
+{
+	namespace Item
+	{
+		class ItemInfo;
+
+		//! Secondary indexes over the items the item manager holds, so list queries cost the size
+		//! of their result instead of a scan of every item. Keys are read from the item when it is
+		//! added so it needs adding again when its status or parent changes
+		//!
+		class ItemIndex
+		{
+		public:
+			//! Adds an item or moves it to its current keys
+			//!
+			void add(const gcRefPtr<ItemInfo> &item);
+
+			void clear();
+
+			typedef std::function<void(const gcRefPtr<ItemInfo>&)> VisitorFn;
+
+			//! Calls fn with each item of a type (DesuraId::TYPE_*) ordered by id. The index is locked
+			//! while fn runs so it must not add or remove items
+			//!
+			void forEachOfType(uint8 type, const VisitorFn &fn) const;
+
+			//! Calls fn with each item with this parent ordered by id
+			//!
+			void forEachWithParent(DesuraId parentId, const VisitorFn &fn) const;
+
+			//! Calls fn with each item with this status flag ordered by id. Only flags in getIndexedStatus are indexed
+			//!
+			void forEachWithStatus(uint32 flag, const VisitorFn &fn) const;
+
+			static uint32 getIndexedStatus();
+
+		protected:
+			class Keys
+			{
+			public:
+				uint8 type = 0;
+				uint64 parentId = 0;
+				uint32 status = 0;
+
+				bool operator==(const Keys &keys) const
+				{
+					return type == keys.type && parentId == keys.parentId && status == keys.status;
+				}
+			};
+
+			typedef std::map<uint64, gcRefPtr<ItemInfo>> ItemMap;
+
+			void removeKeys(uint64 id, const Keys &keys);
+
+		private:
+			std::map<uint64, Keys> m_mKeys;
+
+			std::map<uint8, ItemMap> m_mByType;
+			std::map<uint64, ItemMap> m_mByParent;
+			std::map<uint32, ItemMap> m_mByStatus;
+
+			mutable std::mutex m_Lock;
+		};
+	}
+}
+
+#endif //DESURA_ITEMINDEX_H
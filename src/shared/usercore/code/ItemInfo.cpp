@@ -37,6 +37,9 @@ Contact us at legal@badjuju.com.
 
 #include "BranchInfo.h"
 #include "BranchInstallInfo.h"
+#include "ItemDbReader.h"
+#include "ItemIndex.h"
+#include "ItemUpdateFingerprints.h"
 
 
 using namespace UserCore::Item;
@@ -71,167 +74,177 @@ ItemInfo::~ItemInfo()
 }
 
 
-void ItemInfo::deleteFromDb(sqlite3x::sqlite3_connection* db)
+bool ItemInfo::shouldSaveDb()
 {
-	if (!m_bAddedToDb)
-		return;
-
-	gcTrace("");
-
-	try
-	{
-		sqlite3x::sqlite3_command cmd(*db, "DELETE FROM iteminfo WHERE internalid=?;");
-		cmd.bind(1, (long long int)m_iId.toInt64());
-		cmd.executenonquery();
-	}
-	catch (...)
-	{
-	}
+	bool isDeleted = HasAllFlags(getStatus(), ItemInfoI::STATUS_DELETED);
+	bool isOnAccount = HasAllFlags(getStatus(), ItemInfoI::STATUS_ONACCOUNT);
+	bool isOnComp = HasAnyFlags(getStatus(), ItemInfoI::STATUS_ONCOMPUTER|ItemInfoI::STATUS_INSTALLED);
 
-	for (size_t x=0; x<m_vBranchList.size(); x++)
-	{
-		m_vBranchList[x]->deleteFromDb(db);
-	}
+	return !(isDeleted || (isOnAccount && !isOnComp));
+}
 
-	std::for_each(m_mBranchInstallInfo.begin(), m_mBranchInstallInfo.end(), [&db](std::pair<uint32, gcRefPtr<BranchInstallInfo>> p)
-	{
-		p.second->deleteFromDb(db);
-	});
+void ItemInfo::saveDbFull(ItemDbStatements &db)
+{
+	ItemDbSnapshot snapshot;
 
-	try
-	{
-		sqlite3x::sqlite3_command cmd(*db, "DELETE FROM exe WHERE itemid=?;");
-		cmd.bind(1, (long long int)m_iId.toInt64());
-		cmd.executenonquery();
-	}
-	catch (...)
-	{
-	}
+	if (saveDbFull(snapshot))
+		ItemDbWriter(db).write(snapshot);
 }
 
-
-bool ItemInfo::shouldSaveDb(sqlite3x::sqlite3_connection* db)
+bool ItemInfo::saveDbDirty(ItemDbStatements &db)
 {
-	if (!db)
-		return false;
+	ItemDbSnapshot snapshot;
 
-	bool isDeleted = HasAllFlags(getStatus(), ItemInfoI::STATUS_DELETED);
-	bool isOnAccount = HasAllFlags(getStatus(), ItemInfoI::STATUS_ONACCOUNT);
-	bool isOnComp = HasAnyFlags(getStatus(), ItemInfoI::STATUS_ONCOMPUTER|ItemInfoI::STATUS_INSTALLED);
-
-	if (isDeleted || (isOnAccount && !isOnComp))
-	{
-		deleteFromDb(db);
+	if (!saveDbDirty(snapshot))
 		return false;
-	}
 
+	ItemDbWriter(db).write(snapshot);
 	return true;
 }
 
-void ItemInfo::saveDb(sqlite3x::sqlite3_connection* db)
+bool ItemInfo::saveDbFull(ItemDbSnapshot &snapshot)
 {
-	if (!shouldSaveDb(db))
-		return;
+	std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 
-	if (!db)
-		return;
+	clearDirty();
+	snapshot.item.id = m_iId;
 
-	sqlite3x::sqlite3_command cmd(*db, "SELECT count(*) FROM iteminfo WHERE internalid=?;");
-	cmd.bind(1, (long long int)m_iId.toInt64());
+	if (!shouldSaveDb())
+	{
+		if (!m_bAddedToDb)
+			return false;
 
-	int count = cmd.executeint();
+		gcTrace("");
 
-	if (count == 0)
-	{
-		saveDbFull(db);
+		m_bAddedToDb = false;
+		snapshot.remove = true;
+
+		for (auto b : m_vBranchList)
+		{
+			BranchDbRow row;
+			row.branchId = b->getBranchId();
+			snapshot.item.branches.push_back(row);
+		}
+
+		for (auto p : m_mBranchInstallInfo)
+		{
+			InstallInfoDbRow row;
+			row.biid = p.second->getBiId();
+			snapshot.item.installInfo.push_back(row);
+		}
+
+		return true;
 	}
-	else
-	{
-		sqlite3x::sqlite3_command cmd(*db, "UPDATE iteminfo SET "
-											"statusflags=?,"
-											"percent=?,"
-											"icon=?,"
-											"logo=?,"
-											"iconurl=?,"
-											"logourl=?,"
-											"ibranch=?,"
-											"lastbranch=? WHERE internalid=?;");
 
-		uint32 status = m_iStatus&(~ItemInfoI::STATUS_DEVELOPER);
+	m_bAddedToDb = true;
+	snapshot.itemRow = true;
 
-		cmd.bind(1, (int)status); //status
-		cmd.bind(2, (int)m_iPercent); //percent
+	auto &row = snapshot.item;
 
-		cmd.bind(3, UTIL::OS::getRelativePath(m_szIcon)); //icon
-		cmd.bind(4, UTIL::OS::getRelativePath(m_szLogo)); //logo
-		cmd.bind(5, m_szIconUrl); //icon
-		cmd.bind(6, m_szLogoUrl); //logo
+	row.parentId = m_iParentId;
+	row.percent = m_iPercent;
+	row.status = m_iStatus&(~ItemInfoI::STATUS_DEVELOPER);
+	row.rating = m_szRating;
 
-		cmd.bind(7, (int)m_INBranch);
-		cmd.bind(8, (int)m_LastBranch);
+	row.developer = m_szDev;
+	row.name = m_szName;
+	row.shortName = m_szShortName;
+	row.profile = m_szProfile;
+	row.devProfile = m_szDevProfile;
 
-		cmd.bind(9, (long long int)m_iId.toInt64()); //internal id
-		cmd.executenonquery();
+	row.icon = UTIL::OS::getRelativePath(m_szIcon);
+	row.iconUrl = m_szIconUrl;
+	row.logo = UTIL::OS::getRelativePath(m_szLogo);
+	row.logoUrl = m_szLogoUrl;
+	row.publisher = m_szPublisher;
 
-		for (size_t x=0; x<m_vBranchList.size(); x++)
-		{
-			m_vBranchList[x]->saveDb(db);
-		}
+	row.publisherProfile = m_szPublisherProfile;
+	row.installedBranch = (int)m_INBranch;
+	row.lastBranch = (int)m_LastBranch;
 
-		std::for_each(m_mBranchInstallInfo.begin(), m_mBranchInstallInfo.end(), [&db](std::pair<uint32, gcRefPtr<BranchInstallInfo>> p)
-		{
-			p.second->saveDb(db);
-		});
+	for (auto b : m_vBranchList)
+	{
+		row.branches.push_back(BranchDbRow());
+		b->saveDb(row.branches.back());
+	}
+
+	for (auto p : m_mBranchInstallInfo)
+	{
+		row.installInfo.push_back(InstallInfoDbRow());
+		p.second->saveDb(row.installInfo.back());
 	}
+
+	return true;
 }
 
-void ItemInfo::saveDbFull(sqlite3x::sqlite3_connection* db)
+bool ItemInfo::saveDbDirty(ItemDbSnapshot &snapshot)
 {
-	if (!shouldSaveDb(db))
-		return;
+	std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 
-	if (!db)
-		return;
+	if (!isDirty())
+		return false;
 
-	m_bAddedToDb = true;
+	//status changes decide if the item is kept at all so they go through the full save
+	if (m_bDirty || !m_bAddedToDb)
+		return saveDbFull(snapshot);
 
-	uint32 status = m_iStatus&(~ItemInfoI::STATUS_DEVELOPER);
+	snapshot.item.id = m_iId;
 
-	sqlite3x::sqlite3_command cmd(*db, "REPLACE INTO iteminfo VALUES (?,?,?,?,?, ?,?,?,?,?, ?,?,?,?,?, ?,?,?);");
+	for (auto b : m_vBranchList)
+	{
+		if (!b->isDirty())
+			continue;
 
-	cmd.bind(1, (long long int)m_iId.toInt64());		// id
-	cmd.bind(2, (long long int)m_iParentId.toInt64());	// parent id
-	cmd.bind(3, (int)m_iPercent);	//
-	cmd.bind(4, (int)status);		//
-	cmd.bind(5, m_szRating);		//
+		snapshot.item.branches.push_back(BranchDbRow());
+		b->saveDb(snapshot.item.branches.back());
+	}
 
-	cmd.bind(6, m_szDev);			//
-	cmd.bind(7, m_szName);			//
-	cmd.bind(8, m_szShortName);		//
-	cmd.bind(9, m_szProfile);		//
-	cmd.bind(10, m_szDevProfile);	//
+	for (auto p : m_mBranchInstallInfo)
+	{
+		if (!p.second->isDirty())
+			continue;
 
-	cmd.bind(11, UTIL::OS::getRelativePath(m_szIcon));			//
-	cmd.bind(12, m_szIconUrl);		//
-	cmd.bind(13, UTIL::OS::getRelativePath(m_szLogo));			//
-	cmd.bind(14, m_szLogoUrl);		//
-	cmd.bind(15, m_szPublisher);
+		snapshot.item.installInfo.push_back(InstallInfoDbRow());
+		p.second->saveDb(snapshot.item.installInfo.back());
+	}
 
-	cmd.bind(16, m_szPublisherProfile);
-	cmd.bind(17, (int)m_INBranch);
-	cmd.bind(18, (int)m_LastBranch);
+	return !snapshot.item.branches.empty() || !snapshot.item.installInfo.empty();
+}
+
+void ItemInfo::markDirty()
+{
+	m_bDirty = true;
+}
 
-	cmd.executenonquery();
+bool ItemInfo::isDirty()
+{
+	if (m_bDirty)
+		return true;
 
 	for (auto b : m_vBranchList)
 	{
-		b->saveDbFull(db);
+		if (b->isDirty())
+			return true;
 	}
 
 	for (auto p : m_mBranchInstallInfo)
 	{
-		p.second->saveDb(db);
+		if (p.second->isDirty())
+			return true;
 	}
+
+	return false;
+}
+
+void ItemInfo::clearDirty()
+{
+	m_bDirty = false;
+
+	for (auto b : m_vBranchList)
+		b->clearDirty();
+
+	for (auto p : m_mBranchInstallInfo)
+		p.second->clearDirty();
 }
 
 void ItemInfo::loadDb(sqlite3x::sqlite3_connection* db)
@@ -239,110 +252,78 @@ void ItemInfo::loadDb(sqlite3x::sqlite3_connection* db)
 	if (!db)
 		return;
 
-	m_bAddedToDb = true;
+	ItemDbRow row;
+	row.id = m_iId;
 
-	sqlite3x::sqlite3_command cmd(*db, "SELECT * FROM iteminfo WHERE internalid=?;");
-	cmd.bind(1, (long long int)m_iId.toInt64());
-	sqlite3x::sqlite3_reader reader = cmd.executereader();
+	ItemDbReader(*db, m_pUserCore->getUserId()).readItem(m_iId, row);
+	loadDb(row);
+}
 
-	reader.read();
+void ItemInfo::loadDb(const ItemDbRow &row)
+{
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 
-	// reader.getint(0); //internal id
-	// reader.getint(1); //parent id
+		m_bAddedToDb = true;
 
-	m_iPercent		= reader.getint(2);				 //percent
-	m_iStatus		= reader.getint(3);				 //status flags
-	m_szRating		= gcString(reader.getstring(4)); //rating
+		m_iPercent		= row.percent;
+		m_iStatus		= row.status;
+		m_szRating		= row.rating;
 
-	m_szDev			= gcString(reader.getstring(5)); //developer
-	m_szName		= gcString(reader.getstring(6)); //name
-	m_szShortName	= gcString(reader.getstring(7)); //shortname
-	m_szProfile		= gcString(reader.getstring(8)); //profile url
-	m_szDevProfile	= gcString(reader.getstring(9)); //dev profile
+		m_szDev			= row.developer;
+		m_szName		= row.name;
+		m_szShortName	= row.shortName;
+		m_szProfile		= row.profile;
+		m_szDevProfile	= row.devProfile;
 
-	m_szIcon		= UTIL::OS::getAbsPath(reader.getstring(10)); //icon
-	m_szIconUrl		= gcString(reader.getstring(11)); //icon url
-	m_szLogo		= UTIL::OS::getAbsPath(reader.getstring(12)); //logo
-	m_szLogoUrl		= gcString(reader.getstring(13)); //logo url
+		m_szIcon		= UTIL::OS::getAbsPath(row.icon);
+		m_szIconUrl		= row.iconUrl;
+		m_szLogo		= UTIL::OS::getAbsPath(row.logo);
+		m_szLogoUrl		= row.logoUrl;
 
-	m_szPublisher	= reader.getstring(14);
-	m_szPublisherProfile = reader.getstring(15);
+		m_szPublisher	= row.publisher;
+		m_szPublisherProfile = row.publisherProfile;
 
-	m_INBranch		= MCFBranch::BranchFromInt(reader.getint(16));
-	m_LastBranch	= MCFBranch::BranchFromInt(reader.getint(17));
+		m_INBranch		= MCFBranch::BranchFromInt(row.installedBranch);
+		m_LastBranch	= MCFBranch::BranchFromInt(row.lastBranch);
 
+		//matches the db now, anything below that changes it marks it dirty again
+		m_bDirty = false;
 
-	if (HasAnyFlags(m_iStatus, UserCore::Item::ItemInfoI::STATUS_ONACCOUNT))
-	{
-		m_bWasOnAccount = true;
-		m_iStatus &= ~UserCore::Item::ItemInfoI::STATUS_ONACCOUNT;
+		if (HasAnyFlags(m_iStatus, UserCore::Item::ItemInfoI::STATUS_ONACCOUNT))
+		{
+			m_bWasOnAccount = true;
+			m_iStatus &= ~UserCore::Item::ItemInfoI::STATUS_ONACCOUNT;
+			markDirty();
+		}
 	}
 
 	delSFlag(ItemInfoI::STATUS_UPDATEAVAL);
 
 	{
-		std::vector<uint32> vIdList;
-
-		sqlite3x::sqlite3_command cmd(*db, "SELECT biid FROM installinfo WHERE itemid=?;");
-		cmd.bind(1, (long long int)m_iId.toInt64());
-		sqlite3x::sqlite3_reader reader = cmd.executereader();
-
-		while (reader.read())
-		{
-			vIdList.push_back(reader.getint(0));
-		}
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 
-		for (size_t x=0; x<vIdList.size(); x++)
+		for (auto &iiRow : row.installInfo)
 		{
-			auto bii = gcRefPtr<BranchInstallInfo>::create(MCFBranch::BranchFromInt(vIdList[x]), this, m_pFileSystem);
-
-			try
-			{
-				bii->loadDb(db);
-			}
-			catch (std::exception &)
-			{
-				safe_delete(bii);
-				continue;
-			}
-
-			m_mBranchInstallInfo[vIdList[x]] = bii;
-		}
-	}
-
-	{
-		std::vector<std::pair<uint32,uint32> > vIdList;
-
-		sqlite3x::sqlite3_command cmd(*db, "SELECT branchid, biid FROM branchinfo WHERE internalid=?;");
-		cmd.bind(1, (long long int)m_iId.toInt64());
-		sqlite3x::sqlite3_reader reader = cmd.executereader();
+			auto bii = gcRefPtr<BranchInstallInfo>::create(MCFBranch::BranchFromInt(iiRow.biid), this, m_pFileSystem);
+			bii->loadDb(iiRow);
 
-		while (reader.read())
-		{
-			vIdList.push_back(std::pair<uint32, uint32>(reader.getint(0), reader.getint(1)));
+			m_mBranchInstallInfo[iiRow.biid] = bii;
 		}
 
-		for (size_t x=0; x<vIdList.size(); x++)
+		for (size_t x=0; x<row.branches.size(); x++)
 		{
-			auto it = m_mBranchInstallInfo.find(vIdList[x].second);
+			auto &biRow = row.branches[x];
+			auto it = m_mBranchInstallInfo.find(biRow.biid);
 
 			if (it == m_mBranchInstallInfo.end())
-				m_mBranchInstallInfo[vIdList[x].second] = new BranchInstallInfo(vIdList[x].second, this, m_pFileSystem);
+				m_mBranchInstallInfo[biRow.biid] = new BranchInstallInfo(biRow.biid, this, m_pFileSystem);
 
-			auto bi = gcRefPtr<BranchInfo>::create(MCFBranch::BranchFromInt(vIdList[x].first), m_iId, m_mBranchInstallInfo[vIdList[x].second], 0, m_pUserCore->getUserId());
+			auto bi = gcRefPtr<BranchInfo>::create(MCFBranch::BranchFromInt(biRow.branchId), m_iId, m_mBranchInstallInfo[biRow.biid], 0, m_pUserCore->getUserId());
 			bi->onBranchInfoChangedEvent += delegate(this, &ItemInfo::onBranchInfoChanged);
+			bi->loadDb(biRow);
 
-			try
-			{
-				bi->loadDb(db);
-			}
-			catch (std::exception &)
-			{
-				safe_delete(bi);
-				continue;
-			}
-
-			if (vIdList[x].first == m_INBranch)
+			if (biRow.branchId == m_INBranch)
 			{
 				gcTrace("Changing Current Branch");
 				m_INBranchIndex = x;
@@ -383,6 +364,8 @@ void ItemInfo::loadDb(sqlite3x::sqlite3_connection* db)
 
 			if (!bi && HasAnyFlags(getStatus(), ItemInfoI::STATUS_LINK) && m_mBranchInstallInfo.find(BUILDID_PUBLIC) != end(m_mBranchInstallInfo))
 			{
+				std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
 				m_vBranchList.push_back(new UserCore::Item::BranchInfo(MCFBranch::BranchFromInt(0), getId(), m_mBranchInstallInfo[BUILDID_PUBLIC], 0, m_pUserCore->getUserId()));
 				bi = m_vBranchList[0];
 				bi->setLinkInfo(getName());
@@ -390,6 +373,7 @@ void ItemInfo::loadDb(sqlite3x::sqlite3_connection* db)
 				gcTrace("Changing Current Branch");
 				m_INBranchIndex = 0;
 				m_INBranch = MCFBranch::BranchFromInt(0);
+				markDirty();
 			}
 
 			if (bi && m_pFileSystem->isValidFile(UTIL::FS::PathWithFile(bi->getInstallInfo()->getInstallCheck())) )
@@ -443,6 +427,8 @@ void ItemInfo::loadBranchXmlData(const XML::gcXMLElement &branch)
 		uint32 platformId = 100;
 		branch.GetAtt("platformid", platformId);
 
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
 		auto it = m_mBranchInstallInfo.find(platformId);
 
 		if (it == m_mBranchInstallInfo.end())
@@ -456,6 +442,7 @@ void ItemInfo::loadBranchXmlData(const XML::gcXMLElement &branch)
 
 	if (!found)
 	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 		m_vBranchList.push_back(bi);
 
 		size_t x=m_vBranchList.size()-1;
@@ -479,12 +466,18 @@ void ItemInfo::loadXmlData(uint32 platform, const XML::gcXMLElement &xmlNode, ui
 	auto statNode = xmlNode.FirstChildElement("status");
 	if (statNode.IsValid())
 	{
-		bool isDev = (m_iStatus&ItemInfoI::STATUS_DEVELOPER)?true:false;
+		{
+			std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 
-		statNode.GetAtt("id", m_iStatus);
+			bool isDev = (m_iStatus&ItemInfoI::STATUS_DEVELOPER)?true:false;
 
-		if (isDev)
-			m_iStatus |= ItemInfoI::STATUS_DEVELOPER;
+			statNode.GetAtt("id", m_iStatus);
+
+			if (isDev)
+				m_iStatus |= ItemInfoI::STATUS_DEVELOPER;
+		}
+
+		onIndexChange(m_iStatus);
 	}
 
 	bool installed = HasAllFlags(m_iStatus, ItemInfoI::STATUS_INSTALLED);
@@ -555,6 +548,8 @@ void ItemInfo::loadXmlData(uint32 platform, const XML::gcXMLElement &xmlNode, ui
 		{
 			gcTrace("Changing Current Branch");
 
+			std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
 			m_INBranchIndex = vBranchList[0];
 			m_INBranch = m_vBranchList[m_INBranchIndex]->getBranchId();
 			m_vBranchList[m_INBranchIndex]->getInstallInfo()->setInstalledMcf(m_vBranchList[m_INBranchIndex]->getLatestBuild());
@@ -571,6 +566,7 @@ void ItemInfo::loadXmlData(uint32 platform, const XML::gcXMLElement &xmlNode, ui
 	}
 
 	m_iChangedFlags |= ItemInfoI::CHANGED_INFO;
+	markDirty();
 	broughtCheck();
 
 	m_pUserCore->getItemManager()->saveItem(this);
@@ -586,13 +582,18 @@ void ItemInfo::processInfo(const XML::gcXMLElement &xmlEl)
 
 	//desura info
 	xmlEl.GetChild("name", this, &ItemInfo::setName);
-	xmlEl.GetChild("nameid", m_szShortName);
-	xmlEl.GetChild("summary", m_szDesc);
-	xmlEl.GetChild("url", m_szProfile);
-	xmlEl.GetChild("style", m_szGenre);
-	xmlEl.GetChild("theme", m_szTheme);
-	xmlEl.GetChild("rating", m_szRating);
-	xmlEl.GetChild("eula", m_szEULAUrl);
+
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
+		xmlEl.GetChild("nameid", m_szShortName);
+		xmlEl.GetChild("summary", m_szDesc);
+		xmlEl.GetChild("url", m_szProfile);
+		xmlEl.GetChild("style", m_szGenre);
+		xmlEl.GetChild("theme", m_szTheme);
+		xmlEl.GetChild("rating", m_szRating);
+		xmlEl.GetChild("eula", m_szEULAUrl);
+	}
 
 	bool isDev = false;
 
@@ -647,6 +648,8 @@ void ItemInfo::processInfo(const XML::gcXMLElement &xmlEl)
 	auto devNode = xmlEl.FirstChildElement("developer");
 	if (devNode.IsValid())
 	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
 		devNode.GetChild("name", m_szDev);
 		devNode.GetChild("url", m_szDevProfile);
 	}
@@ -654,6 +657,8 @@ void ItemInfo::processInfo(const XML::gcXMLElement &xmlEl)
 	auto pubNode = xmlEl.FirstChildElement("publisher");
 	if (pubNode.IsValid())
 	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
 		pubNode.GetChild("name", m_szPublisher);
 		pubNode.GetChild("url", m_szPublisherProfile);
 	}
@@ -687,6 +692,7 @@ void ItemInfo::processSettings(uint32 platform, const XML::gcXMLElement &setNode
 	if (it == m_mBranchInstallInfo.end() && !isDownloadable())
 	{
 		//this item is not downloadable thus has no branches. Create a install info for it.
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 		m_mBranchInstallInfo[platform] = new BranchInstallInfo(platform, this, m_pFileSystem);
 		it = m_mBranchInstallInfo.find(platform);
 	}
@@ -720,6 +726,8 @@ void ItemInfo::processSettings(uint32 platform, const XML::gcXMLElement &setNode
 
 		if (HasAnyFlags(getStatus(), UserCore::Item::ItemInfoI::STATUS_LINK))
 		{
+			std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
 			if (m_vBranchList.size() == 0)
 				m_vBranchList.push_back(new UserCore::Item::BranchInfo(MCFBranch::BranchFromInt(0), getId(), it->second, 0, m_pUserCore->getUserId()));
 
@@ -735,7 +743,10 @@ void ItemInfo::processSettings(uint32 platform, const XML::gcXMLElement &setNode
 void ItemInfo::setIcon(const char* icon)
 {
 	if (!m_pFileSystem->isValidFile(m_szIcon))
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 		m_szIcon = "";
+	}
 
 	if (!icon)
 		return;
@@ -743,7 +754,11 @@ void ItemInfo::setIcon(const char* icon)
 	if (!m_pFileSystem->isValidFile(icon))
 		return;
 
-	m_szIcon = UTIL::FS::PathWithFile(icon).getFullPath();
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+		m_szIcon = UTIL::FS::PathWithFile(icon).getFullPath();
+	}
+
 	m_iChangedFlags |= ItemInfoI::CHANGED_ICON;
 	onInfoChange();
 }
@@ -751,7 +766,10 @@ void ItemInfo::setIcon(const char* icon)
 void ItemInfo::setLogo(const char* logo)
 {
 	if (!m_pFileSystem->isValidFile(m_szLogo))
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 		m_szLogo = "";
+	}
 
 	if (!logo)
 		return;
@@ -761,7 +779,11 @@ void ItemInfo::setLogo(const char* logo)
 	if (!m_pFileSystem->isValidFile(path))
 		return;
 
-	m_szLogo = path.getFullPath();
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+		m_szLogo = path.getFullPath();
+	}
+
 	m_iChangedFlags |= ItemInfoI::CHANGED_LOGO;
 	onInfoChange();
 }
@@ -774,7 +796,11 @@ void ItemInfo::setIconUrl(const char* url)
 	bool changed = (m_szIconUrl != url);
 
 	if (changed)
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 		m_szIconUrl = gcString(url);
+		markDirty();
+	}
 
 	if (m_szIconUrl != "" && (changed || !m_pFileSystem->isValidFile(m_szIcon)) && getUserCore()->getInternal())
 		getUserCore()->getInternal()->downloadImage(this, UserCore::Task::DownloadImgTask::ICON);
@@ -788,7 +814,11 @@ void ItemInfo::setLogoUrl(const char* url)
 	bool changed = (m_szLogoUrl != url);
 
 	if (changed)
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 		m_szLogoUrl = gcString(url);
+		markDirty();
+	}
 
 	if (m_szLogoUrl != "" && (changed || !m_pFileSystem->isValidFile(m_szLogo)) && getUserCore()->getInternal())
 		getUserCore()->getInternal()->downloadImage(this, UserCore::Task::DownloadImgTask::LOGO);
@@ -822,6 +852,8 @@ void ItemInfo::removeFromAccount()
 
 void ItemInfo::onInfoChange()
 {
+	markDirty();
+
 	if (!m_bPauseCallBack)
 		triggerCallBack();
 }
@@ -838,6 +870,15 @@ void ItemInfo::triggerCallBack()
 	m_iChangedFlags = 0;
 }
 
+void ItemInfo::onIndexChange(uint32 flags)
+{
+	if (!HasAnyFlags(flags, ItemIndex::getIndexedStatus()))
+		return;
+
+	DesuraId currentID = getId();
+	onIndexChangeEvent(currentID);
+}
+
 void ItemInfo::addSFlag(uint32 flags)
 {
 	if (HasAllFlags(m_iStatus, flags))
@@ -847,8 +888,13 @@ void ItemInfo::addSFlag(uint32 flags)
 
 	bool shouldTriggerUpdate = (m_iStatus&ItemInfoI::STATUS_DEVELOPER || HasAnyFlags(flags, (ItemInfoI::STATUS_INSTALLED|ItemInfoI::STATUS_ONCOMPUTER|ItemInfoI::STATUS_ONACCOUNT|ItemInfoI::STATUS_PAUSED|ItemInfoI::STATUS_UPDATEAVAL)));
 
-	m_iStatus |= flags;
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+		m_iStatus |= flags;
+	}
+
 	m_iChangedFlags |= ItemInfoI::CHANGED_STATUS;
+	onIndexChange(flags);
 
 	if (flags & ItemInfoI::STATUS_VERIFING)
 		delSFlag(ItemInfoI::STATUS_READY);
@@ -893,14 +939,19 @@ void ItemInfo::delSFlag(uint32 flags)
 
 	bool wasDeleted = isDeleted();
 
-	m_iStatus &= (~flags);
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 
-	if (flags & STATUS_PAUSABLE)
-		m_iStatus &= (~STATUS_PAUSED);
+		m_iStatus &= (~flags);
 
-	if (flags & STATUS_INSTALLED)
-		m_iStatus &= (~STATUS_READY);
+		if (flags & STATUS_PAUSABLE)
+			m_iStatus &= (~STATUS_PAUSED);
+
+		if (flags & STATUS_INSTALLED)
+			m_iStatus &= (~STATUS_READY);
+	}
 
+	onIndexChange(flags);
 	onInfoChange();
 	DesuraId currentID = getId();
 
@@ -946,7 +997,11 @@ void ItemInfo::setPercent(uint8 percent)
 	if (m_iPercent == percent)
 		return;
 
-	m_iPercent = std::min(std::max((int)percent,0),100);
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+		m_iPercent = std::min(std::max((int)percent,0),100);
+	}
+
 	m_iChangedFlags |= ItemInfoI::CHANGED_PERCENT;
 
 	onInfoChange();
@@ -1038,15 +1093,25 @@ void ItemInfo::processUpdateXml(const XML::gcXMLElement &node)
 			uint32 platformId = 100;
 			branch.GetAtt("platformid", platformId);
 
-			auto it = m_mBranchInstallInfo.find(platformId);
+			gcRefPtr<BranchInstallInfo> bii;
 
-			if (it == m_mBranchInstallInfo.end())
-				m_mBranchInstallInfo[platformId] = new BranchInstallInfo(platformId, this, m_pFileSystem);
+			{
+				std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
+				auto it = m_mBranchInstallInfo.find(platformId);
+
+				if (it == m_mBranchInstallInfo.end())
+					m_mBranchInstallInfo[platformId] = new BranchInstallInfo(platformId, this, m_pFileSystem);
+
+				bii = m_mBranchInstallInfo[platformId];
+			}
 
-			bi = gcRefPtr<BranchInfo>::create(MCFBranch::BranchFromInt(id), m_iId, m_mBranchInstallInfo[platformId], platformId, m_pUserCore->getUserId());
+			bi = gcRefPtr<BranchInfo>::create(MCFBranch::BranchFromInt(id), m_iId, bii, platformId, m_pUserCore->getUserId());
 			bi->loadXmlData(branch);
 
 			bi->onBranchInfoChangedEvent += delegate(this, &ItemInfo::onBranchInfoChanged);
+
+			std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 			m_vBranchList.push_back(bi);
 		}
 		else
@@ -1142,9 +1207,13 @@ void ItemInfo::resetInstalledMcf()
 	if (getCurrentBranchFull() && getCurrentBranchFull()->getInstallInfo())
 		getCurrentBranchFull()->getInstallInfo()->resetInstalledMcf();
 
-	m_LastBranch = MCFBranch();
-	m_INBranch = MCFBranch();
-	m_INBranchIndex = -1;
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
+		m_LastBranch = MCFBranch();
+		m_INBranch = MCFBranch();
+		m_INBranchIndex = -1;
+	}
 
 	onInfoChange();
 }
@@ -1157,10 +1226,16 @@ bool ItemInfo::setInstalledMcf(MCFBranch branch, MCFBuild build)
 		if (m_vBranchList[x]->getBranchId() == branch)
 		{
 			gcTrace("Changing Current Branch");
-			m_INBranchIndex = x;
 
-			m_LastBranch = m_INBranch;
-			m_INBranch = branch;
+			{
+				std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+
+				m_INBranchIndex = x;
+				m_LastBranch = m_INBranch;
+				m_INBranch = branch;
+			}
+
+			markDirty();
 
 			if (build == 0)
 				build = m_vBranchList[x]->getLatestBuild();
@@ -1231,22 +1306,18 @@ void ItemInfo::setParentId(DesuraId id)
 	if (id == m_iParentId)
 		return;
 
-	sqlite3x::sqlite3_connection db(getItemInfoDb(getUserCore()->getAppDataPath()).c_str());
-
-	try
 	{
-		sqlite3x::sqlite3_command cmd(db, "DELETE FROM iteminfo WHERE internalid=?;");
-		cmd.bind(1, (long long int)m_iId.toInt64());
-		cmd.executenonquery();
-
-		saveDbFull(&db);
-	}
-	catch (std::exception &e)
-	{
-		Warning("Failed to change {0} parent id: {1}\n", getName(), e.what());
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+		m_iParentId = id;
 	}
 
-	m_iParentId = id;
+	markDirty();
+
+	DesuraId currentID = getId();
+	onIndexChangeEvent(currentID);
+
+	//iteminfo rows are keyed on internalid so the write behind save replaces the old row
+	m_pUserCore->getItemManager()->saveItem(this);
 }
 
 void ItemInfo::migrateStandalone(MCFBranch branch, MCFBuild build)
@@ -1262,22 +1333,30 @@ void ItemInfo::setLinkInfo(const char* exe, const char* args)
 
 	UTIL::FS::Path path = UTIL::FS::PathWithFile(exe);
 
-	if (m_mBranchInstallInfo.size() == 0)
-		m_mBranchInstallInfo[BUILDID_PUBLIC] = new UserCore::Item::BranchInstallInfo(BUILDID_PUBLIC, this, m_pFileSystem);
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 
-	auto bii = m_mBranchInstallInfo[BUILDID_PUBLIC];
+		if (m_mBranchInstallInfo.size() == 0)
+			m_mBranchInstallInfo[BUILDID_PUBLIC] = new UserCore::Item::BranchInstallInfo(BUILDID_PUBLIC, this, m_pFileSystem);
 
-	if (m_vBranchList.size() == 0)
-		m_vBranchList.push_back(new UserCore::Item::BranchInfo(MCFBranch::BranchFromInt(0), getId(), bii, 0, m_pUserCore->getUserId()));
+		auto bii = m_mBranchInstallInfo[BUILDID_PUBLIC];
 
-	auto bi = m_vBranchList[0];
+		if (m_vBranchList.size() == 0)
+			m_vBranchList.push_back(new UserCore::Item::BranchInfo(MCFBranch::BranchFromInt(0), getId(), bii, 0, m_pUserCore->getUserId()));
 
-	bii->setLinkInfo(path.getFolderPath().c_str(), exe, args);
-	bi->setLinkInfo(getName());
+		bii->setLinkInfo(path.getFolderPath().c_str(), exe, args);
+		m_vBranchList[0]->setLinkInfo(getName());
+	}
 
 	setInstalledMcf(MCFBranch::BranchFromInt(0), MCFBuild::BuildFromInt(0));
 
-	m_iStatus = STATUS_LINK|STATUS_NONDOWNLOADABLE|STATUS_READY|STATUS_ONCOMPUTER|STATUS_INSTALLED;
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
+		m_iStatus = STATUS_LINK|STATUS_NONDOWNLOADABLE|STATUS_READY|STATUS_ONCOMPUTER|STATUS_INSTALLED;
+	}
+
+	markDirty();
+	onIndexChange(ItemIndex::getIndexedStatus());
 
 #ifdef WIN32
 	gcString savePathIco = UTIL::OS::getAppDataPath(gcWString(getId().getFolderPathExtension("icon.ico")).c_str());
@@ -1820,7 +1899,256 @@ namespace UnitTest
 		ASSERT_TRUE(!!i->getCurrentBranch());
 	}
 
+	TEST_F(ItemInfoThirdPartyFixture, DirtySaveOnlyWritesChanges)
+	{
+		sqlite3x::sqlite3_connection db(":memory:");
+
+		setUpDb(db, vSqlCommands);
+		i->loadDb(&db);
+
+		ItemDbStatements statements(db);
+
+		//on account flag is stripped on load so the row is stale until saved
+		ASSERT_TRUE(i->isDirty());
+		ASSERT_TRUE(i->saveDbDirty(statements));
+		ASSERT_FALSE(i->isDirty());
+		ASSERT_FALSE(i->saveDbDirty(statements));
+
+		std::vector<gcRefPtr<UserCore::Item::Misc::ExeInfoI>> vExeList;
+		i->getExeList(vExeList);
+		ASSERT_EQ(1u, vExeList.size());
+
+		vExeList[0]->setUserArgs("-windowed");
+
+		ASSERT_TRUE(i->isDirty());
+		ASSERT_TRUE(i->saveDbDirty(statements));
+		ASSERT_FALSE(i->isDirty());
+
+		sqlite3x::sqlite3_command cmd(db, "SELECT userargs FROM exe WHERE itemid=?;");
+		cmd.bind(1, (long long int)i->getId().toInt64());
+		ASSERT_EQ("-windowed", cmd.executestring());
+
+		i->setName("Charlie 2");
+
+		ASSERT_TRUE(i->isDirty());
+		ASSERT_TRUE(i->saveDbDirty(statements));
+
+		sqlite3x::sqlite3_command nameCmd(db, "SELECT name FROM iteminfo WHERE internalid=?;");
+		nameCmd.bind(1, (long long int)i->getId().toInt64());
+		ASSERT_EQ("Charlie 2", nameCmd.executestring());
+	}
+
+	TEST_F(ItemInfoThirdPartyFixture, DirtySaveLatency)
+	{
+		const uint32 nItems = 5000;
+		const uint32 nChanged = 50;
+
+		sqlite3x::sqlite3_connection db(":memory:");
+		createItemInfoDbTables(db);
+
+		std::vector<gcRefPtr<ItemInfo>> vItems;
+
+		for (uint32 x=0; x<nItems; x++)
+		{
+			auto item = gcRefPtr<ItemInfo>::create(user, DesuraId(x+1, DesuraId::TYPE_GAME), &fs);
+			item->setName(gcString("Item {0}", x).c_str());
+			vItems.push_back(item);
+		}
+
+		auto saveAll = [&](bool bFull) -> uint32
+		{
+			uint32 nSaved = 0;
+			sqlite3x::sqlite3_transaction trans(db);
+			ItemDbStatements statements(db);
+
+			for (auto item : vItems)
+			{
+				if (bFull)
+					item->saveDbFull(statements);
+				else if (!item->saveDbDirty(statements))
+					continue;
 
+				nSaved++;
+			}
+
+			trans.commit();
+			return nSaved;
+		};
+
+		ASSERT_EQ(nItems, saveAll(true));
+
+		for (uint32 x=0; x<nChanged; x++)
+			vItems[x * (nItems / nChanged)]->setName("Changed");
+
+		auto start = std::chrono::steady_clock::now();
+		ASSERT_EQ(nChanged, saveAll(false));
+		auto mid = std::chrono::steady_clock::now();
+		ASSERT_EQ(nItems, saveAll(true));
+		auto end = std::chrono::steady_clock::now();
+
+		ASSERT_EQ(0u, saveAll(false));
+
+		double dirtyMs = std::chrono::duration<double, std::milli>(mid - start).count();
+		double fullMs = std::chrono::duration<double, std::milli>(end - mid).count();
+
+		RecordProperty("dirty_save_ms", gcString("{0}", dirtyMs));
+		RecordProperty("full_save_ms", gcString("{0}", fullMs));
+	}
+
+	TEST_F(ItemInfoThirdPartyFixture, BulkLoadMatchesPerItemLoad)
+	{
+		sqlite3x::sqlite3_connection db(":memory:");
+		setUpDb(db, vSqlCommands);
+
+		std::vector<ItemDbRow> vRows;
+		ItemDbReader(db, 1).readAll(vRows);
+		ASSERT_EQ(1u, vRows.size());
+
+		auto bulk = gcRefPtr<ItemInfo>::create(user, vRows[0].id, vRows[0].parentId, &fs);
+		bulk->loadDb(vRows[0]);
+		i->loadDb(&db);
+
+		ASSERT_EQ(i->getId(), bulk->getId());
+		ASSERT_STREQ(i->getName(), bulk->getName());
+		ASSERT_EQ(i->getStatus(), bulk->getStatus());
+		ASSERT_EQ(i->getBranchCount(), bulk->getBranchCount());
+		ASSERT_EQ(i->isInstalled(), bulk->isInstalled());
+		ASSERT_EQ(i->isLaunchable(), bulk->isLaunchable());
+
+		std::vector<gcRefPtr<UserCore::Item::Misc::ExeInfoI>> vExpected, vActual;
+		i->getExeList(vExpected);
+		bulk->getExeList(vActual);
+
+		ASSERT_EQ(vExpected.size(), vActual.size());
+
+		for (size_t x=0; x<vExpected.size(); x++)
+			ASSERT_STREQ(vExpected[x]->getExe(), vActual[x]->getExe());
+	}
+
+	TEST_F(ItemInfoThirdPartyFixture, BulkLoadLatency)
+	{
+		const uint32 nItems = 5000;
+
+		sqlite3x::sqlite3_connection db(":memory:");
+		createItemInfoDbTables(db);
+
+		{
+			sqlite3x::sqlite3_transaction trans(db);
+
+			for (uint32 x=1; x<=nItems; x++)
+			{
+				auto id = DesuraId(x, DesuraId::TYPE_GAME).toInt64();
+
+				db.executenonquery(gcString("INSERT INTO iteminfo VALUES({0},0,0,8,'','dev','Item {1}','item{1}','','','','','','','','',{1},0);", id, x));
+				db.executenonquery(gcString("INSERT INTO installinfo VALUES({0},100,'games/{1}','games/{1}/run','',0,0,0);", id, x));
+				db.executenonquery(gcString("INSERT INTO exe VALUES({0},100,'Play','games/{1}/run','','',0);", id, x));
+				db.executenonquery(gcString("INSERT INTO branchinfo VALUES({1},{0},'Main',4,'','','','','',0,0,100);", id, x));
+			}
+
+			trans.commit();
+		}
+
+		std::vector<DesuraId> vIds;
+
+		{
+			sqlite3x::sqlite3_command cmd(db, "SELECT internalid FROM iteminfo;");
+			sqlite3x::sqlite3_reader reader = cmd.executereader();
+
+			while (reader.read())
+				vIds.push_back(DesuraId(reader.getint64(0)));
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (auto id : vIds)
+			gcRefPtr<ItemInfo>::create(user, id, &fs)->loadDb(&db);
+
+		auto mid = std::chrono::steady_clock::now();
+
+		std::vector<ItemDbRow> vRows;
+		ItemDbReader(db, 1).readAll(vRows);
+
+		for (auto &row : vRows)
+			gcRefPtr<ItemInfo>::create(user, row.id, row.parentId, &fs)->loadDb(row);
+
+		auto end = std::chrono::steady_clock::now();
+
+		ASSERT_EQ(nItems, vRows.size());
+		ASSERT_EQ(1u, vRows.back().branches.size());
+		ASSERT_EQ(1u, vRows.back().installInfo.size());
+		ASSERT_EQ(1u, vRows.back().installInfo[0].exes.size());
+
+		double perItemMs = std::chrono::duration<double, std::milli>(mid - start).count();
+		double bulkMs = std::chrono::duration<double, std::milli>(end - mid).count();
+
+		RecordProperty("per_item_load_ms", gcString("{0}", perItemMs));
+		RecordProperty("bulk_load_ms", gcString("{0}", bulkMs));
+	}
+
+	TEST_F(ItemInfoThirdPartyFixture, UpdateXmlFingerprintLatency)
+	{
+		const uint32 nItems = 2000;
+
+		gcString strXml("<games>");
+
+		for (uint32 x=0; x<nItems; x++)
+		{
+			strXml += gcString("<game siteareaid=\"{0}\"><branches>", x+1);
+
+			for (uint32 y=0; y<3; y++)
+				strXml += gcString("<branch id=\"{0}\" platformid=\"100\"><name>Branch {1}</name><mcf id=\"{2}\"><build>{1}</build></mcf></branch>", x*3+y+1, y, x*3+y+1000);
+
+			strXml += "</branches></game>";
+		}
+
+		strXml += "</games>";
+
+		XML::gcXMLDocument doc(strXml.c_str(), strXml.size());
+
+		std::vector<gcRefPtr<ItemInfo>> vItems;
+
+		for (uint32 x=0; x<nItems; x++)
+			vItems.push_back(gcRefPtr<ItemInfo>::create(user, DesuraId(x+1, DesuraId::TYPE_GAME), &fs));
+
+		ItemUpdateFingerprints fingerprints;
+
+		auto processAll = [&]()
+		{
+			uint32 x = 0;
+
+			doc.GetRoot("games").for_each_child("game", [&](const XML::gcXMLElement &game){
+				vItems[x]->processUpdateXml(game);
+				fingerprints.update(vItems[x], game.GetContentHash());
+				x++;
+			});
+		};
+
+		//first poll creates the branches, later polls just reapply the same xml
+		processAll();
+
+		auto start = std::chrono::steady_clock::now();
+		processAll();
+		auto mid = std::chrono::steady_clock::now();
+
+		uint32 nItem = 0;
+		uint32 nUnchanged = 0;
+
+		doc.GetRoot("games").for_each_child("game", [&](const XML::gcXMLElement &game){
+			if (fingerprints.isUnchanged(vItems[nItem++], game.GetContentHash()))
+				nUnchanged++;
+		});
+
+		auto end = std::chrono::steady_clock::now();
+
+		ASSERT_EQ(nItems, nUnchanged);
+		ASSERT_EQ(3u, vItems.back()->getBranchCount());
+
+		double processMs = std::chrono::duration<double, std::milli>(mid - start).count();
+		double hashMs = std::chrono::duration<double, std::milli>(end - mid).count();
+
+		RecordProperty("process_update_ms", gcString("{0}", processMs));
+		RecordProperty("fingerprint_update_ms", gcString("{0}", hashMs));
+	}
 }
 
 #endif
@@ -46,6 +46,9 @@ namespace UserCore
 	{
 		class BranchInfo;
 		class BranchInstallInfo;
+		class ItemDbRow;
+		class ItemDbSnapshot;
+		class ItemDbStatements;
 
 		class BranchItemInfoI : public gcRefBase
 		{
@@ -168,30 +171,58 @@ namespace UserCore
 			bool isFavorite() override;
 			void setFavorite(bool fav) override;
 
-			//! Removes this item from the db
+			//! Save all vars to db
 			//!
-			//! @param db Sqlite db connection
+			//! @param db Statements for the current save batch
 			//!
-			void deleteFromDb(sqlite3x::sqlite3_connection* db);
+			void saveDbFull(ItemDbStatements &db);
 
-			//! Save regular changed vars to db
+			//! Copies all vars into snapshot and clears the dirty flags. Takes the item lock,
+			//! the snapshot is written later with ItemDbWriter
 			//!
-			//! @param db Sqlite db connection
+			//! @param snapshot Out rows to write
+			//! @return False if there is nothing to write
 			//!
-			void saveDb(sqlite3x::sqlite3_connection* db);
+			bool saveDbFull(ItemDbSnapshot &snapshot);
 
-			//! Save all vars to db
+			//! Load vars from db
 			//!
 			//! @param db Sqlite db connection
 			//!
-			void saveDbFull(sqlite3x::sqlite3_connection* db);
+			void loadDb(sqlite3x::sqlite3_connection* db);
 
-			//! Load vars from db
+			//! Load vars from rows already read from the db, see ItemDbReader
 			//!
-			//! @param db Sqlite db connection
+			//! @param row Item row along with its branch and install info rows
 			//!
-			void loadDb(sqlite3x::sqlite3_connection* db);
+			void loadDb(const ItemDbRow &row);
+
+			//! Save only what changed since the last save or load. A dirty item is written in full,
+			//! otherwise just its dirty branches and install infos are
+			//!
+			//! @param db Statements for the current save batch
+			//! @return True if anything was written
+			//!
+			bool saveDbDirty(ItemDbStatements &db);
+
+			//! Same as saveDbDirty but only copies what changed into snapshot, see saveDbFull(ItemDbSnapshot&)
+			//!
+			//! @param snapshot Out rows to write
+			//! @return True if snapshot has anything to write
+			//!
+			bool saveDbDirty(ItemDbSnapshot &snapshot);
+
+			//! Flags this item to be written on the next save
+			//!
+			void markDirty();
 
+			//! Has this item or any of its branches changed since it was last saved or loaded
+			//!
+			bool isDirty();
+
+			//! Triggers when the status flags or parent the item manager indexes items on change
+			//!
+			Event<DesuraId>& getIndexChangeEvent();
 
 			//! Load data for this item from xml
 			//!
@@ -326,6 +357,14 @@ namespace UserCore
 			//!
 			void onInfoChange();
 
+			//! Event handler for changes to the keys the item manager indexes this item on
+			//!
+			Event<DesuraId> onIndexChangeEvent;
+
+			//! Triggers onIndexChangeEvent if flags include an indexed status flag
+			//!
+			void onIndexChange(uint32 flags);
+
 			//! Triggers the info changed event
 			//!
 			void triggerCallBack();
@@ -345,7 +384,8 @@ namespace UserCore
 			void launchExeHack();
 
 			void onBranchInfoChanged();
-			bool shouldSaveDb(sqlite3x::sqlite3_connection* db);
+			bool shouldSaveDb();
+			void clearDirty();
 
 			void loadBranchXmlData(const XML::gcXMLElement &branch);
 
@@ -357,6 +397,10 @@ namespace UserCore
 			bool m_bPauseCallBack = false;
 			bool m_bWasOnAccount = false;
 			bool m_bAddedToDb = false;
+			std::atomic<bool> m_bDirty = {true};
+
+			//guards what the saver thread copies out of this item against the setters
+			std::recursive_mutex m_ItemLock;
 
 			DesuraId m_iId;
 			DesuraId m_iParentId;
@@ -562,6 +606,11 @@ namespace UserCore
 			return onInfoChangeEvent;
 		}
 
+		inline Event<DesuraId>& ItemInfo::getIndexChangeEvent()
+		{
+			return onIndexChangeEvent;
+		}
+
 		/////////////////////////////////////////////
 
 		inline uint64 ItemInfo::getHash()
@@ -586,7 +635,9 @@ namespace UserCore
 
 		inline void ItemInfo::setName(const char* name)
 		{
+			std::lock_guard<std::recursive_mutex> guard(m_ItemLock);
 			m_szName = gcString(name);
+			markDirty();
 		}
 
 		inline gcRefPtr<UserCore::UserI> ItemInfo::getUserCore()
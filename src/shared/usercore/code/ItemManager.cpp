@@ -30,6 +30,8 @@ Contact us at legal@badjuju.com.
 #include "GameExplorerManager.h"
 #endif
 #include "ItemTaskGroup.h"
+#include "ItemSaveThread.h"
+#include "ItemDbReader.h"
 
 #include "sqlite3x.hpp"
 #include "sql/ItemInfoSql.h"
@@ -131,16 +133,28 @@ void ItemManager::cleanup()
 	{
 		m_Cleaned = true;
 
+		UserCore::Misc::ItemSaveThread* pSaveThread = nullptr;
+
+		{
+			std::lock_guard<std::mutex> guard(m_SaveThreadLock);
+			std::swap(pSaveThread, m_pSaveThread);
+		}
+
+		safe_delete(pSaveThread);
 		saveDbItems(true);
 
 		onUpdateEvent.reset();
 		onFavoriteUpdateEvent.reset();
 		onRecentUpdateEvent.reset();
 
+		m_ItemIndex.clear();
 		auto list = dumpAndClear();
 
 		for (const auto & i : list)
+		{
+			i->getItemInfoNorm()->getIndexChangeEvent() -= delegate(this, &ItemManager::onItemIndexChange);
 			i->cleanup();
+		}
 
 		safe_delete(list);
 	}
@@ -393,41 +407,30 @@ void ItemManager::getAllItems(std::vector<gcRefPtr<UserCore::Item::ItemInfoI>> &
 
 void ItemManager::getGameList(std::vector<gcRefPtr<UserCore::Item::ItemInfoI>> &gList, bool includeDeleted)
 {
-	itemIterator it;
-	itemIterator endit = m_mItemMap.end();
+	//If this is Diablo 2 (50) and we have LOD (13824) install, dont return d2
+	bool hasLod = m_mItemMap.find(DesuraId("13824", "games").toInt64()) != m_mItemMap.end();
 
-	for (it = m_mItemMap.begin(); it != endit; ++it)
+	m_ItemIndex.forEachOfType(DesuraId::TYPE_GAME, [&gList, includeDeleted, hasLod](const gcRefPtr<UserCore::Item::ItemInfo> &info)
 	{
-		auto info = it->second->getItemInfoNorm();
-
-		if (!info)
-			continue;
-
-		if (info->getId().getType() != DesuraId::TYPE_GAME)
-			continue;
-
 		if (!includeDeleted && (info->getStatus() & UM::ItemInfoI::STATUS_DELETED))
-			continue;
+			return;
 
 		if (HasAnyFlags(info->getStatus(), UM::ItemInfoI::STATUS_STUB))
-			continue;
+			return;
 
-		//If this is Diablo 2 (50) and we have LOD (13824) install, dont return d2
-		if (info->getId().getItem() == 50 && m_mItemMap.find(DesuraId("13824", "games").toInt64()) != m_mItemMap.end())
-			continue;
+		if (hasLod && info->getId().getItem() == 50)
+			return;
 
-		gList.push_back(info);
-	}
+		gList.push_back(info.get());
+	});
 
 }
 
 void ItemManager::getModList(DesuraId gameId, std::vector<gcRefPtr<UserCore::Item::ItemInfoI>> &mList, bool includeDeleted)
 {
-	for_each([&mList, includeDeleted, gameId](const gcRefPtr<UserCore::Item::ItemHandle> &handle)
+	m_ItemIndex.forEachWithParent(gameId, [&mList, includeDeleted](const gcRefPtr<UserCore::Item::ItemInfo> &info)
 	{
-		auto& info = handle->getItemInfo();
-
-		if (info->getId().getType() != DesuraId::TYPE_MOD || info->getParentId() != gameId)
+		if (info->getId().getType() != DesuraId::TYPE_MOD)
 			return;
 
 		if (!includeDeleted && (info->getStatus() & UM::ItemInfoI::STATUS_DELETED))
@@ -436,7 +439,7 @@ void ItemManager::getModList(DesuraId gameId, std::vector<gcRefPtr<UserCore::Ite
 		if (HasAnyFlags(info->getStatus(), UM::ItemInfoI::STATUS_STUB))
 			return;
 
-		mList.push_back(info);
+		mList.push_back(info.get());
 	});
 
 	//if this is lod (13824) show d2 mods as well
@@ -446,45 +449,40 @@ void ItemManager::getModList(DesuraId gameId, std::vector<gcRefPtr<UserCore::Ite
 
 void ItemManager::getDevList(std::vector<gcRefPtr<UserCore::Item::ItemInfoI>> &dList)
 {
-	itemIterator it;
-	itemIterator endit = m_mItemMap.end();
-
-	for (it = m_mItemMap.begin(); it != endit; ++it)
+	m_ItemIndex.forEachWithStatus(UM::ItemInfoI::STATUS_DEVELOPER, [&dList](const gcRefPtr<UserCore::Item::ItemInfo> &info)
 	{
-		auto info = it->second->getItemInfoNorm();
-
-		if (!info)
-			continue;
-
 		if (info->getId().getType() == DesuraId::TYPE_TOOL)
-			continue;
+			return;
 
-		if (info->getStatus() & (UM::ItemInfoI::STATUS_DEVELOPER) && !(info->getStatus() & (UM::ItemInfoI::STATUS_DELETED)))
-			dList.push_back(info);
-	}
+		if (!(info->getStatus() & (UM::ItemInfoI::STATUS_DELETED)))
+			dList.push_back(info.get());
+	});
 }
 
 
 void ItemManager::getLinkList(std::vector<gcRefPtr<UserCore::Item::ItemInfoI>> &lList)
 {
-	itemIterator it;
-	itemIterator endit = m_mItemMap.end();
-
-	for (it = m_mItemMap.begin(); it != endit; ++it)
+	m_ItemIndex.forEachOfType(DesuraId::TYPE_LINK, [&lList](const gcRefPtr<UserCore::Item::ItemInfo> &info)
 	{
-		auto info = it->second->getItemInfoNorm();
+		if (info->getStatus() & UM::ItemInfoI::STATUS_DELETED)
+			return;
 
-		if (!info)
-			continue;
+		lList.push_back(info.get());
+	});
+}
 
-		if (info->getId().getType() != DesuraId::TYPE_LINK)
-			continue;
+void ItemManager::indexItem(const gcRefPtr<UserCore::Item::ItemInfo> &info)
+{
+	if (!info)
+		return;
 
-		if (info->getStatus() & UM::ItemInfoI::STATUS_DELETED)
-			continue;
+	info->getIndexChangeEvent() += delegate(this, &ItemManager::onItemIndexChange);
+	m_ItemIndex.add(info);
+}
 
-		lList.push_back(info);
-	}
+void ItemManager::onItemIndexChange(DesuraId &id)
+{
+	m_ItemIndex.add(findItemInfoNorm(id));
 }
 
 
@@ -526,11 +524,11 @@ void ItemManager::loadFavList()
 	m_FavLock.lock();
 
 	m_vFavList.clear();
-	sqlite3x::sqlite3_connection db(getItemInfoDb(m_szAppPath.c_str()).c_str());
+	sqlite3x::sqlite3_pooled_connection db(getItemInfoDb(m_szAppPath.c_str()));
 
 	try
 	{
-		sqlite3x::sqlite3_command cmd(db, "SELECT internalid FROM favorite WHERE userid=?;");
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT internalid FROM favorite WHERE userid=?;");
 		cmd.bind(1, (int)m_pUser->getUserId());
 
 		sqlite3x::sqlite3_reader reader = cmd.executereader();
@@ -547,11 +545,11 @@ void ItemManager::loadFavList()
 
 void ItemManager::getRecentList(std::vector<gcRefPtr<UserCore::Item::ItemInfoI>> &rList)
 {
-	sqlite3x::sqlite3_connection db(getItemInfoDb(m_szAppPath.c_str()).c_str());
+	sqlite3x::sqlite3_pooled_connection db(getItemInfoDb(m_szAppPath.c_str()));
 
 	try
 	{
-		sqlite3x::sqlite3_command cmd(db, "SELECT internalid FROM recent WHERE userid=? ORDER BY time DESC;");
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT internalid FROM recent WHERE userid=? ORDER BY time DESC;");
 		cmd.bind(1, (int)m_pUser->getUserId());
 
 		sqlite3x::sqlite3_reader reader = cmd.executereader();
@@ -572,11 +570,11 @@ void ItemManager::getRecentList(std::vector<gcRefPtr<UserCore::Item::ItemInfoI>>
 
 void ItemManager::getNewItems(std::vector<gcRefPtr<UserCore::Item::ItemInfoI>> &rList)
 {
-	sqlite3x::sqlite3_connection db(getItemInfoDb(m_szAppPath.c_str()).c_str());
+	sqlite3x::sqlite3_pooled_connection db(getItemInfoDb(m_szAppPath.c_str()));
 
 	try
 	{
-		sqlite3x::sqlite3_command cmd(db, "SELECT internalid FROM newItems WHERE userid=? AND time > datetime('now', '-5 day');");
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT internalid FROM newItems WHERE userid=? AND time > datetime('now', '-5 day');");
 		cmd.bind(1, (int)m_pUser->getUserId());
 
 		sqlite3x::sqlite3_reader reader = cmd.executereader();
@@ -808,9 +806,9 @@ void ItemManager::loadDbItems()
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
 
-		sqlite3x::sqlite3_command cmd(db, "SELECT count(*) FROM newItems WHERE userid=?;");
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT count(*) FROM newItems WHERE userid=?;");
 		cmd.bind(1, (int)m_pUser->getUserId());
 
 		m_bFirstLogin = (cmd.executeint() == 0);
@@ -822,26 +820,38 @@ void ItemManager::loadDbItems()
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
 
 		if (db.executeint("select count(*) from sqlite_master where name='iteminfo';") != 0)
 		{
 			uint32 count = 0;
 
-			sqlite3x::sqlite3_command cmd(db, "SELECT internalid, parentid FROM iteminfo;");
-			sqlite3x::sqlite3_reader reader = cmd.executereader();
+			bool bPreloaded = false;
+			std::vector<UserCore::Item::ItemDbRow> vRows;
 
-			while(reader.read())
 			{
-				DesuraId id(reader.getint64(0));
-				DesuraId pid(reader.getint64(1));
+				std::lock_guard<std::mutex> guard(m_PreloadLock);
+				std::swap(bPreloaded, m_bPreloaded);
+				vRows.swap(m_vPreloadedRows);
+			}
 
-				auto temp = gcRefPtr<UserCore::Item::ItemInfo>::create(m_pUser, id, pid);
-				temp->loadDb(&db); //UM::ItemInfoI::STATUS_ONCOMPUTER
+			UserCore::Item::ItemDbReader reader(db.connection(), m_pUser->getUserId());
+
+			//one query per table instead of a handful per item and branch
+			if (bPreloaded)
+				reader.readCdKeys(vRows);
+			else
+				reader.readAll(vRows);
+
+			for (auto &row : vRows)
+			{
+				auto temp = gcRefPtr<UserCore::Item::ItemInfo>::create(m_pUser, row.id, row.parentId);
+				temp->loadDb(row); //UM::ItemInfoI::STATUS_ONCOMPUTER
 
 				auto handle = gcRefPtr<UserCore::Item::ItemHandle>::create(temp, m_pUser);
 
-				addItem(id.toInt64(), handle);
+				addItem(row.id.toInt64(), handle);
+				indexItem(temp);
 				count++;
 			}
 
@@ -858,35 +868,118 @@ void ItemManager::loadDbItems()
 	loadFavList();
 }
 
+void ItemManager::preloadItems(const std::function<bool()> &fnCancelled)
+{
+	auto isCancelled = [&fnCancelled]()
+	{
+		return fnCancelled && fnCancelled();
+	};
+
+	if (isCancelled())
+		return;
+
+	gcString szItemDb = getItemInfoDb(m_szAppPath.c_str());
+	std::vector<UserCore::Item::ItemDbRow> vRows;
+
+	try
+	{
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
+
+		if (db.executeint("select count(*) from sqlite_master where name='iteminfo';") == 0)
+			return;
+
+		//cd keys belong to a user so they get read once login says who that is
+		UserCore::Item::ItemDbReader(db.connection(), 0).readAll(vRows);
+	}
+	catch (std::exception &e)
+	{
+		Warning("Failed to preload items from db: {0}\n", e.what());
+		return;
+	}
+
+	if (isCancelled())
+		return;
+
+	std::lock_guard<std::mutex> guard(m_PreloadLock);
+	m_vPreloadedRows.swap(vRows);
+	m_bPreloaded = true;
+}
+
 void ItemManager::saveItems()
 {
 	if (!m_bEnableSave)
 		return;
 
-	saveDbItems(false);
+	requestSave();
+}
+
+void ItemManager::requestSave()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_SaveThreadLock);
+
+		if (m_pSaveThread)
+		{
+			m_pSaveThread->requestSave();
+			return;
+		}
+	}
+
+	saveDbItems();
 }
 
 void ItemManager::saveDbItems(bool fullSave)
 {
 	gcString szItemDb = getItemInfoDb(m_szAppPath.c_str());
 
+	std::lock_guard<std::mutex> guard(m_SaveLock);
+	std::vector<gcRefPtr<UserCore::Item::ItemInfo>> vSaved;
+	std::vector<UserCore::Item::ItemDbSnapshot> vSnapshots;
+
+	//copied out under each item's lock so the writes below never read a live item
+	for_each([&vSaved, &vSnapshots, fullSave](const gcRefPtr<UserCore::Item::ItemHandle> &handle){
+
+		if (!handle || !handle->getItemInfoNorm())
+			return;
+
+		auto info = handle->getItemInfoNorm();
+
+		if (!fullSave && !info->isDirty())
+			return;
+
+		UserCore::Item::ItemDbSnapshot snapshot;
+
+		if (fullSave ? !info->saveDbFull(snapshot) : !info->saveDbDirty(snapshot))
+			return;
+
+		vSaved.push_back(info);
+		vSnapshots.push_back(std::move(snapshot));
+	});
+
+	if (vSnapshots.empty())
+		return;
+
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
 		sqlite3x::sqlite3_transaction trans(db);
 
-		for_each([&db](const gcRefPtr<UserCore::Item::ItemHandle> &handle){
-
-			if (handle && handle->getItemInfoNorm())
-				handle->getItemInfoNorm()->saveDbFull(&db);
+		//statements are prepared once and reused for every row in the batch
+		UserCore::Item::ItemDbStatements statements(db);
+		UserCore::Item::ItemDbWriter writer(statements);
 
-		});
+		for (auto &snapshot : vSnapshots)
+			writer.write(snapshot);
 
 		trans.commit();
 	}
 	catch (std::exception &e)
 	{
 		Warning("Failed to save items to db: {0}\n", e.what());
+
+		//rolled back, try them again next save
+		for (auto info : vSaved)
+			info->markDirty();
 	}
 }
 
@@ -951,6 +1044,8 @@ void ItemManager::parseItemUpdateXml(const char* area, const XML::gcXMLElement &
 			return;
 		}
 
+		uint64 xmlHash = itemNode.GetContentHash();
+
 		if (item->isDeleted())
 		{
 			DesuraId currentID = item->getId();
@@ -959,9 +1054,15 @@ void ItemManager::parseItemUpdateXml(const char* area, const XML::gcXMLElement &
 			item->addSFlag(UserCore::Item::ItemInfoI::STATUS_ONACCOUNT);
 			onNewItem(currentID);
 		}
+		else if (m_UpdateFingerprints.isUnchanged(item, xmlHash))
+		{
+			return;
+		}
 
 		item->processUpdateXml(itemNode);
 		m_pUser->getToolManager()->findJSTools(item);
+
+		m_UpdateFingerprints.update(item, xmlHash);
 	});
 }
 
@@ -1024,6 +1125,7 @@ gcRefPtr<UserCore::Item::ItemInfo> ItemManager::createNewItem(DesuraId pid, Desu
 		m_pUser->getToolManager()->findJSTools(temp);
 
 		addItem(id.toInt64(), handle);
+		indexItem(temp);
 
 		if (!temp->isDeleted())
 			onNewItem(id);
@@ -1271,7 +1373,7 @@ void ItemManager::parseModXml(gcRefPtr<UserCore::Item::ItemInfo> parent, DesuraI
 void ItemManager::setFavorite(DesuraId id, bool fav)
 {
 	gcTrace("ItemId {0}, Fav {1}", id, fav);
-	sqlite3x::sqlite3_connection db(getItemInfoDb(m_szAppPath.c_str()).c_str());
+	sqlite3x::sqlite3_pooled_connection db(getItemInfoDb(m_szAppPath.c_str()));
 
 	try
 	{
@@ -1282,7 +1384,7 @@ void ItemManager::setFavorite(DesuraId id, bool fav)
 		else
 			szCmd = gcString("DELETE FROM favorite WHERE internalid=? AND userid=?;");
 
-		sqlite3x::sqlite3_command cmd(db, szCmd.c_str());
+		sqlite3x::sqlite3_command &cmd = db.command(szCmd.c_str());
 		cmd.bind(1, (long long int)id.toInt64());
 		cmd.bind(2, (int)m_pUser->getUserId());
 
@@ -1317,7 +1419,7 @@ void ItemManager::setFavorite(DesuraId id, bool fav)
 
 void ItemManager::setNew(DesuraId &id)
 {
-	sqlite3x::sqlite3_connection db(getItemInfoDb(m_szAppPath.c_str()).c_str());
+	sqlite3x::sqlite3_pooled_connection db(getItemInfoDb(m_szAppPath.c_str()));
 
 	try
 	{
@@ -1326,7 +1428,7 @@ void ItemManager::setNew(DesuraId &id)
 		if (m_bFirstLogin)
 			cmdSql = "INSERT INTO newItems VALUES (?,?, datetime('now', '-10 day'));";
 
-		sqlite3x::sqlite3_command cmd(db, cmdSql);
+		sqlite3x::sqlite3_command &cmd = db.command(cmdSql);
 		cmd.bind(1, (long long int)id.toInt64());
 		cmd.bind(2, (int)m_pUser->getUserId());
 		cmd.executenonquery();
@@ -1338,29 +1440,29 @@ void ItemManager::setNew(DesuraId &id)
 
 void ItemManager::setRecent(DesuraId id)
 {
-	sqlite3x::sqlite3_connection db(getItemInfoDb(m_szAppPath.c_str()).c_str());
+	sqlite3x::sqlite3_pooled_connection db(getItemInfoDb(m_szAppPath.c_str()));
 
 	try
 	{
-		sqlite3x::sqlite3_command cmd(db, "SELECT count(*) FROM recent WHERE internalid=? AND userid=? ;");
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT count(*) FROM recent WHERE internalid=? AND userid=? ;");
 		cmd.bind(1, (long long int)id.toInt64());
 		cmd.bind(2, (int)m_pUser->getUserId());
 
 		if (cmd.executeint() == 1)
 		{
-			sqlite3x::sqlite3_command cmd(db, "UPDATE recent SET time=datetime('now') WHERE internalid=? AND userid=? ;");
+			sqlite3x::sqlite3_command &cmd = db.command("UPDATE recent SET time=datetime('now') WHERE internalid=? AND userid=? ;");
 			cmd.bind(1, (long long int)id.toInt64());
 			cmd.bind(2, (int)m_pUser->getUserId());
 			cmd.executenonquery();
 		}
 		else
 		{
-			sqlite3x::sqlite3_command cmd(db, "SELECT count(*) FROM recent WHERE userid=?;");
+			sqlite3x::sqlite3_command &cmd = db.command("SELECT count(*) FROM recent WHERE userid=?;");
 			cmd.bind(1, (int)m_pUser->getUserId());
 
 			if (cmd.executeint() >= 5)
 			{
-				sqlite3x::sqlite3_command cmd(db, "SELECT internalid, time FROM recent WHERE userid=? ORDER BY time ACS LIMIT 1;");
+				sqlite3x::sqlite3_command &cmd = db.command("SELECT internalid, time FROM recent WHERE userid=? ORDER BY time ACS LIMIT 1;");
 				cmd.bind(1, (int)m_pUser->getUserId());
 
 				sqlite3x::sqlite3_reader reader = cmd.executereader();
@@ -1370,7 +1472,7 @@ void ItemManager::setRecent(DesuraId id)
 				std::string time = reader.getstring(1);
 
 				{
-					sqlite3x::sqlite3_command cmd(db, "DELETE FROM recent WHERE internalid=? AND userid=? AND time=?;");
+					sqlite3x::sqlite3_command &cmd = db.command("DELETE FROM recent WHERE internalid=? AND userid=? AND time=?;");
 					cmd.bind(1, (long long int)id.toInt64());
 					cmd.bind(2, (int)m_pUser->getUserId());
 					cmd.bind(3, time);
@@ -1379,7 +1481,7 @@ void ItemManager::setRecent(DesuraId id)
 			}
 
 			{
-				sqlite3x::sqlite3_command cmd(db, "INSERT INTO recent VALUES (?,?, datetime('now'));");
+				sqlite3x::sqlite3_command &cmd = db.command("INSERT INTO recent VALUES (?,?, datetime('now'));");
 				cmd.bind(1, (long long int)id.toInt64());
 				cmd.bind(2, (int)m_pUser->getUserId());
 				cmd.executenonquery();
@@ -1516,6 +1618,7 @@ DesuraId ItemManager::addLink(const char* name, const char* exe, const char* arg
 	info->setLinkInfo(exe, args);
 
 	addItem(id.toInt64(), handle);
+	indexItem(info);
 	onNewItem(id);
 
 	uint32 count = 1;
@@ -1536,7 +1639,10 @@ void ItemManager::updateLink(DesuraId id, const char* args)
 	info->getExeList(list);
 
 	if (list.size() == 1)
+	{
 		list[0]->setUserArgs(args);
+		saveItem(info);
+	}
 }
 
 
@@ -1659,16 +1765,8 @@ void ItemManager::saveItem(gcRefPtr<UserCore::Item::ItemInfoI> pItem)
 
 	VERIFY_OR_RETURN(pItemNorm, );
 
-	try
-	{
-		gcString szItemDb = getItemInfoDb(m_szAppPath.c_str());
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
-		pItemNorm->saveDbFull(&db);
-	}
-	catch (std::exception &e)
-	{
-		Warning("Failed to save item to db: {0}\n", e.what());
-	}
+	pItemNorm->markDirty();
+	requestSave();
 }
 
 void ItemManager::enableSave()
@@ -1677,6 +1775,17 @@ void ItemManager::enableSave()
 		return;
 
 	m_bEnableSave = true;
+
+	{
+		std::lock_guard<std::mutex> guard(m_SaveThreadLock);
+
+		m_pSaveThread = new UserCore::Misc::ItemSaveThread([this](){
+			saveDbItems();
+		});
+
+		m_pSaveThread->start();
+	}
+
 	saveItems();
 }
 
@@ -32,6 +32,9 @@ Contact us at legal@badjuju.com.
 
 #include "ItemInfo.h"
 #include "ItemHandle.h"
+#include "ItemIndex.h"
+#include "ItemUpdateFingerprints.h"
+#include "ItemDbReader.h"
 
 namespace XML
 {
@@ -48,6 +51,11 @@ namespace UserCore
 		class ItemTaskGroup;
 	}
 
+	namespace Misc
+	{
+		class ItemSaveThread;
+	}
+
 	class ItemManager : public ItemManagerI, public BaseManager<UserCore::Item::ItemHandle>
 	{
 	public:
@@ -108,6 +116,13 @@ namespace UserCore
 		void enableSave();
 		gcRefPtr<UserCore::Item::ItemTaskGroup> newTaskGroup(uint32 type);
 
+		//! Reads the item db before the user is known so it can overlap login. The next
+		//! loadItems builds the items from these rows instead of reading the db again
+		//!
+		//! @param fnCancelled Checked before and after the read, the rows are dropped once it returns true
+		//!
+		void preloadItems(const std::function<bool()> &fnCancelled = std::function<bool()>());
+
 		DesuraId addLink(const char* name, const char* exe, const char* args) override;
 		void updateLink(DesuraId id, const char* args) override;
 
@@ -154,7 +169,16 @@ namespace UserCore
 
 
 		void loadDbItems();
+
+		//! Writes items to the db in one transaction
+		//!
+		//! @param fullSave Write every item instead of just the ones that changed since the last save
+		//!
 		void saveDbItems(bool fullSave = false);
+
+		//! Queues a write behind save of the changed items
+		//!
+		void requestSave();
 		void updateItemIds();
 
 		friend class User;
@@ -176,6 +200,11 @@ namespace UserCore
 		void onNewItem(DesuraId id);
 		bool isDelayLoading();
 
+		//! Adds an item to the list indexes and keeps it there as its status or parent change
+		//!
+		void indexItem(const gcRefPtr<UserCore::Item::ItemInfo> &info);
+		void onItemIndexChange(DesuraId &id);
+
 		void loadFavList();
 
 	private:
@@ -193,6 +222,20 @@ namespace UserCore
 		std::mutex m_FavLock;
 		std::vector<DesuraId> m_vFavList;
 
+		std::mutex m_SaveLock;
+
+		std::mutex m_SaveThreadLock;
+		UserCore::Misc::ItemSaveThread* m_pSaveThread = nullptr;
+
+		UserCore::Item::ItemIndex m_ItemIndex;
+
+		//! Only used from the update poll
+		UserCore::Item::ItemUpdateFingerprints m_UpdateFingerprints;
+
+		std::mutex m_PreloadLock;
+		bool m_bPreloaded = false;
+		std::vector<UserCore::Item::ItemDbRow> m_vPreloadedRows;
+
 		bool m_Cleaned;
 	};
 
@@ -0,0 +1,66 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "ItemSaveThread.h"
+
+using namespace UserCore::Misc;
+
+
+ItemSaveThread::ItemSaveThread(const std::function<void()> &fnSave, uint32 nDelayMs)
+	: ::Thread::BaseThread("Item Save Thread")
+	, m_fnSave(fnSave)
+	, m_nDelayMs(nDelayMs)
+{
+}
+
+ItemSaveThread::~ItemSaveThread()
+{
+	stop();
+}
+
+void ItemSaveThread::requestSave()
+{
+	m_bPending = true;
+	m_RequestWait.notify();
+}
+
+void ItemSaveThread::run()
+{
+	while (!isStopped())
+	{
+		m_RequestWait.wait();
+
+		if (isStopped())
+			break;
+
+		//let the rest of a burst of changes land so they share the transaction
+		m_DelayWait.wait(m_nDelayMs / 1000, m_nDelayMs % 1000);
+
+		if (m_bPending.exchange(false))
+			m_fnSave();
+	}
+}
+
+void ItemSaveThread::onStop()
+{
+	m_RequestWait.notify();
+	m_DelayWait.notify();
+}
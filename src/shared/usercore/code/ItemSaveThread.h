@@ -0,0 +1,68 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_ITEMSAVETHREAD_H
+#define DESURA_ITEMSAVETHREAD_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "util_thread/BaseThread.h"
+#include <atomic>
+
+namespace UserCore
+{
+	namespace Misc
+	{
+		//! Write behind saver for the item db. Save requests from any thread are coalesced
+		//! so a burst of item changes ends up as one transaction off the calling thread
+		//!
+		class ItemSaveThread : public ::Thread::BaseThread
+		{
+		public:
+			//! Constructor
+			//!
+			//! @param fnSave Does the actual save, called on this thread
+			//! @param nDelayMs How long to wait for more changes before saving
+			//!
+			ItemSaveThread(const std::function<void()> &fnSave, uint32 nDelayMs = 500);
+			~ItemSaveThread();
+
+			//! Requests a save. Returns straight away
+			//!
+			void requestSave();
+
+		protected:
+			void run() override;
+			void onStop() override;
+
+		private:
+			std::function<void()> m_fnSave;
+			const uint32 m_nDelayMs;
+
+			std::atomic<bool> m_bPending = {false};
+
+			::Thread::WaitCondition m_RequestWait;
+			::Thread::WaitCondition m_DelayWait;
+		};
+	}
+}
+
+#endif //DESURA_ITEMSAVETHREAD_H
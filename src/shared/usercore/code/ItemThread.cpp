@@ -29,6 +29,7 @@ Contact us at legal@badjuju.com.
 #include "usercore/UserCoreI.h"
 
 #include "UserThreadManager.h"
+#include "util/UtilTimeline.h"
 
 using namespace UserCore::Item;
 
@@ -164,7 +165,11 @@ bool ItemThread::performTask()
 		onTaskStartEvent(taskType);
 
 		gcTrace("Task {0}", task->getTaskName());
-		task->doTask();
+
+		{
+			UTIL::TIMELINE::ScopedSpan span("item", task->getTaskName(), "{0}", m_szBaseName);
+			task->doTask();
+		}
 
 		onTaskCompleteEvent(taskType);
 		m_bRunningTask = false;
@@ -0,0 +1,191 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "ItemUpdateFingerprints.h"
+#include "ItemInfo.h"
+
+using namespace UserCore::Item;
+
+
+bool ItemUpdateFingerprints::isUnchanged(const gcRefPtr<ItemInfo> &item, uint64 xmlHash) const
+{
+	auto it = m_mFingerprints.find(item->getId().toInt64());
+	return it != m_mFingerprints.end() && it->second == getFingerprint(item, xmlHash);
+}
+
+void ItemUpdateFingerprints::update(const gcRefPtr<ItemInfo> &item, uint64 xmlHash)
+{
+	m_mFingerprints[item->getId().toInt64()] = getFingerprint(item, xmlHash);
+}
+
+void ItemUpdateFingerprints::clear()
+{
+	m_mFingerprints.clear();
+}
+
+uint64 ItemUpdateFingerprints::getFingerprint(const gcRefPtr<ItemInfo> &item, uint64 xmlHash)
+{
+	//the same update xml can mean something else once the item is installed, changes branch or
+	//changes status so mix in the local state it gets applied against
+	uint64 hash = xmlHash;
+
+	auto mix = [&hash](uint64 value)
+	{
+		hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+	};
+
+	mix(item->getStatus());
+	mix((uint32)item->getInstalledBranch());
+	mix((uint32)item->getInstalledBuild());
+
+	return hash;
+}
+
+
+
+#ifdef LINK_WITH_GTEST
+
+namespace UnitTest
+{
+	using namespace ::testing;
+
+	class ItemUpdateFingerprintsFixture : public ::testing::Test
+	{
+	public:
+		ItemUpdateFingerprintsFixture()
+			: user(gcRefPtr<UserCore::UserMock>::create())
+			, m_ItemManager(gcRefPtr<UserCore::ItemManagerMock>::create())
+		{
+			ON_CALL(*user, getUserId()).WillByDefault(Return(1));
+			ON_CALL(*user, getItemsAddedEvent()).WillByDefault(ReturnRef(m_ItemAddedEvent));
+			ON_CALL(*user, getItemManager()).WillByDefault(Return(gcRefPtr<UserCore::ItemManagerI>(m_ItemManager)));
+
+			ON_CALL(*m_ItemManager, getOnNewItemEvent()).WillByDefault(ReturnRef(m_NewItemEvent));
+
+			for (uint32 x=0; x<3; x++)
+				m_vItems.push_back(gcRefPtr<ItemInfo>::create(user, DesuraId(x+1, DesuraId::TYPE_GAME), &fs));
+		}
+
+		static gcString getUpdateXml(uint32 nBuild)
+		{
+			gcString strXml("<games>");
+
+			for (uint32 x=0; x<3; x++)
+			{
+				strXml += gcString("<game siteareaid=\"{0}\"><branches>", x+1);
+
+				for (uint32 y=0; y<3; y++)
+					strXml += gcString("<branch id=\"{0}\" platformid=\"100\"><name>Branch {1}</name><mcf id=\"{2}\"><build>{3}</build></mcf></branch>", x*3+y+1, y, x*3+y+1000, nBuild);
+
+				strXml += "</branches></game>";
+			}
+
+			strXml += "</games>";
+			return strXml;
+		}
+
+		//! Same skip check ItemManager::parseItemUpdateXml does, returns how many items had their xml applied
+		uint32 poll(const gcString &strXml)
+		{
+			XML::gcXMLDocument doc(strXml.c_str(), strXml.size());
+
+			uint32 x = 0;
+			uint32 nProcessed = 0;
+
+			doc.GetRoot("games").for_each_child("game", [&](const XML::gcXMLElement &game){
+				auto item = m_vItems[x++];
+				uint64 xmlHash = game.GetContentHash();
+
+				if (m_Fingerprints.isUnchanged(item, xmlHash))
+					return;
+
+				item->processUpdateXml(game);
+				m_Fingerprints.update(item, xmlHash);
+				nProcessed++;
+			});
+
+			return nProcessed;
+		}
+
+		Event<DesuraId> m_NewItemEvent;
+		Event<uint32> m_ItemAddedEvent;
+
+		gcRefPtr<UserCore::UserMock> user;
+		UTIL::FS::UtilFSMock fs;
+		gcRefPtr<UserCore::ItemManagerMock> m_ItemManager;
+
+		std::vector<gcRefPtr<ItemInfo>> m_vItems;
+		ItemUpdateFingerprints m_Fingerprints;
+	};
+
+	TEST_F(ItemUpdateFingerprintsFixture, UnchangedItemsAreSkipped)
+	{
+		auto strXml = getUpdateXml(1);
+
+		ASSERT_EQ(3u, poll(strXml));
+		ASSERT_EQ(3u, m_vItems[0]->getBranchCount());
+
+		ASSERT_EQ(0u, poll(strXml));
+		ASSERT_EQ(0u, poll(strXml));
+
+		//new builds on the server change the xml of every item
+		ASSERT_EQ(3u, poll(getUpdateXml(2)));
+		ASSERT_EQ(0u, poll(getUpdateXml(2)));
+	}
+
+	TEST_F(ItemUpdateFingerprintsFixture, StatusChangeIsReprocessed)
+	{
+		auto strXml = getUpdateXml(1);
+
+		ASSERT_EQ(3u, poll(strXml));
+		ASSERT_EQ(0u, poll(strXml));
+
+		m_vItems[0]->addSFlag(ItemInfoI::STATUS_UPDATEAVAL);
+
+		ASSERT_EQ(1u, poll(strXml));
+		ASSERT_EQ(0u, poll(strXml));
+
+		m_vItems[0]->delSFlag(ItemInfoI::STATUS_UPDATEAVAL);
+
+		ASSERT_EQ(1u, poll(strXml));
+		ASSERT_EQ(0u, poll(strXml));
+	}
+
+	TEST_F(ItemUpdateFingerprintsFixture, InstalledBuildChangeIsReprocessed)
+	{
+		auto strXml = getUpdateXml(1);
+
+		ASSERT_EQ(3u, poll(strXml));
+		ASSERT_EQ(0u, poll(strXml));
+
+		ASSERT_TRUE(m_vItems[1]->setInstalledMcf(MCFBranch::BranchFromInt(4), MCFBuild::BuildFromInt(1)));
+
+		ASSERT_EQ(1u, poll(strXml));
+		ASSERT_EQ(0u, poll(strXml));
+
+		m_vItems[1]->overideInstalledBuild(MCFBuild::BuildFromInt(2));
+
+		ASSERT_EQ(1u, poll(strXml));
+		ASSERT_EQ(0u, poll(strXml));
+	}
+}
+
+#endif
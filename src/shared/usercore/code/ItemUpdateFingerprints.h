@@ -0,0 +1,61 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_ITEMUPDATEFINGERPRINTS_H
+#define DESURA_ITEMUPDATEFINGERPRINTS_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include <map>
+
+namespace UserCore
+{
+	namespace Item
+	{
+		class ItemInfo;
+
+		//! Remembers what each item looked like the last time its update xml was applied, so the
+		//! update poll can skip items whose xml and local state have not changed since
+		//!
+		class ItemUpdateFingerprints
+		{
+		public:
+			//! Returns true if the update xml with this hash was already applied to the item in its current state
+			//!
+			bool isUnchanged(const gcRefPtr<ItemInfo> &item, uint64 xmlHash) const;
+
+			//! Stores the fingerprint after the update xml has been applied
+			//!
+			void update(const gcRefPtr<ItemInfo> &item, uint64 xmlHash);
+
+			void clear();
+
+			//! Hash of an items update xml and the local state it was applied to
+			//!
+			static uint64 getFingerprint(const gcRefPtr<ItemInfo> &item, uint64 xmlHash);
+
+		private:
+			std::map<uint64, uint64> m_mFingerprints;
+		};
+	}
+}
+
+#endif //DESURA_ITEMUPDATEFINGERPRINTS_H
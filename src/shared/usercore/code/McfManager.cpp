@@ -90,7 +90,7 @@ void MCFManager::getListOfBadMcfPaths(const gcString &szItemDb, std::vector<Migr
 {
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
 		getListOfBadMcfPaths(db, delList, updateList);
 	}
 	catch (std::exception &)
@@ -171,8 +171,8 @@ void MCFManager::migrateOldFiles()
 			{
 				int flags = FLAG_NONE;
 
-				sqlite3x::sqlite3_connection db(szItemDb.c_str());
-				sqlite3x::sqlite3_command cmd(db, "INSERT INTO mcfitem VALUES (?,?,?,?,?);");
+				sqlite3x::sqlite3_pooled_connection db(szItemDb);
+				sqlite3x::sqlite3_command &cmd = db.command("INSERT INTO mcfitem VALUES (?,?,?,?,?);");
 				cmd.bind(1, (long long int)updateList[x].id.toInt64());
 				cmd.bind(2, (int)updateList[x].build);
 				cmd.bind(3, UTIL::OS::getRelativePath(newPath));
@@ -199,7 +199,7 @@ gcString MCFManager::getMcfDb(const char* dataPath)
 
 void MCFManager::createMcfDbTables(const char* dataPath)
 {
-	sqlite3x::sqlite3_connection db(getMcfDb(dataPath).c_str());
+	sqlite3x::sqlite3_pooled_connection db(getMcfDb(dataPath));
 
 	try
 	{
@@ -240,9 +240,9 @@ void MCFManager::getAllMcfPaths(DesuraId id, std::vector<McfPathData> &vList)
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
 
-		sqlite3x::sqlite3_command cmd(db, "SELECT path, mcfbuild, branch FROM mcfitem WHERE internalid=?");
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT path, mcfbuild, branch FROM mcfitem WHERE internalid=?");
 		cmd.bind(1, (long long int)id.toInt64());
 
 		sqlite3x::sqlite3_reader reader = cmd.executereader();
@@ -272,11 +272,11 @@ gcString MCFManager::getMcfPath(DesuraId id, MCFBranch branch, MCFBuild build, b
 	{
 		int flags = isUnAuthed?FLAG_UNAUTHED:FLAG_NONE;
 
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
 
 		if (flags == FLAG_NONE)
 		{
-			sqlite3x::sqlite3_command cmd(db, "SELECT path FROM mcfitem WHERE internalid=? AND mcfbuild=? AND branch=?;");
+			sqlite3x::sqlite3_command &cmd = db.command("SELECT path FROM mcfitem WHERE internalid=? AND mcfbuild=? AND branch=?;");
 			cmd.bind(1, (long long int)id.toInt64());
 			cmd.bind(2, (int)build);
 			cmd.bind(3, (int)branch);
@@ -284,7 +284,7 @@ gcString MCFManager::getMcfPath(DesuraId id, MCFBranch branch, MCFBuild build, b
 		}
 		else
 		{
-			sqlite3x::sqlite3_command cmd(db, "SELECT path FROM mcfitem WHERE internalid=? AND mcfbuild=? AND branch=? AND flags & ?;");
+			sqlite3x::sqlite3_command &cmd = db.command("SELECT path FROM mcfitem WHERE internalid=? AND mcfbuild=? AND branch=? AND flags & ?;");
 			cmd.bind(1, (long long int)id.toInt64());
 			cmd.bind(2, (int)build);
 			cmd.bind(3, (int)branch);
@@ -313,8 +313,8 @@ gcString MCFManager::newMcfPath(DesuraId id, MCFBranch branch, MCFBuild build, b
 	{
 		int flags = isUnAuthed?FLAG_UNAUTHED:FLAG_NONE;
 
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, "INSERT INTO mcfitem VALUES (?,?,?,?,?);");
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
+		sqlite3x::sqlite3_command &cmd = db.command("INSERT INTO mcfitem VALUES (?,?,?,?,?);");
 		cmd.bind(1, (long long int)id.toInt64());
 		cmd.bind(2, (int)build);
 		cmd.bind(3, UTIL::OS::getRelativePath(curPath));
@@ -339,8 +339,8 @@ void MCFManager::delMcfPath(DesuraId id, MCFBranch branch, MCFBuild build)
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, "DELETE FROM mcfitem WHERE internalid=? AND mcfbuild=? AND branch=?;");
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
+		sqlite3x::sqlite3_command &cmd = db.command("DELETE FROM mcfitem WHERE internalid=? AND mcfbuild=? AND branch=?;");
 		cmd.bind(1, (long long int)id.toInt64());
 		cmd.bind(2, (int)build);
 		cmd.bind(3, (int)branch);
@@ -356,11 +356,11 @@ void MCFManager::delMcfPath(DesuraId id, MCFBranch branch, MCFBuild build)
 void MCFManager::delAllMcfPath(DesuraId id)
 {
 	gcString szItemDb = getMcfDb(m_szAppDataPath.c_str());
-	sqlite3x::sqlite3_connection db(szItemDb.c_str());
+	sqlite3x::sqlite3_pooled_connection db(szItemDb);
 
 	try
 	{
-		sqlite3x::sqlite3_command cmd(db, "SELECT path FROM mcfitem WHERE internalid=?;");
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT path FROM mcfitem WHERE internalid=?;");
 		cmd.bind(1, (long long int)id.toInt64());
 		sqlite3x::sqlite3_reader reader = cmd.executereader();
 
@@ -376,7 +376,7 @@ void MCFManager::delAllMcfPath(DesuraId id)
 
 	try
 	{
-		sqlite3x::sqlite3_command cmd(db, "DELETE FROM mcfitem WHERE internalid=?;");
+		sqlite3x::sqlite3_command &cmd = db.command("DELETE FROM mcfitem WHERE internalid=?;");
 		cmd.bind(1, (long long int)id.toInt64());
 		cmd.executenonquery();
 	}
@@ -393,8 +393,8 @@ void MCFManager::properDelMcfBackup(DesuraId gid, DesuraId mid)
 	gcString szItemDb = getMcfDb(m_szAppDataPath.c_str());
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, "DELETE FROM mcfbackup WHERE gid=? AND mid=?;");
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
+		sqlite3x::sqlite3_command &cmd = db.command("DELETE FROM mcfbackup WHERE gid=? AND mid=?;");
 		cmd.bind(1, (long long int)gid.toInt64());
 		cmd.bind(2, (long long int)mid.toInt64());
 		cmd.executenonquery();
@@ -412,8 +412,8 @@ gcString MCFManager::getMcfBackup(DesuraId gid, DesuraId mid)
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, "SELECT path FROM mcfbackup WHERE gid=? AND mid=?;");
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT path FROM mcfbackup WHERE gid=? AND mid=?;");
 		cmd.bind(1, (long long int)gid.toInt64());
 		cmd.bind(2, (long long int)mid.toInt64());
 		res = UTIL::OS::getRelativePath(cmd.executestring());
@@ -462,8 +462,8 @@ gcString MCFManager::newMcfBackup(DesuraId gid, DesuraId mid)
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, "INSERT INTO mcfbackup VALUES (?,?,?);");
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
+		sqlite3x::sqlite3_command &cmd = db.command("INSERT INTO mcfbackup VALUES (?,?,?);");
 		cmd.bind(1, (long long int)gid.toInt64());
 		cmd.bind(2, (long long int)mid.toInt64());
 		cmd.bind(3, UTIL::OS::getRelativePath(parPath));
@@ -495,9 +495,9 @@ void MCFManager::getMCFFiles(std::vector<mcfInfo*> &validFiles, DesuraId id)
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
 
-		sqlite3x::sqlite3_command cmd(db, "SELECT path, mcfbuild FROM mcfitem WHERE internalid=?;");
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT path, mcfbuild FROM mcfitem WHERE internalid=?;");
 		cmd.bind(1, (long long int)id.toInt64());
 
 		sqlite3x::sqlite3_reader reader = cmd.executereader();
@@ -580,8 +580,8 @@ void MCFManager::validateMcf(const char* mcf)
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(szItemDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, "INSERT INTO mcfitem VALUES (?,?,?,?,?);");
+		sqlite3x::sqlite3_pooled_connection db(szItemDb);
+		sqlite3x::sqlite3_command &cmd = db.command("INSERT INTO mcfitem VALUES (?,?,?,?,?);");
 		cmd.bind(1, (long long int)id.toInt64());
 		cmd.bind(2, (int)build);
 		cmd.bind(3, UTIL::OS::getRelativePath(mcf));
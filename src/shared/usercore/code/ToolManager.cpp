@@ -71,7 +71,7 @@ void ToolManager::cleanup()
 	safe_delete(m_pToolThread);
 }
 
-void ToolManager::loadItems()
+void ToolManager::loadItems(const std::function<bool()> &fnCancelled)
 {
 	sqlite3x::sqlite3_connection db(getToolInfoDb(m_pUser->getAppDataPath()).c_str());
 
@@ -93,6 +93,9 @@ void ToolManager::loadItems()
 
 	for (size_t x=0; x<toolIdList.size(); x++)
 	{
+		if (fnCancelled && fnCancelled())
+			break;
+
 		auto tool = findItem(toolIdList[x].toInt64());
 
 		bool bAdd = false;
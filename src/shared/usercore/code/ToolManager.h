@@ -89,7 +89,11 @@ namespace UserCore
 		void parseXml(const XML::gcXMLElement &toolinfoNode) override;
 		std::string getToolName(DesuraId toolId) override;
 
-		void loadItems();
+		//! Loads the tools from the db
+		//!
+		//! @param fnCancelled Checked between tools, stops loading once it returns true
+		//!
+		void loadItems(const std::function<bool()> &fnCancelled = std::function<bool()>());
 		void saveItems() override;
 
 
@@ -212,6 +212,13 @@ bool UpdateThreadOld::pollUpdates()
 		post[key] = "1";
 	}
 
+	const gcString strDelta = m_pUser->getCVarValue("gc_updatepoll_delta");
+	bool bDelta = strDelta != "0" && strDelta != "false";
+
+	//forced polls ask for everything in case something was missed
+	if (bDelta && !m_bForcePoll && !m_szRevision.empty())
+		post["since"] = m_szRevision;
+
 	XML::gcXMLDocument doc;
 
 	try
@@ -278,6 +285,11 @@ void UpdateThreadOld::parseXML(const XML::gcXMLDocument &doc)
 	if (!uNode.IsValid())
 		return;
 
+	//servers that dont do delta polls dont send a revision and always send everything
+	gcString szRevision;
+	uNode.GetChild("revision", szRevision);
+	m_szRevision = szRevision;
+
 	auto tempNode = uNode.FirstChildElement("cookies");
 
 
@@ -85,6 +85,9 @@ namespace UserCore
 		gcRefPtr<UserCore::UserI> m_pUser;
 		gcRefPtr<WebCore::WebCoreI> m_pWebCore;
 
+		//! Revision the server sent with the last poll, sent back so it only returns what changed
+		gcString m_szRevision;
+
 		bool m_bLastFailed = false;
 		bool m_bLoadLoginItems = false;
 	};
@@ -0,0 +1,660 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+
+#include "Common.h"
+#include "UploadChunkPipeline.h"
+#include "util_thread/BaseThread.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace UserCore::Thread;
+
+
+class UploadChunkPipeline::Worker : public ::Thread::BaseThread
+{
+public:
+	Worker(UploadChunkPipeline* pPipeline, uint32 nConnection)
+		: ::Thread::BaseThread("Upload Chunk Thread")
+		, m_pPipeline(pPipeline)
+		, m_nConnection(nConnection)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		m_pPipeline->workerRun(m_nConnection);
+	}
+
+private:
+	UploadChunkPipeline* m_pPipeline;
+	const uint32 m_nConnection;
+};
+
+
+UploadChunkPipeline::UploadChunkPipeline(uint32 nConnections, uint32 uiChunkSize, uint32 nMaxAttempts, uint32 uiRetryDelayMs)
+	: m_nConnections(std::max<uint32>(nConnections, 1))
+	, m_uiChunkSize(std::max<uint32>(uiChunkSize, 1))
+	, m_nMaxAttempts(std::max<uint32>(nMaxAttempts, 1))
+	, m_uiRetryDelayMs(uiRetryDelayMs)
+{
+}
+
+UploadChunkPipeline::~UploadChunkPipeline()
+{
+	for (auto &szBuffer : m_vBuffers)
+		safe_delete(szBuffer);
+}
+
+uint32 UploadChunkPipeline::getConnectionCount() const
+{
+	return m_nConnections;
+}
+
+uint32 UploadChunkPipeline::getChunkSize() const
+{
+	return m_uiChunkSize;
+}
+
+void UploadChunkPipeline::stop()
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+	m_bStop = true;
+
+	m_WorkerCond.notify_all();
+	m_ReaderCond.notify_all();
+	m_StateCond.notify_all();
+}
+
+void UploadChunkPipeline::pause()
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+	m_bPaused = true;
+	++m_nPauseCount;
+}
+
+void UploadChunkPipeline::unpause()
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+	m_bPaused = false;
+
+	m_WorkerCond.notify_all();
+	m_StateCond.notify_all();
+}
+
+bool UploadChunkPipeline::run(uint64 uiStart, uint64 uiSize, const ReadFn &readFn, const PostFn &postFn, const CommitFn &commitFn)
+{
+	gcAssert(m_vBuffers.empty());
+
+	m_fnPost = postFn;
+	m_fnCommit = commitFn;
+
+	const uint32 nChunks = (uint32)((uiSize + m_uiChunkSize - 1) / m_uiChunkSize);
+
+	//one buffer per connection plus one being read
+	const uint32 nBuffers = std::min(nChunks, m_nConnections + 1);
+
+	for (uint32 x = 0; x < nBuffers; ++x)
+	{
+		m_vBuffers.push_back(new char[m_uiChunkSize]);
+		m_vFreeBuffers.push_back(x);
+	}
+
+	std::vector<Worker*> vWorkers;
+
+	for (uint32 x = 0; x < std::min(nChunks, m_nConnections); ++x)
+	{
+		vWorkers.push_back(new Worker(this, x));
+		vWorkers.back()->start();
+	}
+
+	std::unique_lock<std::mutex> lock(m_Lock);
+	uint32 nRead = 0;
+
+	try
+	{
+		while (!m_bStop && m_nNextCommit < nChunks)
+		{
+			m_ReaderCond.wait(lock, [this, nRead, nChunks](){
+				return m_bStop
+					|| (!m_mStored.empty() && m_mStored.begin()->first == m_nNextCommit)
+					|| (nRead < nChunks && !m_vFreeBuffers.empty());
+			});
+
+			commitStored(lock);
+
+			if (m_bStop || nRead >= nChunks || m_vFreeBuffers.empty())
+				continue;
+
+			Pending pending;
+			pending.nBuffer = m_vFreeBuffers.back();
+			pending.chunk.uiIndex = nRead;
+			pending.chunk.uiOffset = uiStart + (uint64)nRead * m_uiChunkSize;
+			pending.chunk.uiSize = (uint32)std::min<uint64>(m_uiChunkSize, uiSize - (uint64)nRead * m_uiChunkSize);
+			pending.chunk.szData = m_vBuffers[pending.nBuffer];
+
+			m_vFreeBuffers.pop_back();
+			++nRead;
+
+			lock.unlock();
+			readFn(m_vBuffers[pending.nBuffer], pending.chunk.uiSize);
+			lock.lock();
+
+			m_dReady.push_back(pending);
+			m_WorkerCond.notify_one();
+		}
+	}
+	catch (...)
+	{
+		if (!lock.owns_lock())
+			lock.lock();
+
+		setException(std::current_exception());
+	}
+
+	m_bDone = true;
+	m_WorkerCond.notify_all();
+	lock.unlock();
+
+	for (auto w : vWorkers)
+	{
+		w->join();
+		safe_delete(w);
+	}
+
+	if (m_pException)
+		std::rethrow_exception(m_pException);
+
+	if (m_bStop)
+		return false;
+
+	if (m_bFinished)
+		return true;
+
+	return postFinish(nChunks, uiStart + uiSize);
+}
+
+void UploadChunkPipeline::workerRun(uint32 nConnection)
+{
+	std::unique_lock<std::mutex> lock(m_Lock);
+
+	while (true)
+	{
+		m_WorkerCond.wait(lock, [this](){
+			return m_bStop || m_bDone || (!m_bPaused && !m_dReady.empty());
+		});
+
+		if (m_bStop || m_bDone)
+			return;
+
+		Pending pending = m_dReady.front();
+		pending.nPauseCount = m_nPauseCount;
+		m_dReady.pop_front();
+
+		lock.unlock();
+
+		UploadChunkResult res = UploadChunkResult::Retry;
+		std::exception_ptr pException;
+
+		try
+		{
+			res = m_fnPost(nConnection, pending.chunk, pending.nAttempts + 1 >= m_nMaxAttempts);
+		}
+		catch (...)
+		{
+			pException = std::current_exception();
+		}
+
+		lock.lock();
+		onPostComplete(lock, pending, res, pException);
+	}
+}
+
+void UploadChunkPipeline::onPostComplete(std::unique_lock<std::mutex> &lock, Pending &pending, UploadChunkResult res, std::exception_ptr pException)
+{
+	if (pException)
+	{
+		setException(pException);
+		return;
+	}
+
+	//aborts we didnt ask for are failed posts, otherwise a connection that keeps aborting never gives up
+	if (res == UploadChunkResult::Aborted && !m_bStop && !m_bPaused && pending.nPauseCount == m_nPauseCount)
+		res = UploadChunkResult::Retry;
+
+	switch (res)
+	{
+	case UploadChunkResult::Finished:
+		m_bFinished = true;
+		//fall through
+
+	case UploadChunkResult::Stored:
+		m_mStored[pending.chunk.uiIndex] = pending.chunk.uiSize;
+		m_vFreeBuffers.push_back(pending.nBuffer);
+		m_ReaderCond.notify_one();
+		break;
+
+	case UploadChunkResult::Retry:
+		++pending.nAttempts;
+
+		if (pending.nAttempts >= m_nMaxAttempts)
+		{
+			setException(std::make_exception_ptr(gcException(ERR_BADSTATUS, gcString("Failed to upload chunk {0} after {1} attempts.", pending.chunk.uiIndex, pending.nAttempts))));
+			return;
+		}
+
+		//this connection holds on to the chunk while it waits so the others keep going
+		waitRetryDelay(lock, pending.nAttempts);
+
+		if (m_bStop)
+			return;
+
+		//retries go first so the committed run from the start keeps growing
+		m_dReady.push_front(pending);
+		m_WorkerCond.notify_one();
+		break;
+
+	case UploadChunkResult::Aborted:
+		//workers wait for unpause before taking it again
+		m_dReady.push_front(pending);
+		m_WorkerCond.notify_one();
+		break;
+	};
+}
+
+void UploadChunkPipeline::commitStored(std::unique_lock<std::mutex> &lock)
+{
+	bool bCommitted = false;
+
+	while (!m_mStored.empty() && m_mStored.begin()->first == m_nNextCommit)
+	{
+		m_uiCommitted += m_mStored.begin()->second;
+		m_mStored.erase(m_mStored.begin());
+
+		++m_nNextCommit;
+		bCommitted = true;
+	}
+
+	if (!bCommitted || !m_fnCommit)
+		return;
+
+	const uint64 uiCommitted = m_uiCommitted;
+
+	lock.unlock();
+	m_fnCommit(uiCommitted);
+	lock.lock();
+}
+
+void UploadChunkPipeline::setException(std::exception_ptr pException)
+{
+	if (!m_pException)
+		m_pException = pException;
+
+	m_bStop = true;
+
+	m_WorkerCond.notify_all();
+	m_ReaderCond.notify_all();
+	m_StateCond.notify_all();
+}
+
+void UploadChunkPipeline::waitRetryDelay(std::unique_lock<std::mutex> &lock, uint32 nAttempts)
+{
+	uint64 uiDelayMs = (uint64)m_uiRetryDelayMs << std::min<uint32>(nAttempts - 1, 6);
+
+	m_StateCond.wait_for(lock, std::chrono::milliseconds(uiDelayMs), [this](){
+		return m_bStop;
+	});
+}
+
+bool UploadChunkPipeline::postFinish(uint32 uiIndex, uint64 uiEnd)
+{
+	UploadChunk chunk;
+	chunk.uiIndex = uiIndex;
+	chunk.uiOffset = uiEnd;
+	chunk.szData = "";
+
+	uint32 nAttempts = 0;
+
+	while (true)
+	{
+		uint32 nPauseCount = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Lock);
+
+			m_StateCond.wait(lock, [this](){
+				return m_bStop || !m_bPaused;
+			});
+
+			if (m_bStop)
+				return false;
+
+			nPauseCount = m_nPauseCount;
+		}
+
+		auto res = m_fnPost(0, chunk, nAttempts + 1 >= m_nMaxAttempts);
+
+		if (res == UploadChunkResult::Finished)
+			return true;
+
+		std::unique_lock<std::mutex> lock(m_Lock);
+
+		if (m_bStop)
+			return false;
+
+		if (res == UploadChunkResult::Aborted && (m_bPaused || nPauseCount != m_nPauseCount))
+			continue;
+
+		++nAttempts;
+
+		if (nAttempts >= m_nMaxAttempts)
+			throw gcException(ERR_BADSTATUS, "Server did not finish the upload after all chunks were stored.");
+
+		waitRetryDelay(lock, nAttempts);
+	}
+}
+
+
+
+#ifdef LINK_WITH_GTEST
+
+#include <future>
+#include <thread>
+
+namespace UnitTest
+{
+	//! Stands in for the upload server. Stores chunks by offset and says the upload
+	//! is finished when the empty chunk is posted at the end of a complete file
+	class UploadServerStandIn
+	{
+	public:
+		UploadServerStandIn(uint64 uiSize, uint32 uiLatencyMs = 0)
+			: m_vFile((size_t)uiSize, 0)
+			, m_vReceived((size_t)uiSize, false)
+			, m_uiLatencyMs(uiLatencyMs)
+		{
+		}
+
+		UploadChunkResult post(const UploadChunk &chunk)
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_Lock);
+				++m_nPosts;
+
+				auto it = m_mFailures.find(chunk.uiIndex);
+
+				if (it != m_mFailures.end() && it->second > 0)
+				{
+					--it->second;
+					return UploadChunkResult::Retry;
+				}
+
+				++m_nInFlight;
+				m_nMaxInFlight = std::max(m_nMaxInFlight, m_nInFlight);
+			}
+
+			//later chunks answer first so acks come back out of order
+			uint32 uiDelay = m_uiLatencyMs + ((chunk.uiIndex % 3) == 0 ? m_uiLatencyMs : 0);
+
+			if (uiDelay)
+				std::this_thread::sleep_for(std::chrono::milliseconds(uiDelay));
+
+			std::lock_guard<std::mutex> guard(m_Lock);
+			--m_nInFlight;
+
+			for (uint32 x = 0; x < chunk.uiSize; ++x)
+			{
+				m_vFile[(size_t)chunk.uiOffset + x] = chunk.szData[x];
+				m_vReceived[(size_t)chunk.uiOffset + x] = true;
+			}
+
+			if (chunk.uiSize == 0 && std::find(begin(m_vReceived), end(m_vReceived), false) == end(m_vReceived))
+				return UploadChunkResult::Finished;
+
+			return UploadChunkResult::Stored;
+		}
+
+		std::vector<char> m_vFile;
+		std::vector<bool> m_vReceived;
+		std::map<uint32, uint32> m_mFailures;
+
+		uint32 m_uiLatencyMs;
+		uint32 m_nPosts = 0;
+		uint32 m_nInFlight = 0;
+		uint32 m_nMaxInFlight = 0;
+
+		std::mutex m_Lock;
+	};
+
+	class UploadChunkPipelineFixture : public ::testing::Test
+	{
+	public:
+		UploadChunkPipelineFixture()
+		{
+			for (size_t x = 0; x < m_vSource.size(); ++x)
+				m_vSource[x] = (char)(x * 31 + 7);
+		}
+
+		bool upload(UploadChunkPipeline &pipeline, UploadServerStandIn &server, uint64 uiStart = 0)
+		{
+			uint64 uiPos = uiStart;
+
+			auto readFn = [this, &uiPos](char* szBuffer, uint32 uiSize){
+				memcpy(szBuffer, &m_vSource[(size_t)uiPos], uiSize);
+				uiPos += uiSize;
+			};
+
+			auto postFn = [&server](uint32, const UploadChunk &chunk, bool){
+				return server.post(chunk);
+			};
+
+			auto commitFn = [this](uint64 uiCommitted){
+				m_vCommits.push_back(uiCommitted);
+			};
+
+			return pipeline.run(uiStart, m_vSource.size() - uiStart, readFn, postFn, commitFn);
+		}
+
+		std::vector<char> m_vSource = std::vector<char>(37 * 1024 + 123);
+		std::vector<uint64> m_vCommits;
+	};
+
+	TEST_F(UploadChunkPipelineFixture, StoresChunksOutOfOrderAndCommitsInOrder)
+	{
+		UploadServerStandIn server(m_vSource.size(), 2);
+		UploadChunkPipeline pipeline(4, 1024);
+
+		ASSERT_TRUE(upload(pipeline, server));
+		ASSERT_TRUE(server.m_vFile == m_vSource);
+		ASSERT_GT(server.m_nMaxInFlight, 1u);
+
+		ASSERT_FALSE(m_vCommits.empty());
+		ASSERT_EQ(m_vSource.size(), m_vCommits.back());
+		ASSERT_TRUE(std::is_sorted(begin(m_vCommits), end(m_vCommits)));
+	}
+
+	TEST_F(UploadChunkPipelineFixture, ResumesFromOffset)
+	{
+		const uint64 uiStart = 10 * 1024 + 5;
+
+		UploadServerStandIn server(m_vSource.size());
+
+		for (uint64 x = 0; x < uiStart; ++x)
+		{
+			server.m_vFile[(size_t)x] = m_vSource[(size_t)x];
+			server.m_vReceived[(size_t)x] = true;
+		}
+
+		UploadChunkPipeline pipeline(3, 4096);
+
+		ASSERT_TRUE(upload(pipeline, server, uiStart));
+		ASSERT_TRUE(server.m_vFile == m_vSource);
+		ASSERT_EQ(m_vSource.size() - uiStart, m_vCommits.back());
+	}
+
+	TEST_F(UploadChunkPipelineFixture, RetriesOnlyTheFailedChunk)
+	{
+		UploadServerStandIn server(m_vSource.size());
+		server.m_mFailures[2] = 2;
+		server.m_mFailures[5] = 1;
+
+		UploadChunkPipeline pipeline(3, 4096, 4, 1);
+
+		ASSERT_TRUE(upload(pipeline, server));
+		ASSERT_TRUE(server.m_vFile == m_vSource);
+
+		//10 chunks, 3 failed posts and the empty finish post
+		ASSERT_EQ(14u, server.m_nPosts);
+	}
+
+	TEST_F(UploadChunkPipelineFixture, GivesUpAfterMaxAttempts)
+	{
+		UploadServerStandIn server(m_vSource.size());
+		server.m_mFailures[3] = 10;
+
+		UploadChunkPipeline pipeline(3, 4096, 4, 1);
+
+		ASSERT_THROW(upload(pipeline, server), gcException);
+
+		for (auto uiCommitted : m_vCommits)
+			ASSERT_LE(uiCommitted, 3u * 4096);
+	}
+
+	TEST_F(UploadChunkPipelineFixture, WaitsLongerBeforeEachRetry)
+	{
+		UploadServerStandIn server(m_vSource.size());
+		server.m_mFailures[0] = 2;
+
+		UploadChunkPipeline pipeline(1, 4096, 4, 20);
+
+		auto start = std::chrono::steady_clock::now();
+		ASSERT_TRUE(upload(pipeline, server));
+
+		//20ms before the first retry and 40ms before the second
+		ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(60));
+	}
+
+	TEST_F(UploadChunkPipelineFixture, AbortWithoutPauseUsesAnAttempt)
+	{
+		UploadChunkPipeline pipeline(2, 1024, 3, 1);
+
+		std::atomic<uint32> nAborts = {0};
+
+		auto readFn = [](char*, uint32){};
+		auto postFn = [&nAborts](uint32, const UploadChunk &chunk, bool){
+			if (chunk.uiIndex != 1)
+				return UploadChunkResult::Stored;
+
+			++nAborts;
+			return UploadChunkResult::Aborted;
+		};
+
+		ASSERT_THROW(pipeline.run(0, 4 * 1024, readFn, postFn, UploadChunkPipeline::CommitFn()), gcException);
+		ASSERT_EQ(3u, nAborts.load());
+	}
+
+	TEST_F(UploadChunkPipelineFixture, AbortWhilePausedWaitsForUnpause)
+	{
+		UploadServerStandIn server(m_vSource.size());
+
+		//one attempt per chunk so an abort that used it would fail the upload
+		UploadChunkPipeline pipeline(2, 4096, 1);
+
+		std::promise<void> paused;
+		bool bPaused = false;
+
+		uint64 uiPos = 0;
+
+		auto readFn = [this, &uiPos](char* szBuffer, uint32 uiSize){
+			memcpy(szBuffer, &m_vSource[(size_t)uiPos], uiSize);
+			uiPos += uiSize;
+		};
+
+		auto postFn = [&](uint32, const UploadChunk &chunk, bool){
+			if (chunk.uiIndex == 3 && !bPaused)
+			{
+				bPaused = true;
+				pipeline.pause();
+				paused.set_value();
+				return UploadChunkResult::Aborted;
+			}
+
+			return server.post(chunk);
+		};
+
+		bool bFinished = false;
+
+		std::thread upload([&](){
+			bFinished = pipeline.run(0, m_vSource.size(), readFn, postFn, UploadChunkPipeline::CommitFn());
+		});
+
+		paused.get_future().wait();
+		pipeline.unpause();
+		upload.join();
+
+		ASSERT_TRUE(bFinished);
+		ASSERT_TRUE(server.m_vFile == m_vSource);
+	}
+
+	TEST_F(UploadChunkPipelineFixture, StopReturnsWithoutFinishing)
+	{
+		UploadChunkPipeline pipeline(2, 1024);
+
+		auto readFn = [](char*, uint32){};
+		auto postFn = [&pipeline](uint32, const UploadChunk &chunk, bool){
+			if (chunk.uiIndex == 4)
+			{
+				pipeline.stop();
+				return UploadChunkResult::Aborted;
+			}
+
+			return UploadChunkResult::Stored;
+		};
+
+		ASSERT_FALSE(pipeline.run(0, 16 * 1024, readFn, postFn, UploadChunkPipeline::CommitFn()));
+	}
+
+	TEST_F(UploadChunkPipelineFixture, ConnectionLatency)
+	{
+		m_vSource.resize(64 * 1024);
+
+		auto timeUpload = [this](uint32 nConnections) -> std::chrono::milliseconds {
+			UploadServerStandIn server(m_vSource.size(), 10);
+			UploadChunkPipeline pipeline(nConnections, 4096);
+
+			auto start = std::chrono::steady_clock::now();
+			EXPECT_TRUE(upload(pipeline, server));
+			return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+		};
+
+		auto single = timeUpload(1);
+		auto multi = timeUpload(4);
+
+		RecordProperty("single_connection_ms", gcString("{0}", single.count()));
+		RecordProperty("four_connections_ms", gcString("{0}", multi.count()));
+
+		ASSERT_LT(multi.count(), single.count());
+	}
+}
+
+#endif
@@ -0,0 +1,164 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+
+#ifndef DESURA_UPLOADCHUNKPIPELINE_H
+#define DESURA_UPLOADCHUNKPIPELINE_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+
+namespace UserCore
+{
+	namespace Thread
+	{
+		//! Part of the upload file. Chunks are posted with their offset in the file so
+		//! the server can store them in any order
+		class UploadChunk
+		{
+		public:
+			uint32 uiIndex = 0;
+			uint64 uiOffset = 0;
+			uint32 uiSize = 0;
+			const char* szData = nullptr;
+		};
+
+		enum class UploadChunkResult
+		{
+			Stored,		//!< Server stored the chunk
+			Finished,	//!< Server stored the chunk and has the whole file
+			Retry,		//!< Post failed, counts against the chunk's retries and is posted again after a delay
+			Aborted,	//!< Post was aborted. Only free if the post overlapped a pause or stop, otherwise counts as a retry
+		};
+
+		//! Uploads a file as fixed size chunks over several connections at once.
+		//!
+		//! The calling thread reads chunks in order into a small pool of read ahead buffers
+		//! while one worker thread per connection posts them. Each chunk is retried on its own
+		//! and progress is only committed over the run of stored chunks from the start so a
+		//! resume never skips a chunk that is still in flight.
+		//!
+		class UploadChunkPipeline
+		{
+		public:
+			//! Reads the next uiSize bytes of the file. Always called in order on the thread calling run
+			typedef std::function<void(char* szBuffer, uint32 uiSize)> ReadFn;
+
+			//! Posts a chunk over connection nConnection. When bLastAttempt is set the chunk has
+			//! no retries left and failures should throw rather than return Retry
+			typedef std::function<UploadChunkResult(uint32 nConnection, const UploadChunk &chunk, bool bLastAttempt)> PostFn;
+
+			//! Called in order on the thread calling run with the number of bytes stored from the start
+			typedef std::function<void(uint64 uiCommitted)> CommitFn;
+
+			//! @param nConnections Chunks in flight at once
+			//! @param uiChunkSize Size of each chunk (the last one can be smaller)
+			//! @param nMaxAttempts Posts per chunk before giving up
+			//! @param uiRetryDelayMs Delay before the first retry of a chunk, doubled for each retry after that
+			//!
+			UploadChunkPipeline(uint32 nConnections, uint32 uiChunkSize, uint32 nMaxAttempts = 4, uint32 uiRetryDelayMs = 500);
+			~UploadChunkPipeline();
+
+			//! Uploads uiSize bytes starting at file offset uiStart. Once every chunk is stored an empty
+			//! chunk is posted at the end if the server has not yet said the upload is finished.
+			//!
+			//! Blocks until the upload finishes, stop is called or a chunk fails for good in which
+			//! case the chunk's exception is rethrown.
+			//!
+			//! @return True if the server finished the upload, false if stopped
+			//!
+			bool run(uint64 uiStart, uint64 uiSize, const ReadFn &readFn, const PostFn &postFn, const CommitFn &commitFn);
+
+			//! Makes run return once the posts in flight return. Abort them to return sooner
+			//!
+			void stop();
+
+			//! Stops handing out chunks until unpause is called. Abort the posts in flight after
+			//! calling this so they come back as Aborted without using a retry
+			//!
+			void pause();
+			void unpause();
+
+			uint32 getConnectionCount() const;
+			uint32 getChunkSize() const;
+
+		protected:
+			class Pending
+			{
+			public:
+				UploadChunk chunk;
+				uint32 nBuffer = 0;
+				uint32 nAttempts = 0;
+				uint32 nPauseCount = 0;
+			};
+
+			class Worker;
+
+			friend class Worker;
+
+			void workerRun(uint32 nConnection);
+			void onPostComplete(std::unique_lock<std::mutex> &lock, Pending &pending, UploadChunkResult res, std::exception_ptr pException);
+			void commitStored(std::unique_lock<std::mutex> &lock);
+			void setException(std::exception_ptr pException);
+			bool postFinish(uint32 uiIndex, uint64 uiEnd);
+
+			//! Waits out the delay before retry number nAttempts. Returns early on stop
+			void waitRetryDelay(std::unique_lock<std::mutex> &lock, uint32 nAttempts);
+
+		private:
+			const uint32 m_nConnections;
+			const uint32 m_uiChunkSize;
+			const uint32 m_nMaxAttempts;
+			const uint32 m_uiRetryDelayMs;
+
+			PostFn m_fnPost;
+			CommitFn m_fnCommit;
+
+			std::vector<char*> m_vBuffers;
+			std::vector<uint32> m_vFreeBuffers;
+
+			std::deque<Pending> m_dReady;
+			std::map<uint32, uint32> m_mStored;
+
+			uint32 m_nNextCommit = 0;
+			uint64 m_uiCommitted = 0;
+
+			bool m_bFinished = false;
+			bool m_bDone = false;
+			bool m_bStop = false;
+			bool m_bPaused = false;
+			uint32 m_nPauseCount = 0;
+			std::exception_ptr m_pException;
+
+			std::mutex m_Lock;
+			std::condition_variable m_WorkerCond;
+			std::condition_variable m_ReaderCond;
+			std::condition_variable m_StateCond;
+		};
+	}
+}
+
+#endif //DESURA_UPLOADCHUNKPIPELINE_H
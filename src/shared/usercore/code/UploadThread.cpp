@@ -30,11 +30,44 @@ Contact us at legal@badjuju.com.
 
 using namespace UserCore::Thread;
 
+
+class UploadThread::Connection
+{
+public:
+	Connection(UploadThread* pThread, uint32 nConnection)
+		: m_pThread(pThread)
+		, m_nConnection(nConnection)
+	{
+		m_hHttpHandle->getProgressEvent() += delegate(this, &Connection::onProgress);
+		m_hHttpHandle->setTrafficClass(UTIL::WEB::TrafficClass::Background);
+	}
+
+	~Connection()
+	{
+		m_hHttpHandle->getProgressEvent() -= delegate(this, &Connection::onProgress);
+	}
+
+	void onProgress(Prog_s& p)
+	{
+		m_pThread->onProgress(m_nConnection, p);
+	}
+
+	HttpHandle m_hHttpHandle;
+
+	//only touched with the thread's connection lock held
+	uint64 m_uiSent = 0;
+	double m_dSpeed = 0;
+
+private:
+	UploadThread* m_pThread;
+	const uint32 m_nConnection;
+};
+
+
 UploadThread::UploadThread(gcRefPtr<UploadThreadInfo> info) : MCFThread("Upload Thread", info->itemId)
 {
 	m_pInfo = info;
 
-	m_uiContinueCount = 0;
 	m_uiChunkSize = 1024*1024; //chunksize;
 	m_uiFileSize = 0;
 	m_uiAmountRead =0;
@@ -44,6 +77,7 @@ UploadThread::UploadThread(gcRefPtr<UploadThreadInfo> info) : MCFThread("Upload
 UploadThread::~UploadThread()
 {
 	stop();
+	safe_delete(m_vConnections);
 }
 
 void UploadThread::doRun()
@@ -51,11 +85,9 @@ void UploadThread::doRun()
 	gcString szSafeUploads = getUserCore()->getCVarValue("gc_safe_uploads");
 	bool bSafeUploads = szSafeUploads == "true" || szSafeUploads == "1";
 
-	DesuraId id= getItemId();
-	gcString type = id.getTypeString();
-
+	const char* szConnections = getUserCore()->getCVarValue("gc_upload_connections");
+	uint32 nConnections = Clamp<uint32>(szConnections ? Safe::atoi(szConnections) : 1, 1, 8);
 
-	uint32 sCode = 0;
 	UTIL::FS::Path path = UTIL::FS::PathWithFile(m_pInfo->szFile);
 	m_uiFileSize = UTIL::FS::getFileSize(path);
 
@@ -77,148 +109,200 @@ void UploadThread::doRun()
 		onUploadProgressEvent(ui);
 	}
 
-	if (bSafeUploads)
+	uint32 minSize = 5 * 1024 * 1024;
+	uint32 maxSize = 100 * 1024 * 1024;
+
+	if (nConnections > 1)
+	{
+		//each connection plus the read ahead holds a chunk so keep them all under the old max chunk size
+		uint64 chunkCalc = m_uiFileSize / (nConnections * 4);
+		m_uiChunkSize = Clamp((uint32)std::min<uint64>(chunkCalc, maxSize), minSize, std::max(minSize, maxSize / (nConnections + 1)));
+	}
+	else if (bSafeUploads)
 	{
 		uint64 chunkCalc = m_uiFileSize / 10;
 		//max chunk size is 100mg, min is 5mg
 
-		uint32 minSize = 5 * 1024 * 1024;
-		uint32 maxSize = 100 * 1024 * 1024;
-
-		m_uiChunkSize = Clamp((uint32) chunkCalc, minSize, maxSize);
+		m_uiChunkSize = Clamp((uint32)std::min<uint64>(chunkCalc, maxSize), minSize, maxSize);
 	}
 	else
 	{
-		m_uiChunkSize = (uint32)std::min<uint64>(m_uiFileSize, 100 * 1024 * 1024);
+		m_uiChunkSize = (uint32)std::min<uint64>(m_uiFileSize, maxSize);
 	}
 
 	//if the file is 20% (or less) bigger than one chunk. Upload in one go
 	if (m_uiFileSize < UINT_MAX && (uint64)((double)m_uiChunkSize*1.2) > m_uiFileSize)
 		m_uiChunkSize = (uint32)m_uiFileSize;
 
-	gcString url = getWebCore()->getUrl(WebCore::McfUpload);
-	m_hHttpHandle->setUrl(url.c_str());
-	m_hHttpHandle->getProgressEvent() += delegate(this, &UploadThread::onProgress);
+	uint64 uiLeft = m_uiFileSize - m_pInfo->uiStart;
+	nConnections = (uint32)std::max<uint64>(1, std::min<uint64>(nConnections, (uiLeft + m_uiChunkSize - 1) / m_uiChunkSize));
 
-	UTIL::MISC::Buffer buffer(m_uiChunkSize);
+	gcString url = getWebCore()->getUrl(WebCore::McfUpload);
 
-	while (sCode != 999)
 	{
-		if (m_bCancel)
-			break;
+		std::lock_guard<std::mutex> guard(m_ConnectionLock);
 
-		while (isPaused())
+		for (uint32 x = 0; x < nConnections; ++x)
 		{
-			gcSleep(500);
+			m_vConnections.push_back(new Connection(this, x));
+			m_vConnections.back()->m_hHttpHandle->setUrl(url.c_str());
 		}
 
-		uint32 chunkSize = m_uiChunkSize;
-		uint64 fileLeft =  m_uiFileSize - (m_uiAmountRead + m_pInfo->uiStart);
-		if ((uint64)chunkSize > fileLeft)
-		{
-			chunkSize = (uint32)(fileLeft);
-		}
+		m_pPipeline.reset(new UploadChunkPipeline(nConnections, m_uiChunkSize));
 
-		if (sCode == 0)
-		{
-			hFile.read(buffer, chunkSize);
-			sCode = 900;
-		}
+		if (m_bCancel)
+			m_pPipeline->stop();
+		else if (isPaused())
+			m_pPipeline->pause();
+	}
 
+	auto readFn = [&hFile](char* szBuffer, uint32 uiSize){
+		hFile.read(szBuffer, uiSize);
+	};
 
-		m_hHttpHandle->cleanUp();
-		m_hHttpHandle->clearCookies();
-		getWebCore()->setWCCookies(m_hHttpHandle);
+	auto postFn = [this](uint32 nConnection, const UploadChunk &chunk, bool bLastAttempt){
+		return postChunk(nConnection, chunk, bLastAttempt);
+	};
 
-		m_hHttpHandle->addPostText("key", m_pInfo->szKey.c_str());
-		m_hHttpHandle->addPostText("action", "uploadchunk");
-		m_hHttpHandle->addPostText("siteareaid", id.getItem());
-		m_hHttpHandle->addPostText("sitearea", type.c_str());
-		m_hHttpHandle->addPostFileAsBuff("mcf", "upload.mcf", buffer, chunkSize);
-		m_hHttpHandle->addPostText("uploadsize", chunkSize);
+	auto commitFn = [this](uint64 uiCommitted){
+		onChunksCommitted(uiCommitted);
+	};
 
-		uint8 res = 0;
+	bool bFinished = m_pPipeline->run(m_pInfo->uiStart, uiLeft, readFn, postFn, commitFn);
 
-		//need to check here a second time incase we where paused or by fluke missed the check the first time as m_hHttpHandle->CleanUp() removes the abort flag.
-		if (m_bCancel)
-			break;
+	hFile.close();
 
-		try
-		{
-			res = m_hHttpHandle->postWeb();
-		}
-		catch (gcException &except)
-		{
-			if (m_uiContinueCount > 3)
-			{
-				throw;
-			}
-			else
-			{
-				m_uiContinueCount++;
-				Warning("Failed to upload chunk: {0}. Retrying.\n", except);
-				continue;
-			}
-		}
+	if (bFinished)
+	{
+		uint32 sCode = (uint32)MCFUploadStatus::Finished;
+		onCompleteEvent(sCode);
+		getUploadManager()->removeUpload(m_pInfo->szKey.c_str(), false);
+	}
+}
 
-		if (res == UWEB_USER_ABORT)
-			continue;
+UploadChunkResult UploadThread::postChunk(uint32 nConnection, const UploadChunk &chunk, bool bLastAttempt)
+{
+	while (isPaused() && !m_bCancel)
+	{
+		gcSleep(500);
+	}
 
-		const char* error = m_hHttpHandle->getData();
+	if (m_bCancel)
+		return UploadChunkResult::Aborted;
 
-		//Warning("UC: %s\n", error);
+	DesuraId id = getItemId();
+	gcString type = id.getTypeString();
 
-		XML::gcXMLDocument doc(const_cast<char*>(error), m_hHttpHandle->getDataSize());
+	Connection* pConnection = m_vConnections[nConnection];
+	HttpHandle &hHttpHandle = pConnection->m_hHttpHandle;
 
-		int status = -1;
+	{
+		std::lock_guard<std::mutex> guard(m_ConnectionLock);
+		pConnection->m_uiSent = 0;
+		pConnection->m_dSpeed = 0;
+	}
+
+	hHttpHandle->cleanUp();
+	hHttpHandle->clearCookies();
+	getWebCore()->setWCCookies(hHttpHandle);
+
+	hHttpHandle->addPostText("key", m_pInfo->szKey.c_str());
+	hHttpHandle->addPostText("action", "uploadchunk");
+	hHttpHandle->addPostText("siteareaid", id.getItem());
+	hHttpHandle->addPostText("sitearea", type.c_str());
+	hHttpHandle->addPostText("offset", gcString("{0}", chunk.uiOffset).c_str());
+	hHttpHandle->addPostFileAsBuff("mcf", "upload.mcf", chunk.szData, chunk.uiSize);
+	hHttpHandle->addPostText("uploadsize", chunk.uiSize);
 
-		try
+	//need to check here a second time incase we where paused or by fluke missed the check the first time as hHttpHandle->CleanUp() removes the abort flag.
+	if (m_bCancel || isPaused())
+		return UploadChunkResult::Aborted;
+
+	uint8 res = 0;
+
+	try
+	{
+		res = hHttpHandle->postWeb();
+	}
+	catch (gcException &except)
+	{
+		if (bLastAttempt)
+			throw;
+
+		Warning("Failed to upload chunk {0}: {1}. Retrying.\n", chunk.uiIndex, except);
+		return UploadChunkResult::Retry;
+	}
+
+	if (res == UWEB_USER_ABORT)
+		return UploadChunkResult::Aborted;
+
+	const char* error = hHttpHandle->getData();
+
+	XML::gcXMLDocument doc(const_cast<char*>(error), hHttpHandle->getDataSize());
+
+	int status = -1;
+
+	try
+	{
+		doc.ProcessStatus("itemupload", status);
+	}
+	catch (...)
+	{
+		if (status == (int)MCFUploadStatus::Finished)
 		{
-			doc.ProcessStatus("itemupload", status);
 		}
-		catch (...)
+		else if (status == (int)MCFUploadStatus::Failed || status == (int)MCFUploadStatus::ItemNotFound || bLastAttempt)
 		{
-			if (status == (int)MCFUploadStatus::Finished)
-			{
-			}
-			else if (status == (int)MCFUploadStatus::Failed || status == (int)MCFUploadStatus::ItemNotFound || m_uiContinueCount > 3)
-			{
-				throw;
-			}
-			else
-			{
-				m_uiContinueCount++;
-				Warning("Upload xml error! Retrying. [{0}]\n", m_pInfo->szFile);
-				continue;
-			}
+			throw;
 		}
-
-		sCode = status;
-
-		if (sCode == (int)MCFUploadStatus::Ok || sCode == (int)MCFUploadStatus::Finished)
+		else
 		{
-			m_uiAmountRead += chunkSize;
-			m_uiContinueCount = 0;
-
-			UserCore::Misc::UploadInfo ui;
-			ui.milestone = true;
-			onUploadProgressEvent(ui);
+			Warning("Upload xml error! Retrying chunk {0}. [{1}]\n", chunk.uiIndex, m_pInfo->szFile);
+			return UploadChunkResult::Retry;
 		}
 	}
 
-	hFile.close();
+	if (status == (int)MCFUploadStatus::Finished)
+		return UploadChunkResult::Finished;
+
+	if (status == (int)MCFUploadStatus::Ok)
+		return UploadChunkResult::Stored;
 
-	if (sCode == 999)
+	return UploadChunkResult::Retry;
+}
+
+void UploadThread::onChunksCommitted(uint64 uiCommitted)
+{
 	{
-		onCompleteEvent(sCode);
-		getUploadManager()->removeUpload(m_pInfo->szKey.c_str(), false);
+		std::lock_guard<std::mutex> guard(m_ConnectionLock);
+		m_uiAmountRead = uiCommitted;
 	}
-}
 
+	UserCore::Misc::UploadInfo ui;
+	ui.milestone = true;
+	onUploadProgressEvent(ui);
+}
 
-void UploadThread::onProgress(Prog_s& p)
+void UploadThread::onProgress(uint32 nConnection, Prog_s& p)
 {
-	uint64 currProg = m_uiAmountRead + (uint64)p.ulnow;
+	std::lock_guard<std::mutex> guard(m_ConnectionLock);
+
+	if (nConnection >= m_vConnections.size())
+		return;
+
+	m_vConnections[nConnection]->m_uiSent = (uint64)p.ulnow;
+	m_vConnections[nConnection]->m_dSpeed = p.abort ? 0 : p.ulspeed;
+
+	uint64 currProg = m_uiAmountRead;
+	double speed = 0;
+
+	for (auto c : m_vConnections)
+	{
+		currProg += c->m_uiSent;
+		speed += c->m_dSpeed;
+	}
+
+	currProg = std::min(currProg, m_uiFileSize - m_pInfo->uiStart);
 
 	UserCore::Misc::UploadInfo ui;
 	ui.num = 0;
@@ -233,7 +317,7 @@ void UploadThread::onProgress(Prog_s& p)
 		return;
 
 	m_tLastProgUpdate = now;
-	double pred = (m_uiFileSize - currProg - m_pInfo->uiStart) / p.ulspeed;
+	double pred = speed > 0 ? (m_uiFileSize - currProg - m_pInfo->uiStart) / speed : 0;
 
 	if (p.abort)
 	{
@@ -246,7 +330,7 @@ void UploadThread::onProgress(Prog_s& p)
 
 		ui.min = (uint8) predTime.minutes();
 		ui.hour = (uint8) predTime.hours();
-		ui.rate = (uint32) (p.ulspeed);
+		ui.rate = (uint32) (speed);
 	}
 
 	onUploadProgressEvent(ui);
@@ -254,17 +338,47 @@ void UploadThread::onProgress(Prog_s& p)
 
 void UploadThread::onPause()
 {
-	m_hHttpHandle->abortTransfer();
+	{
+		std::lock_guard<std::mutex> guard(m_ConnectionLock);
+
+		if (m_pPipeline)
+			m_pPipeline->pause();
+	}
+
+	abortConnections();
 	onPauseEvent();
 }
 
 void UploadThread::onUnpause()
 {
+	{
+		std::lock_guard<std::mutex> guard(m_ConnectionLock);
+
+		if (m_pPipeline)
+			m_pPipeline->unpause();
+	}
+
 	onUnpauseEvent();
 }
 
 void UploadThread::onStop()
 {
 	m_bCancel = true;
-	m_hHttpHandle->abortTransfer();
+
+	{
+		std::lock_guard<std::mutex> guard(m_ConnectionLock);
+
+		if (m_pPipeline)
+			m_pPipeline->stop();
+	}
+
+	abortConnections();
+}
+
+void UploadThread::abortConnections()
+{
+	std::lock_guard<std::mutex> guard(m_ConnectionLock);
+
+	for (auto c : m_vConnections)
+		c->m_hHttpHandle->abortTransfer();
 }
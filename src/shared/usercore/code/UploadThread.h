@@ -27,6 +27,7 @@ Contact us at legal@badjuju.com.
 
 
 #include "MCFThread.h"
+#include "UploadChunkPipeline.h"
 #include "util/gcTime.h"
 
 
@@ -73,8 +74,14 @@ namespace UserCore
 			virtual ~UploadThread();
 
 		protected:
+			class Connection;
+
 			void doRun();
-			void onProgress(Prog_s& p);
+			void onProgress(uint32 nConnection, Prog_s& p);
+
+			UploadChunkResult postChunk(uint32 nConnection, const UploadChunk &chunk, bool bLastAttempt);
+			void onChunksCommitted(uint64 uiCommitted);
+			void abortConnections();
 
 			virtual void onPause();
 			virtual void onUnpause();
@@ -87,10 +94,12 @@ namespace UserCore
 
 		private:
 			gcRefPtr<UploadThreadInfo> m_pInfo;
-			HttpHandle m_hHttpHandle;
+
+			std::mutex m_ConnectionLock;
+			std::vector<Connection*> m_vConnections;
+			std::unique_ptr<UploadChunkPipeline> m_pPipeline;
 
 			uint32 m_uiChunkSize;
-			uint32 m_uiContinueCount;
 
 			uint64 m_uiFileSize;
 			uint64 m_uiAmountRead;
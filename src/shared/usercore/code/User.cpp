@@ -49,10 +49,28 @@ Contact us at legal@badjuju.com.
 
 #include "BDManager.h"
 #include "McfManager.h"
+#include "BackgroundModeMonitor.h"
+
+#include "mcfcore/MCFMain.h"
+#include "mcfcore/MCFIOSchedulerI.h"
 
 namespace UM = UserCore::Misc;
 using namespace UserCore;
 
+//! Points webcore and mcfcore at a bandwidth limiter so all transfers share one budget
+static void ShareBandwidthLimiter(UTIL::WEB::BandwidthLimiter* pLimiter)
+{
+	auto setWebCoreLimiter = (UTIL::WEB::SetBandwidthLimiterFn)WebCore::FactoryBuilder(WEBCORE_BANDWIDTHLIMITER);
+
+	if (setWebCoreLimiter)
+		setWebCoreLimiter(pLimiter);
+
+	auto setMcfCoreLimiter = (UTIL::WEB::SetBandwidthLimiterFn)MCFCore::FactoryBuilder(MCF_BANDWIDTHLIMITER);
+
+	if (setMcfCoreLimiter)
+		setMcfCoreLimiter(pLimiter);
+}
+
 User::User()
 	: m_bAltProvider(false)
 {
@@ -85,6 +103,11 @@ void User::destroy()
 	safe_delete(m_pThreadPool);
 	safe_delete(m_pWebCore);
 	safe_delete(m_pMcfManager);
+
+	ShareBandwidthLimiter(nullptr);
+
+	//Checkpoint and release the item and mcf databases so they can be moved once we log out
+	sqlite3x::closepooledconnections();
 }
 
 void User::onLoginItemsLoaded()
@@ -123,6 +146,8 @@ void User::init(const char* appDataPath, const char* szProviderUrl)
 	m_pWebCore = gcRefPtr<WebCore::WebCoreI>((WebCore::WebCoreI*)WebCore::FactoryBuilder(WEBCORE));
 	m_pWebCore->init(appDataPath, szProviderUrl);
 
+	ShareBandwidthLimiter(&UTIL::WEB::GetBandwidthLimiter());
+
 	m_pBannerDownloadManager = gcRefPtr<BDManager>::create(this);
 	m_pCDKeyManager = gcRefPtr<CDKeyManager>::create(this);
 
@@ -170,6 +195,9 @@ void User::cleanUp()
 	if (m_pToolManager)
 		m_pToolManager->cleanup();
 
+	if (m_pBackgroundModeMonitor)
+		m_pBackgroundModeMonitor->stop();
+
 	//must delete this one first as upload threads are apart of thread manager
 	safe_delete(m_pUploadManager);
 	safe_delete(m_pUThread);
@@ -185,6 +213,7 @@ void User::cleanUp()
 	}
 
 	safe_delete(m_pToolManager);
+	safe_delete(m_pBackgroundModeMonitor);
 	safe_delete(m_pPipeClient);
 	safe_delete(m_pCDKeyManager);
 	safe_delete(m_pBannerDownloadManager);
@@ -219,6 +248,10 @@ void User::init()
 	m_pCIPManager = gcRefPtr<CIPManager>::create(this);
 	m_pPipeClient = nullptr;
 
+	m_pBackgroundModeMonitor = gcRefPtr<UserCore::Misc::BackgroundModeMonitor>::create([this](bool bEnabled){
+		applyBackgroundMode(bEnabled);
+	});
+
 	m_bDownloadingUpdate = false;
 
 	onNeedWildCardEvent.reset();
@@ -411,6 +444,44 @@ void User::changeAccount(DesuraId id, uint8 action)
 	m_pThreadPool->queueTask(gcRefPtr<UserCore::Task::ChangeAccountTask>::create(this, id, action));
 }
 
+void User::onItemLaunched(DesuraId id, const char* szPath)
+{
+	if (m_pBackgroundModeMonitor)
+		m_pBackgroundModeMonitor->onItemLaunched(id, szPath);
+}
+
+void User::refreshBackgroundMode()
+{
+	applyBackgroundMode(m_pBackgroundModeMonitor && m_pBackgroundModeMonitor->isBackgroundMode());
+}
+
+void User::applyBackgroundMode(bool bEnabled)
+{
+	const gcString strEnabled = getCVarValue("gc_background_mode");
+
+	if (strEnabled != "1" && strEnabled != "true")
+		bEnabled = false;
+
+	uint32 uiRateLimit = Safe::atoi(getCVarValue("gc_background_io_limit"));
+
+	auto pScheduler = (MCFCore::IOSchedulerI*)MCFCore::FactoryBuilder(MCF_IOSCHEDULER);
+
+	if (pScheduler)
+		pScheduler->setBackgroundMode(bEnabled, uiRateLimit);
+
+	try
+	{
+		auto pServiceMain = getServiceMain();
+
+		if (pServiceMain)
+			pServiceMain->setMcfBackgroundMode(bEnabled, uiRateLimit);
+	}
+	catch (gcException &e)
+	{
+		Warning("Failed to set mcf background mode in service: {0}\n", e);
+	}
+}
+
 void User::parseNews(const XML::gcXMLElement &newsNode)
 {
 	parseNewsAndGifts(newsNode, "item", onNewsUpdateEvent);
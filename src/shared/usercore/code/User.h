@@ -84,6 +84,11 @@ namespace UserCore
 		class UserThreadI;
 	}
 
+	namespace Misc
+	{
+		class BackgroundModeMonitor;
+	}
+
 	namespace Misc
 	{
 		//! Update available struct
@@ -119,6 +124,14 @@ namespace UserCore
 		virtual std::shared_ptr<IPC::ServiceMainI> getServiceMain() = 0;
 
 		virtual gcRefPtr<MCFManagerI> getMCFManager() = 0;
+
+		//! Lets the user know a item was launched so mcf work can be moved to the background
+		//! while it runs
+		//!
+		//! @param id Item that was launched
+		//! @param szPath Install folder of the item
+		//!
+		virtual void onItemLaunched(DesuraId id, const char* szPath) = 0;
 	};
 
 #ifdef LINK_WITH_GMOCK
@@ -133,6 +146,7 @@ namespace UserCore
 		MOCK_METHOD2(changeAccount, void(DesuraId, uint8));
 		MOCK_METHOD0(getMCFManager, gcRefPtr<MCFManagerI>());
 		MOCK_METHOD0(getServiceMain, std::shared_ptr<IPC::ServiceMainI>());
+		MOCK_METHOD2(onItemLaunched, void(DesuraId, const char*));
 
 		gc_IMPLEMENT_REFCOUNTING(UserInternalMock);
 	};
@@ -181,6 +195,7 @@ namespace UserCore
 		void forceUpdatePoll() override;
 		void forceQATestingUpdate() override;
 		void setQATesting(bool bEnable = true) override;
+		void refreshBackgroundMode() override;
 
 		///////////////////////////////////////////////////////////////////////////////
 		// Getters
@@ -292,6 +307,7 @@ namespace UserCore
 #endif
 
 		gcRefPtr<MCFManagerI> getMCFManager() override;
+		void onItemLaunched(DesuraId id, const char* szPath) override;
 
 		//! Start the pipe to the desura service
 		//!
@@ -349,6 +365,12 @@ namespace UserCore
 
 		void testMcfCache();
 
+		//! Passes background mode on to mcfcore in this process and in the service
+		//!
+		//! @param bEnabled Turn background mode on or off
+		//!
+		void applyBackgroundMode(bool bEnabled);
+
 	private:
 		void doLogIn(const char* user, const char* pass, bool bTestOnly);
 
@@ -397,6 +419,7 @@ namespace UserCore
 		gcRefPtr<UserCore::BDManager> m_pBannerDownloadManager;
 		gcRefPtr<UserCore::CIPManager> m_pCIPManager;
 		gcRefPtr<UserCore::MCFManager> m_pMcfManager;
+		gcRefPtr<UserCore::Misc::BackgroundModeMonitor> m_pBackgroundModeMonitor;
 
 		volatile bool m_bLocked = false;
 		::Thread::WaitCondition m_WaitCond;
@@ -24,9 +24,40 @@ Contact us at legal@badjuju.com.
 #include "User.h"
 #include "usercore/UserCoreI.h"
 #include <branding/usercore_version.h>
+#include "util/UtilMetrics.h"
+#include "util/UtilTimeline.h"
+#include "sqlite3x.hpp"
 
 gcString g_szUserCoreVersion("{0}.{1}.{2}.{3}", VERSION_MAJOR, VERSION_MINOR, VERSION_BUILDNO, VERSION_EXTEND);
 
+namespace
+{
+	UTIL::METRICS::Histogram &g_QueryTime = UTIL::METRICS::GetRegistry().histogram("usercore.sqlite.query_us");
+
+	void ProfileQuery(void*, const char*, unsigned long long nNanoSeconds)
+	{
+		g_QueryTime.record(nNanoSeconds / 1000);
+	}
+
+	void PoolWarning(const char* szDb, const char* szMsg)
+	{
+		Warning("Sqlite pool {0}: {1}\n", szDb, szMsg);
+	}
+
+	//Times every statement run on a usercore connection and reports pool setup failures
+	class RegQueryProfiler
+	{
+	public:
+		RegQueryProfiler()
+		{
+			sqlite3x::setprofilecallback(&ProfileQuery);
+			sqlite3x::setpoolwarningcallback(&PoolWarning);
+		}
+	};
+
+	RegQueryProfiler g_RegQueryProfiler;
+}
+
 
 namespace UserCore
 {
@@ -60,6 +91,18 @@ extern "C"
 		{
 			return (void*)&UserCore::Item::ItemHandle::getStatusStr_s;
 		}
+		else if (strName == USERCORE_METRICS)
+		{
+			return &UTIL::METRICS::GetRegistry();
+		}
+		else if (strName == USERCORE_TIMELINE)
+		{
+			return &UTIL::TIMELINE::GetTimeline();
+		}
+		else if (strName == USERCORE_BANDWIDTHLIMITER)
+		{
+			return &UTIL::WEB::GetBandwidthLimiter();
+		}
 
 		return nullptr;
 	}
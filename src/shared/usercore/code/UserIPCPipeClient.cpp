@@ -26,6 +26,7 @@ Contact us at legal@badjuju.com.
 
 #ifdef NIX
 #include "IPCServerI.h"
+#include "util/UtilLinux.h"
 typedef void* (*FactoryFn)(const char*);
 #endif
 
@@ -155,21 +156,8 @@ UserIPCPipeClient::~UserIPCPipeClient()
 #else
 	void UserIPCPipeClient::start()
 	{
-		if (!m_hServiceDll.load("libservicecore.so"))
-			throw gcException(ERR_INVALID, gcString("Failed to load service core: {0}", dlerror()));
-
-		FactoryFn factory = m_hServiceDll.getFunction<FactoryFn>("FactoryBuilderSC");
-
-		if (!factory)
-			throw gcException(ERR_INVALID, "Failed to get factory function");
-
-		m_pServer = (IPCServerI*)factory(IPC_SERVER);
-
-		if (!factory)
-			throw gcException(ERR_INVALID, "Failed to create server");
-
-		m_pServer->setSendCallback((void*)this, &UserIPCPipeClient::recvMessage);
-		setSendCallback((void*)this, &UserIPCPipeClient::sendMessage);
+		if (!connectToService())
+			startInProcess();
 
 		IPC::PipeClient::start();
 
@@ -183,9 +171,70 @@ UserIPCPipeClient::~UserIPCPipeClient()
 		m_pServiceMain->setAppDataPath(m_szAppDataPath.c_str());
 	}
 
-	void UserIPCPipeClient::setUpPipes()
+	bool UserIPCPipeClient::tryConnect()
+	{
+		try
+		{
+			IPC::PipeClient::setUpPipes();
+			return true;
+		}
+		catch (gcException &)
+		{
+			return false;
+		}
+	}
+
+	bool UserIPCPipeClient::connectToService()
+	{
+		if (tryConnect())
+			return true;
+
+		gcString strBinDir(UTIL::OS::getCurrentDir());
+		gcString strExe("{0}/desura_service", strBinDir);
+
+		std::map<std::string, std::string> info;
+		info["lp"] = strBinDir;
+
+		if (!UTIL::LIN::launchProcess(strExe.c_str(), info))
+		{
+			Warning("Failed to start {0}, running service core in process instead.\n", strExe);
+			return false;
+		}
+
+		uint32 count = 0;
+		while (!tryConnect())
+		{
+			//wait five seconds
+			if (count > 50)
+			{
+				Warning("Desura service didnt start listening, running service core in process instead.\n");
+				return false;
+			}
+
+			gcSleep(100);
+			count++;
+		}
+
+		return true;
+	}
+
+	void UserIPCPipeClient::startInProcess()
 	{
+		if (!m_hServiceDll.load("libservicecore.so"))
+			throw gcException(ERR_INVALID, gcString("Failed to load service core: {0}", dlerror()));
+
+		FactoryFn factory = m_hServiceDll.getFunction<FactoryFn>("FactoryBuilderSC");
+
+		if (!factory)
+			throw gcException(ERR_INVALID, "Failed to get factory function");
+
+		m_pServer = (IPCServerI*)factory(IPC_SERVER);
 
+		if (!m_pServer)
+			throw gcException(ERR_INVALID, "Failed to create server");
+
+		m_pServer->setSendCallback((void*)this, &UserIPCPipeClient::recvMessage);
+		setSendCallback((void*)this, &UserIPCPipeClient::sendMessage);
 	}
 
 	void UserIPCPipeClient::recvMessage(void* obj, const char* buffer, size_t size)
@@ -64,7 +64,17 @@ namespace UserCore
 		void recvMessage(const char* buffer, size_t size);
 		static void sendMessage(void* obj, const char* buffer, size_t size);
 		void sendMessage(const char* buffer, size_t size);
-		virtual void setUpPipes();
+
+		//! Connects to the desura_service process, starting it if it isnt running
+		//!
+		//! @return False if the service couldnt be reached
+		//!
+		bool connectToService();
+		bool tryConnect();
+
+		//! Loads service core into this process when no service is listening
+		//!
+		void startInProcess();
 #endif
 
 	private:
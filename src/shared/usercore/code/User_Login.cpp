@@ -32,6 +32,7 @@ Contact us at legal@badjuju.com.
 #include "sqlite3x.hpp"
 
 #include "util_thread/ThreadPool.h"
+#include "util_thread/TaskGraph.h"
 
 #include <branding/usercore_version.h>
 #include "UpdateThread.h"
@@ -96,9 +97,9 @@ void User::initPipe()
 		}
 		catch (gcException &)
 		{
+			//callers log out, during login other graph steps can still be using the managers
 			if (x > 5)
 			{
-				logOut();
 				throw;
 			}
 			else
@@ -118,7 +119,15 @@ void User::logInCleanUp()
 	m_pItemManager->loadItems();
 	m_pItemManager->enableSave();
 
-	initPipe();
+	try
+	{
+		initPipe();
+	}
+	catch (...)
+	{
+		logOut();
+		throw;
+	}
 }
 
 void User::logIn(const char* user, const char* pass)
@@ -155,74 +164,122 @@ void User::doLogIn(const char* user, const char* pass, bool bTestOnly)
 		throw gcException(ERR_NULLWEBCORE);
 
 	XML::gcXMLDocument doc;
-	m_pWebCore->logIn(user, pass, doc);
+	XML::gcXMLElement memNode;
+	uint32 version = 0;
+	bool bBadLogin = false;
 
-	auto uNode = doc.GetRoot("memberlogin");
+	auto webLogin = [&]()
+	{
+		m_pWebCore->logIn(user, pass, doc);
 
-	if (!uNode.IsValid())
-		throw gcException(ERR_BADXML);
+		auto uNode = doc.GetRoot("memberlogin");
 
-	uint32 version = 0;
-	uNode.GetAtt("version", version);
+		if (!uNode.IsValid())
+			throw gcException(ERR_BADXML);
 
-	if (version == 0)
-		version = 1;
+		uNode.GetAtt("version", version);
 
-	m_bDelayLoading = (version >= 3);
+		if (version == 0)
+			version = 1;
 
-	auto memNode = uNode.FirstChildElement("member");
+		m_bDelayLoading = (version >= 3);
 
-	if (memNode.IsValid())
-	{
-		m_iUserId = 0;
-		memNode.GetAtt("siteareaid", m_iUserId);
+		memNode = uNode.FirstChildElement("member");
 
-		if ((int)m_iUserId <= 0)
+		if (memNode.IsValid())
 		{
-			logOut();
-			throw gcException(ERR_BAD_PORU);
+			m_iUserId = 0;
+			memNode.GetAtt("siteareaid", m_iUserId);
+
+			if ((int)m_iUserId <= 0)
+			{
+				bBadLogin = true;
+				throw gcException(ERR_BAD_PORU);
+			}
 		}
-	}
 
-	memNode.GetChild("admin", m_bAdmin);
-	memNode.GetChild("name", m_szUserName);
-	memNode.GetChild("nameid", m_szUserNameId);
-	memNode.GetChild("url", m_szProfileUrl);
-	memNode.GetChild("urledit", m_szProfileEditUrl);
+		memNode.GetChild("admin", m_bAdmin);
+		memNode.GetChild("name", m_szUserName);
+		memNode.GetChild("nameid", m_szUserNameId);
+		memNode.GetChild("url", m_szProfileUrl);
+		memNode.GetChild("urledit", m_szProfileEditUrl);
+	};
 
 	if (bTestOnly)
-		return;
-
-	initPipe();
-
-#ifdef WIN32
-	auto fixFolderPermissions = [this](const char* strName, const char* szPath)
 	{
 		try
 		{
-			if (getServiceMain())
-				getServiceMain()->fixFolderPermissions(szPath);
-		}
-		catch (gcException* e)
-		{
-			Warning("Failed to set {0} path to be writeable: {1}", strName, e);
+			webLogin();
 		}
 		catch (...)
 		{
-			Warning("Failed to set {0} path to be writeable: (Unknown error)", strName);
+			if (bBadLogin)
+				logOut();
+
+			throw;
 		}
+
+		return;
+	}
+
+	//Local db reads dont need to know who the user is so they overlap the web call, everything
+	//else waits on the steps it uses. Steps are forced onto their own threads so queued tasks
+	//cant hold up login.
+	::Thread::TaskGraph graph("Login");
+
+	auto isCancelled = [&graph]()
+	{
+		return graph.isCancelled();
 	};
 
-	gcString appDataPath = UTIL::OS::getAppDataPath();
-	fixFolderPermissions("AppData", appDataPath.c_str());
+	auto loadTools = graph.addTask("Load tools", [this, isCancelled]()
+	{
+		m_pToolManager->loadItems(isCancelled);
+	});
 
-	try
+	auto readItems = graph.addTask("Read item db", [this, isCancelled]()
 	{
-		testMcfCache();
-	}
-	catch (...)
+		m_pItemManager->preloadItems(isCancelled);
+	});
+
+	//Without a user the local reads are wasted, so a failed login stops them instead of waiting them out
+	auto login = graph.addTask("Web login", [&graph, &webLogin]()
+	{
+		try
+		{
+			webLogin();
+		}
+		catch (...)
+		{
+			graph.cancel();
+			throw;
+		}
+	});
+
+	auto connectService = graph.addTask("Connect service", [this]()
 	{
-		fixFolderPermissions("Mcf Cache", m_szMcfCachePath.c_str());
+		initPipe();
+
+#ifdef WIN32
+		auto fixFolderPermissions = [this](const char* strName, const char* szPath)
+		{
+			try
+			{
+				if (getServiceMain())
+					getServiceMain()->fixFolderPermissions(szPath);
+			}
+			catch (gcException* e)
+			{
+				Warning("Failed to set {0} path to be writeable: {1}", strName, e);
+			}
+			catch (...)
+			{
+				Warning("Failed to set {0} path to be writeable: (Unknown error)", strName);
+			}
+		};
+
+		gcString appDataPath = UTIL::OS::getAppDataPath();
+		fixFolderPermissions("AppData", appDataPath.c_str());
 
 		try
 		{
@@ -230,56 +287,97 @@ void User::doLogIn(const char* user, const char* pass, bool bTestOnly)
 		}
 		catch (...)
 		{
+			fixFolderPermissions("Mcf Cache", m_szMcfCachePath.c_str());
+
+			try
+			{
+				testMcfCache();
+			}
+			catch (...)
+			{
+			}
 		}
-	}
 #endif
+	}, { login });
 
-	gcString szAvatar;
-	memNode.GetChild("avatar", szAvatar);
+	//Building items starts standalone migrations and checks mcf cache paths, which need the service
+	//and the folder fixes it does on windows, same order as before the graph
+	auto loadItems = graph.addTask("Load items", [this]()
+	{
+		m_pItemManager->loadItems();
+	}, { readItems, login, connectService });
 
-	m_szAvatarUrl = szAvatar;
-	m_pThreadPool->queueTask(gcRefPtr<UserCore::Task::DownloadAvatarTask>::create(this, szAvatar.c_str(), m_iUserId) );
+	graph.addTask("Queue avatar", [this, &memNode]()
+	{
+		gcString szAvatar;
+		memNode.GetChild("avatar", szAvatar);
 
+		m_szAvatarUrl = szAvatar;
+		m_pThreadPool->queueTask(gcRefPtr<UserCore::Task::DownloadAvatarTask>::create(this, szAvatar.c_str(), m_iUserId) );
+	}, { login });
 
-	auto msgNode = memNode.FirstChildElement("messages");
-	if (msgNode.IsValid())
+	auto parseLogin = graph.addTask("Parse login", [this, &memNode, &version]()
 	{
-		msgNode.GetChild("updates", m_iUpdates);
-		msgNode.GetChild("privatemessages", m_iPms);
-		msgNode.GetChild("cart", m_iCartItems);
-		msgNode.GetChild("threadwatch", m_iThreads);
-	}
+		auto msgNode = memNode.FirstChildElement("messages");
+		if (msgNode.IsValid())
+		{
+			msgNode.GetChild("updates", m_iUpdates);
+			msgNode.GetChild("privatemessages", m_iPms);
+			msgNode.GetChild("cart", m_iCartItems);
+			msgNode.GetChild("threadwatch", m_iThreads);
+		}
 
-	m_pToolManager->loadItems();
-	m_pItemManager->loadItems();
+		if (m_bDelayLoading)
+		{
+			//do nothing as the update thread will grab it
+		}
+		else if (version == 2)
+		{
+			m_pItemManager->parseLoginXml2(memNode.FirstChildElement("games"), memNode.FirstChildElement("platforms"));
+		}
+		else
+		{
+			m_pItemManager->parseLoginXml(memNode.FirstChildElement("games"), memNode.FirstChildElement("developer"));
+		}
+
+		auto newsNode = memNode.FirstChildElement("news");
+		if (newsNode.IsValid())
+			parseNews(newsNode);
 
-	if (m_bDelayLoading)
+		auto giftsNode = memNode.FirstChildElement("gifts");
+		if (giftsNode.IsValid())
+			parseGifts(giftsNode);
+	}, { loadTools, loadItems, connectService });
+
+	graph.addTask("Start update thread", [this]()
 	{
-		//do nothing as the update thread will grab it
-	}
-	else if (version == 2)
+		m_pUThread = m_pThreadManager->newUpdateThread(&onForcePollEvent, m_bDelayLoading);
+		m_pUThread->start();
+	}, { parseLogin });
+
+#ifdef WIN32
+	graph.addTask("Load game explorer", [this]()
 	{
-		m_pItemManager->parseLoginXml2(memNode.FirstChildElement("games"), memNode.FirstChildElement("platforms"));
-	}
-	else
+		m_pGameExplorerManager->loadItems();
+	}, { parseLogin });
+#endif
+
+	try
 	{
-		m_pItemManager->parseLoginXml(memNode.FirstChildElement("games"), memNode.FirstChildElement("developer"));
+		graph.run(m_pThreadPool);
 	}
+	catch (...)
+	{
+		Warning("{0}", graph.getReport());
 
-	auto newsNode = memNode.FirstChildElement("news");
-	if (newsNode.IsValid())
-		parseNews(newsNode);
-
-	auto giftsNode = memNode.FirstChildElement("gifts");
-	if (giftsNode.IsValid())
-		parseGifts(giftsNode);
+		//every step has stopped now so it is safe to tear down what they started
+		if (bBadLogin)
+			logOut();
 
-	m_pUThread = m_pThreadManager->newUpdateThread(&onForcePollEvent, m_bDelayLoading);
-	m_pUThread->start();
+		throw;
+	}
 
-#ifdef WIN32
-	m_pGameExplorerManager->loadItems();
-#endif
+	Msg("{0}", graph.getReport());
 
 	if (getServiceMain())
 		getServiceMain()->updateShortCuts();
@@ -37,8 +37,8 @@ void ImageCache::loadFromDb()
 {
 	try
 	{
-		sqlite3x::sqlite3_connection db(getWebCoreDb(m_szAppDataPath.c_str()).c_str());
-		sqlite3x::sqlite3_command cmd(db, "SELECT * FROM imagecache WHERE ttl > DATETIME('NOW');");
+		sqlite3x::sqlite3_pooled_connection db(getWebCoreDb(m_szAppDataPath.c_str()));
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT * FROM imagecache WHERE ttl > DATETIME('NOW');");
 		sqlite3x::sqlite3_reader reader = cmd.executereader();
 
 		while (reader.read())
@@ -55,13 +55,12 @@ void ImageCache::saveToDb()
 {
 	try
 	{
-		std::string dbLoc = getWebCoreDb(m_szAppDataPath.c_str());
-		sqlite3x::sqlite3_connection db(dbLoc.c_str());
+		sqlite3x::sqlite3_pooled_connection db(getWebCoreDb(m_szAppDataPath.c_str()));
 		//sqlite3x::sqlite3_transaction trans(db);
 
 		for (size_t x=0; x<m_vUpdateList.size(); x++)
 		{
-			sqlite3x::sqlite3_command cmd(db, "REPLACE INTO imagecache (path, hash, ttl) VALUES (?, ?, DATETIME('NOW', '+5 day'));");
+			sqlite3x::sqlite3_command &cmd = db.command("REPLACE INTO imagecache (path, hash, ttl) VALUES (?, ?, DATETIME('NOW', '+5 day'));");
 
 			cmd.bind(1, UTIL::OS::getRelativePath(m_mImageMap[m_vUpdateList[x]]));
 			cmd.bind(2, (int)m_vUpdateList[x]);
@@ -65,6 +65,7 @@ WebCoreClass::WebCoreClass()
 WebCoreClass::~WebCoreClass()
 {
 	m_ImageCache.saveToDb();
+	sqlite3x::closepooledconnections(getWebCoreDb(m_szAppDataPath.c_str()).c_str());
 }
 
 void WebCoreClass::enableDebugging(bool state)
@@ -214,7 +215,7 @@ void WebCoreClass::clearNameCache()
 {
 	try
 	{
-		sqlite3x::sqlite3_connection db(getWebCoreDb(m_szAppDataPath.c_str()).c_str());
+		sqlite3x::sqlite3_pooled_connection db(getWebCoreDb(m_szAppDataPath.c_str()));
 		db.executenonquery("DELETE FROM namecache");
 	}
 	catch (std::exception &ex)
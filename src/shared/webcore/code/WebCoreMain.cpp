@@ -96,6 +96,10 @@ CEXPORT void* FactoryBuilder(const char* name)
 	{
 		return (void*)&genUserAgent;
 	}
+	else if (strcmp(WEBCORE_BANDWIDTHLIMITER, name) == 0)
+	{
+		return (void*)&UTIL::WEB::SetBandwidthLimiter;
+	}
 
 	return nullptr;
 }
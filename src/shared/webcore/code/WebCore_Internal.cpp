@@ -146,10 +146,11 @@ DesuraId WebCoreClass::nameToId(const char* name, const char* type)
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(getWebCoreDb(m_szAppDataPath.c_str()).c_str());
-		gcString q("select internalid from namecache where nameid='{0}' and ttl > DATETIME('NOW');",  hash);
+		sqlite3x::sqlite3_pooled_connection db(getWebCoreDb(m_szAppDataPath.c_str()));
+		sqlite3x::sqlite3_command &cmd = db.command("select internalid from namecache where nameid=? and ttl > DATETIME('NOW');");
+		cmd.bind(1, (long long int)hash);
 
-		DesuraId id(db.executeint64(q.c_str()));
+		DesuraId id(cmd.executeint64());
 		if (id.isOk())
 			return id;
 	}
@@ -182,9 +183,11 @@ DesuraId WebCoreClass::nameToId(const char* name, const char* type)
 		{
 			try
 			{
-				sqlite3x::sqlite3_connection db(getWebCoreDb(m_szAppDataPath.c_str()).c_str());
-				gcString q("replace into namecache (internalid, nameid, ttl) values ('{0}','{1}', DATETIME('NOW', '+5 day'));", id.toInt64(), hash);
-				db.executenonquery(q.c_str());
+				sqlite3x::sqlite3_pooled_connection db(getWebCoreDb(m_szAppDataPath.c_str()));
+				sqlite3x::sqlite3_command &cmd = db.command("replace into namecache (internalid, nameid, ttl) values (?,?, DATETIME('NOW', '+5 day'));");
+				cmd.bind(1, (long long int)id.toInt64());
+				cmd.bind(2, (long long int)hash);
+				cmd.executenonquery();
 			}
 			catch(std::exception &ex)
 			{
@@ -206,9 +209,11 @@ DesuraId WebCoreClass::hashToId(const char* itemHashId)
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(getWebCoreDb(m_szAppDataPath.c_str()).c_str());
-		gcString q("select internalid from namecache where hashid='{0}' and ttl > DATETIME('NOW');", UTIL::MISC::RSHash_CSTR(itemHashId) );
-		DesuraId id(db.executeint(q.c_str()));
+		sqlite3x::sqlite3_pooled_connection db(getWebCoreDb(m_szAppDataPath.c_str()));
+		sqlite3x::sqlite3_command &cmd = db.command("select internalid from namecache where hashid=? and ttl > DATETIME('NOW');");
+		cmd.bind(1, (long long int)UTIL::MISC::RSHash_CSTR(itemHashId));
+
+		DesuraId id(cmd.executeint());
 
 		if (id.isOk())
 			return id;
@@ -241,9 +246,11 @@ DesuraId WebCoreClass::hashToId(const char* itemHashId)
 
 			try
 			{
-				sqlite3x::sqlite3_connection db(getWebCoreDb(m_szAppDataPath.c_str()).c_str());
-				gcString q("replace into namecache (internalid, hashid, ttl) values ('{0}','{1}', DATETIME('NOW', '+5 day'));", id.toInt64(), UTIL::MISC::RSHash_CSTR(itemHashId));
-				db.executenonquery(q.c_str());
+				sqlite3x::sqlite3_pooled_connection db(getWebCoreDb(m_szAppDataPath.c_str()));
+				sqlite3x::sqlite3_command &cmd = db.command("replace into namecache (internalid, hashid, ttl) values (?,?, DATETIME('NOW', '+5 day'));");
+				cmd.bind(1, (long long int)id.toInt64());
+				cmd.bind(2, (long long int)UTIL::MISC::RSHash_CSTR(itemHashId));
+				cmd.executenonquery();
 			}
 			catch(std::exception &ex)
 			{
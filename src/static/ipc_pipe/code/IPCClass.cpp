@@ -28,10 +28,15 @@ Contact us at legal@badjuju.com.
 #include "IPCMessage.h"
 #include "IPCManager.h"
 #include "IPCParameter.h"
+#include "util/UtilMetrics.h"
 
 
 namespace IPC
 {
+	static UTIL::METRICS::Counter &g_AsyncCalls = UTIL::METRICS::GetRegistry().counter("ipc.calls_async");
+	static UTIL::METRICS::Counter &g_FutureCalls = UTIL::METRICS::GetRegistry().counter("ipc.calls_future");
+	static UTIL::METRICS::Histogram &g_CallTime = UTIL::METRICS::GetRegistry().histogram("ipc.call_rtt_us");
+
 	typedef struct
 	{
 		char* data;
@@ -142,50 +147,54 @@ IPCParameterI* IPCClass::callFunction(const char* name, bool async, IPCParameter
 
 IPCParameterI* IPCClass::callFunction(const char* name, bool async, std::vector<IPCParameterI*> &pList)
 {
-	static gcString s_strMessage("message");
-
-	if (s_strMessage != name)
-	{
-		gcString traceName("{0}::{1}", typeid(this).name(), name);
-		TraceT(traceName.c_str(), this, "Async: {0}, ArgC: {1}", async, pList.size());
-	}
-
-	IPCFunctionCall *fch;
-
 	uint32 tsize;
 	char* data = serializeList(pList, tsize);
 
-	char* buff = new char[tsize + IPCFunctionCallSIZE];
-	fch = (IPCFunctionCall*)buff;
+	gcBuff buff(tsize + IPCFunctionCallSIZE);
+	IPCFunctionCall *fch = (IPCFunctionCall*)buff.c_ptr();
 
 	fch->size = tsize;
-	fch->functionHash = UTIL::MISC::RSHash_CSTR(name);
 	fch->numP = pList.size();
 	memcpy(&fch->data, data, tsize );
 
 	safe_delete(data);
 
+	return callFunction(name, async, fch);
+}
+
+IPCParameterI* IPCClass::callFunction(const char* name, bool async, IPCFunctionCall* fch)
+{
+	static gcString s_strMessage("message");
+
+	if (s_strMessage != name)
+	{
+		gcString traceName("{0}::{1}", typeid(this).name(), name);
+		TraceT(traceName.c_str(), this, "Async: {0}, ArgC: {1}", async, fch->numP);
+	}
+
+	fch->functionHash = UTIL::MISC::RSHash_CSTR(name);
+
 	IPCParameterI* ret = nullptr;
 
 	if (async)
 	{
 		fch->id = 0;
+		g_AsyncCalls.add();
 		this->sendMessage(MT_FUNCTIONCALL_ASYNC, (const char*)fch, sizeofStruct(fch) );
-		safe_delete(buff);
 
 		ret = new PVoid();
 	}
 	else
 	{
 		IPCScopedLock<IPCClass> lock(this, newLock());
+		UTIL::METRICS::ScopedTimer timer(g_CallTime);
 
 		fch->id = lock->id;
 
 		this->sendMessage(MT_FUNCTIONCALL, (const char*)fch, sizeofStruct(fch) );
-		safe_delete(buff);
 
 		//wait on mutex
-		if (lock->wait(30, 0))
+		if (lock->wait(IPC_CALL_TIMEOUT, 0))
 			throw gcException(ERR_IPC, "Waited too long with no response");
 
 		ret = lock->popResult();
@@ -195,6 +204,38 @@ IPCParameterI* IPCClass::callFunction(const char* name, bool async, std::vector<
 }
 
 
+void IPCClass::callFunction(const char* name, IPCFunctionCall* fch, const std::function<void(IPCParameterI*)> &fnCallback)
+{
+	static gcString s_strMessage("message");
+
+	if (s_strMessage != name)
+	{
+		gcString traceName("{0}::{1}", typeid(this).name(), name);
+		TraceT(traceName.c_str(), this, "Future, ArgC: {0}", fch->numP);
+	}
+
+	//would never get a result
+	if (m_pManager->isDisconnected())
+		throw gcException(ERR_PIPE, "Pipe Disconnected. IPC Failed.");
+
+	auto lock = newLock(fnCallback);
+
+	fch->functionHash = UTIL::MISC::RSHash_CSTR(name);
+	fch->id = lock->id;
+
+	g_FutureCalls.add();
+
+	try
+	{
+		this->sendMessage(MT_FUNCTIONCALL, (const char*)fch, sizeofStruct(fch) );
+	}
+	catch (...)
+	{
+		delLock(lock->id);
+		throw;
+	}
+}
+
 IPCParameterI* IPCClass::callLoopback(const char* name, bool async, IPCParameterI* a, IPCParameterI* b, IPCParameterI* c, IPCParameterI* d, IPCParameterI* e, IPCParameterI* f)
 {
 	std::vector<IPCParameterI*> pList;
@@ -418,6 +459,10 @@ void IPCClass::handleFunctionReturn(const char* buff, uint32 size)
 	{
 		IPCParameter* par = (IPCParameter*)&fch->data;
 		lock->trigger(getParameter(par->type, &par->data, par->size));
+
+		//no one is waiting to remove these
+		if (lock->hasCallback())
+			delLock(lock->id);
 	}
 	else
 	{
@@ -31,7 +31,9 @@ Contact us at legal@badjuju.com.
 #include "IPCParameter.h"
 #include "IPCLockable.h"
 #include "IPCMessage.h"
+#include "IPCFlatParameter.h"
 #include <atomic>
+#include <future>
 
 namespace IPC
 {
@@ -71,49 +73,8 @@ namespace IPC
 		{
 		}
 
-		template <typename A>
-		IPCParameterI* setupParam(std::vector<IPCParameterI*> &vPList, const std::vector<IPCParameter*> &vParamList, uint32 &x)
-		{
-			IPCParameterI* pParam = IPC::getParameter<A>();
-			auto msg = vParamList[x];
-
-			if (msg)
-			{
-				if (msg->type != pParam->getType())
-					gcAssert(false);
-				else
-					pParam->deserialize(&msg->data, msg->size);
-			}
-
-			vPList[x] = pParam;
-
-#ifdef __clang__
-			++x;
-#else
-			--x;
-#endif
-			return pParam;
-		}
-
-		template <typename A>
-		IPCParameterI* popElement(const std::vector<IPCParameterI*> &vPList, uint32 &x)
-		{
-#ifdef __clang__
-			size_t nPos = x;
-			++x;
-			return vPList[nPos];
-#else
-			return vPList[--x];
-#endif
-		}
-
 		template <typename ... Args>
-		void emptyTemplateFunction(Args && ... args)
-		{
-		}
-
-		template <typename ... Args>
-		IPC::IPCParameterI* processArgs(char* buff, uint32 size, uint8 numP, std::vector<IPCParameterI*> &vPList)
+		IPC::IPCParameterI* processArgs(char* buff, uint32 size, uint8 numP, FlatArgumentList<Args...> &args)
 		{
 			if (numP != sizeof...(Args))
 			{
@@ -121,38 +82,10 @@ namespace IPC
 				return IPC::newParameter(e);
 			}
 
-			std::vector<IPCParameter*> vParamList;
-
-			uint32 done = 0;
+			uint32 nFound = args.read(buff, size);
 
-			for (int x = 0; x < sizeof...(Args); ++x)
-			{
-				if (done >= size)
-				{
-					Warning("Failed to decode IPC argument {0} for {1}, not enough data.", x, m_strFunctionName);
-
-					vParamList.push_back(nullptr);
-					vPList.push_back(nullptr);
-				}
-				else
-				{
-					auto msg = (IPCParameter*)buff;
-					auto s = sizeofStruct(msg);
-
-					done += s;
-					buff += s;
-
-					vParamList.push_back(msg);
-					vPList.push_back(nullptr);
-				}
-			}
-
-#ifdef __clang__
-			uint32 x = 0;
-#else
-			uint32 x = vPList.size() - 1;
-#endif
-			emptyTemplateFunction(setupParam<Args>(vPList, vParamList, x)...);
+			if (nFound != sizeof...(Args))
+				Warning("Failed to decode IPC argument {0} for {1}, not enough data.", nFound, m_strFunctionName);
 
 			return nullptr;
 		}
@@ -174,8 +107,8 @@ namespace IPC
 
 		IPCParameterI* call(char* buff, uint32 size, uint8 numP)
 		{
-			std::vector<IPCParameterI*> vPList;
-			IPCParameterI* ret = processArgs<Args...>(buff, size, numP, vPList);
+			FlatArgumentList<Args...> args;
+			IPCParameterI* ret = processArgs(buff, size, numP, args);
 
 			if (ret)
 				return ret;
@@ -184,13 +117,7 @@ namespace IPC
 			{
 				TraceT(m_strFunctionName.c_str(), this, "");
 
-#ifdef __clang__
-				uint32 x = 0;
-#else
-				uint32 x = vPList.size();
-#endif
-				auto res = callFunction(popElement<Args>(vPList, x)...);
-
+				auto res = args.call(m_fnCallback);
 				ret = IPC::getParameter(res, true);
 			}
 			catch (gcException &e)
@@ -198,8 +125,6 @@ namespace IPC
 				ret = IPC::newParameter(e);
 			}
 
-			safe_delete(vPList);
-
 			if (!ret)
 				return IPC::getParameter<R>();
 			else
@@ -213,15 +138,7 @@ namespace IPC
 			return r;
 		}
 
-	protected:
-		template <typename ... Params>
-		R callFunction(Params&&...params)
-		{
-			return m_fnCallback(getParameterValue<Args>(params)...);
-		}
-
 	private:
-		const gcString m_strFunctionName;
 		std::function<R(Args...)> m_fnCallback;
 	};
 
@@ -238,8 +155,8 @@ namespace IPC
 
 		IPCParameterI* call(char* buff, uint32 size, uint8 numP)
 		{
-			std::vector<IPCParameterI*> vPList;
-			IPCParameterI* ret = processArgs<Args...>(buff, size, numP, vPList);
+			FlatArgumentList<Args...> args;
+			IPCParameterI* ret = processArgs(buff, size, numP, args);
 
 			if (ret)
 				return ret;
@@ -249,21 +166,13 @@ namespace IPC
 				if (m_bTrace)
 					TraceT(m_strFunctionName.c_str(), this, "");
 
-#ifdef __clang__
-				uint32 x = 0;
-#else
-				uint32 x = vPList.size();
-#endif
-				callFunction(popElement<Args>(vPList, x)...);
-
+				args.call(m_fnCallback);
 			}
 			catch (gcException &e)
 			{
-				safe_delete(vPList);
 				return IPC::newParameter(e);
 			}
 
-			safe_delete(vPList);
 			return new IPC::PVoid();
 		}
 
@@ -272,13 +181,6 @@ namespace IPC
 			return new PVoid();
 		}
 
-	protected:
-		template <typename ... Params>
-		void callFunction(Params&&...params)
-		{
-			m_fnCallback(getParameterValue<Args>(params)...);
-		}
-
 	private:
 		std::function<void(Args...)> m_fnCallback;
 	};
@@ -394,6 +296,23 @@ namespace IPC
 		//!
 		virtual IPCParameterI* callFunction(const char* name, bool async, std::vector<IPCParameterI*> &pList);
 
+		//! Calls a function on the other side of the IPC with already serialized parameters. Needs to be public due to helper function. Shouldnt be called directly
+		//!
+		//! @param name Function name
+		//! @param async Do an async function call (immediate void return)
+		//! @param fch Function call followed by its parameters. Hash and id are filled in here
+		//! @return Result
+		//!
+		IPCParameterI* callFunction(const char* name, bool async, IPCFunctionCall* fch);
+
+		//! Calls a function on the other side of the IPC without waiting for it to return. Needs to be public due to helper function. Shouldnt be called directly
+		//!
+		//! @param name Function name
+		//! @param fch Function call followed by its parameters. Hash and id are filled in here
+		//! @param fnCallback Gets the result on the IPC thread and owns it. Must not block
+		//!
+		void callFunction(const char* name, IPCFunctionCall* fch, const std::function<void(IPCParameterI*)> &fnCallback);
+
 
 		//! Calls a function on this side from IPC thread. Needs to be public due to helper function. Shouldnt be called directly
 		//!
@@ -694,7 +613,8 @@ namespace IPC
 	template <typename R, typename ... Args>
 	R functionCall(IPC::IPCClass* cl, const char* name, Args& ... args)
 	{
-		IPC::IPCParameterI* r = cl->callFunction(name, false, IPC::getParameter(args)...);
+		IPC::FlatFunctionCall<Args...> call(args...);
+		IPC::IPCParameterI* r = cl->callFunction(name, false, call.getFunctionCall());
 		return handleReturn<R>(r);
 	}
 
@@ -702,8 +622,55 @@ namespace IPC
 	template <typename ... Args>
 	void functionCallV(IPC::IPCClass* cl, const char* name, Args& ... args)
 	{
-		IPC::IPCParameterI* r = cl->callFunction(name, false, IPC::getParameter(args)...);
+		IPC::FlatFunctionCall<Args...> call(args...);
+		IPC::IPCParameterI* r = cl->callFunction(name, false, call.getFunctionCall());
+		handleReturnV(r);
+	}
+
+	template <typename R>
+	void setPromiseResult(std::promise<R> &promise, IPC::IPCParameterI* r)
+	{
+		promise.set_value(handleReturn<R>(r));
+	}
+
+	template <>
+	inline void setPromiseResult<void>(std::promise<void> &promise, IPC::IPCParameterI* r)
+	{
 		handleReturnV(r);
+		promise.set_value();
+	}
+
+	//! Calls a function on the other side without blocking. Several of these can be in
+	//! flight at once, each one is matched to its result by the call id.
+	//!
+	template <typename R, typename ... Args>
+	std::future<R> functionCallFuture(IPC::IPCClass* cl, const char* name, Args& ... args)
+	{
+		auto pPromise = std::make_shared<std::promise<R>>();
+		std::future<R> future = pPromise->get_future();
+
+		try
+		{
+			IPC::FlatFunctionCall<Args...> call(args...);
+
+			cl->callFunction(name, call.getFunctionCall(), [pPromise](IPC::IPCParameterI* r)
+			{
+				try
+				{
+					setPromiseResult(*pPromise, r);
+				}
+				catch (gcException &e)
+				{
+					pPromise->set_exception(std::make_exception_ptr(e));
+				}
+			});
+		}
+		catch (gcException &e)
+		{
+			pPromise->set_exception(std::make_exception_ptr(e));
+		}
+
+		return future;
 	}
 
 	template <typename ... Args>
@@ -711,7 +678,8 @@ namespace IPC
 	{
 		try
 		{
-			IPC::IPCParameterI* r = cl->callFunction(name, true, IPC::getParameter(args)...);
+			IPC::FlatFunctionCall<Args...> call(args...);
+			IPC::IPCParameterI* r = cl->callFunction(name, true, call.getFunctionCall());
 			handleReturnV(r);
 		}
 		catch (gcException &e)
@@ -0,0 +1,578 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_IPCFLATPARAMETER_H
+#define DESURA_IPCFLATPARAMETER_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "IPCParameter.h"
+#include "IPCMessage.h"
+#include <atomic>
+#include <tuple>
+#include <type_traits>
+
+//! Function calls with arguments up to this size are serialized without a heap allocation
+//!
+#define IPC_FLATCALL_ARENA 256
+
+namespace IPC
+{
+	//! Wire type hash of a parameter type, worked out on first use instead of on every call.
+	//!
+	//! Filled in lazily rather than by a static initializer as it can be needed while other
+	//! globals are being constructed. Threads racing on the first call all store the same value.
+	//!
+	template <typename T>
+	class ParameterType
+	{
+	public:
+		static uint32 get()
+		{
+			uint32 uiType = s_uiType.load(std::memory_order_relaxed);
+
+			if (uiType == 0)
+			{
+				uiType = IPC::getType<T>();
+				s_uiType.store(uiType, std::memory_order_relaxed);
+			}
+
+			return uiType;
+		}
+
+	private:
+		//! Zero initialized before any dynamic initialization happens
+		static std::atomic<uint32> s_uiType;
+	};
+
+	template <typename T>
+	std::atomic<uint32> ParameterType<T>::s_uiType;
+
+
+	//! Reads and writes the wire format used by the fixed size parameter classes
+	//!
+	template <typename W>
+	class FlatWire;
+
+	template <>
+	class FlatWire<bool>
+	{
+	public:
+		static const uint32 Size = 1;
+		static void write(char* szBuffer, bool bValue){ szBuffer[0] = bValue; }
+		static bool read(const char* szBuffer){ return szBuffer[0] ? true : false; }
+	};
+
+	template <>
+	class FlatWire<uint32>
+	{
+	public:
+		static const uint32 Size = 4;
+		static void write(char* szBuffer, uint32 nValue){ Uint32ToBuff(szBuffer, nValue); }
+		static uint32 read(const char* szBuffer){ return buffToUint32(szBuffer); }
+	};
+
+	template <>
+	class FlatWire<int32>
+	{
+	public:
+		static const uint32 Size = 4;
+		static void write(char* szBuffer, int32 nValue){ Uint32ToBuff(szBuffer, (uint32)nValue); }
+		static int32 read(const char* szBuffer){ return buffToInt32(szBuffer); }
+	};
+
+	template <>
+	class FlatWire<uint64>
+	{
+	public:
+		static const uint32 Size = 8;
+		static void write(char* szBuffer, uint64 nValue){ memcpy(szBuffer, &nValue, 8); }
+		static uint64 read(const char* szBuffer){ uint64 nValue; memcpy(&nValue, szBuffer, 8); return nValue; }
+	};
+
+	template <>
+	class FlatWire<double>
+	{
+	public:
+		static const uint32 Size = 8;
+		static void write(char* szBuffer, double dValue){ memcpy(szBuffer, &dValue, 8); }
+		static double read(const char* szBuffer){ double dValue; memcpy(&dValue, szBuffer, 8); return dValue; }
+	};
+
+
+
+	//! Serializes one function argument. Types without a flat writer go through the
+	//! parameter classes like before.
+	//!
+	template <typename T>
+	class FlatWriter
+	{
+	public:
+		FlatWriter(const T& t)
+			: m_pParam(IPC::getParameter(t))
+		{
+		}
+
+		~FlatWriter()
+		{
+			safe_delete(m_pParam);
+		}
+
+		uint32 getType() const { return m_pParam->getType(); }
+		uint32 getSize() const { return m_pParam->getSerializeSize(); }
+		void write(char* szBuffer) const { m_pParam->serialize(szBuffer); }
+
+	private:
+		FlatWriter(const FlatWriter&) = delete;
+		IPCParameterI* m_pParam;
+	};
+
+	//! T is the argument type, W the type it is sent as
+	//!
+	template <typename T, typename W>
+	class FlatScalarWriter
+	{
+	public:
+		FlatScalarWriter(const T& t)
+			: m_Value((W)t)
+		{
+		}
+
+		uint32 getType() const { return ParameterType<W>::get(); }
+		uint32 getSize() const { return FlatWire<W>::Size; }
+		void write(char* szBuffer) const { FlatWire<W>::write(szBuffer, m_Value); }
+
+	private:
+		W m_Value;
+	};
+
+	//! Same layout as PString, a null string is sent with no data
+	//!
+	class FlatStringWriter
+	{
+	public:
+		FlatStringWriter(const char* szValue)
+			: m_szValue(szValue)
+			, m_nLen(szValue ? strlen(szValue) : 0)
+		{
+		}
+
+		uint32 getType() const { return ParameterType<char*>::get(); }
+		uint32 getSize() const { return m_szValue ? 4 + m_nLen : 0; }
+
+		void write(char* szBuffer) const
+		{
+			if (!m_szValue)
+				return;
+
+			Uint32ToBuff(szBuffer, m_nLen);
+			memcpy(szBuffer + 4, m_szValue, m_nLen);
+		}
+
+	private:
+		const char* m_szValue;
+		uint32 m_nLen;
+	};
+
+	//! Writes the blob straight from the callers copy
+	//!
+	class FlatBlobWriter
+	{
+	public:
+		FlatBlobWriter(const PBlob& blob)
+			: m_Blob(blob)
+		{
+		}
+
+		uint32 getType() const { return ParameterType<PBlob>::get(); }
+		uint32 getSize() const { return 4 + m_Blob.getSize(); }
+
+		void write(char* szBuffer) const
+		{
+			Uint32ToBuff(szBuffer, m_Blob.getSize());
+
+			if (m_Blob.getSize() > 0)
+				memcpy(szBuffer + 4, m_Blob.getData(), m_Blob.getSize());
+		}
+
+	private:
+		const PBlob& m_Blob;
+	};
+
+	template <> class FlatWriter<bool> : public FlatScalarWriter<bool, bool> { public: FlatWriter(const bool& t) : FlatScalarWriter(t){} };
+	template <> class FlatWriter<uint8> : public FlatScalarWriter<uint8, uint32> { public: FlatWriter(const uint8& t) : FlatScalarWriter(t){} };
+	template <> class FlatWriter<uint32> : public FlatScalarWriter<uint32, uint32> { public: FlatWriter(const uint32& t) : FlatScalarWriter(t){} };
+	template <> class FlatWriter<int32> : public FlatScalarWriter<int32, int32> { public: FlatWriter(const int32& t) : FlatScalarWriter(t){} };
+	template <> class FlatWriter<uint64> : public FlatScalarWriter<uint64, uint64> { public: FlatWriter(const uint64& t) : FlatScalarWriter(t){} };
+	template <> class FlatWriter<double> : public FlatScalarWriter<double, double> { public: FlatWriter(const double& t) : FlatScalarWriter(t){} };
+	template <> class FlatWriter<char*> : public FlatStringWriter { public: FlatWriter(const char* t) : FlatStringWriter(t){} };
+	template <> class FlatWriter<const char*> : public FlatStringWriter { public: FlatWriter(const char* t) : FlatStringWriter(t){} };
+	template <> class FlatWriter<PBlob> : public FlatBlobWriter { public: FlatWriter(const PBlob& t) : FlatBlobWriter(t){} };
+
+
+
+	//! Deserializes one function argument. Types without a flat reader go through the
+	//! parameter classes like before.
+	//!
+	template <typename T>
+	class FlatReader
+	{
+	public:
+		FlatReader()
+			: m_pParam(nullptr)
+		{
+		}
+
+		~FlatReader()
+		{
+			safe_delete(m_pParam);
+		}
+
+		bool read(IPCParameter* msg)
+		{
+			m_pParam = IPC::getParameter<T>();
+
+			if (!msg)
+				return false;
+
+			if (msg->type != m_pParam->getType())
+			{
+				gcAssert(false);
+				return false;
+			}
+
+			m_pParam->deserialize(&msg->data, msg->size);
+			return true;
+		}
+
+		T get()
+		{
+			return getParameterValue<T>(m_pParam);
+		}
+
+	private:
+		FlatReader(const FlatReader&) = delete;
+		IPCParameterI* m_pParam;
+	};
+
+	template <typename T, typename W>
+	class FlatScalarReader
+	{
+	public:
+		FlatScalarReader()
+			: m_Value()
+		{
+		}
+
+		bool read(IPCParameter* msg)
+		{
+			if (!msg)
+				return false;
+
+			if (msg->type != ParameterType<W>::get())
+			{
+				gcAssert(false);
+				return false;
+			}
+
+			if (msg->size >= FlatWire<W>::Size)
+				m_Value = (T)FlatWire<W>::read(&msg->data);
+
+			return true;
+		}
+
+		T get() const
+		{
+			return m_Value;
+		}
+
+	private:
+		T m_Value;
+	};
+
+	//! Hands out a pointer into the message instead of copying the string. The
+	//! characters are moved down over the top byte of the length so they can be
+	//! terminated without touching the next parameter, so this can only read a
+	//! buffer once.
+	//!
+	template <typename T>
+	class FlatStringReader
+	{
+	public:
+		FlatStringReader()
+			: m_szValue(nullptr)
+		{
+		}
+
+		bool read(IPCParameter* msg)
+		{
+			if (!msg)
+				return false;
+
+			if (msg->type != ParameterType<char*>::get())
+			{
+				gcAssert(false);
+				return false;
+			}
+
+			if (msg->size < 4)
+				return true;
+
+			char* szData = &msg->data;
+			uint32 nLen = buffToUint32(szData);
+
+			if (nLen > msg->size - 4)
+				return true;
+
+			memmove(szData + 3, szData + 4, nLen);
+			szData[3 + nLen] = '\0';
+
+			m_szValue = szData + 3;
+			return true;
+		}
+
+		T get() const
+		{
+			return m_szValue;
+		}
+
+	private:
+		char* m_szValue;
+	};
+
+	//! Builds the blob from the message directly instead of through a PBlob parameter
+	//!
+	class FlatBlobReader
+	{
+	public:
+		FlatBlobReader()
+			: m_szData(nullptr)
+			, m_nSize(0)
+		{
+		}
+
+		bool read(IPCParameter* msg)
+		{
+			if (!msg)
+				return false;
+
+			if (msg->type != ParameterType<PBlob>::get())
+			{
+				gcAssert(false);
+				return false;
+			}
+
+			if (msg->size < 4)
+				return true;
+
+			uint32 nSize = buffToUint32(&msg->data);
+
+			if (nSize <= msg->size - 4)
+			{
+				m_szData = &msg->data + 4;
+				m_nSize = nSize;
+			}
+
+			return true;
+		}
+
+		PBlob get() const
+		{
+			return PBlob(m_szData, m_nSize);
+		}
+
+	private:
+		const char* m_szData;
+		uint32 m_nSize;
+	};
+
+	template <> class FlatReader<bool> : public FlatScalarReader<bool, bool> {};
+	template <> class FlatReader<uint8> : public FlatScalarReader<uint8, uint32> {};
+	template <> class FlatReader<uint32> : public FlatScalarReader<uint32, uint32> {};
+	template <> class FlatReader<int32> : public FlatScalarReader<int32, int32> {};
+	template <> class FlatReader<uint64> : public FlatScalarReader<uint64, uint64> {};
+	template <> class FlatReader<double> : public FlatScalarReader<double, double> {};
+	template <> class FlatReader<char*> : public FlatStringReader<char*> {};
+	template <> class FlatReader<const char*> : public FlatStringReader<const char*> {};
+	template <> class FlatReader<PBlob> : public FlatBlobReader {};
+
+
+
+	template <uint32 ... I>
+	class FlatIndexList
+	{
+	};
+
+	template <uint32 N, uint32 ... I>
+	class MakeFlatIndexList : public MakeFlatIndexList<N - 1, N - 1, I...>
+	{
+	};
+
+	template <uint32 ... I>
+	class MakeFlatIndexList<0, I...>
+	{
+	public:
+		typedef FlatIndexList<I...> type;
+	};
+
+
+	//! Serializes a function call and all of its arguments into one buffer. The writers
+	//! are picked from the argument types at compile time and small calls are built in
+	//! an inline arena.
+	//!
+	template <typename ... Args>
+	class FlatFunctionCall
+	{
+	public:
+		FlatFunctionCall(const Args& ... args)
+			: m_Writers(args...)
+			, m_szHeap(nullptr)
+		{
+			init(typename MakeFlatIndexList<sizeof...(Args)>::type());
+		}
+
+		~FlatFunctionCall()
+		{
+			safe_delete(m_szHeap);
+		}
+
+		//! Function call header followed by the arguments. The caller fills in the hash and id.
+		//!
+		IPCFunctionCall* getFunctionCall()
+		{
+			return m_pCall;
+		}
+
+	private:
+		FlatFunctionCall(const FlatFunctionCall&) = delete;
+
+		template <uint32 ... I>
+		void init(FlatIndexList<I...>)
+		{
+			const uint32 vSizes[] = { 0, (IPCParameterSIZE + std::get<I>(m_Writers).getSize())... };
+
+			uint32 vOffsets[sizeof...(Args) + 1] = { 0 };
+			uint32 nSize = 0;
+
+			for (size_t x = 0; x < sizeof...(Args); ++x)
+			{
+				vOffsets[x] = nSize;
+				nSize += vSizes[x + 1];
+			}
+
+			char* szBuffer = m_szArena;
+
+			if (IPCFunctionCallSIZE + nSize > sizeof(m_szArena))
+			{
+				m_szHeap = new char[IPCFunctionCallSIZE + nSize];
+				szBuffer = m_szHeap;
+			}
+
+			m_pCall = (IPCFunctionCall*)szBuffer;
+			m_pCall->functionHash = 0;
+			m_pCall->id = 0;
+			m_pCall->size = nSize;
+			m_pCall->numP = sizeof...(Args);
+
+			// each argument writes at its own offset so the expansion order does not matter
+			const bool vRes[] = { true, writeParam(std::get<I>(m_Writers), &m_pCall->data + vOffsets[I])... };
+			(void)vRes;
+		}
+
+		template <typename W>
+		static bool writeParam(const W& writer, char* szBuffer)
+		{
+			IPCParameter* pParam = (IPCParameter*)szBuffer;
+
+			pParam->type = writer.getType();
+			pParam->size = writer.getSize();
+			writer.write(&pParam->data);
+
+			return true;
+		}
+
+		std::tuple<FlatWriter<typename std::decay<Args>::type>...> m_Writers;
+
+		IPCFunctionCall* m_pCall;
+		char* m_szHeap;
+		char m_szArena[IPC_FLATCALL_ARENA];
+	};
+
+
+	//! Deserializes the arguments of a function call in place and calls the callback
+	//! with them.
+	//!
+	template <typename ... Args>
+	class FlatArgumentList
+	{
+	public:
+		//! Reads the arguments out of the buffer
+		//!
+		//! @return Number of arguments found in the buffer
+		//!
+		uint32 read(char* buff, uint32 size)
+		{
+			IPCParameter* vParams[sizeof...(Args) + 1] = { nullptr };
+
+			uint32 done = 0;
+			uint32 nFound = 0;
+
+			for (; nFound < sizeof...(Args); ++nFound)
+			{
+				if (done >= size)
+					break;
+
+				auto msg = (IPCParameter*)(buff + done);
+
+				vParams[nFound] = msg;
+				done += sizeofStruct(msg);
+			}
+
+			readAll(vParams, typename MakeFlatIndexList<sizeof...(Args)>::type());
+			return nFound;
+		}
+
+		template <typename R>
+		R call(const std::function<R(Args...)> &fnCallback)
+		{
+			return callAll(fnCallback, typename MakeFlatIndexList<sizeof...(Args)>::type());
+		}
+
+	private:
+		template <uint32 ... I>
+		void readAll(IPCParameter** vParams, FlatIndexList<I...>)
+		{
+			const bool vRes[] = { true, std::get<I>(m_Readers).read(vParams[I])... };
+			(void)vRes;
+		}
+
+		template <typename R, uint32 ... I>
+		R callAll(const std::function<R(Args...)> &fnCallback, FlatIndexList<I...>)
+		{
+			return fnCallback(std::get<I>(m_Readers).get()...);
+		}
+
+		std::tuple<FlatReader<typename std::decay<Args>::type>...> m_Readers;
+	};
+}
+
+#endif //DESURA_IPCFLATPARAMETER_H
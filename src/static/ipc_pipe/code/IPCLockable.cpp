@@ -29,6 +29,17 @@ using namespace IPC;
 
 IPCLock::IPCLock(uint32 i)
 	: id(i)
+	, m_bHasCallback(false)
+	, m_InternalLock()
+	, m_WaitCond()
+{
+}
+
+IPCLock::IPCLock(uint32 i, const std::function<void(IPCParameterI*)> &fnCallback, uint32 nTimeoutMs)
+	: id(i)
+	, m_bHasCallback(true)
+	, m_fnCallback(fnCallback)
+	, m_tExpires(std::chrono::steady_clock::now() + std::chrono::milliseconds(nTimeoutMs))
 	, m_InternalLock()
 	, m_WaitCond()
 {
@@ -61,6 +72,24 @@ bool IPCLock::wait(int sec, int milli)
 
 void IPCLock::trigger(IPCParameterI* pParameter)
 {
+	if (m_bHasCallback)
+	{
+		std::function<void(IPCParameterI*)> fnCallback;
+
+		{
+			std::lock_guard<std::mutex> guard(m_InternalLock);
+			std::swap(fnCallback, m_fnCallback);
+		}
+
+		//result and cancel can race, only the first one counts
+		if (fnCallback)
+			fnCallback(pParameter);
+		else
+			safe_delete(pParameter);
+
+		return;
+	}
+
 	std::lock_guard<std::mutex> guard(m_InternalLock);
 
 	gcAssert(!m_pResult);
@@ -84,12 +113,16 @@ IPCParameterI* IPCLock::popResult()
 IPCLockable::IPCLockable()
 : m_lockMutex()
 , m_uiIdCount(0)
+, m_nCallbackTimeoutMs(IPC_CALL_TIMEOUT * 1000)
 , m_vLockList()
 {
 }
 
 IPCLockable::~IPCLockable()
 {
+	gcException e(ERR_IPC, "IPC class was destroyed before the call returned");
+	cancelLocks(e);
+
 	std::lock_guard<std::mutex> guard(m_lockMutex);
 	gcAssert(m_vLockList.empty());
 }
@@ -100,6 +133,36 @@ void IPCLockable::cancelLocks(gcException &reason)
 
 	for (auto l : m_vLockList)
 		l->trigger(newParameterS(reason));
+
+	//no one is waiting on callback locks to remove them
+	auto it = std::remove_if(begin(m_vLockList), end(m_vLockList), [](std::shared_ptr<IPCLock> &lock){
+		return lock->hasCallback();
+	});
+
+	m_vLockList.erase(it, end(m_vLockList));
+}
+
+void IPCLockable::expireLocks()
+{
+	std::vector<std::shared_ptr<IPCLock>> vExpired;
+
+	{
+		std::lock_guard<std::mutex> guard(m_lockMutex);
+
+		auto now = std::chrono::steady_clock::now();
+		auto it = std::partition(begin(m_vLockList), end(m_vLockList), [now](std::shared_ptr<IPCLock> &lock){
+			return !lock->hasExpired(now);
+		});
+
+		vExpired.assign(it, end(m_vLockList));
+		m_vLockList.erase(it, end(m_vLockList));
+	}
+
+	gcException e(ERR_IPC, "Waited too long with no response");
+
+	//a late result wont find the lock anymore and gets dropped
+	for (auto l : vExpired)
+		l->trigger(newParameterS(e));
 }
 
 std::shared_ptr<IPCLock> IPCLockable::newLock()
@@ -112,6 +175,16 @@ std::shared_ptr<IPCLock> IPCLockable::newLock()
 	return lock;
 }
 
+std::shared_ptr<IPCLock> IPCLockable::newLock(const std::function<void(IPCParameterI*)> &fnCallback)
+{
+	auto lock = std::make_shared<IPCLock>(++m_uiIdCount, fnCallback, m_nCallbackTimeoutMs);
+
+	std::lock_guard<std::mutex> guard(m_lockMutex);
+	m_vLockList.push_back(lock);
+
+	return lock;
+}
+
 void IPCLockable::delLock(uint32 id)
 {
 	std::lock_guard<std::mutex> guard(m_lockMutex);
@@ -29,6 +29,11 @@ Contact us at legal@badjuju.com.
 #include "IPCParameter.h"
 
 #include <atomic>
+#include <chrono>
+
+//! Seconds a call can go without a response before it fails, same for blocking and future calls
+//!
+#define IPC_CALL_TIMEOUT 30
 
 namespace IPC
 {
@@ -39,6 +44,14 @@ namespace IPC
 	{
 	public:
 		IPCLock(uint32 i);
+
+		//! Lock that hands the result to a callback instead of waking a waiting thread
+		//!
+		//! @param i Lock id
+		//! @param fnCallback Gets called once with the result and takes ownership of it
+		//! @param nTimeoutMs Time after which IPCLockable::expireLocks fails the call
+		//!
+		IPCLock(uint32 i, const std::function<void(IPCParameterI*)> &fnCallback, uint32 nTimeoutMs);
 		~IPCLock();
 
 		void wait();
@@ -49,11 +62,25 @@ namespace IPC
 		void trigger(IPCParameterI* pParameter);
 		IPCParameterI* popResult();
 
+		bool hasCallback() const
+		{
+			return m_bHasCallback;
+		}
+
+		bool hasExpired(std::chrono::steady_clock::time_point now) const
+		{
+			return m_bHasCallback && now >= m_tExpires;
+		}
+
 		const uint32 id;
 
 	private:
 		IPCParameterI* m_pResult = nullptr;
 
+		const bool m_bHasCallback;
+		std::function<void(IPCParameterI*)> m_fnCallback;
+		std::chrono::steady_clock::time_point m_tExpires;
+
         std::atomic<bool> m_bTriggered = {false};
 		Thread::WaitCondition m_WaitCond;
 		std::mutex m_InternalLock;
@@ -101,15 +128,28 @@ namespace IPC
 
 		void cancelLocks(gcException &reason);
 
+		//! Fails callback locks that have waited longer than their timeout
+		//!
+		void expireLocks();
+
+		//! Sets how long new callback locks wait for a result, defaults to IPC_CALL_TIMEOUT
+		//!
+		void setCallbackTimeout(uint32 nTimeoutMs)
+		{
+			m_nCallbackTimeoutMs = nTimeoutMs;
+		}
+
 	protected:
 		void delLock(uint32 id);
 		std::shared_ptr<IPCLock> newLock();
+		std::shared_ptr<IPCLock> newLock(const std::function<void(IPCParameterI*)> &fnCallback);
 		std::shared_ptr<IPCLock> findLock(uint32 id);
 
 	private:
 		template <class T> friend class IPCScopedLock;
 
 		std::atomic<uint32> m_uiIdCount;
+		std::atomic<uint32> m_nCallbackTimeoutMs;
 		std::vector<std::shared_ptr<IPCLock>> m_vLockList;
 		std::mutex m_lockMutex;
 	};
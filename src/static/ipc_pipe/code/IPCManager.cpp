@@ -25,10 +25,19 @@ Contact us at legal@badjuju.com.
 #include "IPCClass.h"
 #include "IPCParameter.h"
 #include "IPCPipeBase.h"
+#include "util/UtilMetrics.h"
+
+#ifdef NIX
+#include "IPCSharedPayload.h"
+#endif
 
 namespace IPC
 {
 
+static UTIL::METRICS::Counter &g_MessagesSent = UTIL::METRICS::GetRegistry().counter("ipc.messages_sent");
+static UTIL::METRICS::Counter &g_BytesSent = UTIL::METRICS::GetRegistry().counter("ipc.bytes_sent");
+static UTIL::METRICS::Counter &g_MessagesRecv = UTIL::METRICS::GetRegistry().counter("ipc.messages_recv");
+static UTIL::METRICS::Counter &g_SharedPayloads = UTIL::METRICS::GetRegistry().counter("ipc.shared_payloads");
 
 std::map<uint32, newClassFunc> *g_pmIPCClassList = nullptr;
 
@@ -122,6 +131,16 @@ public:
 		m_WaitCond.notify();
 	}
 
+	//! Queues a message whose buffer is already owned, so it is used in place instead of copied
+	void newMessage(std::shared_ptr<IPCClass> ipcClass, uint32 type, std::shared_ptr<char> buffer, uint32 size)
+	{
+		gcAssert(ipcClass);
+
+		std::lock_guard<std::mutex> guard(m_mVectorMutex);
+		m_vItemList.emplace_back(ipcClass, type, std::move(buffer), size);
+		m_WaitCond.notify();
+	}
+
 	void purgeEvents(uint32 uId)
 	{
 		std::lock_guard<std::mutex> guard(m_mVectorMutex);
@@ -171,6 +190,14 @@ protected:
 			}
 		}
 
+		ProcessData(std::weak_ptr<IPCClass> c, uint32 t, std::shared_ptr<char> b, uint32 s)
+			: pClass(c)
+			, buff(std::move(b))
+			, buffsize(s)
+			, type(t)
+		{
+		}
+
 		std::weak_ptr<IPCClass> pClass;
 		std::shared_ptr<char> buff;
 		uint32 buffsize = 0;
@@ -243,6 +270,12 @@ IPCManager::IPCManager(LoopbackProcessor* loopbackProcessor, uint32 managerId, c
 	, m_vPipeMsgs()
 	, onDisconnectEvent()
 	, onNeedAuthEvent()
+#ifdef NIX
+	, m_uiSharedPayloadThreshold(IPC_SHAREDPAYLOAD_THRESHOLD)
+#else
+	, m_uiSharedPayloadThreshold(0)
+#endif
+	, m_setSharedPayloads()
 {
 	if (isServer)
 		m_mClassId = 1;
@@ -271,6 +304,18 @@ IPCManager::~IPCManager()
 	{
 		gcAssert(c.unique());
 	}
+
+#ifdef NIX
+	{
+		std::lock_guard<std::mutex> guard(m_SharedPayloadLock);
+
+		for (auto &name : m_setSharedPayloads)
+			SharedPayload::Remove(name.c_str());
+	}
+#endif
+
+	std::lock_guard<std::mutex> guard(m_mVectorMutex);
+	safe_delete(m_vPipeMsgs);
 }
 
 std::shared_ptr<IPCClass> IPCManager::createClass(const char* name)
@@ -428,6 +473,22 @@ void IPCManager::processInternalMessage(uint8 type, const char* buff, uint32 siz
 			Warning("Failed to process create class return.\n");
 		}
 	}
+#ifdef NIX
+	else if (type == MT_SHAREDPAYLOAD_ACK)
+	{
+		if (size != IPCSharedPayloadRefSIZE)
+			return;
+
+		char name[sizeof(IPCSharedPayloadRef::name) + 1] = {0};
+		memcpy(name, ((IPCSharedPayloadRef*)buff)->name, sizeof(IPCSharedPayloadRef::name));
+
+		std::lock_guard<std::mutex> guard(m_SharedPayloadLock);
+
+		//Only names we sent, the receiver already removed it unless opening failed
+		if (m_setSharedPayloads.erase(name) != 0)
+			SharedPayload::Remove(name);
+	}
+#endif
 }
 
 
@@ -508,6 +569,14 @@ void IPCManager::recvMessage(IPCMessage* msg)
 	if (!msg)
 		return;
 
+	g_MessagesRecv.add();
+
+	if (msg->totparts == IPC_SHAREDPAYLOAD_PARTS)
+	{
+		recvSharedMessage(msg);
+		return;
+	}
+
 	if (msg->totparts != 1)
 	{
 		std::lock_guard<std::mutex> guard(m_PartLock);
@@ -522,6 +591,47 @@ void IPCManager::recvMessage(IPCMessage* msg)
 		return;
 	}
 
+	dispatchMessage(msg->id, msg->type, &msg->data, msg->size);
+}
+
+void IPCManager::recvSharedMessage(IPCMessage* msg)
+{
+#ifdef NIX
+	if (msg->size != IPCSharedPayloadRefSIZE)
+	{
+		Warning("Invalid shared ipc payload for class {0}\n", msg->id);
+		return;
+	}
+
+	auto payload = std::make_shared<SharedPayload>();
+	bool bOpened = payload->open(*(IPCSharedPayloadRef*)&msg->data);
+
+	//Let the sender stop tracking the segment either way
+	try
+	{
+		sendMessage(&msg->data, IPCSharedPayloadRefSIZE, 0, MT_SHAREDPAYLOAD_ACK);
+	}
+	catch (gcException &e)
+	{
+		Warning("Failed to ack shared ipc payload: {0}\n", e);
+	}
+
+	if (!bOpened)
+	{
+		Warning("Failed to open shared ipc payload for class {0}\n", msg->id);
+		return;
+	}
+
+	//Queued messages share ownership of the mapping so they read it in place
+	std::shared_ptr<char> data(payload, payload->getData());
+	dispatchMessage(msg->id, msg->type, payload->getData(), payload->getSize(), data);
+#else
+	Warning("Shared ipc payloads are not supported on this platform\n");
+#endif
+}
+
+void IPCManager::dispatchMessage(uint32 id, uint8 type, const char* buff, uint32 size, std::shared_ptr<char> owner)
+{
 	{
 		std::lock_guard<std::mutex> guard(m_ClassMutex);
 
@@ -532,26 +642,26 @@ void IPCManager::recvMessage(IPCMessage* msg)
 		m_vClassDelList.erase(it, end(m_vClassDelList));
 	}
 
-	if (msg->id == 0)
+	if (id == 0)
 	{
-		processInternalMessage(msg->type, &msg->data, msg->size);
+		processInternalMessage(type, buff, size);
 	}
 	else
 	{
-		if (msg->type == MT_FUNCTIONRETURN)
+		if (type == MT_FUNCTIONRETURN)
 		{
-			auto pClass = findClass(msg->id);
-			pClass->messageRecived(msg->type, &msg->data, msg->size);
+			auto pClass = findClass(id);
+			pClass->messageRecived(type, buff, size);
 		}
 		else
 		{
 			// as event callbacks often block we need to offload them to another thread
-			auto pClass = findClass(msg->id);
+			auto pClass = findClass(id);
 
 			if (!pClass)
 				return;
 
-			if (msg->type == MT_EVENTTRIGGER || msg->type == MT_KILL_COMPLETE || msg->type == MT_KILL)
+			if (type == MT_EVENTTRIGGER || type == MT_KILL_COMPLETE || type == MT_KILL)
 			{
 				if (!m_pEventThread)
 				{
@@ -560,10 +670,13 @@ void IPCManager::recvMessage(IPCMessage* msg)
 					m_pEventThread->start();
 				}
 
-				m_pEventThread->newMessage(pClass, msg->type, &msg->data, msg->size);
+				if (owner)
+					m_pEventThread->newMessage(pClass, type, owner, size);
+				else
+					m_pEventThread->newMessage(pClass, type, buff, size);
 			}
 
-			if (msg->type != MT_EVENTTRIGGER)
+			if (type != MT_EVENTTRIGGER)
 			{
 				if (!m_pCallThread)
 				{
@@ -572,7 +685,10 @@ void IPCManager::recvMessage(IPCMessage* msg)
 					m_pCallThread->start();
 				}
 
-				m_pCallThread->newMessage(pClass, msg->type, &msg->data, msg->size);
+				if (owner)
+					m_pCallThread->newMessage(pClass, type, owner, size);
+				else
+					m_pCallThread->newMessage(pClass, type, buff, size);
 			}
 		}
 	}
@@ -672,6 +788,9 @@ void IPCManager::sendMessage(const char* buff, uint32 size, uint32 id, uint8 typ
 
 	uint64 serial = ++m_nMsgSerial;
 
+	g_MessagesSent.add();
+	g_BytesSent.add(size);
+
 	auto createMessage = [id, type, serial](const char* buff, uint32 size, uint8 part, uint8 totparts)
 	{
 		auto pm = new PipeMessage(IPCMessageSIZE + size);
@@ -689,35 +808,56 @@ void IPCManager::sendMessage(const char* buff, uint32 size, uint32 id, uint8 typ
 		return pm;
 	};
 
-	std::vector<std::pair<uint32, const char*>> vMsgParts;
-
-	auto tbuff = buff;
+#ifdef NIX
+	IPCSharedPayloadRef ref;
 
-	do
+	//One copy into shared memory instead of a copy per part on each side of the pipe
+	if (m_uiSharedPayloadThreshold != 0 && size >= m_uiSharedPayloadThreshold && SharedPayload::Create(buff, size, ref))
 	{
-		auto s = size;
+		g_SharedPayloads.add();
 
-		if (s > (BUFSIZE - IPCMessageSIZE))
-			s = BUFSIZE - IPCMessageSIZE;
+		auto pm = createMessage((const char*)&ref, IPCSharedPayloadRefSIZE, 0, IPC_SHAREDPAYLOAD_PARTS);
 
-		vMsgParts.push_back(std::make_pair(s, tbuff));
+		//Tracked until the receiver sends MT_SHAREDPAYLOAD_ACK back
+		{
+			std::lock_guard<std::mutex> guard(m_SharedPayloadLock);
+			m_setSharedPayloads.insert(ref.name);
+		}
 
-		size -= s;
-		tbuff += s;
+		std::lock_guard<std::mutex> guard(m_mVectorMutex);
+		m_vPipeMsgs.push_back(pm);
 	}
-	while (size > 0);
+	else
+#endif
+	{
+		std::vector<std::pair<uint32, const char*>> vMsgParts;
 
-	int x = 0;
+		auto tbuff = buff;
 
-	for (auto p : vMsgParts)
-	{
-		auto pm = createMessage(p.second, p.first, x, vMsgParts.size());
-		++x;
+		do
+		{
+			auto s = size;
+
+			if (s > (BUFSIZE - IPCMessageSIZE))
+				s = BUFSIZE - IPCMessageSIZE;
+
+			vMsgParts.push_back(std::make_pair(s, tbuff));
+
+			size -= s;
+			tbuff += s;
+		}
+		while (size > 0);
+
+		int x = 0;
 
 		std::lock_guard<std::mutex> guard(m_mVectorMutex);
-		m_vPipeMsgs.push_back(pm);
-	}
 
+		for (auto p : vMsgParts)
+		{
+			m_vPipeMsgs.push_back(createMessage(p.second, p.first, x, vMsgParts.size()));
+			++x;
+		}
+	}
 
 #ifdef WIN32
 	if (m_hEvent != INVALID_HANDLE_VALUE)
@@ -764,29 +904,32 @@ void IPCManager::sendLoopbackMessage(const char* buff, uint32 size, uint32 id, u
 
 bool IPCManager::getMessageToSend(char* buffer, uint32 buffSize, uint32& msgSize)
 {
-	PipeMessage *msg = nullptr;
+	msgSize = 0;
 
-	m_mVectorMutex.lock();
-	if (m_vPipeMsgs.size() > 0)
+	std::lock_guard<std::mutex> guard(m_mVectorMutex);
+
+	while (!m_vPipeMsgs.empty())
 	{
-		msg = m_vPipeMsgs.front();
-		m_vPipeMsgs.erase(m_vPipeMsgs.begin());
-	}
-	m_mVectorMutex.unlock();
+		PipeMessage *msg = m_vPipeMsgs.front();
+		uint32 size = msg->getSize();
 
-	if (!msg)
-		return false;
+		if (msgSize + size > buffSize)
+		{
+			if (msgSize != 0)
+				break;
 
-	msgSize = msg->getSize();
+			gcAssert(size <= buffSize);
+			size = buffSize;
+		}
 
-	gcAssert(msgSize <= buffSize);
-	uint32 cpysize = (msgSize > buffSize)?buffSize:msgSize;
-	msgSize = cpysize;
+		memcpy(buffer + msgSize, msg->getBuffer(), size);
+		msgSize += size;
 
-	memcpy(buffer, msg->getBuffer(), cpysize);
-	safe_delete(msg);
+		m_vPipeMsgs.pop_front();
+		safe_delete(msg);
+	}
 
-	return true;
+	return msgSize != 0;
 }
 
 void IPCManager::disconnect(bool triggerEvent)
@@ -841,6 +984,19 @@ void IPCManager::informClassesOfDisconnect()
 		c->cancelLocks(e);
 }
 
+void IPCManager::expireLocks()
+{
+	std::vector<std::shared_ptr<IPCClass>> vClassList;
+
+	{
+		std::lock_guard<std::mutex> al(m_ClassMutex);
+		vClassList = m_vClassList;
+	}
+
+	for (auto c : vClassList)
+		c->expireLocks();
+}
+
 
 #ifdef NIX
 uint32 IPCManager::getNumSendEvents()
@@ -30,6 +30,7 @@ Contact us at legal@badjuju.com.
 #include "IPCLockable.h"
 #include "IPCPipeAuth.h"
 #include <atomic>
+#include <set>
 
 #include "util_thread/BaseThread.h"
 
@@ -124,11 +125,11 @@ namespace IPC
 		//!
 		void sendLoopbackMessage(const char* buff, uint32 size, uint32 id, uint8 type) override;
 
-		//! Get a pending message to send
+		//! Get pending messages to send. Packs as many whole messages as fit into the buffer
 		//!
-		//! @param buffer Buffer to copy message into
+		//! @param buffer Buffer to copy messages into
 		//! @param buffSize Size of the buffer
-		//! @param msgSize Size of message copied into the buffer
+		//! @param msgSize Size of messages copied into the buffer
 		//!
 		bool getMessageToSend(char* buffer, uint32 buffSize, uint32& msgSize);
 
@@ -165,6 +166,10 @@ namespace IPC
 		uint32 getNumSendEvents();
 #endif
 
+		//! Fails future calls that have gone too long without a response. Called from the pipe thread
+		//!
+		void expireLocks();
+
 		//! Disconnect from the pipe
 		//!
 		//! @param triggerEvent Trigger onDisconnectEvent
@@ -210,6 +215,14 @@ namespace IPC
 			return m_bDisconnected;
 		}
 
+		//! Sets the payload size at which messages are sent through shared memory instead of
+		//! being split into pipe sized parts. Zero always uses the pipe
+		//!
+		void setSharedPayloadThreshold(uint32 size)
+		{
+			m_uiSharedPayloadThreshold = size;
+		}
+
 	protected:
 		//! Process a recvied message
 		//!
@@ -217,6 +230,18 @@ namespace IPC
 		//!
 		void recvMessage(IPCMessage* msg);
 
+		//! Process a recived message that refers to a shared memory payload
+		//!
+		//! @param msg Message to process
+		//!
+		void recvSharedMessage(IPCMessage* msg);
+
+		//! Routes a complete message to its class or the internal handler
+		//!
+		//! @param owner Optional owner of buff, queued messages keep it alive instead of copying buff
+		//!
+		void dispatchMessage(uint32 id, uint8 type, const char* buff, uint32 size, std::shared_ptr<char> owner = std::shared_ptr<char>());
+
 		//! Process a internal message
 		//!
 		//! @param type Message type
@@ -252,7 +277,7 @@ namespace IPC
 		std::vector<std::shared_ptr<IPCClass> > m_vClassList;
 		std::vector<std::shared_ptr<IPCClass> > m_vClassDelList;
 
-		std::vector<PipeMessage*> m_vPipeMsgs;
+		std::deque<PipeMessage*> m_vPipeMsgs;
 
 #ifdef WIN32
 		HANDLE m_hEvent;
@@ -278,6 +303,12 @@ namespace IPC
 		std::map<uint64, std::vector<PipeMessage*>> m_mOutstandingPartMessages;
 
 		std::shared_ptr<PendingPartRecvMessage> m_pPendingMessage;
+
+		uint32 m_uiSharedPayloadThreshold;
+
+		//! Segments sent but not acknowledged yet, removed on destruction
+		std::mutex m_SharedPayloadLock;
+		std::set<gcString> m_setSharedPayloads;
 	};
 
 	template <class T>
@@ -47,6 +47,17 @@ typedef struct
 
 #define IPCMessageSIZE 26
 
+//! totparts value for a message whose data is an IPCSharedPayloadRef instead of the payload
+#define IPC_SHAREDPAYLOAD_PARTS 0
+
+typedef struct
+{
+	uint32 size;
+	char name[32];
+} PACK IPCSharedPayloadRef;
+
+#define IPCSharedPayloadRefSIZE 36
+
 typedef struct
 {
 	uint32 functionHash;
@@ -170,6 +181,9 @@ enum MESSAGE_TYPE
 	MT_EVENTTRIGGER,
 	MT_KILL,
 	MT_KILL_COMPLETE,
+
+	//manager message, sent back with the IPCSharedPayloadRef once the segment was opened (or failed to)
+	MT_SHAREDPAYLOAD_ACK,
 };
 
 #endif //DESURA_IPCMESSAGE_H
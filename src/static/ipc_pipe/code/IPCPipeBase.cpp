@@ -118,27 +118,36 @@ void PipeBase::run()
 	{
 		processEvents();
 		processLoopback();
+		expireLocks();
+	}
+}
+
+void PipeBase::expireLocks()
+{
+	for (uint32 x=0; x<getNumManagers(); x++)
+	{
+		IPCManager* mng = getManager(x);
+
+		if (mng)
+			mng->expireLocks();
 	}
 }
 
 void PipeBase::processLoopback()
 {
+	std::deque<LoopbackInfo*> vLoopback;
+
 	m_LoopbackLock.lock();
+	vLoopback.swap(m_vLoopback);
+	m_LoopbackLock.unlock();
 
-	if (m_vLoopback.size() > 0)
+	for (auto info : vLoopback)
 	{
-		LoopbackInfo* info = m_vLoopback.front();
-		m_vLoopback.pop_front();
-
 		if (getManager(info->id))
-		{
 			getManager(info->id)->recvMessage(info->buffer, info->size);
-		}
-
-		safe_delete(info);
 	}
 
-	m_LoopbackLock.unlock();
+	safe_delete(vLoopback);
 }
 
 void PipeBase::processEvents()
@@ -28,6 +28,10 @@ Contact us at legal@badjuju.com.
 #include "util_thread/BaseThread.h"
 #include "IPCPipeHelper.h"
 
+#ifdef NIX
+#include "IPCPipeSocket_Nix.h"
+#endif
+
 namespace IPC
 {
 class IPCManager;
@@ -45,6 +49,9 @@ public:
 //! Base Class for pipe server and pipe client
 //!
 class PipeBase : public Thread::BaseThread, public LoopbackProcessor
+#ifdef NIX
+	, public SocketHandlerI
+#endif
 {
 public:
 	//! Constuctor
@@ -96,6 +103,10 @@ protected:
 	//!
 	void processLoopback();
 
+	//! Fail future calls on every manager that have waited too long
+	//!
+	void expireLocks();
+
 	//! Init pipes (for server create, for client connect)
 	//!
 	virtual void setUpPipes()=0;
@@ -106,19 +117,18 @@ protected:
 	//!
 	virtual IPCManager* getManager(uint32 index)=0;
 
-
-#ifdef WIN32
-	//! Get the pipe data for a pipe instance
+	//! Disconnect a broken pipe and reconnect it
 	//!
 	//! @param index Event index
 	//!
-	virtual PipeData* getData(uint32 index)=0;
+	virtual void disconnectAndReconnect(uint32 i)=0;
 
-	//! Disconnect a broken pipe and reconnect it
+#ifdef WIN32
+	//! Get the pipe data for a pipe instance
 	//!
 	//! @param index Event index
 	//!
-	virtual void disconnectAndReconnect(uint32 i)=0;
+	virtual PipeData* getData(uint32 index)=0;
 
 	//! Fet number of events in the event array
 	//!
@@ -137,6 +147,54 @@ protected:
 	//! Stop thread
 	//!
 	virtual void onStop();
+
+	//! Get number of managers to send messages for
+	//!
+	virtual uint32 getNumManagers()
+	{
+		return 1;
+	}
+
+	//! Get the connected socket for a manager
+	//!
+	//! @param index Manager index
+	//! @return Socket or -1 to use the send callback
+	//!
+	virtual int getSocket(uint32 index)
+	{
+		return -1;
+	}
+
+	//! Called on the pipe thread after a socket has been accepted for a manager
+	//!
+	//! @param index Manager index
+	//!
+	virtual void onSocketConnected(uint32 index)
+	{
+	}
+
+	//! Sends packets out of the socket or send callback for a manager
+	//!
+	void writeMessages(uint32 index, PipeData* pData, uint32 count);
+
+	//! Starts the epoll reader thread
+	//!
+	//! @param hListenSocket Listen socket or -1 for client
+	//!
+	void startSocketReader(int hListenSocket = -1);
+
+	//! Stops the reader thread. Must be called before sockets are closed
+	//!
+	void stopSocketReader();
+
+	//SocketHandlerI, called from the reader thread
+	int32 onSocketAccept(int hSocket, uid_t uid, pid_t pid) override
+	{
+		return -1;
+	}
+
+	void onSocketRead(uint32 tag, const char* buffer, uint32 size) override;
+	void onSocketClosed(uint32 tag) override;
 #endif
 
 
@@ -152,11 +210,45 @@ protected:
 	SendFn sendMsg;
 
 
+	enum class RecvType
+	{
+		Message,
+		Connect,
+		Disconnect,
+	};
+
+	class RecvInfo
+	{
+	public:
+		RecvInfo()
+			: type(RecvType::Message)
+			, index(0)
+			, data()
+		{
+		}
+
+		RecvType type;
+		uint32 index;
+		PipeData data;
+	};
+
+	//! Gets a recv entry from the free list or allocates a new one
+	//!
+	RecvInfo* newRecvInfo(RecvType type, uint32 index);
+
+	void queueRecv(RecvInfo* info);
+
 	std::mutex m_RecvLock;
-	std::deque<PipeData*> m_vRecvBuffer;
+	std::deque<RecvInfo*> m_vRecvBuffer;
+	std::vector<RecvInfo*> m_vFreeRecv;
+
+	//! Packets gathered per manager so they can go out in one sendmmsg
+	PipeData m_SendBatch[IPC_SEND_BATCH];
 
 	::Thread::WaitCondition m_WaitCond;
 
+	SocketReader* m_pSocketReader;
+
 #endif
 
 	std::mutex m_LoopbackLock;
@@ -24,6 +24,8 @@ Contact us at legal@badjuju.com.
 #include "IPCPipeBase.h"
 #include "IPCManager.h"
 
+#include <sys/socket.h>
+
 //prints ipc stuff to a file
 #ifdef DEBUG
 //#define IPC_DEBUG
@@ -66,6 +68,7 @@ PipeBase::PipeBase(const char* pipeName, const char* threadName)
 , m_vLoopback()
 , m_vRecvBuffer()
 , sendMsg([](void*, const char*, size_t){})
+, m_pSocketReader(nullptr)
 {
 
 }
@@ -73,6 +76,12 @@ PipeBase::PipeBase(const char* pipeName, const char* threadName)
 PipeBase::~PipeBase()
 {
 	stop();
+	stopSocketReader();
+
+	m_RecvLock.lock();
+	safe_delete(m_vRecvBuffer);
+	safe_delete(m_vFreeRecv);
+	m_RecvLock.unlock();
 
 	m_LoopbackLock.lock();
 	safe_delete(m_vLoopback);
@@ -103,92 +112,202 @@ void PipeBase::run()
 	{
 		processEvents();
 		processLoopback();
+		expireLocks();
 
+		//wake up now and then so future calls with no response still time out
 		if (itemsWaiting() == false)
-			m_WaitCond.wait();
+			m_WaitCond.wait(1);
+	}
+}
+
+void PipeBase::expireLocks()
+{
+	for (uint32 x=0; x<getNumManagers(); x++)
+	{
+		IPCManager* mng = getManager(x);
+
+		if (mng)
+			mng->expireLocks();
 	}
 }
 
 void PipeBase::processLoopback()
 {
+	std::deque<LoopbackInfo*> vLoopback;
+
 	m_LoopbackLock.lock();
+	vLoopback.swap(m_vLoopback);
+	m_LoopbackLock.unlock();
 
-	if (m_vLoopback.size() > 0)
+	for (auto info : vLoopback)
 	{
-		LoopbackInfo* info = m_vLoopback.front();
-		m_vLoopback.pop_front();
-
 		if (getManager(info->id))
-		{
 			getManager(info->id)->recvMessage(info->buffer, info->size);
-		}
-
-		safe_delete(info);
 	}
 
-	m_LoopbackLock.unlock();
+	safe_delete(vLoopback);
 }
 
 void PipeBase::processEvents()
 {
-	IPCManager* mng = getManager(0);	//TODO: Fix for multi instances
-
-	PipeData* data = NULL;
+	std::deque<RecvInfo*> vRecv;
 
 	m_RecvLock.lock();
+	vRecv.swap(m_vRecvBuffer);
+	m_RecvLock.unlock();
 
-	if (m_vRecvBuffer.size() > 0)
+	for (auto info : vRecv)
 	{
-		data = m_vRecvBuffer.front();
-		m_vRecvBuffer.pop_front();
+		IPCManager* mng = getManager(info->index);
+
+		if (info->type == RecvType::Connect)
+			onSocketConnected(info->index);
+		else if (info->type == RecvType::Disconnect)
+			disconnectAndReconnect(info->index);
+		else if (mng)
+			mng->recvMessage(info->data.buffer, info->data.size);
 	}
 
-	m_RecvLock.unlock();
+	if (!vRecv.empty())
+	{
+		m_RecvLock.lock();
 
+		for (auto info : vRecv)
+		{
+			if (m_vFreeRecv.size() < IPC_RECV_POOL)
+				m_vFreeRecv.push_back(info);
+			else
+				safe_delete(info);
+		}
 
-	if (data)
-	{
-		mng->recvMessage(data->buffer, data->size);
-		safe_delete(data);
+		m_RecvLock.unlock();
 	}
 
-	PipeData toSend;
-
-	if (mng->getMessageToSend(toSend.buffer, BUFSIZE, toSend.size))
+	for (uint32 x=0; x<getNumManagers(); x++)
 	{
-		sendMsg(m_pSendObj, toSend.buffer, toSend.size);
+		IPCManager* mng = getManager(x);
+
+		if (!mng)
+			continue;
+
+		uint32 count = 0;
+
+		while (count < IPC_SEND_BATCH && mng->getMessageToSend(m_SendBatch[count].buffer, BUFSIZE, m_SendBatch[count].size))
+			++count;
+
+		if (count > 0)
+			writeMessages(x, m_SendBatch, count);
 	}
 }
 
 bool PipeBase::itemsWaiting()
 {
-	IPCManager* mng = getManager(0);	//TODO: Fix for multi instances
-
 	uint32 num = 0;
 
 	m_RecvLock.lock();
 	num = m_vRecvBuffer.size();
 	m_RecvLock.unlock();
 
-	num += mng->getNumSendEvents();
+	for (uint32 x=0; x<getNumManagers(); x++)
+	{
+		IPCManager* mng = getManager(x);
+
+		if (mng)
+			num += mng->getNumSendEvents();
+	}
 
 	return num != 0;
 }
 
 void PipeBase::recvMessage(const char* buffer, size_t size)
 {
-	PipeData *data = new PipeData();
+	onSocketRead(0, buffer, size);
+}
 
-	data->size = size;
-	memcpy(data->buffer, buffer, size);
+PipeBase::RecvInfo* PipeBase::newRecvInfo(RecvType type, uint32 index)
+{
+	RecvInfo* info = nullptr;
 
 	m_RecvLock.lock();
-	m_vRecvBuffer.push_back(data);
+
+	if (!m_vFreeRecv.empty())
+	{
+		info = m_vFreeRecv.back();
+		m_vFreeRecv.pop_back();
+	}
+
+	m_RecvLock.unlock();
+
+	if (!info)
+		info = new RecvInfo();
+
+	info->type = type;
+	info->index = index;
+	info->data.size = 0;
+
+	return info;
+}
+
+void PipeBase::queueRecv(RecvInfo* info)
+{
+	m_RecvLock.lock();
+	m_vRecvBuffer.push_back(info);
 	m_RecvLock.unlock();
 
 	m_WaitCond.notify();
 }
 
+void PipeBase::onSocketRead(uint32 tag, const char* buffer, uint32 size)
+{
+	gcAssert(size <= BUFSIZE);
+
+	RecvInfo* info = newRecvInfo(RecvType::Message, tag);
+
+	info->data.size = size;
+	memcpy(info->data.buffer, buffer, size);
+
+	queueRecv(info);
+}
+
+void PipeBase::onSocketClosed(uint32 tag)
+{
+	queueRecv(newRecvInfo(RecvType::Disconnect, tag));
+}
+
+void PipeBase::writeMessages(uint32 index, PipeData* pData, uint32 count)
+{
+	int hSocket = getSocket(index);
+
+	if (hSocket == -1)
+	{
+		for (uint32 x=0; x<count; x++)
+			sendMsg(m_pSendObj, pData[x].buffer, pData[x].size);
+	}
+	else if (!SendPackets(hSocket, pData, count))
+	{
+		Warning("Failed to send ipc packets to {0}: {1}\n", index, errno);
+
+		//the stream is out of step now, drop the connection so the reader fails whatever is waiting on it
+		shutdown(hSocket, SHUT_RDWR);
+	}
+}
+
+void PipeBase::startSocketReader(int hListenSocket)
+{
+	gcAssert(!m_pSocketReader);
+
+	m_pSocketReader = new SocketReader(getName(), this, hListenSocket);
+	m_pSocketReader->start();
+}
+
+void PipeBase::stopSocketReader()
+{
+	if (m_pSocketReader)
+		m_pSocketReader->stop();
+
+	safe_delete(m_pSocketReader);
+}
+
 void PipeBase::setSendCallback(void* obj, SendFn funct)
 {
 	m_pSendObj = obj;
@@ -46,9 +46,7 @@ public:
 	//!
 	~PipeClient();
 
-#ifdef WIN32
 	void setUpPipes();
-#endif
 
 protected:
 	IPCManager* getManager(uint32 index);
@@ -62,6 +60,8 @@ protected:
 	PipeData* getData(uint32 index);
 
 	void cleanUp();
+#else
+	int getSocket(uint32 index) override;
 #endif
 
 
@@ -71,6 +71,9 @@ private:
 
 	PipeData m_pdSend;
 	PipeData m_pdRecv;
+#else
+	gcString m_szName;
+	int m_hSocket;
 #endif
 };
 
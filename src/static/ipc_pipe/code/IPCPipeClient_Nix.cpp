@@ -27,7 +27,11 @@ namespace IPC
 {
 
 
-PipeClient::PipeClient(const char* name, LoopbackProcessor* loopbackProcessor, uint32 managerId) : PipeBase(name, gcString("{0}- IPC Client",name).c_str()), IPCManager(loopbackProcessor, managerId, name)
+PipeClient::PipeClient(const char* name, LoopbackProcessor* loopbackProcessor, uint32 managerId)
+	: PipeBase(name, gcString("{0}- IPC Client",name).c_str())
+	, IPCManager(loopbackProcessor, managerId, name)
+	, m_szName(name)
+	, m_hSocket(-1)
 {
 	setSendEvent(&m_WaitCond);
 }
@@ -35,6 +39,21 @@ PipeClient::PipeClient(const char* name, LoopbackProcessor* loopbackProcessor, u
 PipeClient::~PipeClient()
 {
 	Thread::BaseThread::stop();
+	stopSocketReader();
+
+	if (m_hSocket != -1)
+		close(m_hSocket);
+}
+
+void PipeClient::setUpPipes()
+{
+	if (m_hSocket != -1)
+		return;
+
+	m_hSocket = ConnectSocket(m_szName.c_str());
+
+	startSocketReader();
+	m_pSocketReader->addSocket(m_hSocket, 0);
 }
 
 IPCManager* PipeClient::getManager(uint32 index)
@@ -42,10 +61,20 @@ IPCManager* PipeClient::getManager(uint32 index)
 	return this;
 }
 
+int PipeClient::getSocket(uint32 index)
+{
+	return m_hSocket;
+}
+
 void PipeClient::disconnectAndReconnect(uint32 i)
 {
 	informClassesOfDisconnect();
 	disconnect();
+
+	if (m_hSocket != -1)
+		close(m_hSocket);
+
+	m_hSocket = -1;
 }
 
 }
@@ -31,6 +31,8 @@ Contact us at legal@badjuju.com.
 #define PIPE_ACCESS	(PIPE_ACCESS_DUPLEX|FILE_FLAG_OVERLAPPED) //|FILE_FLAG_FIRST_PIPE_INSTANCE
 #define	PIPE_MODE	(PIPE_TYPE_MESSAGE|PIPE_READMODE_MESSAGE|PIPE_WAIT)
 #define PIPE_TIMEOUT 5000
+#define IPC_SEND_BATCH 16	//max packets sent to one manager per pump pass
+#define IPC_RECV_POOL 64	//max recv buffers kept for reuse
 
 #include "IPCManager.h"
 
@@ -92,6 +94,9 @@ public:
 	: send()
 	, recv()
 	, pIPC(nullptr)
+#ifdef NIX
+	, hSocket(-1)
+#endif
 	{
 #ifdef WIN32
 		pipes[0] = &send;
@@ -113,6 +118,8 @@ public:
 
 #ifdef WIN32
 	PipeData *pipes[2];
+#else
+	int hSocket;
 #endif
 
 	IPCManager* pIPC;
@@ -131,6 +138,11 @@ public:
 
 		send.reset();
 		recv.reset();
+#else
+		if (hSocket != -1)
+			close(hSocket);
+
+		hSocket = -1;
 #endif
 	}
 };
@@ -65,10 +65,9 @@ public:
 	IPCManager* getManager(uint32 index);
 
 protected:
-
-#ifdef WIN32
 	virtual void run();
 
+#ifdef WIN32
 	//! Init a new client pipe
 	//!
 	//! @param p Pipe Instance
@@ -85,23 +84,33 @@ protected:
 #endif
 	//inherited from IPCPipeBase
 	void setUpPipes();
-#ifdef WIN32
 	void disconnectAndReconnect(uint32 i);
 
+#ifdef WIN32
 	uint32 getNumEvents(){return 2*m_uiNumPipes;}
 	PipeData* getData(uint32 index);
 	void createAccessRights(PACL pNewAcl, SECURITY_ATTRIBUTES &sa, SECURITY_DESCRIPTOR &sd);
+#else
+	uint32 getNumManagers() override;
+	int getSocket(uint32 index) override;
+	void onSocketConnected(uint32 index) override;
+	int32 onSocketAccept(int hSocket, uid_t uid, pid_t pid) override;
+
+	//! Creates the manager for a pipe instance
+	//!
+	void initNewClient(uint32 index, PipeInst *p);
 #endif
 
 private:
-#ifdef WIN32
 	bool m_bChangeAccess;
 	uint8 m_uiNumPipes;
 	std::vector<PipeInst*> m_vPipeInst;
 
 	gcString m_szName;
-#else
-	PipeInst* m_pPipe;
+
+#ifdef NIX
+	int m_hListenSocket;
+	std::mutex m_SocketLock;
 #endif
 };
 
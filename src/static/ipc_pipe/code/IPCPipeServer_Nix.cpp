@@ -29,31 +29,134 @@ namespace IPC
 
 PipeServer::PipeServer(const char* name, uint8 numPipes, bool changeAccess)
 	: PipeBase(name, gcString("{0}- IPC Server", name).c_str())
-	, m_pPipe(new PipeInst())
-	, onConnectEvent()
-	, onDisconnectEvent()
 	, onNeedAuthEvent()
+	, onDisconnectEvent()
+	, onConnectEvent()
+	, m_bChangeAccess(changeAccess)
+	, m_uiNumPipes(numPipes)
+	, m_vPipeInst()
+	, m_szName(name)
+	, m_hListenSocket(-1)
+	, m_SocketLock()
 {
-	m_pPipe->pIPC = new IPCManager(this, 0, name, true);
-	m_pPipe->pIPC->onNeedAuthEvent += delegate(&onNeedAuthEvent);
-	m_pPipe->pIPC->setSendEvent(&m_WaitCond);
+	//Managers exist up front as instance 0 can also be fed in process through recvMessage
+	for (uint32 x=0; x<m_uiNumPipes; x++)
+	{
+		PipeInst *p = new PipeInst();
+		m_vPipeInst.push_back(p);
 
+		initNewClient(x, p);
+	}
 }
 
 PipeServer::~PipeServer()
 {
 	stop();
-	safe_delete(m_pPipe);
+	stopSocketReader();
+
+	if (m_hListenSocket != -1)
+		close(m_hListenSocket);
+
+	safe_delete(m_vPipeInst);
+}
+
+void PipeServer::run()
+{
+	try
+	{
+		setUpPipes();
+	}
+	catch (gcException &e)
+	{
+		Warning("Failed to start pipe: {0}\n", e);
+	}
+
+	PipeBase::run();
 }
 
 void PipeServer::setUpPipes()
 {
+	gcTrace("Socket: {0}", GetSocketName(m_szName.c_str()));
+
+	m_hListenSocket = ListenSocket(m_szName.c_str());
+	startSocketReader(m_hListenSocket);
+}
+
+void PipeServer::initNewClient(uint32 index, PipeInst *p)
+{
+	p->pIPC = new IPCManager(this, index, m_szName.c_str(), true);
+	p->pIPC->onNeedAuthEvent += delegate(&onNeedAuthEvent);
+	p->pIPC->setSendEvent(&m_WaitCond);
+}
+
+int32 PipeServer::onSocketAccept(int hSocket, uid_t uid, pid_t pid)
+{
+	//Unlike windows there is no service account here so only ever talk to our own user or root
+	if (uid != getuid() && uid != 0)
+	{
+		Warning("Rejected ipc connection on {0} from pid {1} (uid {2})\n", m_szName, pid, uid);
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> guard(m_SocketLock);
+
+	for (uint32 x=0; x<m_vPipeInst.size(); x++)
+	{
+		if (m_vPipeInst[x]->hSocket != -1)
+			continue;
+
+		m_vPipeInst[x]->hSocket = hSocket;
+		queueRecv(newRecvInfo(RecvType::Connect, x));
+		return x;
+	}
+
+	Warning("No free ipc pipe instance on {0} for pid {1}\n", m_szName, pid);
+	return -1;
+}
+
+void PipeServer::onSocketConnected(uint32 index)
+{
+	gcTrace("Id: {0}", index);
+	onConnectEvent(index);
+}
+
+void PipeServer::disconnectAndReconnect(uint32 i)
+{
+	gcTrace("Id: {0}", i);
+	onDisconnectEvent(i);
+
+	if (i >= m_vPipeInst.size())
+		return;
+
+	PipeInst* p = m_vPipeInst[i];
 
+	safe_delete(p->pIPC);
+	initNewClient(i, p);
+
+	std::lock_guard<std::mutex> guard(m_SocketLock);
+	p->disconnect();
+}
+
+uint32 PipeServer::getNumManagers()
+{
+	return m_uiNumPipes;
+}
+
+int PipeServer::getSocket(uint32 index)
+{
+	if (index >= m_vPipeInst.size())
+		return -1;
+
+	std::lock_guard<std::mutex> guard(m_SocketLock);
+	return m_vPipeInst[index]->hSocket;
 }
 
 IPCManager* PipeServer::getManager(uint32 i)
 {
-	return m_pPipe->pIPC;
+	if (i >= m_vPipeInst.size())
+		return nullptr;
+
+	return m_vPipeInst[i]->pIPC;
 }
 
 }
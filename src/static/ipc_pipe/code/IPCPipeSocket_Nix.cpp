@@ -0,0 +1,384 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "IPCPipeSocket_Nix.h"
+#include "IPCPipeHelper.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace
+{
+	const uint64 LISTEN_TAG = (uint64)-1;
+	const uint64 WAKE_TAG = (uint64)-2;
+
+	uint64 MakeEpollData(int hSocket, uint32 tag)
+	{
+		return ((uint64)tag << 32) | (uint32)hSocket;
+	}
+
+	socklen_t MakeAddress(const char* pipeName, sockaddr_un &addr)
+	{
+		gcString name = IPC::GetSocketName(pipeName);
+
+		memset(&addr, 0, sizeof(sockaddr_un));
+		addr.sun_family = AF_UNIX;
+
+		//leading null byte puts it in the abstract namespace so nothing is left behind on disk
+		size_t len = std::min(name.size(), sizeof(addr.sun_path) - 2);
+		memcpy(addr.sun_path + 1, name.c_str(), len);
+
+		return (socklen_t)(offsetof(sockaddr_un, sun_path) + 1 + len);
+	}
+
+	//! How many 100ms waits for room in a full socket buffer a send gets before it fails
+	const uint32 MAX_SEND_WAITS = 50;
+
+	//! Checks errno after a failed send, waiting for room in the socket buffer if it was full
+	//!
+	//! @param nWaits Waits that timed out so far for this send
+	//!
+	bool ShouldRetrySend(int hSocket, uint32 &nWaits)
+	{
+		if (errno == EINTR)
+			return true;
+
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			return false;
+
+		pollfd pfd;
+		pfd.fd = hSocket;
+		pfd.events = POLLOUT;
+		pfd.revents = 0;
+
+		int res = poll(&pfd, 1, 100);
+
+		if (res == -1)
+			return errno == EINTR;
+
+		//the other end has stopped reading, fail the send instead of spinning on it forever
+		if (res == 0 && ++nWaits >= MAX_SEND_WAITS)
+		{
+			Warning("IPC send on socket {0} timed out waiting for the reader\n", hSocket);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+namespace IPC
+{
+
+gcString GetSocketName(const char* pipeName)
+{
+	return gcString("desura-{0}-{1}", getuid(), pipeName);
+}
+
+int ListenSocket(const char* pipeName)
+{
+	sockaddr_un addr;
+	socklen_t addrLen = MakeAddress(pipeName, addr);
+
+	int hSocket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+	if (hSocket == -1)
+		throw gcException(ERR_PIPE, errno, "Failed to create socket");
+
+	if (bind(hSocket, (sockaddr*)&addr, addrLen) != 0 || listen(hSocket, 8) != 0)
+	{
+		int err = errno;
+		close(hSocket);
+		throw gcException(ERR_PIPE, err, gcString("Failed to listen on socket {0}", GetSocketName(pipeName)));
+	}
+
+	return hSocket;
+}
+
+int ConnectSocket(const char* pipeName)
+{
+	sockaddr_un addr;
+	socklen_t addrLen = MakeAddress(pipeName, addr);
+
+	int hSocket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+	if (hSocket == -1)
+		throw gcException(ERR_PIPE, errno, "Failed to create socket");
+
+	if (connect(hSocket, (sockaddr*)&addr, addrLen) != 0)
+	{
+		int err = errno;
+		close(hSocket);
+		throw gcException(ERR_PIPE, err, gcString("Failed to connect to socket {0}", GetSocketName(pipeName)));
+	}
+
+	uid_t uid = -1;
+	pid_t pid = 0;
+
+	//Abstract names can be taken by anyone so make sure the server is us or root
+	if (!GetPeerCredentials(hSocket, uid, pid) || (uid != getuid() && uid != 0))
+	{
+		close(hSocket);
+		throw gcException(ERR_PIPE, gcString("Socket {0} is owned by another user ({1})", GetSocketName(pipeName), uid));
+	}
+
+	return hSocket;
+}
+
+bool GetPeerCredentials(int hSocket, uid_t &uid, pid_t &pid)
+{
+	ucred cred;
+	socklen_t len = sizeof(ucred);
+
+	if (getsockopt(hSocket, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+		return false;
+
+	uid = cred.uid;
+	pid = cred.pid;
+	return true;
+}
+
+bool SendPacket(int hSocket, const char* buffer, uint32 size)
+{
+	uint32 nWaits = 0;
+
+	for (;;)
+	{
+		ssize_t res = send(hSocket, buffer, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+		//seqpacket sends are all or nothing so anything else is an error
+		if (res == (ssize_t)size)
+			return true;
+
+		if (res != -1 || !ShouldRetrySend(hSocket, nWaits))
+			return false;
+	}
+}
+
+bool SendPackets(int hSocket, PipeData* pData, uint32 count)
+{
+	mmsghdr msgs[IPC_SEND_BATCH];
+	iovec iov[IPC_SEND_BATCH];
+
+	uint32 sent = 0;
+	uint32 nWaits = 0;
+
+	while (sent < count)
+	{
+		uint32 batch = std::min<uint32>(count - sent, IPC_SEND_BATCH);
+
+		for (uint32 x=0; x<batch; x++)
+		{
+			iov[x].iov_base = pData[sent + x].buffer;
+			iov[x].iov_len = pData[sent + x].size;
+
+			memset(&msgs[x], 0, sizeof(mmsghdr));
+			msgs[x].msg_hdr.msg_iov = &iov[x];
+			msgs[x].msg_hdr.msg_iovlen = 1;
+		}
+
+		int res = sendmmsg(hSocket, msgs, batch, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+		if (res > 0)
+		{
+			sent += res;
+			nWaits = 0;
+		}
+		else if (res == -1 && !ShouldRetrySend(hSocket, nWaits))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+SocketReader::SocketReader(const char* name, SocketHandlerI* handler, int hListenSocket)
+	: Thread::BaseThread(gcString("{0}: Socket Reader", name).c_str())
+	, m_pHandler(handler)
+	, m_hListenSocket(hListenSocket)
+	, m_hEpoll(epoll_create1(EPOLL_CLOEXEC))
+	, m_hWakeEvent(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+	, m_vReadBuffer(IPC_SEND_BATCH * BUFSIZE)
+{
+	gcAssert(m_pHandler);
+
+	if (m_hEpoll == -1 || m_hWakeEvent == -1)
+		throw gcException(ERR_PIPE, errno, "Failed to create epoll for socket reader");
+
+	epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u64 = WAKE_TAG;
+	epoll_ctl(m_hEpoll, EPOLL_CTL_ADD, m_hWakeEvent, &ev);
+
+	if (m_hListenSocket != -1)
+	{
+		ev.data.u64 = LISTEN_TAG;
+		epoll_ctl(m_hEpoll, EPOLL_CTL_ADD, m_hListenSocket, &ev);
+	}
+}
+
+SocketReader::~SocketReader()
+{
+	stop();
+
+	if (m_hEpoll != -1)
+		close(m_hEpoll);
+
+	if (m_hWakeEvent != -1)
+		close(m_hWakeEvent);
+}
+
+void SocketReader::addSocket(int hSocket, uint32 tag)
+{
+	epoll_event ev;
+	ev.events = EPOLLIN | EPOLLRDHUP;
+	ev.data.u64 = MakeEpollData(hSocket, tag);
+
+	if (epoll_ctl(m_hEpoll, EPOLL_CTL_ADD, hSocket, &ev) != 0)
+		Warning("Failed to watch ipc socket {0}: {1}\n", hSocket, errno);
+}
+
+void SocketReader::run()
+{
+	epoll_event events[16];
+
+	while (!isStopped())
+	{
+		int count = epoll_wait(m_hEpoll, events, 16, -1);
+
+		if (count == -1)
+		{
+			if (errno == EINTR)
+				continue;
+
+			Warning("IPC socket epoll failed: {0}\n", errno);
+			break;
+		}
+
+		for (int x=0; x<count && !isStopped(); x++)
+		{
+			uint64 data = events[x].data.u64;
+
+			if (data == WAKE_TAG)
+				continue;
+			else if (data == LISTEN_TAG)
+				acceptSocket();
+			else
+				readSocket((int)(data & 0xFFFFFFFF), (uint32)(data >> 32));
+		}
+	}
+}
+
+void SocketReader::onStop()
+{
+	uint64 val = 1;
+	if (write(m_hWakeEvent, &val, sizeof(uint64)) != sizeof(uint64))
+		Warning("Failed to wake ipc socket reader: {0}\n", errno);
+}
+
+void SocketReader::acceptSocket()
+{
+	int hSocket = accept4(m_hListenSocket, nullptr, nullptr, SOCK_CLOEXEC);
+
+	if (hSocket == -1)
+		return;
+
+	uid_t uid = -1;
+	pid_t pid = 0;
+
+	int32 tag = -1;
+
+	if (GetPeerCredentials(hSocket, uid, pid))
+		tag = m_pHandler->onSocketAccept(hSocket, uid, pid);
+
+	if (tag < 0)
+	{
+		close(hSocket);
+		return;
+	}
+
+	addSocket(hSocket, (uint32)tag);
+}
+
+void SocketReader::readSocket(int hSocket, uint32 tag)
+{
+	mmsghdr msgs[IPC_SEND_BATCH];
+	iovec iov[IPC_SEND_BATCH];
+
+	//Drain everything that is waiting so a burst costs one wake up
+	while (true)
+	{
+		for (uint32 x=0; x<IPC_SEND_BATCH; x++)
+		{
+			iov[x].iov_base = &m_vReadBuffer[x * BUFSIZE];
+			iov[x].iov_len = BUFSIZE;
+
+			memset(&msgs[x], 0, sizeof(mmsghdr));
+			msgs[x].msg_hdr.msg_iov = &iov[x];
+			msgs[x].msg_hdr.msg_iovlen = 1;
+		}
+
+		int res = recvmmsg(hSocket, msgs, IPC_SEND_BATCH, MSG_DONTWAIT, nullptr);
+
+		if (res == -1 && errno == EINTR)
+			continue;
+
+		if (res == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+
+		bool bClosed = (res <= 0);
+
+		for (int x=0; x<res; x++)
+		{
+			//ipc never sends empty packets, so an empty one is the other end going away
+			if (msgs[x].msg_len == 0)
+			{
+				bClosed = true;
+				break;
+			}
+
+			if (msgs[x].msg_hdr.msg_flags & MSG_TRUNC)
+			{
+				Warning("Dropping oversized ipc packet\n");
+				continue;
+			}
+
+			m_pHandler->onSocketRead(tag, &m_vReadBuffer[x * BUFSIZE], msgs[x].msg_len);
+		}
+
+		if (bClosed)
+			break;
+	}
+
+	epoll_ctl(m_hEpoll, EPOLL_CTL_DEL, hSocket, nullptr);
+	m_pHandler->onSocketClosed(tag);
+}
+
+}
@@ -0,0 +1,121 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_IPCPIPESOCKET_NIX_H
+#define DESURA_IPCPIPESOCKET_NIX_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "util_thread/BaseThread.h"
+
+#include <sys/types.h>
+
+namespace IPC
+{
+class PipeData;
+
+//! Callbacks from the socket reader thread. Tags are handed out by onSocketAccept
+//! (or given to addSocket) and identify the pipe instance a socket belongs to
+//!
+class SocketHandlerI
+{
+public:
+	//! New connection on the listen socket. Return the tag for the socket or -1 to reject it
+	//!
+	//! @param hSocket Accepted socket
+	//! @param uid User id of the connecting process
+	//! @param pid Process id of the connecting process
+	//!
+	virtual int32 onSocketAccept(int hSocket, uid_t uid, pid_t pid)=0;
+
+	//! Packet read from a socket
+	//!
+	virtual void onSocketRead(uint32 tag, const char* buffer, uint32 size)=0;
+
+	//! Socket was closed by the other end. The reader has already stopped watching it
+	//!
+	virtual void onSocketClosed(uint32 tag)=0;
+};
+
+//! Gets the abstract unix socket name for a pipe. Includes the user id so different users dont collide
+//!
+gcString GetSocketName(const char* pipeName);
+
+//! Creates a SOCK_SEQPACKET socket listening on the pipe name. Throws gcException on failure
+//!
+int ListenSocket(const char* pipeName);
+
+//! Connects to a pipe server and checks its credentials. Throws gcException on failure
+//!
+int ConnectSocket(const char* pipeName);
+
+//! Gets the credentials of the process on the other end of a socket
+//!
+bool GetPeerCredentials(int hSocket, uid_t &uid, pid_t &pid);
+
+//! Sends one packet. Returns false if the socket is broken or stayed full for about 5 seconds
+//!
+bool SendPacket(int hSocket, const char* buffer, uint32 size);
+
+//! Sends several packets with as few syscalls as possible. Returns false if the socket is broken
+//! or stayed full for about 5 seconds
+//!
+bool SendPackets(int hSocket, PipeData* pData, uint32 count);
+
+//! Thread that waits on the listen socket and all connected sockets with epoll
+//!
+class SocketReader : public Thread::BaseThread
+{
+public:
+	//! Constructor
+	//!
+	//! @param name Thread name
+	//! @param handler Socket callbacks
+	//! @param hListenSocket Listen socket or -1 for client only
+	//!
+	SocketReader(const char* name, SocketHandlerI* handler, int hListenSocket = -1);
+	~SocketReader();
+
+	//! Starts watching a connected socket
+	//!
+	void addSocket(int hSocket, uint32 tag);
+
+protected:
+	void run() override;
+	void onStop() override;
+
+	void acceptSocket();
+	void readSocket(int hSocket, uint32 tag);
+
+private:
+	SocketHandlerI* m_pHandler;
+
+	int m_hListenSocket;
+	int m_hEpoll;
+	int m_hWakeEvent;
+
+	std::vector<char> m_vReadBuffer;
+};
+
+}
+
+#endif //DESURA_IPCPIPESOCKET_NIX_H
@@ -0,0 +1,91 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#ifndef DESURA_IPCSHAREDPAYLOAD_H
+#define DESURA_IPCSHAREDPAYLOAD_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "IPCMessage.h"
+
+namespace IPC
+{
+
+//! Payloads at least this big skip the pipe and go through shared memory
+//!
+#define IPC_SHAREDPAYLOAD_THRESHOLD (64*1024)
+
+//! Shared memory segment used to hand large ipc payloads to the other side without
+//! splitting them into pipe sized parts. The sender creates a segment and sends its
+//! name, the receiver maps a private copy on write view of it, removes the name and reads
+//! the data in place. The mapping stays alive until every queued message using it has been
+//! handled. The receiver acks each name so the sender can stop tracking it.
+//!
+class SharedPayload
+{
+public:
+	SharedPayload();
+	~SharedPayload();
+
+	//! Creates a segment holding a copy of the buffer
+	//!
+	//! @param buff Payload
+	//! @param size Payload size
+	//! @param ref Filled with the segment name and size to send
+	//! @return false if shared memory is not available
+	//!
+	static bool Create(const char* buff, uint32 size, IPCSharedPayloadRef &ref);
+
+	//! Removes a segment that might not have been opened by the other side
+	//!
+	static void Remove(const char* name);
+
+	//! Maps a segment sent from the other side and removes its name
+	//!
+	bool open(const IPCSharedPayloadRef &ref);
+
+	char* getData()
+	{
+		return m_pData;
+	}
+
+	const char* getData() const
+	{
+		return m_pData;
+	}
+
+	uint32 getSize() const
+	{
+		return m_uiSize;
+	}
+
+private:
+	SharedPayload(const SharedPayload&) = delete;
+	SharedPayload& operator=(const SharedPayload&) = delete;
+
+	char* m_pData;
+	uint32 m_uiSize;
+};
+
+}
+
+#endif //DESURA_IPCSHAREDPAYLOAD_H
@@ -0,0 +1,122 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "IPCSharedPayload.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <atomic>
+
+namespace IPC
+{
+
+static std::atomic<uint32> g_nPayloadCount(0);
+
+SharedPayload::SharedPayload()
+	: m_pData(nullptr)
+	, m_uiSize(0)
+{
+}
+
+SharedPayload::~SharedPayload()
+{
+	if (m_pData)
+		munmap(m_pData, m_uiSize);
+}
+
+bool SharedPayload::Create(const char* buff, uint32 size, IPCSharedPayloadRef &ref)
+{
+	memset(&ref, 0, sizeof(IPCSharedPayloadRef));
+	snprintf(ref.name, sizeof(ref.name), "/desura-ipc-%d-%u", getpid(), ++g_nPayloadCount);
+	ref.size = size;
+
+	int fd = shm_open(ref.name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+
+	if (fd == -1)
+		return false;
+
+	void* pData = MAP_FAILED;
+
+	if (ftruncate(fd, size) == 0)
+		pData = mmap(nullptr, size, PROT_WRITE, MAP_SHARED, fd, 0);
+
+	close(fd);
+
+	if (pData == MAP_FAILED)
+	{
+		shm_unlink(ref.name);
+		return false;
+	}
+
+	memcpy(pData, buff, size);
+	munmap(pData, size);
+
+	return true;
+}
+
+void SharedPayload::Remove(const char* name)
+{
+	shm_unlink(name);
+}
+
+bool SharedPayload::open(const IPCSharedPayloadRef &ref)
+{
+	gcAssert(!m_pData);
+
+	char name[sizeof(ref.name) + 1] = {0};
+	memcpy(name, ref.name, sizeof(ref.name));
+
+	//Dont let the other side point us at (and unlink) some other segment
+	if (strncmp(name, "/desura-ipc-", 12) != 0)
+		return false;
+
+	int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+
+	if (fd == -1)
+		return false;
+
+	//name is only needed to find it, the mapping keeps the memory alive
+	shm_unlink(name);
+
+	struct stat st;
+	void* pData = MAP_FAILED;
+
+	if (fstat(fd, &st) == 0 && st.st_size == ref.size && ref.size > 0)
+	{
+		//Private and writable as the call is dispatched in place and flat string args
+		//get terminated where they lie. Writes are copy on write and never reach the sender
+		pData = mmap(nullptr, ref.size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	}
+
+	close(fd);
+
+	if (pData == MAP_FAILED)
+		return false;
+
+	m_pData = (char*)pData;
+	m_uiSize = ref.size;
+
+	return true;
+}
+
+}
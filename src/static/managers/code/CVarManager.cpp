@@ -74,7 +74,7 @@ CVarManager::CVarManager()
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(m_szCVarDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(m_szCVarDb);
 
 		if (db.executeint(COUNT_CVARUSER) == 0)
 			db.executenonquery(CREATE_CVARUSER);
@@ -145,8 +145,8 @@ void CVarManager::loadCVarFromDb(CVar *var, const char* szSql, gcString strExtra
 {
 	try
 	{
-		sqlite3x::sqlite3_connection db(m_szCVarDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, szSql);
+		sqlite3x::sqlite3_pooled_connection db(m_szCVarDb);
+		sqlite3x::sqlite3_command &cmd = db.command(szSql);
 		cmd.bind(1, var->getName());
 		cmd.bind(2, strExtra);
 
@@ -184,8 +184,8 @@ void CVarManager::loadUser(uint32 userid)
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(m_szCVarDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, "SELECT name, value FROM cvaruser WHERE user=?;");
+		sqlite3x::sqlite3_pooled_connection db(m_szCVarDb);
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT name, value FROM cvaruser WHERE user=?;");
 		cmd.bind(1, (int)m_uiUserId);
 
 		sqlite3x::sqlite3_reader cmdResults = cmd.executereader();
@@ -202,8 +202,8 @@ void CVarManager::loadWinUser()
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(m_szCVarDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, "SELECT name, value FROM cvarwin WHERE user=?;");
+		sqlite3x::sqlite3_pooled_connection db(m_szCVarDb);
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT name, value FROM cvarwin WHERE user=?;");
 
 		cmd.bind(1, getWinUser());
 
@@ -222,8 +222,8 @@ void CVarManager::loadNormal()
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(m_szCVarDb.c_str());
-		sqlite3x::sqlite3_command cmd(db, "SELECT name, value FROM cvar;");
+		sqlite3x::sqlite3_pooled_connection db(m_szCVarDb);
+		sqlite3x::sqlite3_command &cmd = db.command("SELECT name, value FROM cvar;");
 
 		sqlite3x::sqlite3_reader cmdResults = cmd.executereader();
 		loadFromDb(cmdResults);
@@ -248,10 +248,10 @@ void CVarManager::saveUser()
 
 	try
 	{
-		sqlite3x::sqlite3_connection db(m_szCVarDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(m_szCVarDb);
 
 		{
-			sqlite3x::sqlite3_command cmd(db,"DELETE FROM cvaruser where user=?;");
+			sqlite3x::sqlite3_command &cmd = db.command("DELETE FROM cvaruser where user=?;");
 			cmd.bind(1, (int)m_uiUserId);
 			cmd.executenonquery();
 		}
@@ -259,7 +259,7 @@ void CVarManager::saveUser()
 		sqlite3x::sqlite3_transaction trans(db);
 
 		{
-			sqlite3x::sqlite3_command cmd(db, "INSERT INTO cvaruser (name, value, user) VALUES (?,?,?);");
+			sqlite3x::sqlite3_command &cmd = db.command("INSERT INTO cvaruser (name, value, user) VALUES (?,?,?);");
 			cmd.bind(3, (int)m_uiUserId);
 			saveToDb(cmd, CFLAG_USER);
 		}
@@ -276,15 +276,15 @@ void CVarManager::saveWinUser()
 {
 	try
 	{
-		sqlite3x::sqlite3_connection db(m_szCVarDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(m_szCVarDb);
 
 		{
-			sqlite3x::sqlite3_command cmd(db,"DELETE FROM cvarwin where user=?;");
+			sqlite3x::sqlite3_command &cmd = db.command("DELETE FROM cvarwin where user=?;");
 			cmd.bind(1, getWinUser());
 			cmd.executenonquery();
 		}
 
-		sqlite3x::sqlite3_command cmd(db, "INSERT INTO cvarwin (name, value, user) VALUES (?,?,?);");
+		sqlite3x::sqlite3_command &cmd = db.command("INSERT INTO cvarwin (name, value, user) VALUES (?,?,?);");
 		cmd.bind(3, getWinUser());
 
 		sqlite3x::sqlite3_transaction trans(db);
@@ -301,10 +301,10 @@ void CVarManager::saveNormal()
 {
 	try
 	{
-		sqlite3x::sqlite3_connection db(m_szCVarDb.c_str());
+		sqlite3x::sqlite3_pooled_connection db(m_szCVarDb);
 		db.executenonquery("DELETE FROM cvar;");
 
-		sqlite3x::sqlite3_command cmd(db, "INSERT INTO cvar (name, value) VALUES (?,?);");
+		sqlite3x::sqlite3_command &cmd = db.command("INSERT INTO cvar (name, value) VALUES (?,?);");
 
 		sqlite3x::sqlite3_transaction trans(db);
 		saveToDb(cmd, CFLAG_NOFLAGS);
@@ -0,0 +1,104 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#include "Common.h"
+#include "util/UtilBandwidthLimiter.h"
+
+using namespace UTIL::WEB;
+
+
+void BandwidthLimiter::setDownloadLimit(uint64 nRate)
+{
+	m_DownloadBucket.setRate(nRate);
+	m_nDownloadRate = nRate;
+}
+
+void BandwidthLimiter::setUploadLimit(uint64 nRate)
+{
+	m_UploadBucket.setRate(nRate);
+	m_nUploadRate = nRate;
+}
+
+uint64 BandwidthLimiter::getDownloadLimit() const
+{
+	return m_nDownloadRate;
+}
+
+uint64 BandwidthLimiter::getUploadLimit() const
+{
+	return m_nUploadRate;
+}
+
+std::chrono::microseconds BandwidthLimiter::take(TrafficDirection direction, TrafficClass trafficClass, uint64 nBytes)
+{
+	bool bDownload = (direction == TrafficDirection::Download);
+
+	//every curl callback comes through here, dont touch the bucket locks if there is no limit
+	if ((bDownload ? m_nDownloadRate : m_nUploadRate) == 0)
+		return std::chrono::microseconds(0);
+
+	auto &bucket = (bDownload ? m_DownloadBucket : m_UploadBucket);
+
+	//a burst of page loads can only push background transfers back by about a second
+	if (trafficClass == TrafficClass::Interactive)
+	{
+		bucket.charge(nBytes);
+		return std::chrono::microseconds(0);
+	}
+
+	return bucket.take(nBytes);
+}
+
+//Zero initialised before any constructors run so it is safe to use from other globals
+static std::atomic<BandwidthLimiter*> g_pLimiter;
+static std::atomic<BandwidthLimiter*> g_pSharedLimiter;
+
+BandwidthLimiter& UTIL::WEB::GetBandwidthLimiter()
+{
+	auto pShared = g_pSharedLimiter.load(std::memory_order_acquire);
+
+	if (pShared)
+		return *pShared;
+
+	auto pLimiter = g_pLimiter.load(std::memory_order_acquire);
+
+	if (pLimiter)
+		return *pLimiter;
+
+	//Never deleted, other modules can hold on to it until they are unloaded
+	auto pNew = new BandwidthLimiter();
+
+	if (!g_pLimiter.compare_exchange_strong(pLimiter, pNew))
+	{
+		delete pNew;
+		return *pLimiter;
+	}
+
+	return *pNew;
+}
+
+void UTIL::WEB::SetBandwidthLimiter(BandwidthLimiter* pLimiter)
+{
+	if (pLimiter == g_pLimiter.load(std::memory_order_acquire))
+		pLimiter = nullptr;
+
+	g_pSharedLimiter.store(pLimiter, std::memory_order_release);
+}
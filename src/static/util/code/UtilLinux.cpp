@@ -643,6 +643,67 @@ bool launchProcess(const char* exe, const std::map<std::string, std::string> &in
 	return false;
 }
 
+static std::vector<uint32> getProcessesWithLinkAtPath(const char* szPath, bool bCheckCwd)
+{
+	std::vector<uint32> res;
+
+	if (!szPath)
+		return res;
+
+	DIR* dir = opendir("/proc");
+
+	if (!dir)
+		return res;
+
+	UTIL::FS::Path path(szPath, "", false);
+	pid_t curPID = getpid();
+
+	struct dirent* entry = nullptr;
+	char buffer[PATH_MAX] = {0};
+
+	while ((entry = readdir(dir)) != nullptr)
+	{
+		uint32 pid = (uint32)atoi(entry->d_name);
+
+		if (pid == 0 || pid == (uint32)curPID)
+			continue;
+
+		const char* szLinks[] = { "exe", "cwd" };
+
+		for (size_t x = 0; x < (bCheckCwd ? 2 : 1); x++)
+		{
+			gcString strLink("/proc/{0}/{1}", pid, szLinks[x]);
+			ssize_t len = readlink(strLink.c_str(), buffer, PATH_MAX - 1);
+
+			if (len <= 0)
+				continue;
+
+			buffer[len] = '\0';
+
+			UTIL::FS::Path procPath(buffer, "", x == 0);
+
+			if (procPath.startsWith(path))
+			{
+				res.push_back(pid);
+				break;
+			}
+		}
+	}
+
+	closedir(dir);
+	return res;
+}
+
+std::vector<uint32> getProcessesRunningAtPath(const char* szPath)
+{
+	return getProcessesWithLinkAtPath(szPath, false);
+}
+
+std::vector<uint32> getProcessesUsingPath(const char* szPath)
+{
+	return getProcessesWithLinkAtPath(szPath, true);
+}
+
 static std::string getDescFromLSB(std::string &input)
 {
 	std::vector<std::string> tokens;
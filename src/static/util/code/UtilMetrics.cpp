@@ -0,0 +1,327 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#include "Common.h"
+#include "util/UtilMetrics.h"
+
+#ifdef WIN32
+#include <intrin.h>
+#endif
+
+using namespace UTIL::METRICS;
+
+namespace
+{
+	uint32 HighestBit(uint64 nValue)
+	{
+#ifdef WIN32
+		unsigned long nIndex = 0;
+#ifdef _WIN64
+		_BitScanReverse64(&nIndex, nValue);
+#else
+		if (_BitScanReverse(&nIndex, (unsigned long)(nValue >> 32)))
+			nIndex += 32;
+		else
+			_BitScanReverse(&nIndex, (unsigned long)nValue);
+#endif
+		return nIndex;
+#else
+		return 63 - __builtin_clzll(nValue);
+#endif
+	}
+
+	void AppendJsonName(std::string &strOut, const std::string &strName, bool &bFirst)
+	{
+		if (!bFirst)
+			strOut += ", ";
+
+		bFirst = false;
+
+		strOut += '"';
+		UTIL::STRING::appendJsonEscaped(strOut, strName);
+		strOut += "\": ";
+	}
+}
+
+
+Counter::Counter()
+{
+	for (auto &s : m_Shards)
+		s.m_nValue = 0;
+}
+
+uint64 Counter::get() const
+{
+	uint64 nTotal = 0;
+
+	for (auto &s : m_Shards)
+		nTotal += s.m_nValue.load(std::memory_order_relaxed);
+
+	return nTotal;
+}
+
+Gauge::Gauge()
+	: m_nValue(0)
+{
+}
+
+
+Histogram::Histogram()
+	: m_nMax(0)
+{
+	for (auto &b : m_Buckets)
+		b = 0;
+}
+
+uint32 Histogram::getBucket(uint64 nValue)
+{
+	if (nValue < SUB_BUCKETS)
+		return (uint32)nValue;
+
+	uint32 nExp = HighestBit(nValue);
+	uint32 nSub = (uint32)(nValue >> (nExp - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+
+	return (nExp - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + nSub;
+}
+
+uint64 Histogram::getBucketValue(uint32 nBucket)
+{
+	if (nBucket < SUB_BUCKETS)
+		return nBucket;
+
+	uint32 nExp = nBucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+	uint64 nSub = nBucket % SUB_BUCKETS;
+
+	return (SUB_BUCKETS + nSub) << (nExp - SUB_BUCKET_BITS);
+}
+
+void Histogram::record(uint64 nValue)
+{
+	m_Buckets[getBucket(nValue)].fetch_add(1, std::memory_order_relaxed);
+
+	m_Count.add();
+	m_Sum.add(nValue);
+
+	uint64 nMax = m_nMax.load(std::memory_order_relaxed);
+
+	while (nValue > nMax && !m_nMax.compare_exchange_weak(nMax, nValue, std::memory_order_relaxed))
+	{
+	}
+}
+
+HistogramSnapshot Histogram::snapshot() const
+{
+	HistogramSnapshot snap;
+
+	for (uint32 x = 0; x < BUCKET_COUNT; ++x)
+	{
+		uint64 nCount = m_Buckets[x].load(std::memory_order_relaxed);
+
+		if (nCount == 0)
+			continue;
+
+		snap.m_vBuckets.push_back(std::make_pair(getBucketValue(x), nCount));
+		snap.m_nCount += nCount;
+	}
+
+	//Count from the buckets so percentiles line up, the sum can be slightly ahead of it
+	snap.m_nSum = m_Sum.get();
+	snap.m_nMax = m_nMax.load(std::memory_order_relaxed);
+
+	return snap;
+}
+
+uint64 HistogramSnapshot::getPercentile(double dPercentile) const
+{
+	if (m_nCount == 0)
+		return 0;
+
+	uint64 nTarget = (uint64)(dPercentile / 100.0 * m_nCount + 0.5);
+
+	if (nTarget == 0)
+		nTarget = 1;
+
+	uint64 nSeen = 0;
+
+	for (auto &b : m_vBuckets)
+	{
+		nSeen += b.second;
+
+		//Report the highest value the bucket can hold so percentiles never under state
+		if (nSeen >= nTarget)
+			return std::min(Histogram::getBucketValue(Histogram::getBucket(b.first) + 1) - 1, m_nMax);
+	}
+
+	return m_nMax;
+}
+
+
+void Snapshot::toJson(std::string &strOut, const Snapshot* pPrevious, double dSeconds) const
+{
+	strOut += "{ \"counters\": { ";
+
+	bool bFirst = true;
+
+	for (auto &c : m_mCounters)
+	{
+		AppendJsonName(strOut, c.first, bFirst);
+
+		if (pPrevious && dSeconds > 0.0)
+		{
+			uint64 nLast = 0;
+			auto it = pPrevious->m_mCounters.find(c.first);
+
+			if (it != pPrevious->m_mCounters.end())
+				nLast = it->second;
+
+			strOut += gcString("{ \"value\": {0}, \"per_sec\": {1} }", c.second, (uint64)((c.second - nLast) / dSeconds));
+		}
+		else
+		{
+			strOut += gcString("{ \"value\": {0} }", c.second);
+		}
+	}
+
+	strOut += " }, \"gauges\": { ";
+	bFirst = true;
+
+	for (auto &g : m_mGauges)
+	{
+		AppendJsonName(strOut, g.first, bFirst);
+		strOut += gcString("{0}", g.second);
+	}
+
+	strOut += " }, \"histograms\": { ";
+	bFirst = true;
+
+	for (auto &h : m_mHistograms)
+	{
+		auto &s = h.second;
+
+		AppendJsonName(strOut, h.first, bFirst);
+		strOut += gcString("{ \"count\": {0}, \"sum\": {1}, \"mean\": {2}, ", s.m_nCount, s.m_nSum, (uint64)s.getMean());
+		strOut += gcString("\"p50\": {0}, \"p90\": {1}, \"p99\": {2}, \"max\": {3} }", s.getPercentile(50), s.getPercentile(90), s.getPercentile(99), s.m_nMax);
+	}
+
+	strOut += " } }";
+}
+
+void Snapshot::toText(std::string &strOut, const char* szFilter) const
+{
+	auto match = [szFilter](const std::string &strName)
+	{
+		return !szFilter || strName.compare(0, strlen(szFilter), szFilter) == 0;
+	};
+
+	for (auto &c : m_mCounters)
+	{
+		if (match(c.first))
+			strOut += gcString("{0} = {1}\n", c.first, c.second);
+	}
+
+	for (auto &g : m_mGauges)
+	{
+		if (match(g.first))
+			strOut += gcString("{0} = {1}\n", g.first, g.second);
+	}
+
+	for (auto &h : m_mHistograms)
+	{
+		if (!match(h.first))
+			continue;
+
+		auto &s = h.second;
+		strOut += gcString("{0}: count {1}, mean {2}, p50 {3}, p90 {4}, p99 {5}, max {6}\n", h.first, s.m_nCount, (uint64)s.getMean(), s.getPercentile(50), s.getPercentile(90), s.getPercentile(99), s.m_nMax);
+	}
+}
+
+
+Counter& Registry::counter(const std::string &strName)
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	auto &p = m_mCounters[strName];
+
+	if (!p)
+		p.reset(new Counter());
+
+	return *p;
+}
+
+Gauge& Registry::gauge(const std::string &strName)
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	auto &p = m_mGauges[strName];
+
+	if (!p)
+		p.reset(new Gauge());
+
+	return *p;
+}
+
+Histogram& Registry::histogram(const std::string &strName)
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	auto &p = m_mHistograms[strName];
+
+	if (!p)
+		p.reset(new Histogram());
+
+	return *p;
+}
+
+void Registry::snapshot(Snapshot &snapshot) const
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	for (auto &c : m_mCounters)
+		snapshot.m_mCounters[c.first] = c.second->get();
+
+	for (auto &g : m_mGauges)
+		snapshot.m_mGauges[g.first] = g.second->get();
+
+	for (auto &h : m_mHistograms)
+		snapshot.m_mHistograms[h.first] = h.second->snapshot();
+}
+
+//Zero initialised before any constructors run so it is safe to use from other globals
+static std::atomic<Registry*> g_pRegistry;
+
+Registry& UTIL::METRICS::GetRegistry()
+{
+	auto pRegistry = g_pRegistry.load(std::memory_order_acquire);
+
+	if (pRegistry)
+		return *pRegistry;
+
+	//Never deleted, metric references are held by globals that can outlive any cleanup
+	auto pNew = new Registry();
+
+	if (!g_pRegistry.compare_exchange_strong(pRegistry, pNew))
+	{
+		delete pNew;
+		return *pRegistry;
+	}
+
+	return *pNew;
+}
@@ -565,9 +565,9 @@ std::vector<uint32> getProcessesRunningAtPath(const char* szPath)
 {
 #ifdef WIN32
 	return UTIL::WIN::getProcessesRunningAtPath(szPath);
+#else
+	return UTIL::LIN::getProcessesRunningAtPath(szPath);
 #endif
-
-	return std::vector<uint32>();
 }
 
 void killProcess(uint32 pid)
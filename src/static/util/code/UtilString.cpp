@@ -586,5 +586,21 @@ std::string escape(const std::string &in)
 	return out;
 }
 
+void appendJsonEscaped(std::string &strOut, const std::string &in)
+{
+	for (auto c : in)
+	{
+		if (c == '"' || c == '\\')
+			strOut += '\\';
+
+		if (c == '\n')
+			strOut += "\\n";
+		else if (c == '\t')
+			strOut += "\\t";
+		else
+			strOut += c;
+	}
+}
+
 }
 }
@@ -0,0 +1,239 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#include "Common.h"
+#include "util/UtilTimeline.h"
+
+#include <algorithm>
+
+#ifdef NIX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace UTIL::TIMELINE;
+
+namespace
+{
+	void AppendComma(std::string &strOut)
+	{
+		if (!strOut.empty())
+			strOut += ",\n";
+	}
+
+	uint64 GetProcessId()
+	{
+#ifdef WIN32
+		return GetCurrentProcessId();
+#else
+		return getpid();
+#endif
+	}
+
+	int64 ToMicroseconds(std::chrono::steady_clock::time_point time)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+	}
+}
+
+
+Timeline::Timeline()
+	: m_bEnabled(false)
+{
+}
+
+uint64 Timeline::getCurrentThreadId()
+{
+#ifdef WIN32
+	return ::GetCurrentThreadId();
+#else
+	return (uint64)syscall(SYS_gettid);
+#endif
+}
+
+void Timeline::record(const char* szCategory, std::string strName, std::string strDetail, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	auto nThreadId = getCurrentThreadId();
+	auto &buffer = m_Buffers[nThreadId % BUFFER_SHARDS];
+
+	std::lock_guard<std::mutex> guard(buffer.m_Lock);
+
+	Span* pSpan = nullptr;
+
+	if (buffer.m_vSpans.size() < BUFFER_SIZE)
+	{
+		buffer.m_vSpans.push_back(Span());
+		pSpan = &buffer.m_vSpans.back();
+	}
+	else
+	{
+		pSpan = &buffer.m_vSpans[buffer.m_nNext];
+		buffer.m_nNext = (buffer.m_nNext + 1) % BUFFER_SIZE;
+	}
+
+	pSpan->m_szCategory = szCategory;
+	pSpan->m_strName = std::move(strName);
+	pSpan->m_strDetail = std::move(strDetail);
+	pSpan->m_nThreadId = nThreadId;
+	pSpan->m_nStart = ToMicroseconds(start);
+	pSpan->m_nDuration = ToMicroseconds(end) - pSpan->m_nStart;
+}
+
+void Timeline::setThreadName(const char* szName)
+{
+	if (!szName)
+		return;
+
+	auto nThreadId = getCurrentThreadId();
+
+	std::lock_guard<std::mutex> guard(m_ThreadNameLock);
+	m_mThreadNames[nThreadId] = szName;
+
+	//Thread ids get reused
+	auto it = std::find(m_vExitedThreads.begin(), m_vExitedThreads.end(), nThreadId);
+
+	if (it != m_vExitedThreads.end())
+		m_vExitedThreads.erase(it);
+}
+
+void Timeline::threadExited()
+{
+	auto nThreadId = getCurrentThreadId();
+
+	std::lock_guard<std::mutex> guard(m_ThreadNameLock);
+
+	if (m_mThreadNames.find(nThreadId) == m_mThreadNames.end())
+		return;
+
+	m_vExitedThreads.push_back(nThreadId);
+
+	//Nothing might ever clear the spans so dont let thread churn grow the names for ever
+	while (m_vExitedThreads.size() > MAX_EXITED_THREAD_NAMES)
+	{
+		m_mThreadNames.erase(m_vExitedThreads.front());
+		m_vExitedThreads.pop_front();
+	}
+}
+
+void Timeline::removeExitedThreadNames()
+{
+	for (auto nThreadId : m_vExitedThreads)
+		m_mThreadNames.erase(nThreadId);
+
+	m_vExitedThreads.clear();
+}
+
+void Timeline::appendEvents(std::string &strOut, bool bClear)
+{
+	auto nPid = GetProcessId();
+
+	for (auto &buffer : m_Buffers)
+	{
+		std::lock_guard<std::mutex> guard(buffer.m_Lock);
+
+		for (auto &s : buffer.m_vSpans)
+		{
+			AppendComma(strOut);
+
+			strOut += gcString("{ \"ph\": \"X\", \"pid\": {0}, \"tid\": {1}, \"ts\": {2}, \"dur\": {3}, \"cat\": \"{4}\", \"name\": \"", nPid, s.m_nThreadId, s.m_nStart, s.m_nDuration, s.m_szCategory);
+			UTIL::STRING::appendJsonEscaped(strOut, s.m_strName);
+			strOut += "\"";
+
+			if (!s.m_strDetail.empty())
+			{
+				strOut += ", \"args\": { \"detail\": \"";
+				UTIL::STRING::appendJsonEscaped(strOut, s.m_strDetail);
+				strOut += "\" }";
+			}
+
+			strOut += " }";
+		}
+
+		if (bClear)
+		{
+			buffer.m_vSpans.clear();
+			buffer.m_nNext = 0;
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(m_ThreadNameLock);
+
+	for (auto &t : m_mThreadNames)
+	{
+		AppendComma(strOut);
+
+		strOut += gcString("{ \"ph\": \"M\", \"pid\": {0}, \"tid\": {1}, \"name\": \"thread_name\", \"args\": { \"name\": \"", nPid, t.first);
+		UTIL::STRING::appendJsonEscaped(strOut, t.second);
+		strOut += "\" } }";
+	}
+
+	if (bClear)
+		removeExitedThreadNames();
+}
+
+void Timeline::clear()
+{
+	for (auto &buffer : m_Buffers)
+	{
+		std::lock_guard<std::mutex> guard(buffer.m_Lock);
+		buffer.m_vSpans.clear();
+		buffer.m_nNext = 0;
+	}
+
+	std::lock_guard<std::mutex> guard(m_ThreadNameLock);
+	removeExitedThreadNames();
+}
+
+std::string UTIL::TIMELINE::FormatChromeTrace(const std::vector<Timeline*> &vTimelines, bool bClear)
+{
+	std::string strEvents;
+
+	for (auto pTimeline : vTimelines)
+	{
+		if (pTimeline)
+			pTimeline->appendEvents(strEvents, bClear);
+	}
+
+	return "{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [\n" + strEvents + "\n] }\n";
+}
+
+
+//Zero initialised before any constructors run so it is safe to use from other globals
+static std::atomic<Timeline*> g_pTimeline;
+
+Timeline& UTIL::TIMELINE::GetTimeline()
+{
+	auto pTimeline = g_pTimeline.load(std::memory_order_acquire);
+
+	if (pTimeline)
+		return *pTimeline;
+
+	//Never deleted, spans can be recorded by threads that outlive any cleanup
+	auto pNew = new Timeline();
+
+	if (!g_pTimeline.compare_exchange_strong(pTimeline, pNew))
+	{
+		delete pNew;
+		return *pTimeline;
+	}
+
+	return *pNew;
+}
@@ -0,0 +1,107 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+#include "Common.h"
+#include "util/UtilTokenBucket.h"
+
+#include <thread>
+
+using namespace UTIL::MISC;
+
+
+TokenBucket::TokenBucket(uint64 nRate, uint64 nBurst)
+	: m_tLastRefill(std::chrono::steady_clock::now())
+{
+	setRate(nRate, nBurst);
+}
+
+void TokenBucket::setRate(uint64 nRate, uint64 nBurst)
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	refill(std::chrono::steady_clock::now());
+
+	bool bWasUnlimited = (m_nRate == 0);
+
+	m_nRate = nRate;
+	m_nBurst = nBurst ? nBurst : nRate;
+
+	//a fresh limit starts with a full bucket, debt from an older rate carries over
+	if (bWasUnlimited || m_dTokens > m_nBurst)
+		m_dTokens = (double)m_nBurst;
+}
+
+uint64 TokenBucket::getRate() const
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+	return m_nRate;
+}
+
+void TokenBucket::refill(std::chrono::steady_clock::time_point tNow)
+{
+	auto nElapsed = std::chrono::duration_cast<std::chrono::microseconds>(tNow - m_tLastRefill).count();
+	m_tLastRefill = tNow;
+
+	if (m_nRate == 0 || nElapsed <= 0)
+		return;
+
+	m_dTokens = std::min<double>((double)m_nBurst, m_dTokens + (double)m_nRate * nElapsed / 1000000.0);
+}
+
+std::chrono::microseconds TokenBucket::take(uint64 nTokens)
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	if (m_nRate == 0)
+		return std::chrono::microseconds(0);
+
+	refill(std::chrono::steady_clock::now());
+	m_dTokens -= (double)nTokens;
+
+	if (m_dTokens >= 0)
+		return std::chrono::microseconds(0);
+
+	return std::chrono::microseconds((int64)(-m_dTokens * 1000000.0 / m_nRate));
+}
+
+void TokenBucket::consume(uint64 nTokens)
+{
+	auto wait = take(nTokens);
+
+	if (wait.count() > 0)
+		std::this_thread::sleep_for(wait);
+}
+
+void TokenBucket::charge(uint64 nTokens)
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	if (m_nRate == 0)
+		return;
+
+	refill(std::chrono::steady_clock::now());
+
+	//debt the waiting callers built up themselves is left alone
+	double dFloor = -(double)m_nBurst;
+
+	if (m_dTokens > dFloor)
+		m_dTokens = std::max(dFloor, m_dTokens - (double)nTokens);
+}
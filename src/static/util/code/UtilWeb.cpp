@@ -33,6 +33,8 @@ Contact us at legal@badjuju.com.
 #include "Winhttp.h"
 #endif
 
+#include <thread>
+
 
 class MemoryStruct
 {
@@ -133,6 +135,11 @@ public:
 		return m_nLastStatusCode;
 	}
 
+	void setTrafficClass(UTIL::WEB::TrafficClass trafficClass) override
+	{
+		m_TrafficClass = trafficClass;
+	}
+
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Events
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -169,6 +176,9 @@ protected:
 	uint8 processResult(CURLcode res);
 	void storeCookies();
 
+	//! Charges bytes to the bandwidth limiter and waits if over budget
+	void throttle(UTIL::WEB::TrafficDirection direction, uint64 nBytes);
+
 	void setUp(bool setRange);
 
 private:
@@ -201,6 +211,9 @@ private:
 
 	bool m_bDontThrowOnPartFile = false;
 	long m_nLastStatusCode = 0;
+
+	UTIL::WEB::TrafficClass m_TrafficClass = UTIL::WEB::TrafficClass::Interactive;
+	double m_dLastUlNow = 0.0;
 };
 
 
@@ -383,6 +396,11 @@ size_t HttpHInternal::write_cb(size_t size, size_t nmemb, void *data)
 
 	size_t realsize = size * nmemb;
 
+	throttle(UTIL::WEB::TrafficDirection::Download, realsize);
+
+	if (m_bAbort)
+		return 0;
+
 	m_pMemStruct->size += (uint32)realsize;
 
 	WriteMem_s wms;
@@ -421,6 +439,27 @@ size_t HttpHInternal::write_cb(size_t size, size_t nmemb, void *data)
 	return realsize;
 }
 
+void HttpHInternal::throttle(UTIL::WEB::TrafficDirection direction, uint64 nBytes)
+{
+	auto wait = UTIL::WEB::GetBandwidthLimiter().take(direction, m_TrafficClass, nBytes);
+
+	if (wait.count() <= 0)
+		return;
+
+	auto tEnd = std::chrono::steady_clock::now() + wait;
+
+	//sleep in slices so an abort doesnt have to wait out a slow limit
+	while (!m_bAbort)
+	{
+		auto tNow = std::chrono::steady_clock::now();
+
+		if (tNow >= tEnd)
+			break;
+
+		std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(tEnd - tNow, std::chrono::milliseconds(100)));
+	}
+}
+
 void HttpHInternal::setUp()
 {
 	setUp(true);
@@ -446,6 +485,7 @@ void HttpHInternal::setUp(bool setRange)
 	curl_easy_setopt(m_pCurlHandle, CURLOPT_NOPROGRESS, false);
 	curl_easy_setopt(m_pCurlHandle, CURLOPT_PROGRESSFUNCTION, HttpHInternal::progress_cbs);
 	curl_easy_setopt(m_pCurlHandle, CURLOPT_PROGRESSDATA, this);
+	m_dLastUlNow = 0.0;
 
 	if (m_szCookies != "")
 		curl_easy_setopt(m_pCurlHandle, CURLOPT_COOKIE, m_szCookies.c_str());
@@ -843,6 +883,16 @@ int HttpHInternal::progress_cbs(void *clientp, double dltotal, double dlnow, dou
 
 int HttpHInternal::progress_cb(double dltotal, double dlnow, double ultotal, double ulnow)
 {
+	//posts are read by curl itself so uploads are charged here as they go out
+	if (ulnow < m_dLastUlNow)
+		m_dLastUlNow = 0.0;
+
+	if (ulnow > m_dLastUlNow)
+	{
+		throttle(UTIL::WEB::TrafficDirection::Upload, (uint64)(ulnow - m_dLastUlNow));
+		m_dLastUlNow = ulnow;
+	}
+
 	Prog_s temp;
 	temp.dltotal = dltotal;
 	temp.dlnow = dlnow;
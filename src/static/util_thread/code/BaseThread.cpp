@@ -23,6 +23,7 @@ Contact us at legal@badjuju.com.
 
 #include "Common.h"
 #include "util_thread/BaseThread.h"
+#include "util/UtilTimeline.h"
 
 #include <thread>
 #include <mutex>
@@ -45,47 +46,50 @@ void waitOnMutex(std::condition_variable &waitCond, std::mutex &waitMutex)
 	waitCond.wait(lock);
 }
 
-//! Returns true if timeout hit
-bool timedWaitOnMutex(std::condition_variable &waitCond, std::mutex &waitMutex, int secs, int msecs)
-{
-	auto span = std::chrono::seconds(secs) + std::chrono::milliseconds(msecs);
-
-	std::unique_lock<std::mutex> lock(waitMutex);
-	return waitCond.wait_for(lock, span) == std::cv_status::timeout;
-}
-
 
 
 class WaitCondition::WaitConditionPrivates
 {
 public:
-	bool checkNotify()
+	//! Waits for a notify. Returns true if the timeout was hit
+	//! The notify flag is checked and set under the same lock as the wait so a notify
+	//! that lands between the check and the wait cant be lost
+	bool waitForNotify(int secs, int msecs, bool bInfinite)
 	{
-		std::lock_guard<std::mutex> guard(m_NotifyLock);
+		std::unique_lock<std::mutex> lock(m_WaitMutex);
+
+		auto pred = [this](){ return m_bNotify; };
 
-		if (!m_bNotify)
-			return false;
+		if (bInfinite)
+		{
+			m_WaitCond.wait(lock, pred);
+		}
+		else
+		{
+			auto span = std::chrono::seconds(secs) + std::chrono::milliseconds(msecs);
+
+			if (!m_WaitCond.wait_for(lock, span, pred))
+				return true;
+		}
 
 		m_bNotify = false;
-		return true;
+		return false;
 	}
 
-	void setNotify(bool state)
+	void setNotify()
 	{
-		std::lock_guard<std::mutex> guard(m_NotifyLock);
-
-		m_bNotify = state;
+		{
+			std::lock_guard<std::mutex> guard(m_WaitMutex);
+			m_bNotify = true;
+		}
 
-		if (state)
-			m_WaitCond.notify_all();
+		m_WaitCond.notify_all();
 	}
 
+private:
 	std::condition_variable m_WaitCond;
 	std::mutex m_WaitMutex;
-
-private:
-	std::mutex m_NotifyLock;
-	volatile bool m_bNotify = false;
+	bool m_bNotify = false;
 };
 
 
@@ -101,27 +105,17 @@ WaitCondition::~WaitCondition()
 
 void WaitCondition::wait()
 {
-	while (wait(0, 500))
-	{
-	}
+	m_pPrivates->waitForNotify(0, 0, true);
 }
 
 bool WaitCondition::wait(int sec, int msec)
 {
-	if (m_pPrivates->checkNotify())
-		return false;
-
-	bool res = timedWaitOnMutex(m_pPrivates->m_WaitCond, m_pPrivates->m_WaitMutex, sec, msec);
-
-	if (m_pPrivates->checkNotify())
-		res = false;
-
-	return res;
+	return m_pPrivates->waitForNotify(sec, msec, false);
 }
 
 void WaitCondition::notify()
 {
-	m_pPrivates->setNotify(true);
+	m_pPrivates->setNotify();
 }
 
 
@@ -224,6 +218,7 @@ void BaseThread::start()
 			Warning("Unhandled exception in thread {0}", m_pPrivates->m_szName);
 		}
 
+		UTIL::TIMELINE::GetTimeline().threadExited();
 		gcTrace("Ending thread {0}", m_pPrivates->m_szName);
 	});
 
@@ -381,6 +376,7 @@ void BaseThread::setThreadName(const char* nameOveride)
 		nameOveride = m_pPrivates->m_szName.c_str();
 
 	Debug("Setting thread name to: {0}\n", nameOveride);
+	UTIL::TIMELINE::GetTimeline().setThreadName(nameOveride);
 
 #if defined(WIN32) && !defined(__MINGW32__)
 	THREADNAME_INFO info;
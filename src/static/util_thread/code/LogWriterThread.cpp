@@ -0,0 +1,214 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "util_thread/LogWriterThread.h"
+
+using namespace Thread;
+
+namespace
+{
+	const size_t g_nFileBufferSize = 64 * 1024;
+}
+
+class LogWriterThread::LogEntry
+{
+public:
+	LogEntry()
+		: m_pNext(nullptr)
+		, m_Type(MT_MSG)
+		, m_bHasColor(false)
+		, m_Color(0)
+	{
+	}
+
+	LogEntry(MSG_TYPE type, const char* szMessage, Color* pColor)
+		: m_pNext(nullptr)
+		, m_Type(type)
+		, m_bHasColor(pColor != nullptr)
+		, m_Color(pColor ? *pColor : Color(0))
+		, m_strMessage(szMessage ? szMessage : "")
+	{
+	}
+
+	std::atomic<LogEntry*> m_pNext;
+
+	MSG_TYPE m_Type;
+	bool m_bHasColor;
+	Color m_Color;
+	std::string m_strMessage;
+};
+
+
+LogWriterThread::LogWriterThread(const char* szLogFile, const SinkFn &sink)
+	: BaseThread("Log Writer Thread")
+	, m_Sink(sink)
+	, m_szLogFile(szLogFile)
+	, m_pStub(new LogEntry())
+	, m_bWaiting(false)
+	, m_nWritten(0)
+{
+	m_pHead = m_pStub;
+	m_pTail = m_pStub;
+}
+
+LogWriterThread::~LogWriterThread()
+{
+	stop();
+
+	//thread might never have been started
+	drain();
+
+	if (m_pFile)
+		fclose(m_pFile);
+
+	safe_delete(m_pStub);
+}
+
+void LogWriterThread::push(MSG_TYPE type, const char* szMessage, Color* pColor)
+{
+	enqueue(new LogEntry(type, szMessage, pColor));
+
+	//Only pay for the notify if the writer is actually asleep
+	if (m_bWaiting.exchange(false))
+		m_WaitCond.notify();
+}
+
+uint64 LogWriterThread::getWrittenCount() const
+{
+	return m_nWritten;
+}
+
+void LogWriterThread::run()
+{
+	if (!m_szLogFile.empty())
+	{
+		UTIL::FS::recMakeFolder(UTIL::FS::PathWithFile(m_szLogFile));
+		m_pFile = Safe::fopen(m_szLogFile.c_str(), "a");
+
+		if (m_pFile)
+		{
+			m_vFileBuffer.resize(g_nFileBufferSize);
+			setvbuf(m_pFile, &m_vFileBuffer[0], _IOFBF, m_vFileBuffer.size());
+		}
+	}
+
+	while (!isStopped())
+	{
+		if (drain())
+			continue;
+
+		if (m_pFile)
+			fflush(m_pFile);
+
+		m_bWaiting = true;
+
+		//a producer might have pushed between the drain and setting the flag
+		if (drain())
+		{
+			m_bWaiting = false;
+			continue;
+		}
+
+		m_WaitCond.wait(1);
+		m_bWaiting = false;
+	}
+
+	drain();
+
+	if (m_pFile)
+		fflush(m_pFile);
+}
+
+void LogWriterThread::onStop()
+{
+	m_WaitCond.notify();
+}
+
+bool LogWriterThread::drain()
+{
+	bool bWritten = false;
+
+	while (LogEntry* pEntry = dequeue())
+	{
+		write(pEntry);
+		delete pEntry;
+
+		bWritten = true;
+	}
+
+	return bWritten;
+}
+
+void LogWriterThread::write(LogEntry* pEntry)
+{
+	if (m_Sink)
+		m_Sink(pEntry->m_Type, pEntry->m_strMessage.c_str(), pEntry->m_bHasColor ? &pEntry->m_Color : nullptr);
+
+	if (m_pFile)
+		fwrite(pEntry->m_strMessage.c_str(), 1, pEntry->m_strMessage.size(), m_pFile);
+
+	++m_nWritten;
+}
+
+void LogWriterThread::enqueue(LogEntry* pEntry)
+{
+	pEntry->m_pNext = nullptr;
+
+	LogEntry* pPrev = m_pHead.exchange(pEntry);
+	pPrev->m_pNext = pEntry;
+}
+
+LogWriterThread::LogEntry* LogWriterThread::dequeue()
+{
+	LogEntry* pTail = m_pTail;
+	LogEntry* pNext = pTail->m_pNext;
+
+	if (pTail == m_pStub)
+	{
+		if (!pNext)
+			return nullptr;
+
+		m_pTail = pNext;
+		pTail = pNext;
+		pNext = pNext->m_pNext;
+	}
+
+	if (pNext)
+	{
+		m_pTail = pNext;
+		return pTail;
+	}
+
+	//producer is half way through a push, pick it up next time round
+	if (pTail != m_pHead)
+		return nullptr;
+
+	enqueue(m_pStub);
+	pNext = pTail->m_pNext;
+
+	if (pNext)
+	{
+		m_pTail = pNext;
+		return pTail;
+	}
+
+	return nullptr;
+}
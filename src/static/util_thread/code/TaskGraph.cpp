@@ -0,0 +1,350 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "util_thread/TaskGraph.h"
+#include "util/UtilTimeline.h"
+
+using namespace Thread;
+
+namespace
+{
+	enum class TaskState
+	{
+		Pending,
+		Running,
+		Done,
+		Failed,
+		Skipped,
+	};
+
+	const char* GetStateName(TaskState state)
+	{
+		switch (state)
+		{
+		case TaskState::Pending:
+			return "pending";
+		case TaskState::Running:
+			return "running";
+		case TaskState::Done:
+			return "done";
+		case TaskState::Failed:
+			return "failed";
+		case TaskState::Skipped:
+			return "skipped";
+		};
+
+		return "unknown";
+	}
+}
+
+class TaskGraph::Task
+{
+public:
+	gcString m_szName;
+	TaskFn m_fnTask;
+
+	std::vector<TaskId> m_vDependents;
+	uint32 m_nDepends = 0;
+	uint32 m_nWaiting = 0;
+
+	TaskState m_State = TaskState::Pending;
+	std::chrono::steady_clock::time_point m_Start;
+	std::chrono::steady_clock::time_point m_End;
+};
+
+class TaskGraph::PoolTask : public BaseTask
+{
+public:
+	PoolTask(TaskGraph* pGraph, TaskId id)
+		: m_pGraph(pGraph)
+		, m_Id(id)
+	{
+	}
+
+	const char* getName() override
+	{
+		return "TaskGraph";
+	}
+
+	void doTask() override
+	{
+		m_pGraph->runTask(m_Id);
+	}
+
+private:
+	TaskGraph* m_pGraph;
+	const TaskId m_Id;
+};
+
+
+TaskGraph::TaskGraph(const char* szName)
+	: m_szName(szName)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+	safe_delete(m_vTasks);
+}
+
+TaskGraph::TaskId TaskGraph::addTask(const char* szName, const TaskFn &fnTask, const std::vector<TaskId> &vDepends)
+{
+	TaskId id = m_vTasks.size();
+
+	auto task = new Task();
+	task->m_szName = szName;
+	task->m_fnTask = fnTask;
+
+	for (auto dep : vDepends)
+	{
+		gcAssert(dep < id);
+
+		if (dep >= id)
+			continue;
+
+		m_vTasks[dep]->m_vDependents.push_back(id);
+		task->m_nDepends++;
+	}
+
+	m_vTasks.push_back(task);
+	return id;
+}
+
+void TaskGraph::run(const gcRefPtr<ThreadPoolI> &pPool)
+{
+	std::vector<TaskId> vReady;
+
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+
+		m_Start = std::chrono::steady_clock::now();
+		m_nFinished = 0;
+		m_vReady.clear();
+		m_pException = std::exception_ptr();
+		m_bCancelled = false;
+
+		for (TaskId x=0; x<m_vTasks.size(); x++)
+		{
+			m_vTasks[x]->m_State = TaskState::Pending;
+			m_vTasks[x]->m_nWaiting = m_vTasks[x]->m_nDepends;
+
+			if (m_vTasks[x]->m_nDepends == 0)
+				vReady.push_back(x);
+		}
+	}
+
+	if (!pPool)
+	{
+		//dependencies always point backwards so going in order is a valid schedule
+		for (TaskId x=0; x<m_vTasks.size(); x++)
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_Lock);
+
+				if (m_vTasks[x]->m_State != TaskState::Pending)
+					continue;
+
+				m_vTasks[x]->m_State = TaskState::Running;
+			}
+
+			runTask(x);
+		}
+	}
+	else
+	{
+		for (auto id : vReady)
+			startTask(id, pPool);
+
+		std::unique_lock<std::mutex> lock(m_Lock);
+
+		while (m_nFinished < m_vTasks.size())
+		{
+			m_FinishedCond.wait(lock, [this](){
+				return !m_vReady.empty() || m_nFinished == m_vTasks.size();
+			});
+
+			std::vector<TaskId> vStart;
+			vStart.swap(m_vReady);
+
+			lock.unlock();
+
+			for (auto id : vStart)
+				startTask(id, pPool);
+
+			lock.lock();
+		}
+	}
+
+	std::exception_ptr pException;
+
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+		m_End = std::chrono::steady_clock::now();
+		pException = m_pException;
+	}
+
+	if (pException)
+		std::rethrow_exception(pException);
+}
+
+void TaskGraph::cancel()
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	m_bCancelled = true;
+
+	for (auto task : m_vTasks)
+	{
+		if (task->m_State != TaskState::Pending)
+			continue;
+
+		task->m_State = TaskState::Skipped;
+		m_nFinished++;
+	}
+
+	m_vReady.clear();
+	m_FinishedCond.notify_all();
+}
+
+bool TaskGraph::isCancelled() const
+{
+	return m_bCancelled;
+}
+
+void TaskGraph::startTask(TaskId id, const gcRefPtr<ThreadPoolI> &pPool)
+{
+	{
+		std::lock_guard<std::mutex> guard(m_Lock);
+
+		//cancelled between becoming ready and starting
+		if (m_vTasks[id]->m_State != TaskState::Pending)
+			return;
+
+		m_vTasks[id]->m_State = TaskState::Running;
+	}
+
+	pPool->forceTask(gcRefPtr<PoolTask>::create(this, id));
+}
+
+void TaskGraph::runTask(TaskId id)
+{
+	auto task = m_vTasks[id];
+	std::exception_ptr pException;
+
+	auto start = std::chrono::steady_clock::now();
+
+	{
+		UTIL::TIMELINE::ScopedSpan span("startup", task->m_szName.c_str(), "{0}", m_szName);
+
+		try
+		{
+			task->m_fnTask();
+		}
+		catch (...)
+		{
+			pException = std::current_exception();
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	task->m_Start = start;
+	task->m_End = std::chrono::steady_clock::now();
+
+	onTaskComplete(id, pException);
+	m_FinishedCond.notify_all();
+}
+
+void TaskGraph::onTaskComplete(TaskId id, std::exception_ptr pException)
+{
+	auto task = m_vTasks[id];
+	m_nFinished++;
+
+	if (pException)
+	{
+		task->m_State = TaskState::Failed;
+
+		if (!m_pException)
+			m_pException = pException;
+
+		skipDependents(id);
+		return;
+	}
+
+	task->m_State = TaskState::Done;
+
+	for (auto dep : task->m_vDependents)
+	{
+		auto depTask = m_vTasks[dep];
+
+		if (depTask->m_State != TaskState::Pending)
+			continue;
+
+		depTask->m_nWaiting--;
+
+		if (depTask->m_nWaiting == 0)
+			m_vReady.push_back(dep);
+	}
+}
+
+void TaskGraph::skipDependents(TaskId id)
+{
+	for (auto dep : m_vTasks[id]->m_vDependents)
+	{
+		auto depTask = m_vTasks[dep];
+
+		if (depTask->m_State != TaskState::Pending)
+			continue;
+
+		depTask->m_State = TaskState::Skipped;
+		m_nFinished++;
+
+		skipDependents(dep);
+	}
+}
+
+gcString TaskGraph::getReport() const
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+
+	auto toMs = [this](std::chrono::steady_clock::time_point time) -> int64
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(time - m_Start).count();
+	};
+
+	gcString szReport("{0} took {1}ms\n", m_szName, toMs(m_End));
+
+	for (auto task : m_vTasks)
+	{
+		if (task->m_State == TaskState::Done || task->m_State == TaskState::Failed)
+			szReport += gcString("\t{0}: start {1}ms, took {2}ms, {3}\n", task->m_szName, toMs(task->m_Start), toMs(task->m_End) - toMs(task->m_Start), GetStateName(task->m_State));
+		else
+			szReport += gcString("\t{0}: {1}\n", task->m_szName, GetStateName(task->m_State));
+	}
+
+	return szReport;
+}
+
+std::chrono::milliseconds TaskGraph::getDuration() const
+{
+	std::lock_guard<std::mutex> guard(m_Lock);
+	return std::chrono::duration_cast<std::chrono::milliseconds>(m_End - m_Start);
+}
@@ -23,6 +23,13 @@ Contact us at legal@badjuju.com.
 #include "Common.h"
 #include "util_thread/ThreadPool.h"
 #include "ThreadPoolThread.h"
+#include "util/UtilMetrics.h"
+
+#include <condition_variable>
+
+static UTIL::METRICS::Gauge &g_QueueDepth = UTIL::METRICS::GetRegistry().gauge("threadpool.queue_depth");
+static UTIL::METRICS::Counter &g_TasksQueued = UTIL::METRICS::GetRegistry().counter("threadpool.tasks_queued");
+static UTIL::METRICS::Histogram &g_QueueWait = UTIL::METRICS::GetRegistry().histogram("threadpool.queue_wait_us");
 
 class ThreadPoolTaskSource : public Thread::ThreadPoolTaskSourceI
 {
@@ -76,6 +83,7 @@ void ThreadPool::cleanup()
 
 	{
 		std::lock_guard<std::mutex> guard(m_TaskMutex);
+		g_QueueDepth.add(-(int64)m_vTaskList.size());
 		m_vTaskList.clear();
 	}
 
@@ -141,11 +149,15 @@ void ThreadPool::purgeTasks()
 			m_vForcedList.clear();
 		}
 
+		g_QueueDepth.add(-(int64)m_vTaskList.size());
 		m_vTaskList.clear();
 	}
 
-	while (activeThreads() > 0)
-		gcSleep(50);
+	//onThreadComplete wakes us each time a worker finishes its task
+	std::unique_lock<std::mutex> lock(m_IdleMutex);
+	m_IdleCond.wait(lock, [this](){
+		return activeThreads() == 0;
+	});
 }
 
 void ThreadPool::queueTask(gcRefPtr<BaseTask> pTask)
@@ -161,9 +173,12 @@ void ThreadPool::queueTask(gcRefPtr<BaseTask> pTask)
 
 	{
 		std::lock_guard<std::mutex> guardTask(m_TaskMutex);
-		m_vTaskList.push_back(pTask);
+		m_vTaskList.push_back(std::make_pair(pTask, std::chrono::steady_clock::now()));
 	}
 
+	g_QueueDepth.add(1);
+	g_TasksQueued.add();
+
 	//get thread running again.
 	m_WaitCondition.notify();
 }
@@ -326,6 +341,12 @@ void ThreadPool::removedForced()
 
 void ThreadPool::onThreadComplete()
 {
+	{
+		std::lock_guard<std::mutex> guard(m_IdleMutex);
+	}
+
+	m_IdleCond.notify_all();
+
 	if (isStopped())
 		return;
 
@@ -340,8 +361,13 @@ gcRefPtr<BaseTask> ThreadPool::getTask()
 
 	if (m_vTaskList.size() > 0)
 	{
-		task = m_vTaskList.front();
+		auto &front = m_vTaskList.front();
+
+		task = front.first;
+		g_QueueWait.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - front.second).count());
+
 		m_vTaskList.pop_front();
+		g_QueueDepth.add(-1);
 	}
 
 	return task;
@@ -0,0 +1,389 @@
+/*
+Copyright (C) 2011 Mark Chandler (Desura Net Pty Ltd)
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "IPCBenchClass.h"
+#include "util/UtilMetrics.h"
+
+#ifdef NIX
+#include "IPCSharedPayload.h"
+#endif
+
+#include <chrono>
+#include <deque>
+#include <thread>
+
+using namespace IPC;
+using namespace UTIL::METRICS;
+
+typedef std::chrono::steady_clock BenchClock;
+
+REG_IPC_CLASS(IPCBenchClass);
+
+bool IsLogEnabled(MSG_TYPE type)
+{
+	return type == MT_WARN;
+}
+
+void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
+{
+	fprintf(stderr, "%s", msg.c_str());
+}
+
+void LogTrace(const TraceEvent &event)
+{
+	LogTraceAsMsg(event);
+}
+
+static void DispHelp()
+{
+	printf("Usage: ipc_bench [options]\n");
+	printf("\n");
+	printf("Runs an ipc server and client in this process and prints the results as json.\n");
+	printf("\n");
+	printf("  -s, --scale N              Multiply the number of calls by N (default 1)\n");
+	printf("  -t, --shared-threshold N   Send payloads of N bytes or more through shared memory.\n");
+	printf("                             0 keeps everything on the pipe\n");
+	printf("  -o, --out FILE             Write the json to FILE instead of stdout\n");
+	printf("  -h, --help                 Shows this help\n");
+}
+
+static double ToSeconds(BenchClock::duration d)
+{
+	return std::chrono::duration<double>(d).count();
+}
+
+static uint64 ToNanoSeconds(BenchClock::duration d)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+//! Latency percentiles in micro seconds from a histogram recorded in nano seconds
+static gcString FormatLatency(const Histogram &histogram)
+{
+	auto s = histogram.snapshot();
+
+	return gcString("\"p50_us\": {0}, \"p90_us\": {1}, \"p99_us\": {2}, \"max_us\": {3}",
+		s.getPercentile(50) / 1000.0, s.getPercentile(90) / 1000.0, s.getPercentile(99) / 1000.0, s.m_nMax / 1000.0);
+}
+
+
+class Bench
+{
+public:
+	Bench(uint32 nScale, uint32 nSharedThreshold)
+		: m_Pipes(gcString("ipc_bench-{0}", (uint64)time(nullptr)).c_str())
+		, m_nScale(nScale)
+	{
+		m_Pipes.setSharedPayloadThreshold(nSharedThreshold);
+	}
+
+	std::shared_ptr<IPCBenchClass> newClass()
+	{
+		return m_Pipes.newClass();
+	}
+
+	void runSmallCalls(std::string &strOut)
+	{
+		auto bench = newClass();
+		const uint32 nCalls = 10000 * m_nScale;
+
+		Histogram latency;
+		auto start = BenchClock::now();
+
+		for (uint32 x = 0; x < nCalls; x++)
+		{
+			auto callStart = BenchClock::now();
+			bench->sendPing(x);
+			latency.record(ToNanoSeconds(BenchClock::now() - callStart));
+		}
+
+		double dBlocking = nCalls / ToSeconds(BenchClock::now() - start);
+
+		//async calls only count once the sync call queued behind them comes back
+		start = BenchClock::now();
+
+		for (uint32 x = 0; x < nCalls; x++)
+			bench->sendNotify(x);
+
+		bench->sendPing(0);
+		double dAsync = nCalls / ToSeconds(BenchClock::now() - start);
+
+		const uint32 nInFlight = 32;
+		std::deque<std::future<uint32>> dqPending;
+
+		start = BenchClock::now();
+
+		for (uint32 x = 0; x < nCalls; x++)
+		{
+			if (dqPending.size() == nInFlight)
+			{
+				dqPending.front().get();
+				dqPending.pop_front();
+			}
+
+			dqPending.push_back(bench->sendPingFuture(x));
+		}
+
+		for (auto &f : dqPending)
+			f.get();
+
+		double dPipelined = nCalls / ToSeconds(BenchClock::now() - start);
+
+		strOut += gcString("{ \"calls\": {0}, \"blocking\": { \"calls_per_sec\": {1}, {2} }, ", nCalls, (uint64)dBlocking, FormatLatency(latency));
+		strOut += gcString("\"async\": { \"calls_per_sec\": {0} }, ", (uint64)dAsync);
+		strOut += gcString("\"pipelined\": { \"in_flight\": {0}, \"calls_per_sec\": {1} } }", nInFlight, (uint64)dPipelined);
+	}
+
+	void runEvents(std::string &strOut)
+	{
+		const uint32 vClasses[] = { 1, 4, 16 };
+		bool bFirst = true;
+
+		strOut += "[ ";
+
+		for (auto nClasses : vClasses)
+		{
+			const uint32 nEvents = 20000 * m_nScale / nClasses;
+
+			std::vector<std::shared_ptr<IPCBenchClass>> vBench;
+
+			for (uint32 x = 0; x < nClasses; x++)
+				vBench.push_back(newClass());
+
+			auto start = BenchClock::now();
+
+			for (auto &b : vBench)
+				b->sendFireEvents(nEvents);
+
+			bool bComplete = true;
+
+			for (auto &b : vBench)
+				bComplete = b->waitForEvents(nEvents, 60 * 1000) && bComplete;
+
+			double dSeconds = ToSeconds(BenchClock::now() - start);
+
+			if (!bFirst)
+				strOut += ", ";
+
+			bFirst = false;
+			strOut += gcString("{ \"classes\": {0}, \"events\": {1}, \"complete\": {2}, \"events_per_sec\": {3} }",
+				nClasses, nEvents * nClasses, bComplete ? "true" : "false", (uint64)(nEvents * nClasses / dSeconds));
+		}
+
+		strOut += " ]";
+	}
+
+	void runBlobs(std::string &strOut)
+	{
+		//part messages count to 255 so the pipe path tops out just under 1mb
+		const uint32 vSizes[] = { 1024, 16 * 1024, 64 * 1024, 256 * 1024, 512 * 1024 };
+		bool bFirst = true;
+
+		auto bench = newClass();
+		strOut += "[ ";
+
+		for (auto nSize : vSizes)
+		{
+			const uint32 nCalls = std::max<uint32>(20, (64 * 1024 * 1024 / nSize) * m_nScale / 8);
+
+			std::vector<char> vData(nSize, 'd');
+			PBlob blob(&vData[0], nSize);
+
+			Histogram latency;
+			bool bValid = true;
+
+			auto start = BenchClock::now();
+
+			for (uint32 x = 0; x < nCalls; x++)
+			{
+				auto callStart = BenchClock::now();
+				bValid = bench->sendBlob(blob) == nSize && bValid;
+				latency.record(ToNanoSeconds(BenchClock::now() - callStart));
+			}
+
+			double dSeconds = ToSeconds(BenchClock::now() - start);
+			double dMbs = ((double)nSize * nCalls / (1024.0 * 1024.0)) / dSeconds;
+
+			if (!bFirst)
+				strOut += ", ";
+
+			bFirst = false;
+			strOut += gcString("{ \"size\": {0}, \"calls\": {1}, \"valid\": {2}, \"mb_per_sec\": {3}, {4} }",
+				nSize, nCalls, bValid ? "true" : "false", (uint64)dMbs, FormatLatency(latency));
+		}
+
+		strOut += " ]";
+	}
+
+	void runConcurrentClasses(std::string &strOut)
+	{
+		const uint32 vClasses[] = { 1, 4, 16, 64 };
+		bool bFirst = true;
+
+		strOut += "[ ";
+
+		for (auto nClasses : vClasses)
+		{
+			const uint32 nCalls = std::max<uint32>(100, 8000 * m_nScale / nClasses);
+
+			std::vector<std::shared_ptr<IPCBenchClass>> vBench;
+
+			for (uint32 x = 0; x < nClasses; x++)
+				vBench.push_back(newClass());
+
+			Histogram latency;
+			std::vector<std::thread> vThreads;
+
+			auto start = BenchClock::now();
+
+			for (auto &b : vBench)
+			{
+				auto bench = b;
+
+				vThreads.push_back(std::thread([bench, nCalls, &latency]()
+				{
+					for (uint32 x = 0; x < nCalls; x++)
+					{
+						auto callStart = BenchClock::now();
+						bench->sendPing(x);
+						latency.record(ToNanoSeconds(BenchClock::now() - callStart));
+					}
+				}));
+			}
+
+			for (auto &t : vThreads)
+				t.join();
+
+			double dSeconds = ToSeconds(BenchClock::now() - start);
+
+			if (!bFirst)
+				strOut += ", ";
+
+			bFirst = false;
+			strOut += gcString("{ \"classes\": {0}, \"calls\": {1}, \"calls_per_sec\": {2}, {3} }",
+				nClasses, nCalls * nClasses, (uint64)(nCalls * nClasses / dSeconds), FormatLatency(latency));
+		}
+
+		strOut += " ]";
+	}
+
+private:
+	IPCBenchPipes m_Pipes;
+	const uint32 m_nScale;
+};
+
+
+int main(int argc, char** argv)
+{
+	uint32 nScale = 1;
+	std::string strOutFile;
+
+#ifdef NIX
+	uint32 nSharedThreshold = IPC_SHAREDPAYLOAD_THRESHOLD;
+	const char* szTransport = "unix_socket";
+#else
+	uint32 nSharedThreshold = 0;
+	const char* szTransport = "named_pipe";
+#endif
+
+	for (int x = 1; x < argc; ++x)
+	{
+		std::string strArg(argv[x]);
+		bool bHasValue = x + 1 < argc;
+
+		if ((strArg == "-s" || strArg == "--scale") && bHasValue)
+		{
+			nScale = std::max(1, atoi(argv[++x]));
+		}
+		else if ((strArg == "-t" || strArg == "--shared-threshold") && bHasValue)
+		{
+			nSharedThreshold = (uint32)atoi(argv[++x]);
+		}
+		else if ((strArg == "-o" || strArg == "--out") && bHasValue)
+		{
+			strOutFile = argv[++x];
+		}
+		else if (strArg == "-h" || strArg == "--help")
+		{
+			DispHelp();
+			return 0;
+		}
+		else
+		{
+			DispHelp();
+			return 1;
+		}
+	}
+
+	std::string strOut;
+
+	try
+	{
+		Bench bench(nScale, nSharedThreshold);
+
+		strOut += gcString("{ \"transport\": \"{0}\", \"shared_threshold\": {1}, \"scale\": {2}", szTransport, nSharedThreshold, nScale);
+
+		strOut += ", \"small_calls\": ";
+		bench.runSmallCalls(strOut);
+
+		strOut += ", \"events\": ";
+		bench.runEvents(strOut);
+
+		strOut += ", \"blobs\": ";
+		bench.runBlobs(strOut);
+
+		strOut += ", \"concurrent_classes\": ";
+		bench.runConcurrentClasses(strOut);
+
+		Snapshot snapshot;
+		GetRegistry().snapshot(snapshot);
+
+		strOut += ", \"metrics\": ";
+		snapshot.toJson(strOut);
+
+		strOut += " }\n";
+	}
+	catch (gcException &e)
+	{
+		fprintf(stderr, "IPC benchmark failed: %s\n", e.getErrMsg());
+		return 1;
+	}
+
+	if (strOutFile.empty())
+	{
+		printf("%s", strOut.c_str());
+		return 0;
+	}
+
+	FILE* fh = fopen(strOutFile.c_str(), "w");
+
+	if (!fh)
+	{
+		fprintf(stderr, "Failed to open %s\n", strOutFile.c_str());
+		return 1;
+	}
+
+	fwrite(strOut.c_str(), 1, strOut.size(), fh);
+	fclose(fh);
+
+	return 0;
+}
@@ -71,6 +71,66 @@ public:
 	}
 };
 
+class CreateMCFIncremental : public UtilFunction
+{
+public:
+	virtual uint32 getNumArgs()
+	{
+		return 3;
+	}
+
+	virtual const char* getArgDesc(size_t index)
+	{
+		if (index == 0)
+			return "Src Folder";
+		else if (index == 1)
+			return "Prev Mcf";
+
+		return "Dest Mcf";
+	}
+
+	virtual const char* getFullArg()
+	{
+		return "createinc";
+	}
+
+	virtual const char getShortArg()
+	{
+		return 'e';
+	}
+
+	virtual const char* getDescription()
+	{
+		return "Creates a new mcf from a folder, copying unchanged files from the previous build's mcf";
+	}
+
+	virtual int performAction(std::vector<std::string> &args)
+	{
+		if (UTIL::FS::PathWithFile(args[1]) == UTIL::FS::PathWithFile(args[2]))
+		{
+			printf("Prev Mcf and Dest Mcf must be different files.\n");
+			return -1;
+		}
+
+		MCFCore::MCFI* prevHandle = mcfFactory();
+		prevHandle->setFile(args[1].c_str());
+		prevHandle->parseMCF();
+
+		MCFCore::MCFI* mcfHandle = mcfFactory();
+		mcfHandle->getProgEvent() += delegate((UtilFunction*)this, &UtilFunction::printProgress);
+		mcfHandle->getErrorEvent() += delegate((UtilFunction*)this, &UtilFunction::mcfError);
+
+		mcfHandle->setFile(args[2].c_str());
+		mcfHandle->setReuseMcf(prevHandle);
+		mcfHandle->parseFolder(args[0].c_str());
+		mcfHandle->saveMCF();
+
+		mcfDelFactory(mcfHandle);
+		mcfDelFactory(prevHandle);
+		return 0;
+	}
+};
+
 class CreateMCFDiff : public UtilFunction
 {
 public:
@@ -177,4 +237,5 @@ public:
 
 REG_FUNCTION(CreateMCFDiff)
 REG_FUNCTION(CreateMCF)
+REG_FUNCTION(CreateMCFIncremental)
 REG_FUNCTION(CreateNCMCF)
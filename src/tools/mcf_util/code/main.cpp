@@ -65,11 +65,21 @@ public:
 REG_FUNCTION(ShowVersion);
 
 
+bool IsLogEnabled(MSG_TYPE type)
+{
+	return true;
+}
+
 void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
 {
 	fprintf(stdout, "%s", msg.c_str());
 }
 
+void LogTrace(const TraceEvent &event)
+{
+	LogTraceAsMsg(event);
+}
+
 bool SortFunctionList(UtilFunction* a, UtilFunction* b)
 {
 	return a->getShortArg() < b->getShortArg();
@@ -0,0 +1,606 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include "Common.h"
+#include "XMLMacros.h"
+#include "util/UtilWeb.h"
+#include "util/UtilMetrics.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef WIN32
+#include <winsock2.h>
+
+typedef SOCKET BenchSocket;
+typedef int socklen_t;
+#define CloseSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef int BenchSocket;
+#define INVALID_SOCKET -1
+#define CloseSocket close
+#endif
+
+using namespace UTIL::METRICS;
+
+typedef std::chrono::steady_clock BenchClock;
+
+bool IsLogEnabled(MSG_TYPE type)
+{
+	return type == MT_WARN;
+}
+
+void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
+{
+	fprintf(stderr, "%s", msg.c_str());
+}
+
+void LogTrace(const TraceEvent &event)
+{
+	LogTraceAsMsg(event);
+}
+
+static void DispHelp()
+{
+	printf("Usage: poll_bench [options]\n");
+	printf("\n");
+	printf("Replays an update poll against a local http server in this process and prints the\n");
+	printf("results as json.\n");
+	printf("\n");
+	printf("  -f, --file FILE      Serve a recorded update poll response from FILE\n");
+	printf("  -n, --items N        Generate a response with N games of three branches each when\n");
+	printf("                       no file is given (default 2000)\n");
+	printf("  -p, --polls N        Number of polls after the first one (default 20)\n");
+	printf("  -d, --delta          Send the revision back and have the server answer with nothing\n");
+	printf("                       changed, like a server that supports delta polls\n");
+	printf("  -o, --out FILE       Write the json to FILE instead of stdout\n");
+	printf("  -h, --help           Shows this help\n");
+}
+
+static double ToMilliSeconds(BenchClock::duration d)
+{
+	return std::chrono::duration<double, std::milli>(d).count();
+}
+
+//! Cpu time used by the calling thread in nano seconds
+static uint64 GetThreadCpuTime()
+{
+#ifdef WIN32
+	FILETIME create, exit, kernel, user;
+
+	if (!GetThreadTimes(GetCurrentThread(), &create, &exit, &kernel, &user))
+		return 0;
+
+	uint64 k = ((uint64)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+	uint64 u = ((uint64)user.dwHighDateTime << 32) | user.dwLowDateTime;
+
+	return (k + u) * 100;
+#else
+	timespec ts;
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+		return 0;
+
+	return (uint64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static gcString GenerateResponse(uint32 nItems)
+{
+	gcString strXml("<updatepoll version=\"1\"><status code=\"0\"/><items><games>");
+
+	for (uint32 x=0; x<nItems; x++)
+	{
+		strXml += gcString("<game siteareaid=\"{0}\"><name>Game {0}</name><branches>", x+1);
+
+		for (uint32 y=0; y<3; y++)
+			strXml += gcString("<branch id=\"{0}\" platformid=\"100\"><name>Branch {1}</name><mcf id=\"{2}\"><build>{1}</build></mcf></branch>", x*3+y+1, y, x*3+y+1000);
+
+		strXml += "</branches></game>";
+	}
+
+	strXml += "</games></items></updatepoll>";
+	return strXml;
+}
+
+
+//! Minimal http server that answers every post with the same update poll response, or with an
+//! empty one when the client sends back a revision. One connection at a time, close after each.
+class HttpStandIn
+{
+public:
+	HttpStandIn(const std::string &strFull, const std::string &strDelta)
+		: m_strFull(strFull)
+		, m_strDelta(strDelta)
+	{
+		m_Listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+		if (m_Listen == INVALID_SOCKET)
+			throw gcException(ERR_SOCKET, "Failed to create the listen socket");
+
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+
+		socklen_t nLen = sizeof(addr);
+
+		if (bind(m_Listen, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(m_Listen, 8) != 0 || getsockname(m_Listen, (sockaddr*)&addr, &nLen) != 0)
+		{
+			CloseSocket(m_Listen);
+			throw gcException(ERR_SOCKET, "Failed to listen on the loop back address");
+		}
+
+		m_nPort = ntohs(addr.sin_port);
+		m_Thread = std::thread(&HttpStandIn::run, this);
+	}
+
+	~HttpStandIn()
+	{
+		m_bStop = true;
+
+		//accept doesnt return when the socket is closed on every platform so wake it with a connection
+		BenchSocket wake = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+		if (wake != INVALID_SOCKET)
+		{
+			sockaddr_in addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = htons(m_nPort);
+
+			connect(wake, (sockaddr*)&addr, sizeof(addr));
+			CloseSocket(wake);
+		}
+
+		m_Thread.join();
+		CloseSocket(m_Listen);
+	}
+
+	gcString getUrl() const
+	{
+		return gcString("http://127.0.0.1:{0}/2/updatepoll", m_nPort);
+	}
+
+protected:
+	void run()
+	{
+		while (!m_bStop)
+		{
+			BenchSocket client = accept(m_Listen, nullptr, nullptr);
+
+			if (client == INVALID_SOCKET)
+				continue;
+
+			if (!m_bStop)
+				handleRequest(client);
+
+			CloseSocket(client);
+		}
+	}
+
+	void handleRequest(BenchSocket client)
+	{
+		std::string strRequest;
+		size_t nHeaderEnd = std::string::npos;
+		char buff[16 * 1024];
+
+		while (nHeaderEnd == std::string::npos)
+		{
+			int nRead = recv(client, buff, sizeof(buff), 0);
+
+			if (nRead <= 0)
+				return;
+
+			strRequest.append(buff, nRead);
+			nHeaderEnd = strRequest.find("\r\n\r\n");
+		}
+
+		std::string strHeaders = strRequest.substr(0, nHeaderEnd);
+		std::transform(strHeaders.begin(), strHeaders.end(), strHeaders.begin(), ::tolower);
+
+		size_t nBodySize = 0;
+		size_t nPos = strHeaders.find("content-length:");
+
+		if (nPos != std::string::npos)
+			nBodySize = (size_t)atoll(strHeaders.c_str() + nPos + 15);
+
+		if (strHeaders.find("expect: 100-continue") != std::string::npos)
+			sendAll(client, "HTTP/1.1 100 Continue\r\n\r\n");
+
+		while (strRequest.size() < nHeaderEnd + 4 + nBodySize)
+		{
+			int nRead = recv(client, buff, sizeof(buff), 0);
+
+			if (nRead <= 0)
+				return;
+
+			strRequest.append(buff, nRead);
+		}
+
+		bool bDelta = strRequest.find("name=\"since\"", nHeaderEnd) != std::string::npos;
+		const std::string &strBody = bDelta ? m_strDelta : m_strFull;
+
+		std::string strResponse = gcString("HTTP/1.1 200 OK\r\nContent-Type: text/xml\r\nContent-Length: {0}\r\nConnection: close\r\n\r\n", strBody.size());
+		strResponse += strBody;
+
+		sendAll(client, strResponse);
+	}
+
+	void sendAll(BenchSocket client, const std::string &strData)
+	{
+		size_t nSent = 0;
+
+		while (nSent < strData.size())
+		{
+			int nRet = send(client, strData.c_str() + nSent, (int)(strData.size() - nSent), 0);
+
+			if (nRet <= 0)
+				return;
+
+			nSent += nRet;
+		}
+	}
+
+private:
+	const std::string m_strFull;
+	const std::string m_strDelta;
+
+	BenchSocket m_Listen = INVALID_SOCKET;
+	uint16 m_nPort = 0;
+
+	std::atomic<bool> m_bStop = {false};
+	std::thread m_Thread;
+};
+
+
+//! Client side of the update poll the way UpdateThreadOld and ItemManager run it, minus the
+//! parts that need a logged in user: post, parse, then fingerprint each item to find the ones
+//! that changed
+class PollClient
+{
+public:
+	struct PollResult
+	{
+		uint64 nCpuNs = 0;
+		uint64 nWallNs = 0;
+		uint64 nFetchNs = 0;
+		uint64 nParseNs = 0;
+		uint64 nFingerprintNs = 0;
+		uint32 nBytes = 0;
+		uint32 nItems = 0;
+		uint32 nChanged = 0;
+	};
+
+	PollClient(const gcString &strUrl, const std::vector<std::pair<std::string, uint32>> &vItems, bool bDelta)
+		: m_strUrl(strUrl)
+		, m_vItems(vItems)
+		, m_bDelta(bDelta)
+	{
+	}
+
+	PollResult poll()
+	{
+		PollResult res;
+
+		uint64 nCpuStart = GetThreadCpuTime();
+		auto start = BenchClock::now();
+
+		HttpHandle wc(m_strUrl.c_str());
+
+		wc->addPostText("appid", "100");
+		wc->addPostText("build", "0");
+
+		for (auto &item : m_vItems)
+			wc->addPostText(gcString("updates[{0}][{1}]", item.first, item.second).c_str(), "1");
+
+		if (m_bDelta && !m_strRevision.empty())
+			wc->addPostText("since", m_strRevision.c_str());
+
+		wc->postWeb();
+
+		auto fetched = BenchClock::now();
+
+		XML::gcXMLDocument doc(wc->getData(), wc->getDataSize());
+		uint32 nVersion = doc.ProcessStatus("updatepoll");
+
+		auto uNode = doc.GetRoot("updatepoll");
+		uNode.GetChild("revision", m_strRevision);
+
+		auto parsed = BenchClock::now();
+
+		if (nVersion == 1)
+		{
+			processItems("mod", uNode.FirstChildElement("items"), res);
+			processItems("game", uNode.FirstChildElement("items"), res);
+		}
+		else
+		{
+			uNode.FirstChildElement("platforms").for_each_child("platform", [&](const XML::gcXMLElement &platform)
+			{
+				processItems("mod", platform, res);
+				processItems("game", platform, res);
+			});
+		}
+
+		auto end = BenchClock::now();
+
+		res.nCpuNs = GetThreadCpuTime() - nCpuStart;
+		res.nWallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		res.nFetchNs = std::chrono::duration_cast<std::chrono::nanoseconds>(fetched - start).count();
+		res.nParseNs = std::chrono::duration_cast<std::chrono::nanoseconds>(parsed - fetched).count();
+		res.nFingerprintNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - parsed).count();
+		res.nBytes = wc->getDataSize();
+
+		return res;
+	}
+
+protected:
+	void processItems(const char* area, const XML::gcXMLElement &itemsNode, PollResult &res)
+	{
+		if (!itemsNode.IsValid())
+			return;
+
+		gcString rootArea = gcString(area) + "s";
+		auto areaNode = itemsNode.FirstChildElement(rootArea.c_str());
+
+		if (!areaNode.IsValid())
+			return;
+
+		areaNode.for_each_child(area, [&](const XML::gcXMLElement &itemNode)
+		{
+			gcString strKey("{0}/{1}", area, itemNode.GetAtt("siteareaid"));
+			uint64 nHash = itemNode.GetContentHash();
+
+			res.nItems++;
+
+			auto it = m_mFingerprints.find(strKey);
+
+			if (it != m_mFingerprints.end() && it->second == nHash)
+				return;
+
+			m_mFingerprints[strKey] = nHash;
+			res.nChanged++;
+		});
+	}
+
+private:
+	const gcString m_strUrl;
+	const std::vector<std::pair<std::string, uint32>> m_vItems;
+	const bool m_bDelta;
+
+	gcString m_strRevision;
+	std::map<std::string, uint64> m_mFingerprints;
+};
+
+
+//! Ids of every game and mod in the response so the client can ask for them like a real poll does
+static std::vector<std::pair<std::string, uint32>> GetPollItems(const std::string &strXml)
+{
+	std::vector<std::pair<std::string, uint32>> vItems;
+
+	XML::gcXMLDocument doc(strXml.c_str(), strXml.size());
+	uint32 nVersion = doc.ProcessStatus("updatepoll");
+	auto uNode = doc.GetRoot("updatepoll");
+
+	auto addItems = [&vItems](const XML::gcXMLElement &itemsNode)
+	{
+		for (auto area : { "game", "mod" })
+		{
+			itemsNode.FirstChildElement(gcString("{0}s", area).c_str()).for_each_child(area, [&](const XML::gcXMLElement &itemNode)
+			{
+				uint32 nId = 0;
+				itemNode.GetAtt("siteareaid", nId);
+				vItems.push_back(std::make_pair(gcString("{0}s", area), nId));
+			});
+		}
+	};
+
+	if (nVersion == 1)
+	{
+		auto itemsNode = uNode.FirstChildElement("items");
+
+		if (itemsNode.IsValid())
+			addItems(itemsNode);
+	}
+	else
+	{
+		uNode.FirstChildElement("platforms").for_each_child("platform", addItems);
+	}
+
+	return vItems;
+}
+
+static gcString FormatPoll(const PollClient::PollResult &res)
+{
+	return gcString("{ \"cpu_ms\": {0}, \"wall_ms\": {1}, \"fetch_ms\": {2}, \"parse_ms\": {3}, \"fingerprint_ms\": {4}, \"bytes\": {5}, \"items\": {6}, \"changed\": {7} }",
+		res.nCpuNs / 1000000.0, res.nWallNs / 1000000.0, res.nFetchNs / 1000000.0, res.nParseNs / 1000000.0, res.nFingerprintNs / 1000000.0,
+		res.nBytes, res.nItems, res.nChanged);
+}
+
+//! Percentiles in milli seconds from a histogram recorded in nano seconds
+static gcString FormatTimes(const Histogram &histogram)
+{
+	auto s = histogram.snapshot();
+
+	return gcString("{ \"mean_ms\": {0}, \"p50_ms\": {1}, \"p90_ms\": {2}, \"max_ms\": {3} }",
+		s.getMean() / 1000000.0, s.getPercentile(50) / 1000000.0, s.getPercentile(90) / 1000000.0, s.m_nMax / 1000000.0);
+}
+
+
+int main(int argc, char** argv)
+{
+	std::string strFile;
+	std::string strOutFile;
+	uint32 nItems = 2000;
+	uint32 nPolls = 20;
+	bool bDelta = false;
+
+	for (int x = 1; x < argc; ++x)
+	{
+		std::string strArg(argv[x]);
+		bool bHasValue = x + 1 < argc;
+
+		if ((strArg == "-f" || strArg == "--file") && bHasValue)
+		{
+			strFile = argv[++x];
+		}
+		else if ((strArg == "-n" || strArg == "--items") && bHasValue)
+		{
+			nItems = std::max(1, atoi(argv[++x]));
+		}
+		else if ((strArg == "-p" || strArg == "--polls") && bHasValue)
+		{
+			nPolls = std::max(1, atoi(argv[++x]));
+		}
+		else if (strArg == "-d" || strArg == "--delta")
+		{
+			bDelta = true;
+		}
+		else if ((strArg == "-o" || strArg == "--out") && bHasValue)
+		{
+			strOutFile = argv[++x];
+		}
+		else if (strArg == "-h" || strArg == "--help")
+		{
+			DispHelp();
+			return 0;
+		}
+		else
+		{
+			DispHelp();
+			return 1;
+		}
+	}
+
+#ifdef WIN32
+	WSADATA wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	std::string strFull;
+
+	if (!strFile.empty())
+	{
+		std::ifstream fs(strFile.c_str(), std::ios::binary);
+
+		if (!fs)
+		{
+			fprintf(stderr, "Failed to open %s\n", strFile.c_str());
+			return 1;
+		}
+
+		std::stringstream ss;
+		ss << fs.rdbuf();
+		strFull = ss.str();
+	}
+	else
+	{
+		strFull = GenerateResponse(nItems);
+	}
+
+	//servers only do delta polls when they hand out a revision
+	const char* szRevision = "<revision>bench</revision>";
+
+	if (bDelta && strFull.find("<revision>") == std::string::npos)
+	{
+		size_t nPos = strFull.rfind("</updatepoll>");
+
+		if (nPos != std::string::npos)
+			strFull.insert(nPos, szRevision);
+	}
+
+	std::string strDelta = gcString("<updatepoll version=\"1\"><status code=\"0\"/>{0}</updatepoll>", szRevision);
+	std::string strOut;
+
+	try
+	{
+		auto vItems = GetPollItems(strFull);
+
+		HttpStandIn server(strFull, strDelta);
+		PollClient client(server.getUrl(), vItems, bDelta);
+
+		//first poll sees every item for the first time
+		auto first = client.poll();
+
+		Histogram cpu;
+		Histogram wall;
+		PollClient::PollResult last;
+
+		for (uint32 x=0; x<nPolls; x++)
+		{
+			last = client.poll();
+
+			cpu.record(last.nCpuNs);
+			wall.record(last.nWallNs);
+		}
+
+		strOut += gcString("{ \"source\": \"{0}\", \"delta\": {1}, \"polls\": {2}, \"items\": {3}",
+			strFile.empty() ? "generated" : strFile.c_str(), bDelta ? "true" : "false", nPolls, vItems.size());
+
+		strOut += ", \"first_poll\": ";
+		strOut += FormatPoll(first);
+
+		strOut += ", \"last_poll\": ";
+		strOut += FormatPoll(last);
+
+		strOut += ", \"repeat_cpu\": ";
+		strOut += FormatTimes(cpu);
+
+		strOut += ", \"repeat_wall\": ";
+		strOut += FormatTimes(wall);
+
+		strOut += " }\n";
+	}
+	catch (gcException &e)
+	{
+		fprintf(stderr, "Poll benchmark failed: %s\n", e.getErrMsg());
+		return 1;
+	}
+
+	if (strOutFile.empty())
+	{
+		printf("%s", strOut.c_str());
+		return 0;
+	}
+
+	FILE* fh = fopen(strOutFile.c_str(), "w");
+
+	if (!fh)
+	{
+		fprintf(stderr, "Failed to open %s\n", strOutFile.c_str());
+		return 1;
+	}
+
+	fwrite(strOut.c_str(), 1, strOut.size(), fh);
+	fclose(fh);
+
+	return 0;
+}
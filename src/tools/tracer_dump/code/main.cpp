@@ -0,0 +1,175 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+
+*/
+
+
+#include "Common.h"
+#include "Tracer.h"
+
+#include <cerrno>
+#include <chrono>
+#include <thread>
+
+#ifdef NIX
+#include <signal.h>
+#endif
+
+bool IsLogEnabled(MSG_TYPE type)
+{
+	return true;
+}
+
+void LogMsg(MSG_TYPE type, std::string msg, Color* col, std::map<std::string, std::string> *mpArgs)
+{
+	fprintf(stderr, "%s", msg.c_str());
+}
+
+void LogTrace(const TraceEvent &event)
+{
+	LogTraceAsMsg(event);
+}
+
+static void DispHelp()
+{
+	printf("Usage: tracer_dump [options] [name]\n");
+	printf("\n");
+	printf("Dumps the trace ring buffer of a running (or crashed) Desura process.\n");
+	printf("Name defaults to DESURA_CLIENT_TRACER_OUTPUT.\n");
+	printf("\n");
+	printf("  -f, --follow    Keep printing new traces until the process exits\n");
+	printf("  -j, --json      Print records as json objects\n");
+	printf("  -h, --help      Shows this help\n");
+}
+
+static void PrintRecord(const TracerRecord &record, bool bJson)
+{
+	std::string strOut;
+
+	if (bJson)
+	{
+		record.formatJson(strOut);
+		printf("%s\n", strOut.c_str());
+		return;
+	}
+
+	time_t nSeconds = (time_t)(record.m_nTime / 1000000);
+	uint32 nMicro = (uint32)(record.m_nTime % 1000000);
+
+	struct tm t;
+#ifdef WIN32
+	localtime_s(&t, &nSeconds);
+#else
+	localtime_r(&nSeconds, &t);
+#endif
+
+	char szTime[64] = { 0 };
+	size_t nLen = strftime(szTime, sizeof(szTime), "%H:%M:%S", &t);
+	snprintf(szTime + nLen, sizeof(szTime) - nLen, ".%06u ", nMicro);
+
+	strOut = szTime;
+
+	if (record.m_bRaw)
+		strOut += gcString("[{0}] {1}: ", record.m_nThreadId, record.m_strFunction);
+
+	strOut += record.m_strMessage;
+
+	for (auto &p : record.m_vArgs)
+		strOut += gcString(" {0}={1}", p.first, p.second);
+
+	printf("%s\n", strOut.c_str());
+}
+
+static bool IsProcessAlive(uint32 nPid)
+{
+#ifdef NIX
+	return kill((pid_t)nPid, 0) == 0 || errno == EPERM;
+#else
+	HANDLE hProcess = OpenProcess(SYNCHRONIZE, FALSE, nPid);
+
+	if (!hProcess)
+		return false;
+
+	bool bAlive = WaitForSingleObject(hProcess, 0) == WAIT_TIMEOUT;
+	CloseHandle(hProcess);
+
+	return bAlive;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	bool bFollow = false;
+	bool bJson = false;
+	std::string strName = "DESURA_CLIENT_TRACER_OUTPUT";
+
+	for (int x = 1; x < argc; ++x)
+	{
+		std::string strArg(argv[x]);
+
+		if (strArg == "-f" || strArg == "--follow")
+		{
+			bFollow = true;
+		}
+		else if (strArg == "-j" || strArg == "--json")
+		{
+			bJson = true;
+		}
+		else if (strArg == "-h" || strArg == "--help")
+		{
+			DispHelp();
+			return 0;
+		}
+		else if (strArg[0] == '-')
+		{
+			DispHelp();
+			return 1;
+		}
+		else
+		{
+			strName = strArg;
+		}
+	}
+
+	TracerReader reader(strName);
+
+	if (!reader.isValid())
+	{
+		fprintf(stderr, "Failed to attach to tracer %s\n", strName.c_str());
+		return 1;
+	}
+
+	auto printFn = [bJson](const TracerRecord &record)
+	{
+		PrintRecord(record, bJson);
+	};
+
+	uint32 nLastSeq = reader.read(0, printFn);
+	fflush(stdout);
+
+	while (bFollow && IsProcessAlive(reader.getPid()))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		nLastSeq = reader.read(nLastSeq, printFn);
+		fflush(stdout);
+	}
+
+	return 0;
+}
@@ -30,7 +30,7 @@ namespace sqlite3x {
 
 sqlite3_command::sqlite3_command(sqlite3_connection &con, const char *sql) : con(con),refs(0) {
 	const char *tail=NULL;
-	if(sqlite3_prepare(con.db, sql, -1, &this->stmt, &tail)!=SQLITE_OK)
+	if(sqlite3_prepare_v2(con.db, sql, -1, &this->stmt, &tail)!=SQLITE_OK)
 		throw database_error(con);
 
 	this->argc=sqlite3_column_count(this->stmt);
@@ -38,7 +38,7 @@ sqlite3_command::sqlite3_command(sqlite3_connection &con, const char *sql) : con
 
 sqlite3_command::sqlite3_command(sqlite3_connection &con, const wchar_t *sql) : con(con),refs(0) {
 	const wchar_t *tail=NULL;
-	if(sqlite3_prepare16(con.db, sql, -1, &this->stmt, (const void**)&tail)!=SQLITE_OK)
+	if(sqlite3_prepare16_v2(con.db, sql, -1, &this->stmt, (const void**)&tail)!=SQLITE_OK)
 		throw database_error(con);
 
 	this->argc=sqlite3_column_count(this->stmt);
@@ -46,7 +46,7 @@ sqlite3_command::sqlite3_command(sqlite3_connection &con, const wchar_t *sql) :
 
 sqlite3_command::sqlite3_command(sqlite3_connection &con, const std::string &sql) : con(con),refs(0) {
 	const char *tail=NULL;
-	if(sqlite3_prepare(con.db, sql.data(), (int)sql.length(), &this->stmt, &tail)!=SQLITE_OK)
+	if(sqlite3_prepare_v2(con.db, sql.data(), (int)sql.length(), &this->stmt, &tail)!=SQLITE_OK)
 		throw database_error(con);
 
 	this->argc=sqlite3_column_count(this->stmt);
@@ -54,7 +54,7 @@ sqlite3_command::sqlite3_command(sqlite3_connection &con, const std::string &sql
 
 sqlite3_command::sqlite3_command(sqlite3_connection &con, const std::wstring &sql) : con(con),refs(0) {
 	const wchar_t *tail=NULL;
-	if(sqlite3_prepare16(con.db, sql.data(), (int)sql.length()*2, &this->stmt, (const void**)&tail)!=SQLITE_OK)
+	if(sqlite3_prepare16_v2(con.db, sql.data(), (int)sql.length()*2, &this->stmt, (const void**)&tail)!=SQLITE_OK)
 		throw database_error(con);
 
 	this->argc=sqlite3_column_count(this->stmt);
@@ -109,6 +109,13 @@ void sqlite3_command::bind(int index, const std::wstring &data) {
 		throw database_error(this->con);
 }
 
+void sqlite3_command::reset() {
+	if(this->refs) throw database_error("command is in use");
+
+	sqlite3_reset(this->stmt);
+	sqlite3_clear_bindings(this->stmt);
+}
+
 sqlite3_reader sqlite3_command::executereader() {
 	return sqlite3_reader(this);
 }
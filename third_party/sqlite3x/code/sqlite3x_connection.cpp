@@ -28,6 +28,10 @@
 
 namespace sqlite3x {
 
+static profile_callback g_profilecallback=NULL;
+
+void setprofilecallback(profile_callback cb) { g_profilecallback=cb; }
+
 sqlite3_connection::sqlite3_connection() : db(NULL) {}
 
 sqlite3_connection::sqlite3_connection(const char *db) : db(NULL) { this->open(db); }
@@ -39,11 +43,17 @@ sqlite3_connection::~sqlite3_connection() { if(this->db) sqlite3_close(this->db)
 void sqlite3_connection::open(const char *db) {
 	if(sqlite3_open(db, &this->db)!=SQLITE_OK)
 		throw database_error("unable to open database");
+
+	if(g_profilecallback)
+		sqlite3_profile(this->db, g_profilecallback, NULL);
 }
 
 void sqlite3_connection::open(const wchar_t *db) {
 	if(sqlite3_open16(db, &this->db)!=SQLITE_OK)
 		throw database_error("unable to open database");
+
+	if(g_profilecallback)
+		sqlite3_profile(this->db, g_profilecallback, NULL);
 }
 
 void sqlite3_connection::close() {
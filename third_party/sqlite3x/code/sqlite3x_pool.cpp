@@ -0,0 +1,269 @@
+/*
+Copyright (C) 2014 Bad Juju Games, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+
+Contact us at legal@badjuju.com.
+*/
+
+#include <sqlite3.h>
+#include "sqlite3x.hpp"
+
+#include <map>
+#include <vector>
+#include <mutex>
+
+namespace sqlite3x {
+
+//! Idle connections kept per database
+static const size_t MAX_IDLE_CONNECTIONS = 4;
+
+//! Statements kept per connection before the cache is flushed
+static const size_t MAX_CACHED_STATEMENTS = 64;
+
+//! Busy timeout so readers and writers on other connections wait for each other instead of failing
+static const int POOL_BUSY_TIMEOUT = 5000;
+
+static pool_warning_callback g_poolwarningcallback=NULL;
+
+void setpoolwarningcallback(pool_warning_callback cb) { g_poolwarningcallback=cb; }
+
+struct sqlite3_pool_entry {
+	sqlite3_pool_entry(const std::string &path) : path(path) {
+		con.open(path.c_str());
+	}
+
+	~sqlite3_pool_entry() {
+		for(std::map<std::string, sqlite3_command*>::iterator it=statements.begin(); it!=statements.end(); ++it)
+			delete it->second;
+	}
+
+	std::string path;
+	sqlite3_connection con;
+	std::map<std::string, sqlite3_command*> statements;
+};
+
+class sqlite3_pool {
+public:
+	sqlite3_pool() {
+		stats.opened=0;
+		stats.reused=0;
+		stats.prepared=0;
+		stats.cached=0;
+	}
+
+	~sqlite3_pool() {
+		close(NULL);
+	}
+
+	sqlite3_pool_entry* acquire(const std::string &path) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			std::vector<sqlite3_pool_entry*> &list=idle[path];
+
+			if(!list.empty()) {
+				sqlite3_pool_entry *entry=list.back();
+				list.pop_back();
+				++stats.reused;
+				return entry;
+			}
+
+			++stats.opened;
+		}
+
+		sqlite3_pool_entry *entry=new sqlite3_pool_entry(path);
+
+		// Each setting is optional, the connection still works without it
+		try {
+			entry->con.setbusytimeout(POOL_BUSY_TIMEOUT);
+		}
+		catch(database_error &e) {
+			warn(path, "busy timeout", e);
+		}
+
+		try {
+			// WAL can be refused (e.g. on network shares), in which case the default journal is fine
+			std::string mode=entry->con.executestring("PRAGMA journal_mode=WAL;");
+
+			if(mode != "wal" && mode != "memory" && g_poolwarningcallback)
+				g_poolwarningcallback(path.c_str(), ("journal_mode is " + mode + " instead of wal").c_str());
+		}
+		catch(database_error &e) {
+			warn(path, "journal_mode=WAL", e);
+		}
+
+		try {
+			entry->con.executenonquery("PRAGMA synchronous=NORMAL;");
+		}
+		catch(database_error &e) {
+			warn(path, "synchronous=NORMAL", e);
+		}
+
+		try {
+			entry->con.executenonquery("PRAGMA temp_store=MEMORY;");
+		}
+		catch(database_error &e) {
+			warn(path, "temp_store=MEMORY", e);
+		}
+
+		return entry;
+	}
+
+	static void warn(const std::string &path, const char *setting, const database_error &e) {
+		if(!g_poolwarningcallback)
+			return;
+
+		std::string msg=std::string("failed to set ") + setting + ": " + e.what();
+		g_poolwarningcallback(path.c_str(), msg.c_str());
+	}
+
+	void release(sqlite3_pool_entry *entry) {
+		// Never hand out a connection with a transaction left open by the last user
+		if(!sqlite3_get_autocommit(entry->con.db)) {
+			try {
+				entry->con.executenonquery("ROLLBACK;");
+			}
+			catch(database_error&) {
+			}
+		}
+
+		if(entry->statements.size() > MAX_CACHED_STATEMENTS) {
+			for(std::map<std::string, sqlite3_command*>::iterator it=entry->statements.begin(); it!=entry->statements.end(); ++it)
+				delete it->second;
+
+			entry->statements.clear();
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			std::vector<sqlite3_pool_entry*> &list=idle[entry->path];
+
+			if(list.size() < MAX_IDLE_CONNECTIONS) {
+				list.push_back(entry);
+				return;
+			}
+		}
+
+		delete entry;
+	}
+
+	void close(const char *db) {
+		std::vector<sqlite3_pool_entry*> closeList;
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			for(std::map<std::string, std::vector<sqlite3_pool_entry*> >::iterator it=idle.begin(); it!=idle.end(); ++it) {
+				if(db && it->first != db)
+					continue;
+
+				closeList.insert(closeList.end(), it->second.begin(), it->second.end());
+				it->second.clear();
+			}
+		}
+
+		for(size_t x=0; x<closeList.size(); ++x)
+			delete closeList[x];
+	}
+
+	void addStat(bool prepared) {
+		std::lock_guard<std::mutex> guard(lock);
+
+		if(prepared)
+			++stats.prepared;
+		else
+			++stats.cached;
+	}
+
+	sqlite3_pool_stats getStats() {
+		std::lock_guard<std::mutex> guard(lock);
+		return stats;
+	}
+
+private:
+	std::mutex lock;
+	std::map<std::string, std::vector<sqlite3_pool_entry*> > idle;
+	sqlite3_pool_stats stats;
+};
+
+static sqlite3_pool g_pool;
+
+void closepooledconnections(const char *db) {
+	g_pool.close(db);
+}
+
+sqlite3_pool_stats getpoolstats() {
+	return g_pool.getStats();
+}
+
+sqlite3_pooled_connection::sqlite3_pooled_connection(const char *db) : entry(NULL) {
+	this->acquire(db);
+}
+
+sqlite3_pooled_connection::sqlite3_pooled_connection(const std::string &db) : entry(NULL) {
+	this->acquire(db);
+}
+
+sqlite3_pooled_connection::~sqlite3_pooled_connection() {
+	if(this->entry)
+		g_pool.release(this->entry);
+}
+
+void sqlite3_pooled_connection::acquire(const std::string &db) {
+	this->entry=g_pool.acquire(db);
+}
+
+sqlite3_connection& sqlite3_pooled_connection::connection() {
+	return this->entry->con;
+}
+
+sqlite3_command& sqlite3_pooled_connection::command(const char *sql) {
+	return this->command(std::string(sql));
+}
+
+sqlite3_command& sqlite3_pooled_connection::command(const std::string &sql) {
+	std::map<std::string, sqlite3_command*>::iterator it=this->entry->statements.find(sql);
+
+	if(it!=this->entry->statements.end()) {
+		it->second->reset();
+		g_pool.addStat(false);
+		return *it->second;
+	}
+
+	sqlite3_command *cmd=new sqlite3_command(this->entry->con, sql);
+	this->entry->statements[sql]=cmd;
+	g_pool.addStat(true);
+	return *cmd;
+}
+
+void sqlite3_pooled_connection::executenonquery(const char *sql) {
+	this->command(sql).executenonquery();
+}
+
+int sqlite3_pooled_connection::executeint(const char *sql) {
+	return this->command(sql).executeint();
+}
+
+long long sqlite3_pooled_connection::executeint64(const char *sql) {
+	return this->command(sql).executeint64();
+}
+
+std::string sqlite3_pooled_connection::executestring(const char *sql) {
+	return this->command(sql).executestring();
+}
+
+}
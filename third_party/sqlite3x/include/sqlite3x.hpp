@@ -30,9 +30,15 @@
 #include <stdexcept>
 
 namespace sqlite3x {
+	typedef void (*profile_callback)(void *userdata, const char *sql, unsigned long long nanoseconds);
+
+	// Called with the run time of every statement on connections opened after it is set
+	void setprofilecallback(profile_callback cb);
+
 	class sqlite3_connection {
 	private:
 		friend class sqlite3_command;
+		friend class sqlite3_pool;
 		friend class database_error;
 
 		struct sqlite3 *db;
@@ -137,6 +143,9 @@ namespace sqlite3x {
 		void bind(int index, const std::string &data);
 		void bind(int index, const std::wstring &data);
 
+		// Resets a finished statement and clears its bindings so it can be run again
+		void reset();
+
 		sqlite3_reader executereader();
 		void executenonquery();
 		int executeint();
@@ -177,6 +186,57 @@ namespace sqlite3x {
 		std::wstring getcolname16(int index);
 	};
 
+	struct sqlite3_pool_entry;
+
+	// Borrows a connection to db from a process wide pool for the life of the object.
+	// Pooled connections run in WAL mode and keep their prepared statements between
+	// borrows, so command() only prepares a given sql string once per connection.
+	// A borrowed connection must only be used by one thread at a time.
+	class sqlite3_pooled_connection {
+	private:
+		sqlite3_pool_entry *entry;
+
+		sqlite3_pooled_connection(const sqlite3_pooled_connection& con)=delete;
+		sqlite3_pooled_connection(sqlite3_pooled_connection&& con)=delete;
+
+		void acquire(const std::string &db);
+
+	public:
+		sqlite3_pooled_connection(const char *db);
+		sqlite3_pooled_connection(const std::string &db);
+		~sqlite3_pooled_connection();
+
+		sqlite3_connection& connection();
+		operator sqlite3_connection&() { return this->connection(); }
+
+		// Cached statement for sql. It stays owned by the pool and is valid until this object is destroyed
+		sqlite3_command& command(const char *sql);
+		sqlite3_command& command(const std::string &sql);
+
+		void executenonquery(const char *sql);
+		int executeint(const char *sql);
+		long long executeint64(const char *sql);
+		std::string executestring(const char *sql);
+	};
+
+	// Closes idle pooled connections to db (or to every database when db is NULL), checkpointing their WAL.
+	// Call before moving or deleting a database file.
+	void closepooledconnections(const char *db=NULL);
+
+	struct sqlite3_pool_stats {
+		unsigned long long opened;
+		unsigned long long reused;
+		unsigned long long prepared;
+		unsigned long long cached;
+	};
+
+	sqlite3_pool_stats getpoolstats();
+
+	typedef void (*pool_warning_callback)(const char *db, const char *msg);
+
+	// Called when setting up a pooled connection partly fails, e.g. a pragma is refused
+	void setpoolwarningcallback(pool_warning_callback cb);
+
 	class database_error : public std::runtime_error {
 	public:
 		database_error(const char *msg);